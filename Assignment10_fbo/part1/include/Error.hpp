@@ -1,38 +1,17 @@
 /* Helper header file for error handling in OpenGL
  *
- *
- *
- *
+ * Errors used to be found by polling glGetError before and after every
+ * call. The driver now reports them itself through the KHR_debug callback
+ * installed by GLDebug, so GLCall only records which call is running.
+ * In release builds GLCall(x) is just x.
  */
 #ifndef ERROR_HPP
 #define ERROR_HPP
 
-#include <glad/glad.h>
-#include <iostream>
-
-// This assert inserts a breakpoint in your code!
-// That way we can get the line number and file.
-// #define ASSERT(x) if(!(x)) __debugbreak(); (__debugbreak() is only available
-// on MSVC)
-#define GLCall(x) GLClearErrorStates(); x ; GLCheckError(#x,__LINE__);
-
-// New error handling routine
-static void GLClearErrorStates(){
-    // Return all of the errors that occur.
-    while(glGetError() != GL_NO_ERROR){
-        ;
-    }
-}
+#include "GLDebug.hpp"
 
-// Returns false if an error occurs
-static bool GLCheckError(const char* function, int line){
-    while(GLenum error = glGetError()){
-        // __LINE__ is a special preprocessor macro that
-        // Can tell us what line any errors occurred on.
-        std::cout << "[OpenGL Error]" << error << "|" << function << " Line: " << line << "\n";
-        return false;
-    }
-    return true;
-}
+// Wraps a single OpenGL call, e.g. GLCall(glBindVertexArray(m_VAO));
+// Messages raised by the call are printed with the file and line number.
+#define GLCall(x) GL_CHECK(x)
 
 #endif
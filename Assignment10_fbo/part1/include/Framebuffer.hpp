@@ -13,6 +13,7 @@
 
 #include <glad/glad.h>
 #include <memory>
+#include <vector>
 
 // Each Framebuffer can have a custom shader so we
 // are forward declaring the class.
@@ -24,8 +25,15 @@ public:
     Framebuffer();
     // Destructor
     ~Framebuffer();
-    // Create the framebuffer
-    void Create(int width, int height);
+    // Create the framebuffer. With more than one layer the color and depth
+    // buffers are texture arrays that a geometry shader picks the layer of
+    // (gl_Layer), for drawing several views at once (see MultiView.hpp).
+    void Create(int width, int height, int layers = 1);
+    // Create a framebuffer with one color texture per internal format
+    // (GL_RGBA8, GL_RG16 or GL_RGBA16F), which are fragment shader outputs
+    // 0, 1, ... With 'depth' there is also a depth texture that shaders can
+    // read (e.g. the G-buffer of the deferred path, see DeferredShading.hpp).
+    void CreateTargets(int width, int height, const std::vector<GLenum>& formats, bool depth);
     // Select our framebuffer
     void Bind();
     // Update our framebuffer once per frame for any
@@ -33,25 +41,38 @@ public:
     void Update();
     // Done with our framebuffer
     void Unbind();
-    // Draws the screen quad
-    void DrawFBO();
+    // Draws the screen quad, showing 'layer' of a layered framebuffer
+    void DrawFBO(int layer = 0);
+    // How many layers Create() made
+    int GetLayerCount() const { return m_layers; }
+    // The color texture of output 'index' (0 is m_colorBuffer_id)
+    unsigned int GetColorTexture(int index) const;
+    // 0 unless made by CreateTargets() or for several layers
+    unsigned int GetDepthTexture() const { return m_depthBuffer_id; }
 private: 
     // Creates a quad that will be overlaid on top of the screen
     void SetupScreenQuad(float x,float y, float w, float h);
+    // Create() for more than one layer
+    void CreateLayered(int width, int height, int layers);
 // public member variables
 public:
     std::shared_ptr<Shader> m_fboShader;
     // Our framebuffer also needs a texture.
-    unsigned int m_colorBuffer_id;
+    unsigned int m_colorBuffer_id{0};
 // private member variables
 private:
     // Framebuffer id
-    unsigned int m_fbo_id; 
+    unsigned int m_fbo_id{0}; 
     // Finally create our render buffer object
-    unsigned int m_rbo_id;
+    unsigned int m_rbo_id{0};
+    // Depth of a layered framebuffer (which has no render buffer)
+    unsigned int m_depthBuffer_id{0};
+    int m_layers{1};
+    // Color textures after the first one (CreateTargets())
+    std::vector<unsigned int> m_extraTargets;
     // Store our screen buffer
-    unsigned int m_quadVAO;
-    unsigned int m_quadVBO;
+    unsigned int m_quadVAO{0};
+    unsigned int m_quadVBO{0};
 
 };
 
@@ -12,6 +12,9 @@
 
 #include <vector>
 
+#include "ResourceTracker.hpp"
+#include "Residency.hpp"
+
 // Purpose of this class is to store vertice and triangle information
 class Geometry{
 public:
@@ -42,6 +45,11 @@ public:
 	unsigned int GetIndicesSize();
     // Retrieve the pointer to the indices
 	unsigned int* GetIndicesDataPtr();
+	// Retrieve the vertex positions (x,y,z per vertex)
+	const std::vector<float>& GetVertexPositions() const { return m_vertexPositions; }
+	// Called once the data has been uploaded to the GPU.
+	// Frees the host copies that the residency policy does not need.
+	void ApplyResidency(Residency residency);
 
 private:
 	// m_bufferData stores all of the vertexPositons, coordinates, normals, etc.
@@ -57,6 +65,11 @@ private:
 
 	// The indices for a indexed-triangle mesh
 	std::vector<unsigned int> m_indices;
+
+	// Memory held by all of the vectors above, reported to the tracker
+	TrackedAllocation m_trackedBytes{"Geometry"};
+	// Recomputes m_trackedBytes from the capacity of our vectors
+	void UpdateTrackedBytes();
 };
 
 
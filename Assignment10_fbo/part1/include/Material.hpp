@@ -0,0 +1,112 @@
+#ifndef MATERIAL_HPP
+#define MATERIAL_HPP
+/** @file Material.hpp
+ *  @brief How a mesh looks: the programs of every render pass and the
+ *         textures they sample.
+ *
+ *  A material compiles its shaders once per pass (with the pass's
+ *  fragment shader or defines) and points their samplers and uniform
+ *  blocks at the units and binding points below when it is created, so
+ *  nothing is set per frame. Drawing records the program, the textures
+ *  and then the mesh (see Mesh.hpp).
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+
+#include <vector>
+#include <memory>
+#include <string>
+
+#include "Shader.hpp"
+#include "Texture.hpp"
+#include "CommandBuffer.hpp"
+#include "VirtualTexture.hpp"
+
+#include "glm/glm.hpp"
+
+// Per draw data of the shaders' 'Transforms' block (std140, see
+// shaders/vert.glsl), read from uniform buffer binding point kTransformsBinding
+struct TransformBlock{
+    glm::mat4 model;
+    glm::mat4 view;
+    glm::mat4 projection;
+};
+static const GLuint kTransformsBinding = 0;
+// The 'PulledMesh' block of shaders/vert_pull.glsl (PulledMeshBlock, see
+// VertexPulling.hpp), recorded with the draws of pulled meshes
+static const GLuint kPulledMeshBinding = 1;
+// The 'Views' block of the MULTIVIEW shaders (ViewsBlock, see MultiView.hpp)
+static const GLuint kViewsBinding = 2;
+// The 'Shadows' block of shaders/frag.glsl (ShadowBlock, see
+// ShadowCascades.hpp), and the texture unit of the shadow maps
+static const GLuint kShadowsBinding = 3;
+static const GLuint kShadowMapUnit = 2;
+// The 'Lights' block (LightsBlock, see DeferredShading.hpp)
+static const GLuint kLightsBinding = 4;
+// The 'VirtualTexture' block of the VIRTUAL_TEXTURE shaders
+// (VirtualTextureBlock, see VirtualTexture.hpp), and the texture units of
+// its page table and page cache
+static const GLuint kVirtualTextureBinding = 5;
+static const GLuint kPageTableUnit = 7;
+static const GLuint kPageCacheUnit = 8;
+// The material's own textures
+static const GLuint kDiffuseMapUnit = 0;
+static const GLuint kDetailMapUnit = 1;
+
+// Which of a material's programs a draw uses
+enum class RenderPass{
+    Color,      // m_shader
+    MultiView,  // m_multiViewShader: every view at once
+    Depth,      // m_depthShader: only the depth, for shadow maps
+    GBuffer,    // m_gbufferShader: the deferred path's G-buffer
+    Feedback    // m_feedbackShader: the pages of the virtual texture seen
+};
+
+class Material{
+public:
+    // Compiles the programs of every pass from these shaders.
+    // 'defines' are added to every program's shaders. VIRTUAL_TEXTURE
+    // samples the diffuse map from a virtual texture (see
+    // SetVirtualTexture()) and adds the feedback program.
+    Material(std::string vertShader, std::string fragShader,
+             const std::vector<std::string>& defines = {});
+    // Destructor
+    ~Material();
+    // Loads the diffuse map
+    void LoadTexture(std::string fileName, GpuUploader* uploader = nullptr);
+    // Loads the diffuse and detail maps (both files are read at once)
+    void LoadTextures(std::string colormap, std::string detailmap, GpuUploader* uploader = nullptr);
+    // Samples the diffuse map from a virtual texture instead (with a
+    // material built with VIRTUAL_TEXTURE). The texture must outlive the
+    // material.
+    void SetVirtualTexture(VirtualTexture* virtualTexture);
+    // Records the program of 'pass' and the textures it samples. Returns
+    // false, recording nothing, if there is no program for it
+    // (RenderPass::Feedback without VIRTUAL_TEXTURE): skip the draw then.
+    // Makes no OpenGL calls.
+    bool Record(CommandBuffer& commands, RenderPass pass) const;
+
+private:
+    // Points the samplers of one of our programs at their texture units
+    void SetSamplerUnits(Shader& shader);
+    // The programs, one per RenderPass
+    std::shared_ptr<Shader> m_shader;
+    // The same shaders compiled with MULTIVIEW and shaders/geom_multiview.glsl
+    std::shared_ptr<Shader> m_multiViewShader;
+    // The same vertex shader with shaders/depth_frag.glsl
+    std::shared_ptr<Shader> m_depthShader;
+    // The same vertex shader with shaders/gbuffer_frag.glsl
+    std::shared_ptr<Shader> m_gbufferShader;
+    // The same vertex shader with shaders/feedback_frag.glsl, only with
+    // VIRTUAL_TEXTURE
+    std::shared_ptr<Shader> m_feedbackShader;
+    // For now we have one diffuse map
+    Texture m_textureDiffuse;
+    // Terrains are often 'multitextured' and have multiple textures.
+    Texture m_detailMap;
+    // See SetVirtualTexture()
+    VirtualTexture* m_virtualTexture{nullptr};
+};
+
+#endif
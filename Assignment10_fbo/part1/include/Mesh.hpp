@@ -0,0 +1,81 @@
+/** @file Mesh.hpp
+ *  @brief Geometry on the GPU, ready to be drawn.
+ *
+ *  What a scene draws is a mesh and a material (see Material.hpp) at a
+ *  transform, kept as components in the Renderer's ComponentStore; a mesh
+ *  only knows its vertices and how to draw them.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <glad/glad.h>
+
+#include <vector>
+#include <string>
+
+// Forward declarations
+#include "VertexBufferLayout.hpp"
+#include "Transform.hpp"
+#include "Geometry.hpp"
+#include "Residency.hpp"
+#include "CommandBuffer.hpp"
+#include "VertexPulling.hpp"
+
+#include "glm/vec3.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+
+// Purpose:
+// The vertices of something to draw, in their own buffers or in a
+// vertex pool
+//
+class Mesh{
+public:
+    // Mesh Constructor
+    // The residency decides what stays on the CPU after the upload, which
+    // is done on the uploader's thread if there is one. With a pool the
+    // vertices are packed into it instead (see VertexPulling.hpp); the
+    // material's shader must then pull them (shaders/vert_pull.glsl).
+    Mesh(Residency residency = Residency::GpuOnly, GpuUploader* uploader = nullptr,
+         VertexPool* pool = nullptr);
+    // Mesh destructor
+    ~Mesh();
+    // Create a quad from -1 to 1 in x and y
+    void MakeQuad();
+    // Puts the geometry on the GPU (see GetGeometry()). Call once, after
+    // filling it and calling Geometry::Gen().
+    void Create();
+    // Records the binds and the draw. Safe to call from a worker thread:
+    // it makes no OpenGL calls.
+    void Record(CommandBuffer& commands) const;
+    // The geometry to fill before Create(); afterwards only positions and
+    // indices remain for Residency::CpuCollision, nothing for
+    // Residency::GpuOnly
+    Geometry& GetGeometry() { return m_geometry; }
+    const Geometry& GetGeometry() const { return m_geometry; }
+    Residency GetResidency() const { return m_residency; }
+    // True if the geometry went into the pool
+    bool IsPulled() const { return m_pulledMesh.IsValid(); }
+    // Sphere around the geometry in object space: center (xyz) and radius
+    // (w), which is negative before Create()
+    const glm::vec4& GetBoundingSphere() const { return m_boundingSphere; }
+private:
+    // For now we have one buffer per mesh.
+    VertexBufferLayout m_vertexBufferLayout;
+    // Store the mesh's Geometry
+	Geometry m_geometry;
+    // What to keep on the CPU after uploading
+    Residency m_residency{Residency::GpuOnly};
+    // Upload on this thread (nullptr: right away)
+    GpuUploader* m_uploader{nullptr};
+    // Pack the geometry into this pool, if there is one
+    VertexPool* m_vertexPool{nullptr};
+    // Where the geometry is in the pool (invalid if it is not)
+    PulledMesh m_pulledMesh;
+    // See GetBoundingSphere()
+    glm::vec4 m_boundingSphere{0.0f,0.0f,0.0f,-1.0f};
+};
+
+#endif
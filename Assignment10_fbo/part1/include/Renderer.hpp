@@ -4,12 +4,18 @@
  *  @brief Renderer is responsible for drawing.
  *
  * 	Renderer is responsible for drawing everything. It
- *	contains a scenegraph node and a camera. We could 
+ *	contains the scene and a camera. We could 
  *	possibly have multiple renderers (if we had multiple
  *	windows for example).
  *
  *	Each renderer thus has it's own camera.
  *
+ *	The scene is a ComponentStore (see ComponentStore.hpp): each thing
+ *	to draw is an entity with a transform, a mesh, a material and bounds,
+ *	the last three as indices into the renderer's tables and a sphere.
+ *	Every pass culls the bounds column alone, then records the draws of
+ *	the rows it kept.
+ *
  *  @author Mike
  *  @bug No known bugs.
  */
@@ -20,12 +26,25 @@
 
 #include <vector>
 #include <memory>
+#include <functional>
+#include <ostream>
 
 // Forward declarations
 
-#include "SceneNode.hpp"
+#include "Mesh.hpp"
+#include "Material.hpp"
+#include "ComponentStore.hpp"
 #include "Camera.hpp"
 #include "Framebuffer.hpp"
+#include "GpuTimer.hpp"
+#include "PerfHud.hpp"
+#include "CommandBuffer.hpp"
+#include "VertexPulling.hpp"
+#include "MultiView.hpp"
+#include "ShadowCascades.hpp"
+#include "ShadowMap.hpp"
+#include "DeferredShading.hpp"
+#include "VirtualTexture.hpp"
 
 
 class Renderer{
@@ -39,9 +58,17 @@ public:
     void Update();
     // Render the scene
     void Render();
-    // Sets the root of our renderer to some node to
-    // draw an entire scene graph
-    void setRoot(std::shared_ptr<SceneNode> startingNode);
+    // Adds a mesh or a material for renderables to use; returns its index.
+    // The levels of detail of a mesh are added one after the other, the
+    // most detailed first.
+    uint32_t AddMesh(std::shared_ptr<Mesh> mesh);
+    uint32_t AddMaterial(std::shared_ptr<Material> material);
+    // Something to draw: a mesh with a material at 'world'. Static ones
+    // never move, so cached shadow cascades keep them.
+    Entity AddRenderable(uint32_t mesh, uint32_t material, const glm::mat4& world, bool isStatic = false);
+    // The entities drawn; their components can be changed (e.g. to move
+    // them, or give them levels of detail)
+    ComponentStore& GetScene(){ return m_scene; }
     // Returns the camera at an index
     Camera*& GetCamera(unsigned int index){
         if(index > m_cameras.size()-1){
@@ -49,19 +76,114 @@ public:
         }
         return m_cameras[index];
     }
+    // Adds a camera (for SetViewCount())
+    Camera* AddCamera(){
+        m_cameras.push_back(new Camera());
+        return m_cameras.back();
+    }
+    // The performance overlay (toggled with 'H')
+    PerfHud& GetPerfHud(){ return m_perfHud; }
+    // The pool the pulled objects draw from (see VertexPulling.hpp); its
+    // buffers are bound before the scene is replayed
+    void SetVertexPool(VertexPool* pool){ m_vertexPool = pool; }
+    // Draws the scene from the first 'count' cameras (1 to kMaxViews, more
+    // are created as needed) side by side on the screen. The scene is
+    // culled and drawn once for all of them, into the layers of a layered
+    // framebuffer (see MultiView.hpp).
+    void SetViewCount(unsigned int count);
+    unsigned int GetViewCount() const { return m_viewCount; }
+    // The sun's cascaded shadows (see ShadowCascades.hpp), on by default
+    void SetShadowsEnabled(bool enabled){ m_shadowsEnabled = enabled; }
+    bool GetShadowsEnabled() const { return m_shadowsEnabled; }
+    // The static nodes changed (e.g. the terrain finished uploading), so
+    // the cached shadow cascades are drawn again
+    void InvalidateShadows(){ m_shadowCascades.Invalidate(); }
+    const ShadowCascadeCache& GetShadowCascades() const { return m_shadowCascades; }
+    // A point light besides the one the camera carries (kMaxLights in all)
+    void AddLight(const PointLight& light){ m_lights.push_back(light); }
+    // Deferred shading (see DeferredShading.hpp) instead of the forward
+    // shading of shaders/frag.glsl. Several views are always drawn forward.
+    void SetDeferred(bool deferred);
+    bool GetDeferred() const { return m_deferred; }
+    // Framebuffer bytes forward and deferred shading move for the last
+    // measured frame of each
+    void PrintShadingReport(std::ostream& out) const;
+    // The virtual texture the scene samples (see VirtualTexture.hpp). Each
+    // frame the pages the first camera sees are drawn into a small feedback
+    // buffer and read back a few frames later. It must outlive the renderer.
+    void SetVirtualTexture(VirtualTexture* virtualTexture);
+    // Asks for the pages of the newest feedback readback and uploads those
+    // that were read since. Returns true if the scene looks different.
+    bool UpdateVirtualTexture();
+    // Feedback or pages are still on their way
+    bool IsVirtualTextureBusy() const;
 
 // TODO: maybe write getter/setter methods
 protected:
-    // Root scene node
-    std::shared_ptr<SceneNode> m_root;
+    // See GetScene(), AddMesh() and AddMaterial()
+    ComponentStore m_scene;
+    std::vector<std::shared_ptr<Mesh>> m_meshes;
+    std::vector<std::shared_ptr<Material>> m_materials;
     // One or more cameras camera per Renderer
     std::vector<Camera*> m_cameras;
     // Store the projection matrix for our camera.
     glm::mat4 m_projectionMatrix;
     // A renderer can have any number of framebuffers
     std::vector<Framebuffer*> m_framebuffers;
+    // Drawn over the composited framebuffer, last thing in a frame
+    PerfHud m_perfHud;
+    // Times the scene and the composite on the GPU
+    GpuTimer m_gpuTimer;
+    // The scene is recorded into command buffers on worker threads
+    // (m_visible split into jobs) and replayed on this thread
+    WorkerPool m_workers;
+    std::vector<DrawRef> m_visible;
+    std::vector<CommandBuffer> m_commandBuffers;
+    CommandReplayer m_replayer;
+    // See SetVertexPool()
+    VertexPool* m_vertexPool{nullptr};
+    // See SetViewCount(); m_framebuffers[1] is the layered framebuffer
+    // when there is more than one view
+    unsigned int m_viewCount{1};
+    // The shadow map has a layer per cascade, drawn from the sun along
+    // m_lightDirection before the scene (see RenderShadows())
+    ShadowMap m_shadowMap;
+    ShadowCascadeCache m_shadowCascades;
+    glm::vec3 m_lightDirection;
+    bool m_shadowsEnabled{true};
+    // The lights; m_lights[0] follows the camera
+    std::vector<PointLight> m_lights;
+    // See SetDeferred(). The G-buffer holds albedo, normal and depth, the
+    // light buffer the lights added up; both are made when first needed.
+    bool m_deferred{false};
+    Framebuffer* m_gbuffer{nullptr};
+    Framebuffer* m_lightBuffer{nullptr};
+    std::shared_ptr<Shader> m_lightVolumeShader;
+    std::shared_ptr<Shader> m_resolveShader;
+    // The light volumes and the resolve make their vertices from gl_VertexID
+    GLuint m_emptyVertexArray{0};
+    CommandBuffer m_deferredCommands;
+    // Samples of the scene and of the light volumes, for PrintShadingReport()
+    GpuSampleCounter m_sceneSamples;
+    GpuSampleCounter m_lightSamples;
+    ShadingSamples m_shadingSamples;
+    // See SetVirtualTexture()
+    VirtualTexture* m_virtualTexture{nullptr};
+    VirtualTextureFeedback m_feedback;
+    std::vector<PageId> m_feedbackPages;
 
 private:
+    // Records the draws of m_visible with the programs of 'pass' into
+    // m_commandBuffers. 'begin' (if any) is recorded first into each.
+    void RecordVisible(const glm::mat4& view, const glm::mat4& projection, RenderPass pass,
+                       const std::function<void(CommandBuffer&)>& begin = nullptr);
+    // Draws the cascades that are out of date
+    void RenderShadows();
+    // Draws which pages of the virtual texture the first camera sees
+    void RenderFeedback();
+    // The deferred path after the G-buffer: lights it, then resolves it
+    // into 'target'
+    void RenderDeferredLighting(Framebuffer* target, const LightsBlock& lights, const ShadowBlock& shadows);
     // Screen dimension constants
     int m_screenWidth;
     int m_screenHeight;
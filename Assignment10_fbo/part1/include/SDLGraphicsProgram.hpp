@@ -26,6 +26,10 @@
 // C++ Libraries
 #include <functional>
 
+#include "GpuUploader.hpp"
+#include "RedrawScheduler.hpp"
+#include "SharedMetrics.hpp"
+
 
 // Purpose:
 // This class sets up a full graphics program using SDL
@@ -44,6 +48,11 @@ public:
     SDL_Window* GetSDLWindow();
     // Helper Function to Query OpenGL information.
     void GetOpenGLVersionInfo();
+    // Draw every frame (benchmarks) or only when something changed.
+    // A loop callback that animates something should call MarkDirty()
+    // or RequestFrames() on the scheduler.
+    void SetRedrawMode(RedrawMode mode);
+    RedrawScheduler& GetRedrawScheduler();
 
 private:
 	// The Renderer responsible for drawing objects
@@ -52,9 +61,17 @@ private:
     SDL_Window* m_window ;
     // OpenGL context
     SDL_GLContext m_openGLContext;
+    // Shares its objects with m_openGLContext; the terrain and its textures
+    // are uploaded on m_uploader's thread with it (see GpuUploader.hpp)
+    SDL_GLContext m_uploadContext{nullptr};
+    GpuUploader m_uploader;
     // Window width and height
     unsigned int m_width;
     unsigned int m_height;
+    // Live metrics for other processes (see SharedMetrics.hpp)
+    MetricsPublisher m_metrics;
+    // Decides which loop iterations draw (see RedrawScheduler.hpp)
+    RedrawScheduler m_redraw;
 
 };
 
@@ -11,12 +11,6 @@
 
 #include <string>
 
-#if defined(LINUX) || defined(MINGW)
-    #include <SDL2/SDL.h>
-#else // This works for Mac
-    #include <SDL.h>
-#endif
-
 #include <glad/glad.h>
 
 class Shader{
@@ -33,6 +27,12 @@ public:
     std::string LoadShader(const std::string& fname);
     // Create a Shader from a loaded vertex and fragment shader
     void CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
+    // The same with a geometry shader between them
+    void CreateShader(const std::string& vertexShaderSource, const std::string& geometryShaderSource,
+                      const std::string& fragmentShaderSource);
+    // Returns the loaded source with '#define name' after its #version line,
+    // so one file can be compiled in more than one way (#ifdef name)
+    static std::string AddDefine(const std::string& source, const std::string& name);
     // return the shader id
     GLuint GetID() const;
     // Set our uniforms for our shader.
@@ -40,6 +40,8 @@ public:
 	void SetUniform3f(const GLchar* name, float v0, float v1, float v2);
     void SetUniform1i(const GLchar* name, int value);
     void SetUniform1f(const GLchar* name, float value);
+    // Reads the uniform block 'name' from uniform buffer binding point 'binding'
+    void SetUniformBlockBinding(const GLchar* name, GLuint binding);
 
 private:
     // Compiles loaded shaders
@@ -52,7 +54,7 @@ private:
     // Logs an error message 
     void Log(const char* system, const char* message);
     // The unique shaderID
-    GLuint m_shaderID;
+    GLuint m_shaderID{0};
 };
 
 #endif
@@ -0,0 +1,44 @@
+/** @file ShadowMap.hpp
+ *  @brief Depth maps of a directional light, one layer per cascade.
+ *
+ *  A depth texture array the Renderer draws its shadow cascades into (see
+ *  ShadowCascades.hpp), one framebuffer per layer so each cascade can be
+ *  redrawn on its own. The texture compares depths when it is sampled, so
+ *  the shaders read it with a sampler2DArrayShadow.
+ *
+ *  @author Mike
+ *  @bug No known bugs.
+ */
+#ifndef SHADOW_MAP_HPP
+#define SHADOW_MAP_HPP
+
+#include <glad/glad.h>
+
+#include <vector>
+
+class ShadowMap{
+public:
+    // Default Constructor
+    ShadowMap();
+    // Destructor
+    ~ShadowMap();
+    // Create 'layers' maps of 'resolution' x 'resolution' texels
+    void Create(int resolution, int layers);
+    // Delete everything Create() made
+    void Release();
+    bool IsCreated() const { return m_texture != 0; }
+    // Select the framebuffer of one layer (and a viewport that covers it)
+    void BindLayer(int layer);
+    // Done with our framebuffer
+    void Unbind();
+    // The depth texture array
+    GLuint GetTexture() const { return m_texture; }
+    int GetResolution() const { return m_resolution; }
+    int GetLayerCount() const { return static_cast<int>(m_framebuffers.size()); }
+private:
+    GLuint m_texture{0};
+    std::vector<GLuint> m_framebuffers;
+    int m_resolution{0};
+};
+
+#endif
@@ -1,7 +1,8 @@
 /** @file Terrain.hpp
  *  @brief Create a terrain
  *  
- *  More...
+ *  A terrain is a Mesh (see Mesh.hpp) whose heights come from an image;
+ *  its textures belong to the Material it is drawn with.
  *
  *  @author Mike
  *  @bug No known bugs.
@@ -9,37 +10,25 @@
 #ifndef TERRAIN_HPP
 #define TERRAIN_HPP
 
-#include "VertexBufferLayout.hpp"
-#include "Texture.hpp"
-#include "Shader.hpp"
 #include "Image.hpp"
-#include "Object.hpp"
+#include "Mesh.hpp"
 
-#include <vector>
+#include <memory>
 #include <string>
 
-class Terrain : public Object {
-public:
-    // Takes in a Terrain and a filename for the heightmap.
-    Terrain (unsigned int xSegs, unsigned int zSegs, std::string fileName);
-    // Destructor
-    ~Terrain ();
-    // override the initialization routine.
-    void Init();
-    // Loads a heightmap based on a PPM image
-    // This then sets the heights of the terrain.
-    void LoadHeightMap(Image image);
-    // Load textures
-    void LoadTextures(std::string colormap, std::string detailmap);
+// Takes in the number of segments and a filename for the heightmap (a PPM
+// image). Each segment gets the height of one pixel, its red value
+// scaled down by 5.
+// The residency decides what stays on the CPU after the upload, which
+// is done on the uploader's thread if there is one. With a pool the
+// vertices are packed into it instead (see Mesh).
+std::shared_ptr<Mesh> MakeTerrain(unsigned int xSegs, unsigned int zSegs, std::string fileName,
+                                  Residency residency = Residency::GpuOnly,
+                                  GpuUploader* uploader = nullptr, VertexPool* pool = nullptr);
 
-private:
-    // data
-    unsigned int m_xSegments;
-    unsigned int m_zSegments;
-
-    // Store the height in a multidimensional array
-    int* m_heightData;
-
-};
+// Creates a grid of segments with these heights (xSegs * zSegs of them,
+// row by row) in 'geometry', ready for Mesh::Create()
+void MakeTerrainGeometry(unsigned int xSegs, unsigned int zSegs, const int* heights,
+                         Geometry& geometry);
 
 #endif
@@ -9,10 +9,14 @@
 #ifndef TEXTURE_HPP
 #define TEXTURE_HPP
 
+#include "GpuUploader.hpp"
 #include "Image.hpp"
+#include "Residency.hpp"
 
 #include <glad/glad.h>
 #include <string>
+#include <utility>
+#include <vector>
 
 class Texture{
 public:
@@ -21,20 +25,37 @@ public:
     // Destructor
     ~Texture();
 	// Loads and sets up an actual texture
-    void LoadTexture(const std::string filepath);
+    // The image data is only kept for Residency::CpuAndGpu.
+    // With an uploader the texture is made on its thread, GetID() is 0
+    // until GpuUploader::Poll() hands it over.
+    void LoadTexture(const std::string filepath, Residency residency=Residency::GpuOnly,
+                     GpuUploader* uploader=nullptr);
+    // Same, with an image that is already loaded (the texture owns it now)
+    void LoadTexture(const std::string filepath, Image* image, Residency residency=Residency::GpuOnly,
+                     GpuUploader* uploader=nullptr);
+    // Loads several textures: the files are read together by
+    // AsyncFileReader::Instance() and parsed on its threads, so their
+    // reads overlap instead of waiting for each other
+    static void LoadTextures(const std::vector<std::pair<Texture*,std::string>>& textures,
+                             Residency residency=Residency::GpuOnly, GpuUploader* uploader=nullptr);
 	// slot tells us which slot we want to bind to.
     // We can have multiple slots. By default, we
     // will set our slot to 0 if it is not specified.
     void Bind(unsigned int slot=0) const;
     // Be done with our texture
-    void Unbind();
+    void Unbind(unsigned int slot=0);
+    // The OpenGL texture (for recording commands, see CommandBuffer.hpp)
+    GLuint GetID() const { return m_textureID; }
 private:
     // Store a unique ID for the texture
-    GLuint m_textureID;
+    GLuint m_textureID{0};
 	// Filepath to the image loaded
     std::string m_filepath;
     // Store whatever image data inside of our texture class.
-    Image* m_image;
+    Image* m_image{nullptr};
+    // An upload that is still on its way
+    GpuUploader* m_uploader{nullptr};
+    UploadTicket m_uploadTicket{0};
 };
 
 
@@ -12,6 +12,8 @@
 // The glad library helps setup OpenGL extensions.
 #include <glad/glad.h>
 
+#include "GpuUploader.hpp"
+
 
 class VertexBufferLayout{ 
 public:
@@ -47,17 +49,39 @@ public:
     // texcoords: s,t
     // tangent: t_x,t_y,t_z
     // bitangent b_x,b_y,b_z
-    void CreateNormalBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata );
+    //
+    // With an uploader the buffers are made on its thread (from copies of
+    // the data) and the vertex array once GpuUploader::Poll() hands them
+    // over. Until then IsReady() is false and there is nothing to draw.
+    void CreateNormalBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata,
+                                  GpuUploader* uploader=nullptr );
+    // True once the vertex array exists
+    bool IsReady() const { return m_VAOId != 0; }
+
+    // Number of indices in the index buffer.
+    // Use this to draw, since the CPU copy of the indices may be gone.
+    unsigned int GetIndexCount() const { return m_indexCount; }
+    // The vertex array object (for recording commands, see CommandBuffer.hpp)
+    GLuint GetVertexArray() const { return m_VAOId; }
 
 private:
+    // Reports the buffers we just created to the resource tracker
+    void TrackBuffers(unsigned int vcount, unsigned int icount);
+    // Attributes of the normal map layout, for the bound vertex array
+    void SetNormalAttributes();
+    // An upload that is still on its way
+    GpuUploader* m_uploader{nullptr};
+    UploadTicket m_uploadTicket{0};
     // Vertex Array Object
-    GLuint m_VAOId;
+    GLuint m_VAOId{0};
     // Vertex Buffer
-    GLuint m_vertexPositionBuffer;
+    GLuint m_vertexPositionBuffer{0};
     // Index Buffer Object
-    GLuint m_indexBufferObject;
+    GLuint m_indexBufferObject{0};
     // Stride of data (how do I get to the next vertex)
     unsigned int m_stride{0};
+    // Number of indices uploaded
+    unsigned int m_indexCount{0};
 };
 
 
@@ -0,0 +1,79 @@
+// ==================================================================
+#version 330 core
+// The last pass of the deferred path: the added up lights times the
+// albedo, with the sun and its shadows applied as in shaders/frag.glsl.
+
+out vec4 FragColor;
+
+struct PointLight{
+    vec4 positionRange;
+    vec4 colorAmbient;
+    vec4 attenuationSpecular;
+};
+layout(std140) uniform Lights{
+    PointLight pointLights[64];
+    mat4 viewProjection;
+    mat4 inverseViewProjection;
+    vec4 eyePosition;
+    ivec4 lightCount;
+};
+layout(std140) uniform Shadows{
+    mat4 lightViewProjections[4];
+    mat4 cameraView;
+    vec4 cascadeEnds;
+    vec4 lightDirection;
+    ivec4 cascadeCount;
+};
+uniform sampler2DArrayShadow u_ShadowMap;
+
+// The G-buffer and the lights
+uniform sampler2D u_Albedo;
+uniform sampler2D u_Normal;
+uniform sampler2D u_Depth;
+uniform sampler2D u_Light;
+
+// OctahedralDecode() in Impostor.cpp
+vec3 DecodeNormal(vec2 uv){
+    vec2 p = uv * 2.0 - 1.0;
+    vec3 n = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+    if(n.y < 0.0){
+        n.xz = (1.0 - abs(p.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0,
+                                        p.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+// SunVisibility() in shaders/frag.glsl
+float SunVisibility(vec3 FragPos)
+{
+    float distance = -(cameraView * vec4(FragPos,1.0)).z;
+    int cascade = 0;
+    while(cascade < cascadeCount.x - 1 && distance > cascadeEnds[cascade]){
+        cascade++;
+    }
+    vec3 coords = (lightViewProjections[cascade] * vec4(FragPos,1.0)).xyz * 0.5 + 0.5;
+    if(any(lessThan(coords,vec3(0.0))) || any(greaterThan(coords,vec3(1.0)))){
+        return 1.0;
+    }
+    return texture(u_ShadowMap, vec4(coords.xy, float(cascade), coords.z - 0.0005));
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(u_Depth, pixel, 0).r;
+    // Keep the clear color where nothing was drawn
+    if(depth == 1.0){
+        discard;
+    }
+    vec3 Lighting = texelFetch(u_Light, pixel, 0).rgb;
+    if(cascadeCount.x > 0){
+        vec2 uv = (vec2(pixel) + 0.5) / vec2(textureSize(u_Depth, 0));
+        vec4 world = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+        vec3 norm = DecodeNormal(texelFetch(u_Normal, pixel, 0).rg);
+        float sun = SunVisibility(world.xyz / world.w) * max(dot(norm, -lightDirection.xyz), 0.0);
+        Lighting *= 0.55 + 0.45 * sun;
+    }
+    FragColor = vec4(texelFetch(u_Albedo, pixel, 0).rgb * Lighting, 1.0);
+}
+// ==================================================================
@@ -0,0 +1,9 @@
+// ==================================================================
+#version 330 core
+// Shadow maps only need the depth (see ShadowMap.hpp), which OpenGL
+// writes without our help.
+
+void main()
+{
+}
+// ==================================================================
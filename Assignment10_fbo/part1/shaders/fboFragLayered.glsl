@@ -0,0 +1,25 @@
+// ====================================================
+#version 330 core
+
+// ======================= uniform ====================
+// The layered framebuffer the views were drawn into (see Framebuffer.hpp)
+uniform sampler2DArray u_DiffuseMap; 
+// Which view this quad shows
+uniform int u_Layer;
+
+// ======================= IN =========================
+in vec2 v_texCoord; // Import our texture coordinates from vertex shader
+
+// ======================= out ========================
+// The final output color of each 'fragment' from our fragment shader.
+out vec4 FragColor;
+
+void main()
+{
+    // Store our final texture color
+    vec3 diffuseColor;
+    diffuseColor = texture(u_DiffuseMap, vec3(v_texCoord, u_Layer)).rgb;
+        
+    FragColor = vec4(diffuseColor,1.0);
+}
+// ==================================================================
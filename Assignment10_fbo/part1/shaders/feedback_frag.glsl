@@ -0,0 +1,32 @@
+// ==================================================================
+#version 330 core
+// The feedback pass of the virtual texture (see VirtualTexture.hpp): which
+// page, at which level, the diffuse map would be sampled from here. The
+// Renderer reads it back and streams in the pages that are missing.
+
+// Page x, page y, level, and 1 where the virtual texture is seen
+out vec4 Feedback;
+
+// What shaders/vert.glsl (or vert_pull.glsl) sends us
+in vec3 myNormal;
+in vec2 v_texCoord;
+in vec3 FragPos;
+
+// The same block as in shaders/frag.glsl
+layout(std140) uniform VirtualTexture{
+    vec4 vtLayout; // Texels and pages along level 0, levels, feedback scale (log2)
+    vec4 vtCache;  // Page texels, border, pages and texels along the cache
+};
+
+void main()
+{
+    // The same level SampleVirtual() picks: this buffer is smaller than
+    // the screen, so its derivatives are larger by the feedback scale
+    vec2 texels = v_texCoord * vtLayout.x;
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float level = clamp(floor(0.5 * log2(max(dot(dx,dx), dot(dy,dy))) - vtLayout.w), 0.0, vtLayout.z - 1.0);
+    vec2 uv = clamp(v_texCoord, 0.0, 0.99999);
+    vec2 page = floor(uv * (vtLayout.y / exp2(level)));
+    Feedback = vec4(page, level, 255.0) / 255.0;
+}
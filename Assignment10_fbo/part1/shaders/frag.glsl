@@ -4,27 +4,22 @@
 // The final output color of each 'fragment' from our fragment shader.
 out vec4 FragColor;
 
-// Our light source data structure
+// Our light source data structure (LightVolume in DeferredShading.hpp)
 struct PointLight{
-    vec3 lightColor;
-    vec3 lightPos;
-    float ambientIntensity;
-
-    float specularStrength;
-
-    float constant;
-    float linear;
-    float quadratic;
-
-    vec3 ambient;
-    vec3 diffuse;
-    vec3 specular;
+    vec4 positionRange;       // xyz: position, w: how far it reaches
+    vec4 colorAmbient;        // rgb: color, a: ambient intensity
+    vec4 attenuationSpecular; // constant, linear, quadratic, specular strength
 };
 
-uniform PointLight pointLights[2];
-
-// Used for our specular highlights
-uniform mat4 view;
+// The lights come in a block from a uniform buffer, recorded by the
+// Renderer (LightsBlock in DeferredShading.hpp must match this layout).
+layout(std140) uniform Lights{
+    PointLight pointLights[64];
+    mat4 viewProjection;
+    mat4 inverseViewProjection;
+    vec4 eyePosition;
+    ivec4 lightCount;
+};
 
 
 // Import our normal data
@@ -39,44 +34,111 @@ uniform sampler2D u_DiffuseMap;
 // Load in an additional detail map
 //uniform sampler2D u_DetailMap; 
 
+#ifdef VIRTUAL_TEXTURE
+// The diffuse map is a virtual texture streamed in pages (see
+// VirtualTexture.hpp; VirtualTextureBlock must match this layout)
+layout(std140) uniform VirtualTexture{
+    vec4 vtLayout; // Texels and pages along level 0, levels, feedback scale (log2)
+    vec4 vtCache;  // Page texels, border, pages and texels along the cache
+};
+// One level per level of the texture: where each page is in the cache,
+// or the nearest coarser page that is
+uniform sampler2D u_PageTable;
+uniform sampler2D u_PageCache;
+
+vec3 SampleVirtual(vec2 uv){
+    vec2 texels = uv * vtLayout.x;
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float level = clamp(floor(0.5 * log2(max(dot(dx,dx), dot(dy,dy)))), 0.0, vtLayout.z - 1.0);
+    uv = clamp(uv, 0.0, 0.99999);
+    ivec2 page = ivec2(uv * (vtLayout.y / exp2(level)));
+    vec3 entry = floor(texelFetch(u_PageTable, page, int(level)).xyz * 255.0 + 0.5);
+    // Where uv is in the page we found, which may be a coarser one
+    vec2 inPage = fract(uv * (vtLayout.y / exp2(entry.z)));
+    vec2 texel = entry.xy * (vtCache.x + 2.0 * vtCache.y) + vtCache.y + inPage * vtCache.x;
+    return textureLod(u_PageCache, texel / vtCache.w, 0.0).rgb;
+}
+#endif
+
+// The sun's cascaded shadow maps (ShadowBlock in ShadowCascades.hpp must
+// match this layout). Cascade i covers view distances up to cascadeEnds[i].
+layout(std140) uniform Shadows{
+    mat4 lightViewProjections[4];
+    mat4 cameraView;
+    vec4 cascadeEnds;
+    vec4 lightDirection;
+    ivec4 cascadeCount; // 0 when shadows are off
+};
+// One layer per cascade, compared with the depth we look up
+uniform sampler2DArrayShadow u_ShadowMap;
+
+// 1.0 where the sun reaches the fragment, 0.0 in shadow
+float SunVisibility()
+{
+    float distance = -(cameraView * vec4(FragPos,1.0)).z;
+    int cascade = 0;
+    while(cascade < cascadeCount.x - 1 && distance > cascadeEnds[cascade]){
+        cascade++;
+    }
+    // Orthographic, so no divide by w
+    vec3 coords = (lightViewProjections[cascade] * vec4(FragPos,1.0)).xyz * 0.5 + 0.5;
+    if(any(lessThan(coords,vec3(0.0))) || any(greaterThan(coords,vec3(1.0)))){
+        return 1.0;
+    }
+    return texture(u_ShadowMap, vec4(coords.xy, float(cascade), coords.z - 0.0005));
+}
+
 void main()
 {
     // Compute the normal direction
     vec3 norm = normalize(myNormal);
     
     // Store our final texture color
+#ifdef VIRTUAL_TEXTURE
+    // The detail map is baked into it
+    vec3 diffuseColor   = SampleVirtual(v_texCoord);
+#else
     vec3 diffuseColor   = texture(u_DiffuseMap, v_texCoord).rgb;
+#endif
 //    vec3 detailColor    = texture(u_DetailMap,  v_texCoord).rgb;
 
 	// Store our final lighting computation
 	vec3 Lighting = vec3(0.0,0.0,0.0);
 
-	// TODO: (Optional) You should refactor this into a separate function :)
-	for(int i=0; i < 1; i++){
+	// The same computation lights the deferred path, once per lit pixel
+	// (see shaders/light_volume_frag.glsl)
+	for(int i=0; i < lightCount.x; i++){
+		vec3 lightPos = pointLights[i].positionRange.xyz;
+		vec3 lightColor = pointLights[i].colorAmbient.rgb;
+		// Calculate Attenuation here
+		// distance and lighting... 
+		// Past its range a light adds too little to see
+		float distance = length(lightPos - FragPos);
+		if(distance > pointLights[i].positionRange.w){
+			continue;
+		}
+		vec4 falloff = pointLights[i].attenuationSpecular;
+		float attenuation = 1.0 / (falloff.x + falloff.y * distance + falloff.z * (distance*distance));
+
 		// (1) Compute ambient light
-		vec3 ambient = pointLights[i].ambientIntensity * pointLights[i].lightColor;
+		vec3 ambient = pointLights[i].colorAmbient.a * lightColor;
 
 		// (2) Compute diffuse light
 		// From our lights position and the fragment, we can get
 		// a vector indicating direction
 		// Note it is always good to 'normalize' values.
-		vec3 lightDir = normalize(pointLights[i].lightPos - FragPos);
+		vec3 lightDir = normalize(lightPos - FragPos);
 		// Now we can compute the diffuse light impact
 		float diffImpact = max(dot(norm, lightDir), 0.0);
-		vec3 diffuseLight = diffImpact * pointLights[i].lightColor;
+		vec3 diffuseLight = diffImpact * lightColor;
 
 		// (3) Compute Specular lighting
-		vec3 viewPos = vec3(0.0,0.0,0.0);
-		vec3 viewDir = normalize(viewPos - FragPos);
+		vec3 viewDir = normalize(eyePosition.xyz - FragPos);
 		vec3 reflectDir = reflect(-lightDir, norm);
 
 		float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
-		vec3 specular = pointLights[i].specularStrength * spec * pointLights[i].lightColor;
-
-		// Calculate Attenuation here
-		// distance and lighting... 
-		float distance = length(pointLights[i].lightPos - FragPos);
-		float attenuation = 1.0 / (pointLights[i].constant + pointLights[i].linear * distance + pointLights[i].quadratic * (distance*distance));
+		vec3 specular = falloff.w * spec * lightColor;
 
 		ambient 		*= attenuation;
 		diffuseLight 	*= attenuation;
@@ -88,6 +150,12 @@ void main()
 		Lighting += diffuseLight + ambient + specular;
 	}
 
+	// The sun: darker where it is blocked or hits at a grazing angle
+	if(cascadeCount.x > 0){
+		float sun = SunVisibility() * max(dot(norm, -lightDirection.xyz), 0.0);
+		Lighting *= 0.55 + 0.45 * sun;
+	}
+
     // Final color + "how dark or light to make fragment"
     if(gl_FrontFacing){
         FragColor = vec4(diffuseColor * Lighting,1.0);
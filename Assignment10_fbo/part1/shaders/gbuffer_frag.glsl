@@ -0,0 +1,66 @@
+// ==================================================================
+#version 330 core
+// The first pass of the deferred path (see DeferredShading.hpp): instead
+// of lighting the fragment, store what lighting it takes. The position
+// is not stored, the lighting rebuilds it from the depth buffer.
+
+// Albedo into RGBA8, the normal into RG16
+layout(location=0) out vec4 Albedo;
+layout(location=1) out vec2 Normal;
+
+// What shaders/vert.glsl (or vert_pull.glsl) sends us
+in vec3 myNormal;
+in vec2 v_texCoord;
+in vec3 FragPos;
+
+uniform sampler2D u_DiffuseMap;
+
+// The same as in shaders/frag.glsl
+#ifdef VIRTUAL_TEXTURE
+// The diffuse map is a virtual texture streamed in pages (see
+// VirtualTexture.hpp; VirtualTextureBlock must match this layout)
+layout(std140) uniform VirtualTexture{
+    vec4 vtLayout; // Texels and pages along level 0, levels, feedback scale (log2)
+    vec4 vtCache;  // Page texels, border, pages and texels along the cache
+};
+// One level per level of the texture: where each page is in the cache,
+// or the nearest coarser page that is
+uniform sampler2D u_PageTable;
+uniform sampler2D u_PageCache;
+
+vec3 SampleVirtual(vec2 uv){
+    vec2 texels = uv * vtLayout.x;
+    vec2 dx = dFdx(texels);
+    vec2 dy = dFdy(texels);
+    float level = clamp(floor(0.5 * log2(max(dot(dx,dx), dot(dy,dy)))), 0.0, vtLayout.z - 1.0);
+    uv = clamp(uv, 0.0, 0.99999);
+    ivec2 page = ivec2(uv * (vtLayout.y / exp2(level)));
+    vec3 entry = floor(texelFetch(u_PageTable, page, int(level)).xyz * 255.0 + 0.5);
+    // Where uv is in the page we found, which may be a coarser one
+    vec2 inPage = fract(uv * (vtLayout.y / exp2(entry.z)));
+    vec2 texel = entry.xy * (vtCache.x + 2.0 * vtCache.y) + vtCache.y + inPage * vtCache.x;
+    return textureLod(u_PageCache, texel / vtCache.w, 0.0).rgb;
+}
+#endif
+
+// OctahedralEncode() in Impostor.cpp: a unit direction in [0, 1] x [0, 1]
+vec2 EncodeNormal(vec3 n){
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 p = n.xz;
+    if(n.y < 0.0){
+        p = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0,
+                                     n.z >= 0.0 ? 1.0 : -1.0);
+    }
+    return p * 0.5 + 0.5;
+}
+
+void main()
+{
+#ifdef VIRTUAL_TEXTURE
+    Albedo = vec4(SampleVirtual(v_texCoord), 1.0);
+#else
+    Albedo = vec4(texture(u_DiffuseMap, v_texCoord).rgb, 1.0);
+#endif
+    Normal = EncodeNormal(normalize(myNormal));
+}
+// ==================================================================
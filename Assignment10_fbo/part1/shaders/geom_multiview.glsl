@@ -0,0 +1,33 @@
+// ==================================================================
+#version 330 core
+// Sends each triangle of a multi-view draw to the layer of its view
+// (vert.glsl compiled with MULTIVIEW, see MultiView.hpp). OpenGL 3.3 can
+// only choose the layer here, not in the vertex shader.
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+in VertexData{
+    vec3 myNormal;
+    vec3 FragPos;
+    vec2 v_texCoord;
+    flat int layer;
+} vertices[];
+
+// What frag.glsl reads
+out vec3 myNormal;
+out vec3 FragPos;
+out vec2 v_texCoord;
+
+void main()
+{
+    for(int i = 0; i < 3; ++i){
+        gl_Position = gl_in[i].gl_Position;
+        gl_Layer = vertices[i].layer;
+        myNormal = vertices[i].myNormal;
+        FragPos = vertices[i].FragPos;
+        v_texCoord = vertices[i].v_texCoord;
+        EmitVertex();
+    }
+    EndPrimitive();
+}
+// ==================================================================
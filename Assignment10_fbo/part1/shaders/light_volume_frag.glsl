@@ -0,0 +1,74 @@
+// ==================================================================
+#version 330 core
+// Lights the pixel the G-buffer holds with light v_light, the way
+// shaders/frag.glsl does. The results of all lights are added up
+// (glBlendFunc(GL_ONE, GL_ONE)) and shaders/deferred_resolve_frag.glsl
+// multiplies them by the albedo.
+
+struct PointLight{
+    vec4 positionRange;
+    vec4 colorAmbient;
+    vec4 attenuationSpecular;
+};
+layout(std140) uniform Lights{
+    PointLight pointLights[64];
+    mat4 viewProjection;
+    mat4 inverseViewProjection;
+    vec4 eyePosition;
+    ivec4 lightCount;
+};
+
+// The G-buffer
+uniform sampler2D u_Depth;
+uniform sampler2D u_Normal;
+
+flat in int v_light;
+
+out vec4 Light;
+
+// OctahedralDecode() in Impostor.cpp
+vec3 DecodeNormal(vec2 uv){
+    vec2 p = uv * 2.0 - 1.0;
+    vec3 n = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+    if(n.y < 0.0){
+        n.xz = (1.0 - abs(p.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0,
+                                        p.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(u_Depth, pixel, 0).r;
+    // Nothing was drawn here
+    if(depth == 1.0){
+        discard;
+    }
+    // Back from the depth buffer to world space
+    vec2 uv = (vec2(pixel) + 0.5) / vec2(textureSize(u_Depth, 0));
+    vec4 world = inverseViewProjection * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    vec3 FragPos = world.xyz / world.w;
+
+    vec3 lightPos = pointLights[v_light].positionRange.xyz;
+    float distance = length(lightPos - FragPos);
+    // The box's corners reach further than the light
+    if(distance > pointLights[v_light].positionRange.w){
+        discard;
+    }
+    vec3 norm = DecodeNormal(texelFetch(u_Normal, pixel, 0).rg);
+    vec3 lightColor = pointLights[v_light].colorAmbient.rgb;
+    vec4 falloff = pointLights[v_light].attenuationSpecular;
+    float attenuation = 1.0 / (falloff.x + falloff.y * distance + falloff.z * (distance*distance));
+
+    vec3 ambient = pointLights[v_light].colorAmbient.a * lightColor;
+    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 diffuseLight = max(dot(norm, lightDir), 0.0) * lightColor;
+    vec3 viewDir = normalize(eyePosition.xyz - FragPos);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    vec3 specular = falloff.w * spec * lightColor;
+
+    Light = vec4((ambient + diffuseLight + specular) * attenuation, 1.0);
+}
+// ==================================================================
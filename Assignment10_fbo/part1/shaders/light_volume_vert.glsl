@@ -0,0 +1,35 @@
+// ==================================================================
+#version 330 core
+// The box around light gl_InstanceID's range (see DeferredShading.hpp),
+// made from gl_VertexID: 36 vertices, outward faces counter clockwise.
+// Drawn with front faces culled, so each pixel is lit once per light.
+
+struct PointLight{
+    vec4 positionRange;
+    vec4 colorAmbient;
+    vec4 attenuationSpecular;
+};
+layout(std140) uniform Lights{
+    PointLight pointLights[64];
+    mat4 viewProjection;
+    mat4 inverseViewProjection;
+    vec4 eyePosition;
+    ivec4 lightCount;
+};
+
+// Corner bits: x is bit 0, y bit 1, z bit 2
+const int kCorners[36] = int[36](0,4,6, 0,6,2,  1,3,7, 1,7,5,
+                                 0,1,5, 0,5,4,  2,6,7, 2,7,3,
+                                 0,2,3, 0,3,1,  4,5,7, 4,7,6);
+
+flat out int v_light;
+
+void main()
+{
+    int corner = kCorners[gl_VertexID];
+    vec3 offset = vec3(corner & 1, (corner >> 1) & 1, (corner >> 2) & 1) * 2.0 - 1.0;
+    vec4 light = pointLights[gl_InstanceID].positionRange;
+    gl_Position = viewProjection * vec4(light.xyz + offset * light.w, 1.0);
+    v_light = gl_InstanceID;
+}
+// ==================================================================
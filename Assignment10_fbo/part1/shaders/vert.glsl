@@ -11,21 +11,46 @@ layout(location=4)in vec3 bitangents; // Our third attribute - texture coordinat
 
 // If we are applying our camera, then we need to add some uniforms.
 // Note that the syntax nicely matches glm's mat4!
-uniform mat4 model; // Object space
-uniform mat4 view; // Object space
-uniform mat4 projection; // Object space
+// They come in a block from a uniform buffer, recorded with each draw
+// (TransformBlock in SceneNode.hpp must match this layout).
+layout(std140) uniform Transforms{
+    mat4 model; // Object space
+    mat4 view; // Object space
+    mat4 projection; // Object space
+};
 
+#ifdef MULTIVIEW
+// Compiled with MULTIVIEW by SceneNode for drawing several views at once
+// (see MultiView.hpp): instance i is drawn with view i and sent to layer i
+// by shaders/geom_multiview.glsl, which reads this block.
+layout(std140) uniform Views{
+    mat4 viewProjections[4];
+    ivec4 viewCount;
+};
+out VertexData{
+    vec3 myNormal;
+    vec3 FragPos;
+    vec2 v_texCoord;
+    flat int layer;
+};
+#else
 // Export our normal data, and read it into our frag shader
 out vec3 myNormal;
 // Export our Fragment Position computed in world space
 out vec3 FragPos;
 // If we have texture coordinates we can now use this as well
 out vec2 v_texCoord;
+#endif
 
 void main()
 {
 
+#ifdef MULTIVIEW
+    gl_Position = viewProjections[gl_InstanceID] * model * vec4(position, 1.0f);
+    layer = gl_InstanceID;
+#else
     gl_Position = projection * view * model * vec4(position, 1.0f);
+#endif
 
     myNormal = normals;
     // Transform normal into world space
@@ -0,0 +1,88 @@
+// ==================================================================
+#version 330 core
+// vert.glsl for meshes in a VertexPool (see VertexPulling.hpp): there are
+// no attributes, the vertex is fetched from the pool's buffers and
+// decoded here.
+uniform usamplerBuffer u_PulledVertices; // One packed vertex per texel
+uniform usamplerBuffer u_PulledIndices;  // The meshes' indices
+
+// If we are applying our camera, then we need to add some uniforms.
+// They come in a block from a uniform buffer, recorded with each draw
+// (TransformBlock in SceneNode.hpp must match this layout).
+layout(std140) uniform Transforms{
+    mat4 model; // Object space
+    mat4 view; // Object space
+    mat4 projection; // Object space
+};
+// Where the mesh is in the pool and how to decode it (PulledMeshBlock)
+layout(std140) uniform PulledMesh{
+    vec4 positionMin;
+    vec4 positionScale;
+    vec4 texCoordRange; // Min (xy) and scale (zw)
+    ivec4 offsets; // x: base vertex
+};
+
+#ifdef MULTIVIEW
+// Compiled with MULTIVIEW by SceneNode for drawing several views at once
+// (see MultiView.hpp): instance i is drawn with view i and sent to layer i
+// by shaders/geom_multiview.glsl, which reads this block.
+layout(std140) uniform Views{
+    mat4 viewProjections[4];
+    ivec4 viewCount;
+};
+out VertexData{
+    vec3 myNormal;
+    vec3 FragPos;
+    vec2 v_texCoord;
+    flat int layer;
+};
+#else
+// Export our normal data, and read it into our frag shader
+out vec3 myNormal;
+// Export our Fragment Position computed in world space
+out vec3 FragPos;
+// If we have texture coordinates we can now use this as well
+out vec2 v_texCoord;
+#endif
+
+// The two 16 bit halves of a packed value, 0..1
+vec2 Unpack16(uint value){
+    return vec2(value & 0xFFFFu, value >> 16) / 65535.0;
+}
+
+// OctahedralDecode() in Impostor.cpp
+vec3 DecodeNormal(vec2 uv){
+    vec2 p = uv * 2.0 - 1.0;
+    vec3 n = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+    if(n.y < 0.0){
+        n.xz = (1.0 - abs(p.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0,
+                                        p.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(n);
+}
+
+void main()
+{
+    // gl_VertexID counts from the mesh's first index (the draw's 'first')
+    int index = int(texelFetch(u_PulledIndices, gl_VertexID).r) + offsets.x;
+    uvec4 vertex = texelFetch(u_PulledVertices, index);
+
+    vec3 position = positionMin.xyz + positionScale.xyz *
+                    vec3(Unpack16(vertex.x), Unpack16(vertex.y).x);
+    vec3 normals = DecodeNormal(Unpack16(vertex.z));
+    vec2 texCoord = texCoordRange.xy + texCoordRange.zw * Unpack16(vertex.w);
+
+#ifdef MULTIVIEW
+    gl_Position = viewProjections[gl_InstanceID] * model * vec4(position, 1.0f);
+    layer = gl_InstanceID;
+#else
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+#endif
+
+    myNormal = normals;
+    // Transform normal into world space
+    FragPos = vec3(model* vec4(position,1.0f));
+
+    v_texCoord = texCoord;
+}
+// ==================================================================
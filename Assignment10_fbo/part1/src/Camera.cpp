@@ -94,6 +94,10 @@ void Camera::SetCameraEyePosition(float x, float y, float z){
     m_eyePosition.z = z;
 }
 
+void Camera::SetCameraViewDirection(float x, float y, float z){
+    m_viewDirection = glm::normalize(glm::vec3(x,y,z));
+}
+
 float Camera::GetEyeXPosition(){
     return m_eyePosition.x;
 }
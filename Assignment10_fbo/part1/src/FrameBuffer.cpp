@@ -1,15 +1,13 @@
-#if defined(LINUX) || defined(MINGW)
-    #include <SDL2/SDL.h>
-#else // This works for Mac
-    #include <SDL.h>
-#endif
-
-
 #include "Framebuffer.hpp"
 #include "Shader.hpp"
+#include "ResourceTracker.hpp"
+#include "FrameStats.hpp"
+#include "GLState.hpp"
 
 #include <glad/glad.h>
 
+#include <iostream>
+
 
 Framebuffer::Framebuffer(){
     // (1) ======= Setup shader
@@ -28,7 +26,24 @@ Framebuffer::Framebuffer(){
 
 // Destructor
 Framebuffer::~Framebuffer(){
+    ResourceTracker& tracker = ResourceTracker::Instance();
+    tracker.UntrackGpu(GpuResourceKind::Framebuffer,m_fbo_id);
+    tracker.UntrackGpu(GpuResourceKind::Texture,m_colorBuffer_id);
+    tracker.UntrackGpu(GpuResourceKind::Renderbuffer,m_rbo_id);
+    tracker.UntrackGpu(GpuResourceKind::Texture,m_depthBuffer_id);
+    for(unsigned int target : m_extraTargets){
+        tracker.UntrackGpu(GpuResourceKind::Texture,target);
+    }
+    tracker.UntrackGpu(GpuResourceKind::VertexArray,m_quadVAO);
+    tracker.UntrackGpu(GpuResourceKind::Buffer,m_quadVBO);
     glDeleteFramebuffers(1,&m_fbo_id); 
+    // The attachments are separate objects and need to be deleted as well
+    glDeleteTextures(1,&m_colorBuffer_id);
+    glDeleteRenderbuffers(1,&m_rbo_id);
+    glDeleteTextures(1,&m_depthBuffer_id);
+    if(!m_extraTargets.empty()){
+        glDeleteTextures(static_cast<GLsizei>(m_extraTargets.size()),m_extraTargets.data());
+    }
     glDeleteVertexArrays(1,&m_quadVAO);
     glDeleteBuffers(1,&m_quadVBO);
 }
@@ -39,7 +54,11 @@ Framebuffer::~Framebuffer(){
 // width and height information
 // TODO: What happens if the window resizes?
 //       Answer: Need to regenerate our buffer
-void Framebuffer::Create(int width, int height){
+void Framebuffer::Create(int width, int height, int layers){
+    if(layers > 1){
+        CreateLayered(width,height,layers);
+        return;
+    }
 
     // Generate a framebuffer
     glGenFramebuffers(1, &m_fbo_id);
@@ -47,7 +66,7 @@ void Framebuffer::Create(int width, int height){
     Bind();
     // Create a color attachment texture
     glGenTextures(1, &m_colorBuffer_id);
-    glBindTexture(GL_TEXTURE_2D, m_colorBuffer_id);
+    GLState::Instance().BindTexture(0, GL_TEXTURE_2D, m_colorBuffer_id);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL); 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -59,10 +78,124 @@ void Framebuffer::Create(int width, int height){
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_rbo_id);
     // Deselect our buffers
     Unbind();
+
+    // Report the framebuffer and both attachments
+    ResourceTracker& tracker = ResourceTracker::Instance();
+    tracker.TrackGpu(GpuResourceKind::Framebuffer,m_fbo_id,0,0,"Framebuffer");
+    tracker.TrackGpu(GpuResourceKind::Texture,m_colorBuffer_id,
+                     ResourceTracker::TextureBytes(width,height,3,false),GL_RGB8,"Framebuffer:color");
+    tracker.TrackGpu(GpuResourceKind::Renderbuffer,m_rbo_id,
+                     ResourceTracker::TextureBytes(width,height,4,false),GL_DEPTH24_STENCIL8,"Framebuffer:depth");
+}
+// One texture array each for color and depth, attached whole so that
+// every layer can be drawn to
+void Framebuffer::CreateLayered(int width, int height, int layers){
+    m_layers = layers;
+    // The quad reads one layer of the array
+    m_fboShader = std::make_shared<Shader>();
+    std::string fboVertexShader = m_fboShader->LoadShader("./shaders/fboVert.glsl");
+    std::string fboFragmentShader = m_fboShader->LoadShader("./shaders/fboFragLayered.glsl");
+    m_fboShader->CreateShader(fboVertexShader,fboFragmentShader);
+
+    glGenFramebuffers(1, &m_fbo_id);
+    Bind();
+    GLState& state = GLState::Instance();
+    glGenTextures(1, &m_colorBuffer_id);
+    state.BindTexture(0, GL_TEXTURE_2D_ARRAY, m_colorBuffer_id);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB, width, height, layers, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, m_colorBuffer_id, 0);
+    glGenTextures(1, &m_depthBuffer_id);
+    state.BindTexture(0, GL_TEXTURE_2D_ARRAY, m_depthBuffer_id);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH24_STENCIL8, width, height, layers, 0,
+                 GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, m_depthBuffer_id, 0);
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::cerr << "Layered framebuffer is not complete\n";
+    }
+    Unbind();
+
+    ResourceTracker& tracker = ResourceTracker::Instance();
+    tracker.TrackGpu(GpuResourceKind::Framebuffer,m_fbo_id,0,0,"Framebuffer");
+    tracker.TrackGpu(GpuResourceKind::Texture,m_colorBuffer_id,
+                     layers*ResourceTracker::TextureBytes(width,height,3,false),GL_RGB8,"Framebuffer:color");
+    tracker.TrackGpu(GpuResourceKind::Texture,m_depthBuffer_id,
+                     layers*ResourceTracker::TextureBytes(width,height,4,false),GL_DEPTH24_STENCIL8,"Framebuffer:depth");
+}
+
+// How the formats CreateTargets() takes are uploaded, and their size
+static bool TargetFormat(GLenum internalFormat, GLenum& format, GLenum& type, int& bytes){
+    switch(internalFormat){
+    case GL_RGBA8:   format = GL_RGBA; type = GL_UNSIGNED_BYTE;  bytes = 4; return true;
+    case GL_RG16:    format = GL_RG;   type = GL_UNSIGNED_SHORT; bytes = 4; return true;
+    case GL_RGBA16F: format = GL_RGBA; type = GL_HALF_FLOAT;     bytes = 8; return true;
+    default: return false;
+    }
+}
+
+// Nearest filtering everywhere: the targets are read a pixel at a time
+void Framebuffer::CreateTargets(int width, int height, const std::vector<GLenum>& formats, bool depth){
+    glGenFramebuffers(1, &m_fbo_id);
+    Bind();
+    GLState& state = GLState::Instance();
+    ResourceTracker& tracker = ResourceTracker::Instance();
+    tracker.TrackGpu(GpuResourceKind::Framebuffer,m_fbo_id,0,0,"Framebuffer");
+    std::vector<GLenum> outputs;
+    for(size_t i=0; i < formats.size(); ++i){
+        GLenum format, type;
+        int bytes;
+        if(!TargetFormat(formats[i],format,type,bytes)){
+            std::cerr << "Framebuffer: unsupported target format 0x" << std::hex << formats[i] << std::dec << "\n";
+            continue;
+        }
+        GLuint texture;
+        glGenTextures(1, &texture);
+        state.BindTexture(0, GL_TEXTURE_2D, texture);
+        glTexImage2D(GL_TEXTURE_2D, 0, formats[i], width, height, 0, format, type, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        GLenum attachment = GL_COLOR_ATTACHMENT0 + static_cast<GLenum>(outputs.size());
+        glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, texture, 0);
+        outputs.push_back(attachment);
+        if(m_colorBuffer_id == 0){
+            m_colorBuffer_id = texture;
+        }else{
+            m_extraTargets.push_back(texture);
+        }
+        tracker.TrackGpu(GpuResourceKind::Texture,texture,
+                         ResourceTracker::TextureBytes(width,height,bytes,false),formats[i],"Framebuffer:target");
+    }
+    glDrawBuffers(static_cast<GLsizei>(outputs.size()), outputs.data());
+    if(depth){
+        glGenTextures(1, &m_depthBuffer_id);
+        state.BindTexture(0, GL_TEXTURE_2D, m_depthBuffer_id);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, width, height, 0,
+                     GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_TEXTURE_2D, m_depthBuffer_id, 0);
+        tracker.TrackGpu(GpuResourceKind::Texture,m_depthBuffer_id,
+                         ResourceTracker::TextureBytes(width,height,4,false),GL_DEPTH24_STENCIL8,"Framebuffer:depth");
+    }
+    if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+        std::cerr << "Framebuffer with " << outputs.size() << " targets is not complete\n";
+    }
+    Unbind();
+}
+
+unsigned int Framebuffer::GetColorTexture(int index) const{
+    if(index == 0){
+        return m_colorBuffer_id;
+    }
+    return index <= static_cast<int>(m_extraTargets.size()) ? m_extraTargets[index-1] : 0;
 }
+
 // Select our framebuffer
 void Framebuffer::Bind(){
-    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo_id);
+    GLState::Instance().BindFramebuffer(GL_FRAMEBUFFER, m_fbo_id);
 }
 
 // Update our framebuffer once per frame for any
@@ -80,16 +213,23 @@ void Framebuffer::Update(){
 
 // Done with our framebuffer
 void Framebuffer::Unbind(){
-    glBindFramebuffer(GL_FRAMEBUFFER,0);
+    GLState::Instance().BindFramebuffer(GL_FRAMEBUFFER,0);
 }
 
 // Draws the screen quad
 // This is the actual rendering of our FBO to the screen.
 // Typically this would be called after 'update'
-void Framebuffer::DrawFBO(){
-    glBindVertexArray(m_quadVAO);
-    glBindTexture(GL_TEXTURE_2D, m_colorBuffer_id);   // use the color attachment texture as the texture of the quad plane
+void Framebuffer::DrawFBO(int layer){
+    GLState& state = GLState::Instance();
+    state.BindVertexArray(m_quadVAO);
+    if(m_layers > 1){
+        state.BindTexture(0, GL_TEXTURE_2D_ARRAY, m_colorBuffer_id);
+        m_fboShader->SetUniform1i("u_Layer",layer);
+    }else{
+        state.BindTexture(0, GL_TEXTURE_2D, m_colorBuffer_id);   // use the color attachment texture as the texture of the quad plane
+    }
     glDrawArrays(GL_TRIANGLES, 0, 6);
+    FrameStats::Instance().CountDraw(2);
 }
 
 // ============== Private Member Functions ==============
@@ -117,13 +257,18 @@ void Framebuffer::SetupScreenQuad(float x,float y, float w, float h){
 // screen quad VAO
     glGenVertexArrays(1, &m_quadVAO);
     glGenBuffers(1, &m_quadVBO);
-    glBindVertexArray(m_quadVAO);
+    GLState& state = GLState::Instance();
+    state.BindVertexArray(m_quadVAO);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
+    state.BindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(quad), &quad, GL_STATIC_DRAW);
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*)(2*sizeof(float)));
 
+    ResourceTracker& tracker = ResourceTracker::Instance();
+    tracker.TrackGpu(GpuResourceKind::VertexArray,m_quadVAO,0,0,"Framebuffer:quad");
+    tracker.TrackGpu(GpuResourceKind::Buffer,m_quadVBO,sizeof(quad),GL_ARRAY_BUFFER,"Framebuffer:quad");
+
 }
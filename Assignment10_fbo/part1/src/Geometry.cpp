@@ -100,6 +100,41 @@ void Geometry::Gen(){
 		m_bufferData.push_back(m_biTangents[i*3+1]);
 		m_bufferData.push_back(m_biTangents[i*3+2]);
 	}
+	UpdateTrackedBytes();
+}
+
+// Once the VBO and IBO are filled, we no longer need the interleaved
+// copy or the individual attributes to draw.
+//  - GpuOnly frees everything.
+//  - CpuCollision keeps only positions and indices (for picking).
+//  - CpuAndGpu keeps everything.
+void Geometry::ApplyResidency(Residency residency){
+	if(residency == Residency::CpuAndGpu){
+		return;
+	}
+	FreeVector(m_bufferData);
+	FreeVector(m_textureCoords);
+	FreeVector(m_normals);
+	FreeVector(m_tangents);
+	FreeVector(m_biTangents);
+	if(residency == Residency::GpuOnly){
+		FreeVector(m_vertexPositions);
+		FreeVector(m_indices);
+	}else{
+		m_vertexPositions.shrink_to_fit();
+		m_indices.shrink_to_fit();
+	}
+	UpdateTrackedBytes();
+}
+
+// Every vector holds a separate CPU copy of the vertex data, so
+// report the sum of their capacities.
+void Geometry::UpdateTrackedBytes(){
+	size_t bytes = (m_bufferData.capacity() + m_vertexPositions.capacity() +
+	                m_textureCoords.capacity() + m_normals.capacity() +
+	                m_tangents.capacity() + m_biTangents.capacity()) * sizeof(float) +
+	               m_indices.capacity() * sizeof(unsigned int);
+	m_trackedBytes.Set(bytes);
 }
 
 // The big trick here, is that when we make a triangle
@@ -0,0 +1,143 @@
+#include "Material.hpp"
+#include "VertexPulling.hpp"
+
+#include <algorithm>
+#include <string>
+#include <iostream>
+
+// The constructor
+Material::Material(std::string vertShader, std::string fragShader,
+                   const std::vector<std::string>& defines){
+	std::cout << "(Material.cpp) Constructor called\n";
+
+    // Create shader
+    m_shader = std::make_shared<Shader>();
+	// Setup shaders for the material.
+	std::string vertexShader   = m_shader->LoadShader(vertShader);
+	std::string fragmentShader = m_shader->LoadShader(fragShader);
+	for(const std::string& define : defines){
+		vertexShader = Shader::AddDefine(vertexShader,define);
+		fragmentShader = Shader::AddDefine(fragmentShader,define);
+	}
+
+	// Actually create our shader
+	m_shader->CreateShader(vertexShader,fragmentShader);
+	// The matrices come from a uniform buffer range (see Renderer)
+	m_shader->SetUniformBlockBinding("Transforms",kTransformsBinding);
+	m_shader->SetUniformBlockBinding("PulledMesh",kPulledMeshBinding);
+
+	// Draws every view at once (see MultiView.hpp)
+	m_multiViewShader = std::make_shared<Shader>();
+	m_multiViewShader->CreateShader(Shader::AddDefine(vertexShader,"MULTIVIEW"),
+	                                m_multiViewShader->LoadShader("./shaders/geom_multiview.glsl"),
+	                                fragmentShader);
+	m_multiViewShader->SetUniformBlockBinding("Transforms",kTransformsBinding);
+	m_multiViewShader->SetUniformBlockBinding("PulledMesh",kPulledMeshBinding);
+	m_multiViewShader->SetUniformBlockBinding("Views",kViewsBinding);
+	m_shader->SetUniformBlockBinding("Shadows",kShadowsBinding);
+	m_multiViewShader->SetUniformBlockBinding("Shadows",kShadowsBinding);
+	m_shader->SetUniformBlockBinding("Lights",kLightsBinding);
+	m_multiViewShader->SetUniformBlockBinding("Lights",kLightsBinding);
+
+	// Draws into the shadow maps
+	m_depthShader = std::make_shared<Shader>();
+	m_depthShader->CreateShader(vertexShader,m_depthShader->LoadShader("./shaders/depth_frag.glsl"));
+	m_depthShader->SetUniformBlockBinding("Transforms",kTransformsBinding);
+	m_depthShader->SetUniformBlockBinding("PulledMesh",kPulledMeshBinding);
+
+	// Draws into the G-buffer of the deferred path
+	m_gbufferShader = std::make_shared<Shader>();
+	std::string gbufferShader = m_gbufferShader->LoadShader("./shaders/gbuffer_frag.glsl");
+	for(const std::string& define : defines){
+		gbufferShader = Shader::AddDefine(gbufferShader,define);
+	}
+	m_gbufferShader->CreateShader(vertexShader,gbufferShader);
+	m_gbufferShader->SetUniformBlockBinding("Transforms",kTransformsBinding);
+	m_gbufferShader->SetUniformBlockBinding("PulledMesh",kPulledMeshBinding);
+
+	// Finds the pages of the virtual texture the camera sees
+	if(std::find(defines.begin(),defines.end(),"VIRTUAL_TEXTURE") != defines.end()){
+		m_feedbackShader = std::make_shared<Shader>();
+		m_feedbackShader->CreateShader(vertexShader,m_feedbackShader->LoadShader("./shaders/feedback_frag.glsl"));
+		m_feedbackShader->SetUniformBlockBinding("Transforms",kTransformsBinding);
+		m_feedbackShader->SetUniformBlockBinding("PulledMesh",kPulledMeshBinding);
+		m_feedbackShader->SetUniformBlockBinding("VirtualTexture",kVirtualTextureBinding);
+		m_shader->SetUniformBlockBinding("VirtualTexture",kVirtualTextureBinding);
+		m_multiViewShader->SetUniformBlockBinding("VirtualTexture",kVirtualTextureBinding);
+		m_gbufferShader->SetUniformBlockBinding("VirtualTexture",kVirtualTextureBinding);
+		SetSamplerUnits(*m_feedbackShader);
+	}
+
+	// Samplers keep their units, so this is done once instead of every frame
+	SetSamplerUnits(*m_depthShader);
+	SetSamplerUnits(*m_gbufferShader);
+	SetSamplerUnits(*m_multiViewShader);
+	SetSamplerUnits(*m_shader);
+}
+
+// The destructor
+Material::~Material(){
+}
+
+void Material::LoadTexture(std::string fileName, GpuUploader* uploader){
+        // Load our actual textures
+        m_textureDiffuse.LoadTexture(fileName,Residency::GpuOnly,uploader);
+}
+
+void Material::LoadTextures(std::string colormap, std::string detailmap, GpuUploader* uploader){
+        // Load our actual textures (both files are read at once)
+        Texture::LoadTextures({{&m_textureDiffuse,colormap},
+                               {&m_detailMap,detailmap}},
+                              Residency::GpuOnly,uploader);
+}
+
+void Material::SetVirtualTexture(VirtualTexture* virtualTexture){
+        m_virtualTexture = virtualTexture;
+}
+
+// The program first, then what it samples. The depth pass samples
+// nothing.
+bool Material::Record(CommandBuffer& commands, RenderPass pass) const{
+	if(pass == RenderPass::Feedback){
+		if(m_feedbackShader == nullptr){
+			return false;
+		}
+		commands.BindProgram(m_feedbackShader->GetID());
+	}else if(pass == RenderPass::MultiView){
+		commands.BindProgram(m_multiViewShader->GetID());
+	}else if(pass == RenderPass::Depth){
+		commands.BindProgram(m_depthShader->GetID());
+		return true;
+	}else if(pass == RenderPass::GBuffer){
+		commands.BindProgram(m_gbufferShader->GetID());
+	}else{
+		commands.BindProgram(m_shader->GetID());
+	}
+	commands.BindTexture(kDiffuseMapUnit, m_textureDiffuse.GetID());
+	commands.BindTexture(kDetailMapUnit, m_detailMap.GetID());
+	// The page table and the cache go next to the diffuse map, with the
+	// block that says how to read them
+	if(m_virtualTexture != nullptr && m_virtualTexture->IsCreated()){
+		VirtualTextureBlock block = m_virtualTexture->GetBlock();
+		commands.BindTexture(kPageTableUnit, m_virtualTexture->GetPageTable());
+		commands.BindTexture(kPageCacheUnit, m_virtualTexture->GetPageCache());
+		commands.SetUniformBlock(kVirtualTextureBinding, &block, sizeof(block));
+	}
+	return true;
+}
+
+// The units the samplers read from
+void Material::SetSamplerUnits(Shader& shader){
+    	// Now apply our shader
+		shader.Bind();
+        shader.SetUniform1i("u_DiffuseMap",kDiffuseMapUnit);
+        shader.SetUniform1i("u_DetailMap",kDetailMapUnit);
+        // Where a pulling shader finds the vertices (see VertexPool::Bind)
+        shader.SetUniform1i("u_PulledVertices",VertexPool::kVertexUnit);
+        shader.SetUniform1i("u_PulledIndices",VertexPool::kIndexUnit);
+        shader.SetUniform1i("u_ShadowMap",kShadowMapUnit);
+        shader.SetUniform1i("u_PageTable",kPageTableUnit);
+        shader.SetUniform1i("u_PageCache",kPageCacheUnit);
+        // The model, view and projection matrices are recorded with
+        // the draw, and so are the lights (the Renderer's 'Lights' block)
+}
@@ -0,0 +1,122 @@
+#include "Mesh.hpp"
+#include "Error.hpp"
+#include "Material.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+
+Mesh::Mesh(Residency residency, GpuUploader* uploader, VertexPool* pool) :
+          m_residency(residency), m_uploader(uploader), m_vertexPool(pool){
+}
+
+Mesh::~Mesh(){
+
+}
+
+// Initialization of the mesh as a 'quad'
+//
+// This could be called in the constructor or
+// otherwise 'explicitly' called this
+// so we create our meshes at the correct time
+void Mesh::MakeQuad(){
+
+        // Setup geometry
+        // We are using a new abstraction which allows us
+        // to create triangles shapes on the fly
+        // Position and Texture coordinate
+        m_geometry.AddVertex(-1.0f,-1.0f, 0.0f, 0.0f, 0.0f);
+        m_geometry.AddVertex( 1.0f,-1.0f, 0.0f, 1.0f, 0.0f);
+    	m_geometry.AddVertex( 1.0f, 1.0f, 0.0f, 1.0f, 1.0f);
+        m_geometry.AddVertex(-1.0f, 1.0f, 0.0f, 0.0f, 1.0f);
+
+        // Make our triangles and populate our
+        // indices data structure
+        m_geometry.MakeTriangle(0,1,2);
+        m_geometry.MakeTriangle(2,3,0);
+
+        // This is a helper function to generate all of the geometry
+        m_geometry.Gen();
+
+        // Create a buffer and set the stride of information
+        Create();
+}
+
+// Either packs the geometry into the vertex pool or creates our own
+// buffers with the normal map layout
+void Mesh::Create(){
+    // Around the middle of the bounding box; the buffers and the residency
+    // policy may not leave the positions around later
+    const float* data = m_geometry.GetBufferDataPtr();
+    const size_t stride = 14;
+    const size_t vertexCount = m_geometry.GetBufferDataSize()/stride;
+    if(vertexCount > 0){
+        glm::vec3 minimum(data[0],data[1],data[2]);
+        glm::vec3 maximum = minimum;
+        for(size_t i=0; i < vertexCount; ++i){
+            glm::vec3 position(data[i*stride],data[i*stride+1],data[i*stride+2]);
+            minimum = glm::min(minimum,position);
+            maximum = glm::max(maximum,position);
+        }
+        glm::vec3 center = (minimum+maximum)*0.5f;
+        float radius = 0.0f;
+        for(size_t i=0; i < vertexCount; ++i){
+            glm::vec3 position(data[i*stride],data[i*stride+1],data[i*stride+2]);
+            radius = std::max(radius,glm::length(position-center));
+        }
+        m_boundingSphere = glm::vec4(center,radius);
+    }
+
+    bool pulled = false;
+    if(m_vertexPool != nullptr){
+        // x,y,z, normal, s,t, tangent, bitangent (see Geometry::Gen)
+        VertexStreams streams;
+        streams.data = data;
+        streams.stride = stride;
+        streams.vertexCount = vertexCount;
+        streams.position = 0;
+        streams.normal = 3;
+        streams.texCoord = 6;
+        std::vector<PackedVertex> packed;
+        VertexQuantization quantization = PackVertices(streams,packed);
+        m_pulledMesh = m_vertexPool->Add(packed,
+                                         m_geometry.GetIndicesDataPtr(),
+                                         m_geometry.GetIndicesSize(),
+                                         quantization);
+        pulled = m_pulledMesh.IsValid();
+        if(!pulled){
+            std::cerr << "Not pulling the vertices: " << m_vertexPool->GetError() << "\n";
+        }
+    }
+    if(!pulled){
+        // NOTE: How we are leveraging our data structure in order to very cleanly
+        //       get information into and out of our data structure.
+        m_vertexBufferLayout.CreateNormalBufferLayout(m_geometry.GetBufferDataSize(),
+                                        m_geometry.GetIndicesSize(),
+                                        m_geometry.GetBufferDataPtr(),
+                                        m_geometry.GetIndicesDataPtr(),
+                                        m_uploader);
+    }
+    // The data is on the GPU (or copied for the upload) now, release
+    // what we do not need
+    m_geometry.ApplyResidency(m_residency);
+}
+
+// The binds and the draw, as commands for the GL thread to replay
+void Mesh::Record(CommandBuffer& commands) const{
+    // Every pulled mesh shares the pool's vertex array; only the block
+    // that says where the mesh is changes
+    if(m_pulledMesh.IsValid()){
+        PulledMeshBlock block = m_pulledMesh.GetBlock();
+        commands.BindVertexArray(m_vertexPool->GetVertexArray());
+        commands.SetUniformBlock(kPulledMeshBinding, &block, sizeof(block));
+        commands.DrawArrays(GL_TRIANGLES, m_pulledMesh.firstIndex, m_pulledMesh.indexCount);
+        return;
+    }
+    // Still uploading
+    if(!m_vertexBufferLayout.IsReady()){
+        return;
+    }
+    commands.BindVertexArray(m_vertexBufferLayout.GetVertexArray());
+    commands.DrawIndexed(GL_TRIANGLES, m_vertexBufferLayout.GetIndexCount());
+}
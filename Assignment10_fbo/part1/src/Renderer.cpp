@@ -1,4 +1,28 @@
 #include "Renderer.hpp"
+#include "FrameStats.hpp"
+#include "GLState.hpp"
+#include "ResourceTracker.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#if defined(LINUX) || defined(MINGW)
+    #include <SDL2/SDL.h>
+#else // This works for Mac
+    #include <SDL.h>
+#endif
+
+// Where the lighting stops counting a light (see LightRange()); lights
+// that never fade out reach twice the far plane
+static const float kLightCutoff = 1.0f / 128.0f;
+static const float kMaxLightRange = 1024.0f;
+// Texture units of the G-buffer and light buffer (after the shadow map)
+static const unsigned int kAlbedoUnit = 3;
+static const unsigned int kNormalUnit = 4;
+static const unsigned int kDepthUnit = 5;
+static const unsigned int kLightUnit = 6;
+// The feedback buffer is this many times smaller than the screen
+static const int kFeedbackScale = 8;
 
 
 // Sets the height and width of our renderer
@@ -12,13 +36,33 @@ Renderer::Renderer(unsigned int w, unsigned int h){
     Camera* defaultCamera = new Camera();
     // Add our single camera
     m_cameras.push_back(defaultCamera);
-    // Initialize the root in our scene
-    m_root = nullptr;
 
     // By derfaflt create one framebuffer within the renderere.
     Framebuffer* newFramebuffer = new Framebuffer();
     newFramebuffer->Create(w,h);
     m_framebuffers.push_back(newFramebuffer);
+
+    // Performance overlay and the GPU time it shows
+    m_perfHud.Create();
+    m_gpuTimer.Create();
+    // Uniform buffer the recorded transforms are uploaded to
+    m_replayer.Create();
+
+    // A sun, low enough that the hills cast long shadows
+    m_lightDirection = glm::normalize(glm::vec3(-0.5f,-1.0f,-0.3f));
+    const ShadowSettings& shadows = m_shadowCascades.GetSettings();
+    m_shadowMap.Create(shadows.resolution,static_cast<int>(shadows.cascades));
+
+    // The camera's light (placed every frame in Render())
+    PointLight cameraLight;
+    cameraLight.ambientIntensity = 0.9f;
+    cameraLight.specularStrength = 0.5f;
+    cameraLight.constant = 1.0f;
+    cameraLight.linear = 0.003f;
+    cameraLight.quadratic = 0.0f;
+    m_lights.push_back(cameraLight);
+    m_sceneSamples.Create();
+    m_lightSamples.Create();
 }
 
 // Sets the height and width of our renderer
@@ -31,6 +75,104 @@ Renderer::~Renderer(){
     for(int i=0; i < m_framebuffers.size(); i++){
         delete m_framebuffers[i];
     }
+    delete m_gbuffer;
+    delete m_lightBuffer;
+    if(m_emptyVertexArray != 0){
+        ResourceTracker::Instance().UntrackGpu(GpuResourceKind::VertexArray,m_emptyVertexArray);
+        glDeleteVertexArrays(1,&m_emptyVertexArray);
+    }
+}
+
+// The G-buffer: albedo (RGBA8), octahedral normal (RG16) and depth. The
+// light buffer is RGBA16F, so many lights can add up past 1.
+void Renderer::SetDeferred(bool deferred){
+    m_deferred = deferred;
+    if(!deferred || m_gbuffer != nullptr){
+        return;
+    }
+    m_gbuffer = new Framebuffer();
+    m_gbuffer->CreateTargets(m_screenWidth,m_screenHeight,{GL_RGBA8,GL_RG16},true);
+    m_lightBuffer = new Framebuffer();
+    m_lightBuffer->CreateTargets(m_screenWidth,m_screenHeight,{GL_RGBA16F},false);
+
+    m_lightVolumeShader = std::make_shared<Shader>();
+    m_lightVolumeShader->CreateShader(m_lightVolumeShader->LoadShader("./shaders/light_volume_vert.glsl"),
+                                      m_lightVolumeShader->LoadShader("./shaders/light_volume_frag.glsl"));
+    m_lightVolumeShader->SetUniformBlockBinding("Lights",kLightsBinding);
+    m_lightVolumeShader->Bind();
+    m_lightVolumeShader->SetUniform1i("u_Normal",kNormalUnit);
+    m_lightVolumeShader->SetUniform1i("u_Depth",kDepthUnit);
+
+    m_resolveShader = std::make_shared<Shader>();
+    m_resolveShader->CreateShader(m_resolveShader->LoadShader("./shaders/deferred_resolve_vert.glsl"),
+                                  m_resolveShader->LoadShader("./shaders/deferred_resolve_frag.glsl"));
+    m_resolveShader->SetUniformBlockBinding("Lights",kLightsBinding);
+    m_resolveShader->SetUniformBlockBinding("Shadows",kShadowsBinding);
+    m_resolveShader->Bind();
+    m_resolveShader->SetUniform1i("u_Albedo",kAlbedoUnit);
+    m_resolveShader->SetUniform1i("u_Normal",kNormalUnit);
+    m_resolveShader->SetUniform1i("u_Depth",kDepthUnit);
+    m_resolveShader->SetUniform1i("u_Light",kLightUnit);
+    m_resolveShader->SetUniform1i("u_ShadowMap",kShadowMapUnit);
+
+    glGenVertexArrays(1,&m_emptyVertexArray);
+    ResourceTracker::Instance().TrackGpu(GpuResourceKind::VertexArray,m_emptyVertexArray,0,0,"Renderer:deferred");
+}
+
+void Renderer::PrintShadingReport(std::ostream& out) const{
+    ::PrintShadingReport(out,m_shadingSamples);
+    if(m_shadingSamples.lightVolumes == 0){
+        out << "  (the light volumes are measured while deferred shading is on, 'D')\n";
+    }
+}
+
+// The feedback buffer only needs to be big enough to catch every page
+// that covers a few pixels
+void Renderer::SetVirtualTexture(VirtualTexture* virtualTexture){
+    m_virtualTexture = virtualTexture;
+    if(virtualTexture == nullptr){
+        m_feedback.Release();
+        return;
+    }
+    m_feedback.Create(m_screenWidth,m_screenHeight,kFeedbackScale);
+    virtualTexture->SetFeedbackScale(m_feedback.GetScale());
+}
+
+bool Renderer::UpdateVirtualTexture(){
+    if(m_virtualTexture == nullptr){
+        return false;
+    }
+    if(m_feedback.Poll(m_virtualTexture->GetHeader(),m_feedbackPages)){
+        m_virtualTexture->Request(m_feedbackPages);
+    }
+    return m_virtualTexture->Update();
+}
+
+bool Renderer::IsVirtualTextureBusy() const{
+    return m_virtualTexture != nullptr && (m_feedback.IsPending() || m_virtualTexture->IsStreaming());
+}
+
+// Every view gets a part of the screen and a layer of its own
+void Renderer::SetViewCount(unsigned int count){
+    count = std::max(1u,std::min(count,kMaxViews));
+    while(m_cameras.size() < count){
+        m_cameras.push_back(new Camera());
+    }
+    if(count == m_viewCount){
+        return;
+    }
+    m_viewCount = count;
+    // The layered framebuffer is the size of one view
+    while(m_framebuffers.size() > 1){
+        delete m_framebuffers.back();
+        m_framebuffers.pop_back();
+    }
+    if(count > 1){
+        glm::ivec4 viewport = SplitScreenViewport(0,count,m_screenWidth,m_screenHeight);
+        Framebuffer* layered = new Framebuffer();
+        layered->Create(viewport.z,viewport.w,count);
+        m_framebuffers.push_back(layered);
+    }
 }
 
 void Renderer::Update(){
@@ -39,41 +181,236 @@ void Renderer::Update(){
     // Then perspective
     // Then the near and far clipping plane.
     // Note I cannot see anything closer than 0.1f units from the screen.
-    m_projectionMatrix = glm::perspective(glm::radians(45.0f),((float)m_screenWidth)/((float)m_screenHeight),0.1f,512.0f);
+    // With several views, each one has the shape of its part of the screen.
+    glm::ivec4 viewport = SplitScreenViewport(0,m_viewCount,m_screenWidth,m_screenHeight);
+    m_projectionMatrix = glm::perspective(glm::radians(45.0f),((float)viewport.z)/((float)viewport.w),0.1f,512.0f);
+
+    // The materials set their samplers up when they are made, and the
+    // matrices are recorded with each draw, so there is nothing else to do
+}
 
-    // Perform the update
-    if(m_root!=nullptr){
-        // TODO: By default, we will only have one camera
-        //       You may otherwise not want to hardcode
-        //       a value of '0' here.
-        m_root->Update(m_projectionMatrix, m_cameras[0]);
+uint32_t Renderer::AddMesh(std::shared_ptr<Mesh> mesh){
+    m_meshes.push_back(mesh);
+    return static_cast<uint32_t>(m_meshes.size()-1);
+}
+
+uint32_t Renderer::AddMaterial(std::shared_ptr<Material> material){
+    m_materials.push_back(material);
+    return static_cast<uint32_t>(m_materials.size()-1);
+}
+
+// The bounds are the mesh's sphere; the world one follows in Render()
+Entity Renderer::AddRenderable(uint32_t mesh, uint32_t material, const glm::mat4& world, bool isStatic){
+    Entity entity = m_scene.Create(kRenderableComponents | (isStatic ? kStaticTag : 0));
+    *m_scene.GetTransform(entity) = world;
+    *m_scene.GetMesh(entity) = mesh;
+    *m_scene.GetMaterial(entity) = material;
+    *m_scene.GetBounds(entity) = m_meshes[mesh]->GetBoundingSphere();
+    return entity;
+}
+
+// Workers take a few draws each. The columns are read where they are:
+// the material and mesh indices, the transform and the level of detail.
+void Renderer::RecordVisible(const glm::mat4& view, const glm::mat4& projection, RenderPass pass,
+                             const std::function<void(CommandBuffer&)>& begin){
+    const size_t drawsPerJob = 64;
+    RecordCommands(m_workers, m_visible.size(), drawsPerJob, m_commandBuffers,
+        [&](size_t first, size_t end, CommandBuffer& commands){
+            if(begin){
+                begin(commands);
+            }
+            TransformBlock transforms;
+            transforms.view = view;
+            transforms.projection = projection;
+            for(size_t i = first; i < end; i++){
+                const Archetype& archetype = m_scene.GetArchetype(m_visible[i].archetype);
+                const uint32_t row = m_visible[i].row;
+                uint32_t mesh = archetype.GetMeshes()[row];
+                if(archetype.Has(kLodComponent)){
+                    mesh += archetype.GetLods()[row].level;
+                }
+                const uint32_t material = archetype.GetMaterials()[row];
+                if(mesh >= m_meshes.size() || material >= m_materials.size() ||
+                   !m_materials[material]->Record(commands, pass)){
+                    continue;
+                }
+                transforms.model = archetype.GetTransforms()[row];
+                commands.SetUniformBlock(kTransformsBinding,&transforms,sizeof(transforms));
+                m_meshes[mesh]->Record(commands);
+            }
+        });
+}
+
+// The near cascades are drawn every frame with whatever their frustum
+// holds. The cached ones only hold static nodes and are drawn when the
+// cache says they no longer cover the camera's view (see ShadowCascades.hpp).
+void Renderer::RenderShadows(){
+    glm::ivec4 viewport = SplitScreenViewport(0,m_viewCount,m_screenWidth,m_screenHeight);
+    unsigned int due = m_shadowCascades.Update(m_cameras[0]->GetWorldToViewmatrix(),glm::radians(45.0f),
+                                               ((float)viewport.z)/((float)viewport.w),0.1f,512.0f,
+                                               m_lightDirection);
+    if(due == 0){
+        return;
+    }
+    // Only depth, pushed back a little so surfaces do not shadow themselves
+    GLState& state = GLState::Instance();
+    state.Enable(GL_DEPTH_TEST);
+    state.Enable(GL_POLYGON_OFFSET_FILL);
+    state.PolygonMode(GL_FILL);
+    glPolygonOffset(2.0f,4.0f);
+    for(unsigned int cascade = 0; cascade < m_shadowCascades.GetCount(); cascade++){
+        if((due & (1u << cascade)) == 0){
+            continue;
+        }
+        const ShadowCascade& fit = m_shadowCascades.GetCascade(cascade);
+        const bool staticOnly = m_shadowCascades.IsCached(cascade);
+        MultiViewFrustum frustum(&fit.viewProjection, 1);
+        m_shadowMap.BindLayer(static_cast<int>(cascade));
+        glClear(GL_DEPTH_BUFFER_BIT);
+        m_visible.clear();
+        CullRenderables(m_scene, frustum, staticOnly ? kStaticTag : 0, m_visible);
+        RecordVisible(fit.view, fit.projection, RenderPass::Depth);
+        if(m_vertexPool != nullptr){
+            m_vertexPool->BindBuffers();
+        }
+        m_replayer.Replay(m_commandBuffers.data(), m_commandBuffers.size());
     }
+    state.Disable(GL_POLYGON_OFFSET_FILL);
+    m_shadowMap.Unbind();
+}
+
+// The same culling and drawing as the first camera's view, with the
+// feedback program of the materials that have one
+void Renderer::RenderFeedback(){
+    GLState& state = GLState::Instance();
+    m_feedback.Begin();
+    state.Enable(GL_DEPTH_TEST);
+    state.PolygonMode(GL_FILL);
+    glm::mat4 view = m_cameras[0]->GetWorldToViewmatrix();
+    glm::mat4 viewProjection = m_projectionMatrix * view;
+    MultiViewFrustum frustum(&viewProjection, 1);
+    m_visible.clear();
+    CullRenderables(m_scene, frustum, 0, m_visible);
+    RecordVisible(view, m_projectionMatrix, RenderPass::Feedback);
+    if(m_vertexPool != nullptr){
+        m_vertexPool->BindBuffers();
+    }
+    m_replayer.Replay(m_commandBuffers.data(), m_commandBuffers.size());
+    m_feedback.End();
+}
+
+// Each light adds itself to the pixels inside its volume (back faces
+// only, no depth test, so each pixel is lit once per light even with the
+// camera inside). Depth clamping keeps volumes reaching past the far plane
+// from being cut off there.
+void Renderer::RenderDeferredLighting(Framebuffer* target, const LightsBlock& lights, const ShadowBlock& shadows){
+    GLState& state = GLState::Instance();
+    m_lightBuffer->Bind();
+    state.ClearColor(0.0f,0.0f,0.0f,0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    state.Disable(GL_DEPTH_TEST);
+    state.Enable(GL_DEPTH_CLAMP);
+    state.Enable(GL_CULL_FACE);
+    state.CullFace(GL_FRONT);
+    state.Enable(GL_BLEND);
+    state.BlendFunc(GL_ONE,GL_ONE);
+    state.PolygonMode(GL_FILL);
+    CommandBuffer& commands = m_deferredCommands;
+    commands.Clear();
+    commands.BindProgram(m_lightVolumeShader->GetID());
+    commands.BindVertexArray(m_emptyVertexArray);
+    commands.BindTexture(kNormalUnit,m_gbuffer->GetColorTexture(1));
+    commands.BindTexture(kDepthUnit,m_gbuffer->GetDepthTexture());
+    commands.SetUniformBlock(kLightsBinding,&lights,sizeof(lights));
+    commands.SetInstances(lights.count.x);
+    commands.DrawArrays(GL_TRIANGLES,0,36);
+    m_lightSamples.Begin();
+    m_replayer.Replay(&commands,1);
+    m_lightSamples.End();
+    state.Disable(GL_BLEND);
+    state.CullFace(GL_BACK);
+    state.Disable(GL_CULL_FACE);
+    state.Disable(GL_DEPTH_CLAMP);
+
+    // Albedo times the lights (and the sun) where the scene was drawn
+    target->Bind();
+    state.ClearColor( 0.01f, 0.01f, 0.01f, 1.f );
+    glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+    commands.Clear();
+    commands.BindProgram(m_resolveShader->GetID());
+    commands.BindVertexArray(m_emptyVertexArray);
+    commands.BindTexture(kAlbedoUnit,m_gbuffer->GetColorTexture(0));
+    commands.BindTexture(kLightUnit,m_lightBuffer->GetColorTexture(0));
+    commands.SetUniformBlock(kLightsBinding,&lights,sizeof(lights));
+    commands.SetUniformBlock(kShadowsBinding,&shadows,sizeof(shadows));
+    commands.DrawArrays(GL_TRIANGLES,0,3);
+    state.BindTexture(kShadowMapUnit, GL_TEXTURE_2D_ARRAY, m_shadowMap.GetTexture());
+    m_replayer.Replay(&commands,1);
+    m_shadingSamples.screen = static_cast<uint64_t>(m_screenWidth)*m_screenHeight;
 }
 
 // Initialize clear color
 // Setup our OpenGL State machine
 // Then render the scene
 void Renderer::Render(){
+    // Results of earlier frames that the GPU has finished by now
+    float gpuMilliseconds;
+    if(m_gpuTimer.Poll(gpuMilliseconds)){
+        FrameStats::Instance().AddGpuTime(gpuMilliseconds);
+    }
+    uint64_t samples;
+    if(m_sceneSamples.Poll(samples)){
+        m_shadingSamples.geometry = samples;
+    }
+    if(m_lightSamples.Poll(samples)){
+        m_shadingSamples.lightVolumes = samples;
+    }
+    m_gpuTimer.Begin();
+
+    // Where everything is this frame, and how detailed it is from here
+    Camera* camera = m_cameras[0];
+    glm::vec3 eye(camera->GetEyeXPosition(),camera->GetEyeYPosition(),camera->GetEyeZPosition());
+    UpdateWorldBounds(m_scene);
+    SelectLods(m_scene, eye);
+
+    // The shadow maps come first, the scene reads them
+    if(m_shadowsEnabled){
+        RenderShadows();
+    }
+    if(m_virtualTexture != nullptr && m_feedback.IsCreated()){
+        RenderFeedback();
+    }
 
     // Setup our uniforms
     // In reality, only need to do this once for this
     // particular fbo because the texture data is 
     // not going to change.
     // NOTE:
-    //       Assume for this implementation we only have at most
-    //       One framebuffer
-    m_framebuffers[0]->Update();
+    //       Several views go into the layers of the second framebuffer
+    //       (see SetViewCount), one view into the first.
+    //       The deferred path draws the scene into the G-buffer first.
+    const bool multiView = m_viewCount > 1;
+    const bool deferred = m_deferred && !multiView;
+    Framebuffer* target = m_framebuffers[multiView ? 1 : 0];
+    target->Update();
     // Bind to our farmebuffer
-    m_framebuffers[0]->Bind();
+    if(deferred){
+        m_gbuffer->Bind();
+    }else{
+        target->Bind();
+    }
 
 
     // What we are doing, is telling opengl to create a depth(or Z-buffer) 
     // for us that is stored every frame.
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_TEXTURE_2D); 
+    // GLState skips the calls whose value did not change since last time.
+    GLState& state = GLState::Instance();
+    state.Enable(GL_DEPTH_TEST);
     // This is the background of the screen.
-    glViewport(0, 0, m_screenWidth, m_screenHeight);
-    glClearColor( 0.01f, 0.01f, 0.01f, 1.f );
+    // Every layer is the size of one view.
+    glm::ivec4 viewport = SplitScreenViewport(0,m_viewCount,m_screenWidth,m_screenHeight);
+    state.Viewport(0, 0, viewport.z, viewport.w);
+    state.ClearColor( 0.01f, 0.01f, 0.01f, 1.f );
     // Clear color buffer and Depth Buffer
     // Remember that the 'depth buffer' is our
     // z-buffer that figures out how far away items are every frame
@@ -92,42 +429,101 @@ void Renderer::Render(){
     const Uint8* currentKeyStates = SDL_GetKeyboardState( NULL );
     if( currentKeyStates[ SDL_SCANCODE_W ] )
     {
-        glPolygonMode(GL_FRONT_AND_BACK,GL_LINE);
+        state.PolygonMode(GL_LINE);
     }else{
-        glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
+        state.PolygonMode(GL_FILL);
     }
     
-    // Now we render our objects from our scenegraph
-    if(m_root!=nullptr){
-        m_root->Draw();
+    // The lights and the sun's shadows; the camera's light sits just in
+    // front of it
+    m_lights[0].position = eye + glm::vec3(camera->GetViewXDirection(),camera->GetViewYDirection(),
+                                           camera->GetViewZDirection());
+    glm::mat4 view = camera->GetWorldToViewmatrix();
+    LightsBlock lights = MakeLightsBlock(m_lights.data(), m_lights.size(), m_projectionMatrix * view, eye,
+                                         kLightCutoff, kMaxLightRange);
+    m_shadingSamples.lights = static_cast<uint64_t>(lights.count.x);
+    ShadowBlock shadows = m_shadowCascades.GetBlock(view);
+    if(!m_shadowsEnabled){
+        shadows.count.x = 0;
+    }
+
+    // Now we render what the scene holds. Worker threads record the
+    // commands of a few draws each (no OpenGL calls), then they are
+    // replayed here in scene order.
+    // With several views, each entity is culled once against all of them
+    // and drawn once, instanced per view.
+    {
+        glm::mat4 viewProjections[kMaxViews];
+        for(unsigned int i = 0; i < m_viewCount; i++){
+            viewProjections[i] = m_projectionMatrix * m_cameras[i]->GetWorldToViewmatrix();
+        }
+        MultiViewFrustum frustum(viewProjections, m_viewCount);
+        ViewsBlock views = MakeViewsBlock(viewProjections, m_viewCount);
+        RenderPass pass = multiView ? RenderPass::MultiView : RenderPass::Color;
+        if(deferred){
+            pass = RenderPass::GBuffer;
+        }
+        m_visible.clear();
+        CullRenderables(m_scene, frustum, 0, m_visible);
+        RecordVisible(view, m_projectionMatrix, pass,
+            [&](CommandBuffer& commands){
+                if(!deferred){
+                    commands.SetUniformBlock(kShadowsBinding, &shadows, sizeof(shadows));
+                    commands.SetUniformBlock(kLightsBinding, &lights, sizeof(lights));
+                }
+                if(multiView){
+                    commands.SetUniformBlock(kViewsBinding, &views, sizeof(views));
+                    commands.SetInstances(m_viewCount);
+                }
+            });
+        // The commands bind the pool's vertex array, not its buffers
+        if(m_vertexPool != nullptr){
+            m_vertexPool->BindBuffers();
+        }
+        state.BindTexture(kShadowMapUnit, GL_TEXTURE_2D_ARRAY, m_shadowMap.GetTexture());
+        m_sceneSamples.Begin();
+        m_replayer.Replay(m_commandBuffers.data(), m_commandBuffers.size());
+        m_sceneSamples.End();
+    }
+    if(deferred){
+        RenderDeferredLighting(target, lights, shadows);
     }
 
     // Finish with our framebuffer
-    m_framebuffers[0]->Unbind();
+    target->Unbind();
     // Now draw a new scene
     // We do not need depth since we are drawing a '2D'
     // image over our screen.
-    glDisable(GL_DEPTH_TEST);
+    state.Disable(GL_DEPTH_TEST);
     // Clear everything away
     // Clear the screen color, and typically I do this
     // to something 'different' than our original as an
     // indication that I am in a FBO. But you may choose
     // to match the glClearColor
-    glClearColor(1.0f,1.0f,1.0f,1.0f);
+    state.ClearColor(1.0f,1.0f,1.0f,1.0f);
     // We only have 'color' in our buffer that is stored
     glClear(GL_COLOR_BUFFER_BIT); 
     // Use our new 'simple screen shader'
-    m_framebuffers[0]->m_fboShader->Bind();
-    // Overlay our 'quad' over the screen
-    m_framebuffers[0]->DrawFBO();    
-    // Unselect our shader and continue
-    m_framebuffers[0]->m_fboShader->Unbind();
-}
+    target->m_fboShader->Bind();
+    // Overlay our 'quad' over the screen, or over each view's part of it
+    if(multiView){
+        for(unsigned int i = 0; i < m_viewCount; i++){
+            glm::ivec4 part = SplitScreenViewport(i,m_viewCount,m_screenWidth,m_screenHeight);
+            state.Viewport(part.x, part.y, part.z, part.w);
+            target->DrawFBO(static_cast<int>(i));
+        }
+        state.Viewport(0, 0, m_screenWidth, m_screenHeight);
+    }else{
+        target->DrawFBO();    
+    }
+    // The shader stays selected: GLState skips selecting it again if
+    // nothing else was selected by next frame.
+    m_gpuTimer.End();
 
-// Determines what the root is of the renderer, so the
-// scene can be drawn.
-void Renderer::setRoot(std::shared_ptr<SceneNode> startingNode){
-    m_root = startingNode;
+    // Last composite step: the performance overlay (not timed, so it does
+    // not show up in its own numbers)
+    m_perfHud.Draw(m_screenWidth,m_screenHeight);
 }
 
 
+
@@ -1,14 +1,144 @@
 #include "SDLGraphicsProgram.hpp"
 #include "Camera.hpp"
+#include "AssetArchive.hpp"
 #include "Terrain.hpp"
 // Include the 'Renderer.hpp' which deteremines what
 // the graphics API is going to be for OpenGL
 #include "Renderer.hpp"
+#include "ResourceTracker.hpp"
+#include "GLDebug.hpp"
+#include "GLState.hpp"
+#include "FrameStats.hpp"
+#include "VirtualTexture.hpp"
+#include "SceneFile.hpp"
 
+#include <cstdlib>
+#include <filesystem>
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <fstream>
+#include <vector>
+
+// The color map with the detail map repeated over it, as a page file
+// (see VirtualTexture.hpp). Cooked the first time it is needed.
+static const char* kVirtualTexturePath = "./assets/textures/terrain.vtex";
+
+static bool CookTerrainTexture(const std::string& colormap, const std::string& detailmap){
+    if(std::ifstream(kVirtualTexturePath).good()){
+        return true;
+    }
+    Image color(colormap);
+    color.LoadPPM(true);
+    Image detail(detailmap);
+    detail.LoadPPM(true);
+    if(color.GetPixelDataPtr() == nullptr || detail.GetPixelDataPtr() == nullptr){
+        return false;
+    }
+    std::cout << "Cooking " << kVirtualTexturePath << "\n";
+    std::vector<uint8_t> pixels;
+    ComposeDetailTexture(color.GetPixelDataPtr(),color.GetWidth(),color.GetHeight(),
+                         detail.GetPixelDataPtr(),detail.GetWidth(),detail.GetHeight(),
+                         32,4096,pixels);
+    std::string error;
+    if(!WriteVirtualTexture(kVirtualTexturePath,pixels.data(),4096,128,4,&error)){
+        std::cerr << "Virtual texture: " << error << "\n";
+        return false;
+    }
+    return true;
+}
+
+// The scene the program draws (see SceneFile.hpp). The text form is the
+// one to edit; it is cooked into the binary form whenever that is missing
+// or older, and the binary form is what is loaded.
+static const char* kScenePath = "./scenes/terrain.scene";
+static const char* kCookedScenePath = "./scenes/terrain.bscene";
+
+// ENGINE_SCENE, if it is set, is loaded as it is (either form)
+static bool LoadProgramScene(SceneDescription& scene, std::string& error){
+    const char* path = std::getenv("ENGINE_SCENE");
+    if(path != nullptr && path[0] != '\0'){
+        return LoadScene(path,scene,&error);
+    }
+    namespace fs = std::filesystem;
+    std::error_code cookedCode, textCode;
+    fs::file_time_type cooked = fs::last_write_time(kCookedScenePath,cookedCode);
+    fs::file_time_type text = fs::last_write_time(kScenePath,textCode);
+    if(!cookedCode && (textCode || cooked >= text) &&
+       LoadScene(kCookedScenePath,scene,&error)){
+        return true;
+    }
+    if(!LoadScene(kScenePath,scene,&error)){
+        return false;
+    }
+    std::string cookError;
+    if(!WriteSceneFile(kCookedScenePath,scene,&cookError)){
+        std::cerr << "Scene: " << cookError << "\n";
+    }
+    return true;
+}
+
+// Adds what a scene describes to the renderer: a renderable per terrain at
+// its world transform (groups only move their children), the lights and
+// the cameras. Terrains are drawn from 'pool' when it can take them, and
+// the first one with a detail map gets the virtual texture when
+// ENGINE_VIRTUAL_TEXTURE=on.
+static void BuildScene(const SceneDescription& scene, Renderer& renderer, GpuUploader* uploader,
+                       VertexPool* pool, VirtualTexture& virtualTexture){
+    // Nothing moves yet, so the world transforms are worked out once.
+    // Parents come first (see ValidateScene).
+    std::vector<glm::mat4> world(scene.nodes.size());
+    for(size_t i = 0; i < scene.nodes.size(); ++i){
+        const SceneNodeDesc& desc = scene.nodes[i];
+        world[i] = SceneNodeMatrix(desc);
+        if(desc.parent >= 0){
+            world[i] = world[desc.parent] * world[i];
+        }
+        if(desc.kind != SceneNodeKind::Terrain){
+            continue;
+        }
+        std::shared_ptr<Mesh> terrain = MakeTerrain(desc.segments[0],desc.segments[1],desc.mesh,
+                                                    Residency::GpuOnly,uploader,pool);
+        std::vector<std::string> defines;
+        std::string error;
+        if(VirtualTextureFromEnvironment() && !virtualTexture.IsCreated() &&
+           !desc.diffuse.empty() && !desc.detail.empty()){
+            if(CookTerrainTexture(desc.diffuse,desc.detail) &&
+               virtualTexture.Create(kVirtualTexturePath,16,&error)){
+                renderer.SetVirtualTexture(&virtualTexture);
+                defines.push_back("VIRTUAL_TEXTURE");
+                std::cout << "Virtual texture: on\n";
+            }else if(!error.empty()){
+                std::cerr << "Virtual texture: " << error << "\n";
+            }
+        }
+        std::string vertexShader = desc.vertexShader.empty() ? "./shaders/vert.glsl" : desc.vertexShader;
+        std::string fragmentShader = desc.fragmentShader.empty() ? "./shaders/frag.glsl" : desc.fragmentShader;
+        // Pulled meshes need the shader that reads them from the pool
+        if(terrain->IsPulled()){
+            vertexShader = "./shaders/vert_pull.glsl";
+        }
+        std::shared_ptr<Material> material = std::make_shared<Material>(vertexShader,fragmentShader,defines);
+        if(!defines.empty()){
+            material->SetVirtualTexture(&virtualTexture);
+        }else if(!desc.diffuse.empty() && !desc.detail.empty()){
+            material->LoadTextures(desc.diffuse,desc.detail,uploader);
+        }else if(!desc.diffuse.empty()){
+            material->LoadTexture(desc.diffuse,uploader);
+        }
+        renderer.AddRenderable(renderer.AddMesh(terrain),renderer.AddMaterial(material),world[i],desc.isStatic);
+    }
+    for(const PointLight& light : scene.lights){
+        renderer.AddLight(light);
+    }
+    // The first camera is the one the mouse and keys move
+    for(size_t i = 0; i < scene.cameras.size(); ++i){
+        Camera* camera = i == 0 ? renderer.GetCamera(0) : renderer.AddCamera();
+        const SceneCameraDesc& view = scene.cameras[i];
+        camera->SetCameraEyePosition(view.eye.x,view.eye.y,view.eye.z);
+        camera->SetCameraViewDirection(view.direction.x,view.direction.y,view.direction.z);
+    }
+}
 
 // Initialization function
 // Returns a true or false value based on successful completion of setup.
@@ -29,6 +159,11 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
     SDL_GL_SetAttribute( SDL_GL_CONTEXT_MAJOR_VERSION, 3 );
     SDL_GL_SetAttribute( SDL_GL_CONTEXT_MINOR_VERSION, 3 );
     SDL_GL_SetAttribute( SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE );
+#if ENGINE_GL_DEBUG
+    // Ask for a debug context so the driver reports errors and performance
+    // warnings through GLDebug (see GLDebug.hpp).
+    SDL_GL_SetAttribute( SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG );
+#endif
     // We want to request a double buffer for smooth updating.
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
     SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
@@ -59,17 +194,65 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h){
         std::cerr << "Failed to iniitalize GLAD\n";
         exit(EXIT_FAILURE);
     }
+    // Route driver messages to GLDebug (compiles to nothing in release)
+    GL_DEBUG_INSTALL(SDL_GL_GetProcAddress);
+
+    // A second context for the upload thread. Creating it makes it
+    // current, so switch back to ours afterwards.
+    SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+    m_uploadContext = SDL_GL_CreateContext( m_window );
+    SDL_GL_MakeCurrent(m_window, m_openGLContext);
+    if(m_uploadContext != NULL){
+        SharedContext shared;
+        SDL_Window* window = m_window;
+        SDL_GLContext context = m_uploadContext;
+        shared.makeCurrent = [window,context](){ return SDL_GL_MakeCurrent(window,context) == 0; };
+        shared.doneCurrent = [window](){ SDL_GL_MakeCurrent(window,NULL); };
+        m_uploader.Start(shared);
+    }
+    if(!m_uploader.IsThreaded()){
+        std::cerr << "Uploading on the render thread (no shared context): " << SDL_GetError() << "\n";
+    }
 
     // If initialization succeeds then print out a list of errors in the constructor.
     SDL_Log("SDLGraphicsProgram::SDLGraphicsProgram - No SDL, GLAD, or OpenGL errors detected during initialization\n\n");
 
 	// SDL_LogSetAllPriority(SDL_LOG_PRIORITY_WARN); // Uncomment to enable extra debug support!
 	GetOpenGLVersionInfo();
+
+    // Cooked assets (tools/AssetCook.cpp) unless ENGINE_ASSETS=off; the
+    // loose files otherwise
+    AssetArchive& archive = AssetArchive::Instance();
+    if(archive.MountFromEnvironment("./../../common/assets.pak","Assignment10_fbo/part1")){
+        std::cout << "Assets: " << archive.GetPath() << " (" << archive.GetEntryCount() << " entries)\n";
+    }else{
+        std::cout << "Assets: loose files (" << archive.GetError() << ")\n";
+    }
+
+    // Publish live metrics unless ENGINE_METRICS_SHM=off
+    std::string metricsName = MetricsName("a10_fbo");
+    if(!metricsName.empty()){
+        if(m_metrics.Open(metricsName)){
+            std::cout << "Publishing metrics to " << metricsName << " (read them with metrics_reader)\n";
+        }else{
+            std::cerr << "No live metrics: " << m_metrics.GetError() << "\n";
+        }
+    }
 }
 
 
 // Proper shutdown of SDL and destroy initialized objects
 SDLGraphicsProgram::~SDLGraphicsProgram(){
+    // Everything created in SetLoopCallback has been destroyed by now,
+    // so anything still alive in the tracker is a leak.
+    // Canceled uploads are deleted here, before the leak check
+    m_uploader.Stop();
+    ResourceTracker::Instance().ShutdownCheck(std::cerr);
+    // Destroy our OpenGL contexts
+    if(m_uploadContext != NULL){
+        SDL_GL_DeleteContext(m_uploadContext);
+    }
+    SDL_GL_DeleteContext(m_openGLContext);
     //Destroy window
 	SDL_DestroyWindow( m_window );
 	// Point m_window to NULL to ensure it points to nothing.
@@ -81,23 +264,41 @@ SDLGraphicsProgram::~SDLGraphicsProgram(){
 
 //Loops forever!
 void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
+    // Meshes drawn by vertex pulling (ENGINE_VERTEX_PULLING=on) live here.
+    // Declared first so it outlives everything drawing from it.
+    VertexPool vertexPool;
+    // The terrain's texture when ENGINE_VIRTUAL_TEXTURE=on, streamed in
+    // pages as the camera needs them. Also outlives the renderer.
+    VirtualTexture virtualTexture;
+    VertexPool* pool = nullptr;
+    if(VertexPullingFromEnvironment() && vertexPool.Create()){
+        pool = &vertexPool;
+        std::cout << "Vertex pulling: on\n";
+    }
+
+    // What to draw, with its lights and cameras
+    SceneDescription scene;
+    std::string sceneError;
+    if(!LoadProgramScene(scene,sceneError)){
+        std::cerr << "Scene: " << sceneError << "\n";
+        return;
+    }
+    // What the metrics report as the model: the first terrain's heightmap
+    std::string heightMap;
+    for(const SceneNodeDesc& node : scene.nodes){
+        if(node.kind == SceneNodeKind::Terrain){
+            heightMap = node.mesh;
+            break;
+        }
+    }
     
     // Create a renderer
     std::shared_ptr<Renderer> renderer = std::make_shared<Renderer>(m_width,m_height);    
+    renderer->SetVertexPool(pool);
 
-    // Create our terrain
-    std::shared_ptr<Terrain> myTerrain = std::make_shared<Terrain>(512,512,"./assets/textures/terrain2.ppm");
-    myTerrain->LoadTextures("./assets/textures/colormap.ppm","./assets/textures/detailmap.ppm");
-
-    // Create a node for our terrain 
-    std::shared_ptr<SceneNode> terrainNode;
-    terrainNode = std::make_shared<SceneNode>(myTerrain,"./shaders/vert.glsl","./shaders/frag.glsl");
+    // Fill the renderer's scene up
+    BuildScene(scene,*renderer,&m_uploader,pool,virtualTexture);
 
-    // Set our SceneTree up
-    renderer->setRoot(terrainNode);
-
-    // Set a default position for our camera
-    renderer->GetCamera(0)->SetCameraEyePosition(125.0f,50.0f,500.0f);
     // Main loop flag
     // If this is quit = 'true' then the program terminates.
     bool quit = false;
@@ -119,10 +320,26 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
 
     // While application is running
     while(!quit){
-        // For our terrain setup the identity transform each frame
-        // By default set the terrain node to the identity
-        // matrix.
-        terrainNode->GetLocalTransform().LoadIdentity();
+        // Nothing changed since the last frame: sleep until an event
+        // arrives (or the idle timeout passes) instead of drawing it again
+        if(!m_redraw.IsFrameDue()){
+            int timeout = m_redraw.GetWaitTimeout();
+            // Check on pending uploads and pages every few milliseconds
+            if((m_uploader.GetPending() > 0 || renderer->IsVirtualTextureBusy()) && timeout > 4){
+                timeout = 4;
+            }
+            SDL_WaitEventTimeout(NULL,timeout);
+        }
+        // Whatever finished uploading is drawn from this frame on
+        if(m_uploader.Poll() > 0){
+            m_redraw.MarkDirty();
+            renderer->InvalidateShadows();
+        }
+        // So are the pages of the virtual texture, and the feedback that
+        // came back asks for the next ones
+        if(renderer->UpdateVirtualTexture()){
+            m_redraw.MarkDirty();
+        }
         // Invoke(i.e. call) the callback function
         callback();
 
@@ -140,6 +357,45 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
                 int mouseY = e.motion.y;
                 renderer->GetCamera(0)->MouseLook(mouseX, mouseY);
             }
+            // Print a report of all GPU and CPU memory in use, and of
+            // the GL state calls issued and filtered so far
+            if(e.type==SDL_KEYDOWN && e.key.keysym.sym==SDLK_m){
+                ResourceTracker::Instance().DumpReport(std::cout);
+                GLState::Instance().PrintReport(std::cout);
+                renderer->PrintShadingReport(std::cout);
+                if(virtualTexture.IsCreated()){
+                    virtualTexture.PrintReport(std::cout);
+                }
+            }
+            // Show or hide the performance overlay
+            if(e.type==SDL_KEYDOWN && e.key.keysym.sym==SDLK_h){
+                renderer->GetPerfHud().Toggle();
+            }
+            // One, two or four views at once
+            if(e.type==SDL_KEYDOWN && e.key.keysym.sym==SDLK_v){
+                unsigned int views = renderer->GetViewCount();
+                renderer->SetViewCount(views == 1 ? 2 : (views == 2 ? 4 : 1));
+                std::cout << "Views: " << renderer->GetViewCount() << "\n";
+            }
+            // Sun shadows on or off
+            if(e.type==SDL_KEYDOWN && e.key.keysym.sym==SDLK_l){
+                renderer->SetShadowsEnabled(!renderer->GetShadowsEnabled());
+                std::cout << "Shadows: " << (renderer->GetShadowsEnabled() ? "on" : "off") << "\n";
+            }
+            // Forward or deferred shading
+            if(e.type==SDL_KEYDOWN && e.key.keysym.sym==SDLK_d){
+                renderer->SetDeferred(!renderer->GetDeferred());
+                std::cout << "Shading: " << (renderer->GetDeferred() ? "deferred" : "forward") << "\n";
+            }
+            // Switch between on-demand and continuous rendering
+            if(e.type==SDL_KEYDOWN && e.key.keysym.sym==SDLK_c){
+                m_redraw.ToggleMode();
+                std::cout << "Rendering: " << RedrawModeName(m_redraw.GetMode()) << "\n";
+            }
+            // Exposed, resized, restored, ...: the window needs its pixels again
+            if(e.type==SDL_WINDOWEVENT){
+                m_redraw.MarkDirty();
+            }
         } // End SDL_PollEvent loop.
 
         // Move left or right
@@ -162,22 +418,56 @@ void SDLGraphicsProgram::SetLoopCallback(std::function<void(void)> callback){
         }else if(keyboardState[SDL_SCANCODE_LCTRL] || keyboardState[SDL_SCANCODE_RCTRL]){
             renderer->GetCamera(0)->MoveDown(cameraSpeed);
         }
-		
-        // Update our scene through our renderer
-        renderer->Update();
-        // Render our scene using our selected renderer
-        renderer->Render();
-        // Delay to slow things down just a bit!
-        SDL_Delay(25);  // TODO: You can change this or implement a frame
-                        // independent movement method if you like.
-      	//Update screen of our specified window
-      	SDL_GL_SwapWindow(GetSDLWindow());
+
+        // Draw only if the camera, the overlay or the wireframe key changed
+        uint64_t state = HashValue(renderer->GetCamera(0)->GetWorldToViewmatrix());
+        state = HashValue(renderer->GetPerfHud().IsVisible(),state);
+        state = HashValue(renderer->GetViewCount(),state);
+        state = HashValue(renderer->GetShadowsEnabled(),state);
+        state = HashValue(renderer->GetDeferred(),state);
+        state = HashValue(keyboardState[SDL_SCANCODE_W] != 0,state);
+        m_redraw.Watch(state);
+        if(m_redraw.BeginFrame()){
+            // Update our scene through our renderer
+            renderer->Update();
+            // Render our scene using our selected renderer
+            renderer->Render();
+            // Delay to slow things down just a bit!
+            SDL_Delay(25);  // TODO: You can change this or implement a frame
+                            // independent movement method if you like.
+            //Update screen of our specified window
+            SDL_GL_SwapWindow(GetSDLWindow());
+            // Print this frame's error / performance message counts
+            GL_DEBUG_END_FRAME();
+            // Close this frame's draw call / state change counts
+            FrameStats::Instance().EndFrame();
+        }
+        // Share this frame's numbers with other processes (never blocks).
+        // Idle iterations publish too, so readers see the program is alive.
+        if(m_metrics.IsOpen()){
+            MetricsSnapshot snapshot{};
+            CollectMetrics(snapshot);
+            snapshot.cacheMode = -1;
+            SetMetricsText(snapshot.program,"a10_fbo");
+            SetMetricsText(snapshot.model,heightMap);
+            m_metrics.Publish(snapshot);
+        }
 	}
     //Disable text input
     SDL_StopTextInput();
 }
 
 
+// Draw every frame or only when something changed
+void SDLGraphicsProgram::SetRedrawMode(RedrawMode mode){
+    m_redraw.SetMode(mode);
+    std::cout << "Rendering: " << RedrawModeName(mode) << " (press c to switch)\n";
+}
+
+RedrawScheduler& SDLGraphicsProgram::GetRedrawScheduler(){
+    return m_redraw;
+}
+
 // Get Pointer to Window
 SDL_Window* SDLGraphicsProgram::GetSDLWindow(){
   return m_window;
@@ -1,4 +1,6 @@
 #include "Shader.hpp"
+#include "ResourceTracker.hpp"
+#include "GLState.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -9,18 +11,20 @@ Shader::Shader(){}
 // Destructor
 Shader::~Shader(){
 	// Deallocate Program
+	ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Program,m_shaderID);
 	glDeleteProgram(m_shaderID);
 }
 
 // Use our shader
 void Shader::Bind() const{
-	glUseProgram(m_shaderID);
+	// Skipped by GLState when it is already in use
+	GLState::Instance().UseProgram(m_shaderID);
 }
 
 
 // Turns off our shader
 void Shader::Unbind() const{
-	glUseProgram(0);
+	GLState::Instance().UseProgram(0);
 }
 
 void Shader::Log(const char* system, const char* message){
@@ -37,7 +41,7 @@ std::string Shader::LoadShader(const std::string& fname){
 		if(myFile.is_open()){
 			while(getline(myFile,line)){
 					result += line + '\n';
-					// SDL_Log(line); 	// Uncomment this if you want to see
+					// std::cout << line; 	// Uncomment this if you want to see
 										// the shader code get printed out.
 			}
 		}
@@ -51,15 +55,28 @@ std::string Shader::LoadShader(const std::string& fname){
 
 
 void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource){
+    // No geometry shader
+    CreateShader(vertexShaderSource,"",fragmentShaderSource);
+}
+
+void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& geometryShaderSource,
+                          const std::string& fragmentShaderSource){
 
     // Create a new program
     unsigned int program = glCreateProgram();
     // Compile our shaders
     unsigned int myVertexShader = CompileShader(GL_VERTEX_SHADER, vertexShaderSource);
+    unsigned int myGeometryShader = 0;
+    if(!geometryShaderSource.empty()){
+        myGeometryShader = CompileShader(GL_GEOMETRY_SHADER, geometryShaderSource);
+    }
     unsigned int myFragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
     // Link our program
     // These have been compiled already.
     glAttachShader(program,myVertexShader);
+    if(myGeometryShader != 0){
+        glAttachShader(program,myGeometryShader);
+    }
     glAttachShader(program,myFragmentShader);
     // Link our programs that have been 'attached'
     glLinkProgram(program);
@@ -71,12 +88,17 @@ void Shader::CreateShader(const std::string& vertexShaderSource, const std::stri
 
     glDeleteShader(myVertexShader);
     glDeleteShader(myFragmentShader);
+    if(myGeometryShader != 0){
+        glDetachShader(program,myGeometryShader);
+        glDeleteShader(myGeometryShader);
+    }
 
     if(!CheckLinkStatus(program)){
         Log("CreateShader","ERROR, shader did not link! Were there compile errors in the shader?");
     }
 
     m_shaderID = program;
+    ResourceTracker::Instance().TrackGpu(GpuResourceKind::Program,program,0,0,"Shader");
 }
 
 
@@ -87,6 +109,8 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
 
   if(type == GL_VERTEX_SHADER){
     id = glCreateShader(GL_VERTEX_SHADER);
+  }else if(type == GL_GEOMETRY_SHADER){
+    id = glCreateShader(GL_GEOMETRY_SHADER);
   }else if(type == GL_FRAGMENT_SHADER){
     id = glCreateShader(GL_FRAGMENT_SHADER);
   }
@@ -108,6 +132,9 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
       if(type == GL_VERTEX_SHADER){
 		Log("CompileShader ERROR", "GL_VERTEX_SHADER compilation failed!");
 		Log("CompileShader ERROR", (const char*)errorMessages);
+      }else if(type == GL_GEOMETRY_SHADER){
+        Log("CompileShader ERROR","GL_GEOMETRY_SHADER compilation failed!");
+		Log("CompileShader ERROR",(const char*)errorMessages);
       }else if(type == GL_FRAGMENT_SHADER){
         Log("CompileShader ERROR","GL_FRAGMENT_SHADER compilation failed!");
 		Log("CompileShader ERROR",(const char*)errorMessages);
@@ -134,8 +161,8 @@ bool Shader::CheckLinkStatus(GLuint programID){
       char* errorMessages = new char[length]; // Could also use alloca here.
       glGetProgramInfoLog(programID, length, &length, errorMessages);
       // Reclaim our memory
-      SDL_Log("ERROR in linking process\n");
-          SDL_Log("%s\n",errorMessages);
+      std::cout << "ERROR in linking process\n";
+          std::cout << errorMessages << "\n";
       delete[] errorMessages;
       return false;
     }
@@ -144,6 +171,21 @@ bool Shader::CheckLinkStatus(GLuint programID){
 }
 
 
+// The #version line has to stay first, so the define goes right after it
+std::string Shader::AddDefine(const std::string& source, const std::string& name){
+    std::string define = "#define " + name + "\n";
+    size_t version = source.find("#version");
+    if(version == std::string::npos){
+        return define + source;
+    }
+    size_t lineEnd = source.find('\n',version);
+    if(lineEnd == std::string::npos){
+        return source + "\n" + define;
+    }
+    return source.substr(0,lineEnd+1) + define + source.substr(lineEnd+1);
+}
+
+
 GLuint Shader::GetID() const{
     return m_shaderID;
 }
@@ -177,3 +219,12 @@ void Shader::SetUniform1f(const GLchar* name, float value){
     GLint location = glGetUniformLocation(m_shaderID,name);
     glUniform1f(location, value);
 }
+
+// Uniform blocks are not set with values: the program reads them from
+// whatever buffer range is bound to 'binding' when it draws.
+void Shader::SetUniformBlockBinding(const GLchar* name, GLuint binding){
+    GLuint index = glGetUniformBlockIndex(m_shaderID,name);
+    if(index != GL_INVALID_INDEX){
+        glUniformBlockBinding(m_shaderID, index, binding);
+    }
+}
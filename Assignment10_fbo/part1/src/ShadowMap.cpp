@@ -0,0 +1,73 @@
+#include "ShadowMap.hpp"
+#include "ResourceTracker.hpp"
+#include "GLState.hpp"
+
+#include <iostream>
+
+ShadowMap::ShadowMap(){
+}
+
+ShadowMap::~ShadowMap(){
+    Release();
+}
+
+// A depth only framebuffer per layer: no color attachment to draw to
+void ShadowMap::Create(int resolution, int layers){
+    Release();
+    m_resolution = resolution;
+    GLState& state = GLState::Instance();
+    glGenTextures(1, &m_texture);
+    state.BindTexture(0, GL_TEXTURE_2D_ARRAY, m_texture);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, resolution, resolution, layers, 0,
+                 GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    // Filtered comparisons give 2x2 percentage closer filtering for free
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+
+    ResourceTracker& tracker = ResourceTracker::Instance();
+    tracker.TrackGpu(GpuResourceKind::Texture,m_texture,
+                     layers*ResourceTracker::TextureBytes(resolution,resolution,4,false),
+                     GL_DEPTH_COMPONENT24,"ShadowMap");
+    m_framebuffers.resize(layers);
+    glGenFramebuffers(layers, m_framebuffers.data());
+    for(int i=0; i < layers; ++i){
+        state.BindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[i]);
+        glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0, i);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+            std::cerr << "Shadow map layer " << i << " is not complete\n";
+        }
+        tracker.TrackGpu(GpuResourceKind::Framebuffer,m_framebuffers[i],0,0,"ShadowMap");
+    }
+    Unbind();
+}
+
+void ShadowMap::Release(){
+    if(!IsCreated()){
+        return;
+    }
+    ResourceTracker& tracker = ResourceTracker::Instance();
+    for(GLuint framebuffer : m_framebuffers){
+        tracker.UntrackGpu(GpuResourceKind::Framebuffer,framebuffer);
+    }
+    tracker.UntrackGpu(GpuResourceKind::Texture,m_texture);
+    glDeleteFramebuffers(static_cast<GLsizei>(m_framebuffers.size()), m_framebuffers.data());
+    glDeleteTextures(1,&m_texture);
+    m_framebuffers.clear();
+    m_texture = 0;
+}
+
+void ShadowMap::BindLayer(int layer){
+    GLState& state = GLState::Instance();
+    state.BindFramebuffer(GL_FRAMEBUFFER, m_framebuffers[layer]);
+    state.Viewport(0, 0, m_resolution, m_resolution);
+}
+
+void ShadowMap::Unbind(){
+    GLState::Instance().BindFramebuffer(GL_FRAMEBUFFER,0);
+}
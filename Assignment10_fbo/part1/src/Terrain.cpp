@@ -2,12 +2,13 @@
 #include "Image.hpp"
 
 #include <iostream>
+#include <vector>
 
-// Constructor for our object
-// Calls the initialization method
-Terrain::Terrain(unsigned int xSegs, unsigned int zSegs, std::string fileName) : 
-                m_xSegments(xSegs), m_zSegments(zSegs) {
-    std::cout << "(Terrain.cpp) Constructor called \n";
+// Loads the heightmap and builds the grid from it
+std::shared_ptr<Mesh> MakeTerrain(unsigned int xSegs, unsigned int zSegs, std::string fileName,
+                                  Residency residency, GpuUploader* uploader, VertexPool* pool){
+    std::cout << "(Terrain.cpp) MakeTerrain called \n";
+    std::shared_ptr<Mesh> terrain = std::make_shared<Mesh>(residency,uploader,pool);
 
     // Load up some image data
     Image heightMap(fileName);
@@ -19,85 +20,57 @@ Terrain::Terrain(unsigned int xSegs, unsigned int zSegs, std::string fileName) :
     float scale = 5.0f; // Note that this scales down the values to make
                         // the image a bit more flat.
     // Create height data
-    m_heightData = new int[m_xSegments*m_zSegments];
     // Set the height data equal to the grayscale value of the heightmap
     // Because the R,G,B will all be equal in a grayscale image, then
     // we just grab one of the color components.
-
-    // TODO: (Inclass) Implement populate heightData!
-    for(unsigned int z=0; z < m_zSegments; ++z){
-        for(unsigned int x=0; x < m_xSegments; ++x){
-            m_heightData[x+z*m_xSegments] = (float)heightMap.GetPixelR(z,x)/scale;
+    // The heights are baked into the vertex positions, so they are only
+    // needed until the grid is built.
+    std::vector<int> heightData(xSegs*zSegs);
+    for(unsigned int z=0; z < zSegs; ++z){
+        for(unsigned int x=0; x < xSegs; ++x){
+            heightData[x+z*xSegs] = (float)heightMap.GetPixelR(z,x)/scale;
         }
     }
 
     // Initialize the terrain
-    Init();
-}
-
-// Destructor
-Terrain::~Terrain(){
-    // Delete our allocatted higheithmap data
-    if(m_heightData!=nullptr){
-        delete m_heightData;
-    }
+    MakeTerrainGeometry(xSegs,zSegs,heightData.data(),terrain->GetGeometry());
+    // Create a buffer and set the stride of information
+    terrain->Create();
+    return terrain;
 }
 
-
 // Creates a grid of segments
 // This article has a pretty handy illustration here:
 // http://www.learnopengles.com/wordpress/wp-content/uploads/2012/05/vbo.png
 // of what we are trying to do.
-void Terrain::Init(){
+void MakeTerrainGeometry(unsigned int xSegs, unsigned int zSegs, const int* heights,
+                         Geometry& geometry){
     // Create the initial grid of vertices.
-
-    // TODO: (Inclass) Build grid of vertices! 
-    for(unsigned int z=0; z < m_zSegments; ++z){
-        for(unsigned int x =0; x < m_xSegments; ++x){
-            float u = 1.0f - ((float)x/(float)m_xSegments);
-            float v = 1.0f - ((float)z/(float)m_zSegments);
+    for(unsigned int z=0; z < zSegs; ++z){
+        for(unsigned int x =0; x < xSegs; ++x){
+            float u = 1.0f - ((float)x/(float)xSegs);
+            float v = 1.0f - ((float)z/(float)zSegs);
             // Calculate the correct position and add the texture coordinates
-            m_geometry.AddVertex(x,m_heightData[x+z*m_xSegments],z,u,v);
+            geometry.AddVertex(x,heights[x+z*xSegs],z,u,v);
         }
     }
     
     // Figure out which indices make up each triangle
     // By writing out a few of the indices you can figure out
     // the pattern here. Note there is an offset.
-    
-    // TODO: (Inclass) Build triangle strip
-    for(unsigned int z=0; z < m_zSegments-1; ++z){
-        for(unsigned int x =0; x < m_xSegments-1; ++x){
-            m_geometry.AddIndex(x+(z*m_zSegments));
-            m_geometry.AddIndex(x+(z*m_zSegments)+m_xSegments);
-            m_geometry.AddIndex(x+(z*m_zSegments+1));
-
-            m_geometry.AddIndex(x+(z*m_zSegments)+1);
-            m_geometry.AddIndex(x+(z*m_zSegments)+m_xSegments);
-            m_geometry.AddIndex(x+(z*m_zSegments)+m_xSegments+1);
+    for(unsigned int z=0; z < zSegs-1; ++z){
+        for(unsigned int x =0; x < xSegs-1; ++x){
+            geometry.AddIndex(x+(z*zSegs));
+            geometry.AddIndex(x+(z*zSegs)+xSegs);
+            geometry.AddIndex(x+(z*zSegs+1));
+
+            geometry.AddIndex(x+(z*zSegs)+1);
+            geometry.AddIndex(x+(z*zSegs)+xSegs);
+            geometry.AddIndex(x+(z*zSegs)+xSegs+1);
         }
     }
 
-
    // Finally generate a simple 'array of bytes' that contains
    // everything for our buffer to work with.
-   m_geometry.Gen();  
-   // Create a buffer and set the stride of information
-   m_vertexBufferLayout.CreateNormalBufferLayout(m_geometry.GetBufferDataSize(),
-                                        m_geometry.GetIndicesSize(),
-                                        m_geometry.GetBufferDataPtr(),
-                                        m_geometry.GetIndicesDataPtr());
-}
-
-
-
-// Loads an image and uses it to set the heights of the terrain.
-void Terrain::LoadHeightMap(Image image){
-
-}
-
-void Terrain::LoadTextures(std::string colormap, std::string detailmap){ 
-        // Load our actual textures
-        m_textureDiffuse.LoadTexture(colormap); // Found in object
-        m_detailMap.LoadTexture(detailmap);     // Found in object
+   geometry.Gen();  
 }
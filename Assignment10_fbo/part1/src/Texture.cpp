@@ -1,11 +1,8 @@
-#if defined(LINUX) || defined(MINGW)
-    #include <SDL2/SDL.h>
-#else // This works for Mac
-    #include <SDL.h>
-#endif
-
-
 #include "Texture.hpp"
+#include "AssetArchive.hpp"
+#include "AsyncFileIO.hpp"
+#include "ResourceTracker.hpp"
+#include "GLState.hpp"
 
 #include <stdio.h>
 #include <string.h>
@@ -23,7 +20,12 @@ Texture::Texture(){
 
 // Default Destructor
 Texture::~Texture(){
+	// A texture that is still uploading is deleted by the uploader
+	if(m_uploadTicket != 0){
+		m_uploader->Cancel(m_uploadTicket);
+	}
 	// Delete our texture from the GPU
+	ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Texture,m_textureID);
 	glDeleteTextures(1,&m_textureID);
 
     // Delete our image
@@ -33,21 +35,97 @@ Texture::~Texture(){
 
 }
 
-void Texture::LoadTexture(const std::string filepath){
-	// Set member variable
-    m_filepath = filepath;
+void Texture::LoadTexture(const std::string filepath, Residency residency, GpuUploader* uploader){
     // Load our actual image data
     // This method loads .ppm files of pixel data
-    m_image = new Image(filepath);
-    m_image->LoadPPM(true);
+    Image* image = new Image(filepath);
+    image->LoadPPM(true);
+    LoadTexture(filepath,image,residency,uploader);
+}
+
+void Texture::LoadTextures(const std::vector<std::pair<Texture*,std::string>>& textures,
+                           Residency residency, GpuUploader* uploader){
+    // Files in the archive are loaded in place below; the others are read
+    // all at once and parsed on the reader's workers
+    AsyncFileReader& reader = AsyncFileReader::Instance();
+    std::vector<Image*> images(textures.size(),nullptr);
+    std::vector<char> parsed(textures.size(),0);
+    for(size_t i=0; i < textures.size(); i++){
+        const std::string& path = textures[i].second;
+        if(AssetArchive::Instance().Find(path).kind == AssetKind::Texture){
+            continue;
+        }
+        images[i] = new Image(path);
+        Image* image = images[i];
+        char* ok = &parsed[i];
+        reader.Read(path,[image,ok](FileReadResult& result){
+            *ok = result.ok && image->LoadPPM(result.data.data(),result.data.size(),true);
+        });
+    }
+    reader.Wait();
+    for(size_t i=0; i < textures.size(); i++){
+        if(parsed[i]){
+            textures[i].first->LoadTexture(textures[i].second,images[i],residency,uploader);
+        }else{
+            // The archive's copy, or the old way (which reports the problem)
+            delete images[i];
+            textures[i].first->LoadTexture(textures[i].second,residency,uploader);
+        }
+    }
+}
+
+void Texture::LoadTexture(const std::string filepath, Image* image, Residency residency, GpuUploader* uploader){
+	// Release any texture we loaded (or are loading) previously
+	if(m_uploadTicket != 0){
+		m_uploader->Cancel(m_uploadTicket);
+		m_uploadTicket = 0;
+	}
+	ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Texture,m_textureID);
+	glDeleteTextures(1,&m_textureID);
+	m_textureID = 0;
+	delete m_image;
+	// Set member variable
+    m_filepath = filepath;
+    m_image = image;
+
+    // The upload thread makes the same texture (and its mip chain) from a
+    // copy of the pixels, so the frame does not wait for it.
+    // Pixels in the mounted archive are read from there, without a copy.
+    if(uploader != nullptr){
+        TextureUpload upload;
+        upload.width = m_image->GetWidth();
+        upload.height = m_image->GetHeight();
+        const uint8_t* pixels = m_image->GetPixelDataPtr();
+        size_t pixelBytes = size_t(upload.width)*upload.height*3;
+        if(m_image->IsArchiveView()){
+            upload.external = pixels;
+            upload.externalBytes = pixelBytes;
+        }
+        else{
+            upload.pixels.assign(pixels, pixels+pixelBytes);
+        }
+        size_t bytes = ResourceTracker::TextureBytes(upload.width,upload.height,3,true);
+        m_uploader = uploader;
+        m_uploadTicket = uploader->UploadTexture(std::move(upload),
+            [this,filepath,bytes](const UploadResult& result){
+                m_uploadTicket = 0;
+                m_textureID = result.texture;
+                ResourceTracker::Instance().TrackGpu(GpuResourceKind::Texture,m_textureID,
+                                    bytes,GL_RGB8,"Texture:"+filepath);
+            });
+        if(residency != Residency::CpuAndGpu){
+            delete m_image;
+            m_image = nullptr;
+        }
+        return;
+    }
 
-    glEnable(GL_TEXTURE_2D); 
 	// Generate a buffer for our texture
     glGenTextures(1,&m_textureID);
     // Similar to our vertex buffers, we now 'select'
     // a texture we want to bind to.
     // Note the type of data is 'GL_TEXTURE_2D'
-    glBindTexture(GL_TEXTURE_2D, m_textureID);
+    GLState::Instance().BindTexture(0, GL_TEXTURE_2D, m_textureID);
 	// Now we are going to setup some information about
 	// our textures.
 	// There are four parameters that must be set.
@@ -71,8 +149,16 @@ void Texture::LoadTexture(const std::string filepath){
     // We are done with our texture data so we can unbind.
     // Generate a mipmap
     glGenerateMipmap(GL_TEXTURE_2D);                        
-	// We are done with our texture data so we can unbind.    
-	glBindTexture(GL_TEXTURE_2D, 0);
+    // Record the texture (and its mip chain) with the tracker
+    ResourceTracker::Instance().TrackGpu(GpuResourceKind::Texture,m_textureID,
+                        ResourceTracker::TextureBytes(m_image->GetWidth(),m_image->GetHeight(),3,true),
+                        GL_RGB8,"Texture:"+filepath);
+
+    // The pixels now live on the GPU
+    if(residency != Residency::CpuAndGpu){
+        delete m_image;
+        m_image = nullptr;
+    }
 }
 
 
@@ -85,13 +171,12 @@ void Texture::Bind(unsigned int slot) const{
 	// be multiple at once.
 	// At the time of writing, OpenGL supports 8-32 depending
 	// on your hardware.
-    glEnable(GL_TEXTURE_2D);
-	glActiveTexture(GL_TEXTURE0+slot);
-	glBindTexture(GL_TEXTURE_2D, m_textureID);
+	// GLState skips both calls when the texture is already there.
+	GLState::Instance().BindTexture(slot, GL_TEXTURE_2D, m_textureID);
 }
 
-void Texture::Unbind(){
-	glBindTexture(GL_TEXTURE_2D, 0);
+void Texture::Unbind(unsigned int slot){
+	GLState::Instance().BindTexture(slot, GL_TEXTURE_2D, 0);
 }
 
 
@@ -1,4 +1,6 @@
 #include "VertexBufferLayout.hpp"
+#include "ResourceTracker.hpp"
+#include "GLState.hpp"
 #include <iostream>
 
 
@@ -6,31 +8,39 @@ VertexBufferLayout::VertexBufferLayout(){
 }
 
 VertexBufferLayout::~VertexBufferLayout(){
+    // Buffers that are still uploading are deleted by the uploader
+    if(m_uploadTicket != 0){
+        m_uploader->Cancel(m_uploadTicket);
+    }
     // Delete our buffers that we have previously allocated
     // http://docs.gl/gl3/glDeleteBuffers
+    ResourceTracker& tracker = ResourceTracker::Instance();
+    tracker.UntrackGpu(GpuResourceKind::Buffer,m_vertexPositionBuffer);
+    tracker.UntrackGpu(GpuResourceKind::Buffer,m_indexBufferObject);
+    tracker.UntrackGpu(GpuResourceKind::VertexArray,m_VAOId);
     glDeleteBuffers(1,&m_vertexPositionBuffer);
     glDeleteBuffers(1,&m_indexBufferObject);
+    glDeleteVertexArrays(1,&m_VAOId);
 }
 
 
 void VertexBufferLayout::Bind(){
-    // Bind to our vertex array
-    glBindVertexArray(m_VAOId);
+    // Bind to our vertex array. The elements we are drawing are part of
+    // it, so they do not need a bind of their own.
+    GLState& state = GLState::Instance();
+    state.BindVertexArray(m_VAOId);
     // Bind to our vertex information
-    glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
-    // Bind to the elements we are drawing
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+    state.BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
 }
 
 // Note: Calling Unbind is rarely done, if you need
 // to draw something else then just bind to new buffer.
 void VertexBufferLayout::Unbind(){
-        // Bind to our vertex array
-        glBindVertexArray(0);
+        // Bind to our vertex array (the elements go with it)
+        GLState& state = GLState::Instance();
+        state.BindVertexArray(0);
         // Bind to our vertex information
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        // Bind to the elements we are drawing
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        state.BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 
@@ -44,7 +54,7 @@ void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount,unsigned
         // VertexArrays
         glGenVertexArrays(1, &m_VAOId);
 
-        glBindVertexArray(m_VAOId);
+        GLState::Instance().BindVertexArray(m_VAOId);
 
         // Vertex Buffer Object (VBO)
         // Create a buffer (note we’ll see this pattern of code often in OpenGL)
@@ -55,7 +65,7 @@ void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount,unsigned
                                                 // use our selected(or binded)
                                                 //  buffer with the arguments passed 
                                                 // into the function.
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
         glBufferData(GL_ARRAY_BUFFER, vcount*sizeof(float), vdata, GL_STATIC_DRAW);
 
         glEnableVertexAttribArray(0);
@@ -98,6 +108,8 @@ void VertexBufferLayout::CreatePositionBufferLayout(unsigned int vcount,unsigned
         glGenBuffers(1, &m_indexBufferObject);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
+
+        TrackBuffers(vcount,icount);
     }
 
 
@@ -111,7 +123,7 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned
         // VertexArrays
         glGenVertexArrays(1, &m_VAOId);
 
-        glBindVertexArray(m_VAOId);
+        GLState::Instance().BindVertexArray(m_VAOId);
 
         // Vertex VertexBufferLayout Object (VBO)
         // Create a buffer (note we’ll see this pattern of code often in OpenGL)
@@ -122,7 +134,7 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned
                                                 // use our selected(or binded)
                                                 //  buffer with the arguments passed 
                                                 // into the function.
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
         glBufferData(GL_ARRAY_BUFFER, vcount*sizeof(float), vdata, GL_STATIC_DRAW);
 
         glEnableVertexAttribArray(0);
@@ -174,6 +186,8 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned
         glGenBuffers(1, &m_indexBufferObject);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
+
+        TrackBuffers(vcount,icount);
     }
 
 
@@ -184,16 +198,41 @@ void VertexBufferLayout::CreateTextureBufferLayout(unsigned int vcount,unsigned
 // texcoords: s,t
 // tangent: t_x,t_y,t_z
 // bitangent b_x,b_y,b_z
-void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata ){
+void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata,
+                                                  GpuUploader* uploader ){
 		m_stride = 14;
         
         
         static_assert(sizeof(GLfloat)==sizeof(float), "GLFloat and gloat are not the same size on this architecture");
+
+        // Let the upload thread make (and fill) both buffers. Vertex arrays
+        // cannot be shared between contexts, so ours is made when they arrive.
+        if(uploader != nullptr){
+            std::vector<BufferUpload> uploads(2);
+            uploads[0].data.assign(reinterpret_cast<uint8_t*>(vdata),
+                                   reinterpret_cast<uint8_t*>(vdata+vcount));
+            uploads[1].data.assign(reinterpret_cast<uint8_t*>(idata),
+                                   reinterpret_cast<uint8_t*>(idata+icount));
+            m_uploader = uploader;
+            m_uploadTicket = uploader->UploadBuffers(std::move(uploads),
+                [this,vcount,icount](const UploadResult& result){
+                    m_uploadTicket = 0;
+                    m_vertexPositionBuffer = result.buffers[0];
+                    m_indexBufferObject = result.buffers[1];
+                    glGenVertexArrays(1, &m_VAOId);
+                    GLState::Instance().BindVertexArray(m_VAOId);
+                    GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+                    SetNormalAttributes();
+                    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+                    TrackBuffers(vcount,icount);
+                });
+            return;
+        }
        
         // VertexArrays
         glGenVertexArrays(1, &m_VAOId);
 
-        glBindVertexArray(m_VAOId);
+        GLState::Instance().BindVertexArray(m_VAOId);
 
         // Vertex Buffer Object (VBO)
         // Create a buffer (note we’ll see this pattern of code often in OpenGL)
@@ -204,9 +243,28 @@ void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount,unsigned i
                                                 // use our selected(or binded)
                                                 //  buffer with the arguments passed 
                                                 // into the function.
-        glBindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
+        GLState::Instance().BindBuffer(GL_ARRAY_BUFFER, m_vertexPositionBuffer);
         glBufferData(GL_ARRAY_BUFFER, vcount*sizeof(float), vdata, GL_STATIC_DRAW);
 
+        SetNormalAttributes();
+
+		// Another Vertex Buffer Object (VBO)
+        // This time for your index buffer.
+        // TODO: put these static_asserts somewhere
+        static_assert(sizeof(unsigned int)==sizeof(GLuint),"Gluint not same size!");
+
+		// Setup an index buffer
+        glGenBuffers(1, &m_indexBufferObject);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
+
+        TrackBuffers(vcount,icount);
+    }
+
+
+// Positions, normals, texture coordinates, tangents and bi-tangents of
+// the bound vertex buffer (m_stride floats per vertex)
+void VertexBufferLayout::SetNormalAttributes(){
         glEnableVertexAttribArray(0);
         // Finally pass in our vertex data
         glVertexAttribPointer(  0,   // Attribute 0, which will match layout in shader
@@ -254,14 +312,17 @@ void VertexBufferLayout::CreateNormalBufferLayout(unsigned int vcount,unsigned i
         // Add three floats for bi-tangent coordinates
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4,3,GL_FLOAT, GL_FALSE,sizeof(float)*m_stride,(char*)(sizeof(float)*11));
-        
-		// Another Vertex Buffer Object (VBO)
-        // This time for your index buffer.
-        // TODO: put these static_asserts somewhere
-        static_assert(sizeof(unsigned int)==sizeof(GLuint),"Gluint not same size!");
+}
 
-		// Setup an index buffer
-        glGenBuffers(1, &m_indexBufferObject);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount*sizeof(unsigned int), idata,GL_STATIC_DRAW);
-    }
+
+// vcount and icount are the number of floats and indices that were
+// uploaded, which is exactly what ends up in GPU memory.
+void VertexBufferLayout::TrackBuffers(unsigned int vcount, unsigned int icount){
+    m_indexCount = icount;
+    ResourceTracker& tracker = ResourceTracker::Instance();
+    tracker.TrackGpu(GpuResourceKind::VertexArray,m_VAOId,0,0,"VertexBufferLayout");
+    tracker.TrackGpu(GpuResourceKind::Buffer,m_vertexPositionBuffer,vcount*sizeof(float),
+                     GL_ARRAY_BUFFER,"VertexBufferLayout");
+    tracker.TrackGpu(GpuResourceKind::Buffer,m_indexBufferObject,icount*sizeof(unsigned int),
+                     GL_ELEMENT_ARRAY_BUFFER,"VertexBufferLayout");
+}
@@ -21,6 +21,9 @@ int main(int argc, char** argv){
 
 	// Create an instance of an object for a SDLGraphicsProgram
 	SDLGraphicsProgram mySDLGraphicsProgram(1280,720);
+	// Only draw when something changes, unless benchmarking
+	// (--continuous or ENGINE_REDRAW=continuous)
+	mySDLGraphicsProgram.SetRedrawMode(RedrawModeFromArgs(argc,argv));
 	// Run our program forever
 	mySDLGraphicsProgram.SetLoopCallback(loop);
 	// When our program ends, it will exit scope, the
@@ -0,0 +1,237 @@
+// Headless benchmark of part1: loads every model, then renders a fixed
+// number of frames offscreen with each cache mode (original, Forsyth,
+// random, Morton, Hilbert and adversarial triangle order) and prints the
+// simulated ACMR of each next to the frame time. Needs no window, so it runs
+// on build machines, and it is the workload tools/pgo.py trains the
+// optimized build with.
+//
+//   headless_bench [--frames N] [--size WxH] [--modes 123456]
+//                  [--forsyth PRESET] [model.obj ...]
+
+// Third Party Libraries
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// C++ Standard Template Library (STL)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Our libraries
+#include "Camera.hpp"
+#include "ForsythTuner.hpp"
+#include "GLState.hpp"
+#include "HeadlessContext.hpp"
+#include "OBJModel.hpp"
+#include "ResourceTracker.hpp"
+
+static std::string LoadFile(const std::string &filename) {
+  std::ifstream file(filename);
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  return buffer.str();
+}
+
+static GLuint CompileShader(GLenum type, const std::string &source) {
+  GLuint shader = glCreateShader(type);
+  const char *src = source.c_str();
+  glShaderSource(shader, 1, &src, nullptr);
+  glCompileShader(shader);
+  GLint result = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &result);
+  if (result == GL_FALSE) {
+    char log[1024];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    std::cerr << "Shader compilation failed:\n" << log << std::endl;
+  }
+  return shader;
+}
+
+// part1's own shaders, so the benchmark draws exactly what the program does
+static GLuint CreateProgram(const std::string &shaderDir) {
+  GLuint vertex = CompileShader(GL_VERTEX_SHADER,
+                                LoadFile(shaderDir + "/vert.glsl"));
+  GLuint fragment = CompileShader(GL_FRAGMENT_SHADER,
+                                  LoadFile(shaderDir + "/frag.glsl"));
+  GLuint program = glCreateProgram();
+  glAttachShader(program, vertex);
+  glAttachShader(program, fragment);
+  glLinkProgram(program);
+  glDetachShader(program, vertex);
+  glDetachShader(program, fragment);
+  glDeleteShader(vertex);
+  glDeleteShader(fragment);
+  ResourceTracker::Instance().TrackGpu(GpuResourceKind::Program, program, 0,
+                                       0, "HeadlessBench");
+  return program;
+}
+
+// Offscreen color + depth target standing in for the window
+struct RenderTarget {
+  GLuint fbo{0};
+  GLuint renderbuffers[2]{0, 0};
+
+  bool Create(int width, int height) {
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(2, renderbuffers);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width,
+                          height);
+    GLState::Instance().BindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                              GL_RENDERBUFFER, renderbuffers[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                              GL_RENDERBUFFER, renderbuffers[1]);
+    ResourceTracker &tracker = ResourceTracker::Instance();
+    tracker.TrackGpu(GpuResourceKind::Framebuffer, fbo, 0, 0, "HeadlessBench");
+    tracker.TrackGpu(GpuResourceKind::Renderbuffer, renderbuffers[0],
+                     static_cast<size_t>(width) * height * 4, GL_RGBA8,
+                     "HeadlessBench");
+    tracker.TrackGpu(GpuResourceKind::Renderbuffer, renderbuffers[1],
+                     static_cast<size_t>(width) * height * 4,
+                     GL_DEPTH_COMPONENT24, "HeadlessBench");
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  }
+
+  void Destroy() {
+    ResourceTracker &tracker = ResourceTracker::Instance();
+    tracker.UntrackGpu(GpuResourceKind::Framebuffer, fbo);
+    tracker.UntrackGpu(GpuResourceKind::Renderbuffer, renderbuffers[0]);
+    tracker.UntrackGpu(GpuResourceKind::Renderbuffer, renderbuffers[1]);
+    GLState::Instance().BindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(2, renderbuffers);
+    fbo = renderbuffers[0] = renderbuffers[1] = 0;
+  }
+};
+
+// Same state and uniforms as PreDraw() in part1/src/main.cpp
+static void SetupFrame(GLuint program, OBJModel &model,
+                       const Camera &camera, int width, int height) {
+  GLState &state = GLState::Instance();
+  state.Enable(GL_DEPTH_TEST);
+  state.Disable(GL_CULL_FACE);
+  state.Viewport(0, 0, width, height);
+  state.ClearColor(0.1f, 0.1f, 0.1f, 1.f);
+  glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+  state.UseProgram(program);
+
+  glm::mat4 modelMatrix =
+      glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -2.0f));
+  glm::mat4 viewMatrix = camera.GetViewMatrix();
+  glm::mat4 perspective = glm::perspective(
+      glm::radians(45.0f), (float)width / (float)height, 0.1f, 10.0f);
+  glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE,
+                     &modelMatrix[0][0]);
+  glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE,
+                     &viewMatrix[0][0]);
+  glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1,
+                     GL_FALSE, &perspective[0][0]);
+  glUniform3f(glGetUniformLocation(program, "u_CameraPosition"), 0.0f, 3.0f,
+              3.0f);
+  model.SetShaderMaterialUniforms(program);
+}
+
+int main(int argc, char **argv) {
+  int frames = 100;
+  int width = 640;
+  int height = 480;
+  std::string modes = "123456";
+  ForsythParams forsythParams = forsythDefaultParams();
+  std::vector<std::string> models;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+      frames = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--size") == 0 && i + 1 < argc) {
+      std::sscanf(argv[++i], "%dx%d", &width, &height);
+    } else if (std::strcmp(argv[i], "--modes") == 0 && i + 1 < argc) {
+      modes = argv[++i];
+    } else if (std::strcmp(argv[i], "--forsyth") == 0 && i + 1 < argc &&
+               FindForsythPreset(argv[i + 1], forsythParams)) {
+      i++;
+    } else if (argv[i][0] == '-') {
+      std::cout << "usage: " << argv[0]
+                << " [--frames N] [--size WxH] [--modes 123456]"
+                   " [--forsyth PRESET] [model.obj ...]"
+                << std::endl;
+      return 1;
+    } else {
+      models.push_back(argv[i]);
+    }
+  }
+  const std::string root = ENGINE_SOURCE_DIR;
+  if (models.empty()) {
+    models = {root + "/common/objects/textured_cube/cube.obj",
+              root + "/common/objects/tree_3/HandpaintedTree.obj",
+              root + "/common/objects/chapel/chapel_obj.obj",
+              root + "/common/objects/house/house_obj.obj"};
+  }
+
+  HeadlessContext context;
+  if (!context.Create(3, 3)) {
+    std::cerr << "headless_bench: " << context.GetError() << std::endl;
+    return 1;
+  }
+  std::cout << "Renderer: " << context.GetRenderer() << "\n";
+
+  RenderTarget target;
+  if (!target.Create(width, height)) {
+    std::cerr << "headless_bench: framebuffer is incomplete" << std::endl;
+    return 1;
+  }
+  GLuint program = CreateProgram(root + "/part1/shaders");
+  Camera camera;
+
+  std::cout << std::fixed << std::setprecision(3);
+  for (const std::string &path : models) {
+    OBJModel model;
+    model.setForsythParams(forsythParams);
+    auto loadStart = std::chrono::steady_clock::now();
+    model.loadModelFromFile(path);
+    double loadMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - loadStart)
+                        .count();
+    std::cout << path << "\n  load: " << loadMs << " ms\n";
+
+    for (char modeChar : modes) {
+      int mode = modeChar - '0';
+      if (mode < 1 || mode > OBJModel::kCacheModes) {
+        continue;
+      }
+      model.setCacheMode(mode);
+      // One warm up frame so shader compilation etc. is not measured
+      SetupFrame(program, model, camera, width, height);
+      model.render();
+      glFinish();
+
+      auto start = std::chrono::steady_clock::now();
+      for (int frame = 0; frame < frames; frame++) {
+        SetupFrame(program, model, camera, width, height);
+        model.render();
+      }
+      glFinish();
+      double totalMs = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+      std::cout << "  " << std::left << std::setw(11)
+                << OBJModel::getCacheModeName(mode) << std::right << ": "
+                << totalMs / frames << " ms/frame, ACMR "
+                << model.getCacheStats(mode).GetAcmr() << "\n";
+    }
+  }
+
+  ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Program, program);
+  glDeleteProgram(program);
+  target.Destroy();
+  return ResourceTracker::Instance().ShutdownCheck(std::cerr) ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+/** @file BenchUtil.hpp
+ *  @brief Helpers shared by the microbenchmarks.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef BENCH_UTIL_HPP
+#define BENCH_UTIL_HPP
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Path of a file in the repository (the benchmarks run from anywhere)
+inline std::string AssetPath(const std::string &relative) {
+  return std::string(ENGINE_SOURCE_DIR) + "/" + relative;
+}
+
+// Swallows std::cout while alive. Several loaders print a line per call,
+// which would otherwise be part of the measurement and flood the console.
+class QuietCout {
+public:
+  QuietCout() : m_previous(std::cout.rdbuf(m_sink.rdbuf())) {}
+  ~QuietCout() { std::cout.rdbuf(m_previous); }
+  QuietCout(const QuietCout &) = delete;
+  QuietCout &operator=(const QuietCout &) = delete;
+
+private:
+  std::ostringstream m_sink;
+  std::streambuf *m_previous;
+};
+
+#endif
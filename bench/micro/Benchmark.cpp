@@ -0,0 +1,400 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <thread>
+
+#include <unistd.h>
+
+namespace benchmark {
+
+State::State(int64_t maxIterations, const std::vector<int64_t> &args)
+    : m_maxIterations(maxIterations), m_args(args) {}
+
+void State::StartTimer() {
+  m_running = true;
+  m_realStart = std::chrono::steady_clock::now();
+  m_cpuStart = std::clock();
+}
+
+void State::StopTimer() {
+  if (!m_running) {
+    return;
+  }
+  m_realSeconds += std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - m_realStart)
+                       .count();
+  m_cpuSeconds += double(std::clock() - m_cpuStart) / CLOCKS_PER_SEC;
+  m_running = false;
+}
+
+void State::PauseTiming() { StopTimer(); }
+
+void State::ResumeTiming() { StartTimer(); }
+
+void State::SkipWithError(const char *message) {
+  m_error = message;
+  m_maxIterations = 0;
+}
+
+Benchmark::Benchmark(const std::string &name, Function function)
+    : m_name(name), m_function(function) {}
+
+Benchmark *Benchmark::Arg(int64_t x) {
+  m_argSets.push_back({x});
+  return this;
+}
+
+Benchmark *Benchmark::Args(const std::vector<int64_t> &args) {
+  m_argSets.push_back(args);
+  return this;
+}
+
+Benchmark *Benchmark::Unit(TimeUnit unit) {
+  m_unit = unit;
+  return this;
+}
+
+Benchmark *Benchmark::MinTime(double seconds) {
+  m_minTime = seconds;
+  return this;
+}
+
+static std::vector<Benchmark *> &GetBenchmarks() {
+  static std::vector<Benchmark *> benchmarks;
+  return benchmarks;
+}
+
+Benchmark *RegisterBenchmark(const std::string &name, Function function) {
+  GetBenchmarks().push_back(new Benchmark(name, function));
+  return GetBenchmarks().back();
+}
+
+static std::map<std::string, std::string> &GetCustomContext() {
+  static std::map<std::string, std::string> context;
+  return context;
+}
+
+void AddCustomContext(const std::string &key, const std::string &value) {
+  GetCustomContext()[key] = value;
+}
+
+// Result of one benchmark with one argument set
+struct Run {
+  std::string name;
+  int64_t iterations{0};
+  double realSeconds{0.0}; // per iteration
+  double cpuSeconds{0.0};  // per iteration
+  double bytesPerSecond{0.0};
+  double itemsPerSecond{0.0};
+  TimeUnit unit{kNanosecond};
+  std::string label;
+  std::string error;
+};
+
+static double UnitMultiplier(TimeUnit unit) {
+  switch (unit) {
+  case kSecond:
+    return 1.0;
+  case kMillisecond:
+    return 1e3;
+  case kMicrosecond:
+    return 1e6;
+  default:
+    return 1e9;
+  }
+}
+
+static const char *UnitName(TimeUnit unit) {
+  switch (unit) {
+  case kSecond:
+    return "s";
+  case kMillisecond:
+    return "ms";
+  case kMicrosecond:
+    return "us";
+  default:
+    return "ns";
+  }
+}
+
+// Prints 1234567 as 1.23457M
+static std::string HumanReadable(double value) {
+  const char *suffixes[] = {"", "k", "M", "G", "T"};
+  int i = 0;
+  while (value >= 1000.0 && i < 4) {
+    value /= 1000.0;
+    i++;
+  }
+  std::ostringstream out;
+  out << std::setprecision(4) << value << suffixes[i];
+  return out.str();
+}
+
+// Same strategy as Google Benchmark: start with one iteration and grow the
+// count until a run takes at least minTime seconds.
+static Run RunBenchmark(const Benchmark &benchmark,
+                        const std::vector<int64_t> &args,
+                        const std::string &name, double minTime) {
+  Run run;
+  run.name = name;
+  run.unit = benchmark.m_unit;
+  if (benchmark.m_minTime > 0.0) {
+    minTime = benchmark.m_minTime;
+  }
+  int64_t iterations = 1;
+  const int64_t maxIterations = 1000000000;
+  while (true) {
+    State state(iterations, args);
+    benchmark.m_function(state);
+    if (!state.GetError().empty()) {
+      run.error = state.GetError();
+      return run;
+    }
+    double seconds = state.GetRealSeconds();
+    if (seconds >= minTime || iterations >= maxIterations) {
+      run.iterations = iterations;
+      run.realSeconds = seconds / iterations;
+      run.cpuSeconds = state.GetCpuSeconds() / iterations;
+      if (seconds > 0.0) {
+        run.bytesPerSecond = state.GetBytesProcessed() / seconds;
+        run.itemsPerSecond = state.GetItemsProcessed() / seconds;
+      }
+      run.label = state.GetLabel();
+      return run;
+    }
+    // Aim a bit past minTime, but never grow by more than 10x at once
+    double multiplier = seconds > 0.0 ? minTime * 1.4 / seconds : 10.0;
+    multiplier = std::min(10.0, std::max(multiplier, 1.0));
+    int64_t next = static_cast<int64_t>(iterations * multiplier);
+    iterations = std::min(maxIterations, std::max(next, iterations + 1));
+  }
+}
+
+static void PrintRun(const Run &run) {
+  std::cout << std::left << std::setw(50) << run.name << std::right;
+  if (!run.error.empty()) {
+    std::cout << " ERROR: " << run.error << std::endl;
+    return;
+  }
+  double multiplier = UnitMultiplier(run.unit);
+  std::cout << std::fixed << std::setprecision(1) << std::setw(12)
+            << run.realSeconds * multiplier << " " << std::setw(2)
+            << UnitName(run.unit) << std::setw(12)
+            << run.cpuSeconds * multiplier << " " << std::setw(2)
+            << UnitName(run.unit) << std::setw(12) << run.iterations;
+  std::cout.unsetf(std::ios::floatfield);
+  if (run.bytesPerSecond > 0.0) {
+    std::cout << " bytes_per_second=" << HumanReadable(run.bytesPerSecond)
+              << "/s";
+  }
+  if (run.itemsPerSecond > 0.0) {
+    std::cout << " items_per_second=" << HumanReadable(run.itemsPerSecond)
+              << "/s";
+  }
+  if (!run.label.empty()) {
+    std::cout << " " << run.label;
+  }
+  std::cout << std::endl;
+}
+
+// Escapes quotes, backslashes and control characters for a JSON string
+static std::string JsonString(const std::string &text) {
+  std::string out = "\"";
+  for (char c : text) {
+    switch (c) {
+    case '"':
+      out += "\\\"";
+      break;
+    case '\\':
+      out += "\\\\";
+      break;
+    case '\n':
+      out += "\\n";
+      break;
+    case '\t':
+      out += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        out += escaped;
+      } else {
+        out += c;
+      }
+    }
+  }
+  return out + "\"";
+}
+
+// Same layout as Google Benchmark's JSON reporter (only the fields we fill)
+static void WriteJson(std::ostream &out, const std::vector<Run> &runs,
+                      const char *executable) {
+  char date[64] = "";
+  std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z",
+                std::localtime(&now));
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+
+  out << std::setprecision(10);
+  out << "{\n  \"context\": {\n";
+  out << "    \"date\": " << JsonString(date) << ",\n";
+  out << "    \"host_name\": " << JsonString(host) << ",\n";
+  out << "    \"executable\": " << JsonString(executable) << ",\n";
+  out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+  for (const auto &entry : GetCustomContext()) {
+    out << "    " << JsonString(entry.first) << ": "
+        << JsonString(entry.second) << ",\n";
+  }
+#ifdef NDEBUG
+  out << "    \"library_build_type\": \"release\"\n";
+#else
+  out << "    \"library_build_type\": \"debug\"\n";
+#endif
+  out << "  },\n  \"benchmarks\": [";
+  for (size_t i = 0; i < runs.size(); i++) {
+    const Run &run = runs[i];
+    double multiplier = UnitMultiplier(run.unit);
+    out << (i == 0 ? "\n" : ",\n") << "    {\n";
+    out << "      \"name\": " << JsonString(run.name) << ",\n";
+    out << "      \"run_name\": " << JsonString(run.name) << ",\n";
+    out << "      \"run_type\": \"iteration\",\n";
+    if (!run.error.empty()) {
+      out << "      \"error_occurred\": true,\n";
+      out << "      \"error_message\": " << JsonString(run.error) << "\n";
+      out << "    }";
+      continue;
+    }
+    out << "      \"iterations\": " << run.iterations << ",\n";
+    out << "      \"real_time\": " << run.realSeconds * multiplier << ",\n";
+    out << "      \"cpu_time\": " << run.cpuSeconds * multiplier << ",\n";
+    out << "      \"time_unit\": \"" << UnitName(run.unit) << "\"";
+    if (run.bytesPerSecond > 0.0) {
+      out << ",\n      \"bytes_per_second\": " << run.bytesPerSecond;
+    }
+    if (run.itemsPerSecond > 0.0) {
+      out << ",\n      \"items_per_second\": " << run.itemsPerSecond;
+    }
+    if (!run.label.empty()) {
+      out << ",\n      \"label\": " << JsonString(run.label);
+    }
+    out << "\n    }";
+  }
+  out << "\n  ]\n}\n";
+}
+
+// Value of "--name=value" if 'arg' is that flag
+static bool ParseFlag(const char *arg, const char *name, std::string &value) {
+  size_t length = std::strlen(name);
+  if (std::strncmp(arg, name, length) != 0 || arg[length] != '=') {
+    return false;
+  }
+  value = arg + length + 1;
+  return true;
+}
+
+static void PrintUsage(const char *program) {
+  std::cerr << "usage: " << program
+            << " [--benchmark_filter=<regex>]"
+               " [--benchmark_min_time=<seconds>]"
+               " [--benchmark_list_tests]"
+               " [--benchmark_format=console|json]"
+               " [--benchmark_out=<file>]"
+               " [--benchmark_out_format=json]"
+            << std::endl;
+}
+
+size_t RunSpecifiedBenchmarks(int argc, char **argv) {
+  std::string filter = ".";
+  double minTime = 0.5;
+  bool listOnly = false;
+  std::string format = "console";
+  std::string outPath;
+  for (int i = 1; i < argc; i++) {
+    std::string value;
+    if (ParseFlag(argv[i], "--benchmark_filter", value)) {
+      filter = value;
+    } else if (ParseFlag(argv[i], "--benchmark_min_time", value)) {
+      minTime = std::atof(value.c_str()); // "0.5" and "0.5s" both work
+    } else if (std::strcmp(argv[i], "--benchmark_list_tests") == 0 ||
+               std::strcmp(argv[i], "--benchmark_list_tests=true") == 0) {
+      listOnly = true;
+    } else if (ParseFlag(argv[i], "--benchmark_format", value) &&
+               (value == "console" || value == "json")) {
+      format = value;
+    } else if (ParseFlag(argv[i], "--benchmark_out", value)) {
+      outPath = value;
+    } else if (ParseFlag(argv[i], "--benchmark_out_format", value) &&
+               value == "json") {
+      // The only file format
+    } else {
+      PrintUsage(argv[0]);
+      std::exit(1);
+    }
+  }
+  std::regex pattern(filter);
+  // With --benchmark_format=json stdout only gets the JSON
+  bool console = format == "console";
+
+#ifndef NDEBUG
+  std::cerr << "***WARNING*** The benchmarks were built without "
+               "optimizations (debug); timings will be misleading."
+            << std::endl;
+#endif
+  if (console && !listOnly) {
+    std::cout << std::left << std::setw(50) << "Benchmark" << std::right
+              << std::setw(15) << "Time" << std::setw(15) << "CPU"
+              << std::setw(12) << "Iterations" << "\n"
+              << std::string(92, '-') << std::endl;
+  }
+  std::vector<Run> runs;
+  for (const Benchmark *benchmark : GetBenchmarks()) {
+    std::vector<std::vector<int64_t>> argSets = benchmark->m_argSets;
+    if (argSets.empty()) {
+      argSets.push_back({});
+    }
+    for (const std::vector<int64_t> &args : argSets) {
+      std::string name = benchmark->m_name;
+      for (int64_t arg : args) {
+        name += "/" + std::to_string(arg);
+      }
+      if (!std::regex_search(name, pattern)) {
+        continue;
+      }
+      if (listOnly) {
+        std::cout << name << std::endl;
+        continue;
+      }
+      runs.push_back(RunBenchmark(*benchmark, args, name, minTime));
+      if (console) {
+        PrintRun(runs.back());
+      }
+    }
+  }
+  if (!listOnly) {
+    if (!console) {
+      WriteJson(std::cout, runs, argv[0]);
+    }
+    if (!outPath.empty()) {
+      std::ofstream out(outPath);
+      if (!out.is_open()) {
+        std::cerr << "Could not write " << outPath << std::endl;
+      } else {
+        WriteJson(out, runs, argv[0]);
+      }
+    }
+  }
+  return runs.size();
+}
+
+} // namespace benchmark
@@ -0,0 +1,173 @@
+/** @file Benchmark.hpp
+ *  @brief A small microbenchmark harness with the Google Benchmark API.
+ *
+ *  Benchmarks are written exactly like Google Benchmark ones:
+ *
+ *    static void BM_Something(benchmark::State &state) {
+ *      for (auto _ : state) {
+ *        benchmark::DoNotOptimize(Something(state.range(0)));
+ *      }
+ *      state.SetItemsProcessed(state.iterations());
+ *    }
+ *    BENCHMARK(BM_Something)->Arg(64)->Arg(1024);
+ *
+ *  but nothing has to be downloaded or installed to build them. Only the
+ *  part of the API used in this repository is provided. Each benchmark runs
+ *  with a growing number of iterations until it takes at least
+ *  --benchmark_min_time seconds, then the time per iteration is reported.
+ *
+ *  Results can also be written as JSON in Google Benchmark's format
+ *  (--benchmark_out=<file>, or --benchmark_format=json for stdout), so
+ *  tools/compare_bench.py can compare two runs and flag regressions.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace benchmark {
+
+enum TimeUnit { kNanosecond, kMicrosecond, kMillisecond, kSecond };
+
+class State {
+public:
+  State(int64_t maxIterations, const std::vector<int64_t> &args);
+
+  // Range based for loop support: for (auto _ : state) { ... }
+  // (the attribute keeps GCC quiet about '_' being unused)
+#if defined(__GNUC__) || defined(__clang__)
+  struct __attribute__((unused)) Value {};
+#else
+  struct Value {};
+#endif
+  struct Iterator {
+    State *parent;
+    int64_t remaining;
+    Value operator*() const { return Value(); }
+    Iterator &operator++() {
+      --remaining;
+      return *this;
+    }
+    bool operator!=(const Iterator &) {
+      if (remaining > 0) {
+        return true;
+      }
+      parent->StopTimer();
+      return false;
+    }
+  };
+  Iterator begin() {
+    StartTimer();
+    return Iterator{this, m_maxIterations};
+  }
+  Iterator end() { return Iterator{this, 0}; }
+
+  // Argument i of this run (see Benchmark::Arg/Args)
+  int64_t range(size_t i = 0) const { return m_args.at(i); }
+  // Number of iterations of this run
+  int64_t iterations() const { return m_maxIterations; }
+
+  // Exclude setup work inside the loop from the measurement
+  void PauseTiming();
+  void ResumeTiming();
+
+  void SetBytesProcessed(int64_t bytes) { m_bytesProcessed = bytes; }
+  void SetItemsProcessed(int64_t items) { m_itemsProcessed = items; }
+  void SetLabel(const std::string &label) { m_label = label; }
+  // Stops the benchmark and reports the message instead of a time
+  void SkipWithError(const char *message);
+
+  // Results, read by the runner
+  double GetRealSeconds() const { return m_realSeconds; }
+  double GetCpuSeconds() const { return m_cpuSeconds; }
+  int64_t GetBytesProcessed() const { return m_bytesProcessed; }
+  int64_t GetItemsProcessed() const { return m_itemsProcessed; }
+  const std::string &GetLabel() const { return m_label; }
+  const std::string &GetError() const { return m_error; }
+
+private:
+  void StartTimer();
+  void StopTimer();
+
+  int64_t m_maxIterations;
+  std::vector<int64_t> m_args;
+  bool m_running{false};
+  std::chrono::steady_clock::time_point m_realStart;
+  std::clock_t m_cpuStart{0};
+  double m_realSeconds{0.0};
+  double m_cpuSeconds{0.0};
+  int64_t m_bytesProcessed{0};
+  int64_t m_itemsProcessed{0};
+  std::string m_label;
+  std::string m_error;
+};
+
+// Plain functions and lambdas (e.g. one per asset found at startup)
+typedef std::function<void(State &)> Function;
+
+// One registered benchmark function and its argument sets
+class Benchmark {
+public:
+  Benchmark(const std::string &name, Function function);
+  Benchmark *Arg(int64_t x);
+  Benchmark *Args(const std::vector<int64_t> &args);
+  Benchmark *Unit(TimeUnit unit);
+  Benchmark *MinTime(double seconds);
+
+  std::string m_name;
+  Function m_function;
+  std::vector<std::vector<int64_t>> m_argSets;
+  TimeUnit m_unit{kNanosecond};
+  double m_minTime{0.0};
+};
+
+Benchmark *RegisterBenchmark(const std::string &name, Function function);
+
+// Parses the --benchmark_* flags and runs every matching benchmark.
+// Returns the number of benchmarks that ran (like Google Benchmark, a
+// benchmark that skipped itself with an error still counts).
+size_t RunSpecifiedBenchmarks(int argc, char **argv);
+
+// Adds "key": "value" to the "context" of the JSON output (e.g. the name of
+// the OpenGL renderer used by the GPU benchmarks)
+void AddCustomContext(const std::string &key, const std::string &value);
+
+// Keeps the compiler from optimizing 'value' (and its computation) away
+template <class T> inline void DoNotOptimize(T const &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void *sink;
+  sink = &value;
+#endif
+}
+
+// Forces all pending writes to memory
+inline void ClobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+} // namespace benchmark
+
+#define BENCHMARK_CONCAT2(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT2(a, b)
+#define BENCHMARK(function)                                                    \
+  static ::benchmark::Benchmark *BENCHMARK_CONCAT(benchmark_, __LINE__) =      \
+      ::benchmark::RegisterBenchmark(#function, function)
+
+#define BENCHMARK_MAIN()                                                       \
+  int main(int argc, char **argv) {                                            \
+    ::benchmark::RunSpecifiedBenchmarks(argc, argv);                           \
+    return 0;                                                                  \
+  }
+
+#endif
@@ -0,0 +1,49 @@
+// Recording command buffers (CommandBuffer.hpp) for a scene of nodes, the
+// work Assignment10_fbo's renderer moves off the GL thread: one node's
+// model matrix, its transforms block and five commands. Arguments: node
+// count, threads. Replaying them is in GpuBench.cpp.
+#include "Benchmark.hpp"
+#include "CommandBuffer.hpp"
+#include "Material.hpp"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+static void BM_RecordCommands(benchmark::State &state) {
+  size_t nodes = static_cast<size_t>(state.range(0));
+  WorkerPool workers(static_cast<unsigned>(state.range(1)));
+  std::vector<glm::vec3> positions(nodes);
+  for (size_t i = 0; i < nodes; i++) {
+    positions[i] = glm::vec3(static_cast<float>(i % 64), 0.0f,
+                             static_cast<float>(i / 64));
+  }
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 10.0f, -10.0f),
+                               glm::vec3(32.0f, 0.0f, 32.0f),
+                               glm::vec3(0.0f, 1.0f, 0.0f));
+  glm::mat4 projection =
+      glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 512.0f);
+  std::vector<CommandBuffer> buffers;
+  auto record = [&](size_t begin, size_t end, CommandBuffer &out) {
+    for (size_t i = begin; i < end; i++) {
+      TransformBlock transforms{glm::translate(glm::mat4(1.0f), positions[i]),
+                                view, projection};
+      out.BindProgram(1);
+      out.SetUniformBlock(kTransformsBinding, &transforms, sizeof(transforms));
+      out.BindVertexArray(1);
+      out.BindTexture(0, 1);
+      out.DrawIndexed(GL_TRIANGLES, 36);
+    }
+  };
+  for (auto _ : state) {
+    RecordCommands(workers, nodes, 256, buffers, record);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * nodes);
+}
+BENCHMARK(BM_RecordCommands)
+    ->Args({8192, 1})
+    ->Args({8192, 2})
+    ->Args({8192, 4})
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,108 @@
+// Culling state.range(0) objects against a frustum: the world spheres of a
+// ComponentStore read from one column, against nodes allocated one by one
+// that each point at their object's sphere and move it by their transform
+// on every test (what the scene graph did before, see ComponentStore.hpp).
+#include "Benchmark.hpp"
+#include "ComponentStore.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Objects on a 512 wide grid, every fourth one static; the camera sees
+// about one in eight
+static glm::mat4 Placement(size_t i) {
+  return glm::translate(glm::mat4(1.0f),
+                        glm::vec3(static_cast<float>(i % 512) * 4.0f, 0.0f,
+                                  static_cast<float>(i / 512) * 4.0f));
+}
+
+static MultiViewFrustum MakeFrustum() {
+  glm::mat4 viewProjection =
+      glm::perspective(glm::radians(45.0f), 16.0f / 9.0f, 0.1f, 512.0f) *
+      glm::lookAt(glm::vec3(1024.0f, 50.0f, -20.0f),
+                  glm::vec3(1024.0f, 0.0f, 200.0f),
+                  glm::vec3(0.0f, 1.0f, 0.0f));
+  return MultiViewFrustum(&viewProjection, 1);
+}
+
+static void BM_CullRenderables(benchmark::State &state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  ComponentStore store;
+  for (size_t i = 0; i < count; i++) {
+    ComponentMask mask = kRenderableComponents;
+    if (i % 4 == 0) {
+      mask |= kStaticTag;
+    }
+    Entity entity = store.Create(mask);
+    *store.GetTransform(entity) = Placement(i);
+    *store.GetBounds(entity) = glm::vec4(0.0f, 0.0f, 0.0f, 1.5f);
+  }
+  UpdateWorldBounds(store);
+  MultiViewFrustum frustum = MakeFrustum();
+  std::vector<DrawRef> visible;
+  visible.reserve(count);
+  for (auto _ : state) {
+    visible.clear();
+    CullRenderables(store, frustum, 0, visible);
+    benchmark::DoNotOptimize(visible.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetLabel(std::to_string(visible.size()) + " visible");
+}
+BENCHMARK(BM_CullRenderables)->Arg(100000)->Unit(benchmark::kMicrosecond);
+
+// The same objects as separately allocated nodes, in a shuffled order as a
+// long lived heap leaves them
+struct BenchObject {
+  glm::vec4 sphere;
+  std::vector<float> geometry;
+};
+struct BenchNode {
+  glm::mat4 world;
+  std::shared_ptr<BenchObject> object;
+  bool isStatic;
+};
+
+static void BM_CullNodeObjects(benchmark::State &state) {
+  size_t count = static_cast<size_t>(state.range(0));
+  std::vector<std::unique_ptr<BenchNode>> owned;
+  for (size_t i = 0; i < count; i++) {
+    BenchNode *node = new BenchNode();
+    node->world = Placement(i);
+    node->object = std::make_shared<BenchObject>();
+    node->object->sphere = glm::vec4(0.0f, 0.0f, 0.0f, 1.5f);
+    node->object->geometry.resize(16);
+    node->isStatic = i % 4 == 0;
+    owned.emplace_back(node);
+  }
+  std::vector<BenchNode *> nodes;
+  for (size_t i = 0; i < count; i++) {
+    nodes.push_back(owned[(i * 7919) % count].get());
+  }
+  MultiViewFrustum frustum = MakeFrustum();
+  std::vector<BenchNode *> visible;
+  visible.reserve(count);
+  for (auto _ : state) {
+    visible.clear();
+    for (BenchNode *node : nodes) {
+      const glm::vec4 &sphere = node->object->sphere;
+      const glm::mat4 &model = node->world;
+      glm::vec3 center =
+          glm::vec3(model * glm::vec4(glm::vec3(sphere), 1.0f));
+      float scale = std::max(glm::length(glm::vec3(model[0])),
+                             std::max(glm::length(glm::vec3(model[1])),
+                                      glm::length(glm::vec3(model[2]))));
+      if (frustum.IntersectsSphere(center, sphere.w * scale)) {
+        visible.push_back(node);
+      }
+    }
+    benchmark::DoNotOptimize(visible.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetLabel(std::to_string(visible.size()) + " visible");
+}
+BENCHMARK(BM_CullNodeObjects)->Arg(100000)->Unit(benchmark::kMicrosecond);
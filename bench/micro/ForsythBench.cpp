@@ -0,0 +1,51 @@
+// Forsyth vertex cache optimization speed (triangles/s) on real meshes.
+// Only positions are used to index, like a mesh with shared vertices.
+#include "Benchmark.hpp"
+#include "BenchUtil.hpp"
+#include "ObjParser.hpp"
+#include "forsyth.h"
+
+#include <string>
+#include <vector>
+
+static void BM_ForsythReorder(benchmark::State &state,
+                              const std::string &path) {
+  ObjData data;
+  if (!LoadObjFile(path, data)) {
+    state.SkipWithError("could not load the model");
+    return;
+  }
+  std::vector<ForsythVertexIndexType> indices;
+  indices.reserve(data.corners.size());
+  for (const ObjIndex &corner : data.corners) {
+    indices.push_back(static_cast<ForsythVertexIndexType>(corner.position));
+  }
+  std::vector<ForsythVertexIndexType> reordered(indices.size());
+  int triangles = static_cast<int>(data.GetTriangleCount());
+  int vertices = static_cast<int>(data.positions.size());
+  for (auto _ : state) {
+    forsythReorderIndices(reordered.data(), indices.data(), triangles,
+                          vertices);
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * triangles);
+  state.SetLabel(std::to_string(triangles) + " triangles");
+}
+
+static bool RegisterForsythBenchmarks() {
+  const char *models[][2] = {
+      {"bunny", "common/objects/bunny_centered.obj"},
+      {"lion", "common/objects/lion/lion_2_percent_of_triangles.obj"},
+      {"house", "common/objects/house/house_obj.obj"},
+      {"chapel", "common/objects/chapel/chapel_obj.obj"}};
+  for (const auto &model : models) {
+    std::string path = AssetPath(model[1]);
+    benchmark::RegisterBenchmark(std::string("BM_ForsythReorder/") + model[0],
+                                 [path](benchmark::State &state) {
+                                   BM_ForsythReorder(state, path);
+                                 })
+        ->Unit(benchmark::kMillisecond);
+  }
+  return true;
+}
+static bool forsythBenchmarksRegistered = RegisterForsythBenchmarks();
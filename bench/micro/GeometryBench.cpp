@@ -0,0 +1,62 @@
+// Building Assignment10_fbo's terrain mesh on the CPU: the full grid
+// (AddVertex, AddIndex, Gen, what MakeTerrainGeometry does before the upload)
+// and Geometry::Gen on its own.
+#include "Benchmark.hpp"
+#include "Geometry.hpp"
+
+#include <memory>
+
+// Same grid as MakeTerrainGeometry, with a flat height field
+static void BuildGrid(Geometry &geometry, unsigned int size) {
+  for (unsigned int z = 0; z < size; ++z) {
+    for (unsigned int x = 0; x < size; ++x) {
+      float u = 1.0f - ((float)x / (float)size);
+      float v = 1.0f - ((float)z / (float)size);
+      geometry.AddVertex(x, 0.0f, z, u, v);
+    }
+  }
+  for (unsigned int z = 0; z < size - 1; ++z) {
+    for (unsigned int x = 0; x < size - 1; ++x) {
+      geometry.AddIndex(x + z * size);
+      geometry.AddIndex(x + z * size + size);
+      geometry.AddIndex(x + z * size + 1);
+      geometry.AddIndex(x + z * size + 1);
+      geometry.AddIndex(x + z * size + size);
+      geometry.AddIndex(x + z * size + size + 1);
+    }
+  }
+}
+
+static void BM_TerrainGridBuild(benchmark::State &state) {
+  unsigned int size = static_cast<unsigned int>(state.range(0));
+  for (auto _ : state) {
+    Geometry geometry;
+    BuildGrid(geometry, size);
+    geometry.Gen();
+    benchmark::DoNotOptimize(geometry.GetBufferDataPtr());
+  }
+  state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_TerrainGridBuild)
+    ->Arg(128)
+    ->Arg(512)
+    ->Unit(benchmark::kMillisecond);
+
+// Gen appends to the interleaved buffer, so every iteration needs a fresh
+// Geometry; building it is not measured.
+static void BM_GeometryGen(benchmark::State &state) {
+  unsigned int size = static_cast<unsigned int>(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<Geometry> geometry(new Geometry());
+    BuildGrid(*geometry, size);
+    state.ResumeTiming();
+    geometry->Gen();
+    benchmark::DoNotOptimize(geometry->GetBufferDataPtr());
+    state.PauseTiming();
+    geometry.reset();
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * size * size);
+}
+BENCHMARK(BM_GeometryGen)->Arg(128)->Arg(512)->Unit(benchmark::kMillisecond);
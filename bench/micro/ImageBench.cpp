@@ -0,0 +1,37 @@
+// PPM decode throughput (MB/s of file) of Assignment10_fbo's Image loader
+#include "Benchmark.hpp"
+#include "BenchUtil.hpp"
+#include "Image.hpp"
+
+#include <filesystem>
+#include <string>
+
+static void BM_LoadPPM(benchmark::State &state, const std::string &path) {
+  std::error_code error;
+  uintmax_t fileSize = std::filesystem::file_size(path, error);
+  if (error) {
+    state.SkipWithError("could not read the file");
+    return;
+  }
+  QuietCout quiet;
+  for (auto _ : state) {
+    Image image(path);
+    image.LoadPPM(true);
+    benchmark::DoNotOptimize(image.GetPixelDataPtr());
+  }
+  state.SetBytesProcessed(state.iterations() * fileSize);
+}
+
+static bool RegisterImageBenchmarks() {
+  for (const char *name : {"terrain2", "colormap", "brick"}) {
+    std::string path = AssetPath(std::string("common/textures/") + name +
+                                 ".ppm");
+    benchmark::RegisterBenchmark(std::string("BM_LoadPPM/") + name,
+                                 [path](benchmark::State &state) {
+                                   BM_LoadPPM(state, path);
+                                 })
+        ->Unit(benchmark::kMillisecond);
+  }
+  return true;
+}
+static bool imageBenchmarksRegistered = RegisterImageBenchmarks();
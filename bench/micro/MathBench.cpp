@@ -0,0 +1,136 @@
+// Batched math kernels (MathKernels.hpp) against the same work done one
+// element at a time with plain glm types.
+#include "Benchmark.hpp"
+#include "MathKernels.hpp"
+
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+static glm::mat4 TestMatrix() {
+  glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+  m = glm::rotate(m, 0.7f, glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f)));
+  return glm::scale(m, glm::vec3(2.0f, 0.5f, 1.5f));
+}
+
+static void BM_Mat4MultiplyGlm(benchmark::State &state) {
+  std::vector<glm::mat4> lhs(state.range(0), TestMatrix());
+  std::vector<glm::mat4> rhs(lhs), out(lhs.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < lhs.size(); i++) {
+      out[i] = lhs[i] * rhs[i];
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * lhs.size());
+}
+BENCHMARK(BM_Mat4MultiplyGlm)->Arg(1024);
+
+static void BM_Mat4MultiplyBatch(benchmark::State &state) {
+  std::vector<glm::mat4> lhs(state.range(0), TestMatrix());
+  std::vector<glm::mat4> rhs(lhs), out(lhs.size());
+  for (auto _ : state) {
+    MultiplyMat4Batch(lhs.data(), rhs.data(), out.data(), lhs.size());
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * lhs.size());
+}
+BENCHMARK(BM_Mat4MultiplyBatch)->Arg(1024);
+
+static PointsSoA RandomPoints(size_t count) {
+  std::mt19937 random(5310);
+  std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+  PointsSoA points;
+  points.Resize(count);
+  for (size_t i = 0; i < count; i++) {
+    points.x[i] = value(random);
+    points.y[i] = value(random);
+    points.z[i] = value(random);
+  }
+  return points;
+}
+
+// The usual layout: an array of glm::vec3
+static void BM_TransformPointsGlm(benchmark::State &state) {
+  PointsSoA soa = RandomPoints(state.range(0));
+  std::vector<glm::vec3> points(soa.Size()), out(soa.Size());
+  for (size_t i = 0; i < points.size(); i++) {
+    points[i] = glm::vec3(soa.x[i], soa.y[i], soa.z[i]);
+  }
+  glm::mat4 m = TestMatrix();
+  for (auto _ : state) {
+    for (size_t i = 0; i < points.size(); i++) {
+      out[i] = glm::vec3(m * glm::vec4(points[i], 1.0f));
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * points.size());
+}
+BENCHMARK(BM_TransformPointsGlm)->Arg(65536);
+
+static void BM_TransformPointsScalar(benchmark::State &state) {
+  PointsSoA points = RandomPoints(state.range(0)), out;
+  glm::mat4 m = TestMatrix();
+  for (auto _ : state) {
+    TransformPointsScalar(m, points, out);
+    benchmark::DoNotOptimize(out.x.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * points.Size());
+}
+BENCHMARK(BM_TransformPointsScalar)->Arg(65536);
+
+static void BM_TransformPointsSoA(benchmark::State &state) {
+  PointsSoA points = RandomPoints(state.range(0)), out;
+  glm::mat4 m = TestMatrix();
+  for (auto _ : state) {
+    TransformPoints(m, points, out);
+    benchmark::DoNotOptimize(out.x.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * points.Size());
+}
+BENCHMARK(BM_TransformPointsSoA)->Arg(65536);
+
+static AabbSoA RandomAabbs(size_t count) {
+  PointsSoA corners = RandomPoints(count);
+  AabbSoA boxes;
+  boxes.Resize(count);
+  for (size_t i = 0; i < count; i++) {
+    boxes.minX[i] = corners.x[i];
+    boxes.minY[i] = corners.y[i];
+    boxes.minZ[i] = corners.z[i];
+    boxes.maxX[i] = corners.x[i] + 2.0f;
+    boxes.maxY[i] = corners.y[i] + 3.0f;
+    boxes.maxZ[i] = corners.z[i] + 1.0f;
+  }
+  return boxes;
+}
+
+static void BM_TransformAabbsScalar(benchmark::State &state) {
+  AabbSoA boxes = RandomAabbs(state.range(0)), out;
+  glm::mat4 m = TestMatrix();
+  for (auto _ : state) {
+    TransformAabbsScalar(m, boxes, out);
+    benchmark::DoNotOptimize(out.minX.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * boxes.Size());
+}
+BENCHMARK(BM_TransformAabbsScalar)->Arg(16384);
+
+static void BM_TransformAabbsSoA(benchmark::State &state) {
+  AabbSoA boxes = RandomAabbs(state.range(0)), out;
+  glm::mat4 m = TestMatrix();
+  for (auto _ : state) {
+    TransformAabbs(m, boxes, out);
+    benchmark::DoNotOptimize(out.minX.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * boxes.Size());
+}
+BENCHMARK(BM_TransformAabbsSoA)->Arg(16384);
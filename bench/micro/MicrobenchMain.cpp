@@ -0,0 +1,3 @@
+#include "Benchmark.hpp"
+
+BENCHMARK_MAIN()
@@ -0,0 +1,49 @@
+// .obj parsing throughput (MB/s) for every model in common/objects. The
+// file is read once; only ParseObj is measured.
+#include "Benchmark.hpp"
+#include "BenchUtil.hpp"
+#include "ObjParser.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+static void BM_ParseObj(benchmark::State &state, const std::string &path) {
+  std::string text;
+  if (!ReadFileToString(path, text)) {
+    state.SkipWithError("could not read the file");
+    return;
+  }
+  ObjData data;
+  for (auto _ : state) {
+    ParseObj(text.data(), text.size(), data);
+    benchmark::DoNotOptimize(data.corners.data());
+  }
+  state.SetBytesProcessed(state.iterations() * text.size());
+  state.SetLabel(std::to_string(data.GetTriangleCount()) + " triangles");
+}
+
+// One benchmark per file, e.g. BM_ParseObj/chapel/chapel_obj.obj
+static bool RegisterObjBenchmarks() {
+  namespace fs = std::filesystem;
+  const fs::path root = AssetPath("common/objects");
+  std::vector<fs::path> files;
+  std::error_code error;
+  for (const auto &entry : fs::recursive_directory_iterator(root, error)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".obj") {
+      files.push_back(entry.path());
+    }
+  }
+  std::sort(files.begin(), files.end());
+  for (const fs::path &file : files) {
+    std::string path = file.string();
+    std::string name =
+        "BM_ParseObj/" + file.lexically_relative(root).generic_string();
+    benchmark::RegisterBenchmark(name, [path](benchmark::State &state) {
+      BM_ParseObj(state, path);
+    })->Unit(benchmark::kMillisecond);
+  }
+  return true;
+}
+static bool objBenchmarksRegistered = RegisterObjBenchmarks();
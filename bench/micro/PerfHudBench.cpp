@@ -0,0 +1,25 @@
+// Building the performance overlay's quads, the CPU half of what the HUD
+// costs per frame (GpuBench.cpp measures the upload and the draw).
+#include "Benchmark.hpp"
+#include "FrameStats.hpp"
+#include "PerfHud.hpp"
+
+static void BM_PerfHudBuild(benchmark::State &state) {
+  FrameStats &stats = FrameStats::Instance();
+  stats.Reset();
+  // Full graphs, so every bar is drawn
+  for (size_t i = 0; i < FrameHistory::kSize; i++) {
+    stats.CountDraw(50000);
+    stats.CountStateChange(12);
+    stats.AddGpuTime(4.0f + (i % 7));
+    stats.EndFrame(16.0f + (i % 13));
+  }
+  HudBatch batch;
+  for (auto _ : state) {
+    BuildPerfHud(batch, stats, 256u << 20, 32u << 20, 0.05f);
+    benchmark::DoNotOptimize(batch.GetVertices().data());
+  }
+  state.SetItemsProcessed(state.iterations() * batch.GetQuadCount());
+  stats.Reset();
+}
+BENCHMARK(BM_PerfHudBuild)->Unit(benchmark::kMicrosecond);
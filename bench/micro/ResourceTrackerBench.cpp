@@ -0,0 +1,30 @@
+// Cost of reporting to the ResourceTracker, which every GPU allocation and
+// every tracked CPU allocation pays.
+#include "Benchmark.hpp"
+#include "ResourceTracker.hpp"
+
+static void BM_TrackUntrackGpu(benchmark::State &state) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  // Number of other live objects already in the tracker
+  for (int64_t i = 0; i < state.range(0); i++) {
+    tracker.TrackGpu(GpuResourceKind::Buffer, 1000 + i, 64, 0, "bench");
+  }
+  for (auto _ : state) {
+    tracker.TrackGpu(GpuResourceKind::Buffer, 1, 1024, 0, "bench");
+    tracker.UntrackGpu(GpuResourceKind::Buffer, 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+  tracker.Reset();
+}
+BENCHMARK(BM_TrackUntrackGpu)->Arg(16)->Arg(1024);
+
+static void BM_TrackedAllocationSet(benchmark::State &state) {
+  TrackedAllocation allocation("bench");
+  size_t bytes = 0;
+  for (auto _ : state) {
+    allocation.Set(++bytes);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TrackedAllocationSet);
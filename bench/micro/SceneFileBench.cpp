@@ -0,0 +1,66 @@
+// Loading a scene of state.range(0) nodes: mapping and checking the binary
+// form against parsing the text form (see SceneFile.hpp).
+#include "Benchmark.hpp"
+#include "SceneFile.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+
+// Chains of 100 nodes that share their shaders
+static SceneDescription MakeScene(size_t count) {
+  SceneDescription scene;
+  scene.nodes.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    SceneNodeDesc &node = scene.nodes[i];
+    node.name = "node" + std::to_string(i);
+    node.parent = i % 100 == 0 ? -1 : static_cast<int>(i) - 1;
+    node.vertexShader = "./shaders/vert.glsl";
+    node.fragmentShader = "./shaders/frag.glsl";
+    node.translation = glm::vec3(static_cast<float>(i % 512), 0.0f,
+                                 static_cast<float>(i / 512));
+    node.rotation = glm::vec3(0.0f, static_cast<float>(i % 360), 0.0f);
+  }
+  return scene;
+}
+
+static std::string TempScenePath() {
+  return (std::filesystem::temp_directory_path() /
+          ("cs5310_bench_" +
+           std::to_string(
+               std::chrono::steady_clock::now().time_since_epoch().count()) +
+           ".bscene"))
+      .string();
+}
+
+static void BM_OpenBinaryScene(benchmark::State &state) {
+  SceneDescription scene = MakeScene(static_cast<size_t>(state.range(0)));
+  std::string path = TempScenePath();
+  if (!WriteSceneFile(path, scene)) {
+    state.SkipWithError("could not write the scene");
+    return;
+  }
+  SceneFile file;
+  for (auto _ : state) {
+    file.Open(path);
+    benchmark::DoNotOptimize(file.GetNodeCount());
+    file.Close();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  std::error_code code;
+  std::filesystem::remove(path, code);
+}
+BENCHMARK(BM_OpenBinaryScene)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_ParseSceneText(benchmark::State &state) {
+  std::string text =
+      WriteSceneText(MakeScene(static_cast<size_t>(state.range(0))));
+  SceneDescription scene;
+  for (auto _ : state) {
+    ParseSceneText(text.data(), text.size(), scene);
+    benchmark::DoNotOptimize(scene.nodes.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_ParseSceneText)->Arg(100000)->Unit(benchmark::kMillisecond);
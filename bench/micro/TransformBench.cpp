@@ -0,0 +1,85 @@
+// Matrix work done every frame: Assignment10_fbo's Transform composition
+// (what the scene graph does per node) and frustum culling of bounding
+// boxes.
+#include "Benchmark.hpp"
+#include "Frustum.hpp"
+#include "Transform.hpp"
+
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+static void BM_TransformMultiply(benchmark::State &state) {
+  Transform parent, child;
+  parent.Translate(1.0f, 2.0f, 3.0f);
+  parent.Rotate(0.5f, 0.0f, 1.0f, 0.0f);
+  child.Scale(2.0f, 2.0f, 2.0f);
+  for (auto _ : state) {
+    Transform world = parent * child;
+    benchmark::DoNotOptimize(world);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TransformMultiply);
+
+// A parent chain of 'depth' nodes, composed from the root to the leaf
+static void BM_TransformChain(benchmark::State &state) {
+  std::vector<Transform> locals(state.range(0));
+  for (size_t i = 0; i < locals.size(); i++) {
+    locals[i].Translate(0.0f, 1.0f, 0.0f);
+    locals[i].Rotate(0.1f * i, 0.0f, 0.0f, 1.0f);
+  }
+  for (auto _ : state) {
+    Transform world;
+    for (const Transform &local : locals) {
+      world *= local;
+    }
+    benchmark::DoNotOptimize(world);
+  }
+  state.SetItemsProcessed(state.iterations() * locals.size());
+}
+BENCHMARK(BM_TransformChain)->Arg(8)->Arg(64);
+
+static void BM_TransformBuild(benchmark::State &state) {
+  for (auto _ : state) {
+    Transform transform;
+    transform.LoadIdentity();
+    transform.Translate(1.0f, 2.0f, 3.0f);
+    transform.Rotate(0.5f, 0.0f, 1.0f, 0.0f);
+    transform.Scale(2.0f, 2.0f, 2.0f);
+    benchmark::DoNotOptimize(transform);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TransformBuild);
+
+// Boxes scattered all around the camera, a few percent of them visible
+static void BM_FrustumCullAabbs(benchmark::State &state) {
+  std::vector<Aabb> boxes(state.range(0));
+  std::mt19937 random(5310);
+  std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+  for (Aabb &box : boxes) {
+    glm::vec3 center(position(random), position(random), position(random));
+    box.min = center - glm::vec3(1.0f);
+    box.max = center + glm::vec3(1.0f);
+  }
+  glm::mat4 projection =
+      glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 200.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+                               glm::vec3(0.0f, 1.0f, 0.0f));
+  Frustum frustum(projection * view);
+  std::vector<uint8_t> visible(boxes.size());
+  size_t visibleCount = 0;
+  for (auto _ : state) {
+    visibleCount =
+        CullAabbs(frustum, boxes.data(), boxes.size(), visible.data());
+    benchmark::DoNotOptimize(visibleCount);
+  }
+  state.SetItemsProcessed(state.iterations() * boxes.size());
+  state.SetLabel(std::to_string(visibleCount) + " visible");
+}
+BENCHMARK(BM_FrustumCullAabbs)
+    ->Arg(1024)
+    ->Arg(65536)
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,65 @@
+// Triangle orders of TriangleOrder.hpp (triangles/s) on real meshes, with
+// the simulated ACMR of the result (32 entry FIFO) in the label. Forsyth's
+// speed is in ForsythBench.cpp.
+#include "Benchmark.hpp"
+#include "BenchUtil.hpp"
+#include "ObjParser.hpp"
+#include "TriangleOrder.hpp"
+#include "VertexCache.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static void BM_TriangleOrder(benchmark::State &state, const std::string &path,
+                             TriangleOrder order) {
+  ObjData data;
+  if (!LoadObjFile(path, data)) {
+    state.SkipWithError("could not load the model");
+    return;
+  }
+  std::vector<uint32_t> indices;
+  indices.reserve(data.corners.size());
+  for (const ObjIndex &corner : data.corners) {
+    indices.push_back(static_cast<uint32_t>(corner.position));
+  }
+  PositionView positions{&data.positions[0].x, sizeof(data.positions[0])};
+  std::vector<uint32_t> reordered(indices.size());
+  for (auto _ : state) {
+    OrderTriangles(order, indices.data(), indices.size(), positions,
+                   reordered.data());
+    benchmark::ClobberMemory();
+  }
+  VertexCacheModel fifo32{VertexCacheKind::Fifo, 32};
+  VertexCacheStats stats = SimulateVertexCache(
+      reordered.data(), reordered.size(), data.positions.size(), fifo32);
+  char label[64];
+  std::snprintf(label, sizeof(label), "%zu triangles, ACMR %.3f",
+                data.GetTriangleCount(), stats.GetAcmr());
+  state.SetItemsProcessed(state.iterations() * data.GetTriangleCount());
+  state.SetLabel(label);
+}
+
+static bool RegisterTriangleOrderBenchmarks() {
+  const char *models[][2] = {
+      {"bunny", "common/objects/bunny_centered.obj"},
+      {"chapel", "common/objects/chapel/chapel_obj.obj"}};
+  const TriangleOrder orders[] = {TriangleOrder::Random, TriangleOrder::Morton,
+                                  TriangleOrder::Hilbert,
+                                  TriangleOrder::Adversarial};
+  for (const auto &model : models) {
+    std::string path = AssetPath(model[1]);
+    for (TriangleOrder order : orders) {
+      benchmark::RegisterBenchmark(std::string("BM_TriangleOrder/") +
+                                       TriangleOrderName(order) + "/" +
+                                       model[0],
+                                   [path, order](benchmark::State &state) {
+                                     BM_TriangleOrder(state, path, order);
+                                   })
+          ->Unit(benchmark::kMillisecond);
+    }
+  }
+  return true;
+}
+static bool triangleOrderBenchmarksRegistered =
+    RegisterTriangleOrderBenchmarks();
@@ -0,0 +1,74 @@
+# Compiler flags shared by every target: platform define, -march=native,
+# link time optimization and profile guided optimization.
+include(CheckCXXCompilerFlag)
+include(CheckIPOSupported)
+
+# The programs pick their SDL include path from one of these (see build.py)
+if(WIN32)
+  set(ENGINE_PLATFORM_DEFINE MINGW)
+elseif(APPLE)
+  set(ENGINE_PLATFORM_DEFINE MAC)
+else()
+  set(ENGINE_PLATFORM_DEFINE LINUX)
+endif()
+
+# -march=native: faster, but the binaries only run on this kind of CPU.
+if(ENGINE_NATIVE_ARCH)
+  check_cxx_compiler_flag(-march=native ENGINE_HAS_MARCH_NATIVE)
+  if(ENGINE_HAS_MARCH_NATIVE)
+    add_compile_options(-march=native)
+  else()
+    message(WARNING "ENGINE_NATIVE_ARCH: -march=native is not supported")
+  endif()
+endif()
+
+# Link time optimization for every target
+if(ENGINE_LTO)
+  check_ipo_supported(RESULT ENGINE_HAS_IPO OUTPUT ENGINE_IPO_ERROR)
+  if(ENGINE_HAS_IPO)
+    set(CMAKE_INTERPROCEDURAL_OPTIMIZATION ON)
+  else()
+    message(WARNING "ENGINE_LTO: not supported (${ENGINE_IPO_ERROR})")
+  endif()
+endif()
+
+# Profile guided optimization. Build with GENERATE, run the headless
+# benchmark, then rebuild the same build directory with USE. tools/pgo.py
+# does all three steps.
+string(TOUPPER "${ENGINE_PGO}" ENGINE_PGO)
+if(ENGINE_PGO STREQUAL "GENERATE")
+  file(MAKE_DIRECTORY ${ENGINE_PGO_DIR})
+  if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    add_compile_options(-fprofile-instr-generate=${ENGINE_PGO_DIR}/%p.profraw)
+    add_link_options(-fprofile-instr-generate=${ENGINE_PGO_DIR}/%p.profraw)
+  else()
+    add_compile_options(-fprofile-generate=${ENGINE_PGO_DIR}
+                        -fprofile-update=atomic)
+    add_link_options(-fprofile-generate=${ENGINE_PGO_DIR})
+  endif()
+elseif(ENGINE_PGO STREQUAL "USE")
+  if(CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+    # The .profraw files have to be merged first:
+    #   llvm-profdata merge -o <dir>/default.profdata <dir>/*.profraw
+    add_compile_options(-fprofile-instr-use=${ENGINE_PGO_DIR}/default.profdata
+                        -Wno-profile-instr-unprofiled)
+  else()
+    # Code that the benchmark never runs simply has no profile
+    add_compile_options(-fprofile-use=${ENGINE_PGO_DIR} -fprofile-correction
+                        -Wno-missing-profile)
+  endif()
+elseif(NOT ENGINE_PGO STREQUAL "OFF")
+  message(FATAL_ERROR "ENGINE_PGO must be OFF, GENERATE or USE")
+endif()
+
+message(STATUS "Build type: ${CMAKE_BUILD_TYPE}, native: ${ENGINE_NATIVE_ARCH}"
+               ", LTO: ${ENGINE_LTO}, PGO: ${ENGINE_PGO}, SIMD: ${ENGINE_SIMD}")
+
+# Warnings for the code we own (the programs keep their original flags)
+function(engine_set_warnings target)
+  if(MSVC)
+    target_compile_options(${target} PRIVATE /W4)
+  else()
+    target_compile_options(${target} PRIVATE -Wall -Wextra)
+  endif()
+endfunction()
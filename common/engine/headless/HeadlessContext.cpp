@@ -0,0 +1,152 @@
+#include "HeadlessContext.hpp"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+
+#include <sstream>
+
+HeadlessContext::HeadlessContext() {}
+
+HeadlessContext::~HeadlessContext() { Destroy(); }
+
+void *HeadlessContext::GetProcAddress(const char *name) {
+  return reinterpret_cast<void *>(eglGetProcAddress(name));
+}
+
+bool HeadlessContext::Create(int major, int minor) {
+  Destroy();
+
+  // Prefer the surfaceless platform (no X11/Wayland needed)
+  EGLDisplay display = EGL_NO_DISPLAY;
+  auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT"));
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+  if (getPlatformDisplay != nullptr) {
+    display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                                 EGL_DEFAULT_DISPLAY, nullptr);
+  }
+#endif
+  if (display == EGL_NO_DISPLAY) {
+    display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+  EGLint eglMajor = 0, eglMinor = 0;
+  if (display == EGL_NO_DISPLAY ||
+      !eglInitialize(display, &eglMajor, &eglMinor)) {
+    m_error = "could not initialize an EGL display";
+    return false;
+  }
+  m_display = display;
+
+  if (!eglBindAPI(EGL_OPENGL_API)) {
+    m_error = "EGL has no desktop OpenGL support";
+    Destroy();
+    return false;
+  }
+
+  // No surface at all: everything is drawn into framebuffer objects
+  const EGLint attributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                               major,
+                               EGL_CONTEXT_MINOR_VERSION,
+                               minor,
+                               EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                               EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                               EGL_NONE};
+  EGLContext context = eglCreateContext(display, EGL_NO_CONFIG_KHR,
+                                        EGL_NO_CONTEXT, attributes);
+  if (context == EGL_NO_CONTEXT) {
+    std::ostringstream message;
+    message << "could not create an OpenGL " << major << "." << minor
+            << " core context (EGL error 0x" << std::hex << eglGetError()
+            << ")";
+    m_error = message.str();
+    Destroy();
+    return false;
+  }
+  m_context = context;
+
+  if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+    m_error = "could not make the context current (surfaceless contexts "
+              "are not supported)";
+    Destroy();
+    return false;
+  }
+  if (!gladLoadGLLoader(GetProcAddress)) {
+    m_error = "glad did not initialize";
+    Destroy();
+    return false;
+  }
+  m_error.clear();
+  return true;
+}
+
+void HeadlessContext::Destroy() {
+  EGLDisplay display = static_cast<EGLDisplay>(m_display);
+  if (display == nullptr) {
+    return;
+  }
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (m_sharedContext != nullptr) {
+    eglDestroyContext(display, static_cast<EGLContext>(m_sharedContext));
+    m_sharedContext = nullptr;
+  }
+  if (m_context != nullptr) {
+    eglDestroyContext(display, static_cast<EGLContext>(m_context));
+    m_context = nullptr;
+  }
+  eglTerminate(display);
+  m_display = nullptr;
+}
+
+static void SetSharedFunctions(EGLDisplay display, void *sharedContext,
+                               SharedContext &shared) {
+  EGLContext context = static_cast<EGLContext>(sharedContext);
+  // The bound API is per thread
+  shared.makeCurrent = [display, context]() {
+    return eglBindAPI(EGL_OPENGL_API) &&
+           eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+  };
+  shared.doneCurrent = [display]() {
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglReleaseThread();
+  };
+}
+
+bool HeadlessContext::CreateSharedContext(SharedContext &shared) {
+  if (!IsValid()) {
+    return false;
+  }
+  EGLDisplay display = static_cast<EGLDisplay>(m_display);
+  if (m_sharedContext != nullptr) {
+    SetSharedFunctions(display, m_sharedContext, shared);
+    return true;
+  }
+  // Same version as the main context
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  const EGLint attributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                               major,
+                               EGL_CONTEXT_MINOR_VERSION,
+                               minor,
+                               EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                               EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                               EGL_NONE};
+  EGLContext context =
+      eglCreateContext(display, EGL_NO_CONFIG_KHR,
+                       static_cast<EGLContext>(m_context), attributes);
+  if (context == EGL_NO_CONTEXT) {
+    return false;
+  }
+  m_sharedContext = context;
+  SetSharedFunctions(display, context, shared);
+  return true;
+}
+
+std::string HeadlessContext::GetRenderer() const {
+  if (!IsValid()) {
+    return "";
+  }
+  const GLubyte *renderer = glGetString(GL_RENDERER);
+  return renderer != nullptr ? reinterpret_cast<const char *>(renderer) : "";
+}
@@ -0,0 +1,55 @@
+/** @file HeadlessContext.hpp
+ *  @brief An OpenGL context without a window, for tests and benchmarks.
+ *
+ *  Uses EGL (surfaceless when the driver supports it), so it runs on build
+ *  machines and in CI where there is no display. Nothing is presented:
+ *  render into a framebuffer object and read the pixels back if needed.
+ *  Lives outside of common/engine/src so that the programs built with
+ *  build.py do not have to link against EGL.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef HEADLESS_CONTEXT_HPP
+#define HEADLESS_CONTEXT_HPP
+
+#include "GpuUploader.hpp"
+
+#include <string>
+
+class HeadlessContext {
+public:
+  HeadlessContext();
+  ~HeadlessContext();
+  HeadlessContext(const HeadlessContext &) = delete;
+  HeadlessContext &operator=(const HeadlessContext &) = delete;
+
+  // Creates a core profile context of (at least) the requested version,
+  // makes it current and loads the OpenGL functions with glad.
+  // Returns false (see GetError()) if that is not possible on this machine.
+  bool Create(int major = 3, int minor = 3);
+  // Releases the context (and the shared one)
+  void Destroy();
+  // Creates a second context that shares objects with this one, for
+  // GpuUploader. It is made current on the thread that calls makeCurrent.
+  // There is one: calling this again returns the same context, which only
+  // one thread at a time can use. Returns false if there is no context or
+  // EGL refuses.
+  bool CreateSharedContext(SharedContext &shared);
+  // True after a successful Create()
+  bool IsValid() const { return m_context != nullptr; }
+  // Why Create() failed
+  const std::string &GetError() const { return m_error; }
+  // The GL_RENDERER string, e.g. to tag benchmark results
+  std::string GetRenderer() const;
+  // Loader for OpenGL functions (what glad was given), e.g. for
+  // GLDebug::Install
+  static void *GetProcAddress(const char *name);
+
+private:
+  void *m_display{nullptr};
+  void *m_context{nullptr};
+  void *m_sharedContext{nullptr};
+  std::string m_error;
+};
+
+#endif
@@ -0,0 +1,169 @@
+/** @file AssetArchive.hpp
+ *  @brief One memory-mapped file with every model and texture, cooked.
+ *
+ *  The programs load loose files: an .obj, its .mtl and each .ppm, all
+ *  text (the PPMs alone are most of common/). tools/AssetCook.cpp cooks
+ *  them once into an archive (see AssetCooker.hpp): meshes are stored as
+ *  the parsed arrays, textures as RGB8 pixels, .mtl files as they are.
+ *
+ *  Layout, little endian:
+ *    ArchiveHeader
+ *    payloads, each at a multiple of kArchiveAlignment (a page) so a
+ *      texture can be handed to OpenGL, or prefetched, on its own pages
+ *    table of contents: ArchiveEntry[slotCount], an open addressing hash
+ *      table (linear probing) on the FNV-1a hash of the path
+ *    the paths, one after the other (not terminated)
+ *
+ *  Paths are relative to the directory the archive was cooked from (the
+ *  repository), with '/' separators. A program mounts the archive with
+ *  the directory it runs in relative to that one, and Find() turns the
+ *  program's own relative paths ("./../common/objects/...") into keys.
+ *
+ *  Mount() maps the file read only (see MappedFile.hpp) and checks the
+ *  whole table of contents, so a truncated or foreign file is refused up
+ *  front. Find() returns views into the mapping: nothing is
+ *  read until a page is touched, and Prefetch() asks the kernel to read
+ *  an entry ahead (madvise MADV_WILLNEED) before it is used.
+ *
+ *  Instance() is the archive the loaders look in (LoadObjFile(),
+ *  ReadFileToString() and both programs' Image::LoadPPM()). Without one
+ *  mounted they read the loose files as before.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef ASSET_ARCHIVE_HPP
+#define ASSET_ARCHIVE_HPP
+
+#include "MappedFile.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+struct ObjData;
+
+const uint32_t kArchiveVersion = 1;
+const size_t kArchiveAlignment = 4096;
+
+enum class AssetKind : uint32_t {
+  None = 0, // An empty slot of the table of contents
+  Raw,      // The file's bytes (.mtl)
+  Mesh,     // A parsed .obj, see CookedMeshHeader
+  Texture,  // RGB8 pixels, rows bottom up as Image::LoadPPM(true) has them
+};
+
+// Printable name of a kind
+const char *AssetKindName(AssetKind kind);
+
+struct ArchiveHeader {
+  char magic[8]; // "CS5310AR"
+  uint32_t version;
+  uint32_t entryCount;
+  uint32_t slotCount; // A power of two, at least twice entryCount
+  uint32_t reserved;
+  uint64_t tocOffset;
+  uint64_t namesOffset;
+  uint64_t namesSize;
+  uint64_t fileSize;
+};
+
+struct ArchiveEntry {
+  uint64_t hash; // ArchivePathHash() of the path
+  uint64_t offset;
+  uint64_t size;
+  uint32_t nameOffset; // In the path block
+  uint32_t nameLength;
+  AssetKind kind;
+  uint32_t width; // Textures only
+  uint32_t height;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(ArchiveHeader) == 56, "the header is part of the format");
+static_assert(sizeof(ArchiveEntry) == 48, "entries are part of the format");
+
+// A cooked mesh starts with this; the arrays follow, each 16 byte aligned,
+// in the order of the counts: positions (3 floats), texture coordinates (2
+// floats), normals (3 floats), corners (ObjIndex, 3 ints) and the name of
+// the material library.
+struct CookedMeshHeader {
+  uint32_t positions;
+  uint32_t texCoords;
+  uint32_t normals;
+  uint32_t corners;
+  uint32_t materialLibraryLength;
+  uint32_t reserved[3];
+};
+
+// Part of the mapping; valid while the archive stays mounted
+struct AssetView {
+  const uint8_t *data{nullptr};
+  size_t size{0};
+  AssetKind kind{AssetKind::None};
+  uint32_t width{0};
+  uint32_t height{0};
+
+  bool IsValid() const { return data != nullptr; }
+};
+
+// FNV-1a of a (normalized) path
+uint64_t ArchivePathHash(const std::string &path);
+// Lexically normal, '/' separated and without a leading "./"
+std::string NormalizeAssetPath(const std::string &path);
+
+// Fills 'out' from a cooked mesh (a copy: ObjData owns its arrays). Returns
+// false if the view is not a well formed mesh.
+bool ReadCookedMesh(const AssetView &view, ObjData &out);
+
+class AssetArchive {
+public:
+  AssetArchive();
+  ~AssetArchive();
+  AssetArchive(const AssetArchive &) = delete;
+  AssetArchive &operator=(const AssetArchive &) = delete;
+
+  // The archive the loaders use
+  static AssetArchive &Instance();
+
+  // Maps 'path'. 'mountPoint' is the program's working directory relative
+  // to the directory the archive was cooked from (e.g. "part1"). Returns
+  // false (see GetError()) if the file is missing or malformed.
+  bool Mount(const std::string &path, const std::string &mountPoint);
+  // Mounts ENGINE_ASSETS if it is set ("off" mounts nothing), otherwise
+  // 'defaultPath' if that file exists. Returns whether one was mounted.
+  bool MountFromEnvironment(const std::string &defaultPath,
+                            const std::string &mountPoint);
+  void Unmount();
+  bool IsMounted() const { return m_file.IsOpen(); }
+  const std::string &GetError() const { return m_error; }
+  const std::string &GetPath() const { return m_path; }
+
+  // The entry for a path relative to the working directory (or an invalid
+  // view). Never touches the payload.
+  AssetView Find(const std::string &path) const;
+  // Same, with a key as it is stored
+  AssetView FindKey(const std::string &key) const;
+  // Asks the kernel to read the view's pages now (they are read on first
+  // use otherwise)
+  void Prefetch(const AssetView &view) const;
+
+  uint32_t GetEntryCount() const;
+  // A slot of the table of contents, false if it is empty (for listing)
+  bool GetEntry(uint32_t slot, std::string &key, AssetView &view) const;
+  uint32_t GetSlotCount() const;
+  size_t GetSize() const { return m_file.GetSize(); }
+
+private:
+  bool Validate();
+  AssetView MakeView(const ArchiveEntry &entry) const;
+
+  MappedFile m_file;
+  const ArchiveHeader *m_header{nullptr};
+  const ArchiveEntry *m_entries{nullptr};
+  const char *m_names{nullptr};
+  std::string m_mountPoint;
+  std::string m_path;
+  std::string m_error;
+};
+
+#endif
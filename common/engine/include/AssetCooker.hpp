@@ -0,0 +1,89 @@
+/** @file AssetCooker.hpp
+ *  @brief Writes asset archives (see AssetArchive.hpp).
+ *
+ *  CookAssets() walks directories for .obj, .mtl and .ppm files and turns
+ *  them into archive entries: .obj files are parsed (ObjParser.hpp) and
+ *  stored as arrays, .ppm files become RGB8 pixels in the order the
+ *  programs use them (Image::LoadPPM(true) reverses the pixel order), .mtl
+ *  files are copied. Anything else is skipped.
+ *
+ *  AssetArchiveWriter streams the payloads to the file as they are added
+ *  and only keeps the table of contents in memory, so cooking all of
+ *  common/ needs little more memory than its largest file.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef ASSET_COOKER_HPP
+#define ASSET_COOKER_HPP
+
+#include "AssetArchive.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct ObjData;
+
+// Parses a plain (P3) PPM: header, then three values per pixel. 'flip'
+// reverses the pixel order like Image::LoadPPM(true). Returns false and
+// describes the problem in 'error' (if given) for anything else.
+bool ParsePpm(const char *text, size_t length, bool flip, uint32_t &width,
+              uint32_t &height, std::vector<uint8_t> &pixels,
+              std::string *error = nullptr);
+
+// The payload of a cooked mesh (see CookedMeshHeader)
+void CookMesh(const ObjData &data, std::vector<uint8_t> &out);
+
+class AssetArchiveWriter {
+public:
+  AssetArchiveWriter() {}
+  // An unfinished archive is removed
+  ~AssetArchiveWriter();
+  AssetArchiveWriter(const AssetArchiveWriter &) = delete;
+  AssetArchiveWriter &operator=(const AssetArchiveWriter &) = delete;
+
+  bool Open(const std::string &path, std::string *error = nullptr);
+  // Writes one payload. 'key' is normalized (NormalizeAssetPath()); a key
+  // that is already in the archive is refused.
+  bool Add(const std::string &key, AssetKind kind, const uint8_t *data,
+           size_t size, uint32_t width = 0, uint32_t height = 0);
+  // Writes the table of contents and the header. Returns the archive size
+  // (0 on failure).
+  size_t Finish(std::string *error = nullptr);
+  size_t GetEntryCount() const { return m_entries.size(); }
+
+private:
+  struct Pending {
+    std::string key;
+    ArchiveEntry entry;
+  };
+  bool Pad(size_t alignment);
+
+  std::ofstream m_file;
+  std::string m_path;
+  uint64_t m_offset{0};
+  std::vector<Pending> m_entries;
+};
+
+struct CookStats {
+  size_t meshes{0};
+  size_t textures{0};
+  size_t raw{0};
+  size_t skipped{0}; // Unknown extensions and files that did not parse
+  uint64_t inputBytes{0};
+  uint64_t outputBytes{0};
+};
+
+// Cooks every file under 'directories' (relative to 'root') into 'output'.
+// Keys are the paths relative to 'root'. Problems with single files are
+// written to 'log' (if given) and the file is skipped; returns false only
+// if the archive could not be written.
+bool CookAssets(const std::string &root,
+                const std::vector<std::string> &directories,
+                const std::string &output, CookStats &stats,
+                std::ostream *log = nullptr, std::string *error = nullptr);
+
+#endif
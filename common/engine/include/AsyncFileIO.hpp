@@ -0,0 +1,130 @@
+/** @file AsyncFileIO.hpp
+ *  @brief Reads many files (or ranges of them) at once, asynchronously.
+ *
+ *  Loading a model the plain way opens its textures one after the other
+ *  and reads each with small blocking reads, so with a cold page cache the
+ *  disk sits idle between requests. AsyncFileReader keeps many large reads
+ *  in flight instead: Read() queues a file and returns, the callback runs
+ *  on a worker thread with the whole file once it is in memory (that is
+ *  where the file should be parsed), and Wait() returns when everything
+ *  queued so far is done. ReadRange() reads only part of a file the same
+ *  way, e.g. a page of a virtual texture (see VirtualTexture.hpp).
+ *
+ *  On Linux it uses io_uring, set up with the raw system calls (no
+ *  liburing). One thread owns the ring: it opens the files, cuts them into
+ *  chunks and keeps the submission queue full of reads into staging
+ *  buffers that are registered with the kernel once (IORING_OP_READ_FIXED,
+ *  so the pages are not pinned again for every read), then copies each
+ *  finished chunk into its file. If the buffers cannot be registered
+ *  (RLIMIT_MEMLOCK) it reads straight into the files with IORING_OP_READ.
+ *
+ *  Where io_uring is missing or not allowed (old kernels, seccomp filters,
+ *  other systems) the worker threads read the files with large blocking
+ *  reads instead, several at a time. ENGINE_ASYNC_IO=threads forces that.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef ASYNC_FILE_IO_HPP
+#define ASYNC_FILE_IO_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class AsyncIoBackend {
+  IoUring,
+  Threads,
+};
+
+// Printable name of a backend
+const char *AsyncIoBackendName(AsyncIoBackend backend);
+
+struct FileReadResult {
+  std::string path;
+  std::string data; // The file or range; the callback may move it away
+  bool ok{false};
+  std::string error;
+};
+
+// Runs on a worker thread
+using FileReadCallback = std::function<void(FileReadResult &result)>;
+
+struct AsyncIoOptions {
+  AsyncIoBackend backend{AsyncIoBackend::IoUring}; // Falls back to Threads
+  unsigned queueDepth{32};       // Reads in flight (io_uring)
+  size_t chunkBytes{128 * 1024}; // Largest single read, a multiple of 4096
+  unsigned workers{0};           // Callback threads, 0 for a few
+};
+
+struct AsyncIoStats {
+  uint64_t files{0};       // Finished, including failures
+  uint64_t failed{0};
+  uint64_t bytes{0};
+  uint64_t reads{0};       // Read requests issued
+  uint64_t submits{0};     // io_uring_enter() calls, or blocking reads
+  uint32_t maxInFlight{0}; // Most reads the kernel had at once
+};
+
+class AsyncFileReader {
+public:
+  explicit AsyncFileReader(const AsyncIoOptions &options = AsyncIoOptions());
+  // Wait()s
+  ~AsyncFileReader();
+  AsyncFileReader(const AsyncFileReader &) = delete;
+  AsyncFileReader &operator=(const AsyncFileReader &) = delete;
+
+  // Shared by the loaders, started on first use
+  static AsyncFileReader &Instance();
+
+  // The backend in use (Threads if io_uring could not be set up)
+  AsyncIoBackend GetBackend() const { return m_backend; }
+  // Queues a file (any thread). 'done' also runs if it cannot be read.
+  void Read(const std::string &path, FileReadCallback done);
+  // Queues 'length' bytes of a file from 'offset' on (any thread). The
+  // read fails if the file ends before the range does.
+  void ReadRange(const std::string &path, uint64_t offset, uint64_t length,
+                 FileReadCallback done);
+  // Returns when every file queued so far is read and its callback has
+  // returned. Not to be called from a callback.
+  void Wait();
+  AsyncIoStats GetStats() const;
+
+private:
+  struct File;
+  struct Ring;
+
+  // Hands a request to the ring thread or a worker
+  void Queue(std::unique_ptr<File> file);
+  void RingMain();
+  void WorkerMain();
+  // Runs a task on a worker
+  void Post(std::function<void()> task);
+  // Reads a file on the calling worker (Threads backend)
+  void ReadBlocking(File &file);
+  // Hands a finished file to its callback
+  void Complete(std::unique_ptr<File> file);
+
+  AsyncIoOptions m_options;
+  AsyncIoBackend m_backend{AsyncIoBackend::Threads};
+  std::unique_ptr<Ring> m_ring;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;     // Work for the ring or the workers
+  std::condition_variable m_finished; // m_outstanding went down
+  std::deque<std::unique_ptr<File>> m_requests; // For the ring thread
+  std::deque<std::function<void()>> m_tasks;     // For the workers
+  size_t m_outstanding{0}; // Read() calls whose callback has not returned
+  bool m_stop{false};
+  AsyncIoStats m_stats;
+  std::thread m_ringThread;
+  std::vector<std::thread> m_workers;
+};
+
+#endif
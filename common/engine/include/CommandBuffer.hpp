@@ -0,0 +1,151 @@
+/** @file CommandBuffer.hpp
+ *  @brief Draw commands recorded on worker threads, replayed on the GL thread.
+ *
+ *  Only the thread that owns the context may call OpenGL, but working out
+ *  what to draw (walking the scene, computing matrices, picking programs and
+ *  textures) does not need the context. Worker jobs record compact 16 byte
+ *  commands into one CommandBuffer each; the GL thread then replays all of
+ *  them with one tight loop.
+ *
+ *  Uniform data is not set with glUniform* calls: SetUniformBlock() copies
+ *  it into the buffer's own arena and the replay uploads all arenas into one
+ *  uniform buffer per frame, binding a range of it per command. The shaders
+ *  therefore read per-draw data from std140 uniform blocks.
+ *
+ *  RecordCommands() gives chunk i of the work to buffer i, so the replay
+ *  order is the same no matter how many threads recorded it or which one
+ *  finished first.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef COMMANDBUFFER_HPP
+#define COMMANDBUFFER_HPP
+
+#include "Parallel.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// ============================== Recording ================================== //
+enum class CommandType : uint8_t {
+  BindProgram,     // a = program
+  BindVertexArray, // a = vertex array
+  BindTexture,     // slot = texture unit, a = GL_TEXTURE_2D texture
+  UniformBlock,    // slot = binding point, a = arena offset, b = bytes
+  DrawIndexed,     // a = mode, b = count, c = byte offset (uint32 indices)
+  DrawArrays,      // a = mode, b = first vertex, c = vertex count
+  Instances        // a = instances of each following draw
+};
+
+struct Command {
+  CommandType type;
+  uint8_t slot;
+  uint16_t padding;
+  uint32_t a;
+  uint32_t b;
+  uint32_t c;
+};
+static_assert(sizeof(Command) == 16, "commands are 16 bytes");
+
+class CommandBuffer {
+public:
+  // Every uniform block starts at a multiple of this. 256 is the largest
+  // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT the spec allows, so it works
+  // everywhere without asking the driver (which needs the GL thread).
+  static const size_t kUniformAlignment = 256;
+  // Texture units the replay keeps track of
+  static const unsigned kTextureUnits = 16;
+
+  // Keeps the memory, so recording the next frame does not allocate
+  void Clear() {
+    m_commands.clear();
+    m_uniforms.clear();
+  }
+
+  void BindProgram(GLuint program) {
+    Push(CommandType::BindProgram, 0, program);
+  }
+  void BindVertexArray(GLuint vertexArray) {
+    Push(CommandType::BindVertexArray, 0, vertexArray);
+  }
+  // unit < kTextureUnits
+  void BindTexture(unsigned unit, GLuint texture) {
+    Push(CommandType::BindTexture, static_cast<uint8_t>(unit), texture);
+  }
+  // Copies 'bytes' of std140 data; it is bound to uniform buffer binding
+  // point 'binding' for the draws that follow
+  void SetUniformBlock(unsigned binding, const void *data, size_t bytes);
+  void DrawIndexed(GLenum mode, size_t count, size_t byteOffset = 0) {
+    Push(CommandType::DrawIndexed, 0, mode, static_cast<uint32_t>(count),
+         static_cast<uint32_t>(byteOffset));
+  }
+  void DrawArrays(GLenum mode, size_t first, size_t count) {
+    Push(CommandType::DrawArrays, 0, mode, static_cast<uint32_t>(first),
+         static_cast<uint32_t>(count));
+  }
+  // The draws that follow in this buffer are instanced 'instances' times
+  // (gl_InstanceID). Every buffer starts at 1.
+  void SetInstances(size_t instances) {
+    Push(CommandType::Instances, 0, static_cast<uint32_t>(instances));
+  }
+
+  const std::vector<Command> &GetCommands() const { return m_commands; }
+  // A multiple of kUniformAlignment
+  const std::vector<uint8_t> &GetUniformData() const { return m_uniforms; }
+
+private:
+  void Push(CommandType type, uint8_t slot, uint32_t a, uint32_t b = 0,
+            uint32_t c = 0) {
+    m_commands.push_back(Command{type, slot, 0, a, b, c});
+  }
+
+  std::vector<Command> m_commands;
+  std::vector<uint8_t> m_uniforms;
+};
+
+// Records 'count' items in chunks of 'grain' on the pool: the chunk that
+// starts at item i * grain goes into buffers[i] (cleared first). 'buffers'
+// is resized to the number of chunks.
+void RecordCommands(
+    WorkerPool &workers, size_t count, size_t grain,
+    std::vector<CommandBuffer> &buffers,
+    const std::function<void(size_t begin, size_t end, CommandBuffer &out)>
+        &record);
+
+// ============================== Replay ===================================== //
+struct ReplayStats {
+  size_t commands{0};
+  size_t draws{0};
+  size_t skippedBinds{0}; // Binds of what was already bound
+  size_t uniformBytes{0}; // Uploaded this frame
+};
+
+class CommandReplayer {
+public:
+  CommandReplayer() {}
+  ~CommandReplayer();
+  CommandReplayer(const CommandReplayer &) = delete;
+  CommandReplayer &operator=(const CommandReplayer &) = delete;
+
+  // Creates the uniform buffer (needs a current context)
+  bool Create();
+  void Release();
+  bool IsCreated() const { return m_uniformBuffer != 0; }
+
+  // Executes the buffers in order. Binds through GLState and leaves the
+  // last program, vertex array and textures bound.
+  void Replay(const CommandBuffer *buffers, size_t count);
+  const ReplayStats &GetLastStats() const { return m_stats; }
+
+private:
+  GLuint m_uniformBuffer{0};
+  size_t m_uniformCapacity{0};
+  std::vector<size_t> m_bases; // Where each buffer's arena was uploaded
+  ReplayStats m_stats;
+};
+
+#endif
@@ -0,0 +1,209 @@
+/** @file ComponentStore.hpp
+ *  @brief What a scene draws as dense columns of components, grouped by
+ *         which components each entity has.
+ *
+ *  An entity is a handle (an index and a generation, so a handle to a
+ *  destroyed entity is told apart from the one reusing its slot) to a row
+ *  of an Archetype: the store keeps one archetype per set of components
+ *  (a ComponentMask) and every entity with exactly that set is a row of
+ *  it. Each component is a column of the archetype, so a system that only
+ *  needs the bounds reads one array of spheres from start to end instead
+ *  of following a pointer per object to a node that holds everything.
+ *
+ *  The components of something to draw:
+ *    transform  its world matrix
+ *    mesh       an index into the program's table of meshes; the levels
+ *               of detail of a mesh are the indices that follow it
+ *    material   an index into the program's table of materials
+ *    bounds     a sphere around the mesh in object space, and the same
+ *               sphere in world space (see UpdateWorldBounds())
+ *    lod        how far away each level of detail starts, and the level
+ *               SelectLods() picked
+ *    static     no data: the entity never moves, so cached shadow
+ *               cascades can keep it (see ShadowCascades.hpp)
+ *
+ *  Destroying an entity moves the last row of its archetype into its
+ *  place, and changing its components (SetMask()) moves it to another
+ *  archetype, so rows are not stable; handles are.
+ *
+ *  The systems below run over the archetypes that have what they need:
+ *  UpdateWorldBounds(), SelectLods(), and CullRenderables(), which only
+ *  reads the world spheres and lists the rows a frustum sees for a
+ *  submission loop to read the other columns of.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef COMPONENT_STORE_HPP
+#define COMPONENT_STORE_HPP
+
+#include "MultiView.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+typedef uint32_t ComponentMask;
+const ComponentMask kTransformComponent = 1u << 0;
+const ComponentMask kMeshComponent = 1u << 1;
+const ComponentMask kMaterialComponent = 1u << 2;
+const ComponentMask kBoundsComponent = 1u << 3;
+const ComponentMask kLodComponent = 1u << 4;
+const ComponentMask kStaticTag = 1u << 5;
+const ComponentMask kAllComponents = (1u << 6) - 1u;
+// What CullRenderables() needs to list an entity
+const ComponentMask kRenderableComponents = kTransformComponent |
+                                            kMeshComponent |
+                                            kMaterialComponent |
+                                            kBoundsComponent;
+
+struct Entity {
+  uint32_t index{0xFFFFFFFFu};
+  uint32_t generation{0};
+
+  bool IsValid() const { return index != 0xFFFFFFFFu; }
+  bool operator==(const Entity &other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const Entity &other) const { return !(*this == other); }
+};
+
+struct LodState {
+  // Level 1 starts this far from the camera, every next level twice as far
+  float firstDistance{64.0f};
+  uint32_t levelCount{1};
+  // Picked by SelectLods()
+  uint32_t level{0};
+};
+
+class Archetype {
+public:
+  explicit Archetype(ComponentMask mask) : m_mask(mask) {}
+
+  ComponentMask GetMask() const { return m_mask; }
+  // True if it has every one of 'components'
+  bool Has(ComponentMask components) const {
+    return (m_mask & components) == components;
+  }
+  size_t GetSize() const { return m_entities.size(); }
+  const Entity *GetEntities() const { return m_entities.data(); }
+
+  // The columns, GetSize() long; empty for components it does not have
+  glm::mat4 *GetTransforms() { return m_transforms.data(); }
+  const glm::mat4 *GetTransforms() const { return m_transforms.data(); }
+  const uint32_t *GetMeshes() const { return m_meshes.data(); }
+  const uint32_t *GetMaterials() const { return m_materials.data(); }
+  // Object space spheres: center (xyz) and radius (w), negative if unknown
+  const glm::vec4 *GetLocalBounds() const { return m_localBounds.data(); }
+  glm::vec4 *GetWorldBounds() { return m_worldBounds.data(); }
+  const glm::vec4 *GetWorldBounds() const { return m_worldBounds.data(); }
+  LodState *GetLods() { return m_lods.data(); }
+  const LodState *GetLods() const { return m_lods.data(); }
+
+private:
+  friend class ComponentStore;
+
+  // Adds a row with default components and returns it
+  size_t Append(Entity entity);
+  // Moves the last row into 'row' and returns the entity that moved
+  // (invalid if 'row' was the last one)
+  Entity Remove(size_t row);
+  // Copies the components both archetypes have
+  void CopyRow(size_t row, const Archetype &from, size_t fromRow);
+
+  ComponentMask m_mask;
+  std::vector<Entity> m_entities;
+  std::vector<glm::mat4> m_transforms;
+  std::vector<uint32_t> m_meshes;
+  std::vector<uint32_t> m_materials;
+  std::vector<glm::vec4> m_localBounds;
+  std::vector<glm::vec4> m_worldBounds;
+  std::vector<LodState> m_lods;
+};
+
+class ComponentStore {
+public:
+  ComponentStore() {}
+  ComponentStore(const ComponentStore &) = delete;
+  ComponentStore &operator=(const ComponentStore &) = delete;
+
+  // A new entity with these components, set to their defaults (identity
+  // transform, mesh and material 0, unknown bounds, one level of detail)
+  Entity Create(ComponentMask mask);
+  // Does nothing if the entity is gone already
+  void Destroy(Entity entity);
+  bool IsAlive(Entity entity) const;
+  void Clear();
+  size_t GetEntityCount() const { return m_count; }
+
+  // Adds and removes components. Those it keeps keep their values.
+  void SetMask(Entity entity, ComponentMask mask);
+  // 0 if the entity is gone
+  ComponentMask GetMask(Entity entity) const;
+
+  // One entity's components, nullptr if it has not got that one (or is
+  // gone). Valid until entities are created, destroyed or change their
+  // components.
+  glm::mat4 *GetTransform(Entity entity);
+  uint32_t *GetMesh(Entity entity);
+  uint32_t *GetMaterial(Entity entity);
+  // The object space sphere; the world one follows with UpdateWorldBounds()
+  glm::vec4 *GetBounds(Entity entity);
+  LodState *GetLod(Entity entity);
+
+  // Archetypes are never removed, so their indices stay valid (until
+  // Clear())
+  size_t GetArchetypeCount() const { return m_archetypes.size(); }
+  Archetype &GetArchetype(size_t index) { return *m_archetypes[index]; }
+  const Archetype &GetArchetype(size_t index) const {
+    return *m_archetypes[index];
+  }
+
+private:
+  struct Location {
+    uint32_t archetype{0};
+    uint32_t row{0};
+    uint32_t generation{0};
+    bool alive{false};
+  };
+
+  const Location *Find(Entity entity) const;
+  // Makes one if there is none
+  uint32_t FindArchetype(ComponentMask mask);
+  // The column of 'component' at the entity's row, if it has one
+  template <typename T>
+  T *Column(Entity entity, ComponentMask component,
+            std::vector<T> Archetype::*column);
+
+  std::vector<std::unique_ptr<Archetype>> m_archetypes;
+  std::vector<Location> m_locations; // By entity index
+  std::vector<uint32_t> m_freeIndices;
+  size_t m_count{0};
+};
+
+// ============================== Systems =================================== //
+// The world sphere of every entity with a transform and bounds: the center
+// moved by the transform, the radius grown by its largest axis scale.
+// Unknown (negative) radii stay unknown.
+void UpdateWorldBounds(ComponentStore &store);
+
+// The level of detail of every entity with bounds and a lod, by how far
+// its world sphere is from the eye
+void SelectLods(ComponentStore &store, const glm::vec3 &eye);
+
+// A row of an archetype
+struct DrawRef {
+  uint32_t archetype;
+  uint32_t row;
+};
+
+// Appends every entity with kRenderableComponents and all of 'required'
+// (e.g. kStaticTag) whose world sphere one of the views sees, in archetype
+// then row order. Entities with unknown bounds are always listed.
+void CullRenderables(const ComponentStore &store,
+                     const MultiViewFrustum &frustum, ComponentMask required,
+                     std::vector<DrawRef> &visible);
+
+#endif
@@ -0,0 +1,135 @@
+/** @file DeferredShading.hpp
+ *  @brief Point lights as light volumes, and what forward and deferred
+ *         shading cost in framebuffer traffic.
+ *
+ *  Forward shading evaluates every light for every fragment the geometry
+ *  produces. Deferred shading first writes what lighting needs into a
+ *  G-buffer and then lights each pixel only for the lights that reach it,
+ *  so lighting scales with lit pixels instead of geometry x lights.
+ *
+ *  The G-buffer is kept small: albedo in RGBA8, the normal as an
+ *  octahedral direction (OctahedralEncode() in Impostor.hpp) in RG16, and
+ *  no position at all, since it can be rebuilt from the depth buffer and
+ *  the inverse view-projection matrix.
+ *
+ *  Each point light is drawn as the box around the sphere beyond which it
+ *  adds less than a cutoff (LightRange()). All lights are one instanced
+ *  draw that reads them from the 'Lights' block (LightsBlock) by
+ *  gl_InstanceID. Only the back faces are drawn, so every pixel is lit once
+ *  per light even with the camera inside the box.
+ *
+ *  GpuSampleCounter counts the samples each pass writes (GL_SAMPLES_PASSED)
+ *  without stalling, and EstimateShadingBandwidth() turns the counts into
+ *  the bytes both paths move through the framebuffer.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef DEFERRED_SHADING_HPP
+#define DEFERRED_SHADING_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Lights one 'Lights' block holds at most
+static const unsigned kMaxLights = 64;
+
+// A light with the attenuation 1 / (constant + linear d + quadratic d^2)
+struct PointLight {
+  glm::vec3 position{0.0f};
+  glm::vec3 color{1.0f};
+  float ambientIntensity{0.0f};
+  float specularStrength{0.5f};
+  float constant{1.0f};
+  float linear{0.0f};
+  float quadratic{0.0f};
+};
+
+// Distance at which the light's brightest channel, attenuated, falls to
+// 'cutoff'. Lights without linear or quadratic falloff reach 'maxRange'.
+float LightRange(const PointLight &light, float cutoff, float maxRange);
+
+// One light of the 'Lights' block (std140)
+struct LightVolume {
+  glm::vec4 positionRange;       // xyz: position, w: LightRange()
+  glm::vec4 colorAmbient;        // rgb: color, a: ambient intensity
+  glm::vec4 attenuationSpecular; // constant, linear, quadratic, specular
+};
+
+// The shaders' 'Lights' block (std140): the lights and the camera they are
+// seen from
+struct LightsBlock {
+  LightVolume lights[kMaxLights];
+  glm::mat4 viewProjection;        // For the light volumes
+  glm::mat4 inverseViewProjection; // Depth buffer back to world space
+  glm::vec4 eyePosition;
+  glm::ivec4 count; // x: lights in use
+};
+static_assert(sizeof(LightsBlock) == 48 * kMaxLights + 128 + 32,
+              "LightsBlock is std140");
+
+// Extra lights are dropped
+LightsBlock MakeLightsBlock(const PointLight *lights, size_t count,
+                            const glm::mat4 &viewProjection,
+                            const glm::vec3 &eyePosition, float cutoff,
+                            float maxRange);
+
+// Samples the passes of one frame wrote
+struct ShadingSamples {
+  uint64_t geometry{0};     // Scene samples that passed the depth test
+  uint64_t lightVolumes{0}; // Samples the light volumes lit
+  uint64_t screen{0};       // Pixels of the full screen passes
+  uint64_t lights{0};       // Lights in the scene
+};
+
+// Framebuffer bytes read and written (texture fetches of the materials
+// are the same for both paths and left out)
+struct ShadingBandwidth {
+  uint64_t forward{0};
+  uint64_t geometryPass{0}; // G-buffer writes and depth test
+  uint64_t lightPass{0};    // G-buffer reads and light accumulation
+  uint64_t resolvePass{0};  // G-buffer and light reads, color writes
+  uint64_t deferred{0};     // The three passes together
+  // Lights evaluated: every light for each scene sample when forward,
+  // once per lit sample when deferred
+  uint64_t forwardLighting{0};
+  uint64_t deferredLighting{0};
+};
+
+ShadingBandwidth EstimateShadingBandwidth(const ShadingSamples &samples);
+
+// Both paths side by side, one line each
+void PrintShadingReport(std::ostream &out, const ShadingSamples &samples);
+
+// GL_SAMPLES_PASSED between Begin() and End(), read a few frames later
+// like GpuTimer does. Begin/End pairs cannot be nested (with this or any
+// other GL_SAMPLES_PASSED query).
+class GpuSampleCounter {
+public:
+  GpuSampleCounter() {}
+  ~GpuSampleCounter();
+  GpuSampleCounter(const GpuSampleCounter &) = delete;
+  GpuSampleCounter &operator=(const GpuSampleCounter &) = delete;
+
+  // Creates the queries (needs a current context)
+  void Create();
+  void Release();
+  bool IsCreated() const { return m_queries[0] != 0; }
+
+  void Begin();
+  void End();
+  // Returns true and the newest count once at least one has finished
+  bool Poll(uint64_t &samples);
+
+private:
+  static const int kQueries = 4;
+  GLuint m_queries[kQueries] = {};
+  bool m_pending[kQueries] = {};
+  int m_next{0};
+  int m_running{-1};
+};
+
+#endif
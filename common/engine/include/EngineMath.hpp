@@ -0,0 +1,47 @@
+/** @file EngineMath.hpp
+ *  @brief glm configuration and the aligned math types used in hot loops.
+ *
+ *  glm's SIMD code is switched on for the whole build by the CMake option
+ *  ENGINE_SIMD (on by default), which defines GLM_FORCE_INTRINSICS for every
+ *  target. It is never switched on per file: glm's types have to be the
+ *  same in every translation unit. The build.py fallback leaves it off.
+ *
+ *  Even with SIMD on, the plain types (glm::vec3, glm::mat4, ...) keep their
+ *  tightly packed layout, so vertex data and uniforms are unaffected. Only
+ *  the aligned types below (16 byte aligned, vec3 padded to 16 bytes) use
+ *  the SIMD code paths. Use them for matrices that are multiplied often.
+ *  Without SIMD they are the plain types.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef ENGINE_MATH_HPP
+#define ENGINE_MATH_HPP
+
+#include <glm/glm.hpp>
+
+// 1 if glm uses SSE/NEON for the aligned types in this build
+#if GLM_CONFIG_SIMD == GLM_ENABLE
+#define ENGINE_MATH_SIMD 1
+#else
+#define ENGINE_MATH_SIMD 0
+#endif
+
+#if GLM_CONFIG_ALIGNED_GENTYPES == GLM_ENABLE
+#include <glm/gtc/type_aligned.hpp>
+typedef glm::aligned_vec3 SimdVec3;
+typedef glm::aligned_vec4 SimdVec4;
+typedef glm::aligned_mat4 SimdMat4;
+#else
+typedef glm::vec3 SimdVec3;
+typedef glm::vec4 SimdVec4;
+typedef glm::mat4 SimdMat4;
+#endif
+
+// Vertex layouts and glUniform* calls rely on these
+static_assert(sizeof(glm::vec2) == 2 * sizeof(float), "glm::vec2 is packed");
+static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 is packed");
+static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "glm::mat4 is packed");
+static_assert(sizeof(SimdMat4) == sizeof(glm::mat4),
+              "an aligned mat4 can be uploaded like a mat4");
+
+#endif
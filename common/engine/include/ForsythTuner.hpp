@@ -0,0 +1,79 @@
+/** @file ForsythTuner.hpp
+ *  @brief Finds Forsyth score function parameters for a vertex cache.
+ *
+ *  Forsyth's default parameters were chosen by hand for an LRU cache of
+ *  about 24 entries. TuneForsyth() searches the parameter space for the
+ *  values that give the lowest simulated ACMR (see VertexCache.hpp) on a
+ *  corpus of meshes for another cache: first a coarse grid over all five
+ *  parameters, then a local search around the best few points that halves
+ *  its steps until nothing improves. Candidates are evaluated in parallel.
+ *
+ *  tools/ForsythTune.cpp runs it over common/objects and prints the table
+ *  of presets below; OBJModel::setForsythParams() and part1's --forsyth
+ *  option use them.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FORSYTH_TUNER_HPP
+#define FORSYTH_TUNER_HPP
+
+#include "VertexCache.hpp"
+#include "forsyth.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A mesh indexed by position only, so vertices are shared like in a
+// welded mesh
+struct TuneMesh {
+  std::string name;
+  std::vector<uint32_t> indices;
+  size_t vertexCount{0};
+};
+
+// Loads an .obj file into a TuneMesh
+bool LoadTuneMesh(const std::string &path, TuneMesh &out,
+                  std::string *error = nullptr);
+
+// Mean ACMR over the meshes after reordering them with 'params' (every
+// mesh counts the same, whatever its size)
+double EvaluateForsyth(const std::vector<TuneMesh> &corpus,
+                       const ForsythParams &params,
+                       const VertexCacheModel &target);
+// Mean ACMR of the indices as they are
+double EvaluateUnoptimized(const std::vector<TuneMesh> &corpus,
+                           const VertexCacheModel &target);
+
+struct ForsythTuneOptions {
+  int gridSteps{3};    // Values per parameter in the coarse grid
+  int starts{3};       // Best grid points the local search starts from
+  int refineRounds{6}; // Times the local search may halve its steps
+  unsigned threads{0}; // 0: GetWorkerCount()
+};
+
+struct ForsythTuneResult {
+  ForsythParams params;
+  double acmr{0.0};        // With 'params'
+  double defaultAcmr{0.0}; // With forsythDefaultParams()
+  int evaluations{0};
+};
+
+ForsythTuneResult TuneForsyth(const std::vector<TuneMesh> &corpus,
+                              const VertexCacheModel &target,
+                              const ForsythTuneOptions &options = {});
+
+// Parameters tuned for a cache model (generated by tools/ForsythTune.cpp)
+struct ForsythPreset {
+  const char *name; // VertexCacheModelName() of the target
+  ForsythParams params;
+};
+
+// All presets; 'count' receives their number
+const ForsythPreset *GetForsythPresets(size_t &count);
+// "default" or a preset name. Returns false (and leaves 'out' alone) if
+// there is no such preset.
+bool FindForsythPreset(const std::string &name, ForsythParams &out);
+
+#endif
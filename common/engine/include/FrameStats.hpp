@@ -0,0 +1,109 @@
+/** @file FrameStats.hpp
+ *  @brief Per-frame rendering counters and a short history of frame times.
+ *
+ *  The draw paths report what they issue (draw calls and their triangles,
+ *  binds of programs, textures, vertex arrays and framebuffers) and the
+ *  program calls EndFrame() once per frame, after the swap. The counts of
+ *  the last complete frame and the frame / GPU times of the last
+ *  FrameHistory::kSize frames are what the PerfHud displays.
+ *
+ *  Like the ResourceTracker this does not call OpenGL, so it can be used
+ *  (and tested) without a context. GPU times come from a GpuTimer.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FRAME_STATS_HPP
+#define FRAME_STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+
+// What one frame issued
+struct FrameCounters {
+  unsigned int drawCalls{0};
+  size_t triangles{0};
+  unsigned int stateChanges{0}; // Program, texture, vertex array, ... binds
+  unsigned int filteredStateChanges{0}; // Redundant ones GLState skipped
+};
+
+// The last kSize samples of a value (in milliseconds), oldest first
+class FrameHistory {
+public:
+  static const size_t kSize = 128;
+
+  void Push(float value);
+  // Number of samples so far (at most kSize)
+  size_t GetCount() const { return m_count; }
+  // i = 0 is the oldest sample, GetCount() - 1 the newest
+  float Get(size_t i) const;
+  float GetLatest() const { return m_count == 0 ? 0.0f : Get(m_count - 1); }
+  float GetAverage() const;
+  float GetMax() const;
+  // Nearest rank percentile, e.g. 0.99 for the 99th (0 if empty)
+  float GetPercentile(float fraction) const;
+  void Clear();
+
+private:
+  float m_values[kSize] = {};
+  size_t m_next{0};
+  size_t m_count{0};
+};
+
+class FrameStats {
+public:
+  // There is one per program (and one OpenGL context).
+  static FrameStats &Instance();
+
+  // Called next to glDrawElements / glDrawArrays
+  void CountDraw(size_t triangles) {
+    m_current.drawCalls++;
+    m_current.triangles += triangles;
+  }
+  // Several draws at once (e.g. after replaying a command buffer)
+  void CountDraws(size_t draws, size_t triangles) {
+    m_current.drawCalls += draws;
+    m_current.triangles += triangles;
+  }
+  // Called next to glUseProgram, glBindTexture, glBindVertexArray, ...
+  void CountStateChange(unsigned int count = 1) {
+    m_current.stateChanges += count;
+  }
+  // Called by GLState for a call it did not pass on
+  void CountFilteredStateChange() { m_current.filteredStateChanges++; }
+
+  // Closes the current frame: its counters become GetLastFrame() and the
+  // time since the previous EndFrame() is added to the frame times.
+  void EndFrame();
+  // Same, with a frame time measured by the caller (e.g. in tests)
+  void EndFrame(float frameMilliseconds);
+  // The next frame time starts now. Called after the program slept while
+  // nothing changed (see RedrawScheduler), so the sleep is not a slow frame.
+  void DiscardIdleTime();
+  // Adds a GPU time (GpuTimer results arrive a few frames late)
+  void AddGpuTime(float milliseconds) { m_gpuTimes.Push(milliseconds); }
+
+  // The frame being recorded and the last complete one
+  const FrameCounters &GetCurrentFrame() const { return m_current; }
+  const FrameCounters &GetLastFrame() const { return m_last; }
+  const FrameHistory &GetFrameTimes() const { return m_frameTimes; }
+  const FrameHistory &GetGpuTimes() const { return m_gpuTimes; }
+  unsigned long GetFrameNumber() const { return m_frame; }
+
+  // Clears everything (e.g. between tests)
+  void Reset();
+
+private:
+  FrameStats() {}
+  FrameStats(const FrameStats &) = delete;
+  FrameStats &operator=(const FrameStats &) = delete;
+
+  FrameCounters m_current;
+  FrameCounters m_last;
+  FrameHistory m_frameTimes;
+  FrameHistory m_gpuTimes;
+  unsigned long m_frame{0};
+  bool m_hasLastEnd{false};
+  std::chrono::steady_clock::time_point m_lastEnd;
+};
+
+#endif
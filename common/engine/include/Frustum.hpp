@@ -0,0 +1,53 @@
+/** @file Frustum.hpp
+ *  @brief View frustum planes and visibility tests for bounding volumes.
+ *
+ *  The six planes are extracted from a (projection * view) matrix
+ *  (Gribb/Hartmann), so a frustum can be built for any camera without
+ *  knowing its field of view or aspect ratio. Plane normals point inside.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+// Axis aligned bounding box
+struct Aabb {
+  glm::vec3 min;
+  glm::vec3 max;
+};
+
+class Frustum {
+public:
+  enum Plane { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+  Frustum();
+  // Builds the planes of 'viewProjection' (projection * view)
+  explicit Frustum(const glm::mat4 &viewProjection);
+  void Set(const glm::mat4 &viewProjection);
+
+  // True if any part of the sphere may be inside
+  bool IntersectsSphere(const glm::vec3 &center, float radius) const;
+  // True if any part of the box may be inside. Conservative: boxes near a
+  // corner of the frustum can be reported visible although they are not.
+  bool IntersectsAabb(const Aabb &box) const;
+
+  // (normal.xyz, distance) with normalized normal
+  const glm::vec4 &GetPlane(Plane plane) const { return m_planes[plane]; }
+
+private:
+  glm::vec4 m_planes[PlaneCount];
+};
+
+// Tests 'count' boxes. visible[i] is set to 1 or 0; returns how many are
+// visible.
+size_t CullAabbs(const Frustum &frustum, const Aabb *boxes, size_t count,
+                 uint8_t *visible);
+
+#endif
@@ -0,0 +1,189 @@
+/** @file GLDebug.hpp
+ *  @brief OpenGL errors and performance warnings through KHR_debug.
+ *
+ *  Instead of asking for errors with glGetError around every call (each
+ *  call can stall until the driver has caught up), the driver reports
+ *  problems to a callback. In debug builds the callback is synchronous: the
+ *  driver calls it from inside the failing GL call, so the call site
+ *  recorded by GL_CHECK is exact. When the layer is kept in an optimized
+ *  build (-DENGINE_GL_DEBUG=1) the messages are delivered asynchronously.
+ *
+ *  Messages are counted per frame (errors, performance warnings such as
+ *  buffer migrations or shader recompiles, other warnings) and EndFrame()
+ *  prints a line for frames that had errors or performance warnings.
+ *
+ *  In release builds GL_CHECK(x) is just x and the other macros are empty,
+ *  so none of this costs anything.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef GL_DEBUG_HPP
+#define GL_DEBUG_HPP
+
+#include <glad/glad.h>
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <string>
+
+// On unless this is an optimized (NDEBUG) build
+#ifndef ENGINE_GL_DEBUG
+#ifdef NDEBUG
+#define ENGINE_GL_DEBUG 0
+#else
+#define ENGINE_GL_DEBUG 1
+#endif
+#endif
+
+// KHR_debug enums (our glad only has OpenGL 3.3)
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS 0x8242
+#define GL_DEBUG_SOURCE_API 0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM 0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER 0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY 0x8249
+#define GL_DEBUG_SOURCE_APPLICATION 0x824A
+#define GL_DEBUG_SOURCE_OTHER 0x824B
+#define GL_DEBUG_TYPE_ERROR 0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR 0x824E
+#define GL_DEBUG_TYPE_PORTABILITY 0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE 0x8250
+#define GL_DEBUG_TYPE_OTHER 0x8251
+#define GL_DEBUG_TYPE_MARKER 0x8268
+#define GL_DEBUG_TYPE_PUSH_GROUP 0x8269
+#define GL_DEBUG_TYPE_POP_GROUP 0x826A
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#define GL_DEBUG_SEVERITY_HIGH 0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM 0x9147
+#define GL_DEBUG_SEVERITY_LOW 0x9148
+#define GL_DEBUG_OUTPUT 0x92E0
+#endif
+
+// Number of messages of each kind
+struct GLDebugCounts {
+  unsigned int errors{0};      // GL_DEBUG_TYPE_ERROR
+  unsigned int performance{0}; // GL_DEBUG_TYPE_PERFORMANCE
+  unsigned int warnings{0};    // Deprecated, undefined or non-portable use
+  unsigned int other{0};       // Everything else that passed the filter
+
+  unsigned int Total() const { return errors + performance + warnings + other; }
+};
+
+class GLDebug {
+public:
+  // There is one per program (and one OpenGL context).
+  static GLDebug &Instance();
+
+  // Enables debug output on the current context and installs the callback.
+  // 'loader' is the function given to gladLoadGLLoader (our glad does not
+  // load the KHR_debug functions). Returns false if the context has no
+  // KHR_debug (e.g. OpenGL 4.1 on macOS); GL_CHECK then falls back to
+  // glGetError.
+  bool Install(GLADloadproc loader, bool synchronous);
+  // Turns debug output off again
+  void Uninstall();
+  bool IsInstalled() const { return m_installed; }
+
+  // Messages below this severity are dropped by the driver (default:
+  // GL_DEBUG_SEVERITY_LOW, i.e. notifications are dropped)
+  void SetMinimumSeverity(GLenum severity);
+  // Drops one message id of one source (e.g. a known remark of a driver)
+  void Ignore(GLenum source, GLuint id);
+  // Each distinct message is printed at most this many times; it is always
+  // counted (default 5)
+  void SetPrintLimit(unsigned int limit) { m_printLimit = limit; }
+  // Where messages are printed (default std::cerr, nullptr to only count)
+  void SetOutput(std::ostream *out) { m_out = out; }
+
+  // Used by GL_CHECK: remembers which call is running, so synchronous
+  // messages can say where they come from.
+  void BeginCall(const char *call, const char *file, int line);
+  // Used by GL_CHECK after the call. Without KHR_debug this is where
+  // glGetError is drained.
+  void EndCall();
+
+  // Closes the current frame: its counts become GetLastFrame(). Prints a
+  // summary if the frame had errors or performance warnings.
+  void EndFrame();
+  const GLDebugCounts &GetLastFrame() const { return m_lastFrame; }
+  // Counts since Install()
+  GLDebugCounts GetTotal() const;
+
+  // Receives the messages. Public so the filtering and counting can be
+  // tested without a driver.
+  void OnMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
+                 const char *message);
+
+private:
+  GLDebug();
+  GLDebug(const GLDebug &) = delete;
+  GLDebug &operator=(const GLDebug &) = delete;
+
+  void Count(GLenum type);
+  void ApplyFilters();
+
+  // KHR_debug entry points
+  typedef void(APIENTRYP CallbackFunction)(GLDEBUGPROC callback,
+                                           const void *userParam);
+  typedef void(APIENTRYP ControlFunction)(GLenum source, GLenum type,
+                                          GLenum severity, GLsizei count,
+                                          const GLuint *ids,
+                                          GLboolean enabled);
+  CallbackFunction m_debugMessageCallback{nullptr};
+  ControlFunction m_debugMessageControl{nullptr};
+
+  bool m_installed{false};
+  bool m_synchronous{false};
+  GLenum m_minimumSeverity{GL_DEBUG_SEVERITY_LOW};
+  std::set<std::pair<GLenum, GLuint>> m_ignored;
+  unsigned int m_printLimit{5};
+  std::ostream *m_out;
+
+  // The GL call in progress (only meaningful with synchronous output)
+  const char *m_call{nullptr};
+  const char *m_file{nullptr};
+  int m_line{0};
+
+  // Asynchronous messages may arrive on a driver thread
+  std::atomic<unsigned int> m_errors{0}, m_performance{0}, m_warnings{0},
+      m_other{0};
+  GLDebugCounts m_lastFrame;
+  GLDebugCounts m_total;
+  unsigned long m_frame{0};
+  // Filters, m_printed, m_total and printing
+  mutable std::mutex m_mutex;
+  std::map<std::pair<GLenum, GLuint>, unsigned int> m_printed;
+};
+
+#if ENGINE_GL_DEBUG
+#ifdef NDEBUG
+#define GL_DEBUG_SYNCHRONOUS false
+#else
+#define GL_DEBUG_SYNCHRONOUS true
+#endif
+// Wraps one OpenGL call: GL_CHECK(glBindBuffer(GL_ARRAY_BUFFER, vbo));
+#define GL_CHECK(call)                                                         \
+  do {                                                                         \
+    GLDebug::Instance().BeginCall(#call, __FILE__, __LINE__);                  \
+    call;                                                                      \
+    GLDebug::Instance().EndCall();                                             \
+  } while (0)
+// Right after gladLoadGLLoader(loader)
+#define GL_DEBUG_INSTALL(loader)                                               \
+  GLDebug::Instance().Install((loader), GL_DEBUG_SYNCHRONOUS)
+// Once per frame, after the buffers are swapped
+#define GL_DEBUG_END_FRAME() GLDebug::Instance().EndFrame()
+#else
+#define GL_CHECK(call)                                                         \
+  do {                                                                         \
+    call;                                                                      \
+  } while (0)
+#define GL_DEBUG_INSTALL(loader) ((void)0)
+#define GL_DEBUG_END_FRAME() ((void)0)
+#endif
+
+#endif
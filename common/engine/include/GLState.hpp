@@ -0,0 +1,172 @@
+/** @file GLState.hpp
+ *  @brief Shadow copy of the OpenGL state that filters redundant calls.
+ *
+ *  Every frame both programs set the same depth test, polygon mode,
+ *  viewport and clear color, and bind the same programs, vertex arrays and
+ *  textures over and over. Each of those is a call into the driver even
+ *  when nothing changes. GLState remembers what it last set and only calls
+ *  OpenGL when a value is different. Programs, vertex arrays, buffers,
+ *  framebuffers, textures, the viewport, the clear color, depth, blend,
+ *  cull and polygon mode are covered.
+ *
+ *  The shadow is only right if all of these changes go through GLState:
+ *  code that calls OpenGL directly has to call Invalidate() afterwards.
+ *  Deleting a bound object unbinds it in OpenGL, so ResourceTracker's
+ *  UntrackGpu() (called next to every glDelete*) tells GLState as well.
+ *
+ *  Issued and filtered calls are counted per kind and in FrameStats (state
+ *  changes and filtered state changes of the frame).
+ *
+ *  With validation on (debug builds, or ENGINE_GL_STATE_VALIDATE=1) a call
+ *  that would be filtered first asks OpenGL with glGet whether the shadow
+ *  is right; if it is not, the mismatch is reported and the call goes
+ *  through. Validate() compares the whole shadow at once.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef GL_STATE_HPP
+#define GL_STATE_HPP
+
+#include "ResourceTracker.hpp"
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+enum class GLStateKind {
+  Program,
+  VertexArray,
+  Buffer,
+  Framebuffer,
+  ActiveTexture,
+  Texture,
+  Viewport,
+  ClearColor,
+  Capability, // glEnable / glDisable
+  BlendFunc,
+  CullFace,
+  DepthFunc,
+  DepthMask,
+  PolygonMode,
+  Count
+};
+
+// Returns a printable name for a kind of state
+const char *GLStateKindName(GLStateKind kind);
+
+struct GLStateCounters {
+  static const int kKinds = static_cast<int>(GLStateKind::Count);
+
+  uint64_t issued[kKinds] = {};   // Calls that reached OpenGL
+  uint64_t filtered[kKinds] = {}; // Calls that were skipped
+  uint64_t mismatches{0};         // Stale shadow values found by validation
+
+  uint64_t GetIssued() const;
+  uint64_t GetFiltered() const;
+};
+
+class GLState {
+public:
+  // Texture units with a shadow (GL_TEXTURE_2D only)
+  static const unsigned kTextureUnits = 16;
+
+  // There is one per program (and one OpenGL context).
+  static GLState &Instance();
+
+  void UseProgram(GLuint program);
+  void BindVertexArray(GLuint vertexArray);
+  // GL_ELEMENT_ARRAY_BUFFER is part of the vertex array's state, so it
+  // (and any target without a shadow) is always passed through
+  void BindBuffer(GLenum target, GLuint buffer);
+  // These also bind the target's generic binding point
+  void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+  void BindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                       GLintptr offset, GLsizeiptr size);
+  // GL_FRAMEBUFFER binds both the draw and the read framebuffer
+  void BindFramebuffer(GLenum target, GLuint framebuffer);
+  // 'unit' counts from 0 (not GL_TEXTURE0)
+  void ActiveTexture(unsigned unit);
+  // Makes 'unit' the active unit, then binds. Only GL_TEXTURE_2D bindings
+  // have a shadow.
+  void BindTexture(unsigned unit, GLenum target, GLuint texture);
+
+  void Viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+  void ClearColor(float r, float g, float b, float a);
+  // GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE and GL_SCISSOR_TEST have a
+  // shadow, other capabilities are passed through
+  void Enable(GLenum capability) { SetEnabled(capability, true); }
+  void Disable(GLenum capability) { SetEnabled(capability, false); }
+  void SetEnabled(GLenum capability, bool enabled);
+  // From the shadow if it is known (asks OpenGL otherwise)
+  bool IsEnabled(GLenum capability);
+  void BlendFunc(GLenum source, GLenum destination);
+  void CullFace(GLenum face);
+  void DepthFunc(GLenum function);
+  void DepthMask(bool write);
+  // For GL_FRONT_AND_BACK (the only face a core profile has)
+  void PolygonMode(GLenum mode);
+
+  // Forgets everything, so the next call of every kind is issued. For a
+  // new context, or after code that changed the state directly.
+  void Invalidate();
+  // An object was deleted: where it was bound, 0 is bound now. Makes no
+  // OpenGL calls.
+  void OnDeleted(GpuResourceKind kind, GLuint id);
+
+  // See the file comment. Off by default in optimized builds.
+  void SetValidation(bool on) { m_validate = on; }
+  bool IsValidating() const { return m_validate; }
+  // Compares every known shadow value with glGet. Prints the differences
+  // to 'out' (if not null), adopts the real values and returns how many
+  // there were.
+  size_t Validate(std::ostream *out);
+
+  // Counts since the start (or ResetCounters())
+  const GLStateCounters &GetCounters() const { return m_counters; }
+  void ResetCounters() { m_counters = GLStateCounters(); }
+  // Issued and filtered calls per kind
+  void PrintReport(std::ostream &out) const;
+
+private:
+  GLState();
+  GLState(const GLState &) = delete;
+  GLState &operator=(const GLState &) = delete;
+
+  // Counts the call; returns true if it can be skipped
+  bool Filter(GLStateKind kind, bool same);
+  // Validation: records a mismatch if the real value is not the shadow.
+  // Returns whether they matched.
+  bool Check(GLStateKind kind, bool matches);
+  bool CheckInteger(GLStateKind kind, GLenum query, GLint shadow);
+  void Issued(GLStateKind kind);
+
+  static const GLuint kUnknown = 0xFFFFFFFFu;
+  static const int kBufferTargets = 6;
+  static const int kCapabilities = 4;
+
+  GLuint m_program;
+  GLuint m_vertexArray;
+  GLuint m_buffers[kBufferTargets];
+  GLuint m_drawFramebuffer;
+  GLuint m_readFramebuffer;
+  GLuint m_activeTexture;
+  GLuint m_textures[kTextureUnits];
+  bool m_viewportKnown;
+  GLint m_viewport[4];
+  bool m_clearColorKnown;
+  float m_clearColor[4];
+  int m_capabilities[kCapabilities]; // -1 unknown, 0 off, 1 on
+  GLenum m_blendSource;
+  GLenum m_blendDestination;
+  GLenum m_cullFace;
+  GLenum m_depthFunc;
+  int m_depthMask; // -1 unknown
+  GLenum m_polygonMode;
+
+  bool m_validate;
+  GLStateCounters m_counters;
+};
+
+#endif
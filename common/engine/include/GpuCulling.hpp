@@ -0,0 +1,200 @@
+/** @file GpuCulling.hpp
+ *  @brief GPU driven drawing: a compute shader culls the objects and
+ *         writes their draw commands.
+ *
+ *  Drawing thousands of objects from the CPU costs a loop per frame: test
+ *  each one against the frustum, set its uniforms, issue its draw. With
+ *  GpuCuller the objects live in GPU buffers instead (shader storage
+ *  buffers: a transform and a bounding sphere per object, a range of the
+ *  index buffer per mesh). Each frame Cull() runs one compute dispatch
+ *  that tests every sphere against the frustum planes and appends a
+ *  DrawElementsIndirectCommand for each visible object, counting them with
+ *  an atomic counter. Draw() then issues all of them with one
+ *  glMultiDrawElementsIndirectCount (OpenGL 4.6 or ARB_indirect_parameters)
+ *  that reads the count from the counter. Without it the commands are
+ *  cleared first and glMultiDrawElementsIndirect issues every slot; the
+ *  empty ones draw nothing.
+ *
+ *  The CPU cost of a frame is the same for ten objects or a hundred
+ *  thousand: a few uniforms, one dispatch, one draw. Transforms are only
+ *  uploaded when SetTransform() changed them (the range of changed
+ *  objects, once per Cull()).
+ *
+ *  The vertex shader finds its object through an instanced integer
+ *  attribute (see Draw()): each command's baseInstance is the object's
+ *  index, so that attribute holds it, and it reads the transform from the
+ *  buffer at binding kGpuObjectBinding:
+ *
+ *    struct GpuObject { mat4 model; vec4 sphere; uvec4 mesh; };
+ *    layout(std430, binding = 0) readonly buffer Objects {
+ *      GpuObject u_Objects[];
+ *    };
+ *    layout(location = 3) in uint a_ObjectIndex;
+ *
+ *  Needs OpenGL 4.3 (compute shaders, shader storage buffers, multi draw
+ *  indirect). Our glad stops at 3.3, so Create() loads those functions
+ *  itself (like GLDebug) and returns false where they are missing.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef GPU_CULLING_HPP
+#define GPU_CULLING_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// OpenGL 4.3+ enums (our glad only has 3.3)
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_PARAMETER_BUFFER
+#define GL_PARAMETER_BUFFER 0x80EE
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+
+// Buffer bindings the shaders use
+const GLuint kGpuObjectBinding = 0;
+
+// A range of the index buffer, with the bounding sphere of what it draws
+// (in object space)
+struct GpuMesh {
+  GLuint indexCount{0};
+  GLuint firstIndex{0};
+  GLint baseVertex{0};
+  glm::vec3 center{0.0f};
+  float radius{0.0f};
+};
+
+// One object as the shaders see it (std430)
+struct GpuObject {
+  glm::mat4 model;
+  glm::vec4 sphere;  // World space center and radius
+  glm::uvec4 mesh;   // x: index into the meshes
+};
+static_assert(sizeof(GpuObject) == 96, "GpuObject must match the shaders");
+
+struct GpuCullStats {
+  uint32_t objects{0};
+  uint32_t drawn{0};         // Kept by a recent Cull() (read without waiting)
+  size_t uploadedBytes{0};   // Transforms uploaded by the last Cull()
+  uint64_t totalUploads{0};  // Cull() calls that uploaded anything
+};
+
+class GpuCuller {
+public:
+  GpuCuller() {}
+  ~GpuCuller();
+  GpuCuller(const GpuCuller &) = delete;
+  GpuCuller &operator=(const GpuCuller &) = delete;
+
+  // Loads the OpenGL 4.3 functions with 'loader' and builds the compute
+  // program (needs a current context). Returns false, see GetError(), if
+  // the context cannot do it. 'useDrawCount' false keeps the draw count
+  // out of it even where the driver has it (to compare the two).
+  bool Create(GLADloadproc loader, bool useDrawCount = true);
+  void Release();
+  bool IsCreated() const { return m_program != 0; }
+  // glMultiDrawElementsIndirectCount is there (the draw count stays on the
+  // GPU)
+  bool HasDrawCount() const { return m_drawCount != nullptr; }
+  const std::string &GetError() const { return m_error; }
+
+  // Returns the mesh's index
+  uint32_t AddMesh(const GpuMesh &mesh);
+  // Returns the object's index. 'model' may scale, the sphere grows with
+  // the largest axis.
+  uint32_t AddObject(uint32_t mesh, const glm::mat4 &model);
+  void SetTransform(uint32_t object, const glm::mat4 &model);
+  // Removes every mesh and object
+  void Clear();
+  uint32_t GetObjectCount() const {
+    return static_cast<uint32_t>(m_objects.size());
+  }
+  const GpuObject &GetObject(uint32_t object) const {
+    return m_objects[object];
+  }
+
+  // Uploads what changed, then culls against the planes of
+  // 'viewProjection' (projection * view) and writes the draw commands
+  void Cull(const glm::mat4 &viewProjection);
+  // Draws what the last Cull() kept with 'vertexArray', whose element
+  // buffer the meshes index. Binds the object buffer and points attribute
+  // 'objectIndexLocation' of the vertex array at the object indices.
+  // The caller's program must be in use (through GLState).
+  void Draw(GLuint vertexArray, GLuint objectIndexLocation);
+  // What the last Cull() kept. Waits for the GPU: for tests and reports.
+  uint32_t ReadDrawnCount();
+  const GpuCullStats &GetStats() const { return m_stats; }
+
+private:
+  // OpenGL 4.3+ entry points
+  typedef void(APIENTRYP DispatchComputeFunction)(GLuint x, GLuint y,
+                                                  GLuint z);
+  typedef void(APIENTRYP MemoryBarrierFunction)(GLbitfield barriers);
+  typedef void(APIENTRYP MultiDrawIndirectFunction)(GLenum mode, GLenum type,
+                                                    const void *indirect,
+                                                    GLsizei drawCount,
+                                                    GLsizei stride);
+  typedef void(APIENTRYP MultiDrawIndirectCountFunction)(
+      GLenum mode, GLenum type, const void *indirect, GLintptr drawCount,
+      GLsizei maxDrawCount, GLsizei stride);
+  typedef void(APIENTRYP ClearBufferDataFunction)(GLenum target,
+                                                  GLenum internalFormat,
+                                                  GLenum format, GLenum type,
+                                                  const void *data);
+
+  // Grows the GPU buffers to the objects and uploads the changed range
+  void Upload();
+  // Reads the counter copies whose fences have signaled
+  void CollectCounts();
+
+  DispatchComputeFunction m_dispatchCompute{nullptr};
+  MemoryBarrierFunction m_memoryBarrier{nullptr};
+  MultiDrawIndirectFunction m_multiDraw{nullptr};
+  MultiDrawIndirectCountFunction m_drawCount{nullptr};
+  ClearBufferDataFunction m_clearBufferData{nullptr};
+
+  GLuint m_program{0};
+  GLint m_planesLocation{-1};
+  GLint m_countLocation{-1};
+  GLuint m_objectBuffer{0};
+  GLuint m_meshBuffer{0};
+  GLuint m_commandBuffer{0};
+  GLuint m_counterBuffer{0};
+  GLuint m_indexBuffer{0}; // 0, 1, 2, ... for the object index attribute
+  uint32_t m_capacity{0};  // Objects the buffers have room for
+
+  // Counter copies read a few frames later, so nobody waits
+  static const int kReadbacks = 3;
+  GLuint m_readbacks[kReadbacks]{};
+  GLsync m_fences[kReadbacks]{};
+  int m_nextReadback{0};
+
+  std::vector<GpuMesh> m_meshes;
+  std::vector<GpuObject> m_objects;
+  // Objects changed since the last upload: [m_dirtyBegin, m_dirtyEnd)
+  uint32_t m_dirtyBegin{0};
+  uint32_t m_dirtyEnd{0};
+  bool m_meshesDirty{false};
+  uint32_t m_culled{0}; // Objects the last Cull() tested
+  GpuCullStats m_stats;
+  std::string m_error;
+};
+
+#endif
@@ -0,0 +1,47 @@
+/** @file GpuTimer.hpp
+ *  @brief Measures how long the GPU spends on a part of a frame.
+ *
+ *  Uses GL_TIME_ELAPSED queries (core since OpenGL 3.3). Reading a query
+ *  right after the frame would wait for the GPU to finish, so a small ring
+ *  of queries is used and a result is only read once the driver says it is
+ *  available, usually two or three frames later. Begin/End pairs cannot be
+ *  nested (with this or any other GL_TIME_ELAPSED query).
+ *
+ *  @bug No known bugs.
+ */
+#ifndef GPU_TIMER_HPP
+#define GPU_TIMER_HPP
+
+#include <glad/glad.h>
+
+class GpuTimer {
+public:
+  GpuTimer() {}
+  ~GpuTimer();
+  GpuTimer(const GpuTimer &) = delete;
+  GpuTimer &operator=(const GpuTimer &) = delete;
+
+  // Creates the queries (needs a current context)
+  void Create();
+  // Deletes the queries while the context is still alive
+  void Release();
+  bool IsCreated() const { return m_queries[0] != 0; }
+
+  // Starts / stops timing this frame's commands. If every query is still
+  // waiting for the GPU, the frame is not timed.
+  void Begin();
+  void End();
+
+  // Collects finished queries without waiting. Returns true and the
+  // newest result in milliseconds if at least one has finished.
+  bool Poll(float &milliseconds);
+
+private:
+  static const int kQueries = 4;
+  GLuint m_queries[kQueries] = {};
+  bool m_pending[kQueries] = {};
+  int m_next{0};
+  int m_running{-1};
+};
+
+#endif
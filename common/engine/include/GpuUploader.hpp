@@ -0,0 +1,168 @@
+/** @file GpuUploader.hpp
+ *  @brief Creates buffers and textures on a second OpenGL context and
+ *         thread, so uploads do not stall the frame.
+ *
+ *  The program creates a context that shares objects with its own (see
+ *  SharedContext) and hands it to Start(). The uploader makes it current
+ *  on its thread, which then takes upload jobs from a queue: it creates
+ *  the buffers or the texture, fills them (and builds the mip chain), puts
+ *  a fence behind them and flushes. Poll() on the render thread hands a
+ *  job over once its fence has signaled, by calling the job's callback
+ *  with the new names; until then the render thread never waits for it.
+ *
+ *  Vertex arrays are not shared between contexts, so callbacks create
+ *  those. Objects are handed over untracked: the callback reports them to
+ *  ResourceTracker like any other object it creates. The upload thread
+ *  uses its own context's state, GLState (the render thread's shadow) is
+ *  not involved.
+ *
+ *  Without Start() (or if the context cannot be made current) jobs are
+ *  done right away on the calling thread, which has to be the render
+ *  thread. Callbacks still run in Poll(), so callers have one code path.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef GPU_UPLOADER_HPP
+#define GPU_UPLOADER_HPP
+
+#include <glad/glad.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+// A context that shares objects with the render thread's one. Both
+// functions are called on the upload thread.
+struct SharedContext {
+  std::function<bool()> makeCurrent;
+  std::function<void()> doneCurrent;
+};
+
+struct BufferUpload {
+  GLenum usage{GL_STATIC_DRAW};
+  std::vector<uint8_t> data; // Freed once it is uploaded
+};
+
+// Copies a vector's bytes into an upload
+template <typename T>
+BufferUpload MakeBufferUpload(const std::vector<T> &values,
+                              GLenum usage = GL_STATIC_DRAW) {
+  BufferUpload upload;
+  upload.usage = usage;
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(values.data());
+  upload.data.assign(bytes, bytes + values.size() * sizeof(T));
+  return upload;
+}
+
+// A 2D texture, GL_TEXTURE_2D
+struct TextureUpload {
+  GLsizei width{0};
+  GLsizei height{0};
+  GLenum internalFormat{GL_RGB8};
+  GLenum format{GL_RGB};
+  GLenum type{GL_UNSIGNED_BYTE};
+  std::vector<uint8_t> pixels; // Freed once it is uploaded
+  // Used instead of 'pixels' if set: memory that outlives the job, e.g. a
+  // view of the AssetArchive, so nothing has to be copied
+  const uint8_t *external{nullptr};
+  size_t externalBytes{0};
+  GLenum minFilter{GL_LINEAR};
+  GLenum magFilter{GL_LINEAR};
+  GLenum wrap{GL_CLAMP_TO_EDGE};
+  bool mipmaps{true};
+};
+
+// What a finished job hands over
+struct UploadResult {
+  std::vector<GLuint> buffers; // In the order of the uploads
+  std::vector<size_t> bufferBytes;
+  GLuint texture{0};
+};
+
+using UploadCallback = std::function<void(const UploadResult &)>;
+// 0 is never a job
+using UploadTicket = uint64_t;
+
+struct UploaderStats {
+  uint64_t jobs{0};          // Handed over (or canceled)
+  uint64_t bytes{0};         // Buffer and level 0 texture bytes uploaded
+  double uploadMs{0.0};      // Time spent issuing the uploads
+  uint64_t notReadyPolls{0}; // Poll() found the next fence unsignaled
+};
+
+class GpuUploader {
+public:
+  GpuUploader();
+  // Stop()s
+  ~GpuUploader();
+  GpuUploader(const GpuUploader &) = delete;
+  GpuUploader &operator=(const GpuUploader &) = delete;
+
+  // Starts the upload thread on 'context'. Returns false (and uploads on
+  // the calling thread from then on) if the context could not be made
+  // current there.
+  bool Start(const SharedContext &context);
+  // Finish()es, then ends the thread. Call it before the contexts go away.
+  void Stop();
+  bool IsThreaded() const { return m_threaded; }
+
+  // Queue a job (any thread). 'ready' runs on the render thread in Poll()
+  // or Finish(), when the objects can be used there.
+  UploadTicket UploadBuffers(std::vector<BufferUpload> buffers,
+                             UploadCallback ready);
+  UploadTicket UploadTexture(TextureUpload texture, UploadCallback ready);
+  // The job's callback will not run and its objects are deleted (for an
+  // owner that goes away first). Does nothing for finished jobs.
+  void Cancel(UploadTicket ticket);
+
+  // Render thread: hands over the jobs whose fences have signaled,
+  // without waiting. Returns how many.
+  size_t Poll();
+  // Render thread: waits until every job queued so far is handed over
+  void Finish();
+  // Queued, uploading or waiting for their fence
+  size_t GetPending() const;
+  UploaderStats GetStats() const;
+
+private:
+  struct Job {
+    UploadTicket ticket{0};
+    std::vector<BufferUpload> buffers;
+    bool isTexture{false};
+    TextureUpload texture;
+    UploadCallback ready;
+    UploadResult result;
+    GLsync fence{nullptr};
+  };
+
+  UploadTicket Queue(std::unique_ptr<Job> job);
+  // Creates and fills the objects on the current context. 'renderThread'
+  // binds through GLState.
+  void Execute(Job &job, bool renderThread);
+  void ThreadMain(SharedContext context, std::promise<bool> started);
+  // Hands over finished jobs in order; 'wait' blocks on their fences
+  size_t HandOver(bool wait);
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_wake;     // New job or stop, for the thread
+  std::condition_variable m_uploaded; // A job moved to m_done
+  std::deque<std::unique_ptr<Job>> m_queued;
+  std::deque<std::unique_ptr<Job>> m_done; // Uploaded, in queue order
+  std::set<UploadTicket> m_canceled;
+  UploadTicket m_busy{0}; // The job the thread is uploading
+  bool m_stop{false};
+  bool m_threaded{false};
+  UploadTicket m_nextTicket{1};
+  UploaderStats m_stats;
+  std::thread m_thread;
+};
+
+#endif
@@ -0,0 +1,158 @@
+/** @file Impostor.hpp
+ *  @brief Octahedral impostors: far away copies of a mesh drawn as quads.
+ *
+ *  A mesh is rendered once, at load time, from N x N directions around its
+ *  bounding sphere into the tiles of one atlas texture. The directions are
+ *  the cell centers of an octahedral map of the sphere, so looking up the
+ *  tile for a view direction is a few arithmetic operations.
+ *
+ *  Each frame SelectImpostors() sorts the copies of the mesh by their size
+ *  on screen: big ones are drawn as the mesh, small ones as one quad each,
+ *  showing the tile that was rendered from the nearest direction. All quads
+ *  are one instanced draw call, so a forest of thousands of trees costs a
+ *  few triangles per tree.
+ *
+ *  In between the two sizes both are drawn with complementary dither
+ *  patterns (a cross-fade that needs no sorting or blending): the impostor
+ *  keeps the pixels where the dither value is below the fade, the mesh the
+ *  others. The mesh's fragment shader has to discard its share, see
+ *  part1/shaders/frag.glsl (u_Dissolve).
+ *
+ *  @bug No known bugs.
+ */
+#ifndef IMPOSTOR_HPP
+#define IMPOSTOR_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// ============================== Mapping ==================================== //
+// Unit direction to the octahedral map ([0, 1] on both axes). The upper
+// hemisphere (y >= 0) is the inner diamond.
+glm::vec2 OctahedralEncode(const glm::vec3 &direction);
+// Back to a unit direction
+glm::vec3 OctahedralDecode(const glm::vec2 &uv);
+// The direction tile (x, y) of an n x n atlas was rendered from
+glm::vec3 ImpostorFrameDirection(int x, int y, int framesPerSide);
+// The tile whose direction is nearest to 'direction'
+glm::ivec2 ImpostorNearestFrame(const glm::vec3 &direction, int framesPerSide);
+// Camera right and up for a tile looking along -direction. The shader
+// builds the quads the same way.
+void ImpostorFrameBasis(const glm::vec3 &direction, glm::vec3 &right,
+                        glm::vec3 &up);
+
+// ============================== Selection ================================== //
+struct ImpostorLodSettings {
+  float thresholdPixels{96.0f}; // Smaller than this on screen: impostor
+  float fadePixels{32.0f};      // Both are drawn this far below it
+};
+
+// Height in pixels of a sphere of 'radius' at 'distance' from the camera
+float ProjectedDiameter(float radius, float distance, float fovY,
+                        float screenHeight);
+// 0 = only the mesh, 1 = only the impostor, in between: cross-fade
+float ImpostorFade(float pixels, const ImpostorLodSettings &settings);
+
+// One copy of the mesh: translated and uniformly scaled (no rotation, the
+// tiles are rendered in the mesh's own frame)
+struct ImpostorInstance {
+  glm::vec3 position;
+  float scale;
+  float fade; // ImpostorFade(), filled in by SelectImpostors
+};
+
+// What to draw this frame
+struct ImpostorSelection {
+  std::vector<uint32_t> meshes;   // Indices of the copies drawn as the mesh
+  std::vector<float> meshFades;   // Their fades (u_Dissolve)
+  std::vector<ImpostorInstance> impostors; // Copies drawn as quads
+
+  void Clear() {
+    meshes.clear();
+    meshFades.clear();
+    impostors.clear();
+  }
+};
+
+// Splits 'instances' by their size on screen. 'center' and 'radius' are
+// the mesh's bounding sphere (before the instance transform).
+void SelectImpostors(const ImpostorInstance *instances, size_t count,
+                     const glm::vec3 &center, float radius,
+                     const glm::vec3 &cameraPosition, float fovY,
+                     float screenHeight, const ImpostorLodSettings &settings,
+                     ImpostorSelection &out);
+
+// ============================== Atlas ====================================== //
+// Draws the mesh with the given matrices into the bound framebuffer
+using ImpostorDrawFunction =
+    std::function<void(const glm::mat4 &view, const glm::mat4 &projection)>;
+
+class ImpostorAtlas {
+public:
+  ImpostorAtlas() {}
+  ~ImpostorAtlas();
+  ImpostorAtlas(const ImpostorAtlas &) = delete;
+  ImpostorAtlas &operator=(const ImpostorAtlas &) = delete;
+
+  // Renders 'draw' from framesPerSide^2 directions into frameSize^2 pixel
+  // tiles around the sphere (center, radius). The draw function must write
+  // an alpha of 1 where the mesh is (the rest stays transparent). The
+  // framebuffer binding and the viewport are put back afterwards. Returns
+  // false if the framebuffer is incomplete.
+  bool Bake(const glm::vec3 &center, float radius, int framesPerSide,
+            int frameSize, const ImpostorDrawFunction &draw);
+  void Release();
+  bool IsBaked() const { return m_texture != 0; }
+
+  GLuint GetTexture() const { return m_texture; }
+  int GetFramesPerSide() const { return m_framesPerSide; }
+  const glm::vec3 &GetCenter() const { return m_center; }
+  float GetRadius() const { return m_radius; }
+
+private:
+  GLuint m_texture{0};
+  int m_framesPerSide{0};
+  glm::vec3 m_center{0.0f};
+  float m_radius{0.0f};
+};
+
+// ============================== Renderer =================================== //
+// Draws impostors of one atlas with a single instanced draw call
+class ImpostorRenderer {
+public:
+  ImpostorRenderer() {}
+  ~ImpostorRenderer();
+  ImpostorRenderer(const ImpostorRenderer &) = delete;
+  ImpostorRenderer &operator=(const ImpostorRenderer &) = delete;
+
+  // Creates the program and the buffers (needs a current context). Returns
+  // false if the program does not compile.
+  bool Create();
+  void Release();
+  bool IsCreated() const { return m_program != 0; }
+
+  // Depth testing should be on. Binds through GLState and leaves its
+  // program and VAO bound.
+  void Draw(const ImpostorAtlas &atlas,
+            const std::vector<ImpostorInstance> &instances,
+            const glm::mat4 &view, const glm::mat4 &projection,
+            const glm::vec3 &cameraPosition);
+
+private:
+  GLuint m_program{0};
+  GLint m_viewProjectionLocation{-1};
+  GLint m_cameraLocation{-1};
+  GLint m_sphereLocation{-1};
+  GLint m_framesLocation{-1};
+  GLuint m_vao{0};
+  GLuint m_cornerVbo{0};
+  GLuint m_instanceVbo{0};
+  size_t m_instanceBytes{0};
+};
+
+#endif
@@ -0,0 +1,46 @@
+/** @file MappedFile.hpp
+ *  @brief A whole file, mapped read only.
+ *
+ *  The cooked formats (AssetArchive.hpp, SceneFile.hpp) are used where
+ *  they lie: Open() maps the file privately and read only, and closes the
+ *  descriptor right away (the mapping keeps the file open). On Windows
+ *  the file is read into memory instead, with the same interface.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MappedFile {
+public:
+  MappedFile() {}
+  // Close()s
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Returns false (and why in 'error') if the file is missing or empty
+  bool Open(const std::string &path, std::string *error = nullptr);
+  void Close();
+  bool IsOpen() const { return m_data != nullptr; }
+  const uint8_t *GetData() const { return m_data; }
+  size_t GetSize() const { return m_size; }
+
+  // The file is read in no particular order: the kernel should not read
+  // ahead (madvise MADV_RANDOM)
+  void AdviseRandom() const;
+  // Asks the kernel to read the pages of 'size' bytes from 'data' (within
+  // the file) now, before they are touched (madvise MADV_WILLNEED)
+  void Prefetch(const uint8_t *data, size_t size) const;
+
+private:
+  const uint8_t *m_data{nullptr};
+  size_t m_size{0};
+  bool m_mapped{false}; // Otherwise m_data was allocated
+};
+
+#endif
@@ -0,0 +1,58 @@
+/** @file MathKernels.hpp
+ *  @brief Batched matrix, point and bounding box transforms.
+ *
+ *  Transforming one thing at a time wastes most of a SIMD register on
+ *  shuffles. These kernels work on many at once: points and boxes are
+ *  stored as structures of arrays (all x, then all y, ...) so four of them
+ *  are transformed per instruction.
+ *
+ *  Every kernel gives bit for bit the same result as its *Scalar version
+ *  (and the same result as glm for the matrix and point transforms): the
+ *  operations are done in the same order and never fused.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef MATH_KERNELS_HPP
+#define MATH_KERNELS_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "EngineMath.hpp"
+
+// Points, one array per coordinate
+struct PointsSoA {
+  std::vector<float> x, y, z;
+
+  void Resize(size_t count);
+  size_t Size() const { return x.size(); }
+};
+
+// Axis aligned bounding boxes, one array per coordinate of min and max
+struct AabbSoA {
+  std::vector<float> minX, minY, minZ;
+  std::vector<float> maxX, maxY, maxZ;
+
+  void Resize(size_t count);
+  size_t Size() const { return minX.size(); }
+};
+
+// out[i] = lhs[i] * rhs[i]. 'out' may be 'lhs' or 'rhs'.
+void MultiplyMat4Batch(const glm::mat4 *lhs, const glm::mat4 *rhs,
+                       glm::mat4 *out, size_t count);
+void MultiplyMat4BatchScalar(const glm::mat4 *lhs, const glm::mat4 *rhs,
+                             glm::mat4 *out, size_t count);
+
+// out = m * (p, 1) for every point, keeping xyz. Meant for affine matrices
+// (model and world transforms), where w stays 1.
+void TransformPoints(const glm::mat4 &m, const PointsSoA &in, PointsSoA &out);
+void TransformPointsScalar(const glm::mat4 &m, const PointsSoA &in,
+                           PointsSoA &out);
+
+// Bounds of every box after an affine transform (Arvo's method: each output
+// axis adds the smaller/larger of m[j][i] * min_j and m[j][i] * max_j).
+void TransformAabbs(const glm::mat4 &m, const AabbSoA &in, AabbSoA &out);
+void TransformAabbsScalar(const glm::mat4 &m, const AabbSoA &in,
+                          AabbSoA &out);
+
+#endif
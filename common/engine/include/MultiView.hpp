@@ -0,0 +1,66 @@
+/** @file MultiView.hpp
+ *  @brief Drawing a scene from several cameras in one pass.
+ *
+ *  Split screen, stereo and cascade style rendering draw the same scene
+ *  from a few views. Doing a full pass per view repeats the culling, the
+ *  recording and every draw call N times. Instead the scene is culled once
+ *  against all views (MultiViewFrustum) and each draw is instanced once per
+ *  view: the vertex shader transforms by the view of gl_InstanceID
+ *  (ViewsBlock) and a geometry shader sends the triangle to that layer of a
+ *  layered framebuffer (gl_Layer). OpenGL 3.3 can only set the layer from a
+ *  geometry shader; GL_OVR_multiview or the vertex shader's gl_Layer need
+ *  newer contexts.
+ *
+ *  The layers are then put next to each other on the screen
+ *  (SplitScreenViewport), or used as textures.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef MULTI_VIEW_HPP
+#define MULTI_VIEW_HPP
+
+#include "Frustum.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// Views drawn by one instanced draw at most
+static const unsigned kMaxViews = 4;
+
+// The shaders' 'Views' block (std140): projection * view of each layer
+struct ViewsBlock {
+  glm::mat4 viewProjection[kMaxViews];
+  glm::ivec4 count; // x: views in use
+};
+static_assert(sizeof(ViewsBlock) == 64 * kMaxViews + 16,
+              "ViewsBlock is std140");
+
+// Fills a block with the first min(count, kMaxViews) matrices
+ViewsBlock MakeViewsBlock(const glm::mat4 *viewProjections, size_t count);
+
+// The frusta of all views; a volume is kept if any view may see it
+class MultiViewFrustum {
+public:
+  MultiViewFrustum() {}
+  MultiViewFrustum(const glm::mat4 *viewProjections, size_t count) {
+    Set(viewProjections, count);
+  }
+  // Uses the first min(count, kMaxViews) views
+  void Set(const glm::mat4 *viewProjections, size_t count);
+
+  bool IntersectsSphere(const glm::vec3 &center, float radius) const;
+  size_t GetViewCount() const { return m_count; }
+
+private:
+  Frustum m_frustums[kMaxViews];
+  size_t m_count{0};
+};
+
+// Where view 'index' of 'count' goes on a width x height screen as
+// (x, y, width, height): the whole screen for one view, side by side for
+// two, a 2 x 2 grid (top left first) for three or four.
+glm::ivec4 SplitScreenViewport(unsigned index, unsigned count, int width,
+                               int height);
+
+#endif
@@ -0,0 +1,58 @@
+/** @file ObjParser.hpp
+ *  @brief Parses Wavefront .obj files into flat arrays.
+ *
+ *  Only the parts of the format our models use are understood: positions
+ *  (v), texture coordinates (vt), normals (vn), faces (f) and the material
+ *  library (mtllib). Faces with more than three corners are split into a
+ *  triangle fan and negative (relative) indices are resolved, so every
+ *  three entries of ObjData::corners form one triangle.
+ *
+ *  The parser works on text that is already in memory, so loading the file
+ *  and parsing it can be measured (and optimized) separately.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef OBJ_PARSER_HPP
+#define OBJ_PARSER_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+// One corner of a face. Indices are 0 based, -1 if the face left it out.
+struct ObjIndex {
+  int position;
+  int texCoord;
+  int normal;
+};
+
+struct ObjData {
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec2> texCoords;
+  std::vector<glm::vec3> normals;
+  std::vector<ObjIndex> corners; // Three per triangle
+  std::string materialLibrary;   // Relative to the .obj file ("" if none)
+
+  size_t GetTriangleCount() const { return corners.size() / 3; }
+  void Clear();
+};
+
+// Parses 'length' bytes of .obj text into 'out' (which is cleared first).
+// Returns false and describes the problem in 'error' (if given) when a face
+// refers to data that does not exist.
+bool ParseObj(const char *text, size_t length, ObjData &out,
+              std::string *error = nullptr);
+
+// Reads a whole file into memory (from the mounted AssetArchive if it has
+// the file). Returns false if it cannot be opened.
+bool ReadFileToString(const std::string &path, std::string &out);
+
+// ReadFileToString + ParseObj, or the cooked mesh from the mounted
+// AssetArchive
+bool LoadObjFile(const std::string &path, ObjData &out,
+                 std::string *error = nullptr);
+
+#endif
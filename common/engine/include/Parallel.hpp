@@ -0,0 +1,75 @@
+/** @file Parallel.hpp
+ *  @brief Splits a loop over the CPU cores.
+ *
+ *  ParallelFor() hands out chunks of [0, count) to a few std::threads and
+ *  returns when all of them are done. Threads are started per call, so it
+ *  is meant for work that takes milliseconds or more (tuning, sorting big
+ *  arrays), not for tiny loops every frame.
+ *
+ *  WorkerPool does the same with threads that are started once and sleep
+ *  between calls, for work that runs every frame (e.g. recording command
+ *  buffers, see CommandBuffer.hpp).
+ *
+ *  @bug No known bugs.
+ */
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of threads to use: ENGINE_THREADS if set, else the number of
+// hardware threads (at least 1)
+unsigned GetWorkerCount();
+
+// Calls body(begin, end) for consecutive chunks of at most 'grain' items
+// until [0, count) is covered, on up to 'threads' threads (0 for
+// GetWorkerCount()). Each chunk is handed to exactly one call.
+void ParallelFor(size_t count, size_t grain,
+                 const std::function<void(size_t begin, size_t end)> &body,
+                 unsigned threads = 0);
+
+// Long lived threads for ParallelFor-style loops. Run() is not reentrant:
+// one thread (e.g. the GL thread) owns the pool.
+class WorkerPool {
+public:
+  // Starts threads - 1 workers (0 for GetWorkerCount()); the thread that
+  // calls Run() is the last one
+  explicit WorkerPool(unsigned threads = 0);
+  ~WorkerPool();
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  unsigned GetThreadCount() const {
+    return static_cast<unsigned>(m_threads.size()) + 1;
+  }
+  // Same contract as ParallelFor()
+  void Run(size_t count, size_t grain,
+           const std::function<void(size_t begin, size_t end)> &body);
+
+private:
+  void WorkerMain();
+  void TakeChunks();
+
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+  // The current loop
+  const std::function<void(size_t, size_t)> *m_body{nullptr};
+  size_t m_count{0};
+  size_t m_grain{1};
+  size_t m_chunks{0};
+  std::atomic<size_t> m_next{0};
+  uint64_t m_generation{0}; // Bumped for every Run()
+  unsigned m_busy{0};       // Workers still in the current loop
+  bool m_stop{false};
+};
+
+#endif
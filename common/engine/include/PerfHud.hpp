@@ -0,0 +1,122 @@
+/** @file PerfHud.hpp
+ *  @brief On-screen overlay with frame times, GPU time, draw calls,
+ *         triangles, state changes and memory.
+ *
+ *  Everything the overlay shows (text, graph bars and the background
+ *  panel) is a textured quad. The quads are collected in a HudBatch on the
+ *  CPU, uploaded into one dynamic vertex buffer and drawn with a single
+ *  glDrawElements. Text uses a built in 3x5 pixel font that is baked into
+ *  a small one channel atlas when the HUD is created; solid quads sample a
+ *  white cell of the same atlas, so no texture or program switch is needed.
+ *
+ *  The HUD is meant to be the last thing drawn in a frame (after the
+ *  framebuffer is composited to the screen). It shows the counters of the
+ *  last complete frame from FrameStats, and the time it spent itself, so
+ *  it can stay on while benchmarking.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef PERF_HUD_HPP
+#define PERF_HUD_HPP
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class FrameHistory;
+class FrameStats;
+
+// One corner of a HUD quad, in pixels from the top left of the screen
+struct HudVertex {
+  float x, y;
+  float u, v;
+  uint32_t color; // RGBA8, red in the lowest byte
+};
+
+// Packs a color into HudVertex::color
+inline uint32_t HudColor(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255) {
+  return static_cast<uint32_t>(r) | (static_cast<uint32_t>(g) << 8) |
+         (static_cast<uint32_t>(b) << 16) | (static_cast<uint32_t>(a) << 24);
+}
+
+// Collects the quads of one frame. Does not call OpenGL.
+class HudBatch {
+public:
+  // Pixel size of a character at scale 1 (glyph plus spacing)
+  static const int kCharWidth = 4;
+  static const int kCharHeight = 6;
+
+  // Starts a new frame (keeps the allocation)
+  void Clear() { m_vertices.clear(); }
+  // A solid rectangle
+  void AddRect(float x, float y, float w, float h, uint32_t color);
+  // A line of text. Lower case letters are drawn as upper case, characters
+  // the font does not have as a box. Returns the x after the text.
+  float AddText(float x, float y, const std::string &text, float scale,
+                uint32_t color);
+  // A bar graph of 'history' in a w x h box. Bars taller than 'budget' are
+  // drawn in a warning color and a line marks the budget.
+  void AddGraph(float x, float y, float w, float h,
+                const FrameHistory &history, float budget);
+
+  const std::vector<HudVertex> &GetVertices() const { return m_vertices; }
+  size_t GetQuadCount() const { return m_vertices.size() / 4; }
+
+private:
+  void AddQuad(float x, float y, float w, float h, float u0, float v0,
+               float u1, float v1, uint32_t color);
+
+  std::vector<HudVertex> m_vertices;
+};
+
+// Fills 'batch' with the overlay for 'stats' (GL free, so it can be tested
+// and benchmarked on its own). 'hudMilliseconds' is the HUD's own cost.
+void BuildPerfHud(HudBatch &batch, const FrameStats &stats,
+                  size_t gpuBytes, size_t cpuBytes, float hudMilliseconds);
+
+class PerfHud {
+public:
+  PerfHud() {}
+  ~PerfHud();
+  PerfHud(const PerfHud &) = delete;
+  PerfHud &operator=(const PerfHud &) = delete;
+
+  // Creates the atlas, the program and the buffers (needs a current
+  // context). Returns false if the program does not compile.
+  bool Create();
+  // Deletes the GL objects while the context is still alive
+  void Release();
+  bool IsCreated() const { return m_program != 0; }
+
+  void SetVisible(bool visible) { m_visible = visible; }
+  bool IsVisible() const { return m_visible; }
+  void Toggle() { m_visible = !m_visible; }
+
+  // Draws the overlay on top of whatever is bound (normally the default
+  // framebuffer) if it is visible. Blending is on and depth testing off
+  // while it draws; both are put back afterwards. The polygon mode is left
+  // at GL_FILL.
+  void Draw(int screenWidth, int screenHeight);
+
+  // Quads in the last Draw() and what the HUD itself cost on the CPU
+  size_t GetQuadCount() const { return m_batch.GetQuadCount(); }
+  float GetLastCost() const { return m_lastCost; }
+
+private:
+  HudBatch m_batch;
+  bool m_visible{false};
+  float m_lastCost{0.0f};
+
+  GLuint m_program{0};
+  GLint m_screenSizeLocation{-1};
+  GLuint m_atlas{0};
+  GLuint m_vao{0};
+  GLuint m_vbo{0};
+  GLuint m_ibo{0};
+  size_t m_vboBytes{0};
+};
+
+#endif
@@ -0,0 +1,100 @@
+/** @file RedrawScheduler.hpp
+ *  @brief Decides when a frame has to be drawn (on-demand rendering).
+ *
+ *  In on-demand mode a program only draws when something it shows has
+ *  changed: the camera, the model, a setting, the window (an expose or a
+ *  resize). The rest of the time it blocks in SDL_WaitEventTimeout() for
+ *  GetWaitTimeout() milliseconds, so a static scene costs (almost) no CPU
+ *  or GPU time.
+ *
+ *  Changes are reported with MarkDirty(), or found by Watch(): the program
+ *  hashes the state it draws from (HashState()) every iteration and the
+ *  scheduler compares it with the last one. After a change a few more
+ *  "settle" frames are drawn, so results that arrive late (GpuTimer
+ *  queries, the PerfHud graphs) and progressive effects reach the screen;
+ *  RequestFrames() asks for more. Both are bounded, the scene goes idle
+ *  again on its own.
+ *
+ *  Continuous mode draws every iteration, like before. Use it for
+ *  benchmarks (--continuous or ENGINE_REDRAW=continuous).
+ *
+ *  @bug No known bugs.
+ */
+#ifndef REDRAW_SCHEDULER_HPP
+#define REDRAW_SCHEDULER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+enum class RedrawMode { OnDemand, Continuous };
+
+const char *RedrawModeName(RedrawMode mode);
+// --continuous / --on-demand on the command line, then the environment
+// variable ENGINE_REDRAW ("continuous" or "on-demand"), else 'fallback'
+RedrawMode RedrawModeFromArgs(int argc, char **argv,
+                              RedrawMode fallback = RedrawMode::OnDemand);
+
+// FNV-1a, to fold the state a frame depends on into one value for Watch().
+// Pass the previous result as 'hash' to add more values.
+const uint64_t kHashStateSeed = 14695981039346656037ull;
+uint64_t HashState(const void *data, size_t size,
+                   uint64_t hash = kHashStateSeed);
+// The bytes of one plain value (a matrix, a float, an enum, ...)
+template <typename T>
+uint64_t HashValue(const T &value, uint64_t hash = kHashStateSeed) {
+  static_assert(std::is_trivially_copyable<T>::value, "hashes raw bytes");
+  return HashState(&value, sizeof(T), hash);
+}
+
+class RedrawScheduler {
+public:
+  // How long an idle program sleeps before it looks again (e.g. at a
+  // global mouse position that sends no events)
+  static const int kIdleTimeoutMs = 100;
+  // Frames drawn after every change (GpuTimer results are a few frames late)
+  static const int kSettleFrames = 4;
+  // Upper bound for RequestFrames()
+  static const int kMaxRequestedFrames = 256;
+
+  explicit RedrawScheduler(RedrawMode mode = RedrawMode::OnDemand)
+      : m_mode(mode) {}
+
+  RedrawMode GetMode() const { return m_mode; }
+  void SetMode(RedrawMode mode);
+  void ToggleMode();
+
+  // Something on screen changed: draw the next frame (and the settle frames)
+  void MarkDirty();
+  // Marks dirty if 'stateHash' differs from the last call
+  void Watch(uint64_t stateHash);
+  // Draw 'frames' more frames even if nothing changes (e.g. to converge a
+  // progressive effect). At most kMaxRequestedFrames are pending.
+  void RequestFrames(int frames);
+
+  // Called once per loop iteration, after input: true if this iteration
+  // draws. Consumes the dirty flag / one pending frame. After idle
+  // iterations it also tells FrameStats to discard the time spent asleep.
+  bool BeginFrame();
+  // True if BeginFrame() would draw
+  bool IsFrameDue() const;
+  // How long the loop may block for events before the next BeginFrame():
+  // 0 if a frame is due (or continuous), kIdleTimeoutMs otherwise
+  int GetWaitTimeout() const;
+
+  // Iterations that drew / did not draw since the start
+  uint64_t GetDrawnFrames() const { return m_drawn; }
+  uint64_t GetIdleWakeups() const { return m_idle; }
+
+private:
+  RedrawMode m_mode;
+  bool m_dirty{true}; // The first frame is always drawn
+  int m_pendingFrames{0};
+  bool m_hasHash{false};
+  uint64_t m_lastHash{0};
+  bool m_wasIdle{false};
+  uint64_t m_drawn{0};
+  uint64_t m_idle{0};
+};
+
+#endif
@@ -0,0 +1,60 @@
+/** @file Residency.hpp
+ *  @brief Describes where the data of a resource lives after it is uploaded.
+ *
+ *  Meshes and textures are built on the CPU and then copied to the GPU.
+ *  Once the copy is made most programs never look at the CPU data again, so
+ *  by default it is freed right after the upload. Resources that need to be
+ *  edited or re-uploaded keep everything, and resources used for picking or
+ *  collision keep only a compact copy of their positions and indices.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef RESIDENCY_HPP
+#define RESIDENCY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class Residency {
+  GpuOnly,     // Free every host copy right after the upload (default)
+  CpuAndGpu,   // Keep all host copies (e.g. for editing and re-uploading)
+  CpuCollision // Keep only positions and indices (picking / collision)
+};
+
+// Returns a printable name for a residency policy
+inline const char *ResidencyName(Residency residency) {
+  switch (residency) {
+  case Residency::GpuOnly:
+    return "GpuOnly";
+  case Residency::CpuAndGpu:
+    return "CpuAndGpu";
+  case Residency::CpuCollision:
+    return "CpuCollision";
+  }
+  return "Unknown";
+}
+
+// The compact copy kept by Residency::CpuCollision resources.
+// positions are stored as x,y,z triples, indices as triangle lists.
+struct CollisionMesh {
+  std::vector<float> positions;
+  std::vector<uint32_t> indices;
+
+  // Number of triangles
+  size_t GetTriangleCount() const { return indices.size() / 3; }
+  // Bytes held on the host
+  size_t GetSizeInBytes() const {
+    return positions.capacity() * sizeof(float) +
+           indices.capacity() * sizeof(uint32_t);
+  }
+  bool IsEmpty() const { return indices.empty(); }
+};
+
+// clear() keeps the allocation around, so swap with an empty vector to
+// actually give the memory back.
+template <typename T> void FreeVector(std::vector<T> &v) {
+  std::vector<T>().swap(v);
+}
+
+#endif
@@ -0,0 +1,243 @@
+/** @file SceneFile.hpp
+ *  @brief Scenes as data: nodes, lights and cameras, in a text form to
+ *         write by hand and a binary form that loads with one mapping.
+ *
+ *  A SceneDescription lists the nodes of a scene graph in order, each with
+ *  its parent, its transform and what to draw (a terrain from a heightmap,
+ *  or nothing for a node that only groups its children), with the paths
+ *  of its textures and shaders; then the point lights and the cameras.
+ *
+ *  The text form is one keyword per line, properties following the 'node',
+ *  'light' or 'camera' line they belong to (see ParseSceneText()). Paths
+ *  and names cannot contain spaces.
+ *
+ *  The binary form is what a program should load. Layout, little endian:
+ *    SceneFileHeader
+ *    SceneNodeRecord[nodeCount]
+ *    SceneLightRecord[lightCount]
+ *    SceneCameraRecord[cameraCount]
+ *    the strings, each terminated, each stored once
+ *  with every section at a multiple of 16 bytes. Records refer to strings
+ *  by their offset in the string block and to their parent by index.
+ *
+ *  SceneFile::Open() maps the file read only (see MappedFile.hpp) and
+ *  checks it once: the sections fit, parents come before their children,
+ *  every string offset lands in the block and the block is terminated.
+ *  After that the records are used where they are; only the section
+ *  offsets are turned into pointers, so no page is written to and a
+ *  scene of 100000 nodes opens in a few milliseconds.
+ *
+ *  LoadScene() takes either form and tells them apart by the magic.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef SCENE_FILE_HPP
+#define SCENE_FILE_HPP
+
+#include "DeferredShading.hpp"
+#include "MappedFile.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+const uint32_t kSceneFileVersion = 1;
+// A string reference that names no string
+const uint32_t kNoSceneString = 0xFFFFFFFFu;
+// Terrains have between 2 and this many segments along each side
+const uint32_t kMaxTerrainSegments = 4096;
+
+enum class SceneNodeKind : uint32_t {
+  Group = 0, // No object, only a transform for its children
+  Terrain,   // 'mesh' is the heightmap, 'segments' its resolution
+};
+
+// Printable name of a kind, as the text form spells it
+const char *SceneNodeKindName(SceneNodeKind kind);
+
+// Node flags
+const uint32_t kSceneNodeStatic = 1u; // Never moves (see Renderer::AddRenderable)
+
+struct SceneFileHeader {
+  char magic[8]; // "CS5310SC"
+  uint32_t version;
+  uint32_t nodeCount;
+  uint32_t lightCount;
+  uint32_t cameraCount;
+  uint64_t nodesOffset;
+  uint64_t lightsOffset;
+  uint64_t camerasOffset;
+  uint64_t stringsOffset;
+  uint64_t stringsSize;
+  uint64_t fileSize;
+};
+
+struct SceneNodeRecord {
+  int32_t parent; // An earlier node, or -1
+  SceneNodeKind kind;
+  uint32_t flags;
+  // Strings (or kNoSceneString)
+  uint32_t name;
+  uint32_t mesh;
+  uint32_t diffuse;
+  uint32_t detail;
+  uint32_t vertexShader;
+  uint32_t fragmentShader;
+  uint32_t segments[2]; // Terrains only
+  // Local transform: scaled, rotated about x, then y, then z (degrees),
+  // then translated
+  float translation[3];
+  float rotation[3];
+  float scale[3];
+};
+
+struct SceneLightRecord {
+  float position[3];
+  float color[3];
+  float ambientIntensity;
+  float specularStrength;
+  float constant;
+  float linear;
+  float quadratic;
+  uint32_t reserved;
+};
+
+struct SceneCameraRecord {
+  float eye[3];
+  float direction[3];
+};
+
+static_assert(sizeof(SceneFileHeader) == 72,
+              "the header is part of the format");
+static_assert(sizeof(SceneNodeRecord) == 80, "nodes are part of the format");
+static_assert(sizeof(SceneLightRecord) == 48, "lights are part of the format");
+static_assert(sizeof(SceneCameraRecord) == 24,
+              "cameras are part of the format");
+
+// A node as a program uses it; see SceneNodeRecord for the fields
+struct SceneNodeDesc {
+  std::string name;
+  int parent{-1};
+  SceneNodeKind kind{SceneNodeKind::Group};
+  bool isStatic{false};
+  std::string mesh;
+  std::string diffuse;
+  std::string detail;
+  std::string vertexShader;
+  std::string fragmentShader;
+  uint32_t segments[2] = {0, 0};
+  glm::vec3 translation{0.0f};
+  glm::vec3 rotation{0.0f};
+  glm::vec3 scale{1.0f};
+};
+
+struct SceneCameraDesc {
+  glm::vec3 eye{0.0f};
+  glm::vec3 direction{0.0f, 0.0f, -1.0f};
+};
+
+struct SceneDescription {
+  std::vector<SceneNodeDesc> nodes; // Parents first
+  std::vector<PointLight> lights;
+  std::vector<SceneCameraDesc> cameras;
+
+  void Clear();
+};
+
+// The node's local transform as a matrix
+glm::mat4 SceneNodeMatrix(const SceneNodeDesc &node);
+
+// Checks what the binary form relies on: parents come first, terrains have
+// a heightmap and a sane number of segments, every number is finite, names
+// are unique. Returns false and describes the first problem in 'error'.
+bool ValidateScene(const SceneDescription &scene,
+                   std::string *error = nullptr);
+
+// Reads the text form:
+//
+//   # A comment
+//   node terrain           starts a node; names are unique
+//     kind terrain         group (the default) or terrain
+//     parent world         an earlier node
+//     static
+//     mesh ./heights.ppm
+//     segments 512 512
+//     diffuse ./color.ppm
+//     detail ./detail.ppm
+//     shaders ./vert.glsl ./frag.glsl
+//     translate 0 0 0
+//     rotate 0 90 0
+//     scale 1 1 1
+//   light                  starts a light (PointLight's defaults)
+//     position 0 10 0
+//     color 1 1 1
+//     ambient 0.1
+//     specular 0.5
+//     attenuation 1 0.1 0.01   (constant, linear, quadratic)
+//   camera                 starts a camera
+//     eye 0 50 100
+//     direction 0 0 -1
+//
+// Indentation is for the reader. Returns false and says which line is wrong
+// in 'error'.
+bool ParseSceneText(const char *text, size_t length, SceneDescription &scene,
+                    std::string *error = nullptr);
+// The text form of a scene, without the properties that have their
+// default. Numbers are written so they read back the same.
+std::string WriteSceneText(const SceneDescription &scene);
+
+// The binary form of a scene. Fails like ValidateScene().
+bool CookScene(const SceneDescription &scene, std::vector<uint8_t> &out,
+               std::string *error = nullptr);
+bool WriteSceneFile(const std::string &path, const SceneDescription &scene,
+                    std::string *error = nullptr);
+
+// A binary scene, mapped. The records stay valid while it is open.
+class SceneFile {
+public:
+  SceneFile() {}
+  ~SceneFile();
+  SceneFile(const SceneFile &) = delete;
+  SceneFile &operator=(const SceneFile &) = delete;
+
+  // Returns false (and why in 'error') if the file is missing or damaged
+  bool Open(const std::string &path, std::string *error = nullptr);
+  void Close();
+  bool IsOpen() const { return m_header != nullptr; }
+
+  uint32_t GetNodeCount() const { return m_header->nodeCount; }
+  uint32_t GetLightCount() const { return m_header->lightCount; }
+  uint32_t GetCameraCount() const { return m_header->cameraCount; }
+  const SceneNodeRecord &GetNode(uint32_t i) const { return m_nodes[i]; }
+  const SceneLightRecord &GetLight(uint32_t i) const { return m_lights[i]; }
+  const SceneCameraRecord &GetCamera(uint32_t i) const {
+    return m_cameras[i];
+  }
+  // "" for kNoSceneString
+  const char *GetString(uint32_t offset) const {
+    return offset == kNoSceneString ? "" : m_strings + offset;
+  }
+  size_t GetSize() const { return m_file.GetSize(); }
+
+  // Copies the scene out of the mapping
+  void ToDescription(SceneDescription &scene) const;
+
+private:
+  bool Validate(std::string *error);
+
+  MappedFile m_file;
+  const SceneFileHeader *m_header{nullptr};
+  const SceneNodeRecord *m_nodes{nullptr};
+  const SceneLightRecord *m_lights{nullptr};
+  const SceneCameraRecord *m_cameras{nullptr};
+  const char *m_strings{nullptr};
+};
+
+// Reads a scene in either form
+bool LoadScene(const std::string &path, SceneDescription &scene,
+               std::string *error = nullptr);
+
+#endif
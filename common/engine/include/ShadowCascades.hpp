@@ -0,0 +1,126 @@
+/** @file ShadowCascades.hpp
+ *  @brief Cascaded shadow maps for a directional light, with cascades that
+ *         are only redrawn when they have to be.
+ *
+ *  The camera's view range is split into a few slices (practical split
+ *  scheme: a blend of logarithmic and uniform splits), and each slice gets
+ *  its own orthographic shadow map from the light, so texels near the
+ *  camera are small and far ones are large.
+ *
+ *  Each cascade covers the bounding sphere of its slice. The sphere does
+ *  not change size when the camera turns, and the light's projection is
+ *  moved in whole shadow map texels only, so the edges of shadows do not
+ *  shimmer while the camera moves.
+ *
+ *  Drawing every cascade every frame would cost about as much as drawing
+ *  the scene a few more times. The near cascades are small and are redrawn
+ *  every frame with everything in them; the far ones only hold static
+ *  geometry (terrain) and are drawn with some margin around their slice,
+ *  then kept until the light changes, the slice leaves the covered region
+ *  or the static geometry changes (Invalidate()). ShadowCascadeCache::Update()
+ *  returns which cascades need drawing.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef SHADOW_CASCADES_HPP
+#define SHADOW_CASCADES_HPP
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+// Cascades one shadow map array holds at most
+static const unsigned kMaxCascades = 4;
+
+struct ShadowSettings {
+  unsigned cascades{3};
+  // Cascades from this one on are cached and hold only static geometry
+  unsigned firstCached{1};
+  int resolution{1024}; // Texels along each side of a cascade's map
+  // 0: uniform splits, 1: logarithmic ones
+  float splitLambda{0.75f};
+  // How far behind a cascade (towards the light) casters are kept
+  float casterDistance{256.0f};
+  // Cached cascades cover their slice's sphere grown by this fraction
+  float cacheMargin{0.25f};
+};
+
+// Where the view range [near, far] is split: ends[i] is where cascade i
+// ends (view space distance), ends[count - 1] == far
+void ComputeCascadeSplits(float nearPlane, float farPlane, unsigned count,
+                          float lambda, float *ends);
+
+// Sphere around the part of a perspective camera's frustum between the
+// two distances, in world space. Its radius only depends on the
+// projection and the distances.
+void FrustumSliceSphere(const glm::mat4 &cameraView, float fovY, float aspect,
+                        float sliceNear, float sliceFar, glm::vec3 &center,
+                        float &radius);
+
+struct ShadowCascade {
+  glm::mat4 view{1.0f};
+  glm::mat4 projection{1.0f};
+  glm::mat4 viewProjection{1.0f}; // projection * view
+  glm::vec3 center{0.0f};         // The covered sphere
+  float radius{0.0f};
+  float end{0.0f}; // View space distance where the cascade ends
+};
+
+// Looks at the sphere along 'lightDirection' (from the light towards the
+// scene), with the projection snapped to whole texels of a 'resolution'
+// sized map.
+ShadowCascade FitShadowCascade(const glm::vec3 &center, float radius,
+                               const glm::vec3 &lightDirection,
+                               int resolution, float casterDistance);
+
+// The shaders' 'Shadows' block (std140)
+struct ShadowBlock {
+  glm::mat4 lightViewProjection[kMaxCascades];
+  glm::mat4 cameraView;   // To find a fragment's view space distance
+  glm::vec4 cascadeEnds;  // ShadowCascade::end of each cascade
+  glm::vec4 lightDirection;
+  glm::ivec4 count; // x: cascades in use, 0 when shadows are off
+};
+static_assert(sizeof(ShadowBlock) == 64 * kMaxCascades + 64 + 48,
+              "ShadowBlock is std140");
+
+struct ShadowCascadeStats {
+  uint64_t frames{0};
+  uint64_t drawn[kMaxCascades] = {}; // Times each cascade was drawn
+};
+
+class ShadowCascadeCache {
+public:
+  ShadowCascadeCache() {}
+
+  // Takes effect (redrawing everything) with the next Update()
+  void SetSettings(const ShadowSettings &settings);
+  const ShadowSettings &GetSettings() const { return m_settings; }
+
+  // Fits the cascades to this frame's camera and returns a mask of the
+  // ones that must be drawn (bit i for cascade i).
+  unsigned Update(const glm::mat4 &cameraView, float fovY, float aspect,
+                  float nearPlane, float farPlane,
+                  const glm::vec3 &lightDirection);
+  // The static geometry changed: the next Update() redraws everything
+  void Invalidate() { m_valid = 0; }
+
+  unsigned GetCount() const { return m_settings.cascades; }
+  const ShadowCascade &GetCascade(unsigned index) const {
+    return m_cascades[index];
+  }
+  bool IsCached(unsigned index) const {
+    return index >= m_settings.firstCached;
+  }
+  ShadowBlock GetBlock(const glm::mat4 &cameraView) const;
+  const ShadowCascadeStats &GetStats() const { return m_stats; }
+
+private:
+  ShadowSettings m_settings;
+  ShadowCascade m_cascades[kMaxCascades];
+  unsigned m_valid{0}; // Cached cascades drawn and still usable
+  glm::vec3 m_lightDirection{0.0f, -1.0f, 0.0f};
+  ShadowCascadeStats m_stats;
+};
+
+#endif
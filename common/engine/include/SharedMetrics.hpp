@@ -0,0 +1,156 @@
+/** @file SharedMetrics.hpp
+ *  @brief Publishes live metrics in POSIX shared memory for other processes.
+ *
+ *  A running program writes a MetricsSnapshot (frame counters, frame time
+ *  percentiles, memory, GPU object counts, cache mode and model) into a
+ *  small shared memory object once per frame. Any number of readers (e.g.
+ *  tools/MetricsReader.cpp) map the same object read only and copy the
+ *  snapshot out whenever they like.
+ *
+ *  Readers and the writer never wait for each other: the block is guarded
+ *  by a sequence lock. The writer makes the sequence odd, copies the
+ *  snapshot and makes it even again; a reader copies the snapshot and
+ *  retries if the sequence was odd or changed meanwhile. The snapshot is
+ *  copied as 64 bit relaxed atomics so the concurrent copy is well defined.
+ *
+ *  Not available on Windows (Open() returns false there).
+ *
+ *  @bug No known bugs.
+ */
+#ifndef SHARED_METRICS_HPP
+#define SHARED_METRICS_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+// Everything that is published. Fixed size fields only, so the layout is
+// the same in every process that includes this header.
+struct MetricsSnapshot {
+  uint64_t frameNumber;
+  uint64_t timestampMs; // Wall clock (milliseconds since 1970)
+  uint32_t processId;
+  int32_t cacheMode; // part1's index order (1-6), -1 if the program has none
+  // Frame times of the last FrameHistory::kSize frames
+  float frameMs; // Last frame
+  float frameAverageMs;
+  float frameP50Ms;
+  float frameP95Ms;
+  float frameP99Ms;
+  float frameMaxMs;
+  float gpuMs; // Average GPU time (0 if unknown)
+  // The last complete frame
+  uint32_t drawCalls;
+  uint64_t triangles;
+  uint32_t stateChanges;
+  uint32_t glErrors; // GLDebug counts (0 when the layer is compiled out)
+  uint32_t glPerformanceWarnings;
+  uint32_t filteredStateChanges; // Skipped by GLState
+  // Memory and live GPU objects from the ResourceTracker
+  uint64_t gpuBytes;
+  uint64_t cpuBytes;
+  uint32_t gpuObjects[8]; // Indexed by GpuResourceKind
+  char program[32];
+  char model[128];
+};
+
+static_assert(std::is_trivially_copyable<MetricsSnapshot>::value,
+              "the snapshot is copied word by word");
+static_assert(sizeof(MetricsSnapshot) % sizeof(uint64_t) == 0,
+              "the snapshot is copied word by word");
+
+// Fills the frame, memory and GL message fields from FrameStats, the
+// ResourceTracker and GLDebug. 'program', 'model' and 'cacheMode' are left
+// to the caller (see SetMetricsText).
+void CollectMetrics(MetricsSnapshot &out);
+// Copies 'text' into a fixed size field, always zero terminated
+template <size_t N>
+void SetMetricsText(char (&field)[N], const std::string &text) {
+  size_t length = text.size() < N - 1 ? text.size() : N - 1;
+  text.copy(field, length);
+  field[length] = '\0';
+}
+
+// Human readable dump of a snapshot
+void PrintMetrics(std::ostream &out, const MetricsSnapshot &snapshot);
+// One CSV line per snapshot, with a header line
+void WriteMetricsCsvHeader(std::ostream &out);
+void WriteMetricsCsvRow(std::ostream &out, const MetricsSnapshot &snapshot);
+
+// Shared memory object name for a program ("/cs5310_part1", ...). The
+// environment variable ENGINE_METRICS_SHM overrides it; setting it to "off"
+// returns "" (nothing is published).
+std::string MetricsName(const std::string &program);
+
+// What is in shared memory
+struct SharedMetricsBlock {
+  static const uint32_t kMagic = 0x424D5343; // "CSMB"
+  static const uint32_t kVersion = 2;
+  static const size_t kWords = sizeof(MetricsSnapshot) / sizeof(uint64_t);
+
+  uint32_t magic;
+  uint32_t version;
+  uint32_t snapshotSize;
+  uint32_t padding;
+  std::atomic<uint64_t> sequence; // Odd while the writer is copying
+  std::atomic<uint64_t> words[kWords];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "atomics in shared memory must not need a lock");
+
+// The writing side. One per shared memory object.
+class MetricsPublisher {
+public:
+  MetricsPublisher() {}
+  ~MetricsPublisher();
+  MetricsPublisher(const MetricsPublisher &) = delete;
+  MetricsPublisher &operator=(const MetricsPublisher &) = delete;
+
+  // Creates (or takes over) the shared memory object 'name', e.g.
+  // "/cs5310_part1". Returns false (see GetError()) if that fails.
+  bool Open(const std::string &name);
+  // Unmaps and removes the object
+  void Close();
+  bool IsOpen() const { return m_block != nullptr; }
+  const std::string &GetError() const { return m_error; }
+
+  // Never blocks
+  void Publish(const MetricsSnapshot &snapshot);
+
+private:
+  SharedMetricsBlock *m_block{nullptr};
+  std::string m_name;
+  std::string m_error;
+};
+
+// The reading side, for other processes
+class MetricsReader {
+public:
+  MetricsReader() {}
+  ~MetricsReader();
+  MetricsReader(const MetricsReader &) = delete;
+  MetricsReader &operator=(const MetricsReader &) = delete;
+
+  // Maps an existing object read only. Fails if nobody publishes under
+  // 'name' or the layout is from another version.
+  bool Open(const std::string &name);
+  void Close();
+  bool IsOpen() const { return m_block != nullptr; }
+  const std::string &GetError() const { return m_error; }
+
+  // Copies a consistent snapshot. Returns false if nothing was published
+  // yet or the writer was busy for 'maxAttempts' attempts in a row.
+  bool Read(MetricsSnapshot &out, int maxAttempts = 1000) const;
+  // Changes every time something is published
+  uint64_t GetSequence() const;
+
+private:
+  const SharedMetricsBlock *m_block{nullptr};
+  std::string m_error;
+};
+
+#endif
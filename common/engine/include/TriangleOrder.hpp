@@ -0,0 +1,60 @@
+/** @file TriangleOrder.hpp
+ *  @brief Reference orders for the triangles of an indexed mesh.
+ *
+ *  Baselines to judge a vertex cache optimizer (Forsyth) against:
+ *
+ *  - Random: a seeded shuffle of whole triangles, so the mesh still looks
+ *    the same (shuffling single indices would scramble the corners).
+ *  - Morton / Hilbert: triangles sorted along a space filling curve
+ *    through their centroids (quantized to 10 bits per axis, sorted with a
+ *    parallel radix sort). Spatially coherent without knowing the
+ *    connectivity; Hilbert never jumps, Morton sometimes does.
+ *  - Adversarial: a constructed bad case. The Morton order is written out
+ *    column by column with about sqrt(n) columns, so triangles that are
+ *    close in space end up about sqrt(n) triangles apart and every cache
+ *    smaller than that misses (almost) every vertex.
+ *
+ *  Every order keeps each triangle's corners together and in their
+ *  winding order, so the result draws exactly the same image.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef TRIANGLE_ORDER_HPP
+#define TRIANGLE_ORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class TriangleOrder { Random, Morton, Hilbert, Adversarial };
+
+const char *TriangleOrderName(TriangleOrder order);
+
+// Vertex positions inside an array of vertex structs
+struct PositionView {
+  const float *data; // x of vertex 0 (y and z follow)
+  size_t stride;     // Bytes from one vertex to the next
+
+  const float *Get(size_t vertex) const {
+    return reinterpret_cast<const float *>(
+        reinterpret_cast<const char *>(data) + vertex * stride);
+  }
+};
+
+// Writes the triangles of 'indices' ('count' indices, a triangle list) to
+// 'out' (also 'count' long, not the same array) in the given order. 'seed'
+// is only used by Random.
+void OrderTriangles(TriangleOrder order, const uint32_t *indices,
+                    size_t count, const PositionView &positions,
+                    uint32_t *out, uint64_t seed = 1);
+
+// 10 bit coordinates (0..1023) to a 30 bit key along the curve
+uint32_t MortonKey(uint32_t x, uint32_t y, uint32_t z);
+uint32_t HilbertKey(uint32_t x, uint32_t y, uint32_t z);
+
+// Sorts 'keys' and moves 'values' along (stable, least significant digit
+// first, 8 bits per pass). Big arrays are split over the threads.
+void RadixSortPairs(std::vector<uint32_t> &keys, std::vector<uint32_t> &values,
+                    unsigned threads = 0);
+
+#endif
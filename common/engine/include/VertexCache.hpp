@@ -0,0 +1,54 @@
+/** @file VertexCache.hpp
+ *  @brief Simulates a GPU's post-transform vertex cache on an index list.
+ *
+ *  The result is the ACMR (average cache miss ratio: vertex shader runs per
+ *  triangle, 0.5 at best on a big regular mesh, 3 when nothing is reused)
+ *  and the ATVR (runs per unique vertex, 1 is perfect). Both cache models
+ *  found in hardware are supported: a FIFO (a hit does not move the
+ *  vertex, most GPUs) and an LRU (a hit moves it to the front, what
+ *  Forsyth's optimizer assumes).
+ *
+ *  @bug No known bugs.
+ */
+#ifndef VERTEX_CACHE_HPP
+#define VERTEX_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class VertexCacheKind { Fifo, Lru };
+
+// A cache to optimize for, e.g. {Fifo, 16}
+struct VertexCacheModel {
+  VertexCacheKind kind;
+  int size; // Entries, 1 .. kMaxSize
+  static const int kMaxSize = 64;
+};
+
+// "fifo16", "lru32", ...
+std::string VertexCacheModelName(const VertexCacheModel &model);
+// Parses what VertexCacheModelName() returns. False if malformed.
+bool ParseVertexCacheModel(const std::string &name, VertexCacheModel &out);
+
+struct VertexCacheStats {
+  size_t triangles{0};
+  size_t uniqueVertices{0}; // Vertices the indices refer to
+  size_t misses{0};         // Vertex shader invocations
+
+  double GetAcmr() const {
+    return triangles == 0 ? 0.0 : static_cast<double>(misses) / triangles;
+  }
+  double GetAtvr() const {
+    return uniqueVertices == 0 ? 0.0
+                               : static_cast<double>(misses) / uniqueVertices;
+  }
+};
+
+// Runs 'count' indices (a triangle list) through an empty cache.
+// 'vertexCount' must be larger than every index.
+VertexCacheStats SimulateVertexCache(const uint32_t *indices, size_t count,
+                                     size_t vertexCount,
+                                     const VertexCacheModel &model);
+
+#endif
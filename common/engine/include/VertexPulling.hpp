@@ -0,0 +1,173 @@
+/** @file VertexPulling.hpp
+ *  @brief Meshes in shared buffers that the vertex shader reads itself.
+ *
+ *  With attribute pointers every vertex format (and, in practice, every
+ *  mesh) needs its own vertex array, and switching them is one of the
+ *  costlier binds. A VertexPool keeps the vertices and indices of many
+ *  meshes in two large buffers instead and draws all of them with one
+ *  empty vertex array: the vertex shader fetches index gl_VertexID from the
+ *  index buffer, adds the mesh's base vertex and fetches and decodes that
+ *  vertex ("vertex pulling").
+ *
+ *  Since the shader does the decoding, the vertices can be stored
+ *  compressed. A PackedVertex is 16 bytes where the layout used by
+ *  Assignment10_fbo's VertexBufferLayout takes 56: the position and the
+ *  texture coordinates are 16 bit fixed point within the mesh's bounds
+ *  (VertexQuantization, sent with each draw), the normal is an octahedral
+ *  direction (OctahedralEncode() in Impostor.hpp) in 2 x 16 bits.
+ *
+ *  The buffers are texture buffers (OpenGL 3.1), so it works in the 3.3
+ *  contexts our programs ask for; the shader reads them with texelFetch on
+ *  a usamplerBuffer. A shader that pulls looks like this:
+ *
+ *    uniform usamplerBuffer u_PulledVertices; // VertexPool::kVertexUnit
+ *    uniform usamplerBuffer u_PulledIndices;  // VertexPool::kIndexUnit
+ *    layout(std140) uniform PulledMesh {      // PulledMeshBlock
+ *      vec4 positionMin; vec4 positionScale; vec4 texCoordRange;
+ *      ivec4 offsets;
+ *    };
+ *    ...
+ *    int index = int(texelFetch(u_PulledIndices, gl_VertexID).r) +
+ *                offsets.x;
+ *    uvec4 vertex = texelFetch(u_PulledVertices, index);
+ *    // position: vertex.x (x, y) and vertex.y (z), 16 bits each, low first
+ *    // normal: vertex.z, octahedral (x, y); texCoord: vertex.w (s, t)
+ *
+ *  and is drawn with glDrawArrays(GL_TRIANGLES, firstIndex, indexCount).
+ *
+ *  @bug No known bugs.
+ */
+#ifndef VERTEX_PULLING_HPP
+#define VERTEX_PULLING_HPP
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One vertex, as the shaders fetch it (one RGBA32UI texel)
+struct PackedVertex {
+  uint32_t positionXY{0}; // 16 bit fixed point x (low) and y (high)
+  uint32_t positionZ{0};  // z in the low 16 bits, the rest unused
+  uint32_t normal{0};     // Octahedral direction, 16 bits per component
+  uint32_t texCoord{0};   // 16 bit fixed point s (low) and t (high)
+};
+static_assert(sizeof(PackedVertex) == 16, "one RGBA32UI texel per vertex");
+
+// Maps the 16 bit values back: value = min + scale * fixed / 65535
+struct VertexQuantization {
+  glm::vec3 positionMin{0.0f};
+  glm::vec3 positionScale{0.0f};
+  glm::vec2 texCoordMin{0.0f};
+  glm::vec2 texCoordScale{0.0f};
+};
+
+// Where the attributes of an interleaved float vertex buffer are, in floats
+// from the start of a vertex. -1: the vertices do not have it.
+struct VertexStreams {
+  const float *data{nullptr};
+  size_t vertexCount{0};
+  size_t stride{0};
+  int position{0};
+  int normal{-1};
+  int texCoord{-1};
+};
+
+// Packs the vertices into 'out' and returns the bounds they were quantized
+// to. Normals that are zero become straight up.
+VertexQuantization PackVertices(const VertexStreams &streams,
+                                std::vector<PackedVertex> &out);
+// What the shader makes of a packed vertex (for tests and tools)
+glm::vec3 UnpackPosition(const PackedVertex &vertex,
+                         const VertexQuantization &quantization);
+glm::vec3 UnpackNormal(const PackedVertex &vertex);
+glm::vec2 UnpackTexCoord(const PackedVertex &vertex,
+                         const VertexQuantization &quantization);
+
+// The shaders' 'PulledMesh' block (std140), per draw
+struct PulledMeshBlock {
+  glm::vec4 positionMin;
+  glm::vec4 positionScale;
+  glm::vec4 texCoord;  // Min (xy) and scale (zw)
+  glm::ivec4 offsets;  // x: base vertex
+};
+static_assert(sizeof(PulledMeshBlock) == 64, "PulledMeshBlock is std140");
+
+// A mesh in a pool. Draw it with glDrawArrays(mode, firstIndex, indexCount)
+// and its block bound.
+struct PulledMesh {
+  uint32_t firstIndex{0};
+  uint32_t indexCount{0};
+  int32_t baseVertex{0};
+  VertexQuantization quantization;
+
+  bool IsValid() const { return indexCount > 0; }
+  PulledMeshBlock GetBlock() const;
+};
+
+class VertexPool {
+public:
+  // Texture units the buffers are bound to by Bind(), out of the way of
+  // the material textures
+  static const unsigned kVertexUnit = 14;
+  static const unsigned kIndexUnit = 15;
+
+  VertexPool() {}
+  ~VertexPool();
+  VertexPool(const VertexPool &) = delete;
+  VertexPool &operator=(const VertexPool &) = delete;
+
+  // Makes the vertex array (the buffers grow with Add()); needs a current
+  // context
+  bool Create();
+  void Release();
+  bool IsCreated() const { return m_vertexArray != 0; }
+
+  // Appends a mesh (GL thread). Indices count from the mesh's first
+  // vertex. Returns an invalid mesh, see GetError(), if the pool would
+  // outgrow GL_MAX_TEXTURE_BUFFER_SIZE.
+  PulledMesh Add(const std::vector<PackedVertex> &vertices,
+                 const uint32_t *indices, size_t indexCount,
+                 const VertexQuantization &quantization);
+
+  // Binds the empty vertex array and the two buffers (through GLState)
+  void Bind() const;
+  // Binds only the buffers, for draws that bind the vertex array
+  // themselves (recorded commands)
+  void BindBuffers() const;
+  GLuint GetVertexArray() const { return m_vertexArray; }
+
+  size_t GetVertexCount() const { return m_vertexCount; }
+  size_t GetIndexCount() const { return m_indexCount; }
+  const std::string &GetError() const { return m_error; }
+
+private:
+  // A growing buffer with a texture buffer view
+  struct Store {
+    GLuint buffer{0};
+    GLuint texture{0};
+    size_t capacity{0}; // Elements
+  };
+  // Makes room for 'count' elements of 'bytes' each, keeping the 'used'
+  // ones. The texture is bound to 'unit' to attach the buffer.
+  void Reserve(Store &store, size_t used, size_t count, size_t bytes,
+               GLenum format, unsigned unit, const char *owner);
+  void ReleaseStore(Store &store);
+
+  GLuint m_vertexArray{0};
+  Store m_vertices;
+  Store m_indices;
+  size_t m_vertexCount{0};
+  size_t m_indexCount{0};
+  size_t m_maxTexels{0}; // GL_MAX_TEXTURE_BUFFER_SIZE
+  std::string m_error;
+};
+
+// ENGINE_VERTEX_PULLING=on draws meshes from a VertexPool where a program
+// supports it; off (the default) keeps the vertex arrays
+bool VertexPullingFromEnvironment();
+
+#endif
@@ -0,0 +1,380 @@
+/** @file VirtualTexture.hpp
+ *  @brief A texture far larger than the GPU memory it takes, streamed in
+ *         pages as the camera needs them.
+ *
+ *  A terrain's unique texture (the color map with the detail map baked
+ *  into it, see ComposeDetailTexture()) is cooked once into a page file:
+ *  its whole mip chain cut into square pages, each stored with a border of
+ *  its neighbours' texels so it can be filtered on its own. Only a fixed
+ *  number of pages is on the GPU at a time, in one physical cache texture,
+ *  so the memory it takes does not depend on the size of the texture.
+ *
+ *  Every frame:
+ *    - a small feedback pass draws the scene into a buffer a few times
+ *      smaller than the screen, writing the page and level each pixel
+ *      would sample (RGBA8: page x, page y, level, 255), and reads it back
+ *      through a pixel buffer (VirtualTextureFeedback)
+ *    - a few frames later the readback is done, CollectFeedbackPages()
+ *      turns it into the distinct pages seen (and their coarser ancestors)
+ *    - the pages that are not in the cache are read a few at a time
+ *      (PageStreamer, through AsyncFileReader::ReadRange), most wanted
+ *      (coarsest) first
+ *    - Update() copies the pages read since into free or least recently
+ *      seen slots of the cache (VirtualPageCache) and rewrites the page
+ *      table: per level, one texel per page with the slot of the page or
+ *      of its nearest coarser page in the cache
+ *
+ *  The shader picks the level from the derivatives of the texture
+ *  coordinates, finds the page table entry with texelFetch and samples the
+ *  slot bilinearly. A missing page falls back to a coarser one, so the
+ *  texture is blurry for a few frames instead of wrong. The single page of
+ *  the coarsest level is read when the texture is created and never
+ *  evicted.
+ *
+ *  Page file layout, little endian: VirtualTextureHeader, then every
+ *  page, level 0 first and row by row (rows bottom up), each
+ *  (pageSize + 2 border)^2 RGB8 texels.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef VIRTUAL_TEXTURE_HPP
+#define VIRTUAL_TEXTURE_HPP
+
+#include "AsyncFileIO.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+const uint32_t kVirtualTextureVersion = 1;
+// Pages along a level and slots along the cache are stored in 8 bits
+const uint32_t kMaxVirtualPages = 256;
+
+struct VirtualTextureHeader {
+  char magic[8]; // "CS5310VT"
+  uint32_t version;
+  uint32_t size;     // Texels along each side of level 0
+  uint32_t pageSize; // Texels along each side of a page, border excluded
+  uint32_t border;   // Texels of the neighbours around each page
+  uint32_t levels;   // The last one is a single page
+  uint32_t pageCount;
+};
+static_assert(sizeof(VirtualTextureHeader) == 32, "no padding");
+
+struct PageId {
+  uint32_t x{0};
+  uint32_t y{0};
+  uint32_t level{0};
+};
+
+inline bool operator==(const PageId &a, const PageId &b) {
+  return a.x == b.x && a.y == b.y && a.level == b.level;
+}
+
+// Level in the top 8 bits, so larger keys are coarser pages
+inline uint32_t PageKey(const PageId &page) {
+  return (page.level << 24) | (page.y << 12) | page.x;
+}
+inline PageId PageFromKey(uint32_t key) {
+  PageId page;
+  page.x = key & 0xfffu;
+  page.y = (key >> 12) & 0xfffu;
+  page.level = key >> 24;
+  return page;
+}
+
+// Pages along each side of a level
+inline uint32_t PagesPerSide(const VirtualTextureHeader &header,
+                             uint32_t level) {
+  return (header.size / header.pageSize) >> level;
+}
+// RGB8 bytes of one page, border included
+inline size_t PageBytes(const VirtualTextureHeader &header) {
+  size_t side = header.pageSize + 2 * header.border;
+  return side * side * 3;
+}
+// Where a page is in the file, counted in pages
+uint32_t PageIndex(const VirtualTextureHeader &header, const PageId &page);
+// Where a page starts in the file, in bytes. False if the page is outside
+// the texture.
+bool PageOffset(const VirtualTextureHeader &header, const PageId &page,
+                uint64_t &offset);
+
+// The terrain's unique texture, 'size' x 'size' RGB8 texels: 'color'
+// stretched over all of it, times 'detail' repeated 'detailRepeat' times
+// along each side. The detail is divided by its mean and blended in by
+// half, so it adds texture without changing the brightness. Both images
+// are sampled bilinearly like OpenGL would (rows bottom up).
+void ComposeDetailTexture(const uint8_t *color, uint32_t colorWidth,
+                          uint32_t colorHeight, const uint8_t *detail,
+                          uint32_t detailWidth, uint32_t detailHeight,
+                          uint32_t detailRepeat, uint32_t size,
+                          std::vector<uint8_t> &out);
+
+// Builds the mip chain of a 'size' x 'size' RGB8 image and writes it as a
+// page file. 'size' must be 'pageSize' times a power of two, with at most
+// kMaxVirtualPages pages along level 0.
+bool WriteVirtualTexture(const std::string &path, const uint8_t *rgb,
+                         uint32_t size, uint32_t pageSize, uint32_t border,
+                         std::string *error = nullptr);
+
+// Reads pages of a page file. Not thread safe: one thread per reader.
+class VirtualTextureFile {
+public:
+  VirtualTextureFile() {}
+
+  // Checks the header against the file's size
+  bool Open(const std::string &path, std::string *error = nullptr);
+  void Close();
+  bool IsOpen() const { return m_file.is_open(); }
+  const VirtualTextureHeader &GetHeader() const { return m_header; }
+  // Reads PageBytes() bytes into 'out'
+  bool ReadPage(const PageId &page, uint8_t *out);
+
+private:
+  std::ifstream m_file;
+  VirtualTextureHeader m_header{};
+};
+
+// The distinct pages a feedback buffer asks for, and every coarser page
+// above them, coarsest first. Pixels with alpha 0 saw no virtual texture;
+// entries outside the texture are ignored.
+void CollectFeedbackPages(const uint8_t *rgba, size_t pixels,
+                          const VirtualTextureHeader &header,
+                          std::vector<PageId> &pages);
+
+// Which page is in which slot of the physical cache, and the page table
+// that tells the shaders. CPU only.
+class VirtualPageCache {
+public:
+  VirtualPageCache() {}
+
+  // Empties the cache: 'slotsPerSide'^2 slots for a texture of 'levels'
+  // levels with 'pagesPerSide' pages along level 0
+  void Reset(uint32_t pagesPerSide, uint32_t levels, uint32_t slotsPerSide);
+  // A new feedback frame: 'pages' were seen, so their slots are kept
+  // until a later one. Appends the pages not in the cache to 'missing'.
+  void Touch(const std::vector<PageId> &pages, std::vector<PageId> &missing);
+  // Finds a slot for 'page': a free one, else the one of the page seen
+  // longest ago if that was before the current frame. The page of the
+  // coarsest level is never evicted. Returns false if every slot is in
+  // use (the page is dropped and asked for again by a later frame).
+  bool Insert(const PageId &page, uint32_t &slot, PageId *evicted = nullptr);
+  // -1 if the page is not in the cache
+  int FindSlot(const PageId &page) const;
+  size_t GetResidentCount() const { return m_resident.size(); }
+  uint32_t GetSlotsPerSide() const { return m_slotsPerSide; }
+  // The page table texels of one level, (pagesPerSide >> level)^2 RGBA8
+  // values, rows bottom up: the slot (x, y) and the level of the page or
+  // of its nearest coarser page in the cache, 255; zero if there is none.
+  const std::vector<uint8_t> &GetTable(uint32_t level);
+  // True once after every change, when the page table must be uploaded
+  bool TakeChanged();
+
+private:
+  void RebuildTables();
+
+  struct Slot {
+    uint32_t key{0};
+    uint64_t lastSeen{0};
+    bool used{false};
+  };
+  uint32_t m_pagesPerSide{0};
+  uint32_t m_levels{0};
+  uint32_t m_slotsPerSide{0};
+  std::vector<Slot> m_slots;
+  std::unordered_map<uint32_t, uint32_t> m_resident; // PageKey -> slot
+  std::vector<std::vector<uint8_t>> m_tables;
+  uint64_t m_frame{0};
+  bool m_tablesStale{true};
+  bool m_changed{false};
+};
+
+struct LoadedPage {
+  PageId page;
+  std::vector<uint8_t> pixels; // PageBytes()
+};
+
+// Reads pages through an AsyncFileReader, kPagesInFlight at a time, and
+// hands them over in the order they were asked for
+class PageStreamer {
+public:
+  static const size_t kPagesInFlight = 8;
+
+  // Reads through 'reader', AsyncFileReader::Instance() if null. The
+  // reader must outlive the streamer.
+  explicit PageStreamer(AsyncFileReader *reader = nullptr)
+      : m_reader(reader) {}
+  // Stop()s
+  ~PageStreamer();
+  PageStreamer(const PageStreamer &) = delete;
+  PageStreamer &operator=(const PageStreamer &) = delete;
+
+  bool Start(const std::string &path, std::string *error = nullptr);
+  // Drops the pages not read yet and waits for the reads in flight
+  void Stop();
+  // The pages to read, most wanted first. Replaces the ones not read yet;
+  // pages being read or read and not taken yet are skipped.
+  void SetRequests(const std::vector<PageId> &pages);
+  // Appends the pages read since the last call
+  void TakeLoaded(std::vector<LoadedPage> &pages);
+  // Pages asked for and not taken yet
+  size_t GetPending() const;
+  uint64_t GetBytesRead() const;
+  uint64_t GetFailures() const;
+
+private:
+  struct Read {
+    LoadedPage loaded;
+    bool done{false};
+    bool ok{false};
+  };
+
+  // Starts reads from the front of m_queue while there is room; with
+  // m_mutex held
+  void IssueReads();
+  // The callback of a read (a reader thread)
+  void Finish(Read &read, FileReadResult &result);
+
+  AsyncFileReader *m_reader;
+  std::string m_path;
+  VirtualTextureHeader m_header{};
+  mutable std::mutex m_mutex;
+  std::condition_variable m_idle; // m_reading became empty
+  std::deque<PageId> m_queue;
+  std::deque<std::unique_ptr<Read>> m_reading; // In flight, in order
+  std::unordered_set<uint32_t> m_busy; // Being read, or read and not taken
+  std::vector<LoadedPage> m_loaded;
+  uint64_t m_bytesRead{0};
+  uint64_t m_failures{0};
+  bool m_started{false};
+};
+
+// The shaders' 'VirtualTexture' block (std140)
+struct VirtualTextureBlock {
+  // x: texels along level 0, y: pages along level 0, z: levels,
+  // w: log2 of how much smaller the feedback buffer is than the screen
+  glm::vec4 layout;
+  // x: page texels without the border, y: border, z: slots along the
+  // cache, w: texels along the cache
+  glm::vec4 cache;
+};
+static_assert(sizeof(VirtualTextureBlock) == 32,
+              "VirtualTextureBlock is std140");
+
+struct VirtualTextureStats {
+  size_t resident{0}; // Pages in the cache
+  size_t slots{0};
+  size_t missing{0}; // Pages the last feedback wanted that were not there
+  size_t pending{0}; // Asked for and not uploaded yet
+  uint64_t uploaded{0};
+  uint64_t evicted{0};
+  uint64_t dropped{0}; // Read, but every slot was in use
+  uint64_t bytesRead{0};
+  size_t cacheBytes{0}; // GPU memory of the cache and the page table
+  size_t tableBytes{0};
+  uint64_t virtualBytes{0}; // What the whole mip chain would take
+};
+
+// The cache and page table textures, fed by a PageStreamer
+class VirtualTexture {
+public:
+  VirtualTexture() {}
+  ~VirtualTexture();
+  VirtualTexture(const VirtualTexture &) = delete;
+  VirtualTexture &operator=(const VirtualTexture &) = delete;
+
+  // Opens a page file and makes a cache of 'slotsPerSide'^2 pages (needs
+  // a current context). The coarsest page is read right away.
+  bool Create(const std::string &path, uint32_t slotsPerSide = 16,
+              std::string *error = nullptr);
+  void Release();
+  bool IsCreated() const { return m_cacheTexture != 0; }
+
+  // The pages a feedback readback saw (CollectFeedbackPages()); the
+  // missing ones are read in the background
+  void Request(const std::vector<PageId> &pages);
+  // Copies up to 'maxUploads' of the pages read since into the cache and
+  // updates the page table. Returns true if the texture looks different.
+  bool Update(uint32_t maxUploads = 16);
+  // Pages are still on their way
+  bool IsStreaming() const;
+
+  // The feedback buffer is 'scale' times smaller than the screen
+  void SetFeedbackScale(int scale) { m_feedbackScale = scale; }
+  GLuint GetPageTable() const { return m_tableTexture; }
+  GLuint GetPageCache() const { return m_cacheTexture; }
+  VirtualTextureBlock GetBlock() const;
+  const VirtualTextureHeader &GetHeader() const { return m_header; }
+  VirtualTextureStats GetStats() const;
+  // The stats, one line each
+  void PrintReport(std::ostream &out) const;
+
+private:
+  void UploadPage(uint32_t slot, const uint8_t *pixels);
+  void UploadTable();
+
+  VirtualTextureHeader m_header{};
+  VirtualPageCache m_pages;
+  PageStreamer m_streamer;
+  std::vector<LoadedPage> m_loaded;
+  GLuint m_cacheTexture{0};
+  GLuint m_tableTexture{0};
+  int m_feedbackScale{1};
+  size_t m_missing{0};
+  uint64_t m_uploaded{0};
+  uint64_t m_evicted{0};
+  uint64_t m_dropped{0};
+};
+
+// The framebuffer the feedback pass draws into, and its readback
+class VirtualTextureFeedback {
+public:
+  VirtualTextureFeedback() {}
+  ~VirtualTextureFeedback();
+  VirtualTextureFeedback(const VirtualTextureFeedback &) = delete;
+  VirtualTextureFeedback &operator=(const VirtualTextureFeedback &) = delete;
+
+  // A buffer 'scale' times smaller than 'width' x 'height'
+  bool Create(int width, int height, int scale);
+  void Release();
+  bool IsCreated() const { return m_framebuffer != 0; }
+  int GetScale() const { return m_scale; }
+
+  // Binds the framebuffer and its viewport, and clears it
+  void Begin();
+  // Starts copying it into a pixel buffer, to be read a few frames later
+  void End();
+  // The pages of the newest readback that finished since the last call
+  bool Poll(const VirtualTextureHeader &header, std::vector<PageId> &pages);
+  // Readbacks still in flight
+  bool IsPending() const;
+
+private:
+  static const int kBuffers = 3;
+  GLuint m_framebuffer{0};
+  GLuint m_renderbuffers[2] = {}; // Color, depth
+  GLuint m_pixelBuffers[kBuffers] = {};
+  GLsync m_fences[kBuffers] = {};
+  int m_next{0};
+  int m_width{0};
+  int m_height{0};
+  int m_scale{1};
+};
+
+// True if ENGINE_VIRTUAL_TEXTURE is "on"
+bool VirtualTextureFromEnvironment();
+
+#endif
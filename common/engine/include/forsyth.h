@@ -30,21 +30,52 @@
  * Copyright (c) 2014, Ivan Vashchaev
  */
 
+/*
+ * Altered for this project:
+ * 32 bit vertex indices (16 bit ones silently wrapped on large meshes)
+ * score function parameters passed at runtime (ForsythParams), so they can
+ * be tuned per vertex cache (see ForsythTuner.hpp); no global tables, so
+ * it can run on several threads at once
+ */
+
 #ifndef FORSYTH_H
 #define FORSYTH_H
 
 #include <stdint.h>
 
-typedef uint16_t ForsythVertexIndexType;
+typedef uint32_t ForsythVertexIndexType;
+
+// Largest cache size the optimizer can model
+#define FORSYTH_MAX_VERTEX_CACHE_SIZE 32
+
+// The score function. A vertex scores for its position i in the simulated
+// LRU cache (lastTriScore for the three of the last triangle, then
+// (1 - (i - 3) / 29) ^ cacheDecayPower) plus
+// valenceBoostScale * remainingTriangles ^ -valenceBoostPower.
+typedef struct ForsythParams {
+  int cacheSize;           // 4 .. FORSYTH_MAX_VERTEX_CACHE_SIZE
+  float cacheDecayPower;
+  float lastTriScore;
+  float valenceBoostScale;
+  float valenceBoostPower;
+} ForsythParams;
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Forsyth's published values (cache 24, 1.5, 0.75, 2.0, 0.5)
+ForsythParams forsythDefaultParams(void);
+
+// Returns NULL if a vertex is shared by more than 255 triangles
 ForsythVertexIndexType *
 forsythReorderIndices(ForsythVertexIndexType *outIndices,
                       const ForsythVertexIndexType *indices, int nTriangles,
                       int nVertices);
+// Same with other score function parameters (NULL for the defaults)
+ForsythVertexIndexType *forsythReorderIndicesWithParams(
+    ForsythVertexIndexType *outIndices, const ForsythVertexIndexType *indices,
+    int nTriangles, int nVertices, const ForsythParams *params);
 
 #ifdef __cplusplus
 }
@@ -62,13 +93,11 @@ forsythReorderIndices(ForsythVertexIndexType *outIndices,
 extern "C" {
 #endif
 
-// Set these to adjust the performance and result quality
-#define FORSYTH_VERTEX_CACHE_SIZE 24
+// Length of the cache position score curve (independent of the cache size)
 #define FORSYTH_CACHE_FUNCTION_LENGTH 32
 
 // The size of these data types affect the memory usage
 typedef uint16_t ForsythScoreType;
-#define FORSYTH_SCORE_SCALING 7281
 
 typedef uint8_t ForsythAdjacencyType;
 #define FORSYTH_MAX_ADJACENCY UINT8_MAX
@@ -78,29 +107,48 @@ typedef int32_t ForsythTriangleIndexType;
 typedef int32_t ForsythArrayIndexType;
 
 // The size of the precalculated tables
-#define FORSYTH_CACHE_SCORE_TABLE_SIZE 32
+#define FORSYTH_CACHE_SCORE_TABLE_SIZE FORSYTH_MAX_VERTEX_CACHE_SIZE
 #define FORSYTH_VALENCE_SCORE_TABLE_SIZE 32
-#if FORSYTH_CACHE_SCORE_TABLE_SIZE < FORSYTH_VERTEX_CACHE_SIZE
-#error Vertex score table too small
-#endif
 
-// Precalculated tables
-static ForsythScoreType
-    forsythCachePositionScore[FORSYTH_CACHE_SCORE_TABLE_SIZE];
-static ForsythScoreType forsythValenceScore[FORSYTH_VALENCE_SCORE_TABLE_SIZE];
+// Precalculated tables, one set per call
+typedef struct ForsythTables {
+  int cacheSize;
+  ForsythScoreType cachePositionScore[FORSYTH_CACHE_SCORE_TABLE_SIZE];
+  ForsythScoreType valenceScore[FORSYTH_VALENCE_SCORE_TABLE_SIZE];
+} ForsythTables;
 
 #define FORSYTH_ISADDED(x) (triangleAdded[(x) >> 3] & (1 << (x & 7)))
 #define FORSYTH_SETADDED(x) (triangleAdded[(x) >> 3] |= (1 << (x & 7)))
 
-// Score function constants
-#define FORSYTH_CACHE_DECAY_POWER 1.5
-#define FORSYTH_LAST_TRI_SCORE 0.75
-#define FORSYTH_VALENCE_BOOST_SCALE 2.0
-#define FORSYTH_VALENCE_BOOST_POWER 0.5
+ForsythParams forsythDefaultParams(void) {
+  ForsythParams params;
+  params.cacheSize = 24;
+  params.cacheDecayPower = 1.5f;
+  params.lastTriScore = 0.75f;
+  params.valenceBoostScale = 2.0f;
+  params.valenceBoostPower = 0.5f;
+  return params;
+}
 
 // Precalculate the tables
-static void forsythInit() {
-  for (int i = 0; i < FORSYTH_CACHE_SCORE_TABLE_SIZE; i++) {
+static void forsythInit(ForsythTables *tables, const ForsythParams *params) {
+  int cacheSize = params->cacheSize;
+  if (cacheSize < 4)
+    cacheSize = 4;
+  if (cacheSize > FORSYTH_MAX_VERTEX_CACHE_SIZE)
+    cacheSize = FORSYTH_MAX_VERTEX_CACHE_SIZE;
+  tables->cacheSize = cacheSize;
+
+  // A triangle scores the sum of three vertices and must fit the 16 bit
+  // score type. With the default parameters this is the original 7281.
+  float lastTri = params->lastTriScore > 0.0f ? params->lastTriScore : 0.0f;
+  float valence =
+      params->valenceBoostScale > 0.0f ? params->valenceBoostScale : 0.0f;
+  float maxVertexScore = (lastTri > 1.0f ? lastTri : 1.0f) + valence;
+  float scaling = floorf(65535.0f / (3.0f * maxVertexScore));
+
+  memset(tables->cachePositionScore, 0, sizeof(tables->cachePositionScore));
+  for (int i = 0; i < cacheSize; i++) {
     float score = 0;
     if (i < 3) {
       // This vertex was used in the last triangle,
@@ -108,28 +156,29 @@ static void forsythInit() {
       // it's in. Otherwise, you can get very different
       // answers depending on whether you add
       // the triangle 1,2,3 or 3,1,2 - which is silly
-      score = FORSYTH_LAST_TRI_SCORE;
+      score = lastTri;
     } else {
       // Points for being high in the cache.
       const float scaler = 1.0f / (FORSYTH_CACHE_FUNCTION_LENGTH - 3);
       score = 1.0f - (i - 3) * scaler;
-      score = powf(score, FORSYTH_CACHE_DECAY_POWER);
+      score = powf(score, params->cacheDecayPower);
     }
-    forsythCachePositionScore[i] =
-        (ForsythScoreType)(FORSYTH_SCORE_SCALING * score);
+    tables->cachePositionScore[i] = (ForsythScoreType)(scaling * score);
   }
 
+  tables->valenceScore[0] = 0;
   for (int i = 1; i < FORSYTH_VALENCE_SCORE_TABLE_SIZE; i++) {
     // Bonus points for having a low number of tris still to
     // use the vert, so we get rid of lone verts quickly
-    float valenceBoost = powf(i, -FORSYTH_VALENCE_BOOST_POWER);
-    float score = FORSYTH_VALENCE_BOOST_SCALE * valenceBoost;
-    forsythValenceScore[i] = (ForsythScoreType)(FORSYTH_SCORE_SCALING * score);
+    float valenceBoost = powf((float)i, -params->valenceBoostPower);
+    float score = valence * valenceBoost;
+    tables->valenceScore[i] = (ForsythScoreType)(scaling * score);
   }
 }
 
 // Calculate the score for a vertex
-static ForsythScoreType forsythFindVertexScore(int numActiveTris,
+static ForsythScoreType forsythFindVertexScore(const ForsythTables *tables,
+                                               int numActiveTris,
                                                int cachePosition) {
   if (numActiveTris == 0) {
     // No triangles need this vertex!
@@ -140,24 +189,30 @@ static ForsythScoreType forsythFindVertexScore(int numActiveTris,
   if (cachePosition < 0) {
     // Vertex is not in LRU cache - no score
   } else {
-    score = forsythCachePositionScore[cachePosition];
+    score = tables->cachePositionScore[cachePosition];
   }
 
   if (numActiveTris < FORSYTH_VALENCE_SCORE_TABLE_SIZE)
-    score += forsythValenceScore[numActiveTris];
+    score += tables->valenceScore[numActiveTris];
   return score;
 }
 
-// The main reordering function
 ForsythVertexIndexType *
 forsythReorderIndices(ForsythVertexIndexType *outIndices,
                       const ForsythVertexIndexType *indices, int nTriangles,
                       int nVertices) {
-  static int init = 1;
-  if (init) {
-    forsythInit();
-    init = 0;
-  }
+  return forsythReorderIndicesWithParams(outIndices, indices, nTriangles,
+                                         nVertices, NULL);
+}
+
+// The main reordering function
+ForsythVertexIndexType *forsythReorderIndicesWithParams(
+    ForsythVertexIndexType *outIndices, const ForsythVertexIndexType *indices,
+    int nTriangles, int nVertices, const ForsythParams *params) {
+  ForsythParams defaults = forsythDefaultParams();
+  ForsythTables tables;
+  forsythInit(&tables, params != NULL ? params : &defaults);
+  const int cacheSize = tables.cacheSize;
 
   ForsythAdjacencyType *numActiveTris =
       (ForsythAdjacencyType *)malloc(sizeof(ForsythAdjacencyType) * nVertices);
@@ -215,7 +270,8 @@ forsythReorderIndices(ForsythVertexIndexType *outIndices,
 
   // Initialize the score for all vertices
   for (int i = 0; i < nVertices; i++) {
-    lastScore[i] = forsythFindVertexScore(numActiveTris[i], cacheTag[i]);
+    lastScore[i] =
+        forsythFindVertexScore(&tables, numActiveTris[i], cacheTag[i]);
     for (int j = 0; j < numActiveTris[i]; j++)
       triangleScore[triangleIndices[offsets[i] + j]] += lastScore[i];
   }
@@ -237,8 +293,8 @@ forsythReorderIndices(ForsythVertexIndexType *outIndices,
   int outPos = 0;
 
   // Initialize the cache
-  int cache[FORSYTH_VERTEX_CACHE_SIZE + 3];
-  for (int i = 0; i < FORSYTH_VERTEX_CACHE_SIZE + 3; i++)
+  int cache[FORSYTH_MAX_VERTEX_CACHE_SIZE + 3];
+  for (int i = 0; i < cacheSize + 3; i++)
     cache[i] = -1;
 
   int scanPos = 0;
@@ -258,7 +314,7 @@ forsythReorderIndices(ForsythVertexIndexType *outIndices,
       // is in the cache
       int endpos = cacheTag[v];
       if (endpos < 0)
-        endpos = FORSYTH_VERTEX_CACHE_SIZE + i;
+        endpos = cacheSize + i;
       if (endpos > i) {
         // Move all cache entries from the previous position
         // in the cache to the new target position (i) one
@@ -290,18 +346,18 @@ forsythReorderIndices(ForsythVertexIndexType *outIndices,
       numActiveTris[v]--;
     }
     // Update the scores of all triangles in the cache
-    for (int i = 0; i < FORSYTH_VERTEX_CACHE_SIZE + 3; i++) {
+    for (int i = 0; i < cacheSize + 3; i++) {
       int v = cache[i];
       if (v < 0)
         break;
       // This vertex has been pushed outside of the
       // actual cache
-      if (i >= FORSYTH_VERTEX_CACHE_SIZE) {
+      if (i >= cacheSize) {
         cacheTag[v] = -1;
         cache[i] = -1;
       }
       ForsythScoreType newScore =
-          forsythFindVertexScore(numActiveTris[v], cacheTag[v]);
+          forsythFindVertexScore(&tables, numActiveTris[v], cacheTag[v]);
       ForsythScoreType diff = newScore - lastScore[v];
       for (int j = 0; j < numActiveTris[v]; j++)
         triangleScore[triangleIndices[offsets[v] + j]] += diff;
@@ -310,7 +366,7 @@ forsythReorderIndices(ForsythVertexIndexType *outIndices,
     // Find the best triangle referenced by vertices in the cache
     bestTriangle = -1;
     bestScore = -1;
-    for (int i = 0; i < FORSYTH_VERTEX_CACHE_SIZE; i++) {
+    for (int i = 0; i < cacheSize; i++) {
       if (cache[i] < 0)
         break;
       int v = cache[i];
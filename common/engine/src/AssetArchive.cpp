@@ -0,0 +1,299 @@
+#include "AssetArchive.hpp"
+#include "ObjParser.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+static const char kMagic[8] = {'C', 'S', '5', '3', '1', '0', 'A', 'R'};
+
+const char *AssetKindName(AssetKind kind) {
+  switch (kind) {
+  case AssetKind::None:
+    return "none";
+  case AssetKind::Raw:
+    return "raw";
+  case AssetKind::Mesh:
+    return "mesh";
+  case AssetKind::Texture:
+    return "texture";
+  }
+  return "?";
+}
+
+uint64_t ArchivePathHash(const std::string &path) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : path) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::string NormalizeAssetPath(const std::string &path) {
+  std::string slashes = path;
+  for (char &c : slashes) {
+    if (c == '\\') {
+      c = '/';
+    }
+  }
+  std::string normal =
+      std::filesystem::path(slashes).lexically_normal().generic_string();
+  if (normal == ".") {
+    return "";
+  }
+  // "dir/" names the same directory as "dir"
+  if (!normal.empty() && normal.back() == '/') {
+    normal.pop_back();
+  }
+  return normal;
+}
+
+// ============================== Cooked meshes ============================== //
+static size_t Align16(size_t offset) { return (offset + 15) & ~size_t(15); }
+
+bool ReadCookedMesh(const AssetView &view, ObjData &out) {
+  out.Clear();
+  if (view.kind != AssetKind::Mesh || view.size < sizeof(CookedMeshHeader)) {
+    return false;
+  }
+  CookedMeshHeader header;
+  std::memcpy(&header, view.data, sizeof(header));
+  const size_t sizes[5] = {header.positions * sizeof(glm::vec3),
+                           header.texCoords * sizeof(glm::vec2),
+                           header.normals * sizeof(glm::vec3),
+                           header.corners * sizeof(ObjIndex),
+                           header.materialLibraryLength};
+  size_t offsets[5];
+  size_t offset = sizeof(CookedMeshHeader);
+  for (int i = 0; i < 5; i++) {
+    offset = Align16(offset);
+    offsets[i] = offset;
+    offset += sizes[i];
+  }
+  if (offset > view.size || header.corners % 3 != 0) {
+    return false;
+  }
+  out.positions.resize(header.positions);
+  out.texCoords.resize(header.texCoords);
+  out.normals.resize(header.normals);
+  out.corners.resize(header.corners);
+  std::memcpy(out.positions.data(), view.data + offsets[0], sizes[0]);
+  std::memcpy(out.texCoords.data(), view.data + offsets[1], sizes[1]);
+  std::memcpy(out.normals.data(), view.data + offsets[2], sizes[2]);
+  std::memcpy(out.corners.data(), view.data + offsets[3], sizes[3]);
+  out.materialLibrary.assign(
+      reinterpret_cast<const char *>(view.data + offsets[4]), sizes[4]);
+
+  // The same guarantee ParseObj() gives: every index can be used as is
+  for (const ObjIndex &corner : out.corners) {
+    if (corner.position < 0 ||
+        static_cast<uint32_t>(corner.position) >= header.positions ||
+        corner.texCoord < -1 ||
+        (corner.texCoord >= 0 &&
+         static_cast<uint32_t>(corner.texCoord) >= header.texCoords) ||
+        corner.normal < -1 ||
+        (corner.normal >= 0 &&
+         static_cast<uint32_t>(corner.normal) >= header.normals)) {
+      out.Clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+// ================================ Mounting ================================= //
+AssetArchive::AssetArchive() {}
+
+AssetArchive::~AssetArchive() { Unmount(); }
+
+AssetArchive &AssetArchive::Instance() {
+  static AssetArchive archive;
+  return archive;
+}
+
+bool AssetArchive::Mount(const std::string &path,
+                         const std::string &mountPoint) {
+  Unmount();
+  if (!m_file.Open(path, &m_error)) {
+    return false;
+  }
+  // Entries are read one at a time, in no particular order, so read ahead
+  // only where Prefetch() asks for it
+  m_file.AdviseRandom();
+  if (!Validate()) {
+    std::string error = path + ": " + m_error;
+    Unmount();
+    m_error = error;
+    return false;
+  }
+  m_mountPoint = NormalizeAssetPath(mountPoint);
+  m_path = path;
+  m_error.clear();
+  return true;
+}
+
+bool AssetArchive::MountFromEnvironment(const std::string &defaultPath,
+                                        const std::string &mountPoint) {
+  const char *path = std::getenv("ENGINE_ASSETS");
+  if (path != nullptr && path[0] != '\0') {
+    if (std::strcmp(path, "off") == 0) {
+      Unmount();
+      m_error = "ENGINE_ASSETS=off";
+      return false;
+    }
+    return Mount(path, mountPoint);
+  }
+  if (!std::ifstream(defaultPath).good()) {
+    Unmount();
+    m_error = "no archive at " + defaultPath;
+    return false;
+  }
+  return Mount(defaultPath, mountPoint);
+}
+
+void AssetArchive::Unmount() {
+  m_file.Close();
+  m_header = nullptr;
+  m_entries = nullptr;
+  m_names = nullptr;
+  m_mountPoint.clear();
+  m_path.clear();
+}
+
+// Checks everything Find() and the views rely on, once
+bool AssetArchive::Validate() {
+  const uint8_t *data = m_file.GetData();
+  const uint64_t size = m_file.GetSize();
+  if (size < sizeof(ArchiveHeader)) {
+    m_error = "too small for an archive";
+    return false;
+  }
+  const ArchiveHeader *header = reinterpret_cast<const ArchiveHeader *>(data);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+    m_error = "not an asset archive";
+    return false;
+  }
+  if (header->version != kArchiveVersion) {
+    m_error = "archive version " + std::to_string(header->version) +
+              ", expected " + std::to_string(kArchiveVersion) +
+              " (cook it again)";
+    return false;
+  }
+  uint64_t slots = header->slotCount;
+  if (header->fileSize != size || slots == 0 || (slots & (slots - 1)) != 0 ||
+      header->entryCount > slots / 2 ||
+      header->tocOffset % alignof(ArchiveEntry) != 0 ||
+      header->tocOffset > size ||
+      slots > (size - header->tocOffset) / sizeof(ArchiveEntry) ||
+      header->namesOffset > size ||
+      header->namesSize > size - header->namesOffset) {
+    m_error = "truncated or damaged table of contents";
+    return false;
+  }
+  const ArchiveEntry *entries =
+      reinterpret_cast<const ArchiveEntry *>(data + header->tocOffset);
+  const char *names =
+      reinterpret_cast<const char *>(data + header->namesOffset);
+  uint32_t used = 0;
+  for (uint64_t i = 0; i < slots; i++) {
+    const ArchiveEntry &entry = entries[i];
+    if (entry.kind == AssetKind::None) {
+      continue;
+    }
+    used++;
+    bool ok = entry.kind <= AssetKind::Texture &&
+              entry.offset % kArchiveAlignment == 0 &&
+              entry.offset <= header->tocOffset &&
+              entry.size <= header->tocOffset - entry.offset &&
+              entry.nameOffset <= header->namesSize &&
+              entry.nameLength <= header->namesSize - entry.nameOffset &&
+              entry.hash ==
+                  ArchivePathHash(std::string(names + entry.nameOffset,
+                                              entry.nameLength));
+    if (ok && entry.kind == AssetKind::Texture) {
+      ok = entry.size == uint64_t(entry.width) * entry.height * 3;
+    }
+    if (!ok) {
+      m_error = "damaged entry " + std::to_string(i);
+      return false;
+    }
+  }
+  if (used != header->entryCount) {
+    m_error = "the table of contents does not match its entry count";
+    return false;
+  }
+  m_header = header;
+  m_entries = entries;
+  m_names = names;
+  return true;
+}
+
+// ================================ Lookups ================================== //
+AssetView AssetArchive::MakeView(const ArchiveEntry &entry) const {
+  AssetView view;
+  view.data = m_file.GetData() + entry.offset;
+  view.size = static_cast<size_t>(entry.size);
+  view.kind = entry.kind;
+  view.width = entry.width;
+  view.height = entry.height;
+  return view;
+}
+
+AssetView AssetArchive::FindKey(const std::string &key) const {
+  if (m_header == nullptr) {
+    return AssetView();
+  }
+  uint64_t hash = ArchivePathHash(key);
+  uint32_t mask = m_header->slotCount - 1;
+  for (uint32_t probe = 0; probe <= mask; probe++) {
+    const ArchiveEntry &entry = m_entries[(hash + probe) & mask];
+    if (entry.kind == AssetKind::None) {
+      break;
+    }
+    if (entry.hash == hash && entry.nameLength == key.size() &&
+        std::memcmp(m_names + entry.nameOffset, key.data(), key.size()) ==
+            0) {
+      return MakeView(entry);
+    }
+  }
+  return AssetView();
+}
+
+AssetView AssetArchive::Find(const std::string &path) const {
+  if (m_header == nullptr || path.empty() || path[0] == '/') {
+    return AssetView();
+  }
+  std::string key = NormalizeAssetPath(
+      m_mountPoint.empty() ? path : m_mountPoint + "/" + path);
+  // Outside of the cooked directory
+  if (key.compare(0, 3, "../") == 0) {
+    return AssetView();
+  }
+  return FindKey(key);
+}
+
+void AssetArchive::Prefetch(const AssetView &view) const {
+  m_file.Prefetch(view.data, view.size);
+}
+
+uint32_t AssetArchive::GetEntryCount() const {
+  return m_header != nullptr ? m_header->entryCount : 0;
+}
+
+uint32_t AssetArchive::GetSlotCount() const {
+  return m_header != nullptr ? m_header->slotCount : 0;
+}
+
+bool AssetArchive::GetEntry(uint32_t slot, std::string &key,
+                            AssetView &view) const {
+  if (m_header == nullptr || slot >= m_header->slotCount ||
+      m_entries[slot].kind == AssetKind::None) {
+    return false;
+  }
+  const ArchiveEntry &entry = m_entries[slot];
+  key.assign(m_names + entry.nameOffset, entry.nameLength);
+  view = MakeView(entry);
+  return true;
+}
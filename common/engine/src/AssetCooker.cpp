@@ -0,0 +1,325 @@
+#include "AssetCooker.hpp"
+#include "ObjParser.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+static const char kMagic[8] = {'C', 'S', '5', '3', '1', '0', 'A', 'R'};
+
+// ================================== PPM ==================================== //
+// Skips whitespace and '#' comments (which run to the end of the line)
+static const char *SkipSpace(const char *p, const char *end) {
+  while (p < end) {
+    if (*p == '#') {
+      while (p < end && *p != '\n') {
+        p++;
+      }
+    } else if (std::isspace(static_cast<unsigned char>(*p))) {
+      p++;
+    } else {
+      break;
+    }
+  }
+  return p;
+}
+
+static bool ReadNumber(const char *&p, const char *end, uint32_t &value) {
+  p = SkipSpace(p, end);
+  if (p >= end || *p < '0' || *p > '9') {
+    return false;
+  }
+  uint64_t number = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    number = number * 10 + static_cast<uint64_t>(*p - '0');
+    if (number > 0xFFFFFFFFull) {
+      return false;
+    }
+    p++;
+  }
+  value = static_cast<uint32_t>(number);
+  return true;
+}
+
+bool ParsePpm(const char *text, size_t length, bool flip, uint32_t &width,
+              uint32_t &height, std::vector<uint8_t> &pixels,
+              std::string *error) {
+  const char *p = text;
+  const char *end = text + length;
+  pixels.clear();
+  width = height = 0;
+  if (length < 2 || p[0] != 'P' || p[1] != '3') {
+    if (error != nullptr) {
+      *error = "not a plain (P3) PPM";
+    }
+    return false;
+  }
+  p += 2;
+  uint32_t maxValue = 0;
+  if (!ReadNumber(p, end, width) || !ReadNumber(p, end, height) ||
+      !ReadNumber(p, end, maxValue) || width == 0 || height == 0 ||
+      uint64_t(width) * height > (1ull << 28)) {
+    if (error != nullptr) {
+      *error = "bad PPM header";
+    }
+    return false;
+  }
+  size_t count = size_t(width) * height * 3;
+  pixels.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    uint32_t value = 0;
+    if (!ReadNumber(p, end, value)) {
+      if (error != nullptr) {
+        *error = "PPM ends after " + std::to_string(i) + " of " +
+                 std::to_string(count) + " values";
+      }
+      pixels.clear();
+      return false;
+    }
+    // Image::LoadPPM() ignores the maximum as well
+    pixels[i] = static_cast<uint8_t>(value);
+  }
+  if (flip) {
+    // The last pixel first, each pixel still RGB
+    size_t pixelCount = count / 3;
+    for (size_t i = 0; i < pixelCount / 2; i++) {
+      std::swap_ranges(&pixels[i * 3], &pixels[i * 3] + 3,
+                       &pixels[(pixelCount - 1 - i) * 3]);
+    }
+  }
+  return true;
+}
+
+// ================================= Meshes ================================== //
+static size_t Align16(size_t offset) { return (offset + 15) & ~size_t(15); }
+
+void CookMesh(const ObjData &data, std::vector<uint8_t> &out) {
+  CookedMeshHeader header = {};
+  header.positions = static_cast<uint32_t>(data.positions.size());
+  header.texCoords = static_cast<uint32_t>(data.texCoords.size());
+  header.normals = static_cast<uint32_t>(data.normals.size());
+  header.corners = static_cast<uint32_t>(data.corners.size());
+  header.materialLibraryLength =
+      static_cast<uint32_t>(data.materialLibrary.size());
+  const void *arrays[5] = {data.positions.data(), data.texCoords.data(),
+                           data.normals.data(), data.corners.data(),
+                           data.materialLibrary.data()};
+  const size_t sizes[5] = {data.positions.size() * sizeof(glm::vec3),
+                           data.texCoords.size() * sizeof(glm::vec2),
+                           data.normals.size() * sizeof(glm::vec3),
+                           data.corners.size() * sizeof(ObjIndex),
+                           data.materialLibrary.size()};
+  out.assign(sizeof(header), 0);
+  std::memcpy(out.data(), &header, sizeof(header));
+  for (int i = 0; i < 5; i++) {
+    size_t offset = Align16(out.size());
+    out.resize(offset + sizes[i], 0);
+    if (sizes[i] > 0) {
+      std::memcpy(out.data() + offset, arrays[i], sizes[i]);
+    }
+  }
+}
+
+// ================================ Writing ================================== //
+AssetArchiveWriter::~AssetArchiveWriter() {
+  if (m_file.is_open()) {
+    m_file.close();
+    std::remove(m_path.c_str());
+  }
+}
+
+bool AssetArchiveWriter::Open(const std::string &path, std::string *error) {
+  m_entries.clear();
+  m_path = path;
+  m_file.open(path, std::ios::binary | std::ios::trunc);
+  if (!m_file) {
+    if (error != nullptr) {
+      *error = "could not create " + path;
+    }
+    return false;
+  }
+  // The header is written last, when everything in it is known
+  ArchiveHeader header = {};
+  m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  m_offset = sizeof(header);
+  return static_cast<bool>(m_file);
+}
+
+bool AssetArchiveWriter::Pad(size_t alignment) {
+  static const char zeros[kArchiveAlignment] = {};
+  size_t padding = (alignment - m_offset % alignment) % alignment;
+  m_file.write(zeros, padding);
+  m_offset += padding;
+  return static_cast<bool>(m_file);
+}
+
+bool AssetArchiveWriter::Add(const std::string &key, AssetKind kind,
+                             const uint8_t *data, size_t size, uint32_t width,
+                             uint32_t height) {
+  if (!m_file.is_open() || kind == AssetKind::None) {
+    return false;
+  }
+  std::string normal = NormalizeAssetPath(key);
+  for (const Pending &pending : m_entries) {
+    if (pending.key == normal) {
+      return false;
+    }
+  }
+  if (!Pad(kArchiveAlignment)) {
+    return false;
+  }
+  Pending pending;
+  pending.key = normal;
+  pending.entry = ArchiveEntry();
+  pending.entry.hash = ArchivePathHash(normal);
+  pending.entry.offset = m_offset;
+  pending.entry.size = size;
+  pending.entry.kind = kind;
+  pending.entry.width = width;
+  pending.entry.height = height;
+  m_file.write(reinterpret_cast<const char *>(data), size);
+  m_offset += size;
+  m_entries.push_back(pending);
+  return static_cast<bool>(m_file);
+}
+
+size_t AssetArchiveWriter::Finish(std::string *error) {
+  if (!m_file.is_open()) {
+    return 0;
+  }
+  // At most half full, so probe sequences stay short
+  uint32_t slots = 16;
+  while (slots < m_entries.size() * 2) {
+    slots *= 2;
+  }
+  std::vector<ArchiveEntry> table(slots, ArchiveEntry());
+  std::string names;
+  for (Pending &pending : m_entries) {
+    pending.entry.nameOffset = static_cast<uint32_t>(names.size());
+    pending.entry.nameLength = static_cast<uint32_t>(pending.key.size());
+    names += pending.key;
+    uint32_t slot = static_cast<uint32_t>(pending.entry.hash) & (slots - 1);
+    while (table[slot].kind != AssetKind::None) {
+      slot = (slot + 1) & (slots - 1);
+    }
+    table[slot] = pending.entry;
+  }
+
+  ArchiveHeader header = {};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kArchiveVersion;
+  header.entryCount = static_cast<uint32_t>(m_entries.size());
+  header.slotCount = slots;
+  Pad(kArchiveAlignment);
+  header.tocOffset = m_offset;
+  m_file.write(reinterpret_cast<const char *>(table.data()),
+               table.size() * sizeof(ArchiveEntry));
+  m_offset += table.size() * sizeof(ArchiveEntry);
+  header.namesOffset = m_offset;
+  header.namesSize = names.size();
+  m_file.write(names.data(), names.size());
+  m_offset += names.size();
+  header.fileSize = m_offset;
+  m_file.seekp(0);
+  m_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  m_file.close();
+  if (m_file.fail()) {
+    if (error != nullptr) {
+      *error = "could not write " + m_path;
+    }
+    std::remove(m_path.c_str());
+    return 0;
+  }
+  return static_cast<size_t>(header.fileSize);
+}
+
+// ================================ Cooking ================================== //
+static std::string Extension(const std::filesystem::path &path) {
+  std::string extension = path.extension().string();
+  for (char &c : extension) {
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+  return extension;
+}
+
+bool CookAssets(const std::string &root,
+                const std::vector<std::string> &directories,
+                const std::string &output, CookStats &stats,
+                std::ostream *log, std::string *error) {
+  namespace fs = std::filesystem;
+  stats = CookStats();
+  // Sorted, so the same files always give the same archive
+  std::vector<fs::path> files;
+  for (const std::string &directory : directories) {
+    std::error_code code;
+    fs::recursive_directory_iterator it(fs::path(root) / directory, code), end;
+    if (code) {
+      if (log != nullptr) {
+        *log << "skipping " << directory << ": " << code.message() << "\n";
+      }
+      continue;
+    }
+    for (; it != end; it.increment(code)) {
+      if (code) {
+        break;
+      }
+      if (it->is_regular_file()) {
+        files.push_back(it->path());
+      }
+    }
+  }
+  std::sort(files.begin(), files.end());
+
+  AssetArchiveWriter writer;
+  if (!writer.Open(output, error)) {
+    return false;
+  }
+  std::string text, problem;
+  std::vector<uint8_t> payload;
+  ObjData mesh;
+  for (const fs::path &file : files) {
+    std::string extension = Extension(file);
+    std::string key = fs::relative(file, root).generic_string();
+    if ((extension != ".obj" && extension != ".mtl" && extension != ".ppm") ||
+        !ReadFileToString(file.string(), text)) {
+      stats.skipped++;
+      continue;
+    }
+    bool added = false;
+    problem.clear();
+    if (extension == ".obj") {
+      if (ParseObj(text.data(), text.size(), mesh, &problem)) {
+        CookMesh(mesh, payload);
+        added = writer.Add(key, AssetKind::Mesh, payload.data(),
+                           payload.size());
+        stats.meshes += added ? 1 : 0;
+      }
+    } else if (extension == ".ppm") {
+      uint32_t width = 0, height = 0;
+      if (ParsePpm(text.data(), text.size(), true, width, height, payload,
+                   &problem)) {
+        added = writer.Add(key, AssetKind::Texture, payload.data(),
+                           payload.size(), width, height);
+        stats.textures += added ? 1 : 0;
+      }
+    } else {
+      added = writer.Add(key, AssetKind::Raw,
+                         reinterpret_cast<const uint8_t *>(text.data()),
+                         text.size());
+      stats.raw += added ? 1 : 0;
+    }
+    if (!added) {
+      stats.skipped++;
+      if (log != nullptr) {
+        *log << "skipping " << key << ": "
+             << (problem.empty() ? "could not add it" : problem) << "\n";
+      }
+      continue;
+    }
+    stats.inputBytes += text.size();
+  }
+  stats.outputBytes = writer.Finish(error);
+  return stats.outputBytes > 0;
+}
@@ -0,0 +1,562 @@
+#include "AsyncFileIO.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+const char *AsyncIoBackendName(AsyncIoBackend backend) {
+  switch (backend) {
+  case AsyncIoBackend::IoUring:
+    return "io_uring";
+  case AsyncIoBackend::Threads:
+    return "threads";
+  }
+  return "?";
+}
+
+struct AsyncFileReader::File {
+  FileReadResult result;
+  FileReadCallback done;
+  int fd{-1};
+  uint64_t start{0}; // Where the range starts in the file
+  bool whole{true};  // Else 'size' bytes from 'start' on
+  uint64_t size{0};
+  uint64_t issued{0};   // Bytes handed to reads (in order)
+  uint64_t received{0}; // Bytes that arrived
+  uint32_t inFlight{0};
+  uint64_t reads{0};
+  uint64_t submits{0};
+};
+
+#ifdef __linux__
+// ================================= Ring ==================================== //
+// The ring and the staging buffers. Only the ring thread touches it after
+// Setup().
+struct AsyncFileReader::Ring {
+  int fd{-1};
+  void *sqMap{nullptr};
+  size_t sqMapSize{0};
+  void *cqMap{nullptr}; // Same as sqMap with IORING_FEAT_SINGLE_MMAP
+  size_t cqMapSize{0};
+  io_uring_sqe *sqes{nullptr};
+  size_t sqesSize{0};
+  unsigned *sqHead{nullptr};
+  unsigned *sqTail{nullptr};
+  unsigned sqMask{0};
+  unsigned *sqArray{nullptr};
+  unsigned *cqHead{nullptr};
+  unsigned *cqTail{nullptr};
+  unsigned cqMask{0};
+  io_uring_cqe *cqes{nullptr};
+
+  // One read per slot; a slot's staging buffer is registered as buffer
+  // 'slot'
+  struct Slot {
+    File *file{nullptr};
+    uint64_t offset{0};
+    uint32_t length{0};
+  };
+  std::vector<Slot> slots;
+  std::vector<unsigned> freeSlots;
+  bool fixed{false};
+  size_t chunkBytes{0};
+  uint8_t *staging{nullptr};
+
+  ~Ring() {
+    if (fd >= 0) {
+      close(fd); // Also unregisters the buffers
+    }
+    if (sqes != nullptr) {
+      munmap(sqes, sqesSize);
+    }
+    if (cqMap != nullptr && cqMap != sqMap) {
+      munmap(cqMap, cqMapSize);
+    }
+    if (sqMap != nullptr) {
+      munmap(sqMap, sqMapSize);
+    }
+    std::free(staging);
+  }
+
+  bool Setup(unsigned depth, size_t chunk, std::string &error) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd = static_cast<int>(syscall(__NR_io_uring_setup, depth, &params));
+    if (fd < 0) {
+      error = std::string("io_uring_setup: ") + std::strerror(errno);
+      return false;
+    }
+    sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+      sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+    }
+    sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqMap == MAP_FAILED) {
+      sqMap = nullptr;
+      error = "could not map the submission queue";
+      return false;
+    }
+    cqMap = sqMap;
+    if (!single) {
+      cqMap = mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (cqMap == MAP_FAILED) {
+        cqMap = nullptr;
+        error = "could not map the completion queue";
+        return false;
+      }
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqeMap == MAP_FAILED) {
+      error = "could not map the submission entries";
+      return false;
+    }
+    sqes = static_cast<io_uring_sqe *>(sqeMap);
+    uint8_t *sq = static_cast<uint8_t *>(sqMap);
+    uint8_t *cq = static_cast<uint8_t *>(cqMap);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    // Never more reads than the completion queue can hold
+    unsigned count = std::min(params.sq_entries, params.cq_entries);
+    slots.assign(count, Slot());
+    for (unsigned i = count; i > 0; i--) {
+      freeSlots.push_back(i - 1);
+    }
+    chunkBytes = chunk;
+    // Page aligned, registered once. Without them (RLIMIT_MEMLOCK) the
+    // reads go straight into the files.
+    staging = static_cast<uint8_t *>(std::aligned_alloc(4096, count * chunk));
+    if (staging != nullptr) {
+      std::vector<iovec> buffers(count);
+      for (unsigned i = 0; i < count; i++) {
+        buffers[i].iov_base = staging + i * chunk;
+        buffers[i].iov_len = chunk;
+      }
+      fixed = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS,
+                      buffers.data(), count) == 0;
+    }
+    if (!fixed) {
+      std::free(staging);
+      staging = nullptr;
+    }
+    return true;
+  }
+
+  // Queues one read; the caller checked that a slot is free
+  void Push(File &file, uint64_t offset, uint32_t length) {
+    unsigned slot = freeSlots.back();
+    freeSlots.pop_back();
+    slots[slot] = {&file, offset, length};
+    unsigned tail = *sqTail;
+    unsigned index = tail & sqMask;
+    io_uring_sqe &sqe = sqes[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.fd = file.fd;
+    sqe.off = file.start + offset;
+    sqe.len = length;
+    sqe.user_data = slot;
+    if (fixed) {
+      sqe.opcode = IORING_OP_READ_FIXED;
+      sqe.addr = reinterpret_cast<uint64_t>(staging + slot * chunkBytes);
+      sqe.buf_index = static_cast<uint16_t>(slot);
+    } else {
+      sqe.opcode = IORING_OP_READ;
+      sqe.addr = reinterpret_cast<uint64_t>(&file.result.data[offset]);
+    }
+    sqArray[index] = index;
+    // The kernel may read the entry as soon as it sees the new tail
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    file.inFlight++;
+    file.reads++;
+  }
+
+  // Submits what was pushed and, if 'wait', blocks for one completion
+  int Enter(unsigned submit, bool wait) {
+    for (;;) {
+      long result =
+          syscall(__NR_io_uring_enter, fd, submit, wait ? 1u : 0u,
+                  wait ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+      if (result >= 0) {
+        return static_cast<int>(result);
+      }
+      if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        return -errno;
+      }
+    }
+  }
+};
+#else
+struct AsyncFileReader::Ring {};
+#endif
+
+// =============================== Reader ==================================== //
+AsyncFileReader::AsyncFileReader(const AsyncIoOptions &options)
+    : m_options(options) {
+  m_options.queueDepth = std::max(1u, m_options.queueDepth);
+  m_options.chunkBytes =
+      std::max<size_t>(4096, (m_options.chunkBytes + 4095) & ~size_t(4095));
+  const char *forced = std::getenv("ENGINE_ASYNC_IO");
+  if (forced != nullptr && std::strcmp(forced, "threads") == 0) {
+    m_options.backend = AsyncIoBackend::Threads;
+  }
+#ifdef __linux__
+  if (m_options.backend == AsyncIoBackend::IoUring) {
+    std::unique_ptr<Ring> ring(new Ring());
+    std::string error;
+    if (ring->Setup(m_options.queueDepth, m_options.chunkBytes, error)) {
+      m_ring = std::move(ring);
+      m_backend = AsyncIoBackend::IoUring;
+      m_ringThread = std::thread(&AsyncFileReader::RingMain, this);
+    } else if (forced == nullptr) {
+      std::cerr << "AsyncFileReader: " << error << ", using threads\n";
+    }
+  }
+#endif
+  unsigned workers = m_options.workers;
+  if (workers == 0) {
+    // A few: the Threads backend also reads on them
+    workers = std::min(8u, std::max(2u, GetWorkerCount()));
+  }
+  for (unsigned i = 0; i < workers; i++) {
+    m_workers.emplace_back(&AsyncFileReader::WorkerMain, this);
+  }
+}
+
+AsyncFileReader::~AsyncFileReader() {
+  Wait();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  if (m_ringThread.joinable()) {
+    m_ringThread.join();
+  }
+  for (std::thread &worker : m_workers) {
+    worker.join();
+  }
+}
+
+AsyncFileReader &AsyncFileReader::Instance() {
+  static AsyncFileReader reader;
+  return reader;
+}
+
+void AsyncFileReader::Read(const std::string &path, FileReadCallback done) {
+  std::unique_ptr<File> file(new File());
+  file->result.path = path;
+  file->done = std::move(done);
+  Queue(std::move(file));
+}
+
+void AsyncFileReader::ReadRange(const std::string &path, uint64_t offset,
+                                uint64_t length, FileReadCallback done) {
+  std::unique_ptr<File> file(new File());
+  file->result.path = path;
+  file->done = std::move(done);
+  file->start = offset;
+  file->size = length;
+  file->whole = false;
+  Queue(std::move(file));
+}
+
+void AsyncFileReader::Queue(std::unique_ptr<File> file) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_outstanding++;
+  }
+  if (m_backend == AsyncIoBackend::IoUring) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_requests.push_back(std::move(file));
+    }
+    m_wake.notify_all();
+    return;
+  }
+  File *raw = file.release();
+  Post([this, raw]() {
+    std::unique_ptr<File> owned(raw);
+    ReadBlocking(*owned);
+    Complete(std::move(owned));
+  });
+}
+
+void AsyncFileReader::Wait() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_finished.wait(lock, [this]() { return m_outstanding == 0; });
+}
+
+AsyncIoStats AsyncFileReader::GetStats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
+
+void AsyncFileReader::Post(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_tasks.push_back(std::move(task));
+  }
+  m_wake.notify_all();
+}
+
+void AsyncFileReader::WorkerMain() {
+  for (;;) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+      if (m_tasks.empty()) {
+        return; // Stopped
+      }
+      task = std::move(m_tasks.front());
+      m_tasks.pop_front();
+    }
+    task();
+  }
+}
+
+void AsyncFileReader::ReadBlocking(File &file) {
+  std::ifstream stream(file.result.path, std::ios::binary | std::ios::ate);
+  if (!stream) {
+    file.result.error = "could not open " + file.result.path;
+    return;
+  }
+  uint64_t fileSize = static_cast<uint64_t>(stream.tellg());
+  if (file.whole) {
+    file.size = fileSize;
+  } else if (file.start > fileSize || file.size > fileSize - file.start) {
+    file.result.error = file.result.path + " ends before the range read";
+    return;
+  }
+  stream.seekg(static_cast<std::streamoff>(file.start));
+  file.result.data.resize(file.size);
+  // Large reads, so several files are read at the disk's pace in parallel
+  while (file.received < file.size) {
+    size_t length = static_cast<size_t>(std::min<uint64_t>(
+        m_options.chunkBytes, file.size - file.received));
+    stream.read(&file.result.data[file.received], length);
+    file.reads++;
+    file.submits++;
+    if (static_cast<size_t>(stream.gcount()) != length) {
+      file.result.error = "could not read " + file.result.path;
+      return;
+    }
+    file.received += length;
+  }
+}
+
+void AsyncFileReader::Complete(std::unique_ptr<File> file) {
+#ifdef __linux__
+  if (file->fd >= 0) {
+    close(file->fd);
+    file->fd = -1;
+  }
+#endif
+  file->result.ok = file->result.error.empty();
+  if (!file->result.ok) {
+    file->result.data.clear();
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.files++;
+    m_stats.failed += file->result.ok ? 0 : 1;
+    m_stats.bytes += file->result.ok ? file->size : 0;
+    m_stats.reads += file->reads;
+    m_stats.submits += file->submits;
+  }
+  if (file->done) {
+    file->done(file->result);
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_outstanding--;
+  }
+  m_finished.notify_all();
+}
+
+// The ring thread: opens the files and keeps the queue full
+void AsyncFileReader::RingMain() {
+#ifdef __linux__
+  Ring &ring = *m_ring;
+  std::deque<std::unique_ptr<File>> active; // Opened, in request order
+  // Remainders of short reads, served before new chunks
+  struct Retry {
+    File *file;
+    uint64_t offset;
+    uint32_t length;
+  };
+  std::deque<Retry> retries;
+  uint32_t inFlight = 0;
+
+  // Runs the callback of a finished file on a worker
+  auto finish = [this](std::unique_ptr<File> file) {
+    File *raw = file.release();
+    Post([this, raw]() { Complete(std::unique_ptr<File>(raw)); });
+  };
+
+  for (;;) {
+    std::deque<std::unique_ptr<File>> incoming;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (inFlight == 0 && active.empty()) {
+        m_wake.wait(lock, [this]() { return m_stop || !m_requests.empty(); });
+        if (m_requests.empty()) {
+          return; // Stopped
+        }
+      }
+      incoming.swap(m_requests);
+    }
+    for (std::unique_ptr<File> &file : incoming) {
+      file->fd = open(file->result.path.c_str(), O_RDONLY | O_CLOEXEC);
+      struct stat info;
+      if (file->fd < 0 || fstat(file->fd, &info) != 0) {
+        file->result.error = "could not open " + file->result.path;
+        finish(std::move(file));
+        continue;
+      }
+      uint64_t fileSize = static_cast<uint64_t>(info.st_size);
+      if (file->whole) {
+        file->size = fileSize;
+      } else if (file->start > fileSize ||
+                 file->size > fileSize - file->start) {
+        file->result.error = file->result.path + " ends before the range read";
+        finish(std::move(file));
+        continue;
+      }
+      file->result.data.resize(file->size);
+      if (file->size == 0) {
+        finish(std::move(file));
+        continue;
+      }
+      if (file->whole) {
+        // Sequential, so the kernel reads ahead within each file
+        posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+      }
+      active.push_back(std::move(file));
+    }
+
+    // Fill the queue: retries first, then the next chunks in file order
+    unsigned pushed = 0;
+    while (!ring.freeSlots.empty() && !retries.empty()) {
+      Retry retry = retries.front();
+      retries.pop_front();
+      ring.Push(*retry.file, retry.offset, retry.length);
+      pushed++;
+    }
+    for (std::unique_ptr<File> &file : active) {
+      while (!ring.freeSlots.empty() && file->result.error.empty() &&
+             file->issued < file->size) {
+        uint32_t length = static_cast<uint32_t>(
+            std::min<uint64_t>(ring.chunkBytes, file->size - file->issued));
+        ring.Push(*file, file->issued, length);
+        file->issued += length;
+        pushed++;
+      }
+    }
+    inFlight += pushed;
+    if (inFlight == 0) {
+      continue;
+    }
+
+    int entered = ring.Enter(pushed, true);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stats.submits++;
+      m_stats.maxInFlight = std::max(m_stats.maxInFlight, inFlight);
+    }
+    if (entered < 0) {
+      // Only a bug gets here (bad arguments); the reads never started
+      std::cerr << "AsyncFileReader: io_uring_enter: "
+                << std::strerror(-entered) << "\n";
+      for (std::unique_ptr<File> &file : active) {
+        file->result.error = "io_uring_enter failed";
+        file->inFlight = 0;
+      }
+      retries.clear();
+      ring.freeSlots.clear();
+      for (unsigned i = static_cast<unsigned>(ring.slots.size()); i > 0;
+           i--) {
+        ring.freeSlots.push_back(i - 1);
+      }
+      inFlight = 0;
+    }
+
+    // Reap everything that is there
+    unsigned head = *ring.cqHead;
+    unsigned tail = __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+      const io_uring_cqe &cqe = ring.cqes[head & ring.cqMask];
+      unsigned slot = static_cast<unsigned>(cqe.user_data);
+      Ring::Slot read = ring.slots[slot];
+      File &file = *read.file;
+      ring.freeSlots.push_back(slot);
+      inFlight--;
+      file.inFlight--;
+      if (cqe.res == -EAGAIN || cqe.res == -EINTR) {
+        retries.push_back({&file, read.offset, read.length});
+      } else if (cqe.res < 0) {
+        file.result.error = file.result.path + ": " + std::strerror(-cqe.res);
+      } else if (cqe.res == 0) {
+        file.result.error = file.result.path + " got shorter while reading";
+      } else {
+        uint32_t got = static_cast<uint32_t>(cqe.res);
+        if (ring.fixed) {
+          std::memcpy(&file.result.data[read.offset],
+                      ring.staging + slot * ring.chunkBytes, got);
+        }
+        file.received += got;
+        if (got < read.length) {
+          retries.push_back({&file, read.offset + got, read.length - got});
+        }
+      }
+    }
+    __atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+
+    // Hand over the files that are done (or failed, once nothing of them
+    // is in flight any more)
+    for (auto it = active.begin(); it != active.end();) {
+      File &file = **it;
+      bool failed = !file.result.error.empty();
+      if (file.inFlight == 0 && (failed || file.received == file.size)) {
+        if (failed) {
+          retries.erase(std::remove_if(retries.begin(), retries.end(),
+                                       [&file](const Retry &retry) {
+                                         return retry.file == &file;
+                                       }),
+                        retries.end());
+        }
+        finish(std::move(*it));
+        it = active.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+#endif
+}
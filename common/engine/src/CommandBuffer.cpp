@@ -0,0 +1,178 @@
+#include "CommandBuffer.hpp"
+#include "FrameStats.hpp"
+#include "GLState.hpp"
+#include "ResourceTracker.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+const size_t CommandBuffer::kUniformAlignment;
+const unsigned CommandBuffer::kTextureUnits;
+
+// ============================== Recording ================================== //
+void CommandBuffer::SetUniformBlock(unsigned binding, const void *data,
+                                    size_t bytes) {
+  size_t offset = m_uniforms.size();
+  size_t padded = (bytes + kUniformAlignment - 1) / kUniformAlignment *
+                  kUniformAlignment;
+  m_uniforms.resize(offset + padded);
+  std::memcpy(m_uniforms.data() + offset, data, bytes);
+  Push(CommandType::UniformBlock, static_cast<uint8_t>(binding),
+       static_cast<uint32_t>(offset), static_cast<uint32_t>(bytes));
+}
+
+void RecordCommands(
+    WorkerPool &workers, size_t count, size_t grain,
+    std::vector<CommandBuffer> &buffers,
+    const std::function<void(size_t, size_t, CommandBuffer &)> &record) {
+  grain = std::max<size_t>(grain, 1);
+  buffers.resize((count + grain - 1) / grain);
+  workers.Run(count, grain, [&](size_t begin, size_t end) {
+    CommandBuffer &out = buffers[begin / grain];
+    out.Clear();
+    record(begin, end, out);
+  });
+}
+
+// ============================== Replay ===================================== //
+CommandReplayer::~CommandReplayer() { Release(); }
+
+bool CommandReplayer::Create() {
+  Release();
+  glGenBuffers(1, &m_uniformBuffer);
+  ResourceTracker::Instance().TrackGpu(GpuResourceKind::Buffer,
+                                       m_uniformBuffer, 0, GL_UNIFORM_BUFFER,
+                                       "CommandReplayer:uniforms");
+  return m_uniformBuffer != 0;
+}
+
+void CommandReplayer::Release() {
+  if (!IsCreated()) {
+    return;
+  }
+  ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Buffer,
+                                         m_uniformBuffer);
+  glDeleteBuffers(1, &m_uniformBuffer);
+  m_uniformBuffer = 0;
+  m_uniformCapacity = 0;
+}
+
+void CommandReplayer::Replay(const CommandBuffer *buffers, size_t count) {
+  m_stats = ReplayStats();
+  if (!IsCreated()) {
+    return;
+  }
+
+  // Every arena goes into one buffer. Arenas are multiples of the
+  // alignment, so packing them back to back keeps every block aligned.
+  m_bases.resize(count);
+  size_t total = 0;
+  for (size_t i = 0; i < count; i++) {
+    m_bases[i] = total;
+    total += buffers[i].GetUniformData().size();
+  }
+  GLState &state = GLState::Instance();
+  state.BindBuffer(GL_UNIFORM_BUFFER, m_uniformBuffer);
+  if (total > 0) {
+    if (total > m_uniformCapacity) {
+      m_uniformCapacity = std::max(total, 2 * m_uniformCapacity);
+      ResourceTracker::Instance().TrackGpu(
+          GpuResourceKind::Buffer, m_uniformBuffer, m_uniformCapacity,
+          GL_UNIFORM_BUFFER, "CommandReplayer:uniforms");
+    }
+    // Orphan last frame's storage so the upload never waits for the GPU
+    glBufferData(GL_UNIFORM_BUFFER, m_uniformCapacity, nullptr,
+                 GL_STREAM_DRAW);
+    for (size_t i = 0; i < count; i++) {
+      const std::vector<uint8_t> &data = buffers[i].GetUniformData();
+      if (!data.empty()) {
+        glBufferSubData(GL_UNIFORM_BUFFER, m_bases[i], data.size(),
+                        data.data());
+      }
+    }
+  }
+  m_stats.uniformBytes = total;
+
+  // What this replay bound, to skip binding it again without a call into
+  // GLState. Nothing is known at the start, so the first bind of each
+  // kind is left to GLState's own filter.
+  const GLuint kUnknown = ~0u;
+  GLuint program = kUnknown;
+  GLuint vertexArray = kUnknown;
+  GLuint textures[CommandBuffer::kTextureUnits];
+  std::fill(textures, textures + CommandBuffer::kTextureUnits, kUnknown);
+  size_t triangles = 0;
+  for (size_t i = 0; i < count; i++) {
+    const std::vector<Command> &commands = buffers[i].GetCommands();
+    m_stats.commands += commands.size();
+    // Buffers are recorded independently, so this does not carry over
+    GLsizei instances = 1;
+    for (const Command &command : commands) {
+      switch (command.type) {
+      case CommandType::BindProgram:
+        if (command.a == program) {
+          m_stats.skippedBinds++;
+          break;
+        }
+        program = command.a;
+        state.UseProgram(program);
+        break;
+      case CommandType::BindVertexArray:
+        if (command.a == vertexArray) {
+          m_stats.skippedBinds++;
+          break;
+        }
+        vertexArray = command.a;
+        state.BindVertexArray(vertexArray);
+        break;
+      case CommandType::BindTexture:
+        if (textures[command.slot] == command.a) {
+          m_stats.skippedBinds++;
+          break;
+        }
+        textures[command.slot] = command.a;
+        state.BindTexture(command.slot, GL_TEXTURE_2D, command.a);
+        break;
+      case CommandType::UniformBlock:
+        state.BindBufferRange(GL_UNIFORM_BUFFER, command.slot, m_uniformBuffer,
+                              m_bases[i] + command.a, command.b);
+        break;
+      case CommandType::DrawIndexed: {
+        const void *offset =
+            reinterpret_cast<const void *>(static_cast<uintptr_t>(command.c));
+        if (instances == 1) {
+          glDrawElements(command.a, static_cast<GLsizei>(command.b),
+                         GL_UNSIGNED_INT, offset);
+        } else {
+          glDrawElementsInstanced(command.a, static_cast<GLsizei>(command.b),
+                                  GL_UNSIGNED_INT, offset, instances);
+        }
+        m_stats.draws++;
+        triangles += command.a == GL_TRIANGLES
+                         ? command.b / 3 * static_cast<size_t>(instances)
+                         : 0;
+        break;
+      }
+      case CommandType::DrawArrays:
+        if (instances == 1) {
+          glDrawArrays(command.a, static_cast<GLint>(command.b),
+                       static_cast<GLsizei>(command.c));
+        } else {
+          glDrawArraysInstanced(command.a, static_cast<GLint>(command.b),
+                                static_cast<GLsizei>(command.c), instances);
+        }
+        m_stats.draws++;
+        triangles += command.a == GL_TRIANGLES
+                         ? command.c / 3 * static_cast<size_t>(instances)
+                         : 0;
+        break;
+      case CommandType::Instances:
+        instances = static_cast<GLsizei>(command.a);
+        break;
+      }
+    }
+  }
+
+  // Counted once: the per command bookkeeping stays out of the loop
+  FrameStats::Instance().CountDraws(m_stats.draws, triangles);
+}
@@ -0,0 +1,262 @@
+#include "ComponentStore.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// ============================== Archetype ================================= //
+size_t Archetype::Append(Entity entity) {
+  m_entities.push_back(entity);
+  if (m_mask & kTransformComponent) {
+    m_transforms.push_back(glm::mat4(1.0f));
+  }
+  if (m_mask & kMeshComponent) {
+    m_meshes.push_back(0);
+  }
+  if (m_mask & kMaterialComponent) {
+    m_materials.push_back(0);
+  }
+  if (m_mask & kBoundsComponent) {
+    m_localBounds.push_back(glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+    m_worldBounds.push_back(glm::vec4(0.0f, 0.0f, 0.0f, -1.0f));
+  }
+  if (m_mask & kLodComponent) {
+    m_lods.push_back(LodState());
+  }
+  return m_entities.size() - 1;
+}
+
+// Swaps the last element into 'row' of every column the archetype has
+template <typename T>
+static void RemoveRow(std::vector<T> &column, size_t row) {
+  if (column.empty()) {
+    return;
+  }
+  column[row] = column.back();
+  column.pop_back();
+}
+
+Entity Archetype::Remove(size_t row) {
+  size_t last = m_entities.size() - 1;
+  Entity moved = row == last ? Entity() : m_entities[last];
+  RemoveRow(m_entities, row);
+  RemoveRow(m_transforms, row);
+  RemoveRow(m_meshes, row);
+  RemoveRow(m_materials, row);
+  RemoveRow(m_localBounds, row);
+  RemoveRow(m_worldBounds, row);
+  RemoveRow(m_lods, row);
+  return moved;
+}
+
+void Archetype::CopyRow(size_t row, const Archetype &from, size_t fromRow) {
+  ComponentMask shared = m_mask & from.m_mask;
+  if (shared & kTransformComponent) {
+    m_transforms[row] = from.m_transforms[fromRow];
+  }
+  if (shared & kMeshComponent) {
+    m_meshes[row] = from.m_meshes[fromRow];
+  }
+  if (shared & kMaterialComponent) {
+    m_materials[row] = from.m_materials[fromRow];
+  }
+  if (shared & kBoundsComponent) {
+    m_localBounds[row] = from.m_localBounds[fromRow];
+    m_worldBounds[row] = from.m_worldBounds[fromRow];
+  }
+  if (shared & kLodComponent) {
+    m_lods[row] = from.m_lods[fromRow];
+  }
+}
+
+// ============================== Entities ================================== //
+Entity ComponentStore::Create(ComponentMask mask) {
+  Entity entity;
+  if (!m_freeIndices.empty()) {
+    entity.index = m_freeIndices.back();
+    m_freeIndices.pop_back();
+  } else {
+    entity.index = static_cast<uint32_t>(m_locations.size());
+    m_locations.push_back(Location());
+  }
+  Location &location = m_locations[entity.index];
+  entity.generation = location.generation;
+  location.archetype = FindArchetype(mask & kAllComponents);
+  location.row =
+      static_cast<uint32_t>(m_archetypes[location.archetype]->Append(entity));
+  location.alive = true;
+  m_count++;
+  return entity;
+}
+
+void ComponentStore::Destroy(Entity entity) {
+  if (Find(entity) == nullptr) {
+    return;
+  }
+  Location &location = m_locations[entity.index];
+  Entity moved = m_archetypes[location.archetype]->Remove(location.row);
+  if (moved.IsValid()) {
+    m_locations[moved.index].row = location.row;
+  }
+  location.alive = false;
+  // Handles to it are stale from now on
+  location.generation++;
+  m_freeIndices.push_back(entity.index);
+  m_count--;
+}
+
+bool ComponentStore::IsAlive(Entity entity) const {
+  return Find(entity) != nullptr;
+}
+
+void ComponentStore::Clear() {
+  m_archetypes.clear();
+  m_locations.clear();
+  m_freeIndices.clear();
+  m_count = 0;
+}
+
+void ComponentStore::SetMask(Entity entity, ComponentMask mask) {
+  mask &= kAllComponents;
+  const Location *found = Find(entity);
+  if (found == nullptr || m_archetypes[found->archetype]->GetMask() == mask) {
+    return;
+  }
+  // FindArchetype() may add one; the archetypes themselves do not move
+  uint32_t target = FindArchetype(mask);
+  Location &location = m_locations[entity.index];
+  Archetype &from = *m_archetypes[location.archetype];
+  Archetype &to = *m_archetypes[target];
+  size_t row = to.Append(entity);
+  to.CopyRow(row, from, location.row);
+  Entity moved = from.Remove(location.row);
+  if (moved.IsValid()) {
+    m_locations[moved.index].row = location.row;
+  }
+  location.archetype = target;
+  location.row = static_cast<uint32_t>(row);
+}
+
+ComponentMask ComponentStore::GetMask(Entity entity) const {
+  const Location *location = Find(entity);
+  return location == nullptr ? 0 : m_archetypes[location->archetype]->GetMask();
+}
+
+const ComponentStore::Location *ComponentStore::Find(Entity entity) const {
+  if (entity.index >= m_locations.size()) {
+    return nullptr;
+  }
+  const Location &location = m_locations[entity.index];
+  if (!location.alive || location.generation != entity.generation) {
+    return nullptr;
+  }
+  return &location;
+}
+
+uint32_t ComponentStore::FindArchetype(ComponentMask mask) {
+  for (size_t i = 0; i < m_archetypes.size(); i++) {
+    if (m_archetypes[i]->GetMask() == mask) {
+      return static_cast<uint32_t>(i);
+    }
+  }
+  m_archetypes.push_back(std::unique_ptr<Archetype>(new Archetype(mask)));
+  return static_cast<uint32_t>(m_archetypes.size() - 1);
+}
+
+template <typename T>
+T *ComponentStore::Column(Entity entity, ComponentMask component,
+                          std::vector<T> Archetype::*column) {
+  const Location *location = Find(entity);
+  if (location == nullptr) {
+    return nullptr;
+  }
+  Archetype &archetype = *m_archetypes[location->archetype];
+  if (!archetype.Has(component)) {
+    return nullptr;
+  }
+  return &(archetype.*column)[location->row];
+}
+
+glm::mat4 *ComponentStore::GetTransform(Entity entity) {
+  return Column(entity, kTransformComponent, &Archetype::m_transforms);
+}
+
+uint32_t *ComponentStore::GetMesh(Entity entity) {
+  return Column(entity, kMeshComponent, &Archetype::m_meshes);
+}
+
+uint32_t *ComponentStore::GetMaterial(Entity entity) {
+  return Column(entity, kMaterialComponent, &Archetype::m_materials);
+}
+
+glm::vec4 *ComponentStore::GetBounds(Entity entity) {
+  return Column(entity, kBoundsComponent, &Archetype::m_localBounds);
+}
+
+LodState *ComponentStore::GetLod(Entity entity) {
+  return Column(entity, kLodComponent, &Archetype::m_lods);
+}
+
+// ============================== Systems =================================== //
+void UpdateWorldBounds(ComponentStore &store) {
+  for (size_t a = 0; a < store.GetArchetypeCount(); a++) {
+    Archetype &archetype = store.GetArchetype(a);
+    if (!archetype.Has(kTransformComponent | kBoundsComponent)) {
+      continue;
+    }
+    const glm::mat4 *transforms = archetype.GetTransforms();
+    const glm::vec4 *local = archetype.GetLocalBounds();
+    glm::vec4 *world = archetype.GetWorldBounds();
+    for (size_t i = 0; i < archetype.GetSize(); i++) {
+      const glm::mat4 &model = transforms[i];
+      glm::vec3 center =
+          glm::vec3(model * glm::vec4(glm::vec3(local[i]), 1.0f));
+      float scale = std::max(glm::length(glm::vec3(model[0])),
+                             std::max(glm::length(glm::vec3(model[1])),
+                                      glm::length(glm::vec3(model[2]))));
+      world[i] =
+          glm::vec4(center, local[i].w < 0.0f ? -1.0f : local[i].w * scale);
+    }
+  }
+}
+
+void SelectLods(ComponentStore &store, const glm::vec3 &eye) {
+  for (size_t a = 0; a < store.GetArchetypeCount(); a++) {
+    Archetype &archetype = store.GetArchetype(a);
+    if (!archetype.Has(kBoundsComponent | kLodComponent)) {
+      continue;
+    }
+    const glm::vec4 *world = archetype.GetWorldBounds();
+    LodState *lods = archetype.GetLods();
+    for (size_t i = 0; i < archetype.GetSize(); i++) {
+      LodState &lod = lods[i];
+      // From the sphere's surface, so the camera inside it gets level 0
+      float distance = glm::length(glm::vec3(world[i]) - eye) -
+                       std::max(world[i].w, 0.0f);
+      uint32_t level = 0;
+      if (lod.firstDistance > 0.0f && distance >= lod.firstDistance) {
+        level = 1 + static_cast<uint32_t>(
+                        std::floor(std::log2(distance / lod.firstDistance)));
+      }
+      lod.level = std::min(level, std::max(lod.levelCount, 1u) - 1);
+    }
+  }
+}
+
+void CullRenderables(const ComponentStore &store,
+                     const MultiViewFrustum &frustum, ComponentMask required,
+                     std::vector<DrawRef> &visible) {
+  for (size_t a = 0; a < store.GetArchetypeCount(); a++) {
+    const Archetype &archetype = store.GetArchetype(a);
+    if (!archetype.Has(kRenderableComponents | required)) {
+      continue;
+    }
+    const glm::vec4 *world = archetype.GetWorldBounds();
+    for (size_t i = 0; i < archetype.GetSize(); i++) {
+      if (world[i].w < 0.0f ||
+          frustum.IntersectsSphere(glm::vec3(world[i]), world[i].w)) {
+        visible.push_back(
+            DrawRef{static_cast<uint32_t>(a), static_cast<uint32_t>(i)});
+      }
+    }
+  }
+}
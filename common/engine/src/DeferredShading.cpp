@@ -0,0 +1,163 @@
+#include "DeferredShading.hpp"
+#include "ResourceTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// Framebuffer bytes per sample of each pass
+// Forward: color write, depth read and write
+static const uint64_t kForwardBytes = 4 + 4 + 4;
+// G-buffer: albedo (RGBA8) and normal (RG16) writes, depth read and write
+static const uint64_t kGeometryBytes = 4 + 4 + 4 + 4;
+// Light volumes: depth and normal reads, RGBA16F blend (read and write)
+static const uint64_t kLightBytes = 4 + 4 + 8 + 8;
+// Resolve: albedo, normal, depth and light reads, color write
+static const uint64_t kResolveBytes = 4 + 4 + 4 + 8 + 4;
+
+float LightRange(const PointLight &light, float cutoff, float maxRange) {
+  float brightest =
+      std::max(light.color.r, std::max(light.color.g, light.color.b));
+  // Solve quadratic d^2 + linear d + constant = brightest / cutoff for d
+  float c = light.constant - brightest / cutoff;
+  float range = maxRange;
+  if (light.quadratic > 0.0f) {
+    float discriminant =
+        light.linear * light.linear - 4.0f * light.quadratic * c;
+    range = (-light.linear + std::sqrt(std::max(discriminant, 0.0f))) /
+            (2.0f * light.quadratic);
+  } else if (light.linear > 0.0f) {
+    range = -c / light.linear;
+  }
+  return std::max(0.0f, std::min(range, maxRange));
+}
+
+LightsBlock MakeLightsBlock(const PointLight *lights, size_t count,
+                            const glm::mat4 &viewProjection,
+                            const glm::vec3 &eyePosition, float cutoff,
+                            float maxRange) {
+  LightsBlock block;
+  count = std::min<size_t>(count, kMaxLights);
+  for (size_t i = 0; i < kMaxLights; i++) {
+    LightVolume &volume = block.lights[i];
+    if (i >= count) {
+      volume = LightVolume{glm::vec4(0.0f), glm::vec4(0.0f), glm::vec4(0.0f)};
+      continue;
+    }
+    const PointLight &light = lights[i];
+    volume.positionRange =
+        glm::vec4(light.position, LightRange(light, cutoff, maxRange));
+    volume.colorAmbient = glm::vec4(light.color, light.ambientIntensity);
+    volume.attenuationSpecular = glm::vec4(light.constant, light.linear,
+                                           light.quadratic,
+                                           light.specularStrength);
+  }
+  block.viewProjection = viewProjection;
+  block.inverseViewProjection = glm::inverse(viewProjection);
+  block.eyePosition = glm::vec4(eyePosition, 1.0f);
+  block.count = glm::ivec4(static_cast<int>(count), 0, 0, 0);
+  return block;
+}
+
+ShadingBandwidth EstimateShadingBandwidth(const ShadingSamples &samples) {
+  ShadingBandwidth bandwidth;
+  bandwidth.forward = samples.geometry * kForwardBytes;
+  bandwidth.geometryPass = samples.geometry * kGeometryBytes;
+  bandwidth.lightPass = samples.lightVolumes * kLightBytes;
+  bandwidth.resolvePass = samples.screen * kResolveBytes;
+  bandwidth.deferred =
+      bandwidth.geometryPass + bandwidth.lightPass + bandwidth.resolvePass;
+  bandwidth.forwardLighting = samples.geometry * samples.lights;
+  bandwidth.deferredLighting = samples.lightVolumes;
+  return bandwidth;
+}
+
+static double Megabytes(uint64_t bytes) {
+  return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+void PrintShadingReport(std::ostream &out, const ShadingSamples &samples) {
+  ShadingBandwidth bandwidth = EstimateShadingBandwidth(samples);
+  out << "Shading: " << samples.geometry << " scene samples, "
+      << samples.lightVolumes << " lit samples, " << samples.lights
+      << " lights\n";
+  out << "  forward:  " << Megabytes(bandwidth.forward) << " MB, "
+      << bandwidth.forwardLighting << " light evaluations\n";
+  out << "  deferred: " << Megabytes(bandwidth.deferred) << " MB (G-buffer "
+      << Megabytes(bandwidth.geometryPass) << ", lights "
+      << Megabytes(bandwidth.lightPass) << ", resolve "
+      << Megabytes(bandwidth.resolvePass) << "), "
+      << bandwidth.deferredLighting << " light evaluations\n";
+}
+
+// ============================== GpuSampleCounter ========================== //
+GpuSampleCounter::~GpuSampleCounter() { Release(); }
+
+void GpuSampleCounter::Create() {
+  if (IsCreated()) {
+    return;
+  }
+  glGenQueries(kQueries, m_queries);
+  for (int i = 0; i < kQueries; i++) {
+    m_pending[i] = false;
+    ResourceTracker::Instance().TrackGpu(GpuResourceKind::Query, m_queries[i],
+                                         0, GL_SAMPLES_PASSED,
+                                         "GpuSampleCounter");
+  }
+  m_next = 0;
+  m_running = -1;
+}
+
+void GpuSampleCounter::Release() {
+  if (!IsCreated()) {
+    return;
+  }
+  for (int i = 0; i < kQueries; i++) {
+    ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Query,
+                                           m_queries[i]);
+  }
+  glDeleteQueries(kQueries, m_queries);
+  for (int i = 0; i < kQueries; i++) {
+    m_queries[i] = 0;
+    m_pending[i] = false;
+  }
+}
+
+void GpuSampleCounter::Begin() {
+  if (!IsCreated() || m_pending[m_next]) {
+    return;
+  }
+  m_running = m_next;
+  glBeginQuery(GL_SAMPLES_PASSED, m_queries[m_running]);
+}
+
+void GpuSampleCounter::End() {
+  if (m_running < 0) {
+    return;
+  }
+  glEndQuery(GL_SAMPLES_PASSED);
+  m_pending[m_running] = true;
+  m_next = (m_running + 1) % kQueries;
+  m_running = -1;
+}
+
+bool GpuSampleCounter::Poll(uint64_t &samples) {
+  bool found = false;
+  // Oldest first, so the newest finished result is the one returned
+  for (int k = 0; k < kQueries; k++) {
+    int i = (m_next + k) % kQueries;
+    if (!m_pending[i]) {
+      continue;
+    }
+    GLint available = 0;
+    glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      continue;
+    }
+    GLuint64 count = 0;
+    glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &count);
+    m_pending[i] = false;
+    samples = static_cast<uint64_t>(count);
+    found = true;
+  }
+  return found;
+}
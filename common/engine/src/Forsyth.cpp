@@ -0,0 +1,4 @@
+// forsyth.h is a single file library; its implementation lives here so
+// every program and tool linking the engine can use it.
+#define FORSYTH_IMPLEMENTATION
+#include "forsyth.h"
@@ -0,0 +1,244 @@
+#include "ForsythTuner.hpp"
+#include "ObjParser.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+// ============================== Corpus ===================================== //
+bool LoadTuneMesh(const std::string &path, TuneMesh &out, std::string *error) {
+  ObjData data;
+  if (!LoadObjFile(path, data, error)) {
+    return false;
+  }
+  out.name = path.substr(path.find_last_of("/\\") + 1);
+  out.vertexCount = data.positions.size();
+  out.indices.clear();
+  out.indices.reserve(data.corners.size());
+  for (const ObjIndex &corner : data.corners) {
+    out.indices.push_back(static_cast<uint32_t>(corner.position));
+  }
+  return true;
+}
+
+double EvaluateForsyth(const std::vector<TuneMesh> &corpus,
+                       const ForsythParams &params,
+                       const VertexCacheModel &target) {
+  if (corpus.empty()) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  std::vector<ForsythVertexIndexType> reordered;
+  for (const TuneMesh &mesh : corpus) {
+    reordered.resize(mesh.indices.size());
+    int triangles = static_cast<int>(mesh.indices.size() / 3);
+    if (forsythReorderIndicesWithParams(
+            reordered.data(), mesh.indices.data(), triangles,
+            static_cast<int>(mesh.vertexCount), &params) == nullptr) {
+      // Too many triangles on one vertex: the mesh keeps its order
+      reordered = mesh.indices;
+    }
+    sum += SimulateVertexCache(reordered.data(), reordered.size(),
+                               mesh.vertexCount, target)
+               .GetAcmr();
+  }
+  return sum / corpus.size();
+}
+
+double EvaluateUnoptimized(const std::vector<TuneMesh> &corpus,
+                           const VertexCacheModel &target) {
+  if (corpus.empty()) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  for (const TuneMesh &mesh : corpus) {
+    sum += SimulateVertexCache(mesh.indices.data(), mesh.indices.size(),
+                               mesh.vertexCount, target)
+               .GetAcmr();
+  }
+  return sum / corpus.size();
+}
+
+// ============================== Search ===================================== //
+namespace {
+
+// The five parameters as one point of the search space
+const int kDimensions = 5;
+struct Range {
+  float low, high;
+};
+const Range kRanges[kDimensions] = {
+    {4.0f, static_cast<float>(FORSYTH_MAX_VERTEX_CACHE_SIZE)}, // cacheSize
+    {0.0f, 3.0f},                                              // decay power
+    {0.25f, 1.5f},                                             // last tri
+    {0.5f, 8.0f},                                              // valence scale
+    {0.25f, 1.5f}};                                            // valence power
+
+ForsythParams ToParams(const float point[kDimensions]) {
+  ForsythParams params;
+  params.cacheSize = static_cast<int>(std::lround(point[0]));
+  params.cacheDecayPower = point[1];
+  params.lastTriScore = point[2];
+  params.valenceBoostScale = point[3];
+  params.valenceBoostPower = point[4];
+  return params;
+}
+
+struct Candidate {
+  float point[kDimensions];
+  double acmr;
+};
+
+// Scores every candidate, spread over the threads
+void Evaluate(std::vector<Candidate> &candidates,
+              const std::vector<TuneMesh> &corpus,
+              const VertexCacheModel &target, unsigned threads) {
+  ParallelFor(
+      candidates.size(), 1,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          candidates[i].acmr =
+              EvaluateForsyth(corpus, ToParams(candidates[i].point), target);
+        }
+      },
+      threads);
+}
+
+// The first of the lowest, so the result does not depend on the threads
+const Candidate &Best(const std::vector<Candidate> &candidates) {
+  size_t best = 0;
+  for (size_t i = 1; i < candidates.size(); i++) {
+    if (candidates[i].acmr < candidates[best].acmr) {
+      best = i;
+    }
+  }
+  return candidates[best];
+}
+
+// Local search: try one step up and down in every dimension, move to the
+// best neighbour, halve the steps when none is better
+Candidate Refine(Candidate best, int gridSteps,
+                 const std::vector<TuneMesh> &corpus,
+                 const VertexCacheModel &target,
+                 const ForsythTuneOptions &options, int &evaluations) {
+  float step[kDimensions];
+  for (int d = 0; d < kDimensions; d++) {
+    step[d] = (kRanges[d].high - kRanges[d].low) / (gridSteps - 1) / 2.0f;
+  }
+  step[0] = std::max(step[0], 1.0f); // The cache size is an integer
+  std::vector<Candidate> candidates;
+  for (int round = 0; round < options.refineRounds;) {
+    candidates.clear();
+    for (int d = 0; d < kDimensions; d++) {
+      for (int sign = -1; sign <= 1; sign += 2) {
+        Candidate neighbour = best;
+        neighbour.point[d] =
+            std::min(kRanges[d].high,
+                     std::max(kRanges[d].low, best.point[d] + sign * step[d]));
+        if (neighbour.point[d] != best.point[d]) {
+          candidates.push_back(neighbour);
+        }
+      }
+    }
+    if (candidates.empty()) {
+      break;
+    }
+    Evaluate(candidates, corpus, target, options.threads);
+    evaluations += static_cast<int>(candidates.size());
+    const Candidate &next = Best(candidates);
+    if (next.acmr < best.acmr) {
+      best = next;
+      continue;
+    }
+    for (int d = 0; d < kDimensions; d++) {
+      step[d] /= 2.0f;
+    }
+    step[0] = std::max(std::floor(step[0]), 1.0f);
+    round++;
+  }
+  return best;
+}
+
+} // namespace
+
+ForsythTuneResult TuneForsyth(const std::vector<TuneMesh> &corpus,
+                              const VertexCacheModel &target,
+                              const ForsythTuneOptions &options) {
+  ForsythTuneResult result;
+  ForsythParams defaults = forsythDefaultParams();
+  result.defaultAcmr = EvaluateForsyth(corpus, defaults, target);
+  result.params = defaults;
+  result.acmr = result.defaultAcmr;
+  result.evaluations = 1;
+
+  // Coarse grid over everything
+  int steps = std::max(options.gridSteps, 2);
+  std::vector<Candidate> candidates;
+  size_t gridSize = 1;
+  for (int d = 0; d < kDimensions; d++) {
+    gridSize *= steps;
+  }
+  candidates.resize(gridSize);
+  for (size_t i = 0; i < gridSize; i++) {
+    size_t rest = i;
+    for (int d = 0; d < kDimensions; d++) {
+      float t = static_cast<float>(rest % steps) / (steps - 1);
+      rest /= steps;
+      candidates[i].point[d] =
+          kRanges[d].low + t * (kRanges[d].high - kRanges[d].low);
+    }
+  }
+  Evaluate(candidates, corpus, target, options.threads);
+  result.evaluations += static_cast<int>(candidates.size());
+
+  // The grid is coarse, so the best point of it is not always on the slope
+  // of the best minimum: refine several of them
+  std::stable_sort(candidates.begin(), candidates.end(),
+                   [](const Candidate &a, const Candidate &b) {
+                     return a.acmr < b.acmr;
+                   });
+  candidates.resize(std::min<size_t>(candidates.size(),
+                                     std::max(options.starts, 1)));
+  Candidate best = candidates[0];
+  for (const Candidate &start : candidates) {
+    Candidate refined = Refine(start, steps, corpus, target, options,
+                               result.evaluations);
+    if (refined.acmr < best.acmr) {
+      best = refined;
+    }
+  }
+
+  // Never worse than the defaults
+  if (best.acmr < result.acmr) {
+    result.params = ToParams(best.point);
+    result.acmr = best.acmr;
+  }
+  return result;
+}
+
+// ============================== Presets ==================================== //
+// Output of tools/ForsythTune.cpp on common/objects (mean ACMR with the
+// defaults -> tuned: fifo16 0.665 -> 0.642, fifo32 0.622 -> 0.593,
+// lru16 0.657 -> 0.634, lru32 0.619 -> 0.587)
+static const ForsythPreset kPresets[] = {
+    {"default", {24, 1.5f, 0.75f, 2.0f, 0.5f}},
+    {"fifo16", {15, 0.0f, 0.875f, 3.25f, 0.611f}},
+    {"fifo32", {32, 0.0f, 0.25f, 5.89f, 0.25f}},
+    {"lru16", {15, 0.0f, 0.914f, 2.38f, 0.602f}},
+    {"lru32", {32, 0.0f, 0.25f, 5.89f, 0.25f}},
+};
+
+const ForsythPreset *GetForsythPresets(size_t &count) {
+  count = sizeof(kPresets) / sizeof(kPresets[0]);
+  return kPresets;
+}
+
+bool FindForsythPreset(const std::string &name, ForsythParams &out) {
+  for (const ForsythPreset &preset : kPresets) {
+    if (name == preset.name) {
+      out = preset.params;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,97 @@
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+const size_t FrameHistory::kSize;
+
+void FrameHistory::Push(float value) {
+  m_values[m_next] = value;
+  m_next = (m_next + 1) % kSize;
+  if (m_count < kSize) {
+    m_count++;
+  }
+}
+
+float FrameHistory::Get(size_t i) const {
+  // The oldest sample is at m_next once the ring is full
+  size_t first = m_count < kSize ? 0 : m_next;
+  return m_values[(first + i) % kSize];
+}
+
+float FrameHistory::GetAverage() const {
+  if (m_count == 0) {
+    return 0.0f;
+  }
+  float sum = 0.0f;
+  for (size_t i = 0; i < m_count; i++) {
+    sum += m_values[i];
+  }
+  return sum / static_cast<float>(m_count);
+}
+
+float FrameHistory::GetMax() const {
+  float result = 0.0f;
+  for (size_t i = 0; i < m_count; i++) {
+    result = std::max(result, m_values[i]);
+  }
+  return result;
+}
+
+float FrameHistory::GetPercentile(float fraction) const {
+  if (m_count == 0) {
+    return 0.0f;
+  }
+  float sorted[kSize];
+  std::copy(m_values, m_values + m_count, sorted);
+  fraction = std::min(std::max(fraction, 0.0f), 1.0f);
+  size_t rank = static_cast<size_t>(std::ceil(fraction * m_count));
+  size_t index = rank == 0 ? 0 : rank - 1;
+  std::nth_element(sorted, sorted + index, sorted + m_count);
+  return sorted[index];
+}
+
+void FrameHistory::Clear() {
+  m_next = 0;
+  m_count = 0;
+}
+
+FrameStats &FrameStats::Instance() {
+  static FrameStats instance;
+  return instance;
+}
+
+void FrameStats::EndFrame() {
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (m_hasLastEnd) {
+    std::chrono::duration<float, std::milli> elapsed = now - m_lastEnd;
+    m_frameTimes.Push(elapsed.count());
+  }
+  m_hasLastEnd = true;
+  m_lastEnd = now;
+  m_last = m_current;
+  m_current = FrameCounters();
+  m_frame++;
+}
+
+void FrameStats::EndFrame(float frameMilliseconds) {
+  m_frameTimes.Push(frameMilliseconds);
+  m_last = m_current;
+  m_current = FrameCounters();
+  m_frame++;
+}
+
+void FrameStats::DiscardIdleTime() {
+  if (m_hasLastEnd) {
+    m_lastEnd = std::chrono::steady_clock::now();
+  }
+}
+
+void FrameStats::Reset() {
+  m_current = FrameCounters();
+  m_last = FrameCounters();
+  m_frameTimes.Clear();
+  m_gpuTimes.Clear();
+  m_frame = 0;
+  m_hasLastEnd = false;
+}
@@ -0,0 +1,70 @@
+#include "Frustum.hpp"
+
+#include <glm/geometric.hpp>
+
+Frustum::Frustum() {
+  for (int i = 0; i < PlaneCount; i++) {
+    m_planes[i] = glm::vec4(0.0f);
+  }
+}
+
+Frustum::Frustum(const glm::mat4 &viewProjection) { Set(viewProjection); }
+
+// Each plane is a sum or difference of the last row and one other row of
+// the matrix (glm is column major, so row i is m[0][i], m[1][i], ...).
+void Frustum::Set(const glm::mat4 &m) {
+  glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+  glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+  glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+  glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+  m_planes[Left] = row3 + row0;
+  m_planes[Right] = row3 - row0;
+  m_planes[Bottom] = row3 + row1;
+  m_planes[Top] = row3 - row1;
+  m_planes[Near] = row3 + row2;
+  m_planes[Far] = row3 - row2;
+
+  for (int i = 0; i < PlaneCount; i++) {
+    float length = glm::length(glm::vec3(m_planes[i]));
+    if (length > 0.0f) {
+      m_planes[i] /= length;
+    }
+  }
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3 &center, float radius) const {
+  for (int i = 0; i < PlaneCount; i++) {
+    const glm::vec4 &plane = m_planes[i];
+    if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Only the corner furthest along each plane normal (the 'positive vertex')
+// has to be tested.
+bool Frustum::IntersectsAabb(const Aabb &box) const {
+  for (int i = 0; i < PlaneCount; i++) {
+    const glm::vec4 &plane = m_planes[i];
+    glm::vec3 positive(plane.x >= 0.0f ? box.max.x : box.min.x,
+                       plane.y >= 0.0f ? box.max.y : box.min.y,
+                       plane.z >= 0.0f ? box.max.z : box.min.z);
+    if (glm::dot(glm::vec3(plane), positive) + plane.w < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t CullAabbs(const Frustum &frustum, const Aabb *boxes, size_t count,
+                 uint8_t *visible) {
+  size_t visibleCount = 0;
+  for (size_t i = 0; i < count; i++) {
+    bool inside = frustum.IntersectsAabb(boxes[i]);
+    visible[i] = inside ? 1 : 0;
+    visibleCount += inside ? 1 : 0;
+  }
+  return visibleCount;
+}
@@ -0,0 +1,263 @@
+#include "GLDebug.hpp"
+
+#include <cstring>
+#include <iostream>
+
+GLDebug::GLDebug() : m_out(&std::cerr) {}
+
+GLDebug &GLDebug::Instance() {
+  static GLDebug instance;
+  return instance;
+}
+
+static const char *SourceName(GLenum source) {
+  switch (source) {
+  case GL_DEBUG_SOURCE_API:
+    return "api";
+  case GL_DEBUG_SOURCE_WINDOW_SYSTEM:
+    return "window system";
+  case GL_DEBUG_SOURCE_SHADER_COMPILER:
+    return "shader compiler";
+  case GL_DEBUG_SOURCE_THIRD_PARTY:
+    return "third party";
+  case GL_DEBUG_SOURCE_APPLICATION:
+    return "application";
+  default:
+    return "other";
+  }
+}
+
+static const char *TypeName(GLenum type) {
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    return "error";
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+    return "deprecated";
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+    return "undefined behavior";
+  case GL_DEBUG_TYPE_PORTABILITY:
+    return "portability";
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    return "performance";
+  default:
+    return "other";
+  }
+}
+
+// Lower number = more severe
+static int SeverityRank(GLenum severity) {
+  switch (severity) {
+  case GL_DEBUG_SEVERITY_HIGH:
+    return 0;
+  case GL_DEBUG_SEVERITY_MEDIUM:
+    return 1;
+  case GL_DEBUG_SEVERITY_LOW:
+    return 2;
+  default:
+    return 3;
+  }
+}
+
+static void APIENTRY DebugCallback(GLenum source, GLenum type, GLuint id,
+                                   GLenum severity, GLsizei /*length*/,
+                                   const GLchar *message,
+                                   const void *userParam) {
+  GLDebug *debug = static_cast<GLDebug *>(const_cast<void *>(userParam));
+  debug->OnMessage(source, type, id, severity, message);
+}
+
+// KHR_debug is core since OpenGL 4.3; before that it is an extension.
+static bool HasKhrDebug() {
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  if (major > 4 || (major == 4 && minor >= 3)) {
+    return true;
+  }
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; i++) {
+    const char *name =
+        reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+    if (name != nullptr && std::strcmp(name, "GL_KHR_debug") == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool GLDebug::Install(GLADloadproc loader, bool synchronous) {
+  Uninstall();
+  if (loader == nullptr || !HasKhrDebug()) {
+    return false;
+  }
+  // Desktop OpenGL uses the names without the KHR suffix
+  m_debugMessageCallback =
+      reinterpret_cast<CallbackFunction>(loader("glDebugMessageCallback"));
+  m_debugMessageControl =
+      reinterpret_cast<ControlFunction>(loader("glDebugMessageControl"));
+  if (m_debugMessageCallback == nullptr || m_debugMessageControl == nullptr) {
+    return false;
+  }
+  m_synchronous = synchronous;
+  glEnable(GL_DEBUG_OUTPUT);
+  if (synchronous) {
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  } else {
+    glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+  }
+  m_debugMessageCallback(DebugCallback, this);
+  m_installed = true;
+  ApplyFilters();
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_errors = m_performance = m_warnings = m_other = 0;
+  m_total = GLDebugCounts();
+  m_lastFrame = GLDebugCounts();
+  m_printed.clear();
+  return true;
+}
+
+void GLDebug::Uninstall() {
+  if (!m_installed) {
+    return;
+  }
+  m_debugMessageCallback(nullptr, nullptr);
+  glDisable(GL_DEBUG_OUTPUT);
+  m_installed = false;
+}
+
+void GLDebug::SetMinimumSeverity(GLenum severity) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_minimumSeverity = severity;
+  }
+  ApplyFilters();
+}
+
+void GLDebug::Ignore(GLenum source, GLuint id) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ignored.insert(std::make_pair(source, id));
+  }
+  ApplyFilters();
+}
+
+// Lets the driver drop what we do not want, instead of calling us for it
+void GLDebug::ApplyFilters() {
+  if (!m_installed) {
+    return;
+  }
+  const GLenum severities[] = {GL_DEBUG_SEVERITY_HIGH, GL_DEBUG_SEVERITY_MEDIUM,
+                               GL_DEBUG_SEVERITY_LOW,
+                               GL_DEBUG_SEVERITY_NOTIFICATION};
+  for (GLenum severity : severities) {
+    bool enabled = SeverityRank(severity) <= SeverityRank(m_minimumSeverity);
+    m_debugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr,
+                          enabled ? GL_TRUE : GL_FALSE);
+  }
+  for (const auto &ignored : m_ignored) {
+    m_debugMessageControl(ignored.first, GL_DONT_CARE, GL_DONT_CARE, 1,
+                          &ignored.second, GL_FALSE);
+  }
+}
+
+void GLDebug::BeginCall(const char *call, const char *file, int line) {
+  m_call = call;
+  m_file = file;
+  m_line = line;
+}
+
+void GLDebug::EndCall() {
+  if (!m_installed) {
+    // No callback on this context: ask for errors the old way
+    while (GLenum error = glGetError()) {
+      OnMessage(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_ERROR, error,
+                GL_DEBUG_SEVERITY_HIGH, "glGetError");
+    }
+  }
+  m_call = nullptr;
+}
+
+void GLDebug::Count(GLenum type) {
+  switch (type) {
+  case GL_DEBUG_TYPE_ERROR:
+    m_errors++;
+    break;
+  case GL_DEBUG_TYPE_PERFORMANCE:
+    m_performance++;
+    break;
+  case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR:
+  case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:
+  case GL_DEBUG_TYPE_PORTABILITY:
+    m_warnings++;
+    break;
+  default:
+    m_other++;
+  }
+}
+
+void GLDebug::OnMessage(GLenum source, GLenum type, GLuint id,
+                        GLenum severity, const char *message) {
+  // Debug groups and markers are annotations, not problems
+  if (type == GL_DEBUG_TYPE_PUSH_GROUP || type == GL_DEBUG_TYPE_POP_GROUP ||
+      type == GL_DEBUG_TYPE_MARKER) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  // The driver filters too, but glGetError errors and injected messages
+  // come through here
+  if (SeverityRank(severity) > SeverityRank(m_minimumSeverity) ||
+      m_ignored.count(std::make_pair(source, id)) != 0) {
+    return;
+  }
+  Count(type);
+  unsigned int &printed = m_printed[std::make_pair(source, id)];
+  if (m_out == nullptr || printed >= m_printLimit) {
+    return;
+  }
+  printed++;
+  *m_out << "[GL " << TypeName(type) << ", " << SourceName(source) << " #"
+         << id << "] " << message;
+  // Only a synchronous message is known to come from the current call
+  if (m_synchronous && m_call != nullptr) {
+    *m_out << "\n    in " << m_call << " (" << m_file << ":" << m_line
+           << ")";
+  }
+  if (printed == m_printLimit) {
+    *m_out << "\n    (not printing this message again)";
+  }
+  *m_out << std::endl;
+}
+
+void GLDebug::EndFrame() {
+  GLDebugCounts frame;
+  frame.errors = m_errors.exchange(0);
+  frame.performance = m_performance.exchange(0);
+  frame.warnings = m_warnings.exchange(0);
+  frame.other = m_other.exchange(0);
+  m_lastFrame = frame;
+  m_frame++;
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_total.errors += frame.errors;
+  m_total.performance += frame.performance;
+  m_total.warnings += frame.warnings;
+  m_total.other += frame.other;
+  if (m_out != nullptr && (frame.errors > 0 || frame.performance > 0)) {
+    *m_out << "[GL] frame " << m_frame << ": " << frame.errors
+           << " error(s), " << frame.performance
+           << " performance warning(s), " << frame.warnings
+           << " other warning(s)" << std::endl;
+  }
+}
+
+GLDebugCounts GLDebug::GetTotal() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  GLDebugCounts total = m_total;
+  total.errors += m_errors;
+  total.performance += m_performance;
+  total.warnings += m_warnings;
+  total.other += m_other;
+  return total;
+}
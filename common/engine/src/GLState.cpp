@@ -0,0 +1,580 @@
+#include "GLState.hpp"
+#include "FrameStats.hpp"
+#include "GLDebug.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+const unsigned GLState::kTextureUnits;
+const GLuint GLState::kUnknown;
+const int GLState::kBufferTargets;
+const int GLState::kCapabilities;
+const int GLStateCounters::kKinds;
+
+const char *GLStateKindName(GLStateKind kind) {
+  switch (kind) {
+  case GLStateKind::Program:
+    return "program";
+  case GLStateKind::VertexArray:
+    return "vertex array";
+  case GLStateKind::Buffer:
+    return "buffer";
+  case GLStateKind::Framebuffer:
+    return "framebuffer";
+  case GLStateKind::ActiveTexture:
+    return "active texture";
+  case GLStateKind::Texture:
+    return "texture";
+  case GLStateKind::Viewport:
+    return "viewport";
+  case GLStateKind::ClearColor:
+    return "clear color";
+  case GLStateKind::Capability:
+    return "enable/disable";
+  case GLStateKind::BlendFunc:
+    return "blend func";
+  case GLStateKind::CullFace:
+    return "cull face";
+  case GLStateKind::DepthFunc:
+    return "depth func";
+  case GLStateKind::DepthMask:
+    return "depth mask";
+  case GLStateKind::PolygonMode:
+    return "polygon mode";
+  default:
+    return "?";
+  }
+}
+
+uint64_t GLStateCounters::GetIssued() const {
+  uint64_t total = 0;
+  for (int k = 0; k < kKinds; k++) {
+    total += issued[k];
+  }
+  return total;
+}
+
+uint64_t GLStateCounters::GetFiltered() const {
+  uint64_t total = 0;
+  for (int k = 0; k < kKinds; k++) {
+    total += filtered[k];
+  }
+  return total;
+}
+
+// ============================== Shadow slots =============================== //
+// Buffer targets with a shadow and the glGet that reads them back (the copy
+// targets are their own query in 3.3)
+static const GLenum kBufferTargetList[] = {
+    GL_ARRAY_BUFFER,        GL_UNIFORM_BUFFER,   GL_PIXEL_PACK_BUFFER,
+    GL_PIXEL_UNPACK_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER};
+static const GLenum kBufferBindingList[] = {
+    GL_ARRAY_BUFFER_BINDING,      GL_UNIFORM_BUFFER_BINDING,
+    GL_PIXEL_PACK_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING,
+    GL_COPY_READ_BUFFER,          GL_COPY_WRITE_BUFFER};
+
+static int BufferSlot(GLenum target) {
+  for (int i = 0; i < 6; i++) {
+    if (kBufferTargetList[i] == target) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+static const GLenum kCapabilityList[] = {GL_DEPTH_TEST, GL_BLEND,
+                                         GL_CULL_FACE, GL_SCISSOR_TEST};
+
+static int CapabilitySlot(GLenum capability) {
+  for (int i = 0; i < 4; i++) {
+    if (kCapabilityList[i] == capability) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+// ============================== GLState ==================================== //
+GLState::GLState() : m_validate(ENGINE_GL_DEBUG != 0) {
+  const char *validate = std::getenv("ENGINE_GL_STATE_VALIDATE");
+  if (validate != nullptr && validate[0] != '\0') {
+    m_validate = std::strcmp(validate, "0") != 0;
+  }
+  Invalidate();
+}
+
+GLState &GLState::Instance() {
+  static GLState instance;
+  return instance;
+}
+
+void GLState::Invalidate() {
+  m_program = kUnknown;
+  m_vertexArray = kUnknown;
+  for (GLuint &buffer : m_buffers) {
+    buffer = kUnknown;
+  }
+  m_drawFramebuffer = m_readFramebuffer = kUnknown;
+  m_activeTexture = kUnknown;
+  for (GLuint &texture : m_textures) {
+    texture = kUnknown;
+  }
+  m_viewportKnown = false;
+  m_clearColorKnown = false;
+  for (int &capability : m_capabilities) {
+    capability = -1;
+  }
+  m_blendSource = m_blendDestination = kUnknown;
+  m_cullFace = kUnknown;
+  m_depthFunc = kUnknown;
+  m_depthMask = -1;
+  m_polygonMode = kUnknown;
+}
+
+void GLState::OnDeleted(GpuResourceKind kind, GLuint id) {
+  if (id == 0) {
+    return;
+  }
+  switch (kind) {
+  case GpuResourceKind::Buffer:
+    for (GLuint &buffer : m_buffers) {
+      buffer = buffer == id ? 0 : buffer;
+    }
+    break;
+  case GpuResourceKind::Texture:
+    for (GLuint &texture : m_textures) {
+      texture = texture == id ? 0 : texture;
+    }
+    break;
+  case GpuResourceKind::VertexArray:
+    m_vertexArray = m_vertexArray == id ? 0 : m_vertexArray;
+    break;
+  case GpuResourceKind::Framebuffer:
+    m_drawFramebuffer = m_drawFramebuffer == id ? 0 : m_drawFramebuffer;
+    m_readFramebuffer = m_readFramebuffer == id ? 0 : m_readFramebuffer;
+    break;
+  default:
+    // A program that is in use stays in use until another one is
+    // (its name is not reused before that)
+    break;
+  }
+}
+
+void GLState::Issued(GLStateKind kind) {
+  m_counters.issued[static_cast<int>(kind)]++;
+  FrameStats::Instance().CountStateChange();
+}
+
+bool GLState::Filter(GLStateKind kind, bool same) {
+  if (same) {
+    m_counters.filtered[static_cast<int>(kind)]++;
+    FrameStats::Instance().CountFilteredStateChange();
+    return true;
+  }
+  Issued(kind);
+  return false;
+}
+
+bool GLState::Check(GLStateKind kind, bool matches) {
+  if (!matches) {
+    if (m_counters.mismatches++ < 10) {
+      std::cerr << "GLState: stale " << GLStateKindName(kind)
+                << " shadow (something changed it without GLState)"
+                << std::endl;
+    }
+  }
+  return matches;
+}
+
+bool GLState::CheckInteger(GLStateKind kind, GLenum query, GLint shadow) {
+  GLint real = 0;
+  glGetIntegerv(query, &real);
+  return Check(kind, real == shadow);
+}
+
+// ============================== Bindings =================================== //
+void GLState::UseProgram(GLuint program) {
+  bool same = m_program == program;
+  if (same && m_validate) {
+    same = CheckInteger(GLStateKind::Program, GL_CURRENT_PROGRAM,
+                        static_cast<GLint>(program));
+  }
+  if (Filter(GLStateKind::Program, same)) {
+    return;
+  }
+  glUseProgram(program);
+  m_program = program;
+}
+
+void GLState::BindVertexArray(GLuint vertexArray) {
+  bool same = m_vertexArray == vertexArray;
+  if (same && m_validate) {
+    same = CheckInteger(GLStateKind::VertexArray, GL_VERTEX_ARRAY_BINDING,
+                        static_cast<GLint>(vertexArray));
+  }
+  if (Filter(GLStateKind::VertexArray, same)) {
+    return;
+  }
+  glBindVertexArray(vertexArray);
+  m_vertexArray = vertexArray;
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer) {
+  int slot = BufferSlot(target);
+  bool same = slot >= 0 && m_buffers[slot] == buffer;
+  if (same && m_validate) {
+    same = CheckInteger(GLStateKind::Buffer, kBufferBindingList[slot],
+                        static_cast<GLint>(buffer));
+  }
+  if (Filter(GLStateKind::Buffer, same)) {
+    return;
+  }
+  glBindBuffer(target, buffer);
+  if (slot >= 0) {
+    m_buffers[slot] = buffer;
+  }
+}
+
+void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+  Issued(GLStateKind::Buffer);
+  glBindBufferBase(target, index, buffer);
+  int slot = BufferSlot(target);
+  if (slot >= 0) {
+    m_buffers[slot] = buffer;
+  }
+}
+
+void GLState::BindBufferRange(GLenum target, GLuint index, GLuint buffer,
+                              GLintptr offset, GLsizeiptr size) {
+  Issued(GLStateKind::Buffer);
+  glBindBufferRange(target, index, buffer, offset, size);
+  int slot = BufferSlot(target);
+  if (slot >= 0) {
+    m_buffers[slot] = buffer;
+  }
+}
+
+void GLState::BindFramebuffer(GLenum target, GLuint framebuffer) {
+  bool draw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+  bool read = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+  bool same = (!draw || m_drawFramebuffer == framebuffer) &&
+              (!read || m_readFramebuffer == framebuffer);
+  if (same && m_validate) {
+    same = (!draw || CheckInteger(GLStateKind::Framebuffer,
+                                  GL_DRAW_FRAMEBUFFER_BINDING,
+                                  static_cast<GLint>(framebuffer))) &&
+           (!read || CheckInteger(GLStateKind::Framebuffer,
+                                  GL_READ_FRAMEBUFFER_BINDING,
+                                  static_cast<GLint>(framebuffer)));
+  }
+  if (Filter(GLStateKind::Framebuffer, same)) {
+    return;
+  }
+  glBindFramebuffer(target, framebuffer);
+  if (draw) {
+    m_drawFramebuffer = framebuffer;
+  }
+  if (read) {
+    m_readFramebuffer = framebuffer;
+  }
+}
+
+void GLState::ActiveTexture(unsigned unit) {
+  bool same = m_activeTexture == unit;
+  if (same && m_validate) {
+    same = CheckInteger(GLStateKind::ActiveTexture, GL_ACTIVE_TEXTURE,
+                        static_cast<GLint>(GL_TEXTURE0 + unit));
+  }
+  if (Filter(GLStateKind::ActiveTexture, same)) {
+    return;
+  }
+  glActiveTexture(GL_TEXTURE0 + unit);
+  m_activeTexture = unit;
+}
+
+void GLState::BindTexture(unsigned unit, GLenum target, GLuint texture) {
+  ActiveTexture(unit);
+  bool tracked = target == GL_TEXTURE_2D && unit < kTextureUnits;
+  bool same = tracked && m_textures[unit] == texture;
+  if (same && m_validate) {
+    same = CheckInteger(GLStateKind::Texture, GL_TEXTURE_BINDING_2D,
+                        static_cast<GLint>(texture));
+  }
+  if (Filter(GLStateKind::Texture, same)) {
+    return;
+  }
+  glBindTexture(target, texture);
+  if (tracked) {
+    m_textures[unit] = texture;
+  }
+}
+
+// ============================== Fixed function ============================= //
+void GLState::Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  const GLint viewport[4] = {x, y, width, height};
+  bool same = m_viewportKnown &&
+              std::memcmp(m_viewport, viewport, sizeof(viewport)) == 0;
+  if (same && m_validate) {
+    GLint real[4];
+    glGetIntegerv(GL_VIEWPORT, real);
+    same = Check(GLStateKind::Viewport,
+                 std::memcmp(real, viewport, sizeof(viewport)) == 0);
+  }
+  if (Filter(GLStateKind::Viewport, same)) {
+    return;
+  }
+  glViewport(x, y, width, height);
+  std::memcpy(m_viewport, viewport, sizeof(viewport));
+  m_viewportKnown = true;
+}
+
+void GLState::ClearColor(float r, float g, float b, float a) {
+  const float color[4] = {r, g, b, a};
+  bool same = m_clearColorKnown &&
+              std::memcmp(m_clearColor, color, sizeof(color)) == 0;
+  if (same && m_validate) {
+    // Drivers may store the color with less precision, so compare what
+    // they return for the same value
+    GLfloat real[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, real);
+    bool matches = true;
+    for (int i = 0; i < 4; i++) {
+      matches = matches && real[i] > color[i] - 1e-3f &&
+                real[i] < color[i] + 1e-3f;
+    }
+    same = Check(GLStateKind::ClearColor, matches);
+  }
+  if (Filter(GLStateKind::ClearColor, same)) {
+    return;
+  }
+  glClearColor(r, g, b, a);
+  std::memcpy(m_clearColor, color, sizeof(color));
+  m_clearColorKnown = true;
+}
+
+void GLState::SetEnabled(GLenum capability, bool enabled) {
+  int slot = CapabilitySlot(capability);
+  bool same = slot >= 0 && m_capabilities[slot] == (enabled ? 1 : 0);
+  if (same && m_validate) {
+    same = Check(GLStateKind::Capability,
+                 (glIsEnabled(capability) == GL_TRUE) == enabled);
+  }
+  if (Filter(GLStateKind::Capability, same)) {
+    return;
+  }
+  if (enabled) {
+    glEnable(capability);
+  } else {
+    glDisable(capability);
+  }
+  if (slot >= 0) {
+    m_capabilities[slot] = enabled ? 1 : 0;
+  }
+}
+
+bool GLState::IsEnabled(GLenum capability) {
+  int slot = CapabilitySlot(capability);
+  if (slot >= 0 && m_capabilities[slot] >= 0) {
+    return m_capabilities[slot] == 1;
+  }
+  bool enabled = glIsEnabled(capability) == GL_TRUE;
+  if (slot >= 0) {
+    m_capabilities[slot] = enabled ? 1 : 0;
+  }
+  return enabled;
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination) {
+  bool same = m_blendSource == source && m_blendDestination == destination;
+  if (same && m_validate) {
+    same = CheckInteger(GLStateKind::BlendFunc, GL_BLEND_SRC_RGB,
+                        static_cast<GLint>(source)) &&
+           CheckInteger(GLStateKind::BlendFunc, GL_BLEND_DST_RGB,
+                        static_cast<GLint>(destination));
+  }
+  if (Filter(GLStateKind::BlendFunc, same)) {
+    return;
+  }
+  glBlendFunc(source, destination);
+  m_blendSource = source;
+  m_blendDestination = destination;
+}
+
+void GLState::CullFace(GLenum face) {
+  bool same = m_cullFace == face;
+  if (same && m_validate) {
+    same = CheckInteger(GLStateKind::CullFace, GL_CULL_FACE_MODE,
+                        static_cast<GLint>(face));
+  }
+  if (Filter(GLStateKind::CullFace, same)) {
+    return;
+  }
+  glCullFace(face);
+  m_cullFace = face;
+}
+
+void GLState::DepthFunc(GLenum function) {
+  bool same = m_depthFunc == function;
+  if (same && m_validate) {
+    same = CheckInteger(GLStateKind::DepthFunc, GL_DEPTH_FUNC,
+                        static_cast<GLint>(function));
+  }
+  if (Filter(GLStateKind::DepthFunc, same)) {
+    return;
+  }
+  glDepthFunc(function);
+  m_depthFunc = function;
+}
+
+void GLState::DepthMask(bool write) {
+  bool same = m_depthMask == (write ? 1 : 0);
+  if (same && m_validate) {
+    GLboolean real = GL_FALSE;
+    glGetBooleanv(GL_DEPTH_WRITEMASK, &real);
+    same = Check(GLStateKind::DepthMask, (real == GL_TRUE) == write);
+  }
+  if (Filter(GLStateKind::DepthMask, same)) {
+    return;
+  }
+  glDepthMask(write ? GL_TRUE : GL_FALSE);
+  m_depthMask = write ? 1 : 0;
+}
+
+void GLState::PolygonMode(GLenum mode) {
+  bool same = m_polygonMode == mode;
+  if (same && m_validate) {
+    // Front and back (some drivers still return both)
+    GLint real[2] = {0, 0};
+    glGetIntegerv(GL_POLYGON_MODE, real);
+    same = Check(GLStateKind::PolygonMode,
+                 real[0] == static_cast<GLint>(mode));
+  }
+  if (Filter(GLStateKind::PolygonMode, same)) {
+    return;
+  }
+  glPolygonMode(GL_FRONT_AND_BACK, mode);
+  m_polygonMode = mode;
+}
+
+// ============================== Validation ================================= //
+size_t GLState::Validate(std::ostream *out) {
+  size_t differences = 0;
+  auto compare = [&](const char *name, GLint shadow, GLint real) {
+    if (shadow == real) {
+      return;
+    }
+    differences++;
+    if (out != nullptr) {
+      *out << "GLState: " << name << " is " << real << ", shadow says "
+           << shadow << "\n";
+    }
+  };
+  GLint value = 0;
+  if (m_program != kUnknown) {
+    glGetIntegerv(GL_CURRENT_PROGRAM, &value);
+    compare("program", static_cast<GLint>(m_program), value);
+    m_program = static_cast<GLuint>(value);
+  }
+  if (m_vertexArray != kUnknown) {
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &value);
+    compare("vertex array", static_cast<GLint>(m_vertexArray), value);
+    m_vertexArray = static_cast<GLuint>(value);
+  }
+  for (int i = 0; i < kBufferTargets; i++) {
+    if (m_buffers[i] != kUnknown) {
+      glGetIntegerv(kBufferBindingList[i], &value);
+      compare("buffer binding", static_cast<GLint>(m_buffers[i]), value);
+      m_buffers[i] = static_cast<GLuint>(value);
+    }
+  }
+  if (m_drawFramebuffer != kUnknown) {
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &value);
+    compare("draw framebuffer", static_cast<GLint>(m_drawFramebuffer), value);
+    m_drawFramebuffer = static_cast<GLuint>(value);
+  }
+  if (m_readFramebuffer != kUnknown) {
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &value);
+    compare("read framebuffer", static_cast<GLint>(m_readFramebuffer), value);
+    m_readFramebuffer = static_cast<GLuint>(value);
+  }
+  GLint active = 0;
+  glGetIntegerv(GL_ACTIVE_TEXTURE, &active);
+  if (m_activeTexture != kUnknown) {
+    compare("active texture", static_cast<GLint>(GL_TEXTURE0 + m_activeTexture),
+            active);
+  }
+  for (unsigned unit = 0; unit < kTextureUnits; unit++) {
+    if (m_textures[unit] != kUnknown) {
+      glActiveTexture(GL_TEXTURE0 + unit);
+      glGetIntegerv(GL_TEXTURE_BINDING_2D, &value);
+      compare("texture binding", static_cast<GLint>(m_textures[unit]), value);
+      m_textures[unit] = static_cast<GLuint>(value);
+    }
+  }
+  glActiveTexture(static_cast<GLenum>(active));
+  m_activeTexture = static_cast<GLuint>(active) - GL_TEXTURE0;
+  if (m_viewportKnown) {
+    GLint real[4];
+    glGetIntegerv(GL_VIEWPORT, real);
+    // One difference for the whole rectangle
+    if (std::memcmp(real, m_viewport, sizeof(real)) != 0) {
+      differences++;
+      if (out != nullptr) {
+        *out << "GLState: viewport is " << real[0] << " " << real[1] << " "
+             << real[2] << "x" << real[3] << ", shadow says " << m_viewport[0]
+             << " " << m_viewport[1] << " " << m_viewport[2] << "x"
+             << m_viewport[3] << "\n";
+      }
+      std::memcpy(m_viewport, real, sizeof(real));
+    }
+  }
+  for (int i = 0; i < kCapabilities; i++) {
+    if (m_capabilities[i] >= 0) {
+      GLint enabled = glIsEnabled(kCapabilityList[i]) == GL_TRUE ? 1 : 0;
+      compare("capability", m_capabilities[i], enabled);
+      m_capabilities[i] = enabled;
+    }
+  }
+  if (m_cullFace != kUnknown) {
+    glGetIntegerv(GL_CULL_FACE_MODE, &value);
+    compare("cull face", static_cast<GLint>(m_cullFace), value);
+    m_cullFace = static_cast<GLenum>(value);
+  }
+  if (m_depthFunc != kUnknown) {
+    glGetIntegerv(GL_DEPTH_FUNC, &value);
+    compare("depth func", static_cast<GLint>(m_depthFunc), value);
+    m_depthFunc = static_cast<GLenum>(value);
+  }
+  if (m_polygonMode != kUnknown) {
+    GLint real[2] = {0, 0};
+    glGetIntegerv(GL_POLYGON_MODE, real);
+    compare("polygon mode", static_cast<GLint>(m_polygonMode), real[0]);
+    m_polygonMode = static_cast<GLenum>(real[0]);
+  }
+  // Blend func, depth mask and clear color are simply forgotten
+  m_blendSource = m_blendDestination = kUnknown;
+  m_depthMask = -1;
+  m_clearColorKnown = false;
+  m_counters.mismatches += differences;
+  return differences;
+}
+
+void GLState::PrintReport(std::ostream &out) const {
+  out << "GL state calls (issued / filtered):\n";
+  for (int k = 0; k < GLStateCounters::kKinds; k++) {
+    if (m_counters.issued[k] == 0 && m_counters.filtered[k] == 0) {
+      continue;
+    }
+    out << "  " << std::left << std::setw(16)
+        << GLStateKindName(static_cast<GLStateKind>(k)) << std::right
+        << std::setw(10) << m_counters.issued[k] << " / "
+        << m_counters.filtered[k] << "\n";
+  }
+  out << "  total           " << std::setw(10) << m_counters.GetIssued()
+      << " / " << m_counters.GetFiltered() << "\n";
+  if (m_counters.mismatches > 0) {
+    out << "  stale shadow values found: " << m_counters.mismatches << "\n";
+  }
+}
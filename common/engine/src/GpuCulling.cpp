@@ -0,0 +1,438 @@
+#include "GpuCulling.hpp"
+#include "FrameStats.hpp"
+#include "Frustum.hpp"
+#include "GLState.hpp"
+#include "ResourceTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+// Shader bindings of the other buffers
+static const GLuint kMeshBinding = 1;
+static const GLuint kCommandBinding = 2;
+static const GLuint kCounterBinding = 3;
+// GLuint count, instanceCount, firstIndex; GLint baseVertex; GLuint
+// baseInstance
+static const GLsizei kCommandBytes = 5 * sizeof(GLuint);
+static const GLuint kGroupSize = 64;
+
+// Writes one DrawElementsIndirectCommand per object that touches the
+// frustum, at a slot taken from the counter. baseInstance is the object, so
+// the vertex shader can find its transform.
+static const char *kCullShader = R"(#version 430 core
+layout(local_size_x = 64) in;
+struct Object {
+  mat4 model;
+  vec4 sphere;
+  uvec4 mesh;
+};
+layout(std430, binding = 0) readonly buffer Objects { Object u_Objects[]; };
+// indexCount, firstIndex, baseVertex, unused
+layout(std430, binding = 1) readonly buffer Meshes { uvec4 u_Meshes[]; };
+layout(std430, binding = 2) writeonly buffer Commands { uint u_Commands[]; };
+layout(std430, binding = 3) buffer Counter { uint u_Count; };
+uniform vec4 u_Planes[6];
+uniform uint u_ObjectCount;
+void main() {
+  uint object = gl_GlobalInvocationID.x;
+  if (object >= u_ObjectCount) {
+    return;
+  }
+  vec4 sphere = u_Objects[object].sphere;
+  for (int i = 0; i < 6; i++) {
+    if (dot(u_Planes[i].xyz, sphere.xyz) + u_Planes[i].w < -sphere.w) {
+      return;
+    }
+  }
+  uvec4 mesh = u_Meshes[u_Objects[object].mesh.x];
+  uint slot = atomicAdd(u_Count, 1u) * 5u;
+  u_Commands[slot + 0u] = mesh.x;
+  u_Commands[slot + 1u] = 1u;
+  u_Commands[slot + 2u] = mesh.y;
+  u_Commands[slot + 3u] = mesh.z;
+  u_Commands[slot + 4u] = object;
+}
+)";
+
+static bool HasVersion(int wantMajor, int wantMinor) {
+  GLint major = 0, minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+  return major > wantMajor || (major == wantMajor && minor >= wantMinor);
+}
+
+static bool HasExtension(const char *extension) {
+  GLint count = 0;
+  glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+  for (GLint i = 0; i < count; i++) {
+    const char *name =
+        reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+    if (name != nullptr && std::strcmp(name, extension) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+GpuCuller::~GpuCuller() { Release(); }
+
+bool GpuCuller::Create(GLADloadproc loader, bool useDrawCount) {
+  if (IsCreated()) {
+    return true;
+  }
+  m_error.clear();
+  if (loader == nullptr) {
+    m_error = "no function loader";
+    return false;
+  }
+  // The loader may return something for functions the driver does not
+  // have, so ask the context first
+  if (!HasVersion(4, 3) &&
+      !(HasExtension("GL_ARB_compute_shader") &&
+        HasExtension("GL_ARB_shader_storage_buffer_object") &&
+        HasExtension("GL_ARB_multi_draw_indirect") &&
+        HasExtension("GL_ARB_clear_buffer_object"))) {
+    m_error = "needs OpenGL 4.3 (compute shaders, multi draw indirect)";
+    return false;
+  }
+  m_dispatchCompute =
+      reinterpret_cast<DispatchComputeFunction>(loader("glDispatchCompute"));
+  m_memoryBarrier =
+      reinterpret_cast<MemoryBarrierFunction>(loader("glMemoryBarrier"));
+  m_multiDraw = reinterpret_cast<MultiDrawIndirectFunction>(
+      loader("glMultiDrawElementsIndirect"));
+  m_clearBufferData =
+      reinterpret_cast<ClearBufferDataFunction>(loader("glClearBufferData"));
+  m_drawCount = nullptr;
+  if (useDrawCount && HasVersion(4, 6)) {
+    m_drawCount = reinterpret_cast<MultiDrawIndirectCountFunction>(
+        loader("glMultiDrawElementsIndirectCount"));
+  } else if (useDrawCount && HasExtension("GL_ARB_indirect_parameters")) {
+    m_drawCount = reinterpret_cast<MultiDrawIndirectCountFunction>(
+        loader("glMultiDrawElementsIndirectCountARB"));
+  }
+  if (m_dispatchCompute == nullptr || m_memoryBarrier == nullptr ||
+      m_multiDraw == nullptr || m_clearBufferData == nullptr) {
+    m_error = "could not load the OpenGL 4.3 functions";
+    return false;
+  }
+
+  GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+  glShaderSource(shader, 1, &kCullShader, nullptr);
+  glCompileShader(shader);
+  GLint ok = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+  if (!ok) {
+    char log[512];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    m_error = std::string("shader error: ") + log;
+    glDeleteShader(shader);
+    return false;
+  }
+  GLuint program = glCreateProgram();
+  glAttachShader(program, shader);
+  glLinkProgram(program);
+  glDeleteShader(shader);
+  glGetProgramiv(program, GL_LINK_STATUS, &ok);
+  if (!ok) {
+    m_error = "could not link the culling program";
+    glDeleteProgram(program);
+    return false;
+  }
+  m_program = program;
+  m_planesLocation = glGetUniformLocation(m_program, "u_Planes");
+  m_countLocation = glGetUniformLocation(m_program, "u_ObjectCount");
+
+  glGenBuffers(1, &m_objectBuffer);
+  glGenBuffers(1, &m_meshBuffer);
+  glGenBuffers(1, &m_commandBuffer);
+  glGenBuffers(1, &m_counterBuffer);
+  glGenBuffers(1, &m_indexBuffer);
+  glGenBuffers(kReadbacks, m_readbacks);
+  GLState &state = GLState::Instance();
+  state.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterBuffer);
+  const GLuint zero = 0;
+  glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(zero), &zero, GL_DYNAMIC_DRAW);
+  for (int i = 0; i < kReadbacks; i++) {
+    state.BindBuffer(GL_COPY_WRITE_BUFFER, m_readbacks[i]);
+    glBufferData(GL_COPY_WRITE_BUFFER, sizeof(zero), &zero, GL_STREAM_READ);
+  }
+
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.TrackGpu(GpuResourceKind::Program, m_program, 0, 0, "GpuCuller");
+  tracker.TrackGpu(GpuResourceKind::Buffer, m_objectBuffer, 0,
+                   GL_SHADER_STORAGE_BUFFER, "GpuCuller:objects");
+  tracker.TrackGpu(GpuResourceKind::Buffer, m_meshBuffer, 0,
+                   GL_SHADER_STORAGE_BUFFER, "GpuCuller:meshes");
+  tracker.TrackGpu(GpuResourceKind::Buffer, m_commandBuffer, 0,
+                   GL_DRAW_INDIRECT_BUFFER, "GpuCuller:commands");
+  tracker.TrackGpu(GpuResourceKind::Buffer, m_counterBuffer, sizeof(zero),
+                   GL_SHADER_STORAGE_BUFFER, "GpuCuller:counter");
+  tracker.TrackGpu(GpuResourceKind::Buffer, m_indexBuffer, 0, GL_ARRAY_BUFFER,
+                   "GpuCuller:indices");
+  for (int i = 0; i < kReadbacks; i++) {
+    tracker.TrackGpu(GpuResourceKind::Buffer, m_readbacks[i], sizeof(zero),
+                     GL_COPY_WRITE_BUFFER, "GpuCuller:readback");
+  }
+  // Everything added before Create() goes up with the first Cull()
+  m_capacity = 0;
+  m_meshesDirty = true;
+  m_stats = GpuCullStats();
+  return true;
+}
+
+void GpuCuller::Release() {
+  if (!IsCreated()) {
+    return;
+  }
+  for (int i = 0; i < kReadbacks; i++) {
+    if (m_fences[i] != nullptr) {
+      glDeleteSync(m_fences[i]);
+      m_fences[i] = nullptr;
+    }
+  }
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.UntrackGpu(GpuResourceKind::Program, m_program);
+  GLuint buffers[5 + kReadbacks] = {m_objectBuffer, m_meshBuffer,
+                                    m_commandBuffer, m_counterBuffer,
+                                    m_indexBuffer};
+  std::copy(m_readbacks, m_readbacks + kReadbacks, buffers + 5);
+  for (GLuint buffer : buffers) {
+    tracker.UntrackGpu(GpuResourceKind::Buffer, buffer);
+  }
+  glDeleteProgram(m_program);
+  glDeleteBuffers(5 + kReadbacks, buffers);
+  m_program = m_objectBuffer = m_meshBuffer = m_commandBuffer = 0;
+  m_counterBuffer = m_indexBuffer = 0;
+  std::fill(m_readbacks, m_readbacks + kReadbacks, 0u);
+  m_capacity = 0;
+  m_culled = 0;
+}
+
+// ============================== Objects ==================================== //
+uint32_t GpuCuller::AddMesh(const GpuMesh &mesh) {
+  m_meshes.push_back(mesh);
+  m_meshesDirty = true;
+  return static_cast<uint32_t>(m_meshes.size() - 1);
+}
+
+uint32_t GpuCuller::AddObject(uint32_t mesh, const glm::mat4 &model) {
+  m_objects.push_back(GpuObject());
+  m_objects.back().mesh = glm::uvec4(mesh, 0u, 0u, 0u);
+  uint32_t object = static_cast<uint32_t>(m_objects.size() - 1);
+  SetTransform(object, model);
+  return object;
+}
+
+void GpuCuller::SetTransform(uint32_t object, const glm::mat4 &model) {
+  GpuObject &target = m_objects[object];
+  const GpuMesh &mesh = m_meshes[target.mesh.x];
+  target.model = model;
+  // The sphere grows with the longest axis, so it still holds everything
+  // when the scale is not uniform
+  float scale = std::sqrt(std::max(
+      {glm::dot(glm::vec3(model[0]), glm::vec3(model[0])),
+       glm::dot(glm::vec3(model[1]), glm::vec3(model[1])),
+       glm::dot(glm::vec3(model[2]), glm::vec3(model[2]))}));
+  target.sphere = glm::vec4(glm::vec3(model * glm::vec4(mesh.center, 1.0f)),
+                            mesh.radius * scale);
+  if (m_dirtyBegin == m_dirtyEnd) {
+    m_dirtyBegin = object;
+    m_dirtyEnd = object + 1;
+  } else {
+    m_dirtyBegin = std::min(m_dirtyBegin, object);
+    m_dirtyEnd = std::max(m_dirtyEnd, object + 1);
+  }
+}
+
+void GpuCuller::Clear() {
+  m_meshes.clear();
+  m_objects.clear();
+  m_dirtyBegin = m_dirtyEnd = 0;
+  m_meshesDirty = true;
+  m_culled = 0;
+}
+
+// ============================== Frame ====================================== //
+void GpuCuller::Upload() {
+  GLState &state = GLState::Instance();
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  m_stats.uploadedBytes = 0;
+  uint32_t count = GetObjectCount();
+  if (count > m_capacity) {
+    // Grow everything that has a slot per object, and send all objects
+    m_capacity = std::max(count, 2 * m_capacity);
+    size_t objectBytes = size_t(m_capacity) * sizeof(GpuObject);
+    state.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, objectBytes, nullptr,
+                 GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, count * sizeof(GpuObject),
+                    m_objects.data());
+    m_stats.uploadedBytes += count * sizeof(GpuObject);
+    state.BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, size_t(m_capacity) * kCommandBytes,
+                 nullptr, GL_DYNAMIC_DRAW);
+    std::vector<GLuint> indices(m_capacity);
+    for (uint32_t i = 0; i < m_capacity; i++) {
+      indices[i] = i;
+    }
+    state.BindBuffer(GL_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+                 indices.data(), GL_STATIC_DRAW);
+    tracker.TrackGpu(GpuResourceKind::Buffer, m_objectBuffer, objectBytes,
+                     GL_SHADER_STORAGE_BUFFER, "GpuCuller:objects");
+    tracker.TrackGpu(GpuResourceKind::Buffer, m_commandBuffer,
+                     size_t(m_capacity) * kCommandBytes,
+                     GL_DRAW_INDIRECT_BUFFER, "GpuCuller:commands");
+    tracker.TrackGpu(GpuResourceKind::Buffer, m_indexBuffer,
+                     indices.size() * sizeof(GLuint), GL_ARRAY_BUFFER,
+                     "GpuCuller:indices");
+  } else if (m_dirtyBegin < m_dirtyEnd && m_dirtyBegin < count) {
+    // Only the objects that moved
+    uint32_t end = std::min(m_dirtyEnd, count);
+    state.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+                    m_dirtyBegin * sizeof(GpuObject),
+                    (end - m_dirtyBegin) * sizeof(GpuObject),
+                    m_objects.data() + m_dirtyBegin);
+    m_stats.uploadedBytes += (end - m_dirtyBegin) * sizeof(GpuObject);
+  }
+  m_dirtyBegin = m_dirtyEnd = 0;
+
+  if (m_meshesDirty && !m_meshes.empty()) {
+    std::vector<glm::uvec4> meshes(m_meshes.size());
+    for (size_t i = 0; i < m_meshes.size(); i++) {
+      meshes[i] = glm::uvec4(m_meshes[i].indexCount, m_meshes[i].firstIndex,
+                             static_cast<GLuint>(m_meshes[i].baseVertex), 0u);
+    }
+    size_t bytes = meshes.size() * sizeof(glm::uvec4);
+    state.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_meshBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, meshes.data(),
+                 GL_STATIC_DRAW);
+    m_stats.uploadedBytes += bytes;
+    tracker.TrackGpu(GpuResourceKind::Buffer, m_meshBuffer, bytes,
+                     GL_SHADER_STORAGE_BUFFER, "GpuCuller:meshes");
+  }
+  m_meshesDirty = false;
+  if (m_stats.uploadedBytes > 0) {
+    m_stats.totalUploads++;
+  }
+}
+
+void GpuCuller::CollectCounts() {
+  // Oldest first, so the newest count that is ready wins
+  for (int n = 0; n < kReadbacks; n++) {
+    int i = (m_nextReadback + n) % kReadbacks;
+    if (m_fences[i] == nullptr) {
+      continue;
+    }
+    GLenum status = glClientWaitSync(m_fences[i], 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      continue;
+    }
+    glDeleteSync(m_fences[i]);
+    m_fences[i] = nullptr;
+    GLuint drawn = 0;
+    GLState::Instance().BindBuffer(GL_COPY_READ_BUFFER, m_readbacks[i]);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(drawn), &drawn);
+    m_stats.drawn = drawn;
+  }
+}
+
+void GpuCuller::Cull(const glm::mat4 &viewProjection) {
+  m_culled = 0;
+  m_stats.objects = GetObjectCount();
+  if (!IsCreated() || m_objects.empty()) {
+    return;
+  }
+  Upload();
+  GLState &state = GLState::Instance();
+  const GLuint zero = 0;
+  state.BindBuffer(GL_SHADER_STORAGE_BUFFER, m_counterBuffer);
+  glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+  if (m_drawCount == nullptr) {
+    // Every slot is drawn; the ones nobody writes must draw nothing
+    state.BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    m_clearBufferData(GL_DRAW_INDIRECT_BUFFER, GL_R32UI, GL_RED_INTEGER,
+                      GL_UNSIGNED_INT, &zero);
+  }
+
+  Frustum frustum(viewProjection);
+  glm::vec4 planes[Frustum::PlaneCount];
+  for (int i = 0; i < Frustum::PlaneCount; i++) {
+    planes[i] = frustum.GetPlane(static_cast<Frustum::Plane>(i));
+  }
+  state.UseProgram(m_program);
+  glUniform4fv(m_planesLocation, Frustum::PlaneCount, &planes[0][0]);
+  m_culled = GetObjectCount();
+  glUniform1ui(m_countLocation, m_culled);
+  state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, kGpuObjectBinding,
+                       m_objectBuffer);
+  state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, kMeshBinding, m_meshBuffer);
+  state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, kCommandBinding,
+                       m_commandBuffer);
+  state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, kCounterBinding,
+                       m_counterBuffer);
+  m_dispatchCompute((m_culled + kGroupSize - 1) / kGroupSize, 1, 1);
+  // The commands and the count are read by the draw and by the copy below
+  m_memoryBarrier(GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+  // Keep the count for the statistics without waiting for it: copy it now,
+  // read the copy once its fence has passed
+  CollectCounts();
+  if (m_fences[m_nextReadback] == nullptr) {
+    state.BindBuffer(GL_COPY_READ_BUFFER, m_counterBuffer);
+    state.BindBuffer(GL_COPY_WRITE_BUFFER, m_readbacks[m_nextReadback]);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        sizeof(GLuint));
+    m_fences[m_nextReadback] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_nextReadback = (m_nextReadback + 1) % kReadbacks;
+  }
+}
+
+void GpuCuller::Draw(GLuint vertexArray, GLuint objectIndexLocation) {
+  if (!IsCreated() || m_culled == 0) {
+    return;
+  }
+  GLState &state = GLState::Instance();
+  state.BindVertexArray(vertexArray);
+  // baseInstance + instance = the object
+  state.BindBuffer(GL_ARRAY_BUFFER, m_indexBuffer);
+  glEnableVertexAttribArray(objectIndexLocation);
+  glVertexAttribIPointer(objectIndexLocation, 1, GL_UNSIGNED_INT, 0, nullptr);
+  glVertexAttribDivisor(objectIndexLocation, 1);
+  state.BindBufferBase(GL_SHADER_STORAGE_BUFFER, kGpuObjectBinding,
+                       m_objectBuffer);
+  state.BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+  if (m_drawCount != nullptr) {
+    state.BindBuffer(GL_PARAMETER_BUFFER, m_counterBuffer);
+    m_drawCount(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, 0,
+                static_cast<GLsizei>(m_culled), kCommandBytes);
+  } else {
+    m_multiDraw(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr,
+                static_cast<GLsizei>(m_culled), kCommandBytes);
+  }
+  // The CPU does not know what was drawn; the count it read last is close
+  uint32_t drawn = std::min(m_stats.drawn, m_culled);
+  size_t triangles = 0;
+  if (drawn > 0) {
+    size_t indices = 0;
+    for (const GpuMesh &mesh : m_meshes) {
+      indices += mesh.indexCount;
+    }
+    triangles = indices / 3 * drawn / m_meshes.size();
+  }
+  FrameStats::Instance().CountDraws(1, triangles);
+}
+
+uint32_t GpuCuller::ReadDrawnCount() {
+  if (!IsCreated()) {
+    return 0;
+  }
+  GLuint drawn = 0;
+  GLState::Instance().BindBuffer(GL_COPY_READ_BUFFER, m_counterBuffer);
+  glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(drawn), &drawn);
+  return drawn;
+}
@@ -0,0 +1,73 @@
+#include "GpuTimer.hpp"
+#include "ResourceTracker.hpp"
+
+GpuTimer::~GpuTimer() { Release(); }
+
+void GpuTimer::Create() {
+  if (IsCreated()) {
+    return;
+  }
+  glGenQueries(kQueries, m_queries);
+  for (int i = 0; i < kQueries; i++) {
+    m_pending[i] = false;
+    ResourceTracker::Instance().TrackGpu(GpuResourceKind::Query, m_queries[i],
+                                         0, GL_TIME_ELAPSED, "GpuTimer");
+  }
+  m_next = 0;
+  m_running = -1;
+}
+
+void GpuTimer::Release() {
+  if (!IsCreated()) {
+    return;
+  }
+  for (int i = 0; i < kQueries; i++) {
+    ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Query,
+                                           m_queries[i]);
+  }
+  glDeleteQueries(kQueries, m_queries);
+  for (int i = 0; i < kQueries; i++) {
+    m_queries[i] = 0;
+    m_pending[i] = false;
+  }
+}
+
+void GpuTimer::Begin() {
+  if (!IsCreated() || m_pending[m_next]) {
+    return;
+  }
+  m_running = m_next;
+  glBeginQuery(GL_TIME_ELAPSED, m_queries[m_running]);
+}
+
+void GpuTimer::End() {
+  if (m_running < 0) {
+    return;
+  }
+  glEndQuery(GL_TIME_ELAPSED);
+  m_pending[m_running] = true;
+  m_next = (m_running + 1) % kQueries;
+  m_running = -1;
+}
+
+bool GpuTimer::Poll(float &milliseconds) {
+  bool found = false;
+  // Oldest first, so the newest finished result is the one returned
+  for (int k = 0; k < kQueries; k++) {
+    int i = (m_next + k) % kQueries;
+    if (!m_pending[i]) {
+      continue;
+    }
+    GLint available = 0;
+    glGetQueryObjectiv(m_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) {
+      continue;
+    }
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &nanoseconds);
+    m_pending[i] = false;
+    milliseconds = static_cast<float>(nanoseconds) * 1e-6f;
+    found = true;
+  }
+  return found;
+}
@@ -0,0 +1,279 @@
+#include "GpuUploader.hpp"
+#include "GLState.hpp"
+
+#include <chrono>
+
+// How long Finish() blocks on a fence before it checks again
+static const GLuint64 kFenceWaitNs = 1000000000ull;
+
+GpuUploader::GpuUploader() {}
+
+GpuUploader::~GpuUploader() { Stop(); }
+
+bool GpuUploader::Start(const SharedContext &context) {
+  if (m_thread.joinable()) {
+    return m_threaded;
+  }
+  std::promise<bool> started;
+  std::future<bool> current = started.get_future();
+  m_stop = false;
+  m_thread =
+      std::thread(&GpuUploader::ThreadMain, this, context, std::move(started));
+  m_threaded = current.get();
+  if (!m_threaded) {
+    m_thread.join();
+  }
+  return m_threaded;
+}
+
+void GpuUploader::Stop() {
+  Finish();
+  if (!m_thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  m_thread.join();
+  m_threaded = false;
+}
+
+UploadTicket GpuUploader::UploadBuffers(std::vector<BufferUpload> buffers,
+                                        UploadCallback ready) {
+  std::unique_ptr<Job> job(new Job());
+  job->buffers = std::move(buffers);
+  job->ready = std::move(ready);
+  return Queue(std::move(job));
+}
+
+UploadTicket GpuUploader::UploadTexture(TextureUpload texture,
+                                        UploadCallback ready) {
+  std::unique_ptr<Job> job(new Job());
+  job->isTexture = true;
+  job->texture = std::move(texture);
+  job->ready = std::move(ready);
+  return Queue(std::move(job));
+}
+
+UploadTicket GpuUploader::Queue(std::unique_ptr<Job> job) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  UploadTicket ticket = m_nextTicket++;
+  job->ticket = ticket;
+  if (!m_threaded) {
+    // Same context, so no fence: the objects are usable right away
+    lock.unlock();
+    Execute(*job, true);
+    lock.lock();
+    m_done.push_back(std::move(job));
+    return ticket;
+  }
+  m_queued.push_back(std::move(job));
+  lock.unlock();
+  m_wake.notify_one();
+  return ticket;
+}
+
+void GpuUploader::Cancel(UploadTicket ticket) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  bool pending = ticket != 0 && ticket == m_busy;
+  for (const std::unique_ptr<Job> &job : m_queued) {
+    pending = pending || job->ticket == ticket;
+  }
+  for (const std::unique_ptr<Job> &job : m_done) {
+    pending = pending || job->ticket == ticket;
+  }
+  if (pending) {
+    m_canceled.insert(ticket);
+  }
+}
+
+void GpuUploader::Execute(Job &job, bool renderThread) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  GLState &state = GLState::Instance();
+  size_t bytes = 0;
+  if (!job.isTexture) {
+    // Any buffer can be bound to any target later; the copy target is
+    // free of side effects (the element array one belongs to a VAO)
+    size_t count = job.buffers.size();
+    job.result.buffers.resize(count);
+    job.result.bufferBytes.resize(count);
+    if (count > 0) {
+      glGenBuffers(static_cast<GLsizei>(count), job.result.buffers.data());
+    }
+    for (size_t i = 0; i < count; i++) {
+      std::vector<uint8_t> &data = job.buffers[i].data;
+      if (renderThread) {
+        state.BindBuffer(GL_COPY_WRITE_BUFFER, job.result.buffers[i]);
+      } else {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, job.result.buffers[i]);
+      }
+      glBufferData(GL_COPY_WRITE_BUFFER, data.size(),
+                   data.empty() ? nullptr : data.data(), job.buffers[i].usage);
+      job.result.bufferBytes[i] = data.size();
+      bytes += data.size();
+      std::vector<uint8_t>().swap(data);
+    }
+    if (renderThread) {
+      state.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    } else {
+      glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+  } else {
+    TextureUpload &texture = job.texture;
+    glGenTextures(1, &job.result.texture);
+    if (renderThread) {
+      state.BindTexture(0, GL_TEXTURE_2D, job.result.texture);
+    } else {
+      glBindTexture(GL_TEXTURE_2D, job.result.texture);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, texture.minFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, texture.magFilter);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, texture.wrap);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, texture.wrap);
+    const uint8_t *pixels = texture.external;
+    bytes = texture.externalBytes;
+    if (pixels == nullptr) {
+      pixels = texture.pixels.empty() ? nullptr : texture.pixels.data();
+      bytes = texture.pixels.size();
+    }
+    glTexImage2D(GL_TEXTURE_2D, 0, texture.internalFormat, texture.width,
+                 texture.height, 0, texture.format, texture.type, pixels);
+    if (texture.mipmaps) {
+      glGenerateMipmap(GL_TEXTURE_2D);
+    }
+    std::vector<uint8_t>().swap(texture.pixels);
+    if (!renderThread) {
+      glBindTexture(GL_TEXTURE_2D, 0);
+    }
+  }
+  if (!renderThread) {
+    // The flush makes the fence (and the work before it) reach the GPU, so
+    // the render thread's context can see it signal
+    job.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+  }
+  std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_stats.bytes += bytes;
+  m_stats.uploadMs += elapsed.count();
+}
+
+void GpuUploader::ThreadMain(SharedContext context,
+                             std::promise<bool> started) {
+  bool current = context.makeCurrent && context.makeCurrent();
+  started.set_value(current);
+  if (!current) {
+    return;
+  }
+  for (;;) {
+    std::unique_ptr<Job> job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [this] { return m_stop || !m_queued.empty(); });
+      if (m_queued.empty()) {
+        break;
+      }
+      job = std::move(m_queued.front());
+      m_queued.pop_front();
+      if (m_canceled.erase(job->ticket) > 0) {
+        // Nothing was created yet
+        m_stats.jobs++;
+        m_uploaded.notify_all();
+        continue;
+      }
+      m_busy = job->ticket;
+    }
+    Execute(*job, false);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_done.push_back(std::move(job));
+      m_busy = 0;
+    }
+    m_uploaded.notify_all();
+  }
+  if (context.doneCurrent) {
+    context.doneCurrent();
+  }
+}
+
+size_t GpuUploader::HandOver(bool wait) {
+  size_t handed = 0;
+  for (;;) {
+    // Only this thread removes jobs from m_done, so the front stays put
+    Job *front = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_done.empty()) {
+        break;
+      }
+      front = m_done.front().get();
+    }
+    if (front->fence != nullptr) {
+      GLenum status = glClientWaitSync(front->fence, 0, 0);
+      while (wait && status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(front->fence, 0, kFenceWaitNs);
+      }
+      if (status == GL_TIMEOUT_EXPIRED) {
+        // Jobs finish in order, so the rest are not ready either
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.notReadyPolls++;
+        break;
+      }
+      glDeleteSync(front->fence);
+      front->fence = nullptr;
+    }
+    std::unique_ptr<Job> job;
+    bool canceled = false;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      job = std::move(m_done.front());
+      m_done.pop_front();
+      canceled = m_canceled.erase(job->ticket) > 0;
+      m_stats.jobs++;
+    }
+    UploadResult &result = job->result;
+    if (canceled) {
+      // Never tracked, but the render thread may have had them bound
+      GLState &state = GLState::Instance();
+      for (GLuint buffer : result.buffers) {
+        state.OnDeleted(GpuResourceKind::Buffer, buffer);
+      }
+      if (!result.buffers.empty()) {
+        glDeleteBuffers(static_cast<GLsizei>(result.buffers.size()),
+                        result.buffers.data());
+      }
+      if (result.texture != 0) {
+        state.OnDeleted(GpuResourceKind::Texture, result.texture);
+        glDeleteTextures(1, &result.texture);
+      }
+    } else if (job->ready) {
+      job->ready(result);
+    }
+    handed++;
+  }
+  return handed;
+}
+
+size_t GpuUploader::Poll() { return HandOver(false); }
+
+void GpuUploader::Finish() {
+  if (m_threaded) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_uploaded.wait(lock, [this] { return m_queued.empty() && m_busy == 0; });
+  }
+  HandOver(true);
+}
+
+size_t GpuUploader::GetPending() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_queued.size() + m_done.size() + (m_busy != 0 ? 1 : 0);
+}
+
+UploaderStats GpuUploader::GetStats() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_stats;
+}
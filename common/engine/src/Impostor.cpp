@@ -0,0 +1,407 @@
+#include "Impostor.hpp"
+#include "FrameStats.hpp"
+#include "GLState.hpp"
+#include "ResourceTracker.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// ============================== Mapping ==================================== //
+static float SignNotZero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+glm::vec2 OctahedralEncode(const glm::vec3 &direction) {
+  glm::vec3 n = direction / (std::fabs(direction.x) + std::fabs(direction.y) +
+                             std::fabs(direction.z));
+  glm::vec2 p(n.x, n.z);
+  if (n.y < 0.0f) {
+    // Fold the lower hemisphere over the diamond's edges
+    p = glm::vec2((1.0f - std::fabs(n.z)) * SignNotZero(n.x),
+                  (1.0f - std::fabs(n.x)) * SignNotZero(n.z));
+  }
+  return p * 0.5f + 0.5f;
+}
+
+glm::vec3 OctahedralDecode(const glm::vec2 &uv) {
+  glm::vec2 p = uv * 2.0f - 1.0f;
+  glm::vec3 n(p.x, 1.0f - std::fabs(p.x) - std::fabs(p.y), p.y);
+  if (n.y < 0.0f) {
+    n.x = (1.0f - std::fabs(p.y)) * SignNotZero(p.x);
+    n.z = (1.0f - std::fabs(p.x)) * SignNotZero(p.y);
+  }
+  return glm::normalize(n);
+}
+
+glm::vec3 ImpostorFrameDirection(int x, int y, int framesPerSide) {
+  float n = static_cast<float>(framesPerSide);
+  return OctahedralDecode(glm::vec2((x + 0.5f) / n, (y + 0.5f) / n));
+}
+
+glm::ivec2 ImpostorNearestFrame(const glm::vec3 &direction,
+                                int framesPerSide) {
+  glm::vec2 uv = OctahedralEncode(direction) * float(framesPerSide);
+  return glm::clamp(glm::ivec2(glm::floor(uv)), glm::ivec2(0),
+                    glm::ivec2(framesPerSide - 1));
+}
+
+void ImpostorFrameBasis(const glm::vec3 &direction, glm::vec3 &right,
+                        glm::vec3 &up) {
+  // Straight up or down there is no "up", pick another reference
+  glm::vec3 reference = std::fabs(direction.y) > 0.999f
+                            ? glm::vec3(0.0f, 0.0f, 1.0f)
+                            : glm::vec3(0.0f, 1.0f, 0.0f);
+  right = glm::normalize(glm::cross(reference, direction));
+  up = glm::cross(direction, right);
+}
+
+// ============================== Selection ================================== //
+float ProjectedDiameter(float radius, float distance, float fovY,
+                        float screenHeight) {
+  if (distance <= radius) {
+    return screenHeight; // The camera is inside (or touching) the sphere
+  }
+  return radius / (distance * std::tan(fovY * 0.5f)) * screenHeight;
+}
+
+float ImpostorFade(float pixels, const ImpostorLodSettings &settings) {
+  if (pixels >= settings.thresholdPixels) {
+    return 0.0f;
+  }
+  if (settings.fadePixels <= 0.0f) {
+    return 1.0f;
+  }
+  return std::min(1.0f,
+                  (settings.thresholdPixels - pixels) / settings.fadePixels);
+}
+
+void SelectImpostors(const ImpostorInstance *instances, size_t count,
+                     const glm::vec3 &center, float radius,
+                     const glm::vec3 &cameraPosition, float fovY,
+                     float screenHeight, const ImpostorLodSettings &settings,
+                     ImpostorSelection &out) {
+  out.Clear();
+  for (size_t i = 0; i < count; i++) {
+    const ImpostorInstance &instance = instances[i];
+    glm::vec3 worldCenter = instance.position + center * instance.scale;
+    float pixels =
+        ProjectedDiameter(radius * instance.scale,
+                          glm::length(worldCenter - cameraPosition), fovY,
+                          screenHeight);
+    float fade = ImpostorFade(pixels, settings);
+    if (fade < 1.0f) {
+      out.meshes.push_back(static_cast<uint32_t>(i));
+      out.meshFades.push_back(fade);
+    }
+    if (fade > 0.0f) {
+      out.impostors.push_back(instance);
+      out.impostors.back().fade = fade;
+    }
+  }
+}
+
+// ============================== Atlas ====================================== //
+ImpostorAtlas::~ImpostorAtlas() { Release(); }
+
+bool ImpostorAtlas::Bake(const glm::vec3 &center, float radius,
+                         int framesPerSide, int frameSize,
+                         const ImpostorDrawFunction &draw) {
+  Release();
+  int size = framesPerSide * frameSize;
+  GLint oldFramebuffer = 0;
+  GLint oldViewport[4];
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &oldFramebuffer);
+  glGetIntegerv(GL_VIEWPORT, oldViewport);
+
+  GLState &state = GLState::Instance();
+  glGenTextures(1, &m_texture);
+  state.BindTexture(0, GL_TEXTURE_2D, m_texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA,
+               GL_UNSIGNED_BYTE, nullptr);
+  GLuint depth = 0, fbo = 0;
+  glGenRenderbuffers(1, &depth);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, size, size);
+  glGenFramebuffers(1, &fbo);
+  state.BindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         m_texture, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depth);
+  bool complete =
+      glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  if (complete) {
+    state.Viewport(0, 0, size, size);
+    state.ClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // The sphere exactly fills a tile
+    glm::mat4 projection =
+        glm::ortho(-radius, radius, -radius, radius, 0.5f * radius,
+                   3.5f * radius);
+    for (int y = 0; y < framesPerSide; y++) {
+      for (int x = 0; x < framesPerSide; x++) {
+        glm::vec3 direction = ImpostorFrameDirection(x, y, framesPerSide);
+        glm::vec3 right, up;
+        ImpostorFrameBasis(direction, right, up);
+        glm::mat4 view =
+            glm::lookAt(center + direction * (2.0f * radius), center, up);
+        state.Viewport(x * frameSize, y * frameSize, frameSize, frameSize);
+        draw(view, projection);
+      }
+    }
+  }
+  state.BindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(oldFramebuffer));
+  state.Viewport(oldViewport[0], oldViewport[1], oldViewport[2],
+                 oldViewport[3]);
+  // Only the texture is kept
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(1, &depth);
+  if (!complete) {
+    glDeleteTextures(1, &m_texture);
+    m_texture = 0;
+    return false;
+  }
+
+  // A few mip levels for distant impostors; smaller ones would mix
+  // neighbouring tiles
+  int levels = 0;
+  for (int s = frameSize; s > 8 && levels < 4; s /= 2) {
+    levels++;
+  }
+  // The draw function may have bound other textures
+  state.BindTexture(0, GL_TEXTURE_2D, m_texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels);
+  glGenerateMipmap(GL_TEXTURE_2D);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  m_framesPerSide = framesPerSide;
+  m_center = center;
+  m_radius = radius;
+  ResourceTracker::Instance().TrackGpu(
+      GpuResourceKind::Texture, m_texture,
+      ResourceTracker::TextureBytes(size, size, 4, true), GL_RGBA8,
+      "Impostor:atlas");
+  return true;
+}
+
+void ImpostorAtlas::Release() {
+  if (m_texture == 0) {
+    return;
+  }
+  ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Texture, m_texture);
+  glDeleteTextures(1, &m_texture);
+  m_texture = 0;
+  m_framesPerSide = 0;
+}
+
+// ============================== Renderer =================================== //
+// Must match OctahedralEncode() and ImpostorFrameBasis()
+static const char *kVertexShader = R"(#version 330 core
+layout(location = 0) in vec2 a_corner;
+layout(location = 1) in vec4 a_instance;
+layout(location = 2) in float a_fade;
+uniform mat4 u_ViewProjection;
+uniform vec3 u_CameraPosition;
+uniform vec4 u_Sphere;
+uniform float u_FramesPerSide;
+out vec2 v_texCoord;
+flat out float v_fade;
+vec2 Encode(vec3 d) {
+  vec3 n = d / (abs(d.x) + abs(d.y) + abs(d.z));
+  vec2 p = n.xz;
+  if (n.y < 0.0) {
+    p = (1.0 - abs(n.zx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0,
+                                 n.z >= 0.0 ? 1.0 : -1.0);
+  }
+  return p * 0.5 + 0.5;
+}
+vec3 Decode(vec2 uv) {
+  vec2 p = uv * 2.0 - 1.0;
+  vec3 n = vec3(p.x, 1.0 - abs(p.x) - abs(p.y), p.y);
+  if (n.y < 0.0) {
+    n.xz = (1.0 - abs(p.yx)) * vec2(p.x >= 0.0 ? 1.0 : -1.0,
+                                    p.y >= 0.0 ? 1.0 : -1.0);
+  }
+  return normalize(n);
+}
+void main() {
+  float scale = a_instance.w;
+  vec3 center = a_instance.xyz + u_Sphere.xyz * scale;
+  vec2 frame = clamp(floor(Encode(normalize(u_CameraPosition - center)) *
+                           u_FramesPerSide),
+                     0.0, u_FramesPerSide - 1.0);
+  vec3 direction = Decode((frame + 0.5) / u_FramesPerSide);
+  vec3 reference = abs(direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0)
+                                            : vec3(0.0, 1.0, 0.0);
+  vec3 right = normalize(cross(reference, direction));
+  vec3 up = cross(direction, right);
+  vec3 position = center + (right * a_corner.x + up * a_corner.y) *
+                               (u_Sphere.w * scale);
+  gl_Position = u_ViewProjection * vec4(position, 1.0);
+  v_texCoord = (frame + a_corner * 0.5 + 0.5) / u_FramesPerSide;
+  v_fade = a_fade;
+}
+)";
+
+// The mesh keeps the pixels where Dither() >= fade (part1's frag.glsl)
+static const char *kFragmentShader = R"(#version 330 core
+in vec2 v_texCoord;
+flat in float v_fade;
+uniform sampler2D u_Atlas;
+out vec4 color;
+float Dither(vec2 p) {
+  return fract(52.9829189 * fract(dot(p, vec2(0.06711056, 0.00583715))));
+}
+void main() {
+  vec4 texel = texture(u_Atlas, v_texCoord);
+  if (texel.a < 0.5 || Dither(gl_FragCoord.xy) >= v_fade) {
+    discard;
+  }
+  color = vec4(texel.rgb / texel.a, 1.0);
+}
+)";
+
+static GLuint CompileStage(GLenum type, const char *source) {
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+  GLint ok = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+  if (!ok) {
+    char log[512];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    std::cerr << "ImpostorRenderer: shader error: " << log << std::endl;
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+ImpostorRenderer::~ImpostorRenderer() { Release(); }
+
+bool ImpostorRenderer::Create() {
+  if (IsCreated()) {
+    return true;
+  }
+  GLuint vertex = CompileStage(GL_VERTEX_SHADER, kVertexShader);
+  GLuint fragment = CompileStage(GL_FRAGMENT_SHADER, kFragmentShader);
+  if (vertex == 0 || fragment == 0) {
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    return false;
+  }
+  m_program = glCreateProgram();
+  glAttachShader(m_program, vertex);
+  glAttachShader(m_program, fragment);
+  glLinkProgram(m_program);
+  glDeleteShader(vertex);
+  glDeleteShader(fragment);
+  GLint linked = GL_FALSE;
+  glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    std::cerr << "ImpostorRenderer: could not link the program" << std::endl;
+    glDeleteProgram(m_program);
+    m_program = 0;
+    return false;
+  }
+  m_viewProjectionLocation =
+      glGetUniformLocation(m_program, "u_ViewProjection");
+  m_cameraLocation = glGetUniformLocation(m_program, "u_CameraPosition");
+  m_sphereLocation = glGetUniformLocation(m_program, "u_Sphere");
+  m_framesLocation = glGetUniformLocation(m_program, "u_FramesPerSide");
+  GLState &state = GLState::Instance();
+  state.UseProgram(m_program);
+  glUniform1i(glGetUniformLocation(m_program, "u_Atlas"), 0);
+
+  // A triangle strip quad shared by every instance
+  const float corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_cornerVbo);
+  glGenBuffers(1, &m_instanceVbo);
+  state.BindVertexArray(m_vao);
+  state.BindBuffer(GL_ARRAY_BUFFER, m_cornerVbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), nullptr);
+  state.BindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance),
+                        reinterpret_cast<void *>(
+                            offsetof(ImpostorInstance, position)));
+  glVertexAttribDivisor(1, 1);
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(ImpostorInstance),
+                        reinterpret_cast<void *>(
+                            offsetof(ImpostorInstance, fade)));
+  glVertexAttribDivisor(2, 1);
+
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.TrackGpu(GpuResourceKind::Program, m_program, 0, 0, "Impostor");
+  tracker.TrackGpu(GpuResourceKind::VertexArray, m_vao, 0, 0, "Impostor");
+  tracker.TrackGpu(GpuResourceKind::Buffer, m_cornerVbo, sizeof(corners),
+                   GL_ARRAY_BUFFER, "Impostor:corners");
+  tracker.TrackGpu(GpuResourceKind::Buffer, m_instanceVbo, 0, GL_ARRAY_BUFFER,
+                   "Impostor:instances");
+  return true;
+}
+
+void ImpostorRenderer::Release() {
+  if (!IsCreated()) {
+    return;
+  }
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.UntrackGpu(GpuResourceKind::Program, m_program);
+  tracker.UntrackGpu(GpuResourceKind::VertexArray, m_vao);
+  tracker.UntrackGpu(GpuResourceKind::Buffer, m_cornerVbo);
+  tracker.UntrackGpu(GpuResourceKind::Buffer, m_instanceVbo);
+  glDeleteProgram(m_program);
+  glDeleteVertexArrays(1, &m_vao);
+  glDeleteBuffers(1, &m_cornerVbo);
+  glDeleteBuffers(1, &m_instanceVbo);
+  m_program = m_vao = m_cornerVbo = m_instanceVbo = 0;
+  m_instanceBytes = 0;
+}
+
+void ImpostorRenderer::Draw(const ImpostorAtlas &atlas,
+                            const std::vector<ImpostorInstance> &instances,
+                            const glm::mat4 &view,
+                            const glm::mat4 &projection,
+                            const glm::vec3 &cameraPosition) {
+  if (!IsCreated() || !atlas.IsBaked() || instances.empty()) {
+    return;
+  }
+  GLState &state = GLState::Instance();
+  state.UseProgram(m_program);
+  glm::mat4 viewProjection = projection * view;
+  glUniformMatrix4fv(m_viewProjectionLocation, 1, GL_FALSE,
+                     &viewProjection[0][0]);
+  glUniform3f(m_cameraLocation, cameraPosition.x, cameraPosition.y,
+              cameraPosition.z);
+  const glm::vec3 &center = atlas.GetCenter();
+  glUniform4f(m_sphereLocation, center.x, center.y, center.z,
+              atlas.GetRadius());
+  glUniform1f(m_framesLocation, static_cast<float>(atlas.GetFramesPerSide()));
+  state.BindTexture(0, GL_TEXTURE_2D, atlas.GetTexture());
+  state.BindVertexArray(m_vao);
+
+  // Grow the buffer when needed; otherwise orphan last frame's storage so
+  // the upload never waits for the GPU
+  size_t bytes = instances.size() * sizeof(ImpostorInstance);
+  state.BindBuffer(GL_ARRAY_BUFFER, m_instanceVbo);
+  if (bytes > m_instanceBytes) {
+    m_instanceBytes = std::max(bytes, 2 * m_instanceBytes);
+    ResourceTracker::Instance().TrackGpu(
+        GpuResourceKind::Buffer, m_instanceVbo, m_instanceBytes,
+        GL_ARRAY_BUFFER, "Impostor:instances");
+  }
+  glBufferData(GL_ARRAY_BUFFER, m_instanceBytes, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, instances.data());
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4,
+                        static_cast<GLsizei>(instances.size()));
+  FrameStats::Instance().CountDraw(2 * instances.size());
+}
@@ -0,0 +1,103 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static bool Fail(std::string *error, const std::string &message) {
+  if (error != nullptr) {
+    *error = message;
+  }
+  return false;
+}
+
+MappedFile::~MappedFile() { Close(); }
+
+bool MappedFile::Open(const std::string &path, std::string *error) {
+  Close();
+#ifndef _WIN32
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return Fail(error, "could not open " + path);
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size < 1) {
+    close(fd);
+    return Fail(error, path + " is empty");
+  }
+  size_t size = static_cast<size_t>(info.st_size);
+  void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file open
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return Fail(error, "could not map " + path);
+  }
+  m_data = static_cast<const uint8_t *>(mapping);
+  m_mapped = true;
+#else
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return Fail(error, "could not open " + path);
+  }
+  size_t size = static_cast<size_t>(file.tellg());
+  if (size < 1) {
+    return Fail(error, path + " is empty");
+  }
+  uint8_t *data = new uint8_t[size];
+  file.seekg(0);
+  file.read(reinterpret_cast<char *>(data), size);
+  if (!file) {
+    delete[] data;
+    return Fail(error, "could not read " + path);
+  }
+  m_data = data;
+  m_mapped = false;
+#endif
+  m_size = size;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (m_data != nullptr) {
+#ifndef _WIN32
+    if (m_mapped) {
+      munmap(const_cast<uint8_t *>(m_data), m_size);
+    }
+#endif
+    if (!m_mapped) {
+      delete[] m_data;
+    }
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_mapped = false;
+}
+
+void MappedFile::AdviseRandom() const {
+#ifndef _WIN32
+  if (m_mapped) {
+    madvise(const_cast<uint8_t *>(m_data), m_size, MADV_RANDOM);
+  }
+#endif
+}
+
+void MappedFile::Prefetch(const uint8_t *data, size_t size) const {
+#ifndef _WIN32
+  if (!m_mapped || data == nullptr || size == 0) {
+    return;
+  }
+  // madvise() wants a page aligned start
+  const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  uintptr_t begin = reinterpret_cast<uintptr_t>(data) & ~(page - 1);
+  uintptr_t end = reinterpret_cast<uintptr_t>(data) + size;
+  madvise(reinterpret_cast<void *>(begin), end - begin, MADV_WILLNEED);
+#else
+  (void)data;
+  (void)size;
+#endif
+}
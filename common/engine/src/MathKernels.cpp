@@ -0,0 +1,215 @@
+#include "MathKernels.hpp"
+
+#if ENGINE_MATH_SIMD && (GLM_ARCH & GLM_ARCH_SSE2_BIT)
+#include <emmintrin.h>
+#define MATH_KERNELS_SSE 1
+#else
+#define MATH_KERNELS_SSE 0
+#endif
+
+void PointsSoA::Resize(size_t count) {
+  x.resize(count);
+  y.resize(count);
+  z.resize(count);
+}
+
+void AabbSoA::Resize(size_t count) {
+  minX.resize(count);
+  minY.resize(count);
+  minZ.resize(count);
+  maxX.resize(count);
+  maxY.resize(count);
+  maxZ.resize(count);
+}
+
+// ================================ Scalar ================================= //
+// Same order of operations as glm's operator*: column by column,
+// ((a0 * b.x + a1 * b.y) + a2 * b.z) + a3 * b.w
+void MultiplyMat4BatchScalar(const glm::mat4 *lhs, const glm::mat4 *rhs,
+                             glm::mat4 *out, size_t count) {
+  for (size_t n = 0; n < count; n++) {
+    const glm::mat4 a = lhs[n];
+    const glm::mat4 b = rhs[n];
+    for (int c = 0; c < 4; c++) {
+      for (int r = 0; r < 4; r++) {
+        out[n][c][r] = a[0][r] * b[c][0] + a[1][r] * b[c][1] +
+                       a[2][r] * b[c][2] + a[3][r] * b[c][3];
+      }
+    }
+  }
+}
+
+// glm computes m * v as (m0 * x + m1 * y) + (m2 * z + m3 * w); with w = 1
+// the last product is m3 itself.
+static inline float TransformCoordinate(const glm::mat4 &m, int r, float x,
+                                        float y, float z) {
+  return (m[0][r] * x + m[1][r] * y) + (m[2][r] * z + m[3][r]);
+}
+
+void TransformPointsScalar(const glm::mat4 &m, const PointsSoA &in,
+                           PointsSoA &out) {
+  const size_t count = in.Size();
+  out.Resize(count);
+  for (size_t i = 0; i < count; i++) {
+    float x = in.x[i], y = in.y[i], z = in.z[i];
+    out.x[i] = TransformCoordinate(m, 0, x, y, z);
+    out.y[i] = TransformCoordinate(m, 1, x, y, z);
+    out.z[i] = TransformCoordinate(m, 2, x, y, z);
+  }
+}
+
+// Same results as _mm_min_ps / _mm_max_ps (which differ from std::min and
+// std::max for -0.0f and +0.0f)
+static inline float Min(float a, float b) { return a < b ? a : b; }
+static inline float Max(float a, float b) { return a > b ? a : b; }
+
+// One output axis r of one box: start from the translation and add the
+// smaller (larger) end of each scaled input axis.
+static inline void TransformInterval(const glm::mat4 &m, int r,
+                                     const float min[3], const float max[3],
+                                     float &outMin, float &outMax) {
+  float lo = m[3][r];
+  float hi = m[3][r];
+  for (int j = 0; j < 3; j++) {
+    float a = m[j][r] * min[j];
+    float b = m[j][r] * max[j];
+    lo += Min(a, b);
+    hi += Max(a, b);
+  }
+  outMin = lo;
+  outMax = hi;
+}
+
+static void TransformAabbRange(const glm::mat4 &m, const AabbSoA &in,
+                               AabbSoA &out, size_t begin, size_t end) {
+  for (size_t i = begin; i < end; i++) {
+    const float min[3] = {in.minX[i], in.minY[i], in.minZ[i]};
+    const float max[3] = {in.maxX[i], in.maxY[i], in.maxZ[i]};
+    TransformInterval(m, 0, min, max, out.minX[i], out.maxX[i]);
+    TransformInterval(m, 1, min, max, out.minY[i], out.maxY[i]);
+    TransformInterval(m, 2, min, max, out.minZ[i], out.maxZ[i]);
+  }
+}
+
+void TransformAabbsScalar(const glm::mat4 &m, const AabbSoA &in,
+                          AabbSoA &out) {
+  out.Resize(in.Size());
+  TransformAabbRange(m, in, out, 0, in.Size());
+}
+
+// ================================= SIMD ================================== //
+#if MATH_KERNELS_SSE
+
+void MultiplyMat4Batch(const glm::mat4 *lhs, const glm::mat4 *rhs,
+                       glm::mat4 *out, size_t count) {
+  for (size_t n = 0; n < count; n++) {
+    const float *a = &lhs[n][0][0];
+    const float *b = &rhs[n][0][0];
+    __m128 a0 = _mm_loadu_ps(a);
+    __m128 a1 = _mm_loadu_ps(a + 4);
+    __m128 a2 = _mm_loadu_ps(a + 8);
+    __m128 a3 = _mm_loadu_ps(a + 12);
+    // All of b is read before out is written, so out may alias rhs.
+    // Each column of b is loaded once and its elements broadcast with
+    // shuffles, which is cheaper than four scalar loads.
+    __m128 result[4];
+    for (int c = 0; c < 4; c++) {
+      __m128 column = _mm_loadu_ps(b + c * 4);
+      __m128 x = _mm_shuffle_ps(column, column, _MM_SHUFFLE(0, 0, 0, 0));
+      __m128 y = _mm_shuffle_ps(column, column, _MM_SHUFFLE(1, 1, 1, 1));
+      __m128 z = _mm_shuffle_ps(column, column, _MM_SHUFFLE(2, 2, 2, 2));
+      __m128 w = _mm_shuffle_ps(column, column, _MM_SHUFFLE(3, 3, 3, 3));
+      __m128 sum = _mm_mul_ps(a0, x);
+      sum = _mm_add_ps(sum, _mm_mul_ps(a1, y));
+      sum = _mm_add_ps(sum, _mm_mul_ps(a2, z));
+      sum = _mm_add_ps(sum, _mm_mul_ps(a3, w));
+      result[c] = sum;
+    }
+    float *o = &out[n][0][0];
+    for (int c = 0; c < 4; c++) {
+      _mm_storeu_ps(o + c * 4, result[c]);
+    }
+  }
+}
+
+// Four points per iteration, each coordinate loaded once; the rest goes
+// through the scalar code.
+void TransformPoints(const glm::mat4 &m, const PointsSoA &in,
+                     PointsSoA &out) {
+  const size_t count = in.Size();
+  out.Resize(count);
+  const size_t simdCount = count & ~size_t(3);
+  __m128 column[4][3];
+  for (int c = 0; c < 4; c++) {
+    for (int r = 0; r < 3; r++) {
+      column[c][r] = _mm_set1_ps(m[c][r]);
+    }
+  }
+  const float *inX = in.x.data(), *inY = in.y.data(), *inZ = in.z.data();
+  float *outs[3] = {out.x.data(), out.y.data(), out.z.data()};
+  for (size_t i = 0; i < simdCount; i += 4) {
+    __m128 x = _mm_loadu_ps(inX + i);
+    __m128 y = _mm_loadu_ps(inY + i);
+    __m128 z = _mm_loadu_ps(inZ + i);
+    for (int r = 0; r < 3; r++) {
+      __m128 xy = _mm_add_ps(_mm_mul_ps(column[0][r], x),
+                             _mm_mul_ps(column[1][r], y));
+      __m128 zw = _mm_add_ps(_mm_mul_ps(column[2][r], z), column[3][r]);
+      _mm_storeu_ps(outs[r] + i, _mm_add_ps(xy, zw));
+    }
+  }
+  for (size_t i = simdCount; i < count; i++) {
+    for (int r = 0; r < 3; r++) {
+      outs[r][i] = TransformCoordinate(m, r, inX[i], inY[i], inZ[i]);
+    }
+  }
+}
+
+void TransformAabbs(const glm::mat4 &m, const AabbSoA &in, AabbSoA &out) {
+  const size_t count = in.Size();
+  out.Resize(count);
+  const size_t simdCount = count & ~size_t(3);
+  const float *mins[3] = {in.minX.data(), in.minY.data(), in.minZ.data()};
+  const float *maxs[3] = {in.maxX.data(), in.maxY.data(), in.maxZ.data()};
+  float *outMins[3] = {out.minX.data(), out.minY.data(), out.minZ.data()};
+  float *outMaxs[3] = {out.maxX.data(), out.maxY.data(), out.maxZ.data()};
+  for (size_t i = 0; i < simdCount; i += 4) {
+    __m128 min[3], max[3];
+    for (int j = 0; j < 3; j++) {
+      min[j] = _mm_loadu_ps(mins[j] + i);
+      max[j] = _mm_loadu_ps(maxs[j] + i);
+    }
+    for (int r = 0; r < 3; r++) {
+      __m128 lo = _mm_set1_ps(m[3][r]);
+      __m128 hi = lo;
+      for (int j = 0; j < 3; j++) {
+        __m128 scale = _mm_set1_ps(m[j][r]);
+        __m128 a = _mm_mul_ps(scale, min[j]);
+        __m128 b = _mm_mul_ps(scale, max[j]);
+        lo = _mm_add_ps(lo, _mm_min_ps(a, b));
+        hi = _mm_add_ps(hi, _mm_max_ps(a, b));
+      }
+      _mm_storeu_ps(outMins[r] + i, lo);
+      _mm_storeu_ps(outMaxs[r] + i, hi);
+    }
+  }
+  TransformAabbRange(m, in, out, simdCount, count);
+}
+
+#else
+
+void MultiplyMat4Batch(const glm::mat4 *lhs, const glm::mat4 *rhs,
+                       glm::mat4 *out, size_t count) {
+  MultiplyMat4BatchScalar(lhs, rhs, out, count);
+}
+
+void TransformPoints(const glm::mat4 &m, const PointsSoA &in,
+                     PointsSoA &out) {
+  TransformPointsScalar(m, in, out);
+}
+
+void TransformAabbs(const glm::mat4 &m, const AabbSoA &in, AabbSoA &out) {
+  TransformAabbsScalar(m, in, out);
+}
+
+#endif
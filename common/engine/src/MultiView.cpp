@@ -0,0 +1,49 @@
+#include "MultiView.hpp"
+
+#include <algorithm>
+
+ViewsBlock MakeViewsBlock(const glm::mat4 *viewProjections, size_t count) {
+  ViewsBlock block;
+  count = std::min<size_t>(count, kMaxViews);
+  for (size_t i = 0; i < kMaxViews; i++) {
+    block.viewProjection[i] = i < count ? viewProjections[i] : glm::mat4(1.0f);
+  }
+  block.count = glm::ivec4(static_cast<int>(count), 0, 0, 0);
+  return block;
+}
+
+void MultiViewFrustum::Set(const glm::mat4 *viewProjections, size_t count) {
+  m_count = std::min<size_t>(count, kMaxViews);
+  for (size_t i = 0; i < m_count; i++) {
+    m_frustums[i].Set(viewProjections[i]);
+  }
+}
+
+bool MultiViewFrustum::IntersectsSphere(const glm::vec3 &center,
+                                        float radius) const {
+  for (size_t i = 0; i < m_count; i++) {
+    if (m_frustums[i].IntersectsSphere(center, radius)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+glm::ivec4 SplitScreenViewport(unsigned index, unsigned count, int width,
+                               int height) {
+  if (count <= 1) {
+    return glm::ivec4(0, 0, width, height);
+  }
+  if (count == 2) {
+    int half = width / 2;
+    return index == 0 ? glm::ivec4(0, 0, half, height)
+                      : glm::ivec4(half, 0, width - half, height);
+  }
+  // OpenGL counts rows from the bottom
+  int halfWidth = width / 2, halfHeight = height / 2;
+  int column = static_cast<int>(index % 2), row = static_cast<int>(index / 2);
+  int x = column == 0 ? 0 : halfWidth;
+  int y = row == 0 ? height - halfHeight : 0;
+  return glm::ivec4(x, y, column == 0 ? halfWidth : width - halfWidth,
+                    row == 0 ? halfHeight : height - halfHeight);
+}
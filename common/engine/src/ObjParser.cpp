@@ -0,0 +1,219 @@
+#include "ObjParser.hpp"
+#include "AssetArchive.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+void ObjData::Clear() {
+  positions.clear();
+  texCoords.clear();
+  normals.clear();
+  corners.clear();
+  materialLibrary.clear();
+}
+
+// Skips spaces and tabs (but never the end of the line)
+static const char *SkipBlanks(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    p++;
+  }
+  return p;
+}
+
+// Reads one float of the current line. strtof would happily skip the line
+// break and read the next line, so check for a number first.
+static bool ParseFloat(const char *&p, const char *end, float &value) {
+  p = SkipBlanks(p, end);
+  if (p >= end || *p == '\0' ||
+      std::strchr("+-.0123456789", *p) == nullptr) {
+    return false;
+  }
+  char *next = nullptr;
+  value = std::strtof(p, &next);
+  if (next == p) {
+    return false;
+  }
+  p = next;
+  return true;
+}
+
+static bool ParseInt(const char *&p, const char *end, int &value) {
+  if (p >= end || !(*p == '-' || (*p >= '0' && *p <= '9'))) {
+    return false;
+  }
+  char *next = nullptr;
+  value = static_cast<int>(std::strtol(p, &next, 10));
+  if (next == p) {
+    return false;
+  }
+  p = next;
+  return true;
+}
+
+// Turns a 1 based (or negative, relative) .obj index into a 0 based one.
+// Returns -1 if the index is out of range.
+static int ResolveIndex(int index, size_t count) {
+  if (index > 0 && static_cast<size_t>(index) <= count) {
+    return index - 1;
+  }
+  if (index < 0 && static_cast<size_t>(-index) <= count) {
+    return static_cast<int>(count) + index;
+  }
+  return -1;
+}
+
+// Parses "v", "v/t", "v//n" or "v/t/n"
+static bool ParseCorner(const char *&p, const char *end, const ObjData &data,
+                        ObjIndex &corner) {
+  int position = 0, texCoord = 0, normal = 0;
+  if (!ParseInt(p, end, position)) {
+    return false;
+  }
+  corner.position = ResolveIndex(position, data.positions.size());
+  corner.texCoord = -1;
+  corner.normal = -1;
+  if (corner.position < 0) {
+    return false;
+  }
+  if (p < end && *p == '/') {
+    p++;
+    if (p < end && *p != '/') {
+      if (!ParseInt(p, end, texCoord)) {
+        return false;
+      }
+      corner.texCoord = ResolveIndex(texCoord, data.texCoords.size());
+      if (corner.texCoord < 0) {
+        return false;
+      }
+    }
+    if (p < end && *p == '/') {
+      p++;
+      if (!ParseInt(p, end, normal)) {
+        return false;
+      }
+      corner.normal = ResolveIndex(normal, data.normals.size());
+      if (corner.normal < 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool ParseObj(const char *text, size_t length, ObjData &out,
+              std::string *error) {
+  out.Clear();
+  const char *p = text;
+  const char *end = text + length;
+  size_t lineNumber = 0;
+  std::vector<ObjIndex> polygon;
+
+  while (p < end) {
+    lineNumber++;
+    const char *lineEnd =
+        static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (lineEnd == nullptr) {
+      lineEnd = end;
+    }
+    p = SkipBlanks(p, lineEnd);
+    const char *keyword = p;
+    while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r') {
+      p++;
+    }
+    size_t keywordLength = p - keyword;
+
+    if (keywordLength == 1 && keyword[0] == 'v') {
+      glm::vec3 position(0.0f);
+      ParseFloat(p, lineEnd, position.x);
+      ParseFloat(p, lineEnd, position.y);
+      ParseFloat(p, lineEnd, position.z);
+      out.positions.push_back(position);
+    } else if (keywordLength == 2 && keyword[0] == 'v' && keyword[1] == 't') {
+      glm::vec2 texCoord(0.0f);
+      ParseFloat(p, lineEnd, texCoord.x);
+      ParseFloat(p, lineEnd, texCoord.y);
+      out.texCoords.push_back(texCoord);
+    } else if (keywordLength == 2 && keyword[0] == 'v' && keyword[1] == 'n') {
+      glm::vec3 normal(0.0f);
+      ParseFloat(p, lineEnd, normal.x);
+      ParseFloat(p, lineEnd, normal.y);
+      ParseFloat(p, lineEnd, normal.z);
+      out.normals.push_back(normal);
+    } else if (keywordLength == 1 && keyword[0] == 'f') {
+      polygon.clear();
+      while (true) {
+        p = SkipBlanks(p, lineEnd);
+        if (p >= lineEnd || *p == '\r' || *p == '#') {
+          break;
+        }
+        ObjIndex corner;
+        if (!ParseCorner(p, lineEnd, out, corner)) {
+          if (error != nullptr) {
+            *error = "invalid face on line " + std::to_string(lineNumber);
+          }
+          return false;
+        }
+        polygon.push_back(corner);
+      }
+      // Triangle fan around the first corner
+      for (size_t i = 2; i < polygon.size(); i++) {
+        out.corners.push_back(polygon[0]);
+        out.corners.push_back(polygon[i - 1]);
+        out.corners.push_back(polygon[i]);
+      }
+    } else if (keywordLength == 6 &&
+               std::strncmp(keyword, "mtllib", 6) == 0) {
+      p = SkipBlanks(p, lineEnd);
+      const char *nameEnd = lineEnd;
+      while (nameEnd > p && (nameEnd[-1] == '\r' || nameEnd[-1] == ' ' ||
+                             nameEnd[-1] == '\t')) {
+        nameEnd--;
+      }
+      out.materialLibrary.assign(p, nameEnd);
+    }
+    // Everything else (comments, groups, usemtl, s, ...) is ignored
+    p = lineEnd + 1;
+  }
+  return true;
+}
+
+bool ReadFileToString(const std::string &path, std::string &out) {
+  AssetView view = AssetArchive::Instance().Find(path);
+  if (view.kind == AssetKind::Raw) {
+    out.assign(reinterpret_cast<const char *>(view.data), view.size);
+    return true;
+  }
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) {
+    return false;
+  }
+  file.seekg(0, std::ios::end);
+  std::streamoff size = file.tellg();
+  file.seekg(0, std::ios::beg);
+  out.resize(size > 0 ? static_cast<size_t>(size) : 0);
+  if (!out.empty()) {
+    file.read(&out[0], static_cast<std::streamsize>(out.size()));
+  }
+  return true;
+}
+
+bool LoadObjFile(const std::string &path, ObjData &out, std::string *error) {
+  // A cooked mesh is already parsed
+  const AssetArchive &archive = AssetArchive::Instance();
+  AssetView view = archive.Find(path);
+  if (view.kind == AssetKind::Mesh) {
+    archive.Prefetch(view);
+    if (ReadCookedMesh(view, out)) {
+      return true;
+    }
+  }
+  std::string text;
+  if (!ReadFileToString(path, text)) {
+    if (error != nullptr) {
+      *error = "could not open " + path;
+    }
+    return false;
+  }
+  return ParseObj(text.data(), text.size(), out, error);
+}
@@ -0,0 +1,122 @@
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+unsigned GetWorkerCount() {
+  const char *threads = std::getenv("ENGINE_THREADS");
+  if (threads != nullptr && std::atoi(threads) > 0) {
+    return static_cast<unsigned>(std::atoi(threads));
+  }
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ParallelFor(size_t count, size_t grain,
+                 const std::function<void(size_t begin, size_t end)> &body,
+                 unsigned threads) {
+  if (count == 0) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+  size_t chunks = (count + grain - 1) / grain;
+  if (threads == 0) {
+    threads = GetWorkerCount();
+  }
+  threads = static_cast<unsigned>(std::min<size_t>(threads, chunks));
+  // Chunks are taken in order as threads become free, so uneven work
+  // (e.g. meshes of different sizes) still spreads out
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+      size_t begin = chunk * grain;
+      body(begin, std::min(count, begin + grain));
+    }
+  };
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (unsigned i = 1; i < threads; i++) {
+    pool.emplace_back(worker);
+  }
+  worker(); // The calling thread helps
+  for (std::thread &thread : pool) {
+    thread.join();
+  }
+}
+
+// ============================== WorkerPool ================================= //
+WorkerPool::WorkerPool(unsigned threads) {
+  if (threads == 0) {
+    threads = GetWorkerCount();
+  }
+  for (unsigned i = 1; i < threads; i++) {
+    m_threads.emplace_back(&WorkerPool::WorkerMain, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_wake.notify_all();
+  for (std::thread &thread : m_threads) {
+    thread.join();
+  }
+}
+
+void WorkerPool::Run(size_t count, size_t grain,
+                     const std::function<void(size_t, size_t)> &body) {
+  if (count == 0) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+  size_t chunks = (count + grain - 1) / grain;
+  if (chunks == 1 || m_threads.empty()) {
+    // Not worth waking anybody up
+    for (size_t begin = 0; begin < count; begin += grain) {
+      body(begin, std::min(count, begin + grain));
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_body = &body;
+    m_count = count;
+    m_grain = grain;
+    m_chunks = chunks;
+    m_next = 0;
+    m_busy = static_cast<unsigned>(m_threads.size());
+    m_generation++;
+  }
+  m_wake.notify_all();
+  TakeChunks();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this] { return m_busy == 0; });
+  m_body = nullptr;
+}
+
+void WorkerPool::WorkerMain() {
+  uint64_t seen = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+      if (m_stop) {
+        return;
+      }
+      seen = m_generation;
+    }
+    TakeChunks();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_busy == 0) {
+      m_done.notify_one();
+    }
+  }
+}
+
+void WorkerPool::TakeChunks() {
+  for (size_t chunk = m_next++; chunk < m_chunks; chunk = m_next++) {
+    size_t begin = chunk * m_grain;
+    (*m_body)(begin, std::min(m_count, begin + m_grain));
+  }
+}
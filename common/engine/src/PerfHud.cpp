@@ -0,0 +1,411 @@
+#include "PerfHud.hpp"
+#include "FrameStats.hpp"
+#include "GLState.hpp"
+#include "ResourceTracker.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+// ============================== Font ======================================= //
+// 3x5 pixel glyphs for ASCII 32..126. Bit 14 is the top left pixel, each row
+// is three bits. 0xFFFF marks a character the font does not have (drawn as
+// '?'); lower case letters are drawn as upper case.
+static const uint16_t kMissingGlyph = 0xFFFF;
+static const uint16_t kFont[95] = {
+    0x0000, 0x2482, 0xFFFF, 0x5F7D, 0xFFFF, 0x52A5, 0xFFFF, 0xFFFF, // sp ! " # $ % & '
+    0x2922, 0x224A, 0xFFFF, 0x05D0, 0x0014, 0x01C0, 0x0002, 0x12A4, // ( ) * + , - . /
+    0x7B6F, 0x2C97, 0x73E7, 0x73CF, 0x5BC9, 0x79CF, 0x79EF, 0x7249, // 0 1 2 3 4 5 6 7
+    0x7BEF, 0x7BCF, 0x0410, 0xFFFF, 0x1511, 0x0E38, 0x4454, 0x7282, // 8 9 : ; < = > ?
+    0xFFFF, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B, // @ A B C D E F G
+    0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A, // H I J K L M N O
+    0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD, // P Q R S T U V W
+    0x5AAD, 0x5A92, 0x72A7, 0x6926, 0xFFFF, 0x324B, 0xFFFF, 0x0007, // X Y Z [ bs ] ^ _
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, // ` a b c d e f g
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, // h i j k l m n o
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, // p q r s t u v w
+    0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF, 0x2492, 0xFFFF, 0xFFFF,         // x y z { | } ~
+};
+
+// The atlas has one kCharWidth x kCharHeight cell per character (the glyph
+// in the top left 3x5 pixels), 16 per row. The cell after '~' is solid
+// white and used for rectangles.
+static const int kAtlasColumns = 16;
+static const int kAtlasRows = 6;
+static const int kAtlasWidth = kAtlasColumns * HudBatch::kCharWidth;
+static const int kAtlasHeight = kAtlasRows * HudBatch::kCharHeight;
+static const int kWhiteCell = 95;
+
+// Which atlas cell draws character 'c'
+static int CellOf(char c) {
+  unsigned char u = static_cast<unsigned char>(
+      std::toupper(static_cast<unsigned char>(c)));
+  if (u < 32 || u > 126 || kFont[u - 32] == kMissingGlyph) {
+    return '?' - 32;
+  }
+  return u - 32;
+}
+
+static void CellTexCoords(int cell, float &u0, float &v0, float &u1,
+                          float &v1) {
+  int column = cell % kAtlasColumns;
+  int row = cell / kAtlasColumns;
+  u0 = static_cast<float>(column * HudBatch::kCharWidth) / kAtlasWidth;
+  v0 = static_cast<float>(row * HudBatch::kCharHeight) / kAtlasHeight;
+  u1 = static_cast<float>((column + 1) * HudBatch::kCharWidth) / kAtlasWidth;
+  v1 = static_cast<float>((row + 1) * HudBatch::kCharHeight) / kAtlasHeight;
+}
+
+// One byte per pixel, 255 where a glyph pixel is set
+static std::vector<unsigned char> BakeAtlas() {
+  std::vector<unsigned char> pixels(kAtlasWidth * kAtlasHeight, 0);
+  for (int cell = 0; cell <= kWhiteCell; cell++) {
+    int x0 = (cell % kAtlasColumns) * HudBatch::kCharWidth;
+    int y0 = (cell / kAtlasColumns) * HudBatch::kCharHeight;
+    for (int y = 0; y < HudBatch::kCharHeight; y++) {
+      for (int x = 0; x < HudBatch::kCharWidth; x++) {
+        bool set;
+        if (cell == kWhiteCell) {
+          set = true;
+        } else {
+          uint16_t bits = kFont[cell];
+          set = bits != kMissingGlyph && x < 3 && y < 5 &&
+                (bits >> (14 - (y * 3 + x))) & 1;
+        }
+        pixels[(y0 + y) * kAtlasWidth + x0 + x] = set ? 255 : 0;
+      }
+    }
+  }
+  return pixels;
+}
+
+// ============================== HudBatch =================================== //
+void HudBatch::AddQuad(float x, float y, float w, float h, float u0, float v0,
+                       float u1, float v1, uint32_t color) {
+  m_vertices.push_back({x, y, u0, v0, color});
+  m_vertices.push_back({x, y + h, u0, v1, color});
+  m_vertices.push_back({x + w, y + h, u1, v1, color});
+  m_vertices.push_back({x + w, y, u1, v0, color});
+}
+
+void HudBatch::AddRect(float x, float y, float w, float h, uint32_t color) {
+  // The middle of the white cell, so filtering never reaches a neighbour
+  float u0, v0, u1, v1;
+  CellTexCoords(kWhiteCell, u0, v0, u1, v1);
+  float u = (u0 + u1) * 0.5f;
+  float v = (v0 + v1) * 0.5f;
+  AddQuad(x, y, w, h, u, v, u, v, color);
+}
+
+float HudBatch::AddText(float x, float y, const std::string &text,
+                        float scale, uint32_t color) {
+  float w = kCharWidth * scale;
+  float h = kCharHeight * scale;
+  for (char c : text) {
+    if (c != ' ') {
+      float u0, v0, u1, v1;
+      CellTexCoords(CellOf(c), u0, v0, u1, v1);
+      AddQuad(x, y, w, h, u0, v0, u1, v1, color);
+    }
+    x += w;
+  }
+  return x;
+}
+
+void HudBatch::AddGraph(float x, float y, float w, float h,
+                        const FrameHistory &history, float budget) {
+  AddRect(x, y, w, h, HudColor(0, 0, 0, 160));
+  // Twice the budget fits, higher spikes rescale the graph
+  float top = std::max(budget * 2.0f, history.GetMax());
+  if (top <= 0.0f) {
+    return;
+  }
+  float barWidth = w / FrameHistory::kSize;
+  // Newest sample on the right
+  float left = x + w - barWidth * history.GetCount();
+  for (size_t i = 0; i < history.GetCount(); i++) {
+    float value = history.Get(i);
+    float barHeight = std::min(h, h * value / top);
+    uint32_t color = value > budget ? HudColor(230, 60, 50, 230)
+                                    : HudColor(90, 200, 90, 230);
+    AddRect(left + barWidth * i, y + h - barHeight, barWidth, barHeight,
+            color);
+  }
+  AddRect(x, y + h - h * budget / top, w, 1.0f, HudColor(255, 255, 255, 160));
+}
+
+// ============================== Layout ===================================== //
+static std::string Format(const char *format, double a, double b = 0.0,
+                          double c = 0.0) {
+  char text[96];
+  std::snprintf(text, sizeof(text), format, a, b, c);
+  return text;
+}
+
+static std::string FormatCount(size_t count) {
+  if (count >= 10000000) {
+    return Format("%.1fM", count / 1e6);
+  }
+  if (count >= 10000) {
+    return Format("%.1fK", count / 1e3);
+  }
+  return Format("%.0f", static_cast<double>(count));
+}
+
+void BuildPerfHud(HudBatch &batch, const FrameStats &stats, size_t gpuBytes,
+                  size_t cpuBytes, float hudMilliseconds) {
+  const float scale = 2.0f;
+  const float lineHeight = HudBatch::kCharHeight * scale + 2.0f;
+  const float x = 16.0f;
+  const float width = 300.0f;
+  const float graphHeight = 40.0f;
+  const float budget = 1000.0f / 60.0f;
+  const uint32_t white = HudColor(255, 255, 255);
+  const uint32_t grey = HudColor(170, 170, 170);
+
+  batch.Clear();
+  // The panel goes first so everything else is drawn on top of it
+  batch.AddRect(8.0f, 8.0f, width + 16.0f,
+                8 * lineHeight + 2 * graphHeight + 24.0f,
+                HudColor(20, 20, 24, 200));
+  float y = 16.0f;
+
+  const FrameHistory &frames = stats.GetFrameTimes();
+  float average = frames.GetAverage();
+  batch.AddText(x, y,
+                Format("FRAME %.2f MS  %.0f FPS", average,
+                       average > 0.0f ? 1000.0f / average : 0.0f),
+                scale, white);
+  y += lineHeight;
+  batch.AddText(x, y, Format("MAX %.2f MS", frames.GetMax()), scale, grey);
+  y += lineHeight;
+  batch.AddGraph(x, y, width, graphHeight, frames, budget);
+  y += graphHeight + 4.0f;
+
+  const FrameHistory &gpu = stats.GetGpuTimes();
+  batch.AddText(x, y,
+                gpu.GetCount() > 0 ? Format("GPU %.2f MS", gpu.GetAverage())
+                                   : std::string("GPU -"),
+                scale, white);
+  y += lineHeight;
+  batch.AddGraph(x, y, width, graphHeight, gpu, budget);
+  y += graphHeight + 4.0f;
+
+  const FrameCounters &last = stats.GetLastFrame();
+  batch.AddText(x, y,
+                "DRAWS " + FormatCount(last.drawCalls) + "  TRIS " +
+                    FormatCount(last.triangles),
+                scale, white);
+  y += lineHeight;
+  batch.AddText(x, y,
+                "STATE CHANGES " + FormatCount(last.stateChanges) + "  SKIP " +
+                    FormatCount(last.filteredStateChanges),
+                scale, white);
+  y += lineHeight;
+  batch.AddText(x, y, Format("GPU MEM %.1f MB", gpuBytes / 1048576.0), scale,
+                white);
+  y += lineHeight;
+  batch.AddText(x, y, Format("CPU MEM %.1f MB", cpuBytes / 1048576.0), scale,
+                white);
+  y += lineHeight;
+  batch.AddText(x, y, Format("HUD %.3f MS", hudMilliseconds), scale, grey);
+}
+
+// ============================== PerfHud ==================================== //
+// Enough for the panel, two full graphs and a few hundred characters. Four
+// vertices per quad keep the indices within 16 bits.
+static const size_t kMaxQuads = 4096;
+
+static const char *kVertexShader = R"(#version 330 core
+layout(location = 0) in vec2 a_position;
+layout(location = 1) in vec2 a_texCoord;
+layout(location = 2) in vec4 a_color;
+uniform vec2 u_ScreenSize;
+out vec2 v_texCoord;
+out vec4 v_color;
+void main() {
+  vec2 ndc = a_position / u_ScreenSize * 2.0 - 1.0;
+  gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+  v_texCoord = a_texCoord;
+  v_color = a_color;
+}
+)";
+
+static const char *kFragmentShader = R"(#version 330 core
+in vec2 v_texCoord;
+in vec4 v_color;
+uniform sampler2D u_Atlas;
+out vec4 color;
+void main() {
+  color = vec4(v_color.rgb, v_color.a * texture(u_Atlas, v_texCoord).r);
+}
+)";
+
+static GLuint CompileStage(GLenum type, const char *source) {
+  GLuint shader = glCreateShader(type);
+  glShaderSource(shader, 1, &source, nullptr);
+  glCompileShader(shader);
+  GLint ok = GL_FALSE;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+  if (!ok) {
+    char log[512];
+    glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+    std::cerr << "PerfHud: shader error: " << log << std::endl;
+    glDeleteShader(shader);
+    return 0;
+  }
+  return shader;
+}
+
+PerfHud::~PerfHud() { Release(); }
+
+bool PerfHud::Create() {
+  if (IsCreated()) {
+    return true;
+  }
+  GLuint vertex = CompileStage(GL_VERTEX_SHADER, kVertexShader);
+  GLuint fragment = CompileStage(GL_FRAGMENT_SHADER, kFragmentShader);
+  if (vertex == 0 || fragment == 0) {
+    glDeleteShader(vertex);
+    glDeleteShader(fragment);
+    return false;
+  }
+  m_program = glCreateProgram();
+  glAttachShader(m_program, vertex);
+  glAttachShader(m_program, fragment);
+  glLinkProgram(m_program);
+  glDeleteShader(vertex);
+  glDeleteShader(fragment);
+  GLint linked = GL_FALSE;
+  glGetProgramiv(m_program, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    std::cerr << "PerfHud: could not link the program" << std::endl;
+    glDeleteProgram(m_program);
+    m_program = 0;
+    return false;
+  }
+  m_screenSizeLocation = glGetUniformLocation(m_program, "u_ScreenSize");
+  GLState &state = GLState::Instance();
+  state.UseProgram(m_program);
+  glUniform1i(glGetUniformLocation(m_program, "u_Atlas"), 0);
+
+  std::vector<unsigned char> pixels = BakeAtlas();
+  glGenTextures(1, &m_atlas);
+  state.BindTexture(0, GL_TEXTURE_2D, m_atlas);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, kAtlasWidth, kAtlasHeight, 0, GL_RED,
+               GL_UNSIGNED_BYTE, pixels.data());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  // The indices never change: two triangles per quad
+  std::vector<uint16_t> indices(kMaxQuads * 6);
+  for (size_t q = 0; q < kMaxQuads; q++) {
+    uint16_t first = static_cast<uint16_t>(q * 4);
+    uint16_t quad[6] = {first,
+                        static_cast<uint16_t>(first + 1),
+                        static_cast<uint16_t>(first + 2),
+                        first,
+                        static_cast<uint16_t>(first + 2),
+                        static_cast<uint16_t>(first + 3)};
+    std::copy(quad, quad + 6, indices.begin() + q * 6);
+  }
+  m_vboBytes = kMaxQuads * 4 * sizeof(HudVertex);
+  glGenVertexArrays(1, &m_vao);
+  glGenBuffers(1, &m_vbo);
+  glGenBuffers(1, &m_ibo);
+  state.BindVertexArray(m_vao);
+  state.BindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, m_vboBytes, nullptr, GL_STREAM_DRAW);
+  state.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint16_t),
+               indices.data(), GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex),
+                        reinterpret_cast<void *>(offsetof(HudVertex, x)));
+  glEnableVertexAttribArray(1);
+  glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex),
+                        reinterpret_cast<void *>(offsetof(HudVertex, u)));
+  glEnableVertexAttribArray(2);
+  glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex),
+                        reinterpret_cast<void *>(offsetof(HudVertex, color)));
+  state.BindVertexArray(0);
+
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.TrackGpu(GpuResourceKind::Program, m_program, 0, 0, "PerfHud");
+  tracker.TrackGpu(GpuResourceKind::Texture, m_atlas,
+                   ResourceTracker::TextureBytes(kAtlasWidth, kAtlasHeight, 1,
+                                                 false),
+                   GL_R8, "PerfHud:atlas");
+  tracker.TrackGpu(GpuResourceKind::VertexArray, m_vao, 0, 0, "PerfHud");
+  tracker.TrackGpu(GpuResourceKind::Buffer, m_vbo, m_vboBytes,
+                   GL_ARRAY_BUFFER, "PerfHud:vertices");
+  tracker.TrackGpu(GpuResourceKind::Buffer, m_ibo,
+                   indices.size() * sizeof(uint16_t), GL_ELEMENT_ARRAY_BUFFER,
+                   "PerfHud:indices");
+  return true;
+}
+
+void PerfHud::Release() {
+  if (!IsCreated()) {
+    return;
+  }
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.UntrackGpu(GpuResourceKind::Program, m_program);
+  tracker.UntrackGpu(GpuResourceKind::Texture, m_atlas);
+  tracker.UntrackGpu(GpuResourceKind::VertexArray, m_vao);
+  tracker.UntrackGpu(GpuResourceKind::Buffer, m_vbo);
+  tracker.UntrackGpu(GpuResourceKind::Buffer, m_ibo);
+  glDeleteProgram(m_program);
+  glDeleteTextures(1, &m_atlas);
+  glDeleteVertexArrays(1, &m_vao);
+  glDeleteBuffers(1, &m_vbo);
+  glDeleteBuffers(1, &m_ibo);
+  m_program = m_atlas = m_vao = m_vbo = m_ibo = 0;
+}
+
+void PerfHud::Draw(int screenWidth, int screenHeight) {
+  if (!m_visible || !IsCreated()) {
+    return;
+  }
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  BuildPerfHud(m_batch, FrameStats::Instance(), tracker.GetGpuBytes(),
+               tracker.GetCpuBytes(), m_lastCost);
+  size_t quads = std::min(m_batch.GetQuadCount(), kMaxQuads);
+
+  GLState &state = GLState::Instance();
+  bool depthTest = state.IsEnabled(GL_DEPTH_TEST);
+  bool blend = state.IsEnabled(GL_BLEND);
+  state.Disable(GL_DEPTH_TEST);
+  state.Enable(GL_BLEND);
+  state.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  state.PolygonMode(GL_FILL);
+  state.Viewport(0, 0, screenWidth, screenHeight);
+
+  state.UseProgram(m_program);
+  glUniform2f(m_screenSizeLocation, static_cast<float>(screenWidth),
+              static_cast<float>(screenHeight));
+  state.BindTexture(0, GL_TEXTURE_2D, m_atlas);
+  state.BindVertexArray(m_vao);
+  // Orphan last frame's storage so the upload never waits for the GPU
+  state.BindBuffer(GL_ARRAY_BUFFER, m_vbo);
+  glBufferData(GL_ARRAY_BUFFER, m_vboBytes, nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, quads * 4 * sizeof(HudVertex),
+                  m_batch.GetVertices().data());
+  glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(quads * 6),
+                 GL_UNSIGNED_SHORT, nullptr);
+
+  state.SetEnabled(GL_BLEND, blend);
+  state.SetEnabled(GL_DEPTH_TEST, depthTest);
+  std::chrono::duration<float, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  m_lastCost = elapsed.count();
+}
@@ -0,0 +1,96 @@
+#include "RedrawScheduler.hpp"
+#include "FrameStats.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+const int RedrawScheduler::kIdleTimeoutMs;
+const int RedrawScheduler::kSettleFrames;
+const int RedrawScheduler::kMaxRequestedFrames;
+
+const char *RedrawModeName(RedrawMode mode) {
+  return mode == RedrawMode::Continuous ? "continuous" : "on-demand";
+}
+
+RedrawMode RedrawModeFromArgs(int argc, char **argv, RedrawMode fallback) {
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--continuous") == 0) {
+      return RedrawMode::Continuous;
+    }
+    if (std::strcmp(argv[i], "--on-demand") == 0) {
+      return RedrawMode::OnDemand;
+    }
+  }
+  const char *mode = std::getenv("ENGINE_REDRAW");
+  if (mode != nullptr && std::strcmp(mode, "continuous") == 0) {
+    return RedrawMode::Continuous;
+  }
+  if (mode != nullptr && std::strcmp(mode, "on-demand") == 0) {
+    return RedrawMode::OnDemand;
+  }
+  return fallback;
+}
+
+uint64_t HashState(const void *data, size_t size, uint64_t hash) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+void RedrawScheduler::SetMode(RedrawMode mode) {
+  m_mode = mode;
+  MarkDirty();
+}
+
+void RedrawScheduler::ToggleMode() {
+  SetMode(m_mode == RedrawMode::Continuous ? RedrawMode::OnDemand
+                                           : RedrawMode::Continuous);
+}
+
+void RedrawScheduler::MarkDirty() { m_dirty = true; }
+
+void RedrawScheduler::Watch(uint64_t stateHash) {
+  if (!m_hasHash || stateHash != m_lastHash) {
+    MarkDirty();
+  }
+  m_hasHash = true;
+  m_lastHash = stateHash;
+}
+
+void RedrawScheduler::RequestFrames(int frames) {
+  m_pendingFrames =
+      std::min(kMaxRequestedFrames, std::max(m_pendingFrames, frames));
+}
+
+bool RedrawScheduler::IsFrameDue() const {
+  return m_mode == RedrawMode::Continuous || m_dirty || m_pendingFrames > 0;
+}
+
+int RedrawScheduler::GetWaitTimeout() const {
+  return IsFrameDue() ? 0 : kIdleTimeoutMs;
+}
+
+bool RedrawScheduler::BeginFrame() {
+  if (!IsFrameDue()) {
+    m_wasIdle = true;
+    m_idle++;
+    return false;
+  }
+  if (m_dirty) {
+    // The settle frames follow every change
+    m_dirty = false;
+    m_pendingFrames = std::max(m_pendingFrames, kSettleFrames);
+  } else if (m_pendingFrames > 0) {
+    m_pendingFrames--;
+  }
+  if (m_wasIdle) {
+    FrameStats::Instance().DiscardIdleTime();
+    m_wasIdle = false;
+  }
+  m_drawn++;
+  return true;
+}
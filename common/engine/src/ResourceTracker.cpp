@@ -0,0 +1,235 @@
+#include "ResourceTracker.hpp"
+#include "GLState.hpp"
+
+#include <cstdlib>
+#include <iomanip>
+
+const char *GpuResourceKindName(GpuResourceKind kind) {
+  switch (kind) {
+  case GpuResourceKind::Buffer:
+    return "Buffer";
+  case GpuResourceKind::Texture:
+    return "Texture";
+  case GpuResourceKind::Renderbuffer:
+    return "Renderbuffer";
+  case GpuResourceKind::Program:
+    return "Program";
+  case GpuResourceKind::VertexArray:
+    return "VertexArray";
+  case GpuResourceKind::Framebuffer:
+    return "Framebuffer";
+  case GpuResourceKind::Query:
+    return "Query";
+  default:
+    return "Unknown";
+  }
+}
+
+// The tracker is created on first use and intentionally never destroyed, so
+// that objects destroyed during static destruction can still report back.
+ResourceTracker &ResourceTracker::Instance() {
+  static ResourceTracker *instance = new ResourceTracker();
+  return *instance;
+}
+
+void ResourceTracker::TrackGpu(GpuResourceKind kind, unsigned int id,
+                               size_t bytes, unsigned int format,
+                               const std::string &owner) {
+  if (id == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  GpuResourceInfo &info = m_gpuResources[{kind, id}];
+  info.kind = kind;
+  info.id = id;
+  info.bytes = bytes;
+  info.format = format;
+  // Keep the original owner when an object is re-specified
+  if (info.owner.empty()) {
+    info.owner = owner;
+  }
+}
+
+void ResourceTracker::UntrackGpu(GpuResourceKind kind, unsigned int id) {
+  if (id == 0) {
+    return;
+  }
+  // Deleting a bound object unbinds it, and this is called next to every
+  // glDelete*
+  GLState::Instance().OnDeleted(kind, id);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_gpuResources.erase({kind, id});
+}
+
+void ResourceTracker::TrackCpu(const std::string &category, size_t bytes) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  CpuCategoryInfo &info = m_cpuCategories[category];
+  info.liveBytes += bytes;
+  info.liveAllocations++;
+  info.totalAllocations++;
+  if (info.liveBytes > info.peakBytes) {
+    info.peakBytes = info.liveBytes;
+  }
+}
+
+void ResourceTracker::UntrackCpu(const std::string &category, size_t bytes) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  CpuCategoryInfo &info = m_cpuCategories[category];
+  info.liveBytes = bytes > info.liveBytes ? 0 : info.liveBytes - bytes;
+  if (info.liveAllocations > 0) {
+    info.liveAllocations--;
+  }
+}
+
+size_t ResourceTracker::GetGpuCount(GpuResourceKind kind) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t count = 0;
+  for (const auto &entry : m_gpuResources) {
+    if (entry.second.kind == kind) {
+      count++;
+    }
+  }
+  return count;
+}
+
+size_t ResourceTracker::GetGpuBytes(GpuResourceKind kind) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t bytes = 0;
+  for (const auto &entry : m_gpuResources) {
+    if (entry.second.kind == kind) {
+      bytes += entry.second.bytes;
+    }
+  }
+  return bytes;
+}
+
+size_t ResourceTracker::GetGpuBytes() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t bytes = 0;
+  for (const auto &entry : m_gpuResources) {
+    bytes += entry.second.bytes;
+  }
+  return bytes;
+}
+
+size_t ResourceTracker::GetCpuBytes(const std::string &category) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_cpuCategories.find(category);
+  return it == m_cpuCategories.end() ? 0 : it->second.liveBytes;
+}
+
+size_t ResourceTracker::GetCpuBytes() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t bytes = 0;
+  for (const auto &entry : m_cpuCategories) {
+    bytes += entry.second.liveBytes;
+  }
+  return bytes;
+}
+
+bool ResourceTracker::FindGpu(GpuResourceKind kind, unsigned int id,
+                              GpuResourceInfo &out) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_gpuResources.find({kind, id});
+  if (it == m_gpuResources.end()) {
+    return false;
+  }
+  out = it->second;
+  return true;
+}
+
+void ResourceTracker::DumpReport(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  out << "==================== Resource Report ====================\n";
+  // Per kind summary first
+  for (int k = 0; k < static_cast<int>(GpuResourceKind::Count); ++k) {
+    GpuResourceKind kind = static_cast<GpuResourceKind>(k);
+    size_t count = 0;
+    size_t bytes = 0;
+    for (const auto &entry : m_gpuResources) {
+      if (entry.second.kind == kind) {
+        count++;
+        bytes += entry.second.bytes;
+      }
+    }
+    out << "GPU " << std::left << std::setw(13) << GpuResourceKindName(kind)
+        << " count=" << std::setw(6) << count << " bytes=" << bytes << "\n";
+  }
+  // Then every individual object
+  for (const auto &entry : m_gpuResources) {
+    const GpuResourceInfo &info = entry.second;
+    out << "  [" << GpuResourceKindName(info.kind) << " " << info.id << "] "
+        << info.bytes << " bytes, format=0x" << std::hex << info.format
+        << std::dec << ", owner=" << info.owner << "\n";
+  }
+  for (const auto &entry : m_cpuCategories) {
+    const CpuCategoryInfo &info = entry.second;
+    out << "CPU " << std::left << std::setw(13) << entry.first
+        << " live=" << info.liveBytes << " peak=" << info.peakBytes
+        << " allocations=" << info.liveAllocations << "/"
+        << info.totalAllocations << "\n";
+  }
+  out << std::right
+      << "=========================================================\n";
+}
+
+size_t ResourceTracker::CheckForLeaks(std::ostream &out) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  size_t leaks = m_gpuResources.size();
+  for (const auto &entry : m_gpuResources) {
+    const GpuResourceInfo &info = entry.second;
+    out << "LEAK: " << GpuResourceKindName(info.kind) << " " << info.id
+        << " (" << info.bytes << " bytes) owned by " << info.owner << "\n";
+  }
+  for (const auto &entry : m_cpuCategories) {
+    if (entry.second.liveAllocations > 0 || entry.second.liveBytes > 0) {
+      leaks += entry.second.liveAllocations > 0 ? entry.second.liveAllocations
+                                                : 1;
+      out << "LEAK: " << entry.second.liveBytes << " CPU bytes in '"
+          << entry.first << "'\n";
+    }
+  }
+  return leaks;
+}
+
+bool ResourceTracker::ShutdownCheck(std::ostream &out) const {
+  size_t leaks = CheckForLeaks(out);
+  if (leaks == 0) {
+    return true;
+  }
+  out << "ResourceTracker: " << leaks << " resource(s) leaked at shutdown\n";
+  if (std::getenv("ENGINE_FAIL_ON_LEAKS") != nullptr) {
+    std::exit(EXIT_FAILURE);
+  }
+  return false;
+}
+
+void ResourceTracker::Reset() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_gpuResources.clear();
+  m_cpuCategories.clear();
+}
+
+// Textures with a full mip chain take roughly one third more memory.
+size_t ResourceTracker::TextureBytes(int width, int height, int bytesPerPixel,
+                                     bool mipmapped) {
+  if (width <= 0 || height <= 0) {
+    return 0;
+  }
+  size_t bytes = static_cast<size_t>(width) * height * bytesPerPixel;
+  return mipmapped ? bytes + bytes / 3 : bytes;
+}
+
+void TrackedAllocation::Set(size_t bytes) {
+  if (bytes == m_bytes) {
+    return;
+  }
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  if (m_bytes > 0) {
+    tracker.UntrackCpu(m_category, m_bytes);
+  }
+  if (bytes > 0) {
+    tracker.TrackCpu(m_category, bytes);
+  }
+  m_bytes = bytes;
+}
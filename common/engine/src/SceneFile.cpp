@@ -0,0 +1,789 @@
+#include "SceneFile.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+static const char kMagic[8] = {'C', 'S', '5', '3', '1', '0', 'S', 'C'};
+// Every section starts at a multiple of this
+static const uint64_t kSectionAlignment = 16;
+
+static bool Fail(std::string *error, const std::string &message) {
+  if (error != nullptr) {
+    *error = message;
+  }
+  return false;
+}
+
+const char *SceneNodeKindName(SceneNodeKind kind) {
+  switch (kind) {
+  case SceneNodeKind::Group:
+    return "group";
+  case SceneNodeKind::Terrain:
+    return "terrain";
+  }
+  return "?";
+}
+
+void SceneDescription::Clear() {
+  nodes.clear();
+  lights.clear();
+  cameras.clear();
+}
+
+glm::mat4 SceneNodeMatrix(const SceneNodeDesc &node) {
+  glm::mat4 matrix = glm::translate(glm::mat4(1.0f), node.translation);
+  matrix = glm::rotate(matrix, glm::radians(node.rotation.z),
+                       glm::vec3(0.0f, 0.0f, 1.0f));
+  matrix = glm::rotate(matrix, glm::radians(node.rotation.y),
+                       glm::vec3(0.0f, 1.0f, 0.0f));
+  matrix = glm::rotate(matrix, glm::radians(node.rotation.x),
+                       glm::vec3(1.0f, 0.0f, 0.0f));
+  return glm::scale(matrix, node.scale);
+}
+
+// ============================== Validation ================================ //
+static bool IsFinite(const glm::vec3 &v) {
+  return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+// Names and paths are single words of the text form
+static bool IsWord(const std::string &text) {
+  for (char c : text) {
+    if (c == '\0' || std::isspace(static_cast<unsigned char>(c))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ValidateScene(const SceneDescription &scene, std::string *error) {
+  if (scene.nodes.size() >= 0x7FFFFFFFu) {
+    return Fail(error, "too many nodes");
+  }
+  std::unordered_set<std::string> names;
+  for (size_t i = 0; i < scene.nodes.size(); i++) {
+    const SceneNodeDesc &node = scene.nodes[i];
+    std::string where = "node " + std::to_string(i);
+    if (node.name.empty() || !names.insert(node.name).second) {
+      return Fail(error, where + ": names must be unique and not empty");
+    }
+    where += " (" + node.name + ")";
+    if (node.parent < -1 || node.parent >= static_cast<int>(i)) {
+      return Fail(error, where + ": the parent must come before the node");
+    }
+    if (node.kind != SceneNodeKind::Group &&
+        node.kind != SceneNodeKind::Terrain) {
+      return Fail(error, where + ": unknown kind");
+    }
+    if (!IsWord(node.name) || !IsWord(node.mesh) || !IsWord(node.diffuse) ||
+        !IsWord(node.detail) || !IsWord(node.vertexShader) ||
+        !IsWord(node.fragmentShader)) {
+      return Fail(error, where + ": names and paths cannot contain spaces");
+    }
+    if (node.vertexShader.empty() != node.fragmentShader.empty()) {
+      return Fail(error, where + ": a vertex shader needs a fragment shader");
+    }
+    if (node.kind == SceneNodeKind::Terrain &&
+        (node.mesh.empty() || node.segments[0] < 2 || node.segments[1] < 2 ||
+         node.segments[0] > kMaxTerrainSegments ||
+         node.segments[1] > kMaxTerrainSegments)) {
+      return Fail(error, where + ": a terrain needs a heightmap and 2 to " +
+                             std::to_string(kMaxTerrainSegments) +
+                             " segments along each side");
+    }
+    if (!IsFinite(node.translation) || !IsFinite(node.rotation) ||
+        !IsFinite(node.scale)) {
+      return Fail(error, where + ": the transform is not finite");
+    }
+  }
+  for (size_t i = 0; i < scene.lights.size(); i++) {
+    const PointLight &light = scene.lights[i];
+    if (!IsFinite(light.position) || !IsFinite(light.color) ||
+        !std::isfinite(light.ambientIntensity) ||
+        !std::isfinite(light.specularStrength) ||
+        !std::isfinite(light.constant) || !std::isfinite(light.linear) ||
+        !std::isfinite(light.quadratic)) {
+      return Fail(error, "light " + std::to_string(i) + " is not finite");
+    }
+  }
+  for (size_t i = 0; i < scene.cameras.size(); i++) {
+    const SceneCameraDesc &camera = scene.cameras[i];
+    if (!IsFinite(camera.eye) || !IsFinite(camera.direction)) {
+      return Fail(error, "camera " + std::to_string(i) + " is not finite");
+    }
+  }
+  return true;
+}
+
+// ============================== Text form ================================= //
+static bool ReadFloats(const std::vector<std::string> &words, size_t count,
+                       float *out) {
+  if (words.size() != count + 1) {
+    return false;
+  }
+  for (size_t i = 0; i < count; i++) {
+    const char *begin = words[i + 1].c_str();
+    char *end = nullptr;
+    out[i] = std::strtof(begin, &end);
+    if (end == begin || *end != '\0') {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool ReadVec3(const std::vector<std::string> &words, glm::vec3 &out) {
+  float values[3];
+  if (!ReadFloats(words, 3, values)) {
+    return false;
+  }
+  out = glm::vec3(values[0], values[1], values[2]);
+  return true;
+}
+
+static bool ReadSegments(const std::vector<std::string> &words,
+                         uint32_t *out) {
+  if (words.size() != 3) {
+    return false;
+  }
+  for (int i = 0; i < 2; i++) {
+    const char *begin = words[i + 1].c_str();
+    char *end = nullptr;
+    unsigned long value = std::strtoul(begin, &end, 10);
+    if (end == begin || *end != '\0' || begin[0] == '-' ||
+        value > kMaxTerrainSegments) {
+      return false;
+    }
+    out[i] = static_cast<uint32_t>(value);
+  }
+  return true;
+}
+
+// One line of the text form. 'section' is what the properties go to.
+enum class TextSection { None, Node, Light, Camera };
+
+static bool ParseNodeLine(const std::vector<std::string> &words,
+                          const std::unordered_map<std::string, int> &indices,
+                          SceneNodeDesc &node, std::string &problem) {
+  const std::string &key = words[0];
+  if (key == "kind" && words.size() == 2) {
+    if (words[1] == SceneNodeKindName(SceneNodeKind::Group)) {
+      node.kind = SceneNodeKind::Group;
+    } else if (words[1] == SceneNodeKindName(SceneNodeKind::Terrain)) {
+      node.kind = SceneNodeKind::Terrain;
+    } else {
+      problem = "unknown kind '" + words[1] + "'";
+      return false;
+    }
+    return true;
+  }
+  if (key == "parent" && words.size() == 2) {
+    auto found = indices.find(words[1]);
+    if (found == indices.end() || words[1] == node.name) {
+      problem = "no node named '" + words[1] + "' before this one";
+      return false;
+    }
+    node.parent = found->second;
+    return true;
+  }
+  if (key == "static" && words.size() == 1) {
+    node.isStatic = true;
+    return true;
+  }
+  std::string *path = key == "mesh"      ? &node.mesh
+                      : key == "diffuse" ? &node.diffuse
+                      : key == "detail"  ? &node.detail
+                                         : nullptr;
+  if (path != nullptr && words.size() == 2) {
+    *path = words[1];
+    return true;
+  }
+  if (key == "shaders" && words.size() == 3) {
+    node.vertexShader = words[1];
+    node.fragmentShader = words[2];
+    return true;
+  }
+  if (key == "segments") {
+    if (!ReadSegments(words, node.segments)) {
+      problem = "'segments' takes two counts up to " +
+                std::to_string(kMaxTerrainSegments);
+      return false;
+    }
+    return true;
+  }
+  glm::vec3 *vector = key == "translate" ? &node.translation
+                      : key == "rotate"  ? &node.rotation
+                      : key == "scale"   ? &node.scale
+                                         : nullptr;
+  if (vector != nullptr) {
+    if (!ReadVec3(words, *vector)) {
+      problem = "'" + key + "' takes three numbers";
+      return false;
+    }
+    return true;
+  }
+  problem = "'" + key + "' is not a node property (or has the wrong count "
+                        "of values)";
+  return false;
+}
+
+static bool ParseLightLine(const std::vector<std::string> &words,
+                           PointLight &light, std::string &problem) {
+  const std::string &key = words[0];
+  bool ok = false;
+  if (key == "position") {
+    ok = ReadVec3(words, light.position);
+  } else if (key == "color") {
+    ok = ReadVec3(words, light.color);
+  } else if (key == "ambient") {
+    ok = ReadFloats(words, 1, &light.ambientIntensity);
+  } else if (key == "specular") {
+    ok = ReadFloats(words, 1, &light.specularStrength);
+  } else if (key == "attenuation") {
+    float values[3];
+    ok = ReadFloats(words, 3, values);
+    if (ok) {
+      light.constant = values[0];
+      light.linear = values[1];
+      light.quadratic = values[2];
+    }
+  } else {
+    problem = "'" + key + "' is not a light property";
+    return false;
+  }
+  if (!ok) {
+    problem = "wrong values for '" + key + "'";
+  }
+  return ok;
+}
+
+static bool ParseCameraLine(const std::vector<std::string> &words,
+                            SceneCameraDesc &camera, std::string &problem) {
+  const std::string &key = words[0];
+  bool ok = false;
+  if (key == "eye") {
+    ok = ReadVec3(words, camera.eye);
+  } else if (key == "direction") {
+    ok = ReadVec3(words, camera.direction);
+  } else {
+    problem = "'" + key + "' is not a camera property";
+    return false;
+  }
+  if (!ok) {
+    problem = "'" + key + "' takes three numbers";
+  }
+  return ok;
+}
+
+bool ParseSceneText(const char *text, size_t length, SceneDescription &scene,
+                    std::string *error) {
+  scene.Clear();
+  std::unordered_map<std::string, int> indices;
+  TextSection section = TextSection::None;
+  std::vector<std::string> words;
+  size_t lineNumber = 0;
+  size_t position = 0;
+  while (position < length) {
+    size_t end = position;
+    while (end < length && text[end] != '\n') {
+      end++;
+    }
+    lineNumber++;
+    // Split the line into words, up to a comment
+    words.clear();
+    size_t i = position;
+    while (i < end && text[i] != '#') {
+      if (std::isspace(static_cast<unsigned char>(text[i]))) {
+        i++;
+        continue;
+      }
+      size_t start = i;
+      while (i < end && text[i] != '#' &&
+             !std::isspace(static_cast<unsigned char>(text[i]))) {
+        i++;
+      }
+      words.emplace_back(text + start, i - start);
+    }
+    position = end + 1;
+    if (words.empty()) {
+      continue;
+    }
+
+    std::string problem;
+    const std::string &key = words[0];
+    if (key == "node") {
+      if (words.size() != 2) {
+        problem = "'node' takes a name";
+      } else if (!indices.emplace(words[1], int(scene.nodes.size())).second) {
+        problem = "there already is a node named '" + words[1] + "'";
+      } else {
+        scene.nodes.emplace_back();
+        scene.nodes.back().name = words[1];
+        section = TextSection::Node;
+      }
+    } else if (key == "light" || key == "camera") {
+      if (words.size() != 1) {
+        problem = "'" + key + "' takes no values";
+      } else if (key == "light") {
+        scene.lights.emplace_back();
+        section = TextSection::Light;
+      } else {
+        scene.cameras.emplace_back();
+        section = TextSection::Camera;
+      }
+    } else if (section == TextSection::Node) {
+      ParseNodeLine(words, indices, scene.nodes.back(), problem);
+    } else if (section == TextSection::Light) {
+      ParseLightLine(words, scene.lights.back(), problem);
+    } else if (section == TextSection::Camera) {
+      ParseCameraLine(words, scene.cameras.back(), problem);
+    } else {
+      problem = "'" + key + "' before the first node, light or camera";
+    }
+    if (!problem.empty()) {
+      scene.Clear();
+      return Fail(error, "line " + std::to_string(lineNumber) + ": " + problem);
+    }
+  }
+  if (!ValidateScene(scene, error)) {
+    scene.Clear();
+    return false;
+  }
+  return true;
+}
+
+// The shortest form that reads back as the same float
+static std::string FormatFloat(float value) {
+  char buffer[32];
+  for (int precision = 1; precision <= 9; precision++) {
+    std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    if (std::strtof(buffer, nullptr) == value) {
+      break;
+    }
+  }
+  return buffer;
+}
+
+static void WriteVec3(std::ostringstream &out, const char *key,
+                      const glm::vec3 &v) {
+  out << "    " << key << " " << FormatFloat(v.x) << " " << FormatFloat(v.y)
+      << " " << FormatFloat(v.z) << "\n";
+}
+
+std::string WriteSceneText(const SceneDescription &scene) {
+  std::ostringstream out;
+  for (const SceneNodeDesc &node : scene.nodes) {
+    out << "node " << node.name << "\n";
+    if (node.kind != SceneNodeKind::Group) {
+      out << "    kind " << SceneNodeKindName(node.kind) << "\n";
+    }
+    if (node.parent >= 0) {
+      out << "    parent " << scene.nodes[node.parent].name << "\n";
+    }
+    if (node.isStatic) {
+      out << "    static\n";
+    }
+    if (!node.mesh.empty()) {
+      out << "    mesh " << node.mesh << "\n";
+    }
+    if (node.segments[0] != 0 || node.segments[1] != 0) {
+      out << "    segments " << node.segments[0] << " " << node.segments[1]
+          << "\n";
+    }
+    if (!node.diffuse.empty()) {
+      out << "    diffuse " << node.diffuse << "\n";
+    }
+    if (!node.detail.empty()) {
+      out << "    detail " << node.detail << "\n";
+    }
+    if (!node.vertexShader.empty()) {
+      out << "    shaders " << node.vertexShader << " " << node.fragmentShader
+          << "\n";
+    }
+    if (node.translation != glm::vec3(0.0f)) {
+      WriteVec3(out, "translate", node.translation);
+    }
+    if (node.rotation != glm::vec3(0.0f)) {
+      WriteVec3(out, "rotate", node.rotation);
+    }
+    if (node.scale != glm::vec3(1.0f)) {
+      WriteVec3(out, "scale", node.scale);
+    }
+  }
+  const PointLight defaults;
+  for (const PointLight &light : scene.lights) {
+    out << "light\n";
+    if (light.position != defaults.position) {
+      WriteVec3(out, "position", light.position);
+    }
+    if (light.color != defaults.color) {
+      WriteVec3(out, "color", light.color);
+    }
+    if (light.ambientIntensity != defaults.ambientIntensity) {
+      out << "    ambient " << FormatFloat(light.ambientIntensity) << "\n";
+    }
+    if (light.specularStrength != defaults.specularStrength) {
+      out << "    specular " << FormatFloat(light.specularStrength) << "\n";
+    }
+    if (light.constant != defaults.constant ||
+        light.linear != defaults.linear ||
+        light.quadratic != defaults.quadratic) {
+      out << "    attenuation " << FormatFloat(light.constant) << " "
+          << FormatFloat(light.linear) << " " << FormatFloat(light.quadratic)
+          << "\n";
+    }
+  }
+  const SceneCameraDesc camera;
+  for (const SceneCameraDesc &view : scene.cameras) {
+    out << "camera\n";
+    if (view.eye != camera.eye) {
+      WriteVec3(out, "eye", view.eye);
+    }
+    if (view.direction != camera.direction) {
+      WriteVec3(out, "direction", view.direction);
+    }
+  }
+  return out.str();
+}
+
+// ============================== Binary form =============================== //
+static uint64_t AlignSection(uint64_t offset) {
+  return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+static void CopyVec3(const glm::vec3 &v, float *out) {
+  out[0] = v.x;
+  out[1] = v.y;
+  out[2] = v.z;
+}
+
+static glm::vec3 ToVec3(const float *v) { return glm::vec3(v[0], v[1], v[2]); }
+
+// Each distinct string once, in the order they are first used
+class StringPool {
+public:
+  uint32_t Add(const std::string &text) {
+    if (text.empty()) {
+      return kNoSceneString;
+    }
+    auto found = m_offsets.find(text);
+    if (found != m_offsets.end()) {
+      return found->second;
+    }
+    uint32_t offset = static_cast<uint32_t>(m_bytes.size());
+    m_bytes.insert(m_bytes.end(), text.begin(), text.end());
+    m_bytes.push_back('\0');
+    m_offsets.emplace(text, offset);
+    return offset;
+  }
+  const std::vector<char> &GetBytes() const { return m_bytes; }
+
+private:
+  std::unordered_map<std::string, uint32_t> m_offsets;
+  std::vector<char> m_bytes;
+};
+
+bool CookScene(const SceneDescription &scene, std::vector<uint8_t> &out,
+               std::string *error) {
+  out.clear();
+  if (!ValidateScene(scene, error)) {
+    return false;
+  }
+  StringPool strings;
+  std::vector<SceneNodeRecord> nodes(scene.nodes.size());
+  for (size_t i = 0; i < scene.nodes.size(); i++) {
+    const SceneNodeDesc &node = scene.nodes[i];
+    SceneNodeRecord &record = nodes[i];
+    std::memset(&record, 0, sizeof(record));
+    record.parent = node.parent;
+    record.kind = node.kind;
+    record.flags = node.isStatic ? kSceneNodeStatic : 0u;
+    record.name = strings.Add(node.name);
+    record.mesh = strings.Add(node.mesh);
+    record.diffuse = strings.Add(node.diffuse);
+    record.detail = strings.Add(node.detail);
+    record.vertexShader = strings.Add(node.vertexShader);
+    record.fragmentShader = strings.Add(node.fragmentShader);
+    record.segments[0] = node.segments[0];
+    record.segments[1] = node.segments[1];
+    CopyVec3(node.translation, record.translation);
+    CopyVec3(node.rotation, record.rotation);
+    CopyVec3(node.scale, record.scale);
+  }
+  std::vector<SceneLightRecord> lights(scene.lights.size());
+  for (size_t i = 0; i < scene.lights.size(); i++) {
+    const PointLight &light = scene.lights[i];
+    SceneLightRecord &record = lights[i];
+    std::memset(&record, 0, sizeof(record));
+    CopyVec3(light.position, record.position);
+    CopyVec3(light.color, record.color);
+    record.ambientIntensity = light.ambientIntensity;
+    record.specularStrength = light.specularStrength;
+    record.constant = light.constant;
+    record.linear = light.linear;
+    record.quadratic = light.quadratic;
+  }
+  std::vector<SceneCameraRecord> cameras(scene.cameras.size());
+  for (size_t i = 0; i < scene.cameras.size(); i++) {
+    CopyVec3(scene.cameras[i].eye, cameras[i].eye);
+    CopyVec3(scene.cameras[i].direction, cameras[i].direction);
+  }
+
+  SceneFileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kSceneFileVersion;
+  header.nodeCount = static_cast<uint32_t>(nodes.size());
+  header.lightCount = static_cast<uint32_t>(lights.size());
+  header.cameraCount = static_cast<uint32_t>(cameras.size());
+  header.nodesOffset = AlignSection(sizeof(header));
+  header.lightsOffset = AlignSection(header.nodesOffset +
+                                     nodes.size() * sizeof(SceneNodeRecord));
+  header.camerasOffset = AlignSection(
+      header.lightsOffset + lights.size() * sizeof(SceneLightRecord));
+  header.stringsOffset = AlignSection(
+      header.camerasOffset + cameras.size() * sizeof(SceneCameraRecord));
+  header.stringsSize = strings.GetBytes().size();
+  header.fileSize = header.stringsOffset + header.stringsSize;
+
+  out.assign(static_cast<size_t>(header.fileSize), 0);
+  std::memcpy(out.data(), &header, sizeof(header));
+  if (!nodes.empty()) {
+    std::memcpy(out.data() + header.nodesOffset, nodes.data(),
+                nodes.size() * sizeof(SceneNodeRecord));
+  }
+  if (!lights.empty()) {
+    std::memcpy(out.data() + header.lightsOffset, lights.data(),
+                lights.size() * sizeof(SceneLightRecord));
+  }
+  if (!cameras.empty()) {
+    std::memcpy(out.data() + header.camerasOffset, cameras.data(),
+                cameras.size() * sizeof(SceneCameraRecord));
+  }
+  if (header.stringsSize > 0) {
+    std::memcpy(out.data() + header.stringsOffset, strings.GetBytes().data(),
+                strings.GetBytes().size());
+  }
+  return true;
+}
+
+bool WriteSceneFile(const std::string &path, const SceneDescription &scene,
+                    std::string *error) {
+  std::vector<uint8_t> bytes;
+  if (!CookScene(scene, bytes, error)) {
+    return false;
+  }
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char *>(bytes.data()),
+             static_cast<std::streamsize>(bytes.size()));
+  if (!file) {
+    return Fail(error, "could not write " + path);
+  }
+  return true;
+}
+
+// ============================== SceneFile ================================= //
+SceneFile::~SceneFile() { Close(); }
+
+bool SceneFile::Open(const std::string &path, std::string *error) {
+  Close();
+  if (!m_file.Open(path, error)) {
+    return false;
+  }
+  std::string problem;
+  if (!Validate(&problem)) {
+    Close();
+    return Fail(error, path + ": " + problem);
+  }
+  return true;
+}
+
+void SceneFile::Close() {
+  m_file.Close();
+  m_header = nullptr;
+  m_nodes = nullptr;
+  m_lights = nullptr;
+  m_cameras = nullptr;
+  m_strings = nullptr;
+}
+
+// A section of 'count' records of 'size' bytes that fits in the file
+static bool FitsSection(uint64_t offset, uint64_t count, uint64_t size,
+                        uint64_t fileSize) {
+  return offset % kSectionAlignment == 0 && offset <= fileSize &&
+         count <= (fileSize - offset) / size;
+}
+
+static bool IsFinite(const float *v, int count) {
+  for (int i = 0; i < count; i++) {
+    if (!std::isfinite(v[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Checks everything the accessors rely on, once
+bool SceneFile::Validate(std::string *error) {
+  const uint8_t *data = m_file.GetData();
+  const uint64_t size = m_file.GetSize();
+  if (size < sizeof(SceneFileHeader)) {
+    return Fail(error, "too small for a scene");
+  }
+  const SceneFileHeader *header =
+      reinterpret_cast<const SceneFileHeader *>(data);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+    return Fail(error, "not a binary scene");
+  }
+  if (header->version != kSceneFileVersion) {
+    return Fail(error, "scene version " + std::to_string(header->version) +
+                           ", expected " + std::to_string(kSceneFileVersion) +
+                           " (cook it again)");
+  }
+  if (header->fileSize != size ||
+      !FitsSection(header->nodesOffset, header->nodeCount,
+                   sizeof(SceneNodeRecord), size) ||
+      !FitsSection(header->lightsOffset, header->lightCount,
+                   sizeof(SceneLightRecord), size) ||
+      !FitsSection(header->camerasOffset, header->cameraCount,
+                   sizeof(SceneCameraRecord), size) ||
+      !FitsSection(header->stringsOffset, header->stringsSize, 1, size)) {
+    return Fail(error, "truncated or damaged sections");
+  }
+  const char *strings =
+      reinterpret_cast<const char *>(data + header->stringsOffset);
+  const uint64_t stringsSize = header->stringsSize;
+  // Any offset into a terminated block is a terminated string
+  if (stringsSize > 0 && strings[stringsSize - 1] != '\0') {
+    return Fail(error, "the strings are not terminated");
+  }
+  auto isString = [&](uint32_t offset) {
+    return offset == kNoSceneString || offset < stringsSize;
+  };
+
+  const SceneNodeRecord *nodes =
+      reinterpret_cast<const SceneNodeRecord *>(data + header->nodesOffset);
+  for (uint32_t i = 0; i < header->nodeCount; i++) {
+    const SceneNodeRecord &node = nodes[i];
+    bool ok = node.parent >= -1 && node.parent < static_cast<int64_t>(i) &&
+              node.kind <= SceneNodeKind::Terrain &&
+              (node.flags & ~kSceneNodeStatic) == 0 && isString(node.name) &&
+              isString(node.mesh) && isString(node.diffuse) &&
+              isString(node.detail) && isString(node.vertexShader) &&
+              isString(node.fragmentShader) &&
+              IsFinite(node.translation, 3) && IsFinite(node.rotation, 3) &&
+              IsFinite(node.scale, 3);
+    if (ok && node.kind == SceneNodeKind::Terrain) {
+      ok = node.mesh != kNoSceneString && node.segments[0] >= 2 &&
+           node.segments[1] >= 2 && node.segments[0] <= kMaxTerrainSegments &&
+           node.segments[1] <= kMaxTerrainSegments;
+    }
+    if (!ok) {
+      return Fail(error, "damaged node " + std::to_string(i));
+    }
+  }
+  const SceneLightRecord *lights =
+      reinterpret_cast<const SceneLightRecord *>(data + header->lightsOffset);
+  // Lights are 11 floats, cameras 6, from their first field on
+  for (uint32_t i = 0; i < header->lightCount; i++) {
+    if (!IsFinite(lights[i].position, 11)) {
+      return Fail(error, "damaged light " + std::to_string(i));
+    }
+  }
+  const SceneCameraRecord *cameras =
+      reinterpret_cast<const SceneCameraRecord *>(data + header->camerasOffset);
+  for (uint32_t i = 0; i < header->cameraCount; i++) {
+    if (!IsFinite(cameras[i].eye, 6)) {
+      return Fail(error, "damaged camera " + std::to_string(i));
+    }
+  }
+  m_header = header;
+  m_nodes = nodes;
+  m_lights = lights;
+  m_cameras = cameras;
+  m_strings = strings;
+  return true;
+}
+
+void SceneFile::ToDescription(SceneDescription &scene) const {
+  scene.Clear();
+  if (!IsOpen()) {
+    return;
+  }
+  scene.nodes.resize(m_header->nodeCount);
+  for (uint32_t i = 0; i < m_header->nodeCount; i++) {
+    const SceneNodeRecord &record = m_nodes[i];
+    SceneNodeDesc &node = scene.nodes[i];
+    node.name = GetString(record.name);
+    node.parent = record.parent;
+    node.kind = record.kind;
+    node.isStatic = (record.flags & kSceneNodeStatic) != 0;
+    node.mesh = GetString(record.mesh);
+    node.diffuse = GetString(record.diffuse);
+    node.detail = GetString(record.detail);
+    node.vertexShader = GetString(record.vertexShader);
+    node.fragmentShader = GetString(record.fragmentShader);
+    node.segments[0] = record.segments[0];
+    node.segments[1] = record.segments[1];
+    node.translation = ToVec3(record.translation);
+    node.rotation = ToVec3(record.rotation);
+    node.scale = ToVec3(record.scale);
+  }
+  scene.lights.resize(m_header->lightCount);
+  for (uint32_t i = 0; i < m_header->lightCount; i++) {
+    const SceneLightRecord &record = m_lights[i];
+    PointLight &light = scene.lights[i];
+    light.position = ToVec3(record.position);
+    light.color = ToVec3(record.color);
+    light.ambientIntensity = record.ambientIntensity;
+    light.specularStrength = record.specularStrength;
+    light.constant = record.constant;
+    light.linear = record.linear;
+    light.quadratic = record.quadratic;
+  }
+  scene.cameras.resize(m_header->cameraCount);
+  for (uint32_t i = 0; i < m_header->cameraCount; i++) {
+    scene.cameras[i].eye = ToVec3(m_cameras[i].eye);
+    scene.cameras[i].direction = ToVec3(m_cameras[i].direction);
+  }
+}
+
+bool LoadScene(const std::string &path, SceneDescription &scene,
+               std::string *error) {
+  scene.Clear();
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return Fail(error, "could not open " + path);
+  }
+  char magic[sizeof(kMagic)] = {};
+  file.read(magic, sizeof(magic));
+  if (file.gcount() == sizeof(magic) &&
+      std::memcmp(magic, kMagic, sizeof(kMagic)) == 0) {
+    file.close();
+    SceneFile binary;
+    if (!binary.Open(path, error)) {
+      return false;
+    }
+    binary.ToDescription(scene);
+    return true;
+  }
+  file.clear();
+  file.seekg(0);
+  std::string text((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  std::string problem;
+  if (!ParseSceneText(text.data(), text.size(), scene, &problem)) {
+    return Fail(error, path + ": " + problem);
+  }
+  return true;
+}
@@ -0,0 +1,131 @@
+#include "ShadowCascades.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+void ComputeCascadeSplits(float nearPlane, float farPlane, unsigned count,
+                          float lambda, float *ends) {
+  for (unsigned i = 1; i <= count; i++) {
+    float fraction = static_cast<float>(i) / static_cast<float>(count);
+    float logarithmic = nearPlane * std::pow(farPlane / nearPlane, fraction);
+    float uniform = nearPlane + (farPlane - nearPlane) * fraction;
+    ends[i - 1] = lambda * logarithmic + (1.0f - lambda) * uniform;
+  }
+  // Exactly, whatever the rounding
+  ends[count - 1] = farPlane;
+}
+
+void FrustumSliceSphere(const glm::mat4 &cameraView, float fovY, float aspect,
+                        float sliceNear, float sliceFar, glm::vec3 &center,
+                        float &radius) {
+  // A corner at distance d is k * d away from the view axis
+  float tangent = std::tan(fovY * 0.5f);
+  float k2 = tangent * tangent * (1.0f + aspect * aspect);
+  // The point on the axis as far from the near corners as from the far
+  // ones, unless that is beyond the far plane
+  float distance =
+      std::min(sliceFar, 0.5f * (sliceNear + sliceFar) * (1.0f + k2));
+  radius = std::sqrt((sliceFar - distance) * (sliceFar - distance) +
+                     k2 * sliceFar * sliceFar);
+  center = glm::vec3(glm::inverse(cameraView) *
+                     glm::vec4(0.0f, 0.0f, -distance, 1.0f));
+}
+
+ShadowCascade FitShadowCascade(const glm::vec3 &center, float radius,
+                               const glm::vec3 &lightDirection,
+                               int resolution, float casterDistance) {
+  ShadowCascade cascade;
+  cascade.center = center;
+  cascade.radius = radius;
+  glm::vec3 direction = glm::normalize(lightDirection);
+  glm::vec3 up = std::fabs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f)
+                                                : glm::vec3(0.0f, 1.0f, 0.0f);
+  glm::vec3 eye = center - direction * (radius + casterDistance);
+  cascade.view = glm::lookAt(eye, center, up);
+  cascade.projection = glm::ortho(-radius, radius, -radius, radius, 0.0f,
+                                  2.0f * radius + casterDistance);
+
+  // Move the projection so the world origin lands on a texel corner: the
+  // texel grid then stays put in the world while the cascade follows the
+  // camera
+  float halfResolution = 0.5f * static_cast<float>(resolution);
+  glm::vec4 origin =
+      cascade.projection * cascade.view * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+  glm::vec2 texels = glm::vec2(origin) * halfResolution;
+  glm::vec2 offset = (glm::round(texels) - texels) / halfResolution;
+  cascade.projection[3][0] += offset.x;
+  cascade.projection[3][1] += offset.y;
+  cascade.viewProjection = cascade.projection * cascade.view;
+  return cascade;
+}
+
+void ShadowCascadeCache::SetSettings(const ShadowSettings &settings) {
+  m_settings = settings;
+  m_settings.cascades =
+      std::max(1u, std::min(m_settings.cascades, kMaxCascades));
+  m_valid = 0;
+}
+
+unsigned ShadowCascadeCache::Update(const glm::mat4 &cameraView, float fovY,
+                                    float aspect, float nearPlane,
+                                    float farPlane,
+                                    const glm::vec3 &lightDirection) {
+  if (lightDirection != m_lightDirection) {
+    m_lightDirection = lightDirection;
+    m_valid = 0;
+  }
+  float ends[kMaxCascades];
+  ComputeCascadeSplits(nearPlane, farPlane, m_settings.cascades,
+                       m_settings.splitLambda, ends);
+
+  unsigned mask = 0;
+  float sliceNear = nearPlane;
+  for (unsigned i = 0; i < m_settings.cascades; i++) {
+    glm::vec3 center;
+    float radius;
+    FrustumSliceSphere(cameraView, fovY, aspect, sliceNear, ends[i], center,
+                       radius);
+    ShadowCascade &cascade = m_cascades[i];
+    unsigned bit = 1u << i;
+    if (!IsCached(i)) {
+      cascade = FitShadowCascade(center, radius, lightDirection,
+                                 m_settings.resolution,
+                                 m_settings.casterDistance);
+      mask |= bit;
+    } else {
+      bool covered = (m_valid & bit) != 0 &&
+                     glm::length(center - cascade.center) + radius <=
+                         cascade.radius;
+      if (!covered) {
+        cascade = FitShadowCascade(center,
+                                   radius * (1.0f + m_settings.cacheMargin),
+                                   lightDirection, m_settings.resolution,
+                                   m_settings.casterDistance);
+        m_valid |= bit;
+        mask |= bit;
+      }
+    }
+    cascade.end = ends[i];
+    sliceNear = ends[i];
+  }
+
+  m_stats.frames++;
+  for (unsigned i = 0; i < m_settings.cascades; i++) {
+    m_stats.drawn[i] += (mask >> i) & 1u;
+  }
+  return mask;
+}
+
+ShadowBlock ShadowCascadeCache::GetBlock(const glm::mat4 &cameraView) const {
+  ShadowBlock block;
+  for (unsigned i = 0; i < kMaxCascades; i++) {
+    block.lightViewProjection[i] = m_cascades[i].viewProjection;
+    block.cascadeEnds[i] = i < m_settings.cascades ? m_cascades[i].end : 0.0f;
+  }
+  block.cameraView = cameraView;
+  block.lightDirection = glm::vec4(glm::normalize(m_lightDirection), 0.0f);
+  block.count = glm::ivec4(static_cast<int>(m_settings.cascades), 0, 0, 0);
+  return block;
+}
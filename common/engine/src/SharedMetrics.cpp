@@ -0,0 +1,288 @@
+#include "SharedMetrics.hpp"
+#include "FrameStats.hpp"
+#include "GLDebug.hpp"
+#include "ResourceTracker.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(sizeof(MetricsSnapshot::gpuObjects) /
+                      sizeof(MetricsSnapshot::gpuObjects[0]) >=
+                  static_cast<size_t>(GpuResourceKind::Count),
+              "one gpuObjects entry per GpuResourceKind");
+
+const uint32_t SharedMetricsBlock::kMagic;
+const uint32_t SharedMetricsBlock::kVersion;
+const size_t SharedMetricsBlock::kWords;
+
+// ============================== Collecting ================================= //
+void CollectMetrics(MetricsSnapshot &out) {
+  const FrameStats &stats = FrameStats::Instance();
+  const FrameHistory &frames = stats.GetFrameTimes();
+  out.frameNumber = stats.GetFrameNumber();
+  out.timestampMs = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::system_clock::now().time_since_epoch())
+          .count());
+#ifndef _WIN32
+  out.processId = static_cast<uint32_t>(getpid());
+#else
+  out.processId = 0;
+#endif
+  out.frameMs = frames.GetLatest();
+  out.frameAverageMs = frames.GetAverage();
+  out.frameP50Ms = frames.GetPercentile(0.50f);
+  out.frameP95Ms = frames.GetPercentile(0.95f);
+  out.frameP99Ms = frames.GetPercentile(0.99f);
+  out.frameMaxMs = frames.GetMax();
+  out.gpuMs = stats.GetGpuTimes().GetAverage();
+
+  const FrameCounters &last = stats.GetLastFrame();
+  out.drawCalls = last.drawCalls;
+  out.triangles = last.triangles;
+  out.stateChanges = last.stateChanges;
+  out.filteredStateChanges = last.filteredStateChanges;
+  const GLDebugCounts &messages = GLDebug::Instance().GetLastFrame();
+  out.glErrors = messages.errors;
+  out.glPerformanceWarnings = messages.performance;
+
+  const ResourceTracker &tracker = ResourceTracker::Instance();
+  out.gpuBytes = tracker.GetGpuBytes();
+  out.cpuBytes = tracker.GetCpuBytes();
+  std::memset(out.gpuObjects, 0, sizeof(out.gpuObjects));
+  for (int k = 0; k < static_cast<int>(GpuResourceKind::Count); k++) {
+    out.gpuObjects[k] = static_cast<uint32_t>(
+        tracker.GetGpuCount(static_cast<GpuResourceKind>(k)));
+  }
+}
+
+std::string MetricsName(const std::string &program) {
+  const char *name = std::getenv("ENGINE_METRICS_SHM");
+  if (name != nullptr && name[0] != '\0') {
+    return std::strcmp(name, "off") == 0 ? std::string() : std::string(name);
+  }
+  return "/cs5310_" + program;
+}
+
+// ============================== Printing =================================== //
+void PrintMetrics(std::ostream &out, const MetricsSnapshot &s) {
+  out << s.program << " (pid " << s.processId << ") frame " << s.frameNumber
+      << "\n  model: " << s.model << ", cache mode: " << s.cacheMode
+      << "\n  frame ms: last " << s.frameMs << ", avg " << s.frameAverageMs
+      << ", p50 " << s.frameP50Ms << ", p95 " << s.frameP95Ms << ", p99 "
+      << s.frameP99Ms << ", max " << s.frameMaxMs << "\n  gpu ms: " << s.gpuMs
+      << "\n  draws: " << s.drawCalls << ", triangles: " << s.triangles
+      << ", state changes: " << s.stateChanges << " (+"
+      << s.filteredStateChanges << " filtered)"
+      << "\n  gl errors: " << s.glErrors
+      << ", performance warnings: " << s.glPerformanceWarnings
+      << "\n  memory: gpu " << s.gpuBytes << " bytes, cpu " << s.cpuBytes
+      << " bytes\n  gpu objects:";
+  for (int k = 0; k < static_cast<int>(GpuResourceKind::Count); k++) {
+    out << " " << GpuResourceKindName(static_cast<GpuResourceKind>(k)) << "="
+        << s.gpuObjects[k];
+  }
+  out << "\n";
+}
+
+void WriteMetricsCsvHeader(std::ostream &out) {
+  out << "timestamp_ms,pid,program,model,cache_mode,frame,frame_ms,"
+         "frame_avg_ms,frame_p50_ms,frame_p95_ms,frame_p99_ms,frame_max_ms,"
+         "gpu_ms,draw_calls,triangles,state_changes,filtered_state_changes,"
+         "gl_errors,gl_performance_warnings,gpu_bytes,cpu_bytes";
+  for (int k = 0; k < static_cast<int>(GpuResourceKind::Count); k++) {
+    out << "," << GpuResourceKindName(static_cast<GpuResourceKind>(k));
+  }
+  out << "\n";
+}
+
+// Names come from file paths, so quote them
+static void WriteCsvText(std::ostream &out, const char *text) {
+  out << '"';
+  for (const char *c = text; *c != '\0'; c++) {
+    if (*c == '"') {
+      out << '"';
+    }
+    out << *c;
+  }
+  out << '"';
+}
+
+void WriteMetricsCsvRow(std::ostream &out, const MetricsSnapshot &s) {
+  out << s.timestampMs << "," << s.processId << ",";
+  WriteCsvText(out, s.program);
+  out << ",";
+  WriteCsvText(out, s.model);
+  out << "," << s.cacheMode << "," << s.frameNumber << "," << s.frameMs << ","
+      << s.frameAverageMs << "," << s.frameP50Ms << "," << s.frameP95Ms << ","
+      << s.frameP99Ms << "," << s.frameMaxMs << "," << s.gpuMs << ","
+      << s.drawCalls << "," << s.triangles << "," << s.stateChanges << ","
+      << s.filteredStateChanges << ","
+      << s.glErrors << "," << s.glPerformanceWarnings << "," << s.gpuBytes
+      << "," << s.cpuBytes;
+  for (int k = 0; k < static_cast<int>(GpuResourceKind::Count); k++) {
+    out << "," << s.gpuObjects[k];
+  }
+  out << "\n";
+}
+
+// ============================== Publisher ================================== //
+MetricsPublisher::~MetricsPublisher() { Close(); }
+
+bool MetricsPublisher::Open(const std::string &name) {
+  Close();
+#ifdef _WIN32
+  m_error = "shared memory metrics are not supported on Windows";
+  return false;
+#else
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    m_error = "shm_open(" + name + "): " + std::strerror(errno);
+    return false;
+  }
+  if (ftruncate(fd, sizeof(SharedMetricsBlock)) != 0) {
+    m_error = "ftruncate(" + name + "): " + std::strerror(errno);
+    close(fd);
+    return false;
+  }
+  void *memory = mmap(nullptr, sizeof(SharedMetricsBlock),
+                      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    m_error = "mmap(" + name + "): " + std::strerror(errno);
+    return false;
+  }
+  m_block = static_cast<SharedMetricsBlock *>(memory);
+  m_name = name;
+  // Readers check the header, so write it last
+  m_block->sequence.store(0, std::memory_order_relaxed);
+  m_block->snapshotSize = sizeof(MetricsSnapshot);
+  m_block->version = SharedMetricsBlock::kVersion;
+  m_block->padding = 0;
+  std::atomic_thread_fence(std::memory_order_release);
+  m_block->magic = SharedMetricsBlock::kMagic;
+  return true;
+#endif
+}
+
+void MetricsPublisher::Close() {
+#ifndef _WIN32
+  if (m_block == nullptr) {
+    return;
+  }
+  munmap(m_block, sizeof(SharedMetricsBlock));
+  shm_unlink(m_name.c_str());
+  m_block = nullptr;
+#endif
+}
+
+void MetricsPublisher::Publish(const MetricsSnapshot &snapshot) {
+  if (m_block == nullptr) {
+    return;
+  }
+  uint64_t words[SharedMetricsBlock::kWords];
+  std::memcpy(words, &snapshot, sizeof(words));
+  uint64_t sequence = m_block->sequence.load(std::memory_order_relaxed);
+  // Odd: readers that start now retry
+  m_block->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  for (size_t i = 0; i < SharedMetricsBlock::kWords; i++) {
+    m_block->words[i].store(words[i], std::memory_order_relaxed);
+  }
+  // Even again: the copy is complete
+  m_block->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// ============================== Reader ===================================== //
+MetricsReader::~MetricsReader() { Close(); }
+
+bool MetricsReader::Open(const std::string &name) {
+  Close();
+#ifdef _WIN32
+  m_error = "shared memory metrics are not supported on Windows";
+  return false;
+#else
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    m_error = "shm_open(" + name + "): " + std::strerror(errno);
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      info.st_size < static_cast<off_t>(sizeof(SharedMetricsBlock))) {
+    m_error = name + " is too small to be a metrics block";
+    close(fd);
+    return false;
+  }
+  void *memory =
+      mmap(nullptr, sizeof(SharedMetricsBlock), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    m_error = "mmap(" + name + "): " + std::strerror(errno);
+    return false;
+  }
+  const SharedMetricsBlock *block =
+      static_cast<const SharedMetricsBlock *>(memory);
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (block->magic != SharedMetricsBlock::kMagic ||
+      block->version != SharedMetricsBlock::kVersion ||
+      block->snapshotSize != sizeof(MetricsSnapshot)) {
+    m_error = name + " has a different layout (another version?)";
+    munmap(memory, sizeof(SharedMetricsBlock));
+    return false;
+  }
+  m_block = block;
+  return true;
+#endif
+}
+
+void MetricsReader::Close() {
+#ifndef _WIN32
+  if (m_block == nullptr) {
+    return;
+  }
+  munmap(const_cast<SharedMetricsBlock *>(m_block),
+         sizeof(SharedMetricsBlock));
+  m_block = nullptr;
+#endif
+}
+
+bool MetricsReader::Read(MetricsSnapshot &out, int maxAttempts) const {
+  if (m_block == nullptr) {
+    return false;
+  }
+  uint64_t words[SharedMetricsBlock::kWords];
+  for (int attempt = 0; attempt < maxAttempts; attempt++) {
+    uint64_t before = m_block->sequence.load(std::memory_order_acquire);
+    if (before == 0) {
+      return false; // Nothing published yet
+    }
+    if (before & 1) {
+      continue; // The writer is in the middle of a copy
+    }
+    for (size_t i = 0; i < SharedMetricsBlock::kWords; i++) {
+      words[i] = m_block->words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t after = m_block->sequence.load(std::memory_order_relaxed);
+    if (before == after) {
+      std::memcpy(&out, words, sizeof(words));
+      return true;
+    }
+  }
+  return false;
+}
+
+uint64_t MetricsReader::GetSequence() const {
+  return m_block == nullptr ? 0
+                            : m_block->sequence.load(std::memory_order_acquire);
+}
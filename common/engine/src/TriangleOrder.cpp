@@ -0,0 +1,241 @@
+#include "TriangleOrder.hpp"
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+const char *TriangleOrderName(TriangleOrder order) {
+  switch (order) {
+  case TriangleOrder::Random:
+    return "random";
+  case TriangleOrder::Morton:
+    return "morton";
+  case TriangleOrder::Hilbert:
+    return "hilbert";
+  case TriangleOrder::Adversarial:
+    return "adversarial";
+  }
+  return "?";
+}
+
+// ============================== Curves ===================================== //
+// Spreads 10 bits so that two zero bits follow each one
+static uint32_t SpreadBits(uint32_t v) {
+  v &= 0x3ff;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8)) & 0x0300f00f;
+  v = (v | (v << 4)) & 0x030c30c3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+uint32_t MortonKey(uint32_t x, uint32_t y, uint32_t z) {
+  return (SpreadBits(x) << 2) | (SpreadBits(y) << 1) | SpreadBits(z);
+}
+
+// Skilling, "Programming the Hilbert curve" (2004): the coordinates are
+// turned into the "transposed" Hilbert index, whose bits are then
+// interleaved like a Morton key.
+uint32_t HilbertKey(uint32_t x, uint32_t y, uint32_t z) {
+  const int kBits = 10;
+  uint32_t X[3] = {x & 0x3ff, y & 0x3ff, z & 0x3ff};
+  const uint32_t M = 1u << (kBits - 1);
+  // Inverse undo
+  for (uint32_t Q = M; Q > 1; Q >>= 1) {
+    uint32_t P = Q - 1;
+    for (int i = 0; i < 3; i++) {
+      if (X[i] & Q) {
+        X[0] ^= P; // Invert
+      } else {
+        uint32_t t = (X[0] ^ X[i]) & P; // Exchange
+        X[0] ^= t;
+        X[i] ^= t;
+      }
+    }
+  }
+  // Gray encode
+  for (int i = 1; i < 3; i++) {
+    X[i] ^= X[i - 1];
+  }
+  uint32_t t = 0;
+  for (uint32_t Q = M; Q > 1; Q >>= 1) {
+    if (X[2] & Q) {
+      t ^= Q - 1;
+    }
+  }
+  for (int i = 0; i < 3; i++) {
+    X[i] ^= t;
+  }
+  uint32_t key = 0;
+  for (int b = kBits - 1; b >= 0; b--) {
+    for (int i = 0; i < 3; i++) {
+      key = (key << 1) | ((X[i] >> b) & 1);
+    }
+  }
+  return key;
+}
+
+// ============================== Radix sort ================================= //
+void RadixSortPairs(std::vector<uint32_t> &keys, std::vector<uint32_t> &values,
+                    unsigned threads) {
+  const size_t count = keys.size();
+  if (count < 2) {
+    return;
+  }
+  // Threads only pay off on big arrays
+  if (threads == 0) {
+    threads = GetWorkerCount();
+  }
+  const size_t kMinPerThread = 1 << 16;
+  size_t blocks =
+      std::max<size_t>(1, std::min<size_t>(threads, count / kMinPerThread));
+  size_t blockSize = (count + blocks - 1) / blocks;
+
+  std::vector<uint32_t> keysOut(count), valuesOut(count);
+  std::vector<size_t> histograms(blocks * 256);
+  for (int shift = 0; shift < 32; shift += 8) {
+    // Every block counts its digits...
+    std::fill(histograms.begin(), histograms.end(), 0);
+    ParallelFor(
+        blocks, 1,
+        [&](size_t first, size_t last) {
+          for (size_t block = first; block < last; block++) {
+            size_t *histogram = &histograms[block * 256];
+            size_t end = std::min(count, (block + 1) * blockSize);
+            for (size_t i = block * blockSize; i < end; i++) {
+              histogram[(keys[i] >> shift) & 0xff]++;
+            }
+          }
+        },
+        static_cast<unsigned>(blocks));
+    // ...skip the pass if every key has the same digit...
+    size_t total = 0;
+    bool oneDigit = false;
+    for (int digit = 0; digit < 256 && !oneDigit; digit++) {
+      size_t sum = 0;
+      for (size_t block = 0; block < blocks; block++) {
+        sum += histograms[block * 256 + digit];
+      }
+      oneDigit = sum == count;
+    }
+    if (oneDigit) {
+      continue;
+    }
+    // ...turn the counts into where each block writes each digit
+    // (digit-major, then block, which keeps the sort stable)...
+    for (int digit = 0; digit < 256; digit++) {
+      for (size_t block = 0; block < blocks; block++) {
+        size_t n = histograms[block * 256 + digit];
+        histograms[block * 256 + digit] = total;
+        total += n;
+      }
+    }
+    // ...and scatters its part
+    ParallelFor(
+        blocks, 1,
+        [&](size_t first, size_t last) {
+          for (size_t block = first; block < last; block++) {
+            size_t *offsets = &histograms[block * 256];
+            size_t end = std::min(count, (block + 1) * blockSize);
+            for (size_t i = block * blockSize; i < end; i++) {
+              size_t to = offsets[(keys[i] >> shift) & 0xff]++;
+              keysOut[to] = keys[i];
+              valuesOut[to] = values[i];
+            }
+          }
+        },
+        static_cast<unsigned>(blocks));
+    keys.swap(keysOut);
+    values.swap(valuesOut);
+  }
+}
+
+// ============================== Orders ===================================== //
+// Triangle numbers sorted along a curve through their centroids
+static std::vector<uint32_t> CurveOrder(const uint32_t *indices, size_t count,
+                                        const PositionView &positions,
+                                        bool hilbert) {
+  size_t triangles = count / 3;
+  std::vector<float> centroids(triangles * 3);
+  float low[3] = {INFINITY, INFINITY, INFINITY};
+  float high[3] = {-INFINITY, -INFINITY, -INFINITY};
+  for (size_t t = 0; t < triangles; t++) {
+    for (int axis = 0; axis < 3; axis++) {
+      float c = (positions.Get(indices[3 * t])[axis] +
+                 positions.Get(indices[3 * t + 1])[axis] +
+                 positions.Get(indices[3 * t + 2])[axis]) /
+                3.0f;
+      centroids[3 * t + axis] = c;
+      low[axis] = std::min(low[axis], c);
+      high[axis] = std::max(high[axis], c);
+    }
+  }
+  // The same scale on every axis, so the curve is not stretched
+  float extent = std::max(high[0] - low[0],
+                          std::max(high[1] - low[1], high[2] - low[2]));
+  float scale = extent > 0.0f ? 1023.0f / extent : 0.0f;
+
+  std::vector<uint32_t> keys(triangles), order(triangles);
+  ParallelFor(triangles, 1 << 14, [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; t++) {
+      uint32_t q[3];
+      for (int axis = 0; axis < 3; axis++) {
+        q[axis] = static_cast<uint32_t>(
+            (centroids[3 * t + axis] - low[axis]) * scale + 0.5f);
+        q[axis] = std::min(q[axis], 1023u);
+      }
+      keys[t] = hilbert ? HilbertKey(q[0], q[1], q[2])
+                        : MortonKey(q[0], q[1], q[2]);
+      order[t] = static_cast<uint32_t>(t);
+    }
+  });
+  RadixSortPairs(keys, order);
+  return order;
+}
+
+void OrderTriangles(TriangleOrder order, const uint32_t *indices,
+                    size_t count, const PositionView &positions,
+                    uint32_t *out, uint64_t seed) {
+  size_t triangles = count / 3;
+  std::vector<uint32_t> sequence;
+  switch (order) {
+  case TriangleOrder::Random: {
+    sequence.resize(triangles);
+    for (size_t t = 0; t < triangles; t++) {
+      sequence[t] = static_cast<uint32_t>(t);
+    }
+    // Fisher-Yates with a fixed engine, so a seed gives the same order on
+    // every platform (std::shuffle's algorithm is not specified)
+    std::mt19937_64 rng(seed);
+    for (size_t t = triangles; t > 1; t--) {
+      size_t other = static_cast<size_t>(rng() % t);
+      std::swap(sequence[t - 1], sequence[other]);
+    }
+    break;
+  }
+  case TriangleOrder::Morton:
+  case TriangleOrder::Hilbert:
+    sequence = CurveOrder(indices, count, positions,
+                          order == TriangleOrder::Hilbert);
+    break;
+  case TriangleOrder::Adversarial: {
+    std::vector<uint32_t> morton = CurveOrder(indices, count, positions, false);
+    size_t columns = std::max<size_t>(
+        1, static_cast<size_t>(std::ceil(std::sqrt(double(triangles)))));
+    sequence.reserve(triangles);
+    for (size_t column = 0; column < columns; column++) {
+      for (size_t t = column; t < triangles; t += columns) {
+        sequence.push_back(morton[t]);
+      }
+    }
+    break;
+  }
+  }
+  for (size_t i = 0; i < triangles; i++) {
+    const uint32_t *triangle = indices + 3 * sequence[i];
+    out[3 * i] = triangle[0];
+    out[3 * i + 1] = triangle[1];
+    out[3 * i + 2] = triangle[2];
+  }
+}
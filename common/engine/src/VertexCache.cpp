@@ -0,0 +1,83 @@
+#include "VertexCache.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+const int VertexCacheModel::kMaxSize;
+
+std::string VertexCacheModelName(const VertexCacheModel &model) {
+  return (model.kind == VertexCacheKind::Fifo ? "fifo" : "lru") +
+         std::to_string(model.size);
+}
+
+bool ParseVertexCacheModel(const std::string &name, VertexCacheModel &out) {
+  std::string digits;
+  if (name.compare(0, 4, "fifo") == 0) {
+    out.kind = VertexCacheKind::Fifo;
+    digits = name.substr(4);
+  } else if (name.compare(0, 3, "lru") == 0) {
+    out.kind = VertexCacheKind::Lru;
+    digits = name.substr(3);
+  } else {
+    return false;
+  }
+  if (digits.empty() || digits.size() > 3 ||
+      digits.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+  out.size = std::atoi(digits.c_str());
+  return out.size >= 1 && out.size <= VertexCacheModel::kMaxSize;
+}
+
+VertexCacheStats SimulateVertexCache(const uint32_t *indices, size_t count,
+                                     size_t vertexCount,
+                                     const VertexCacheModel &model) {
+  VertexCacheStats stats;
+  stats.triangles = count / 3;
+  std::vector<bool> seen(vertexCount, false);
+
+  if (model.kind == VertexCacheKind::Fifo) {
+    // A vertex is in the cache if fewer than 'size' misses happened since
+    // it was loaded, so no queue has to be kept
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    for (size_t i = 0; i < count; i++) {
+      uint32_t v = indices[i];
+      if (!seen[v]) {
+        seen[v] = true;
+        stats.uniqueVertices++;
+      } else if (stats.misses - loadedAt[v] <=
+                 static_cast<size_t>(model.size)) {
+        continue; // Hit
+      }
+      stats.misses++;
+      loadedAt[v] = stats.misses - 1;
+    }
+    return stats;
+  }
+
+  // LRU: small, so a move-to-front array is fastest
+  uint32_t cache[VertexCacheModel::kMaxSize];
+  int used = 0;
+  for (size_t i = 0; i < count; i++) {
+    uint32_t v = indices[i];
+    if (!seen[v]) {
+      seen[v] = true;
+      stats.uniqueVertices++;
+    }
+    int slot = 0;
+    while (slot < used && cache[slot] != v) {
+      slot++;
+    }
+    if (slot == used) {
+      stats.misses++;
+      if (used < model.size) {
+        used++;
+      }
+      slot = used - 1; // Drops the least recently used one when full
+    }
+    std::copy_backward(cache, cache + slot, cache + slot + 1);
+    cache[0] = v;
+  }
+  return stats;
+}
@@ -0,0 +1,246 @@
+#include "VertexPulling.hpp"
+#include "GLState.hpp"
+#include "Impostor.hpp"
+#include "ResourceTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+const unsigned VertexPool::kVertexUnit;
+const unsigned VertexPool::kIndexUnit;
+
+// ============================== Packing ==================================== //
+static uint32_t ToFixed(float value) {
+  float clamped = std::min(1.0f, std::max(0.0f, value));
+  return static_cast<uint32_t>(std::lround(clamped * 65535.0f));
+}
+
+static float FromFixed(uint32_t fixed) {
+  return static_cast<float>(fixed & 0xFFFFu) / 65535.0f;
+}
+
+// (value - min) / scale as 16 bits; a flat axis is all zeros
+static uint32_t Quantize(float value, float min, float scale) {
+  return scale > 0.0f ? ToFixed((value - min) / scale) : 0u;
+}
+
+VertexQuantization PackVertices(const VertexStreams &streams,
+                                std::vector<PackedVertex> &out) {
+  VertexQuantization quantization;
+  out.assign(streams.vertexCount, PackedVertex());
+  if (streams.vertexCount == 0) {
+    return quantization;
+  }
+  // Bounds first
+  glm::vec3 positionMin(INFINITY), positionMax(-INFINITY);
+  glm::vec2 texMin(INFINITY), texMax(-INFINITY);
+  for (size_t i = 0; i < streams.vertexCount; i++) {
+    const float *vertex = streams.data + i * streams.stride;
+    glm::vec3 position(vertex[streams.position],
+                       vertex[streams.position + 1],
+                       vertex[streams.position + 2]);
+    positionMin = glm::min(positionMin, position);
+    positionMax = glm::max(positionMax, position);
+    if (streams.texCoord >= 0) {
+      glm::vec2 texCoord(vertex[streams.texCoord],
+                         vertex[streams.texCoord + 1]);
+      texMin = glm::min(texMin, texCoord);
+      texMax = glm::max(texMax, texCoord);
+    }
+  }
+  quantization.positionMin = positionMin;
+  quantization.positionScale = positionMax - positionMin;
+  if (streams.texCoord >= 0) {
+    quantization.texCoordMin = texMin;
+    quantization.texCoordScale = texMax - texMin;
+  }
+
+  const glm::vec3 &pMin = quantization.positionMin;
+  const glm::vec3 &pScale = quantization.positionScale;
+  const glm::vec2 &tMin = quantization.texCoordMin;
+  const glm::vec2 &tScale = quantization.texCoordScale;
+  for (size_t i = 0; i < streams.vertexCount; i++) {
+    const float *vertex = streams.data + i * streams.stride;
+    PackedVertex &packed = out[i];
+    const float *p = vertex + streams.position;
+    packed.positionXY = Quantize(p[0], pMin.x, pScale.x) |
+                        Quantize(p[1], pMin.y, pScale.y) << 16;
+    packed.positionZ = Quantize(p[2], pMin.z, pScale.z);
+    glm::vec3 normal(0.0f, 1.0f, 0.0f);
+    if (streams.normal >= 0) {
+      glm::vec3 n(vertex[streams.normal], vertex[streams.normal + 1],
+                  vertex[streams.normal + 2]);
+      if (glm::dot(n, n) > 0.0f) {
+        normal = n;
+      }
+    }
+    glm::vec2 octahedral = OctahedralEncode(normal);
+    packed.normal = ToFixed(octahedral.x) | ToFixed(octahedral.y) << 16;
+    if (streams.texCoord >= 0) {
+      const float *t = vertex + streams.texCoord;
+      packed.texCoord = Quantize(t[0], tMin.x, tScale.x) |
+                        Quantize(t[1], tMin.y, tScale.y) << 16;
+    }
+  }
+  return quantization;
+}
+
+glm::vec3 UnpackPosition(const PackedVertex &vertex,
+                         const VertexQuantization &quantization) {
+  glm::vec3 fixed(FromFixed(vertex.positionXY),
+                  FromFixed(vertex.positionXY >> 16),
+                  FromFixed(vertex.positionZ));
+  return quantization.positionMin + quantization.positionScale * fixed;
+}
+
+glm::vec3 UnpackNormal(const PackedVertex &vertex) {
+  return OctahedralDecode(
+      glm::vec2(FromFixed(vertex.normal), FromFixed(vertex.normal >> 16)));
+}
+
+glm::vec2 UnpackTexCoord(const PackedVertex &vertex,
+                         const VertexQuantization &quantization) {
+  glm::vec2 fixed(FromFixed(vertex.texCoord), FromFixed(vertex.texCoord >> 16));
+  return quantization.texCoordMin + quantization.texCoordScale * fixed;
+}
+
+PulledMeshBlock PulledMesh::GetBlock() const {
+  PulledMeshBlock block;
+  block.positionMin = glm::vec4(quantization.positionMin, 0.0f);
+  block.positionScale = glm::vec4(quantization.positionScale, 0.0f);
+  block.texCoord =
+      glm::vec4(quantization.texCoordMin, quantization.texCoordScale);
+  block.offsets = glm::ivec4(baseVertex, 0, 0, 0);
+  return block;
+}
+
+// ============================== Pool ======================================= //
+VertexPool::~VertexPool() { Release(); }
+
+bool VertexPool::Create() {
+  if (IsCreated()) {
+    return true;
+  }
+  GLint maxTexels = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+  m_maxTexels = static_cast<size_t>(std::max(0, maxTexels));
+  glGenVertexArrays(1, &m_vertexArray);
+  ResourceTracker::Instance().TrackGpu(GpuResourceKind::VertexArray,
+                                       m_vertexArray, 0, 0, "VertexPool");
+  m_vertexCount = m_indexCount = 0;
+  m_error.clear();
+  return true;
+}
+
+void VertexPool::ReleaseStore(Store &store) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.UntrackGpu(GpuResourceKind::Texture, store.texture);
+  tracker.UntrackGpu(GpuResourceKind::Buffer, store.buffer);
+  glDeleteTextures(1, &store.texture);
+  glDeleteBuffers(1, &store.buffer);
+  store = Store();
+}
+
+void VertexPool::Release() {
+  if (!IsCreated()) {
+    return;
+  }
+  ReleaseStore(m_vertices);
+  ReleaseStore(m_indices);
+  ResourceTracker::Instance().UntrackGpu(GpuResourceKind::VertexArray,
+                                         m_vertexArray);
+  glDeleteVertexArrays(1, &m_vertexArray);
+  m_vertexArray = 0;
+  m_vertexCount = m_indexCount = 0;
+}
+
+void VertexPool::Reserve(Store &store, size_t used, size_t count,
+                         size_t bytes, GLenum format, unsigned unit,
+                         const char *owner) {
+  if (count <= store.capacity) {
+    return;
+  }
+  size_t capacity =
+      std::max(count, std::max<size_t>(4096, 2 * store.capacity));
+  capacity = std::min(capacity, std::max(count, m_maxTexels));
+  GLState &state = GLState::Instance();
+  GLuint buffer = 0;
+  glGenBuffers(1, &buffer);
+  state.BindBuffer(GL_TEXTURE_BUFFER, buffer);
+  glBufferData(GL_TEXTURE_BUFFER, capacity * bytes, nullptr, GL_STATIC_DRAW);
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  if (store.buffer != 0) {
+    // Move what is there on the GPU; there is no CPU copy
+    state.BindBuffer(GL_COPY_READ_BUFFER, store.buffer);
+    state.BindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                        used * bytes);
+    tracker.UntrackGpu(GpuResourceKind::Buffer, store.buffer);
+    glDeleteBuffers(1, &store.buffer);
+  }
+  store.buffer = buffer;
+  store.capacity = capacity;
+  if (store.texture == 0) {
+    glGenTextures(1, &store.texture);
+    tracker.TrackGpu(GpuResourceKind::Texture, store.texture, 0, format,
+                     owner);
+  }
+  state.BindTexture(unit, GL_TEXTURE_BUFFER, store.texture);
+  glTexBuffer(GL_TEXTURE_BUFFER, format, store.buffer);
+  tracker.TrackGpu(GpuResourceKind::Buffer, store.buffer, capacity * bytes,
+                   GL_TEXTURE_BUFFER, owner);
+}
+
+PulledMesh VertexPool::Add(const std::vector<PackedVertex> &vertices,
+                           const uint32_t *indices, size_t indexCount,
+                           const VertexQuantization &quantization) {
+  PulledMesh mesh;
+  if (!IsCreated() || vertices.empty() || indexCount == 0) {
+    m_error = IsCreated() ? "empty mesh" : "the pool is not created";
+    return mesh;
+  }
+  if (m_vertexCount + vertices.size() > m_maxTexels ||
+      m_indexCount + indexCount > m_maxTexels) {
+    m_error = "the mesh does not fit (GL_MAX_TEXTURE_BUFFER_SIZE is " +
+              std::to_string(m_maxTexels) + " texels)";
+    return mesh;
+  }
+  Reserve(m_vertices, m_vertexCount, m_vertexCount + vertices.size(),
+          sizeof(PackedVertex), GL_RGBA32UI, kVertexUnit,
+          "VertexPool:vertices");
+  Reserve(m_indices, m_indexCount, m_indexCount + indexCount,
+          sizeof(uint32_t), GL_R32UI, kIndexUnit, "VertexPool:indices");
+  GLState &state = GLState::Instance();
+  state.BindBuffer(GL_TEXTURE_BUFFER, m_vertices.buffer);
+  glBufferSubData(GL_TEXTURE_BUFFER, m_vertexCount * sizeof(PackedVertex),
+                  vertices.size() * sizeof(PackedVertex), vertices.data());
+  state.BindBuffer(GL_TEXTURE_BUFFER, m_indices.buffer);
+  glBufferSubData(GL_TEXTURE_BUFFER, m_indexCount * sizeof(uint32_t),
+                  indexCount * sizeof(uint32_t), indices);
+
+  mesh.firstIndex = static_cast<uint32_t>(m_indexCount);
+  mesh.indexCount = static_cast<uint32_t>(indexCount);
+  mesh.baseVertex = static_cast<int32_t>(m_vertexCount);
+  mesh.quantization = quantization;
+  m_vertexCount += vertices.size();
+  m_indexCount += indexCount;
+  return mesh;
+}
+
+void VertexPool::Bind() const {
+  GLState::Instance().BindVertexArray(m_vertexArray);
+  BindBuffers();
+}
+
+void VertexPool::BindBuffers() const {
+  GLState &state = GLState::Instance();
+  state.BindTexture(kVertexUnit, GL_TEXTURE_BUFFER, m_vertices.texture);
+  state.BindTexture(kIndexUnit, GL_TEXTURE_BUFFER, m_indices.texture);
+}
+
+bool VertexPullingFromEnvironment() {
+  const char *mode = std::getenv("ENGINE_VERTEX_PULLING");
+  return mode != nullptr && std::strcmp(mode, "on") == 0;
+}
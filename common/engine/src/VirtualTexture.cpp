@@ -0,0 +1,943 @@
+#include "VirtualTexture.hpp"
+#include "GLState.hpp"
+#include "Parallel.hpp"
+#include "ResourceTracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+
+static const char kMagic[8] = {'C', 'S', '5', '3', '1', '0', 'V', 'T'};
+
+static bool Fail(std::string *error, const std::string &message) {
+  if (error != nullptr) {
+    *error = message;
+  }
+  return false;
+}
+
+static bool IsPowerOfTwo(uint32_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+uint32_t PageIndex(const VirtualTextureHeader &header, const PageId &page) {
+  uint32_t index = 0;
+  for (uint32_t level = 0; level < page.level; level++) {
+    uint32_t side = PagesPerSide(header, level);
+    index += side * side;
+  }
+  return index + page.y * PagesPerSide(header, page.level) + page.x;
+}
+
+bool PageOffset(const VirtualTextureHeader &header, const PageId &page,
+                uint64_t &offset) {
+  if (page.level >= header.levels ||
+      page.x >= PagesPerSide(header, page.level) ||
+      page.y >= PagesPerSide(header, page.level)) {
+    return false;
+  }
+  offset = sizeof(VirtualTextureHeader) +
+           uint64_t(PageIndex(header, page)) * PageBytes(header);
+  return true;
+}
+
+// ================================ Cooking ================================= //
+// Bilinear lookup of an RGB8 image, texel centers at half texels
+static void SampleBilinear(const uint8_t *rgb, uint32_t width,
+                           uint32_t height, float u, float v, bool repeat,
+                           float out[3]) {
+  float x = u * static_cast<float>(width) - 0.5f;
+  float y = v * static_cast<float>(height) - 0.5f;
+  float x0f = std::floor(x), y0f = std::floor(y);
+  float fx = x - x0f, fy = y - y0f;
+  long x0 = static_cast<long>(x0f), y0 = static_cast<long>(y0f);
+  auto wrap = [repeat](long i, uint32_t n) {
+    long size = static_cast<long>(n);
+    if (repeat) {
+      return static_cast<size_t>(((i % size) + size) % size);
+    }
+    return static_cast<size_t>(std::max(0L, std::min(i, size - 1)));
+  };
+  size_t xs[2] = {wrap(x0, width), wrap(x0 + 1, width)};
+  size_t ys[2] = {wrap(y0, height), wrap(y0 + 1, height)};
+  float weights[4] = {(1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy,
+                      fx * fy};
+  for (int c = 0; c < 3; c++) {
+    out[c] = 0.0f;
+  }
+  for (int k = 0; k < 4; k++) {
+    const uint8_t *texel = rgb + (ys[k >> 1] * width + xs[k & 1]) * 3;
+    for (int c = 0; c < 3; c++) {
+      out[c] += weights[k] * static_cast<float>(texel[c]);
+    }
+  }
+}
+
+void ComposeDetailTexture(const uint8_t *color, uint32_t colorWidth,
+                          uint32_t colorHeight, const uint8_t *detail,
+                          uint32_t detailWidth, uint32_t detailHeight,
+                          uint32_t detailRepeat, uint32_t size,
+                          std::vector<uint8_t> &out) {
+  double sums[3] = {0.0, 0.0, 0.0};
+  size_t detailTexels = size_t(detailWidth) * detailHeight;
+  for (size_t i = 0; i < detailTexels; i++) {
+    for (int c = 0; c < 3; c++) {
+      sums[c] += detail[i * 3 + c];
+    }
+  }
+  float scale[3];
+  for (int c = 0; c < 3; c++) {
+    double mean =
+        sums[c] / static_cast<double>(std::max<size_t>(1, detailTexels));
+    scale[c] = 0.5f / static_cast<float>(std::max(mean, 1.0));
+  }
+
+  out.resize(size_t(size) * size * 3);
+  float repeat = static_cast<float>(detailRepeat);
+  ParallelFor(size, 64, [&](size_t begin, size_t end) {
+    for (size_t y = begin; y < end; y++) {
+      float v = (static_cast<float>(y) + 0.5f) / static_cast<float>(size);
+      uint8_t *row = out.data() + y * size * 3;
+      for (uint32_t x = 0; x < size; x++) {
+        float u = (static_cast<float>(x) + 0.5f) / static_cast<float>(size);
+        float base[3], fine[3];
+        SampleBilinear(color, colorWidth, colorHeight, u, v, false, base);
+        SampleBilinear(detail, detailWidth, detailHeight, u * repeat,
+                       v * repeat, true, fine);
+        for (int c = 0; c < 3; c++) {
+          float value = base[c] * (0.5f + fine[c] * scale[c]);
+          row[x * 3 + c] =
+              static_cast<uint8_t>(std::min(255.0f, value + 0.5f));
+        }
+      }
+    }
+  });
+}
+
+// Each texel the mean of the 2 x 2 below it
+static void Downsample(const uint8_t *source, uint32_t sourceSize,
+                       std::vector<uint8_t> &out) {
+  uint32_t size = sourceSize / 2;
+  out.resize(size_t(size) * size * 3);
+  for (uint32_t y = 0; y < size; y++) {
+    const uint8_t *rows[2] = {source + size_t(2 * y) * sourceSize * 3,
+                              source + size_t(2 * y + 1) * sourceSize * 3};
+    for (uint32_t x = 0; x < size; x++) {
+      for (int c = 0; c < 3; c++) {
+        unsigned sum = rows[0][6 * x + c] + rows[0][6 * x + 3 + c] +
+                       rows[1][6 * x + c] + rows[1][6 * x + 3 + c];
+        out[(size_t(y) * size + x) * 3 + c] =
+            static_cast<uint8_t>((sum + 2) / 4);
+      }
+    }
+  }
+}
+
+// One page of a level and its border, clamped at the level's edges
+static void CutPage(const uint8_t *level, uint32_t levelSize,
+                    const VirtualTextureHeader &header, uint32_t pageX,
+                    uint32_t pageY, uint8_t *out) {
+  long side = header.pageSize + 2 * header.border;
+  long last = static_cast<long>(levelSize) - 1;
+  for (long j = 0; j < side; j++) {
+    long y = static_cast<long>(pageY * header.pageSize) - header.border + j;
+    y = std::max(0L, std::min(y, last));
+    for (long i = 0; i < side; i++) {
+      long x = static_cast<long>(pageX * header.pageSize) - header.border + i;
+      x = std::max(0L, std::min(x, last));
+      std::memcpy(out + (j * side + i) * 3, level + (y * levelSize + x) * 3,
+                  3);
+    }
+  }
+}
+
+bool WriteVirtualTexture(const std::string &path, const uint8_t *rgb,
+                         uint32_t size, uint32_t pageSize, uint32_t border,
+                         std::string *error) {
+  if (pageSize == 0 || size % pageSize != 0 ||
+      !IsPowerOfTwo(size / pageSize) || size / pageSize > kMaxVirtualPages) {
+    return Fail(error, "the size must be the page size times a power of two "
+                       "up to " + std::to_string(kMaxVirtualPages));
+  }
+  if (border > pageSize) {
+    return Fail(error, "the border is wider than a page");
+  }
+  VirtualTextureHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVirtualTextureVersion;
+  header.size = size;
+  header.pageSize = pageSize;
+  header.border = border;
+  for (uint32_t pages = size / pageSize; pages > 0; pages /= 2) {
+    header.levels++;
+    header.pageCount += pages * pages;
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return Fail(error, "could not create " + path);
+  }
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  std::vector<uint8_t> page(PageBytes(header));
+  std::vector<uint8_t> levels[2];
+  const uint8_t *level = rgb;
+  uint32_t levelSize = size;
+  for (uint32_t l = 0; l < header.levels; l++) {
+    if (l > 0) {
+      std::vector<uint8_t> &next = levels[l % 2];
+      Downsample(level, levelSize, next);
+      level = next.data();
+      levelSize /= 2;
+    }
+    uint32_t pages = PagesPerSide(header, l);
+    for (uint32_t y = 0; y < pages; y++) {
+      for (uint32_t x = 0; x < pages; x++) {
+        CutPage(level, levelSize, header, x, y, page.data());
+        file.write(reinterpret_cast<const char *>(page.data()),
+                   static_cast<std::streamsize>(page.size()));
+      }
+    }
+  }
+  file.close();
+  if (!file) {
+    std::remove(path.c_str());
+    return Fail(error, "could not write " + path);
+  }
+  return true;
+}
+
+// =========================== VirtualTextureFile =========================== //
+bool VirtualTextureFile::Open(const std::string &path, std::string *error) {
+  Close();
+  m_file.open(path, std::ios::binary);
+  if (!m_file) {
+    return Fail(error, "could not open " + path);
+  }
+  VirtualTextureHeader header{};
+  m_file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  m_file.seekg(0, std::ios::end);
+  uint64_t fileSize = static_cast<uint64_t>(m_file.tellg());
+  bool valid = m_file && std::memcmp(header.magic, kMagic, 8) == 0 &&
+               header.version == kVirtualTextureVersion &&
+               header.pageSize > 0 && header.border <= header.pageSize &&
+               header.size % header.pageSize == 0 &&
+               IsPowerOfTwo(header.size / header.pageSize) &&
+               header.size / header.pageSize <= kMaxVirtualPages &&
+               header.levels > 0 && header.levels <= 32 &&
+               (header.size / header.pageSize) >> (header.levels - 1) == 1;
+  if (valid) {
+    uint32_t pages = 0;
+    for (uint32_t level = 0; level < header.levels; level++) {
+      pages += PagesPerSide(header, level) * PagesPerSide(header, level);
+    }
+    valid = pages == header.pageCount &&
+            fileSize == sizeof(header) + uint64_t(pages) * PageBytes(header);
+  }
+  if (!valid) {
+    Close();
+    return Fail(error, path + " is not a virtual texture page file");
+  }
+  m_header = header;
+  return true;
+}
+
+void VirtualTextureFile::Close() {
+  if (m_file.is_open()) {
+    m_file.close();
+  }
+  m_file.clear();
+  m_header = VirtualTextureHeader{};
+}
+
+bool VirtualTextureFile::ReadPage(const PageId &page, uint8_t *out) {
+  uint64_t offset = 0;
+  if (!IsOpen() || !PageOffset(m_header, page, offset)) {
+    return false;
+  }
+  m_file.clear();
+  m_file.seekg(static_cast<std::streamoff>(offset));
+  m_file.read(reinterpret_cast<char *>(out),
+              static_cast<std::streamsize>(PageBytes(m_header)));
+  return static_cast<bool>(m_file);
+}
+
+// ================================ Feedback ================================ //
+void CollectFeedbackPages(const uint8_t *rgba, size_t pixels,
+                          const VirtualTextureHeader &header,
+                          std::vector<PageId> &pages) {
+  std::vector<uint32_t> keys;
+  uint32_t last = 0xffffffffu; // Neighbouring pixels mostly agree
+  for (size_t i = 0; i < pixels; i++) {
+    const uint8_t *texel = rgba + i * 4;
+    if (texel[3] == 0) {
+      continue;
+    }
+    PageId page;
+    page.x = texel[0];
+    page.y = texel[1];
+    page.level = texel[2];
+    if (page.level >= header.levels ||
+        page.x >= PagesPerSide(header, page.level) ||
+        page.y >= PagesPerSide(header, page.level)) {
+      continue;
+    }
+    uint32_t key = PageKey(page);
+    if (key != last) {
+      keys.push_back(key);
+      last = key;
+    }
+  }
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  // The coarser pages the shader falls back to while these are missing
+  size_t seen = keys.size();
+  for (size_t i = 0; i < seen; i++) {
+    PageId page = PageFromKey(keys[i]);
+    while (page.level + 1 < header.levels) {
+      page.x /= 2;
+      page.y /= 2;
+      page.level++;
+      keys.push_back(PageKey(page));
+    }
+  }
+  std::sort(keys.begin(), keys.end(), std::greater<uint32_t>());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  pages.clear();
+  pages.reserve(keys.size());
+  for (uint32_t key : keys) {
+    pages.push_back(PageFromKey(key));
+  }
+}
+
+// ============================ VirtualPageCache ============================ //
+void VirtualPageCache::Reset(uint32_t pagesPerSide, uint32_t levels,
+                             uint32_t slotsPerSide) {
+  m_pagesPerSide = pagesPerSide;
+  m_levels = levels;
+  m_slotsPerSide = slotsPerSide;
+  m_slots.assign(size_t(slotsPerSide) * slotsPerSide, Slot());
+  m_resident.clear();
+  m_tables.assign(levels, std::vector<uint8_t>());
+  for (uint32_t level = 0; level < levels; level++) {
+    uint32_t side = std::max(1u, pagesPerSide >> level);
+    m_tables[level].assign(size_t(side) * side * 4, 0);
+  }
+  m_frame = 0;
+  m_tablesStale = false;
+  m_changed = true;
+}
+
+void VirtualPageCache::Touch(const std::vector<PageId> &pages,
+                             std::vector<PageId> &missing) {
+  m_frame++;
+  for (const PageId &page : pages) {
+    auto found = m_resident.find(PageKey(page));
+    if (found != m_resident.end()) {
+      m_slots[found->second].lastSeen = m_frame;
+    } else {
+      missing.push_back(page);
+    }
+  }
+}
+
+bool VirtualPageCache::Insert(const PageId &page, uint32_t &slot,
+                              PageId *evicted) {
+  uint32_t key = PageKey(page);
+  auto found = m_resident.find(key);
+  if (found != m_resident.end()) {
+    slot = found->second;
+    m_slots[slot].lastSeen = m_frame;
+    return true;
+  }
+  // A free slot, or else the least recently seen one
+  const uint32_t none = 0xffffffffu;
+  uint32_t chosen = none;
+  for (uint32_t i = 0; i < m_slots.size(); i++) {
+    const Slot &candidate = m_slots[i];
+    if (!candidate.used) {
+      chosen = i;
+      break;
+    }
+    if (candidate.lastSeen >= m_frame ||
+        PageFromKey(candidate.key).level + 1 == m_levels) {
+      continue;
+    }
+    if (chosen == none || candidate.lastSeen < m_slots[chosen].lastSeen) {
+      chosen = i;
+    }
+  }
+  if (chosen == none) {
+    return false;
+  }
+  Slot &target = m_slots[chosen];
+  if (target.used) {
+    m_resident.erase(target.key);
+    if (evicted != nullptr) {
+      *evicted = PageFromKey(target.key);
+    }
+  }
+  target.key = key;
+  target.lastSeen = m_frame;
+  target.used = true;
+  m_resident[key] = chosen;
+  slot = chosen;
+  m_tablesStale = true;
+  m_changed = true;
+  return true;
+}
+
+int VirtualPageCache::FindSlot(const PageId &page) const {
+  auto found = m_resident.find(PageKey(page));
+  return found == m_resident.end() ? -1 : static_cast<int>(found->second);
+}
+
+const std::vector<uint8_t> &VirtualPageCache::GetTable(uint32_t level) {
+  if (m_tablesStale) {
+    RebuildTables();
+  }
+  return m_tables[level];
+}
+
+bool VirtualPageCache::TakeChanged() {
+  bool changed = m_changed;
+  m_changed = false;
+  return changed;
+}
+
+// Coarsest level first, so every page can start from its parent's entry
+void VirtualPageCache::RebuildTables() {
+  for (uint32_t l = m_levels; l-- > 0;) {
+    uint32_t side = std::max(1u, m_pagesPerSide >> l);
+    std::vector<uint8_t> &table = m_tables[l];
+    for (uint32_t y = 0; y < side; y++) {
+      for (uint32_t x = 0; x < side; x++) {
+        uint8_t *entry = table.data() + (size_t(y) * side + x) * 4;
+        PageId page;
+        page.x = x;
+        page.y = y;
+        page.level = l;
+        auto found = m_resident.find(PageKey(page));
+        if (found != m_resident.end()) {
+          entry[0] = static_cast<uint8_t>(found->second % m_slotsPerSide);
+          entry[1] = static_cast<uint8_t>(found->second / m_slotsPerSide);
+          entry[2] = static_cast<uint8_t>(l);
+          entry[3] = 255;
+        } else if (l + 1 < m_levels) {
+          uint32_t parentSide = std::max(1u, m_pagesPerSide >> (l + 1));
+          const uint8_t *parent =
+              m_tables[l + 1].data() +
+              (size_t(y / 2) * parentSide + x / 2) * 4;
+          std::memcpy(entry, parent, 4);
+        } else {
+          std::memset(entry, 0, 4);
+        }
+      }
+    }
+  }
+  m_tablesStale = false;
+}
+
+// ============================== PageStreamer ============================== //
+PageStreamer::~PageStreamer() { Stop(); }
+
+bool PageStreamer::Start(const std::string &path, std::string *error) {
+  Stop();
+  // Only the header is read here; the pages are read by ranges
+  VirtualTextureFile file;
+  if (!file.Open(path, error)) {
+    return false;
+  }
+  if (m_reader == nullptr) {
+    m_reader = &AsyncFileReader::Instance();
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_path = path;
+  m_header = file.GetHeader();
+  m_started = true;
+  return true;
+}
+
+void PageStreamer::Stop() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_started = false;
+  m_queue.clear();
+  // The callbacks of the reads in flight still use us
+  m_idle.wait(lock, [this] { return m_reading.empty(); });
+  m_busy.clear();
+  m_loaded.clear();
+}
+
+void PageStreamer::SetRequests(const std::vector<PageId> &pages) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_queue.clear();
+  for (const PageId &page : pages) {
+    if (m_busy.count(PageKey(page)) == 0) {
+      m_queue.push_back(page);
+    }
+  }
+  IssueReads();
+}
+
+void PageStreamer::TakeLoaded(std::vector<LoadedPage> &pages) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (LoadedPage &loaded : m_loaded) {
+    m_busy.erase(PageKey(loaded.page));
+    pages.push_back(std::move(loaded));
+  }
+  m_loaded.clear();
+}
+
+size_t PageStreamer::GetPending() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_queue.size() + m_busy.size();
+}
+
+uint64_t PageStreamer::GetBytesRead() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_bytesRead;
+}
+
+uint64_t PageStreamer::GetFailures() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_failures;
+}
+
+void PageStreamer::IssueReads() {
+  while (m_started && m_reading.size() < kPagesInFlight &&
+         !m_queue.empty()) {
+    PageId page = m_queue.front();
+    m_queue.pop_front();
+    uint64_t offset = 0;
+    if (!PageOffset(m_header, page, offset)) {
+      m_failures++;
+      continue;
+    }
+    m_reading.emplace_back(new Read());
+    Read *read = m_reading.back().get();
+    read->loaded.page = page;
+    m_busy.insert(PageKey(page));
+    m_reader->ReadRange(
+        m_path, offset, PageBytes(m_header),
+        [this, read](FileReadResult &result) { Finish(*read, result); });
+  }
+}
+
+void PageStreamer::Finish(Read &read, FileReadResult &result) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  read.done = true;
+  read.ok = result.ok;
+  read.loaded.pixels.assign(result.data.begin(), result.data.end());
+  // Handed over in the order asked for, so the coarse pages come first
+  while (!m_reading.empty() && m_reading.front()->done) {
+    std::unique_ptr<Read> front = std::move(m_reading.front());
+    m_reading.pop_front();
+    uint32_t key = PageKey(front->loaded.page);
+    if (!m_started) {
+      m_busy.erase(key);
+    } else if (front->ok) {
+      m_bytesRead += front->loaded.pixels.size();
+      m_loaded.push_back(std::move(front->loaded));
+    } else {
+      // Asked for again by a later frame
+      m_failures++;
+      m_busy.erase(key);
+    }
+  }
+  IssueReads();
+  // Under the lock: Stop() may destroy us as soon as it returns
+  if (m_reading.empty()) {
+    m_idle.notify_all();
+  }
+}
+
+// ============================= VirtualTexture ============================= //
+VirtualTexture::~VirtualTexture() { Release(); }
+
+bool VirtualTexture::Create(const std::string &path, uint32_t slotsPerSide,
+                            std::string *error) {
+  Release();
+  VirtualTextureFile file;
+  if (!file.Open(path, error)) {
+    return false;
+  }
+  m_header = file.GetHeader();
+  uint32_t stride = m_header.pageSize + 2 * m_header.border;
+  GLint maxSize = 0;
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+  if (slotsPerSide == 0 || slotsPerSide > kMaxVirtualPages ||
+      static_cast<GLint>(slotsPerSide * stride) > maxSize) {
+    return Fail(error, "a cache of " + std::to_string(slotsPerSide) + " x " +
+                           std::to_string(slotsPerSide) +
+                           " pages does not fit in one texture");
+  }
+
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  GLState &state = GLState::Instance();
+  // The pages, filtered within their borders
+  GLsizei cacheSide = static_cast<GLsizei>(slotsPerSide * stride);
+  glGenTextures(1, &m_cacheTexture);
+  state.BindTexture(0, GL_TEXTURE_2D, m_cacheTexture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, cacheSide, cacheSide, 0, GL_RGB,
+               GL_UNSIGNED_BYTE, nullptr);
+  tracker.TrackGpu(GpuResourceKind::Texture, m_cacheTexture,
+                   ResourceTracker::TextureBytes(cacheSide, cacheSide, 3,
+                                                 false),
+                   GL_RGB8, "VirtualTexture:cache");
+
+  // One mip level of the page table per level of the texture
+  uint32_t pages = PagesPerSide(m_header, 0);
+  glGenTextures(1, &m_tableTexture);
+  state.BindTexture(0, GL_TEXTURE_2D, m_tableTexture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                  static_cast<GLint>(m_header.levels - 1));
+  for (uint32_t level = 0; level < m_header.levels; level++) {
+    GLsizei side = static_cast<GLsizei>(PagesPerSide(m_header, level));
+    glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), GL_RGBA8, side,
+                 side, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  }
+  tracker.TrackGpu(GpuResourceKind::Texture, m_tableTexture,
+                   ResourceTracker::TextureBytes(static_cast<int>(pages),
+                                                 static_cast<int>(pages), 4,
+                                                 true),
+                   GL_RGBA8, "VirtualTexture:table");
+
+  // Something to fall back to from the first frame on
+  m_pages.Reset(pages, m_header.levels, slotsPerSide);
+  PageId top;
+  top.level = m_header.levels - 1;
+  std::vector<uint8_t> pixels(PageBytes(m_header));
+  uint32_t slot = 0;
+  if (!file.ReadPage(top, pixels.data()) || !m_pages.Insert(top, slot)) {
+    Release();
+    return Fail(error, "could not read " + path);
+  }
+  UploadPage(slot, pixels.data());
+  m_pages.TakeChanged();
+  UploadTable();
+  if (!m_streamer.Start(path, error)) {
+    Release();
+    return false;
+  }
+  return true;
+}
+
+void VirtualTexture::Release() {
+  m_streamer.Stop();
+  m_loaded.clear();
+  if (!IsCreated()) {
+    return;
+  }
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.UntrackGpu(GpuResourceKind::Texture, m_cacheTexture);
+  tracker.UntrackGpu(GpuResourceKind::Texture, m_tableTexture);
+  glDeleteTextures(1, &m_cacheTexture);
+  glDeleteTextures(1, &m_tableTexture);
+  m_cacheTexture = 0;
+  m_tableTexture = 0;
+  m_missing = 0;
+  m_uploaded = m_evicted = m_dropped = 0;
+}
+
+void VirtualTexture::Request(const std::vector<PageId> &pages) {
+  if (!IsCreated()) {
+    return;
+  }
+  std::vector<PageId> missing;
+  m_pages.Touch(pages, missing);
+  m_missing = missing.size();
+  // Pages read but not uploaded yet are not read again
+  if (!m_loaded.empty()) {
+    std::unordered_set<uint32_t> loaded;
+    for (const LoadedPage &page : m_loaded) {
+      loaded.insert(PageKey(page.page));
+    }
+    missing.erase(std::remove_if(missing.begin(), missing.end(),
+                                 [&](const PageId &page) {
+                                   return loaded.count(PageKey(page)) != 0;
+                                 }),
+                  missing.end());
+  }
+  m_streamer.SetRequests(missing);
+}
+
+bool VirtualTexture::Update(uint32_t maxUploads) {
+  if (!IsCreated()) {
+    return false;
+  }
+  m_streamer.TakeLoaded(m_loaded);
+  size_t count = std::min<size_t>(m_loaded.size(), maxUploads);
+  for (size_t i = 0; i < count; i++) {
+    uint32_t slot = 0;
+    PageId evicted;
+    evicted.level = m_header.levels; // No page
+    if (!m_pages.Insert(m_loaded[i].page, slot, &evicted)) {
+      m_dropped++;
+      continue;
+    }
+    if (evicted.level < m_header.levels) {
+      m_evicted++;
+    }
+    UploadPage(slot, m_loaded[i].pixels.data());
+    m_uploaded++;
+  }
+  m_loaded.erase(m_loaded.begin(),
+                 m_loaded.begin() + static_cast<std::ptrdiff_t>(count));
+  if (!m_pages.TakeChanged()) {
+    return false;
+  }
+  UploadTable();
+  return true;
+}
+
+bool VirtualTexture::IsStreaming() const {
+  return !m_loaded.empty() || m_streamer.GetPending() > 0;
+}
+
+void VirtualTexture::UploadPage(uint32_t slot, const uint8_t *pixels) {
+  GLsizei stride =
+      static_cast<GLsizei>(m_header.pageSize + 2 * m_header.border);
+  uint32_t slotsPerSide = m_pages.GetSlotsPerSide();
+  GLState::Instance().BindTexture(0, GL_TEXTURE_2D, m_cacheTexture);
+  // RGB8 rows are not always a multiple of 4 bytes
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexSubImage2D(GL_TEXTURE_2D, 0,
+                  static_cast<GLint>(slot % slotsPerSide) * stride,
+                  static_cast<GLint>(slot / slotsPerSide) * stride, stride,
+                  stride, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+void VirtualTexture::UploadTable() {
+  GLState::Instance().BindTexture(0, GL_TEXTURE_2D, m_tableTexture);
+  for (uint32_t level = 0; level < m_header.levels; level++) {
+    GLsizei side = static_cast<GLsizei>(PagesPerSide(m_header, level));
+    glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), 0, 0, side,
+                    side, GL_RGBA, GL_UNSIGNED_BYTE,
+                    m_pages.GetTable(level).data());
+  }
+}
+
+VirtualTextureBlock VirtualTexture::GetBlock() const {
+  VirtualTextureBlock block;
+  float slots = static_cast<float>(m_pages.GetSlotsPerSide());
+  float stride = static_cast<float>(m_header.pageSize + 2 * m_header.border);
+  block.layout = glm::vec4(static_cast<float>(m_header.size),
+                           static_cast<float>(PagesPerSide(m_header, 0)),
+                           static_cast<float>(m_header.levels),
+                           std::log2(static_cast<float>(m_feedbackScale)));
+  block.cache = glm::vec4(static_cast<float>(m_header.pageSize),
+                          static_cast<float>(m_header.border), slots,
+                          slots * stride);
+  return block;
+}
+
+VirtualTextureStats VirtualTexture::GetStats() const {
+  VirtualTextureStats stats;
+  if (!IsCreated()) {
+    return stats;
+  }
+  uint32_t slotsPerSide = m_pages.GetSlotsPerSide();
+  int cacheSide = static_cast<int>(
+      slotsPerSide * (m_header.pageSize + 2 * m_header.border));
+  int pages = static_cast<int>(PagesPerSide(m_header, 0));
+  stats.resident = m_pages.GetResidentCount();
+  stats.slots = size_t(slotsPerSide) * slotsPerSide;
+  stats.missing = m_missing;
+  stats.pending = m_streamer.GetPending() + m_loaded.size();
+  stats.uploaded = m_uploaded;
+  stats.evicted = m_evicted;
+  stats.dropped = m_dropped;
+  stats.bytesRead = m_streamer.GetBytesRead();
+  stats.cacheBytes = ResourceTracker::TextureBytes(cacheSide, cacheSide, 3,
+                                                   false);
+  stats.tableBytes = ResourceTracker::TextureBytes(pages, pages, 4, true);
+  for (uint32_t level = 0; level < m_header.levels; level++) {
+    uint64_t side = m_header.size >> level;
+    stats.virtualBytes += side * side * 3;
+  }
+  return stats;
+}
+
+static double Megabytes(uint64_t bytes) {
+  return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+void VirtualTexture::PrintReport(std::ostream &out) const {
+  VirtualTextureStats stats = GetStats();
+  std::ios::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(1);
+  out << "Virtual texture: " << m_header.size << " x " << m_header.size
+      << ", " << m_header.levels << " levels of " << m_header.pageSize
+      << " texel pages\n";
+  out << "  cache: " << stats.resident << " of " << stats.slots
+      << " pages, " << Megabytes(stats.cacheBytes + stats.tableBytes)
+      << " MB with the page table (the whole texture is "
+      << Megabytes(stats.virtualBytes) << " MB)\n";
+  out << "  streamed: " << stats.uploaded << " pages ("
+      << Megabytes(stats.bytesRead) << " MB read), " << stats.evicted
+      << " evicted, " << stats.dropped << " dropped, " << stats.pending
+      << " pending, " << stats.missing << " missing in the last feedback\n";
+  out.flags(flags);
+}
+
+// ========================= VirtualTextureFeedback ========================= //
+VirtualTextureFeedback::~VirtualTextureFeedback() { Release(); }
+
+bool VirtualTextureFeedback::Create(int width, int height, int scale) {
+  Release();
+  m_scale = std::max(1, scale);
+  m_width = std::max(1, width / m_scale);
+  m_height = std::max(1, height / m_scale);
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  GLState &state = GLState::Instance();
+
+  glGenRenderbuffers(2, m_renderbuffers);
+  const GLenum formats[2] = {GL_RGBA8, GL_DEPTH_COMPONENT24};
+  for (int i = 0; i < 2; i++) {
+    glBindRenderbuffer(GL_RENDERBUFFER, m_renderbuffers[i]);
+    glRenderbufferStorage(GL_RENDERBUFFER, formats[i], m_width, m_height);
+    tracker.TrackGpu(GpuResourceKind::Renderbuffer, m_renderbuffers[i],
+                     size_t(m_width) * m_height * 4, formats[i],
+                     "VirtualTextureFeedback");
+  }
+  glGenFramebuffers(1, &m_framebuffer);
+  state.BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, m_renderbuffers[0]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, m_renderbuffers[1]);
+  bool complete =
+      glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+  state.BindFramebuffer(GL_FRAMEBUFFER, 0);
+  tracker.TrackGpu(GpuResourceKind::Framebuffer, m_framebuffer, 0, 0,
+                   "VirtualTextureFeedback");
+
+  size_t bytes = size_t(m_width) * m_height * 4;
+  glGenBuffers(kBuffers, m_pixelBuffers);
+  for (int i = 0; i < kBuffers; i++) {
+    state.BindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[i]);
+    glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(bytes),
+                 nullptr, GL_STREAM_READ);
+    tracker.TrackGpu(GpuResourceKind::Buffer, m_pixelBuffers[i], bytes,
+                     GL_PIXEL_PACK_BUFFER, "VirtualTextureFeedback");
+  }
+  state.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  if (!complete) {
+    Release();
+  }
+  return complete;
+}
+
+void VirtualTextureFeedback::Release() {
+  if (!IsCreated()) {
+    return;
+  }
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  for (int i = 0; i < kBuffers; i++) {
+    if (m_fences[i] != nullptr) {
+      glDeleteSync(m_fences[i]);
+      m_fences[i] = nullptr;
+    }
+    tracker.UntrackGpu(GpuResourceKind::Buffer, m_pixelBuffers[i]);
+  }
+  glDeleteBuffers(kBuffers, m_pixelBuffers);
+  for (int i = 0; i < 2; i++) {
+    tracker.UntrackGpu(GpuResourceKind::Renderbuffer, m_renderbuffers[i]);
+  }
+  glDeleteRenderbuffers(2, m_renderbuffers);
+  tracker.UntrackGpu(GpuResourceKind::Framebuffer, m_framebuffer);
+  glDeleteFramebuffers(1, &m_framebuffer);
+  for (int i = 0; i < kBuffers; i++) {
+    m_pixelBuffers[i] = 0;
+  }
+  m_renderbuffers[0] = m_renderbuffers[1] = 0;
+  m_framebuffer = 0;
+  m_next = 0;
+}
+
+void VirtualTextureFeedback::Begin() {
+  GLState &state = GLState::Instance();
+  state.BindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  state.Viewport(0, 0, m_width, m_height);
+  state.ClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void VirtualTextureFeedback::End() {
+  GLState &state = GLState::Instance();
+  int slot = m_next;
+  // Never polled: this one is newer anyway
+  if (m_fences[slot] != nullptr) {
+    glDeleteSync(m_fences[slot]);
+  }
+  state.BindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[slot]);
+  glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  state.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  m_fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  m_next = (slot + 1) % kBuffers;
+}
+
+bool VirtualTextureFeedback::Poll(const VirtualTextureHeader &header,
+                                  std::vector<PageId> &pages) {
+  // The newest finished readback; older ones are not needed any more
+  int newest = -1;
+  for (int k = 0; k < kBuffers; k++) {
+    int i = (m_next + k) % kBuffers;
+    if (m_fences[i] == nullptr) {
+      continue;
+    }
+    GLenum status = glClientWaitSync(m_fences[i], 0, 0);
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+      break;
+    }
+    if (newest >= 0) {
+      glDeleteSync(m_fences[newest]);
+      m_fences[newest] = nullptr;
+    }
+    newest = i;
+  }
+  if (newest < 0) {
+    return false;
+  }
+  glDeleteSync(m_fences[newest]);
+  m_fences[newest] = nullptr;
+  GLState &state = GLState::Instance();
+  size_t pixels = size_t(m_width) * m_height;
+  state.BindBuffer(GL_PIXEL_PACK_BUFFER, m_pixelBuffers[newest]);
+  const void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                      static_cast<GLsizeiptr>(pixels * 4),
+                                      GL_MAP_READ_BIT);
+  bool mapped = data != nullptr;
+  if (mapped) {
+    CollectFeedbackPages(static_cast<const uint8_t *>(data), pixels, header,
+                         pages);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  }
+  state.BindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  return mapped;
+}
+
+bool VirtualTextureFeedback::IsPending() const {
+  for (int i = 0; i < kBuffers; i++) {
+    if (m_fences[i] != nullptr) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool VirtualTextureFromEnvironment() {
+  const char *mode = std::getenv("ENGINE_VIRTUAL_TEXTURE");
+  return mode != nullptr && std::strcmp(mode, "on") == 0;
+}
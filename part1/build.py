@@ -1,11 +1,26 @@
-# Run with: python3 build.py
+# Run with: python3 build.py [debug|release|relwithdebinfo] [native] [lto]
+#   (or python3 build.py direct to always use the g++ command below)
 import os
 import platform
+import sys
+
+# (0)============================ CMake build ================================= #
+# When cmake is installed the program is built with the top level
+# CMakeLists.txt (an optimized Release build unless asked otherwise) and
+# copied here. Otherwise we fall back to compiling everything with g++.
+sys.path.insert(0,os.path.join(os.path.dirname(os.path.abspath(__file__)),"..","tools"))
+import cmakebuild
+if cmakebuild.WantsCMake(sys.argv[1:]):
+    if cmakebuild.Build("part1","part1","project",sys.argv[1:]):
+        sys.exit(0)
+    print("CMake build failed, compiling directly with g++ instead")
+# (0)============================ CMake build ================================= #
 
 # (1)==================== COMMON CONFIGURATION OPTIONS ======================= #
 COMPILER="g++ -std=c++17"   # The compiler we want to use 
                                 #(You may try g++ if you have trouble)
-SOURCE="./src/*.cpp"    # Where the source code lives
+SOURCE="./src/*.cpp ./../common/engine/src/*.cpp" # Where the source code lives
+                        # (this program and the shared engine)
 EXECUTABLE="project"        # Name of the final executable
 # ======================= COMMON CONFIGURATION OPTIONS ======================= #
 
@@ -17,16 +32,16 @@ LIBRARIES=""            # What libraries do we want to include
 
 if platform.system()=="Linux":
     ARGUMENTS="-D LINUX" # -D is a #define sent to preprocessor
-    INCLUDE_DIR="-I ./include/ -I ./../common/thirdparty/glm/"
-    LIBRARIES="-lSDL2 -ldl"
+    INCLUDE_DIR="-I ./include/ -I ./../common/engine/include/ -I ./../common/thirdparty/glm/"
+    LIBRARIES="-lSDL2 -ldl -lrt"
 elif platform.system()=="Darwin":
     ARGUMENTS="-D MAC" # -D is a #define sent to the preprocessor.
-    INCLUDE_DIR="-I ./include/ -I/Library/Frameworks/SDL2.framework/Headers -I./../common/thirdparty/old/glm"
+    INCLUDE_DIR="-I ./include/ -I ./../common/engine/include/ -I/Library/Frameworks/SDL2.framework/Headers -I./../common/thirdparty/old/glm"
     LIBRARIES="-F/Library/Frameworks -framework SDL2"
 elif platform.system()=="Windows":
     COMPILER="g++ -std=c++17" # Note we use g++ here as it is more likely what you have
     ARGUMENTS="-D MINGW -std=c++17 -static-libgcc -static-libstdc++" 
-    INCLUDE_DIR="-I./include/ -I./../common/thirdparty/old/glm/"
+    INCLUDE_DIR="-I./include/ -I./../common/engine/include/ -I./../common/thirdparty/old/glm/"
     EXECUTABLE="project.exe"
     LIBRARIES="-lmingw32 -lSDL2main -lSDL2"
 # (2)=================== Platform specific configuration ===================== #
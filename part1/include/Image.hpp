@@ -9,17 +9,24 @@
 #ifndef IMAGE_HPP
 #define IMAGE_HPP
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
+#include "ResourceTracker.hpp"
+
 class Image {
 public:
   // Constructor for creating an image
   Image(std::string filepath);
   // Destructor
   ~Image();
-  // Loads a PPM from memory.
+  // Loads a PPM from memory. With flip, a cooked copy in the mounted
+  // AssetArchive is used in place (nothing is read or allocated).
   void LoadPPM(bool flip);
+  // Parses a PPM that is already in memory (e.g. read by AsyncFileReader).
+  // Returns false if it is not a plain PPM.
+  bool LoadPPM(const char *text, size_t length, bool flip);
   // Return the width
   inline int GetWidth() { return m_width; }
   // Return the height
@@ -31,30 +38,39 @@ public:
   // Display the pixels
   void PrintPixels();
   // Retrieve raw array of pixel data
-  uint8_t *GetPixelDataPtr();
+  const uint8_t *GetPixelDataPtr();
+  // True if the pixels are the archive's (they stay valid while it is
+  // mounted, so they do not need to be copied)
+  bool IsArchiveView() const {
+    return m_pixels != nullptr && m_pixels != m_pixelData;
+  }
   // Returns the red component of a pixel
   inline unsigned int GetPixelR(int x, int y) {
-    return m_pixelData[(x * 3) + m_height * (y * 3)];
+    return m_pixels[(x * 3) + m_height * (y * 3)];
   }
   // Returns the green component of a pixel
   inline unsigned int GetPixelG(int x, int y) {
-    return m_pixelData[(x * 3) + m_height * (y * 3) + 1];
+    return m_pixels[(x * 3) + m_height * (y * 3) + 1];
   }
   // Returns the blue component of a pixel
   inline unsigned int GetPixelB(int x, int y) {
-    return m_pixelData[(x * 3) + m_height * (y * 3) + 2];
+    return m_pixels[(x * 3) + m_height * (y * 3) + 2];
   }
 
 private:
   // Filepath to the image loaded
   std::string m_filepath;
-  // Raw pixel data
-  uint8_t *m_pixelData;
+  // Raw pixel data (when it was read from the file or changed)
+  uint8_t *m_pixelData{nullptr};
+  // The pixels that are read: m_pixelData or a view of the AssetArchive
+  const uint8_t *m_pixels{nullptr};
   // Size and format of image
   int m_width{0};          // Width of the image
   int m_height{0};         // Height of the image
   int m_BPP{0};            // Bits per pixel (i.e. how colorful are our pixels)
   std::string magicNumber; // magicNumber if any for image format
+  // Pixel data reported to the resource tracker
+  TrackedAllocation m_trackedBytes{"Image"};
 };
 
 #endif
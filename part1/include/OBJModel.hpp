@@ -3,7 +3,12 @@
 #define OBJMODEL_HPP
 
 // Required dependencies and libraries
+#include "GpuUploader.hpp"
+#include "Residency.hpp"
+#include "ResourceTracker.hpp"
 #include "Texture.hpp"
+#include "VertexCache.hpp"
+#include "forsyth.h"
 #include <fstream>
 #include <glad/glad.h> // OpenGL loader library
 #include <glm/glm.hpp> // GLM for matrix and vector operations
@@ -15,6 +20,8 @@
 #include <unordered_map>
 #include <vector>
 
+class GpuCuller;
+
 // Structure to represent the material properties of an object
 struct Material {
   float ns;         // Specular exponent
@@ -33,16 +40,58 @@ struct Material {
 // Class to represent an OBJ model
 class OBJModel {
 public:
+  // Index orders, selected with setCacheMode(1..kCacheModes): 1 file order,
+  // 2 Forsyth, 3 random triangles, 4 Morton, 5 Hilbert, 6 adversarial (see
+  // TriangleOrder.hpp)
+  static const int kCacheModes = 6;
+  static const char *getCacheModeName(int mode); // "forsyth", ...
+
   OBJModel();                            // Default constructor
   OBJModel(const std::string &filepath); // Constructor to load model from file
   ~OBJModel();                           // Destructor to clean up resources
 
   void render() const; // Render the model
+  void renderCopy() const; // Render one copy of the model (no offsets)
+  void renderCopies(GpuCuller &culler)
+      const; // Render the copies the culler kept, in one draw call
   void
   loadModelFromFile(const std::string &filepath); // Load model data from file
   void SetShaderMaterialUniforms(
       GLuint shaderProgram);         // Set material properties in the shader
   void setCacheMode(const int mode); // Set cache mode to make indices order
+  int getCacheMode() const { return cacheMode; } // Selected cache mode (1-6)
+  const VertexCacheStats &getCacheStats(int mode) const {
+    return cacheStats[mode - 1];
+  } // Simulated cache misses of a mode's order (computed at load)
+  void unload(); // Release GPU buffers, textures and CPU data
+  void setUploader(GpuUploader *next) {
+    uploader = next;
+  } // Upload the next load's buffers and textures on the uploader's thread
+    // (nullptr: right away)
+  bool isReady() const {
+    return vao != 0;
+  } // The buffers are on the GPU (render() draws nothing before that)
+  void setResidency(Residency policy); // What to keep on the CPU after
+                                       // upload (applies to the next load)
+  void setForsythParams(
+      const ForsythParams &params); // Score function for cache mode 2
+                                    // (applies to the next load)
+  void setCacheModel(const VertexCacheModel &model) {
+    cacheModel = model;
+  } // Cache that getCacheStats() simulates (applies to the next load)
+  void setRandomSeed(uint64_t seed) {
+    randomSeed = seed;
+  } // Seed of cache mode 3 (applies to the next load)
+  const glm::vec3 &getCopyCenter() const {
+    return copyCenter;
+  } // Bounding sphere of one copy (for impostors)
+  float getCopyRadius() const { return copyRadius; }
+  GLsizei getCopyIndexCount() const {
+    return copyIndexCount;
+  } // Indices of one copy, from the start of the copy's EBO
+  const CollisionMesh &getCollisionMesh() const {
+    return collision;
+  } // Compact positions + indices (Residency::CpuCollision only)
 
 private:
   // Vertex structure to represent a vertex with position, texture
@@ -55,18 +104,45 @@ private:
 
   // Model data
   std::vector<Vertex> vertices; // List of vertices
-  std::vector<GLuint> indices;  // Indices for indexed drawing
+  std::vector<GLuint> indices;  // Indices for indexed drawing (file order)
   std::unordered_map<std::string, Texture>
       texturesLoaded; // Map of loaded textures to avoid duplication
 
   // OpenGL buffer objects
-  GLuint vao, vbo, ebo; // Vertex Array Object, Vertex Buffer Object, and
+  GLuint vao{0}, vbo{0}; // Vertex Array Object and Vertex Buffer Object
+  GLuint ebos[kCacheModes]{}; // One Element Buffer Object per cache mode, so
+                              // switching modes does not need the CPU copies
+  GLsizei indexCount{0};      // Number of indices to draw
+  GLuint copyVao{0}, copyEbo{0}; // One copy of the model, in Forsyth's order
+  GLsizei copyIndexCount{0};
+  GLuint copyVertexCount{0}; // Vertices of one copy (the first ones)
+  glm::vec3 copyCenter{0.0f};
+  float copyRadius{0.0f};
+  int cacheMode{2};           // Currently selected cache mode (1-6)
+
+  std::vector<GLuint>
+      reordered[kCacheModes - 1]; // Indices of cache modes 2-6
+  VertexCacheStats cacheStats[kCacheModes]; // Per cache mode
+  VertexCacheModel cacheModel{VertexCacheKind::Fifo, 32};
+  uint64_t randomSeed{5310};
 
-  std::vector<GLuint> oriIndices;
-  std::vector<GLuint> optiIndices;
+  Residency residency{Residency::GpuOnly}; // What stays on the CPU
+  ForsythParams forsythParams{forsythDefaultParams()}; // See ForsythTuner.hpp
+  CollisionMesh collision; // Kept for Residency::CpuCollision
 
   Material material;   // Material properties of the model
+  TrackedAllocation trackedBytes{"OBJModel"}; // CPU copies reported to the
+                                              // resource tracker
+  GpuUploader *uploader{nullptr}; // See setUploader()
+  UploadTicket uploadTicket{0};    // Buffers still on their way
   void setupBuffers(); // Setup the VAO, VBO, and EBO
+  void adoptBuffers(const GLuint *buffers,
+                    const size_t *bytes); // Create the VAOs around uploaded
+                                          // buffers: the VBO, the EBOs and
+                                          // the copy's EBO
+  void setupAttributes() const; // Vertex layout of the bound VAO and VBO
+  void bindTextures() const;       // Bind the material's textures
+  void draw(GLsizei count) const; // Draw the bound VAO with the textures
   void
   LoadMaterials(const std::string
                     &mtlFilePath); // Load material properties from a .mtl file
@@ -74,6 +150,12 @@ private:
   generateOffsetVectors(int maxOffset); // Generate vectors for replicating
   void optimizingIndices(); // Optimize the order of indices based on Foryth's
                             // algorithm
+  void orderingIndices();   // The other orders of cache modes 3-6
+  const std::vector<GLuint> &getIndices(int mode) const {
+    return mode == 1 ? indices : reordered[mode - 2];
+  } // CPU copy of a cache mode's order (may be released)
+  void releaseHostData();   // Free CPU copies according to the residency
+  void updateTrackedBytes(); // Report CPU copies to the resource tracker
 };
 
 #endif // OBJMODEL_HPP
@@ -9,10 +9,14 @@
 #ifndef TEXTURE_HPP
 #define TEXTURE_HPP
 
+#include "GpuUploader.hpp"
 #include "Image.hpp"
+#include "Residency.hpp"
 
 #include <glad/glad.h>
 #include <string>
+#include <utility>
+#include <vector>
 
 class Texture {
 public:
@@ -20,23 +24,46 @@ public:
   Texture();
   // Destructor
   ~Texture();
-  // Loads and sets up an actual texture
-  void LoadTexture(const std::string filepath);
+  // Loads and sets up an actual texture. The image is freed after the
+  // upload unless the residency is Residency::CpuAndGpu. With an uploader
+  // the texture is created on its thread and IsLoaded() turns true once
+  // GpuUploader::Poll() hands it over.
+  void LoadTexture(const std::string filepath,
+                   Residency residency = Residency::GpuOnly,
+                   GpuUploader *uploader = nullptr);
+  // Same, with an image that is already loaded (the texture owns it now)
+  void LoadTexture(const std::string filepath, Image *image,
+                   Residency residency = Residency::GpuOnly,
+                   GpuUploader *uploader = nullptr);
+  // Loads several textures: the files are read together by
+  // AsyncFileReader::Instance() and parsed on its threads, so their reads
+  // overlap instead of waiting for each other
+  static void
+  LoadTextures(const std::vector<std::pair<Texture *, std::string>> &textures,
+               Residency residency = Residency::GpuOnly,
+               GpuUploader *uploader = nullptr);
   // slot tells us which slot we want to bind to.
   // We can have multiple slots. By default, we
   // will set our slot to 0 if it is not specified.
   void Bind(unsigned int slot = 0) const;
-  // Be done with our texture
-  void Unbind();
+  // Be done with our texture (in the same slot)
+  void Unbind(unsigned int slot = 0);
+  // Delete the GPU texture and the image data (or cancel the upload)
+  void Release();
   Image *GetImage() const { return m_image; }
+  // True once the texture exists on the GPU
+  bool IsLoaded() const { return m_textureID != 0; }
 
 private:
   // Store a unique ID for the texture
-  GLuint m_textureID;
+  GLuint m_textureID{0};
   // Filepath to the image loaded
   std::string m_filepath;
   // Store whatever image data inside of our texture class.
-  Image *m_image;
+  Image *m_image{nullptr};
+  // The upload that is still on its way, if any
+  GpuUploader *m_uploader{nullptr};
+  UploadTicket m_uploadTicket{0};
 };
 
 #endif
\ No newline at end of file
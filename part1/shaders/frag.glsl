@@ -17,6 +17,9 @@ uniform sampler2D u_BumpMap;
 uniform sampler2D u_SpecularMap;
 
 uniform vec3 u_CameraPosition;
+// Cross-fade with an impostor (see Impostor.hpp): this share of the pixels
+// is left to the impostor. 0 draws every pixel.
+uniform float u_Dissolve;
 
 // ======================= IN =========================
 in vec3 myNormal; // Import our normal data
@@ -31,9 +34,18 @@ out vec4 FragColor;
 // We will have another constant for specular strength
 float specularStrength = 0.5f;
 
+// The same pattern as the impostor's, so together they cover every pixel
+float Dither(vec2 p) {
+  return fract(52.9829189 * fract(dot(p, vec2(0.06711056, 0.00583715))));
+}
+
 
 void main()
 {
+    if (Dither(gl_FragCoord.xy) < u_Dissolve) {
+        discard;
+    }
+
     // Store our final texture color
     vec3 diffuseColor;
     diffuseColor = texture(u_DiffuseMap, v_texCoord).rgb;
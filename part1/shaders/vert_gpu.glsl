@@ -0,0 +1,44 @@
+// ==================================================================
+#version 430 core
+// vert.glsl for the GPU culled forest (see GpuCulling.hpp): the model
+// matrix comes from the culler's object buffer instead of a uniform.
+layout(location=0)in vec3 position;
+layout(location=1)in vec2 texCoord; // Our third attribute - texture coordinates.
+layout(location=2)in vec3 normals; // Our second attribute - normals.
+// Which object this copy is; the culler points it at the draw's baseInstance
+layout(location=3)in uint objectIndex;
+
+// One entry per copy, written by GpuCuller
+struct Object {
+    mat4 model;
+    vec4 sphere;
+    uvec4 mesh;
+};
+layout(std430, binding = 0) readonly buffer Objects {
+    Object u_Objects[];
+};
+
+uniform mat4 view; // Object space
+uniform mat4 projection; // Object space
+
+// Export our normal data, and read it into our frag shader
+out vec3 myNormal;
+// Export our Fragment Position computed in world space
+out vec3 FragPos;
+// If we have texture coordinates we can now use this as well
+out vec2 v_texCoord;
+
+
+void main()
+{
+    mat4 model = u_Objects[objectIndex].model;
+
+    gl_Position = projection * view * model * vec4(position, 1.0f);
+
+    myNormal = normals;
+    // Transform normal into world space
+    FragPos = vec3(model* vec4(position,1.0f));
+
+    v_texCoord = texCoord;
+}
+// ==================================================================
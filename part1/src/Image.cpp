@@ -1,9 +1,14 @@
 #include "Image.hpp"
+#include "AssetArchive.hpp"
+#include "AssetCooker.hpp"
+
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <stdio.h>
 #include <string.h>
+#include <vector>
 
 // Constructor
 Image::Image(std::string filepath) : m_filepath(filepath) {}
@@ -25,6 +30,18 @@ Image::~Image() {
 // flip - Will flip the pixels upside down in the data
 //        If you use this be consistent.
 void Image::LoadPPM(bool flip) {
+  // The archive stores the pixels flipped
+  if (flip) {
+    const AssetArchive &archive = AssetArchive::Instance();
+    AssetView view = archive.Find(m_filepath);
+    if (view.kind == AssetKind::Texture) {
+      archive.Prefetch(view);
+      m_width = static_cast<int>(view.width);
+      m_height = static_cast<int>(view.height);
+      m_pixels = view.data;
+      return;
+    }
+  }
 
   // Open an input file stream for reading a file
   std::ifstream ppmFile(m_filepath.c_str());
@@ -53,6 +70,7 @@ void Image::LoadPPM(bool flip) {
         std::cout << "PPM width,height=" << m_width << "," << m_height << "\n";
         if (m_width > 0 && m_height > 0) {
           m_pixelData = new uint8_t[m_width * m_height * 3];
+          m_trackedBytes.Set(m_width * m_height * 3);
           if (m_pixelData == NULL) {
             std::cout << "Unable to allocate memory for ppm" << std::endl;
             exit(1);
@@ -94,6 +112,27 @@ void Image::LoadPPM(bool flip) {
     }
     delete[] copyData;
   }
+  m_pixels = m_pixelData;
+}
+
+// The same pixels as LoadPPM(flip) for a file that was read already
+bool Image::LoadPPM(const char *text, size_t length, bool flip) {
+  uint32_t width = 0, height = 0;
+  std::vector<uint8_t> pixels;
+  std::string error;
+  if (!ParsePpm(text, length, flip, width, height, pixels, &error)) {
+    std::cout << "Unable to parse ppm file " << m_filepath << ": " << error
+              << std::endl;
+    return false;
+  }
+  delete[] m_pixelData;
+  m_width = static_cast<int>(width);
+  m_height = static_cast<int>(height);
+  m_pixelData = new uint8_t[pixels.size()];
+  std::copy(pixels.begin(), pixels.end(), m_pixelData);
+  m_trackedBytes.Set(pixels.size());
+  m_pixels = m_pixelData;
+  return true;
 }
 
 /*  ===============================================
@@ -105,6 +144,13 @@ void Image::SetPixel(int x, int y, uint8_t r, uint8_t g, uint8_t b) {
   if (x > m_width || y > m_height) {
     return;
   } else {
+    // The archive is read only: change a copy
+    if (m_pixelData == nullptr && m_pixels != nullptr) {
+      m_pixelData = new uint8_t[m_width * m_height * 3];
+      std::copy(m_pixels, m_pixels + m_width * m_height * 3, m_pixelData);
+      m_trackedBytes.Set(m_width * m_height * 3);
+      m_pixels = m_pixelData;
+    }
     /*std::cout << "modifying pixel at "
               << x << "," << y << "from (" <<
               (int)color[x*y] << "," << (int)color[x*y+1] << "," <<
@@ -125,7 +171,7 @@ Post-condition:
 =============================================== */
 void Image::PrintPixels() {
   for (int x = 0; x < m_width * m_height * 3; ++x) {
-    std::cout << " " << (int)m_pixelData[x];
+    std::cout << " " << (int)m_pixels[x];
   }
   std::cout << "\n";
 }
@@ -135,4 +181,4 @@ Desc: Returns pixel data for our image
 Precondition:
 Post-condition:
 =============================================== */
-uint8_t *Image::GetPixelDataPtr() { return m_pixelData; }
+const uint8_t *Image::GetPixelDataPtr() { return m_pixels; }
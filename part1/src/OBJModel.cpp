@@ -1,12 +1,25 @@
 #include "OBJModel.hpp"
 #include <algorithm>
-#include <chrono>
-#include <random>
+#include <map>
 #include <sstream>
-
-#define FORSYTH_IMPLEMENTATION
+#include <tuple>
+
+#include "FrameStats.hpp"
+#include "GLDebug.hpp"
+#include "GLState.hpp"
+#include "GpuCulling.hpp"
+#include "ObjParser.hpp"
+#include "TriangleOrder.hpp"
 #include "forsyth.h"
 
+const int OBJModel::kCacheModes;
+
+const char *OBJModel::getCacheModeName(int mode) {
+  static const char *names[kCacheModes] = {
+      "original", "forsyth", "random", "morton", "hilbert", "adversarial"};
+  return mode >= 1 && mode <= kCacheModes ? names[mode - 1] : "?";
+}
+
 // Default constructor
 OBJModel::OBJModel() {
   std::cout << "OBJModel default constructor: Nothing loaded yet" << std::endl;
@@ -17,20 +30,91 @@ OBJModel::OBJModel(const std::string &filepath) { loadModelFromFile(filepath); }
 
 // Sets up the vertex buffer objects and vertex array object
 void OBJModel::setupBuffers() {
-  glGenVertexArrays(1, &vao);
-  glGenBuffers(1, &vbo);
-  glGenBuffers(1, &ebo);
+  // The first copy uses the lowest vertices, so its triangles are the ones
+  // of Forsyth's order that only refer to those
+  std::vector<GLuint> copyIndices;
+  const std::vector<GLuint> &optiIndices = reordered[0];
+  for (size_t i = 0; i < optiIndices.size(); i += 3) {
+    if (optiIndices[i] < copyVertexCount &&
+        optiIndices[i + 1] < copyVertexCount &&
+        optiIndices[i + 2] < copyVertexCount) {
+      copyIndices.insert(copyIndices.end(), &optiIndices[i],
+                         &optiIndices[i] + 3);
+    }
+  }
+  indexCount = static_cast<GLsizei>(indices.size());
+  copyIndexCount = static_cast<GLsizei>(copyIndices.size());
+
+  // Upload every index order once; setCacheMode() only switches between
+  // them, so the CPU copies can be released after this.
+  std::vector<BufferUpload> uploads;
+  uploads.push_back(MakeBufferUpload(vertices));
+  for (int i = 0; i < kCacheModes; i++) {
+    uploads.push_back(MakeBufferUpload(getIndices(i + 1)));
+  }
+  uploads.push_back(MakeBufferUpload(copyIndices));
+
+  // The jobs have their own copies, so releaseHostData() does not wait
+  if (uploader != nullptr) {
+    uploadTicket = uploader->UploadBuffers(
+        std::move(uploads), [this](const UploadResult &result) {
+          uploadTicket = 0;
+          adoptBuffers(result.buffers.data(), result.bufferBytes.data());
+        });
+    return;
+  }
 
-  glBindVertexArray(vao);
+  GLuint buffers[kCacheModes + 2];
+  size_t bytes[kCacheModes + 2];
+  glGenBuffers(kCacheModes + 2, buffers);
+  GLState &state = GLState::Instance();
+  for (int i = 0; i < kCacheModes + 2; i++) {
+    state.BindBuffer(GL_COPY_WRITE_BUFFER, buffers[i]);
+    glBufferData(GL_COPY_WRITE_BUFFER, uploads[i].data.size(),
+                 uploads[i].data.data(), GL_STATIC_DRAW);
+    bytes[i] = uploads[i].data.size();
+  }
+  state.BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  adoptBuffers(buffers, bytes);
+}
 
-  glBindBuffer(GL_ARRAY_BUFFER, vbo);
-  glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
-               vertices.data(), GL_STATIC_DRAW);
+// Takes over the buffers setupBuffers() made (or had made) and records the
+// vertex arrays, which cannot be shared with an upload context
+void OBJModel::adoptBuffers(const GLuint *buffers, const size_t *bytes) {
+  vbo = buffers[0];
+  std::copy(buffers + 1, buffers + 1 + kCacheModes, ebos);
+  copyEbo = buffers[kCacheModes + 1];
 
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int),
-               indices.data(), GL_STATIC_DRAW);
+  GLState &state = GLState::Instance();
+  glGenVertexArrays(1, &vao);
+  state.BindVertexArray(vao);
+  state.BindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebos[cacheMode - 1]);
+  setupAttributes();
+
+  glGenVertexArrays(1, &copyVao);
+  state.BindVertexArray(copyVao);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, copyEbo);
+  setupAttributes();
+
+  // Note: the element buffers are kept alive until unload(); the VAO keeps
+  // referencing one of them, so deleting them here would not free any memory.
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.TrackGpu(GpuResourceKind::VertexArray, vao, 0, 0, "OBJModel");
+  tracker.TrackGpu(GpuResourceKind::Buffer, vbo, bytes[0], GL_ARRAY_BUFFER,
+                   "OBJModel");
+  for (int i = 0; i < kCacheModes; i++) {
+    tracker.TrackGpu(GpuResourceKind::Buffer, ebos[i], bytes[i + 1],
+                     GL_ELEMENT_ARRAY_BUFFER, "OBJModel");
+  }
+  tracker.TrackGpu(GpuResourceKind::VertexArray, copyVao, 0, 0,
+                   "OBJModel:copy");
+  tracker.TrackGpu(GpuResourceKind::Buffer, copyEbo, bytes[kCacheModes + 1],
+                   GL_ELEMENT_ARRAY_BUFFER, "OBJModel:copy");
+}
 
+// Positions, texture coordinates and normals of the bound vertex buffer
+void OBJModel::setupAttributes() const {
   // Vertex positions
   glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void *)0);
   glEnableVertexAttribArray(0);
@@ -44,12 +128,97 @@ void OBJModel::setupBuffers() {
   glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex),
                         (void *)offsetof(Vertex, normal));
   glEnableVertexAttribArray(2);
+}
 
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+// Frees the CPU copies that are no longer needed once everything is on the
+// GPU. Residency::CpuCollision keeps a compact positions + indices mesh in
+// which vertices that only differ by their attributes are merged.
+void OBJModel::releaseHostData() {
+  if (residency == Residency::CpuCollision) {
+    collision.positions.clear();
+    collision.indices.clear();
+    std::map<std::tuple<float, float, float>, uint32_t> lookup;
+    collision.indices.reserve(indices.size());
+    for (GLuint index : indices) {
+      const glm::vec3 &p = vertices[index].position;
+      auto inserted = lookup.insert(
+          {std::make_tuple(p.x, p.y, p.z),
+           static_cast<uint32_t>(collision.positions.size() / 3)});
+      if (inserted.second) {
+        collision.positions.push_back(p.x);
+        collision.positions.push_back(p.y);
+        collision.positions.push_back(p.z);
+      }
+      collision.indices.push_back(inserted.first->second);
+    }
+    collision.positions.shrink_to_fit();
+  }
 
-  // Not needed anymore because data is now in GPU
-  glDeleteBuffers(1, &ebo);
+  if (residency != Residency::CpuAndGpu) {
+    FreeVector(vertices);
+    FreeVector(indices);
+    for (std::vector<GLuint> &order : reordered) {
+      FreeVector(order);
+    }
+  }
+  updateTrackedBytes();
+}
+
+// Reports how much CPU memory the model currently holds
+void OBJModel::updateTrackedBytes() {
+  size_t indexCapacity = indices.capacity();
+  for (const std::vector<GLuint> &order : reordered) {
+    indexCapacity += order.capacity();
+  }
+  trackedBytes.Set(vertices.capacity() * sizeof(Vertex) +
+                   indexCapacity * sizeof(GLuint) +
+                   collision.GetSizeInBytes());
+}
+
+// Chooses what stays on the CPU after the next upload
+void OBJModel::setResidency(Residency policy) { residency = policy; }
+
+// Chooses Forsyth's parameters for the next load
+void OBJModel::setForsythParams(const ForsythParams &params) {
+  forsythParams = params;
+}
+
+// Releases everything that belongs to the currently loaded model
+void OBJModel::unload() {
+  // The uploader deletes the buffers if they are already made
+  if (uploadTicket != 0) {
+    uploader->Cancel(uploadTicket);
+    uploadTicket = 0;
+  }
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.UntrackGpu(GpuResourceKind::Buffer, vbo);
+  for (int i = 0; i < kCacheModes; i++) {
+    tracker.UntrackGpu(GpuResourceKind::Buffer, ebos[i]);
+  }
+  tracker.UntrackGpu(GpuResourceKind::VertexArray, vao);
+  tracker.UntrackGpu(GpuResourceKind::Buffer, copyEbo);
+  tracker.UntrackGpu(GpuResourceKind::VertexArray, copyVao);
+  glDeleteBuffers(1, &vbo);
+  glDeleteBuffers(kCacheModes, ebos);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &copyEbo);
+  glDeleteVertexArrays(1, &copyVao);
+  vao = vbo = copyVao = copyEbo = 0;
+  std::fill(std::begin(ebos), std::end(ebos), 0);
+  indexCount = copyIndexCount = 0;
+
+  material.map_kd.Release();
+  material.map_bump.Release();
+  material.map_ks.Release();
+
+  FreeVector(vertices);
+  FreeVector(indices);
+  for (std::vector<GLuint> &order : reordered) {
+    FreeVector(order);
+  }
+  FreeVector(collision.positions);
+  FreeVector(collision.indices);
+  trackedBytes.Set(0);
 }
 
 // Sets the shader material uniforms
@@ -69,125 +238,177 @@ void OBJModel::SetShaderMaterialUniforms(GLuint shaderProgram) {
 
 // Renders the model by binding the VAO and drawing its elements
 void OBJModel::render() const {
-  glBindVertexArray(vao);
+  if (!isReady()) {
+    return;
+  }
+  GLState::Instance().BindVertexArray(vao);
+  draw(indexCount);
+}
 
-  if (material.map_kd.GetImage()) {
-    glActiveTexture(GL_TEXTURE0);
+// Renders the first copy only, e.g. once per tree of a forest
+void OBJModel::renderCopy() const {
+  if (!isReady()) {
+    return;
+  }
+  GLState::Instance().BindVertexArray(copyVao);
+  draw(copyIndexCount);
+}
+
+// Every copy the culler kept, from the copy's VAO. The object index goes in
+// attribute 3 (see shaders/vert_gpu.glsl).
+void OBJModel::renderCopies(GpuCuller &culler) const {
+  if (!isReady()) {
+    return;
+  }
+  bindTextures();
+  GL_CHECK(culler.Draw(copyVao, 3));
+}
+
+void OBJModel::bindTextures() const {
+  // The images may already be freed, so check the GL textures instead.
+  // A forest binds the same three textures for every tree; GLState turns
+  // all but the first into no-ops.
+  if (material.map_kd.IsLoaded()) {
     material.map_kd.Bind(0);
   }
 
-  if (material.map_bump.GetImage()) {
-    glActiveTexture(GL_TEXTURE1);
-    material.map_kd.Bind(1);
+  if (material.map_bump.IsLoaded()) {
+    material.map_bump.Bind(1);
   }
 
-  if (material.map_ks.GetImage()) {
-    glActiveTexture(GL_TEXTURE2);
-    material.map_kd.Bind(2);
+  if (material.map_ks.IsLoaded()) {
+    material.map_ks.Bind(2);
   }
+}
 
-  glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()),
-                 GL_UNSIGNED_INT, 0);
-  glBindVertexArray(0);
+// Binds the textures and draws 'count' indices of the bound VAO
+void OBJModel::draw(GLsizei count) const {
+  bindTextures();
+  GL_CHECK(glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, 0));
+  FrameStats::Instance().CountDraw(count / 3);
 }
 
 // Loads the model data from the specified .obj file
 void OBJModel::loadModelFromFile(const std::string &filepath) {
-  std::ifstream objFile(filepath);
-  if (!objFile.is_open()) {
-    std::cerr << "Failed to open the OBJ file: " << filepath << std::endl;
+  ObjData data;
+  std::string error;
+  if (!LoadObjFile(filepath, data, &error)) {
+    std::cerr << "Failed to open the OBJ file: " << filepath << " (" << error
+              << ")" << std::endl;
     return;
   }
+  // Replace whatever model was loaded before
+  unload();
 
-  std::string line;
-  std::vector<glm::vec3> temp_vertices;
-  std::vector<glm::vec2> temp_texCoords;
-  std::vector<glm::vec3> temp_normals;
+  if (!data.materialLibrary.empty()) {
+    LoadMaterials(filepath.substr(0, filepath.find_last_of("/\\") + 1) +
+                  data.materialLibrary);
+  }
 
-  while (std::getline(objFile, line)) {
-    std::istringstream ss(line);
-    std::string prefix;
-    ss >> prefix;
-
-    if (prefix == "mtllib") {
-      std::string mtlFileName;
-      ss >> mtlFileName;
-      LoadMaterials(filepath.substr(0, filepath.find_last_of("/\\") + 1) +
-                    mtlFileName);
-    } else if (prefix == "usemtl") {
-      std::string matName;
-      ss >> matName;
-    } else if (prefix == "v") {
-      glm::vec3 vertex;
-      ss >> vertex.x >> vertex.y >> vertex.z;
-      temp_vertices.push_back(vertex);
-    } else if (prefix == "vt") {
-      glm::vec2 texCoord;
-      ss >> texCoord.x >> texCoord.y;
-      temp_texCoords.push_back(texCoord);
-    } else if (prefix == "vn") {
-      glm::vec3 normal;
-      ss >> normal.x >> normal.y >> normal.z;
-      temp_normals.push_back(normal);
-    } else if (prefix == "f") {
-      std::string vertex1, vertex2, vertex3;
-      unsigned int vIndex[3], uvIndex[3], nIndex[3];
-      char slash;
-
-      ss >> vertex1 >> vertex2 >> vertex3;
-      sscanf(vertex1.c_str(), "%d/%d/%d", &vIndex[0], &uvIndex[0], &nIndex[0]);
-      sscanf(vertex2.c_str(), "%d/%d/%d", &vIndex[1], &uvIndex[1], &nIndex[1]);
-      sscanf(vertex3.c_str(), "%d/%d/%d", &vIndex[2], &uvIndex[2], &nIndex[2]);
+  // Corners with the same position, texture coordinate and normal share a
+  // vertex; without that every order would miss the cache on every corner
+  std::map<std::tuple<int, int, int>, GLuint> welded;
+  std::vector<GLuint> cornerVertex(data.corners.size());
+  std::vector<Vertex> unique;
+  for (size_t c = 0; c < data.corners.size(); c++) {
+    const ObjIndex &index = data.corners[c];
+    auto inserted = welded.insert(
+        {std::make_tuple(index.position, index.texCoord, index.normal),
+         static_cast<GLuint>(unique.size())});
+    if (inserted.second) {
+      Vertex vertex;
+      vertex.position = data.positions[index.position];
+      vertex.texCoords = index.texCoord >= 0 ? data.texCoords[index.texCoord]
+                                             : glm::vec2(0.0f);
+      vertex.normal =
+          index.normal >= 0 ? data.normals[index.normal] : glm::vec3(0.0f);
+      unique.push_back(vertex);
+    }
+    cornerVertex[c] = inserted.first->second;
+  }
+  copyVertexCount = static_cast<GLuint>(unique.size());
 
-      for (int i = 0; i < 3; i++) {
-        Vertex vertex;
-        vertex.position = temp_vertices[vIndex[i] - 1];
-        vertex.texCoords = temp_texCoords[uvIndex[i] - 1];
-        vertex.normal = temp_normals[nIndex[i] - 1];
-        vertices.push_back(vertex);
-        indices.push_back(vertices.size() - 1);
-      }
+  // Bounding sphere of one copy (around the center of its box)
+  glm::vec3 low(0.0f), high(0.0f);
+  for (size_t v = 0; v < unique.size(); v++) {
+    low = v == 0 ? unique[v].position : glm::min(low, unique[v].position);
+    high = v == 0 ? unique[v].position : glm::max(high, unique[v].position);
+  }
+  copyCenter = (low + high) * 0.5f;
+  copyRadius = 0.0f;
+  for (const Vertex &vertex : unique) {
+    copyRadius =
+        std::max(copyRadius, glm::length(vertex.position - copyCenter));
+  }
 
-      // Define a list of offsets
-      std::vector<glm::vec3> offsets = generateOffsetVectors(3);
-
-      for (auto &offset : offsets) {
-        for (int i = 0; i < 3; i++) {
-          Vertex vertex;
-          vertex.position = temp_vertices[vIndex[i] - 1] + offset;
-          vertex.texCoords = temp_texCoords[uvIndex[i] - 1];
-          vertex.normal = temp_normals[nIndex[i] - 1];
-          vertices.push_back(vertex);
-          indices.push_back(vertices.size() - 1);
-        }
+  // Define a list of offsets. Copy k of the model uses vertices
+  // k * unique.size() and up.
+  std::vector<glm::vec3> offsets = generateOffsetVectors(3);
+  offsets.insert(offsets.begin(), glm::vec3(0.0f));
+  vertices.reserve(unique.size() * offsets.size());
+  indices.reserve(data.corners.size() * offsets.size());
+  for (auto &offset : offsets) {
+    for (Vertex vertex : unique) {
+      vertex.position += offset;
+      vertices.push_back(vertex);
+    }
+  }
+  // Each triangle is followed by its copies, as before welding
+  for (size_t face = 0; face < data.GetTriangleCount(); face++) {
+    for (size_t copy = 0; copy < offsets.size(); copy++) {
+      for (int i = 0; i < 3; i++) {
+        indices.push_back(
+            static_cast<GLuint>(copy * unique.size()) +
+            cornerVertex[face * 3 + i]);
       }
     }
   }
 
-  oriIndices = indices;
   optimizingIndices();
+  orderingIndices();
+  for (int mode = 1; mode <= kCacheModes; mode++) {
+    const std::vector<GLuint> &order = getIndices(mode);
+    cacheStats[mode - 1] = SimulateVertexCache(order.data(), order.size(),
+                                               vertices.size(), cacheModel);
+  }
+  updateTrackedBytes();
 
   std::cout << "The number of indices: " << indices.size() << std::endl;
 
-  objFile.close();
   setupBuffers();
+  releaseHostData();
 }
 
 // Optimize the order of indices
 void OBJModel::optimizingIndices() {
-  std::vector<ForsythVertexIndexType> tmpIndices(indices.begin(),
-                                                 indices.end());
-
-  std::vector<ForsythVertexIndexType> optimizedIndices(indices.size());
-
-  forsythReorderIndices(optimizedIndices.data(), tmpIndices.data(),
-                        indices.size() / 3, vertices.size());
+  static_assert(sizeof(ForsythVertexIndexType) == sizeof(GLuint),
+                "Forsyth works on the GL indices directly");
+  std::vector<GLuint> &optiIndices = reordered[0];
+  optiIndices.resize(indices.size());
+  if (forsythReorderIndicesWithParams(optiIndices.data(), indices.data(),
+                                      indices.size() / 3, vertices.size(),
+                                      &forsythParams) == nullptr) {
+    // A vertex is used by more than 255 triangles
+    std::cerr << "Forsyth could not reorder this model" << std::endl;
+    optiIndices = indices;
+  }
+}
 
-  optiIndices.resize(optimizedIndices.size());
-  std::transform(optimizedIndices.begin(), optimizedIndices.end(),
-                 indices.begin(), [](ForsythVertexIndexType idx) -> GLuint {
-                   return static_cast<GLuint>(idx);
-                 });
+// Baseline orders to compare Forsyth's against
+void OBJModel::orderingIndices() {
+  static_assert(sizeof(uint32_t) == sizeof(GLuint),
+                "the orders work on the GL indices directly");
+  const TriangleOrder orders[kCacheModes - 2] = {
+      TriangleOrder::Random, TriangleOrder::Morton, TriangleOrder::Hilbert,
+      TriangleOrder::Adversarial};
+  PositionView positions{
+      vertices.empty() ? nullptr : &vertices[0].position.x, sizeof(Vertex)};
+  for (int i = 0; i < kCacheModes - 2; i++) {
+    std::vector<GLuint> &order = reordered[i + 1];
+    order.resize(indices.size());
+    OrderTriangles(orders[i], indices.data(), indices.size(), positions,
+                   order.data(), randomSeed);
+  }
 }
 
 // To create more vertices to compare the performance
@@ -209,16 +430,19 @@ std::vector<glm::vec3> OBJModel::generateOffsetVectors(int maxOffset) {
 
 // Loads the material properties from a .mtl file
 void OBJModel::LoadMaterials(const std::string &mtlFilePath) {
-  std::ifstream mtlFile(mtlFilePath);
-  std::string line;
-
-  if (!mtlFile.is_open()) {
+  // From the mounted AssetArchive if it has the file
+  std::string text;
+  if (!ReadFileToString(mtlFilePath, text)) {
     std::cerr << "Could not open MTL file at " << mtlFilePath << std::endl;
     return;
   }
+  std::istringstream mtlFile(text);
+  std::string line;
 
   std::string directory =
       mtlFilePath.substr(0, mtlFilePath.find_last_of("/\\") + 1);
+  // Loaded together at the end, so their files are read at the same time
+  std::vector<std::pair<Texture *, std::string>> textures;
 
   while (getline(mtlFile, line)) {
     std::istringstream lineStream(line);
@@ -242,41 +466,49 @@ void OBJModel::LoadMaterials(const std::string &mtlFilePath) {
     } else if (prefix == "map_Kd") {
       std::string textureFile;
       lineStream >> textureFile;
-      material.map_kd.LoadTexture(directory + textureFile);
+      textures.push_back({&material.map_kd, directory + textureFile});
     } else if (prefix == "map_Bump") {
       std::string textureFile;
       lineStream >> textureFile;
-      material.map_bump.LoadTexture(directory + textureFile);
+      textures.push_back({&material.map_bump, directory + textureFile});
     } else if (prefix == "map_Ks") {
       std::string textureFile;
       lineStream >> textureFile;
-      material.map_ks.LoadTexture(directory + textureFile);
+      textures.push_back({&material.map_ks, directory + textureFile});
     }
   }
+  Texture::LoadTextures(textures, Residency::GpuOnly, uploader);
 }
 
 // Reorder indices according to mode
 void OBJModel::setCacheMode(const int mode) {
-  if (mode == 1) {
-    indices = oriIndices;
-  } else if (mode == 2) {
-    indices = optiIndices;
-  } else if (mode == 3) {
-    auto rng = std::default_random_engine(
-        std::chrono::system_clock::now().time_since_epoch().count());
-    std::shuffle(indices.begin(), indices.end(), rng);
+  if (mode < 1 || mode > kCacheModes) {
+    return;
   }
+  cacheMode = mode;
 
-  std::cout << "First twenty indices" << std::endl;
-  for (int i = 0; i < 20; i++) {
-    std::cout << indices.at(i) << " ";
+  // All orders already live on the GPU, so just attach the matching buffer
+  // (adoptBuffers() attaches it if they are still on their way)
+  if (isReady()) {
+    GLState::Instance().BindVertexArray(vao);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebos[mode - 1]);
+  }
+
+  const VertexCacheStats &stats = cacheStats[mode - 1];
+  std::cout << "Cache mode " << mode << " (" << getCacheModeName(mode)
+            << "): ACMR " << stats.GetAcmr() << ", ATVR " << stats.GetAtvr()
+            << " (" << VertexCacheModelName(cacheModel) << ")" << std::endl;
+
+  // The CPU copies only exist with Residency::CpuAndGpu
+  const std::vector<GLuint> &current = getIndices(mode);
+  if (!current.empty()) {
+    std::cout << "First twenty indices" << std::endl;
+    for (size_t i = 0; i < 20 && i < current.size(); i++) {
+      std::cout << current[i] << " ";
+    }
+    std::cout << std::endl;
   }
-  std::cout << std::endl;
 }
 
 // Destructor which cleans up the allocated buffers
-OBJModel::~OBJModel() {
-  glDeleteBuffers(1, &vbo);
-  glDeleteBuffers(1, &ebo);
-  glDeleteVertexArrays(1, &vao);
-}
\ No newline at end of file
+OBJModel::~OBJModel() { unload(); }
\ No newline at end of file
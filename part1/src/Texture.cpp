@@ -1,6 +1,8 @@
-#include <SDL2/SDL.h>
-
 #include "Texture.hpp"
+#include "AssetArchive.hpp"
+#include "AsyncFileIO.hpp"
+#include "GLState.hpp"
+#include "ResourceTracker.hpp"
 
 #include <stdio.h>
 #include <string.h>
@@ -14,31 +16,116 @@
 Texture::Texture() {}
 
 // Default Destructor
-Texture::~Texture() {
-  // Delete our texture from the GPU
+Texture::~Texture() { Release(); }
+
+// Delete our texture from the GPU and the image we loaded it from
+void Texture::Release() {
+  // The uploader deletes the texture if it is already made
+  if (m_uploadTicket != 0) {
+    m_uploader->Cancel(m_uploadTicket);
+    m_uploadTicket = 0;
+  }
+  ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Texture,
+                                         m_textureID);
   glDeleteTextures(1, &m_textureID);
+  m_textureID = 0;
 
   // Delete our image
-  if (m_image != nullptr) {
-    delete m_image;
+  delete m_image;
+  m_image = nullptr;
+}
+
+void Texture::LoadTexture(const std::string filepath, Residency residency,
+                          GpuUploader *uploader) {
+  // Load our actual image data
+  // This method loads .ppm files of pixel data
+  Image *image = new Image(filepath);
+  image->LoadPPM(true);
+  LoadTexture(filepath, image, residency, uploader);
+}
+
+void Texture::LoadTextures(
+    const std::vector<std::pair<Texture *, std::string>> &textures,
+    Residency residency, GpuUploader *uploader) {
+  // Files in the archive are loaded in place below; the others are read
+  // all at once and parsed on the reader's workers
+  AsyncFileReader &reader = AsyncFileReader::Instance();
+  std::vector<Image *> images(textures.size(), nullptr);
+  std::vector<char> parsed(textures.size(), 0);
+  for (size_t i = 0; i < textures.size(); i++) {
+    const std::string &path = textures[i].second;
+    if (AssetArchive::Instance().Find(path).kind == AssetKind::Texture) {
+      continue;
+    }
+    images[i] = new Image(path);
+    Image *image = images[i];
+    char *ok = &parsed[i];
+    reader.Read(path, [image, ok](FileReadResult &result) {
+      *ok = result.ok && image->LoadPPM(result.data.data(), result.data.size(),
+                                        true);
+    });
+  }
+  reader.Wait();
+  for (size_t i = 0; i < textures.size(); i++) {
+    Texture *texture = textures[i].first;
+    const std::string &path = textures[i].second;
+    if (parsed[i]) {
+      texture->LoadTexture(path, images[i], residency, uploader);
+    } else {
+      // The archive's copy, or the old way (which reports the problem)
+      delete images[i];
+      texture->LoadTexture(path, residency, uploader);
+    }
   }
 }
 
-void Texture::LoadTexture(const std::string filepath) {
+void Texture::LoadTexture(const std::string filepath, Image *image,
+                          Residency residency, GpuUploader *uploader) {
+  // Release a previously loaded texture
+  Release();
   // Set member variable
   m_filepath = filepath;
-  // Load our actual image data
-  // This method loads .ppm files of pixel data
-  m_image = new Image(filepath);
-  m_image->LoadPPM(true);
+  m_image = image;
+
+  // The upload thread gets a copy of the pixels and builds the same
+  // texture, so the frame does not wait for glTexImage2D and the mip chain.
+  // Pixels in the mounted archive are read from there, without a copy.
+  if (uploader != nullptr) {
+    TextureUpload upload;
+    upload.width = m_image->GetWidth();
+    upload.height = m_image->GetHeight();
+    const uint8_t *pixels = m_image->GetPixelDataPtr();
+    size_t pixelBytes = size_t(upload.width) * upload.height * 3;
+    if (m_image->IsArchiveView()) {
+      upload.external = pixels;
+      upload.externalBytes = pixelBytes;
+    } else {
+      upload.pixels.assign(pixels, pixels + pixelBytes);
+    }
+    size_t bytes = ResourceTracker::TextureBytes(upload.width, upload.height,
+                                                 3, true);
+    m_uploader = uploader;
+    m_uploadTicket = uploader->UploadTexture(
+        std::move(upload), [this, filepath, bytes](const UploadResult &result) {
+          m_uploadTicket = 0;
+          m_textureID = result.texture;
+          ResourceTracker::Instance().TrackGpu(GpuResourceKind::Texture,
+                                               m_textureID, bytes, GL_RGB8,
+                                               "Texture:" + filepath);
+        });
+    if (residency != Residency::CpuAndGpu) {
+      delete m_image;
+      m_image = nullptr;
+    }
+    return;
+  }
 
-  glEnable(GL_TEXTURE_2D);
   // Generate a buffer for our texture
   glGenTextures(1, &m_textureID);
   // Similar to our vertex buffers, we now 'select'
   // a texture we want to bind to.
   // Note the type of data is 'GL_TEXTURE_2D'
-  glBindTexture(GL_TEXTURE_2D, m_textureID);
+  GLState::Instance().BindTexture(0, GL_TEXTURE_2D, m_textureID);
   // Now we are going to setup some information about
   // our textures.
   // There are four parameters that must be set.
@@ -56,8 +143,18 @@ void Texture::LoadTexture(const std::string filepath) {
   // We are done with our texture data so we can unbind.
   // Generate a mipmap
   glGenerateMipmap(GL_TEXTURE_2D);
-  // We are done with our texture data so we can unbind.
-  glBindTexture(GL_TEXTURE_2D, 0);
+  // Record the texture (and its mip chain) with the tracker
+  ResourceTracker::Instance().TrackGpu(
+      GpuResourceKind::Texture, m_textureID,
+      ResourceTracker::TextureBytes(m_image->GetWidth(), m_image->GetHeight(),
+                                    3, true),
+      GL_RGB8, "Texture:" + filepath);
+
+  // The pixels now live on the GPU
+  if (residency != Residency::CpuAndGpu) {
+    delete m_image;
+    m_image = nullptr;
+  }
 }
 
 // slot tells us which slot we want to bind to.
@@ -69,9 +166,10 @@ void Texture::Bind(unsigned int slot) const {
   // be multiple at once.
   // At the time of writing, OpenGL supports 8-32 depending
   // on your hardware.
-  glEnable(GL_TEXTURE_2D);
-  glActiveTexture(GL_TEXTURE0 + slot);
-  glBindTexture(GL_TEXTURE_2D, m_textureID);
+  // GLState skips the calls when the texture is already there.
+  GLState::Instance().BindTexture(slot, GL_TEXTURE_2D, m_textureID);
 }
 
-void Texture::Unbind() { glBindTexture(GL_TEXTURE_2D, 0); }
+void Texture::Unbind(unsigned int slot) {
+  GLState::Instance().BindTexture(slot, GL_TEXTURE_2D, 0);
+}
@@ -13,6 +13,7 @@
 #include <glm/vec3.hpp>
 
 // C++ Standard Template Library (STL)
+#include <algorithm>
 #include <chrono>
 #include <fstream>
 #include <iostream>
@@ -21,8 +22,21 @@
 #include <vector>
 
 // Our libraries
+#include "AssetArchive.hpp"
 #include "Camera.hpp"
+#include "ForsythTuner.hpp"
+#include "FrameStats.hpp"
+#include "GLDebug.hpp"
+#include "GLState.hpp"
+#include "GpuCulling.hpp"
+#include "GpuTimer.hpp"
+#include "GpuUploader.hpp"
+#include "Impostor.hpp"
 #include "OBJModel.hpp"
+#include "PerfHud.hpp"
+#include "RedrawScheduler.hpp"
+#include "ResourceTracker.hpp"
+#include "SharedMetrics.hpp"
 #include "Texture.hpp"
 
 // vvvvvvvvvvvvvvvvvvvvvvvvvv Globals vvvvvvvvvvvvvvvvvvvvvvvvvv
@@ -79,28 +93,48 @@ std::string filepath;
 // Texture
 Texture gTexture;
 
+// Performance overlay (toggled with 'H') and the GPU time it shows
+PerfHud gPerfHud;
+GpuTimer gGpuTimer;
+
+// Live metrics for other processes (read them with tools/MetricsReader.cpp)
+MetricsPublisher gMetrics;
+
+// Only draw when something changed (toggle with 'C', see main())
+RedrawScheduler gRedraw;
+
+// Models and textures are uploaded on a second thread, with a context that
+// shares its objects with gOpenGLContext
+SDL_GLContext gUploadContext = nullptr;
+GpuUploader gUploader;
+const int kUploadPollMs = 4; // How often the loop checks on pending uploads
+
+// A forest of copies of the model (toggle with 'F'). Far away copies are
+// drawn as impostors from an atlas that is baked when the model changes.
+bool gForest = false;
+const int kForestSide = 64;      // Copies per row and column
+const float kForestSpacing = 3.0f; // Copies are scaled to a radius of 1
+std::vector<ImpostorInstance> gForestInstances;
+ImpostorSelection gForestSelection;
+ImpostorLodSettings gImpostorLod;
+ImpostorAtlas gImpostorAtlas;
+ImpostorRenderer gImpostorRenderer;
+std::string gImpostorModel; // The model the atlas was baked from
+
+// The forest culled and drawn by the GPU (toggle with 'G'): every copy is
+// the model, a compute shader keeps the visible ones and one indirect draw
+// call draws them (OpenGL 4.3, see GpuCulling.hpp)
+bool gGpuForest = false;
+GpuCuller gGpuCuller;
+GLuint gGpuPipelineShaderProgram = 0; // shaders/vert_gpu.glsl + frag.glsl
+std::string gGpuForestModel; // The model the culler's objects were made for
+
 // ^^^^^^^^^^^^^^^^^^^^^^^^ Globals ^^^^^^^^^^^^^^^^^^^^^^^^^^^
 
 // vvvvvvvvvvvvvvvvvvv Error Handling Routines vvvvvvvvvvvvvvv
-static void GLClearAllErrors() {
-  while (glGetError() != GL_NO_ERROR) {
-  }
-}
-
-// Returns true if we have an error
-static bool GLCheckErrorStatus(const char *function, int line) {
-  while (GLenum error = glGetError()) {
-    std::cout << "OpenGL Error:" << error << "\tLine: " << line
-              << "\tfunction: " << function << std::endl;
-    return true;
-  }
-  return false;
-}
-
-#define GLCheck(x)                                                             \
-  GLClearAllErrors();                                                          \
-  x;                                                                           \
-  GLCheckErrorStatus(#x, __LINE__);
+// OpenGL errors and performance warnings are reported by the driver through
+// the KHR_debug callback in debug builds (see GLDebug.hpp). Wrap a call in
+// GL_CHECK(...) to have messages show where they came from.
 // ^^^^^^^^^^^^^^^^^^^ Error Handling Routines ^^^^^^^^^^^^^^^
 
 /**
@@ -224,6 +258,9 @@ GLuint CreateShaderProgram(const std::string &vertexShaderSource,
   glDeleteShader(myVertexShader);
   glDeleteShader(myFragmentShader);
 
+  ResourceTracker::Instance().TrackGpu(GpuResourceKind::Program,
+                                       programObject, 0, 0, "main");
+
   return programObject;
 }
 
@@ -238,6 +275,12 @@ void CreateGraphicsPipeline() {
 
   gGraphicsPipelineShaderProgram =
       CreateShaderProgram(vertexShaderSource, fragmentShaderSource);
+
+  // Only where the culler could be created (OpenGL 4.3)
+  if (gGpuCuller.IsCreated()) {
+    gGpuPipelineShaderProgram = CreateShaderProgram(
+        LoadShaderAsString("./shaders/vert_gpu.glsl"), fragmentShaderSource);
+  }
 }
 
 /**
@@ -259,6 +302,10 @@ void InitializeProgram() {
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
   SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+#if ENGINE_GL_DEBUG
+  // Drivers only promise debug messages on a debug context
+  SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+#endif
   // We want to request a double buffer for smooth updating.
   SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
   SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
@@ -288,6 +335,36 @@ void InitializeProgram() {
     std::cout << "glad did not initialize" << std::endl;
     exit(1);
   }
+  GL_DEBUG_INSTALL(SDL_GL_GetProcAddress);
+
+  // Creating the upload context makes it current, so switch back after
+  SDL_GL_SetAttribute(SDL_GL_SHARE_WITH_CURRENT_CONTEXT, 1);
+  gUploadContext = SDL_GL_CreateContext(gGraphicsApplicationWindow);
+  SDL_GL_MakeCurrent(gGraphicsApplicationWindow, gOpenGLContext);
+  if (gUploadContext != nullptr) {
+    SharedContext shared;
+    shared.makeCurrent = []() {
+      return SDL_GL_MakeCurrent(gGraphicsApplicationWindow, gUploadContext) ==
+             0;
+    };
+    shared.doneCurrent = []() {
+      SDL_GL_MakeCurrent(gGraphicsApplicationWindow, nullptr);
+    };
+    gUploader.Start(shared);
+  }
+  if (!gUploader.IsThreaded()) {
+    std::cout << "Uploading on the render thread (no shared context): "
+              << SDL_GetError() << "\n";
+  }
+  objModel.setUploader(&gUploader);
+
+  gPerfHud.Create();
+  gGpuTimer.Create();
+  gImpostorRenderer.Create();
+  if (!gGpuCuller.Create(
+          reinterpret_cast<GLADloadproc>(SDL_GL_GetProcAddress))) {
+    std::cout << "No GPU culled forest: " << gGpuCuller.GetError() << "\n";
+  }
 }
 
 /**
@@ -297,6 +374,70 @@ void InitializeProgram() {
  */
 void VertexSpecification() { objModel.loadModelFromFile(filepath); }
 
+/**
+ * The projection of the scene. The forest reaches much further than the
+ * model alone.
+ *
+ * @return projection matrix
+ */
+glm::mat4 ProjectionMatrix() {
+  float farPlane = gForest ? 300.0f : 10.0f;
+  return glm::perspective(glm::radians(45.0f),
+                          (float)gScreenWidth / (float)gScreenHeight, 0.1f,
+                          farPlane);
+}
+
+/**
+ * Renders the current model from every direction of the impostor atlas and
+ * places the copies of the forest, scaled to a radius of 1.
+ *
+ * @return void
+ */
+void BuildForest() {
+  // Baked once the model has arrived
+  if (!objModel.isReady()) {
+    return;
+  }
+  float radius = objModel.getCopyRadius();
+  const glm::vec3 &center = objModel.getCopyCenter();
+  if (radius <= 0.0f) {
+    return;
+  }
+  GLState &state = GLState::Instance();
+  state.PolygonMode(GL_FILL);
+  state.Enable(GL_DEPTH_TEST);
+  state.UseProgram(gGraphicsPipelineShaderProgram);
+  objModel.SetShaderMaterialUniforms(gGraphicsPipelineShaderProgram);
+  GLuint program = gGraphicsPipelineShaderProgram;
+  glm::mat4 identity(1.0f);
+  glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE,
+                     &identity[0][0]);
+  glUniform1f(glGetUniformLocation(program, "u_Dissolve"), 0.0f);
+  gImpostorAtlas.Bake(center, radius, 8, 128,
+                      [program](const glm::mat4 &view,
+                                const glm::mat4 &projection) {
+                        glUniformMatrix4fv(
+                            glGetUniformLocation(program, "view"), 1,
+                            GL_FALSE, &view[0][0]);
+                        glUniformMatrix4fv(
+                            glGetUniformLocation(program, "projection"), 1,
+                            GL_FALSE, &projection[0][0]);
+                        objModel.renderCopy();
+                      });
+  gImpostorModel = filepath;
+
+  // A square in front of the camera, the centers at y = 0
+  float scale = 1.0f / radius;
+  gForestInstances.clear();
+  for (int row = 0; row < kForestSide; row++) {
+    for (int column = 0; column < kForestSide; column++) {
+      glm::vec3 spot((column - kForestSide / 2) * kForestSpacing, 0.0f,
+                     -4.0f - row * kForestSpacing);
+      gForestInstances.push_back({spot - center * scale, scale, 0.0f});
+    }
+  }
+}
+
 /**
  * PreDraw
  * Typically we will use this for setting some sort of 'state'
@@ -305,20 +446,19 @@ void VertexSpecification() { objModel.loadModelFromFile(filepath); }
  * @return void
  */
 void PreDraw() {
-  // Disable depth test and face culling.
-  glEnable(GL_DEPTH_TEST);
-  glDisable(GL_CULL_FACE);
+  // Enable depth test and disable face culling. These are the same every
+  // frame, so after the first one GLState skips them.
+  GLState &state = GLState::Instance();
+  state.Enable(GL_DEPTH_TEST);
+  state.Disable(GL_CULL_FACE);
 
   // Set the polygon fill mode
-  glPolygonMode(GL_FRONT_AND_BACK, gPolygonMode);
-
-  // Enable texture mapping
-  glEnable(GL_TEXTURE_2D);
+  state.PolygonMode(gPolygonMode);
 
   // Initialize clear color
   // This is the background of the screen.
-  glViewport(0, 0, gScreenWidth, gScreenHeight);
-  glClearColor(0.1f, 0.1f, 0.1f, 1.f);
+  state.Viewport(0, 0, gScreenWidth, gScreenHeight);
+  state.ClearColor(0.1f, 0.1f, 0.1f, 1.f);
 
   // Clear color buffer and Depth Buffer
   glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
@@ -328,7 +468,7 @@ void PreDraw() {
   // otherwise 			 you may not get anything returned.
   // See:
   // https://www.khronos.org/opengl/wiki/GLSL_:_common_mistakes#glUniform_doesn't_work
-  glUseProgram(gGraphicsPipelineShaderProgram);
+  state.UseProgram(gGraphicsPipelineShaderProgram);
 
   // Model transformation by translating our object into world space
   glm::mat4 model =
@@ -360,9 +500,7 @@ void PreDraw() {
   }
 
   // Projection matrix (in perspective)
-  glm::mat4 perspective =
-      glm::perspective(glm::radians(45.0f),
-                       (float)gScreenWidth / (float)gScreenHeight, 0.1f, 10.0f);
+  glm::mat4 perspective = ProjectionMatrix();
 
   // Retrieve our location of our perspective matrix uniform
   GLint u_ProjectionLocation =
@@ -392,6 +530,89 @@ void PreDraw() {
   objModel.SetShaderMaterialUniforms(gGraphicsPipelineShaderProgram);
 }
 
+/**
+ * Draws the forest with the GPU culler: the copies are uploaded once per
+ * model, then each frame costs one dispatch and one draw however many
+ * there are.
+ *
+ * @return void
+ */
+void DrawGpuForest() {
+  if (gGpuForestModel != filepath) {
+    gGpuCuller.Clear();
+    uint32_t mesh =
+        gGpuCuller.AddMesh({static_cast<GLuint>(objModel.getCopyIndexCount()),
+                            0, 0, objModel.getCopyCenter(),
+                            objModel.getCopyRadius()});
+    for (const ImpostorInstance &copy : gForestInstances) {
+      gGpuCuller.AddObject(
+          mesh, glm::scale(glm::translate(glm::mat4(1.0f), copy.position),
+                           glm::vec3(copy.scale)));
+    }
+    gGpuForestModel = filepath;
+  }
+  glm::mat4 view = gCamera.GetViewMatrix();
+  glm::mat4 projection = ProjectionMatrix();
+  gGpuCuller.Cull(projection * view);
+
+  GLuint program = gGpuPipelineShaderProgram;
+  GLState::Instance().UseProgram(program);
+  glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE,
+                     &view[0][0]);
+  glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1,
+                     GL_FALSE, &projection[0][0]);
+  glUniform3f(glGetUniformLocation(program, "u_CameraPosition"),
+              gCamera.GetEyeXPosition(), gCamera.GetEyeYPosition(),
+              gCamera.GetEyeZPosition());
+  glUniform1f(glGetUniformLocation(program, "u_Dissolve"), 0.0f);
+  objModel.SetShaderMaterialUniforms(program);
+  objModel.renderCopies(gGpuCuller);
+  // PreDraw() expects the main program
+  GLState::Instance().UseProgram(gGraphicsPipelineShaderProgram);
+}
+
+/**
+ * Draws the forest: copies that are big on screen as the model, the others
+ * as impostors in one draw call, and both while they cross-fade.
+ *
+ * @return void
+ */
+void DrawForest() {
+  if (gImpostorModel != filepath) {
+    BuildForest();
+    // Baking changed the viewport and the uniforms
+    PreDraw();
+  }
+  if (gGpuForest && gImpostorModel == filepath) {
+    DrawGpuForest();
+    return;
+  }
+  glm::vec3 eye(gCamera.GetEyeXPosition(), gCamera.GetEyeYPosition(),
+                gCamera.GetEyeZPosition());
+  SelectImpostors(gForestInstances.data(), gForestInstances.size(),
+                  objModel.getCopyCenter(), objModel.getCopyRadius(), eye,
+                  glm::radians(45.0f), static_cast<float>(gScreenHeight),
+                  gImpostorLod, gForestSelection);
+
+  GLint modelLocation =
+      glGetUniformLocation(gGraphicsPipelineShaderProgram, "model");
+  GLint dissolveLocation =
+      glGetUniformLocation(gGraphicsPipelineShaderProgram, "u_Dissolve");
+  for (size_t i = 0; i < gForestSelection.meshes.size(); i++) {
+    const ImpostorInstance &copy =
+        gForestInstances[gForestSelection.meshes[i]];
+    glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), copy.position),
+                                 glm::vec3(copy.scale));
+    glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &model[0][0]);
+    glUniform1f(dissolveLocation, gForestSelection.meshFades[i]);
+    objModel.renderCopy();
+  }
+  glUniform1f(dissolveLocation, 0.0f);
+
+  gImpostorRenderer.Draw(gImpostorAtlas, gForestSelection.impostors,
+                         gCamera.GetViewMatrix(), ProjectionMatrix(), eye);
+}
+
 /**
  * Draw
  * The render function gets called once per loop.
@@ -405,7 +626,11 @@ void Draw() {
   const size_t maxFrameSamples = 1000;
   auto startTime = std::chrono::high_resolution_clock::now();
 
-  objModel.render();
+  if (gForest) {
+    DrawForest();
+  } else {
+    objModel.render();
+  }
 
   auto endTime = std::chrono::high_resolution_clock::now();
   frameTimes.push_back(
@@ -420,9 +645,8 @@ void Draw() {
     frameTimes.clear();
   }
 
-  // Stop using our current graphics pipeline
-  // Note: This is not necessary if we only have one graphics pipeline.
-  glUseProgram(0);
+  // The program stays in use: the next frame binds it again anyway, and
+  // GLState skips that call if nothing else was bound in between.
 }
 
 /**
@@ -446,10 +670,18 @@ void getOpenGLVersionInfo() {
 bool KeyPressed1 = false;
 bool KeyPressed2 = false;
 bool KeyPressed3 = false;
+bool KeyPressed4 = false;
+bool KeyPressed5 = false;
+bool KeyPressed6 = false;
 bool KeyPressed7 = false;
 bool KeyPressed8 = false;
 bool KeyPressed9 = false;
 bool KeyPressed0 = false;
+bool KeyPressedM = false;
+bool KeyPressedH = false;
+bool KeyPressedC = false;
+bool KeyPressedF = false;
+bool KeyPressedG = false;
 void Input() {
   // Event handler that handles various events in SDL
   // that are related to input and output
@@ -466,6 +698,10 @@ void Input() {
       std::cout << "ESC: Goodbye! (Leaving MainApplicationLoop())" << std::endl;
       gQuit = true;
     }
+    // Exposed, resized, restored, ...: the window needs its pixels again
+    if (e.type == SDL_WINDOWEVENT) {
+      gRedraw.MarkDirty();
+    }
   }
 
   // Retrieve keyboard state
@@ -503,12 +739,33 @@ void Input() {
     KeyPressed2 = false;
   }
   if (state[SDL_SCANCODE_3] && !KeyPressed3) {
-    std::cout << "Randomized indices!" << std::endl;
+    std::cout << "Randomized triangles!" << std::endl;
     objModel.setCacheMode(3);
     KeyPressed3 = true;
   } else if (!state[SDL_SCANCODE_3]) {
     KeyPressed3 = false;
   }
+  if (state[SDL_SCANCODE_4] && !KeyPressed4) {
+    std::cout << "Morton ordered triangles!" << std::endl;
+    objModel.setCacheMode(4);
+    KeyPressed4 = true;
+  } else if (!state[SDL_SCANCODE_4]) {
+    KeyPressed4 = false;
+  }
+  if (state[SDL_SCANCODE_5] && !KeyPressed5) {
+    std::cout << "Hilbert ordered triangles!" << std::endl;
+    objModel.setCacheMode(5);
+    KeyPressed5 = true;
+  } else if (!state[SDL_SCANCODE_5]) {
+    KeyPressed5 = false;
+  }
+  if (state[SDL_SCANCODE_6] && !KeyPressed6) {
+    std::cout << "Adversarial triangle order!" << std::endl;
+    objModel.setCacheMode(6);
+    KeyPressed6 = true;
+  } else if (!state[SDL_SCANCODE_6]) {
+    KeyPressed6 = false;
+  }
 
   // Switch obj file to render
   if (state[SDL_SCANCODE_7] && !KeyPressed7) {
@@ -544,6 +801,65 @@ void Input() {
     KeyPressed0 = false;
   }
 
+  // Print a report of all GPU and CPU memory in use, and of the GL state
+  // calls issued and filtered so far
+  if (state[SDL_SCANCODE_M] && !KeyPressedM) {
+    ResourceTracker::Instance().DumpReport(std::cout);
+    GLState::Instance().PrintReport(std::cout);
+    KeyPressedM = true;
+  } else if (!state[SDL_SCANCODE_M]) {
+    KeyPressedM = false;
+  }
+
+  // Show or hide the performance overlay
+  if (state[SDL_SCANCODE_H] && !KeyPressedH) {
+    gPerfHud.Toggle();
+    KeyPressedH = true;
+  } else if (!state[SDL_SCANCODE_H]) {
+    KeyPressedH = false;
+  }
+
+  // Switch between on-demand and continuous rendering
+  if (state[SDL_SCANCODE_C] && !KeyPressedC) {
+    gRedraw.ToggleMode();
+    std::cout << "Rendering: " << RedrawModeName(gRedraw.GetMode())
+              << std::endl;
+    KeyPressedC = true;
+  } else if (!state[SDL_SCANCODE_C]) {
+    KeyPressedC = false;
+  }
+
+  // Show the model alone or a forest of it
+  if (state[SDL_SCANCODE_F] && !KeyPressedF) {
+    gForest = !gForest;
+    if (gForest) {
+      std::cout << "Forest of " << kForestSide * kForestSide
+                << " copies (impostors when far away)" << std::endl;
+    } else {
+      std::cout << "Forest off" << std::endl;
+    }
+    KeyPressedF = true;
+  } else if (!state[SDL_SCANCODE_F]) {
+    KeyPressedF = false;
+  }
+
+  // Cull and draw the forest on the GPU instead
+  if (state[SDL_SCANCODE_G] && !KeyPressedG) {
+    if (gGpuPipelineShaderProgram == 0) {
+      std::cout << "No GPU culled forest: " << gGpuCuller.GetError()
+                << std::endl;
+    } else {
+      gGpuForest = !gGpuForest;
+      gForest = gForest || gGpuForest;
+      std::cout << "GPU culled forest " << (gGpuForest ? "on" : "off")
+                << (gGpuCuller.HasDrawCount() ? "" : " (no draw count)")
+                << std::endl;
+    }
+    KeyPressedG = true;
+  } else if (!state[SDL_SCANCODE_G]) {
+    KeyPressedG = false;
+  }
+
   // Camera
   // Update our position of the camera
   if (state[SDL_SCANCODE_W]) {
@@ -576,6 +892,45 @@ void Input() {
   gCamera.MouseLook(mouseX, mouseY);
 }
 
+/**
+ * Everything a frame is drawn from, folded into one value so that the
+ * RedrawScheduler notices when any of it changes.
+ *
+ * @return hash of the camera, model, settings and overlay
+ */
+uint64_t SceneStateHash() {
+  glm::mat4 viewMatrix = gCamera.GetViewMatrix();
+  uint64_t hash = HashValue(viewMatrix);
+  hash = HashValue(g_uOffset, hash);
+  hash = HashValue(g_uRotate, hash);
+  hash = HashValue(gPolygonMode, hash);
+  hash = HashValue(objModel.getCacheMode(), hash);
+  hash = HashState(filepath.data(), filepath.size(), hash);
+  hash = HashValue(gPerfHud.IsVisible(), hash);
+  hash = HashValue(gForest, hash);
+  hash = HashValue(gGpuForest, hash);
+  return hash;
+}
+
+/**
+ * Publishes this frame's metrics in shared memory (see SharedMetrics.hpp).
+ * Never blocks, however many readers there are. Called on idle iterations
+ * too, so readers can tell a static scene from a program that hangs.
+ *
+ * @return void
+ */
+void PublishMetrics() {
+  if (!gMetrics.IsOpen()) {
+    return;
+  }
+  MetricsSnapshot snapshot{};
+  CollectMetrics(snapshot);
+  snapshot.cacheMode = objModel.getCacheMode();
+  SetMetricsText(snapshot.program, "part1");
+  SetMetricsText(snapshot.model, filepath);
+  gMetrics.Publish(snapshot);
+}
+
 /**
  * Main Application Loop
  * This is an infinite loop in our graphics application
@@ -590,10 +945,34 @@ void MainLoop() {
 
   // While application is running
   while (!gQuit) {
+    // Nothing changed since the last frame: sleep until an event arrives
+    // (or the idle timeout passes) instead of drawing the same image again
+    if (!gRedraw.IsFrameDue()) {
+      int timeout = gRedraw.GetWaitTimeout();
+      if (gUploader.GetPending() > 0) {
+        timeout = std::min(timeout, kUploadPollMs);
+      }
+      SDL_WaitEventTimeout(nullptr, timeout);
+    }
     // Handle Input
     Input();
+    // Whatever finished uploading is drawn from this frame on
+    if (gUploader.Poll() > 0) {
+      gRedraw.MarkDirty();
+    }
+    gRedraw.Watch(SceneStateHash());
+    if (!gRedraw.BeginFrame()) {
+      PublishMetrics();
+      continue;
+    }
     // Setup anything (i.e. OpenGL State) that needs to take
     // place before draw calls
+    // Collect GPU times of earlier frames, then time this one
+    float gpuMilliseconds;
+    if (gGpuTimer.Poll(gpuMilliseconds)) {
+      FrameStats::Instance().AddGpuTime(gpuMilliseconds);
+    }
+    gGpuTimer.Begin();
     PreDraw();
     // Draw Calls in OpenGL
     // When we 'draw' in OpenGL, this activates the graphics pipeline.
@@ -601,8 +980,14 @@ void MainLoop() {
     //      The pipeline that is utilized is whatever 'glUseProgram' is
     //      currently binded.
     Draw();
+    gGpuTimer.End();
+    // The overlay goes on top of everything (and is not timed itself)
+    gPerfHud.Draw(gScreenWidth, gScreenHeight);
     // Update screen of our specified window
     SDL_GL_SwapWindow(gGraphicsApplicationWindow);
+    GL_DEBUG_END_FRAME();
+    FrameStats::Instance().EndFrame();
+    PublishMetrics();
   }
 }
 
@@ -614,16 +999,37 @@ void MainLoop() {
  * @return void
  */
 void CleanUp() {
-  // Destroy our SDL2 Window
-  SDL_DestroyWindow(gGraphicsApplicationWindow);
-  gGraphicsApplicationWindow = nullptr;
-
-  // Delete our OpenGL Objects
-  //   glDeleteBuffers(1, &gVertexBufferObject);
-  //   glDeleteVertexArrays(1, &gVertexArrayObject);
+  // Hand over (or wait for) what is still uploading, so it is deleted below
+  gUploader.Stop();
+
+  // Delete our OpenGL Objects while the context is still alive
+  objModel.unload();
+  gTexture.Release();
+  gPerfHud.Release();
+  gGpuTimer.Release();
+  gImpostorAtlas.Release();
+  gImpostorRenderer.Release();
+  gGpuCuller.Release();
+  gMetrics.Close();
 
   // Delete our Graphics pipeline
+  ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Program,
+                                         gGraphicsPipelineShaderProgram);
   glDeleteProgram(gGraphicsPipelineShaderProgram);
+  ResourceTracker::Instance().UntrackGpu(GpuResourceKind::Program,
+                                         gGpuPipelineShaderProgram);
+  glDeleteProgram(gGpuPipelineShaderProgram);
+
+  // Everything should have been released at this point
+  ResourceTracker::Instance().ShutdownCheck(std::cerr);
+
+  // Destroy our OpenGL contexts and SDL2 Window
+  if (gUploadContext != nullptr) {
+    SDL_GL_DeleteContext(gUploadContext);
+  }
+  SDL_GL_DeleteContext(gOpenGLContext);
+  SDL_DestroyWindow(gGraphicsApplicationWindow);
+  gGraphicsApplicationWindow = nullptr;
 
   // Quit SDL subsystems
   SDL_Quit();
@@ -638,13 +1044,59 @@ int main(int argc, char *args[]) {
   std::cout << "Use arrow keys to move and rotate\n";
   std::cout << "Use wasd to move\n";
   std::cout << "Use TAB to toggle wireframe\n";
+  std::cout << "Press M to print a memory report\n";
+  std::cout << "Press H to show the performance overlay\n";
+  std::cout << "Press C to switch between on-demand and continuous "
+               "rendering\n";
+  std::cout << "Press F to show a forest of the model (impostors far away)\n";
+  std::cout << "Press G to cull and draw the forest on the GPU\n";
   std::cout << "Press ESC to quit\n";
 
   filepath = "./../common/objects/tree_3/HandpaintedTree.obj";
 
+  // Cooked assets (tools/AssetCook.cpp) unless ENGINE_ASSETS=off; the
+  // loose files otherwise
+  AssetArchive &archive = AssetArchive::Instance();
+  if (archive.MountFromEnvironment("./../common/assets.pak", "part1")) {
+    std::cout << "Assets: " << archive.GetPath() << " ("
+              << archive.GetEntryCount() << " entries)\n";
+  } else {
+    std::cout << "Assets: loose files (" << archive.GetError() << ")\n";
+  }
+
+  // Draw only when something changes, unless benchmarking (--continuous
+  // or ENGINE_REDRAW=continuous)
+  gRedraw.SetMode(RedrawModeFromArgs(argc, args));
+  std::cout << "Rendering: " << RedrawModeName(gRedraw.GetMode()) << "\n";
+
+  // --forsyth PRESET: reorder for another vertex cache (see ForsythTuner.hpp)
+  for (int i = 1; i + 1 < argc; i++) {
+    if (std::string(args[i]) != "--forsyth") {
+      continue;
+    }
+    ForsythParams params;
+    if (FindForsythPreset(args[i + 1], params)) {
+      objModel.setForsythParams(params);
+      std::cout << "Forsyth preset: " << args[i + 1] << "\n";
+    } else {
+      std::cerr << "Unknown Forsyth preset " << args[i + 1] << "\n";
+    }
+  }
+
   // 1. Setup the graphics program
   InitializeProgram();
 
+  // Publish live metrics unless ENGINE_METRICS_SHM=off
+  std::string metricsName = MetricsName("part1");
+  if (!metricsName.empty()) {
+    if (gMetrics.Open(metricsName)) {
+      std::cout << "Publishing metrics to " << metricsName
+                << " (read them with metrics_reader)\n";
+    } else {
+      std::cerr << "No live metrics: " << gMetrics.GetError() << "\n";
+    }
+  }
+
   // 2. Setup our geometry
   VertexSpecification();
 
@@ -0,0 +1,224 @@
+#include "AssetArchive.hpp"
+#include "AssetCooker.hpp"
+#include "ObjParser.hpp"
+#include "TestHarness.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static const char kObj[] = "mtllib quad.mtl\n"
+                           "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+                           "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvn 0 0 1\n"
+                           "f 1/1/1 2/2/1 3/3/1 4/4/1\n";
+static const char kMtl[] = "newmtl quad\nmap_Kd quad.ppm\n";
+// Two rows of two pixels: red, green / blue, white
+static const char kPpm[] = "P3\n# a comment\n2 2\n255\n"
+                           "255 0 0\n0 255 0\n0 0 255 255 255 255\n";
+
+// A directory of its own, removed again when the test ends
+struct TestTree {
+  fs::path root;
+
+  TestTree() {
+    root = fs::temp_directory_path() /
+           ("cs5310_assets_" +
+            std::to_string(
+                std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directories(root / "models" / "quad");
+    Write("models/quad/quad.obj", kObj);
+    Write("models/quad/quad.mtl", kMtl);
+    Write("models/quad/quad.ppm", kPpm);
+    Write("models/quad/notes.txt", "not an asset");
+  }
+  ~TestTree() {
+    AssetArchive::Instance().Unmount();
+    std::error_code code;
+    fs::remove_all(root, code);
+  }
+  void Write(const std::string &name, const std::string &text) const {
+    std::ofstream(root / name, std::ios::binary) << text;
+  }
+  std::string Path(const std::string &name) const {
+    return (root / name).string();
+  }
+  bool Cook(CookStats &stats) const {
+    return CookAssets(root.string(), {"models"}, Path("assets.pak"), stats);
+  }
+};
+
+TEST(CooksMeshesTexturesAndMaterials) {
+  TestTree tree;
+  CookStats stats;
+  REQUIRE(tree.Cook(stats));
+  CHECK_EQ(size_t(1), stats.meshes);
+  CHECK_EQ(size_t(1), stats.textures);
+  CHECK_EQ(size_t(1), stats.raw);
+  CHECK_EQ(size_t(1), stats.skipped); // notes.txt
+
+  AssetArchive archive;
+  REQUIRE(archive.Mount(tree.Path("assets.pak"), ""));
+  CHECK_EQ(3u, archive.GetEntryCount());
+  CHECK_EQ(uint64_t(fs::file_size(tree.root / "assets.pak")),
+           uint64_t(archive.GetSize()));
+  AssetView mesh = archive.FindKey("models/quad/quad.obj");
+  AssetView texture = archive.FindKey("models/quad/quad.ppm");
+  AssetView material = archive.FindKey("models/quad/quad.mtl");
+  REQUIRE(mesh.IsValid() && texture.IsValid() && material.IsValid());
+  CHECK(mesh.kind == AssetKind::Mesh);
+  CHECK(material.kind == AssetKind::Raw);
+  CHECK(!archive.FindKey("models/quad/notes.txt").IsValid());
+  CHECK(!archive.FindKey("models/quad").IsValid());
+
+  // Every payload starts on a page of its own
+  const uint8_t *base = mesh.data - reinterpret_cast<uintptr_t>(mesh.data) %
+                                        kArchiveAlignment;
+  for (const AssetView &view : {mesh, texture, material}) {
+    CHECK_EQ(size_t(0), size_t(view.data - base) % kArchiveAlignment);
+  }
+  CHECK_EQ(std::string(kMtl),
+           std::string(reinterpret_cast<const char *>(material.data),
+                       material.size));
+
+  // The texture is flipped like Image::LoadPPM(true): white pixel first
+  CHECK(texture.kind == AssetKind::Texture);
+  CHECK_EQ(2u, texture.width);
+  CHECK_EQ(2u, texture.height);
+  REQUIRE(texture.size == 12);
+  const uint8_t expected[12] = {255, 255, 255, 0, 0, 255,
+                                0,   255, 0,   255, 0, 0};
+  CHECK(std::memcmp(expected, texture.data, sizeof(expected)) == 0);
+
+  // The cooked mesh is what the parser makes of the file
+  ObjData parsed, cooked;
+  REQUIRE(ParseObj(kObj, std::strlen(kObj), parsed));
+  REQUIRE(ReadCookedMesh(mesh, cooked));
+  CHECK_EQ(parsed.materialLibrary, cooked.materialLibrary);
+  REQUIRE(parsed.corners.size() == cooked.corners.size());
+  REQUIRE(parsed.positions.size() == cooked.positions.size());
+  CHECK(std::memcmp(parsed.corners.data(), cooked.corners.data(),
+                    parsed.corners.size() * sizeof(ObjIndex)) == 0);
+  CHECK(parsed.positions == cooked.positions);
+  CHECK(parsed.texCoords == cooked.texCoords);
+  CHECK(parsed.normals == cooked.normals);
+}
+
+TEST(FindUsesTheMountPoint) {
+  TestTree tree;
+  CookStats stats;
+  REQUIRE(tree.Cook(stats));
+  AssetArchive archive;
+  // As if the program ran in <root>/models/quad
+  REQUIRE(archive.Mount(tree.Path("assets.pak"), "models/quad"));
+  CHECK(archive.Find("quad.obj").IsValid());
+  CHECK(archive.Find("./quad.obj").IsValid());
+  CHECK(archive.Find("./../quad/quad.ppm").IsValid());
+  CHECK(archive.Find("..\\quad\\quad.mtl").IsValid());
+  CHECK(!archive.Find("missing.obj").IsValid());
+  CHECK(!archive.Find("/models/quad/quad.obj").IsValid());
+  // Outside of the directory that was cooked
+  CHECK(!archive.Find("../../../models/quad/quad.obj").IsValid());
+  archive.Prefetch(archive.Find("quad.ppm")); // Only a hint
+}
+
+TEST(LoadersReadFromTheMountedArchive) {
+  TestTree tree;
+  CookStats stats;
+  REQUIRE(tree.Cook(stats));
+  REQUIRE(AssetArchive::Instance().Mount(tree.Path("assets.pak"), ""));
+  // The loose files are gone; the loaders do not notice
+  fs::remove(tree.root / "models" / "quad" / "quad.obj");
+  fs::remove(tree.root / "models" / "quad" / "quad.mtl");
+  ObjData data;
+  REQUIRE(LoadObjFile("models/quad/quad.obj", data));
+  CHECK_EQ(size_t(2), data.GetTriangleCount());
+  CHECK_EQ(std::string("quad.mtl"), data.materialLibrary);
+  std::string text;
+  REQUIRE(ReadFileToString("./models/quad/quad.mtl", text));
+  CHECK_EQ(std::string(kMtl), text);
+
+  // Files that are not in the archive are still read from disk
+  REQUIRE(ReadFileToString(tree.Path("models/quad/notes.txt"), text));
+  CHECK_EQ(std::string("not an asset"), text);
+  AssetArchive::Instance().Unmount();
+  CHECK(!LoadObjFile("models/quad/quad.obj", data));
+}
+
+TEST(DamagedArchivesAreRefused) {
+  TestTree tree;
+  CookStats stats;
+  REQUIRE(tree.Cook(stats));
+  std::string good;
+  REQUIRE(ReadFileToString(tree.Path("assets.pak"), good));
+  AssetArchive archive;
+
+  // Truncated
+  tree.Write("short.pak", good.substr(0, good.size() - 1));
+  CHECK(!archive.Mount(tree.Path("short.pak"), ""));
+  CHECK(!archive.IsMounted());
+  CHECK(!archive.GetError().empty());
+  tree.Write("tiny.pak", good.substr(0, 20));
+  CHECK(!archive.Mount(tree.Path("tiny.pak"), ""));
+
+  // Not an archive
+  tree.Write("text.pak", std::string(kObj));
+  CHECK(!archive.Mount(tree.Path("text.pak"), ""));
+
+  // A flipped bit in a path no longer matches its hash
+  ArchiveHeader header;
+  std::memcpy(&header, good.data(), sizeof(header));
+  std::string damaged = good;
+  damaged[header.namesOffset] ^= 1;
+  tree.Write("damaged.pak", damaged);
+  CHECK(!archive.Mount(tree.Path("damaged.pak"), ""));
+
+  // A newer format
+  damaged = good;
+  damaged[8] = static_cast<char>(kArchiveVersion + 1);
+  tree.Write("newer.pak", damaged);
+  CHECK(!archive.Mount(tree.Path("newer.pak"), ""));
+  CHECK(archive.GetError().find("version") != std::string::npos);
+
+  CHECK(!archive.Mount(tree.Path("missing.pak"), ""));
+  REQUIRE(archive.Mount(tree.Path("assets.pak"), ""));
+}
+
+TEST(ParsePpmReadsPlainPpms) {
+  uint32_t width = 0, height = 0;
+  std::vector<uint8_t> pixels;
+  REQUIRE(ParsePpm(kPpm, std::strlen(kPpm), false, width, height, pixels));
+  CHECK_EQ(2u, width);
+  CHECK_EQ(2u, height);
+  REQUIRE(pixels.size() == 12);
+  CHECK_EQ(255, pixels[0]);
+  CHECK_EQ(255, pixels[4]);
+
+  std::string error;
+  const char truncated[] = "P3 2 2 255 1 2 3";
+  CHECK(!ParsePpm(truncated, std::strlen(truncated), false, width, height,
+                  pixels, &error));
+  CHECK(!error.empty());
+  const char binary[] = "P6 1 1 255 abc";
+  CHECK(!ParsePpm(binary, std::strlen(binary), false, width, height, pixels));
+}
+
+TEST(WriterRefusesDuplicateKeys) {
+  TestTree tree;
+  AssetArchiveWriter writer;
+  REQUIRE(writer.Open(tree.Path("dup.pak")));
+  const uint8_t byte = 7;
+  CHECK(writer.Add("a/b.mtl", AssetKind::Raw, &byte, 1));
+  CHECK(!writer.Add("./a//b.mtl", AssetKind::Raw, &byte, 1));
+  CHECK(writer.Finish() > 0);
+  AssetArchive archive;
+  REQUIRE(archive.Mount(tree.Path("dup.pak"), ""));
+  CHECK_EQ(1u, archive.GetEntryCount());
+  AssetView view = archive.FindKey("a/b.mtl");
+  REQUIRE(view.IsValid());
+  CHECK_EQ(7, view.data[0]);
+}
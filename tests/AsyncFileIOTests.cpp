@@ -0,0 +1,172 @@
+#include "AsyncFileIO.hpp"
+#include "TestHarness.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Files of different sizes in a directory of their own
+struct TestFiles {
+  fs::path root;
+  std::vector<std::string> paths;
+  std::vector<std::string> contents;
+
+  TestFiles() {
+    root = fs::temp_directory_path() /
+           ("cs5310_async_" +
+            std::to_string(
+                std::chrono::steady_clock::now().time_since_epoch().count()));
+    fs::create_directories(root);
+    // Empty, smaller than a chunk, exactly a chunk, and many chunks with a
+    // remainder (chunks are 4 KiB in the tests)
+    const size_t sizes[] = {0, 100, 4096, 5 * 4096 + 123, 40000};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+      std::string text(sizes[i], '\0');
+      for (size_t j = 0; j < text.size(); j++) {
+        text[j] = static_cast<char>((j * 31 + i * 7) % 251);
+      }
+      paths.push_back((root / ("file" + std::to_string(i))).string());
+      contents.push_back(text);
+      std::ofstream(paths.back(), std::ios::binary) << text;
+    }
+  }
+  ~TestFiles() {
+    std::error_code code;
+    fs::remove_all(root, code);
+  }
+};
+
+static void ReadsEveryFile(AsyncIoBackend backend) {
+  TestFiles files;
+  AsyncIoOptions options;
+  options.backend = backend;
+  options.queueDepth = 4; // Fewer slots than chunks
+  options.chunkBytes = 4096;
+  options.workers = 2;
+  AsyncFileReader reader(options);
+  if (backend == AsyncIoBackend::Threads) {
+    CHECK(reader.GetBackend() == AsyncIoBackend::Threads);
+  }
+
+  std::mutex mutex;
+  std::vector<std::string> read(files.paths.size());
+  std::vector<bool> ok(files.paths.size(), false);
+  bool onCaller = false;
+  const std::thread::id caller = std::this_thread::get_id();
+  for (size_t i = 0; i < files.paths.size(); i++) {
+    reader.Read(files.paths[i], [&, i](FileReadResult &result) {
+      std::lock_guard<std::mutex> lock(mutex);
+      onCaller = onCaller || std::this_thread::get_id() == caller;
+      ok[i] = result.ok;
+      read[i] = std::move(result.data);
+    });
+  }
+  bool failedOk = true;
+  std::string failedError;
+  reader.Read((files.root / "missing").string(), [&](FileReadResult &result) {
+    std::lock_guard<std::mutex> lock(mutex);
+    failedOk = result.ok;
+    failedError = result.error;
+  });
+  reader.Wait();
+
+  CHECK(!onCaller);
+  for (size_t i = 0; i < files.paths.size(); i++) {
+    CHECK(ok[i]);
+    CHECK(read[i] == files.contents[i]);
+  }
+  CHECK(!failedOk);
+  CHECK(!failedError.empty());
+
+  AsyncIoStats stats = reader.GetStats();
+  CHECK_EQ(uint64_t(files.paths.size() + 1), stats.files);
+  CHECK_EQ(uint64_t(1), stats.failed);
+  uint64_t bytes = 0;
+  for (const std::string &text : files.contents) {
+    bytes += text.size();
+  }
+  CHECK_EQ(bytes, stats.bytes);
+  // 0 + 1 + 1 + 6 + 10 chunks
+  CHECK(stats.reads >= 18);
+  if (reader.GetBackend() == AsyncIoBackend::IoUring) {
+    CHECK(stats.maxInFlight <= 4);
+    CHECK(stats.maxInFlight > 1);
+    // Many reads per system call
+    CHECK(stats.submits < stats.reads);
+  }
+}
+
+TEST(AsyncReaderReadsWithIoUring) {
+  // Falls back to threads where io_uring is not available
+  ReadsEveryFile(AsyncIoBackend::IoUring);
+}
+
+TEST(AsyncReaderReadsWithThreads) { ReadsEveryFile(AsyncIoBackend::Threads); }
+
+static void ReadsRanges(AsyncIoBackend backend) {
+  TestFiles files;
+  AsyncIoOptions options;
+  options.backend = backend;
+  options.chunkBytes = 4096;
+  AsyncFileReader reader(options);
+  const std::string &path = files.paths[4];
+  const std::string &text = files.contents[4];
+
+  std::mutex mutex;
+  std::vector<std::string> read(3);
+  std::vector<bool> ok(3, false);
+  // Within a chunk, across chunks to the last byte, and past the end
+  const uint64_t ranges[3][2] = {{100, 50}, {4000, 36000}, {39990, 20}};
+  for (size_t i = 0; i < 3; i++) {
+    reader.ReadRange(path, ranges[i][0], ranges[i][1],
+                     [&, i](FileReadResult &result) {
+                       std::lock_guard<std::mutex> lock(mutex);
+                       ok[i] = result.ok;
+                       read[i] = std::move(result.data);
+                     });
+  }
+  reader.Wait();
+  CHECK(ok[0]);
+  CHECK(read[0] == text.substr(100, 50));
+  CHECK(ok[1]);
+  CHECK(read[1] == text.substr(4000));
+  CHECK(!ok[2]);
+  CHECK(read[2].empty());
+  AsyncIoStats stats = reader.GetStats();
+  CHECK_EQ(uint64_t(1), stats.failed);
+  CHECK_EQ(uint64_t(36050), stats.bytes);
+}
+
+TEST(AsyncReaderReadsRangesWithIoUring) {
+  ReadsRanges(AsyncIoBackend::IoUring);
+}
+
+TEST(AsyncReaderReadsRangesWithThreads) {
+  ReadsRanges(AsyncIoBackend::Threads);
+}
+
+TEST(AsyncReaderWaitCoversReadsQueuedByCallbacks) {
+  TestFiles files;
+  AsyncIoOptions options;
+  options.chunkBytes = 4096;
+  AsyncFileReader reader(options);
+  std::mutex mutex;
+  size_t second = 0;
+  reader.Read(files.paths[1], [&](FileReadResult &) {
+    // Like a model that asks for its textures once its file is parsed
+    for (const std::string &path : files.paths) {
+      reader.Read(path, [&](FileReadResult &result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        second += result.ok ? 1 : 0;
+      });
+    }
+  });
+  reader.Wait();
+  CHECK_EQ(files.paths.size(), second);
+}
@@ -0,0 +1,118 @@
+#include "CommandBuffer.hpp"
+#include "FrameStats.hpp"
+#include "GLState.hpp"
+#include "GpuTestSupport.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+#include <vector>
+
+// A quad between x0 and x1 (clip space) in one color, both from a block
+static const char *kVertexSource = R"(#version 330 core
+layout(std140) uniform Quad {
+  vec4 color;
+  vec4 span;
+};
+void main() {
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+  gl_Position = vec4(mix(span.x, span.y, corner.x), corner.y * 2.0 - 1.0,
+                     0.0, 1.0);
+}
+)";
+static const char *kFragmentSource = R"(#version 330 core
+layout(std140) uniform Quad {
+  vec4 color;
+  vec4 span;
+};
+out vec4 fragColor;
+void main() { fragColor = color; }
+)";
+
+struct QuadBlock {
+  float color[4];
+  float span[4];
+};
+
+TEST(CommandReplayerDrawsRecordedBuffers) {
+  const int width = 64, height = 16;
+  GLuint fbo = 0, color = 0;
+  glGenFramebuffers(1, &fbo);
+  glGenRenderbuffers(1, &color);
+  glBindRenderbuffer(GL_RENDERBUFFER, color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, color);
+  REQUIRE(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+  glViewport(0, 0, width, height);
+  glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  GLuint program = CompileTestProgram({kVertexSource, kFragmentSource},
+                                      {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER});
+  REQUIRE(program != 0);
+  glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Quad"), 3);
+  GLuint vao = 0; // The corners come from gl_VertexID
+  glGenVertexArrays(1, &vao);
+
+  // Red on the left half, green on the right, from two buffers as if two
+  // workers had recorded them
+  std::vector<CommandBuffer> buffers(2);
+  const QuadBlock quads[2] = {{{1.0f, 0.0f, 0.0f, 1.0f}, {-1.0f, 0.0f}},
+                              {{0.0f, 1.0f, 0.0f, 1.0f}, {0.0f, 1.0f}}};
+  for (int i = 0; i < 2; i++) {
+    buffers[i].BindProgram(program);
+    buffers[i].BindVertexArray(vao);
+    buffers[i].SetUniformBlock(3, &quads[i], sizeof(quads[i]));
+    buffers[i].DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  }
+
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  GLState &state = GLState::Instance();
+  state.Invalidate();
+  FrameStats &stats = FrameStats::Instance();
+  stats.Reset();
+  {
+    CommandReplayer replayer;
+    REQUIRE(replayer.Create());
+    replayer.Replay(buffers.data(), buffers.size());
+    const ReplayStats &replay = replayer.GetLastStats();
+    CHECK_EQ(8u, replay.commands);
+    CHECK_EQ(2u, replay.draws);
+    // The second buffer's program and vertex array were already bound
+    CHECK_EQ(2u, replay.skippedBinds);
+    CHECK_EQ(2 * CommandBuffer::kUniformAlignment, replay.uniformBytes);
+    stats.EndFrame(1.0f);
+    CHECK_EQ(2u, stats.GetLastFrame().drawCalls);
+    // The uniform buffer, the program, the vertex array and two ranges
+    CHECK_EQ(5u, stats.GetLastFrame().stateChanges);
+
+    unsigned char pixels[width * height * 4];
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    const unsigned char *left = pixels + (height / 2 * width + width / 4) * 4;
+    const unsigned char *right =
+        pixels + (height / 2 * width + 3 * width / 4) * 4;
+    CHECK_EQ(255, left[0]);
+    CHECK_EQ(0, left[1]);
+    CHECK_EQ(0, right[0]);
+    CHECK_EQ(255, right[1]);
+
+    // What was bound last stays bound, and GLState knows it
+    CHECK_EQ(0u, state.Validate(nullptr));
+    GLint bound = 0;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &bound);
+    CHECK_EQ(static_cast<GLint>(program), bound);
+    CHECK_EQ(1u, tracker.GetGpuCount(GpuResourceKind::Buffer));
+  }
+  CHECK_EQ(0u, tracker.GetGpuCount(GpuResourceKind::Buffer));
+  stats.Reset();
+
+  state.BindVertexArray(0);
+  state.UseProgram(0);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteProgram(program);
+  state.BindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(1, &color);
+  CHECK(glGetError() == GL_NO_ERROR);
+}
@@ -0,0 +1,112 @@
+#include "CommandBuffer.hpp"
+#include "TestHarness.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+TEST(CommandBufferAlignsUniformBlocks) {
+  CommandBuffer buffer;
+  const float color[4] = {0.25f, 0.5f, 0.75f, 1.0f};
+  const float matrix[16] = {1.0f};
+  buffer.BindProgram(7);
+  buffer.SetUniformBlock(2, color, sizeof(color));
+  buffer.SetUniformBlock(0, matrix, sizeof(matrix));
+  buffer.DrawIndexed(GL_TRIANGLES, 36, 12);
+
+  const std::vector<Command> &commands = buffer.GetCommands();
+  REQUIRE(commands.size() == 4);
+  CHECK(commands[0].type == CommandType::BindProgram);
+  CHECK_EQ(7u, commands[0].a);
+  CHECK(commands[1].type == CommandType::UniformBlock);
+  CHECK_EQ(2, commands[1].slot);
+  CHECK_EQ(0u, commands[1].a);
+  CHECK_EQ(sizeof(color), static_cast<size_t>(commands[1].b));
+  // The second block starts at the next aligned offset
+  CHECK_EQ(CommandBuffer::kUniformAlignment,
+           static_cast<size_t>(commands[2].a));
+  CHECK_EQ(2 * CommandBuffer::kUniformAlignment,
+           buffer.GetUniformData().size());
+  CHECK(std::memcmp(buffer.GetUniformData().data(), color, sizeof(color)) ==
+        0);
+  CHECK(commands[3].type == CommandType::DrawIndexed);
+  CHECK_EQ(static_cast<uint32_t>(GL_TRIANGLES), commands[3].a);
+  CHECK_EQ(36u, commands[3].b);
+  CHECK_EQ(12u, commands[3].c);
+
+  buffer.SetInstances(4);
+  CHECK(buffer.GetCommands().back().type == CommandType::Instances);
+  CHECK_EQ(4u, buffer.GetCommands().back().a);
+
+  buffer.Clear();
+  CHECK(buffer.GetCommands().empty());
+  CHECK(buffer.GetUniformData().empty());
+}
+
+TEST(WorkerPoolRunsEveryChunkOnce) {
+  WorkerPool pool(4);
+  CHECK_EQ(4u, pool.GetThreadCount());
+  std::vector<std::atomic<int>> seen(1000);
+  // The pool is reused, like once per frame
+  for (int run = 0; run < 50; run++) {
+    for (std::atomic<int> &s : seen) {
+      s = 0;
+    }
+    pool.Run(seen.size(), 7, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; i++) {
+        seen[i]++;
+      }
+    });
+    bool once = true;
+    for (const std::atomic<int> &s : seen) {
+      once = once && s == 1;
+    }
+    CHECK(once);
+  }
+  pool.Run(0, 7, [](size_t, size_t) {});
+}
+
+// Each item records a bind, a block with its index and a draw
+static void RecordItems(WorkerPool &pool, size_t count,
+                        std::vector<CommandBuffer> &buffers) {
+  RecordCommands(pool, count, 16, buffers,
+                 [](size_t begin, size_t end, CommandBuffer &out) {
+                   for (size_t i = begin; i < end; i++) {
+                     uint32_t index = static_cast<uint32_t>(i);
+                     out.BindVertexArray(index % 3);
+                     out.SetUniformBlock(0, &index, sizeof(index));
+                     out.DrawArrays(GL_TRIANGLES, 0, 3 * (i + 1));
+                   }
+                 });
+}
+
+TEST(RecordCommandsMergesInOrder) {
+  const size_t count = 1000;
+  WorkerPool single(1), several(4);
+  std::vector<CommandBuffer> expected, actual;
+  RecordItems(single, count, expected);
+  // Recorded again over the old contents
+  RecordItems(several, count, actual);
+  RecordItems(several, count, actual);
+  REQUIRE(expected.size() == (count + 15) / 16);
+  REQUIRE(actual.size() == expected.size());
+
+  size_t draws = 0;
+  bool same = true;
+  for (size_t b = 0; b < actual.size(); b++) {
+    const std::vector<Command> &a = actual[b].GetCommands();
+    const std::vector<Command> &e = expected[b].GetCommands();
+    same = same && a.size() == e.size() &&
+           std::memcmp(a.data(), e.data(), a.size() * sizeof(Command)) == 0 &&
+           actual[b].GetUniformData() == expected[b].GetUniformData();
+    for (const Command &command : a) {
+      if (command.type == CommandType::DrawArrays) {
+        // Draws come out in item order
+        CHECK_EQ(3 * (draws + 1), static_cast<size_t>(command.c));
+        draws++;
+      }
+    }
+  }
+  CHECK(same);
+  CHECK_EQ(count, draws);
+}
@@ -0,0 +1,145 @@
+#include "ComponentStore.hpp"
+#include "TestHarness.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+static const ComponentMask kDrawable = kRenderableComponents;
+
+TEST(EntitiesOfTheSameComponentsShareAnArchetype) {
+  ComponentStore store;
+  Entity a = store.Create(kDrawable);
+  Entity b = store.Create(kDrawable | kStaticTag);
+  Entity c = store.Create(kDrawable);
+  CHECK_EQ(size_t(3), store.GetEntityCount());
+  CHECK_EQ(size_t(2), store.GetArchetypeCount());
+  CHECK_EQ(kDrawable, store.GetMask(a));
+  CHECK_EQ(size_t(2), store.GetArchetype(0).GetSize());
+
+  // Defaults, and the columns it has not got
+  REQUIRE(store.GetTransform(a) != nullptr);
+  CHECK(*store.GetTransform(a) == glm::mat4(1.0f));
+  CHECK(store.GetBounds(a)->w < 0.0f);
+  CHECK(store.GetLod(a) == nullptr);
+  *store.GetMesh(c) = 7;
+  *store.GetMaterial(b) = 3;
+
+  // The last row moves into the hole; handles still find their entity
+  store.Destroy(a);
+  CHECK(!store.IsAlive(a));
+  CHECK(store.GetTransform(a) == nullptr);
+  CHECK_EQ(size_t(1), store.GetArchetype(0).GetSize());
+  CHECK_EQ(7u, *store.GetMesh(c));
+  CHECK(store.GetArchetype(0).GetEntities()[0] == c);
+  store.Destroy(a);
+  CHECK_EQ(size_t(2), store.GetEntityCount());
+
+  // The slot is reused, the old handle stays dead
+  Entity d = store.Create(kTransformComponent);
+  CHECK_EQ(a.index, d.index);
+  CHECK(d != a);
+  CHECK(!store.IsAlive(a));
+  CHECK(store.IsAlive(d));
+  CHECK_EQ(3u, *store.GetMaterial(b));
+}
+
+TEST(ChangingComponentsKeepsTheSharedOnes) {
+  ComponentStore store;
+  Entity a = store.Create(kDrawable);
+  Entity b = store.Create(kDrawable);
+  glm::mat4 moved =
+      glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+  *store.GetTransform(a) = moved;
+  *store.GetMesh(a) = 4;
+
+  store.SetMask(a, kDrawable | kLodComponent);
+  CHECK_EQ(kDrawable | kLodComponent, store.GetMask(a));
+  CHECK(*store.GetTransform(a) == moved);
+  CHECK_EQ(4u, *store.GetMesh(a));
+  REQUIRE(store.GetLod(a) != nullptr);
+  CHECK_EQ(1u, store.GetLod(a)->levelCount);
+  CHECK_EQ(size_t(1), store.GetArchetype(0).GetSize());
+  CHECK(store.GetArchetype(0).GetEntities()[0] == b);
+
+  store.SetMask(a, kTransformComponent);
+  CHECK(store.GetMesh(a) == nullptr);
+  CHECK(*store.GetTransform(a) == moved);
+  CHECK_EQ(size_t(2), store.GetEntityCount());
+  store.Clear();
+  CHECK(!store.IsAlive(b));
+  CHECK_EQ(size_t(0), store.GetArchetypeCount());
+}
+
+TEST(WorldBoundsFollowTheTransform) {
+  ComponentStore store;
+  Entity a = store.Create(kDrawable);
+  Entity unknown = store.Create(kDrawable);
+  *store.GetBounds(a) = glm::vec4(1.0f, 0.0f, 0.0f, 2.0f);
+  *store.GetTransform(a) =
+      glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 5.0f, 0.0f)),
+                 glm::vec3(3.0f, 1.0f, 1.0f));
+  UpdateWorldBounds(store);
+  const glm::vec4 *world = store.GetArchetype(0).GetWorldBounds();
+  CHECK(world[0] == glm::vec4(3.0f, 5.0f, 0.0f, 6.0f));
+  CHECK(world[1].w < 0.0f);
+  CHECK(store.IsAlive(unknown));
+}
+
+TEST(LevelsOfDetailDoubleTheirDistance) {
+  ComponentStore store;
+  std::vector<Entity> entities;
+  const float distances[] = {0.0f, 9.0f, 11.0f, 25.0f, 1000.0f};
+  for (float distance : distances) {
+    Entity entity = store.Create(kDrawable | kLodComponent);
+    *store.GetBounds(entity) = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    *store.GetTransform(entity) = glm::translate(
+        glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -(distance + 1.0f)));
+    store.GetLod(entity)->firstDistance = 10.0f;
+    store.GetLod(entity)->levelCount = 4;
+    entities.push_back(entity);
+  }
+  UpdateWorldBounds(store);
+  SelectLods(store, glm::vec3(0.0f));
+  // 10 to 20 is level 1, 20 to 40 level 2, and there are only 4
+  CHECK_EQ(0u, store.GetLod(entities[0])->level);
+  CHECK_EQ(0u, store.GetLod(entities[1])->level);
+  CHECK_EQ(1u, store.GetLod(entities[2])->level);
+  CHECK_EQ(2u, store.GetLod(entities[3])->level);
+  CHECK_EQ(3u, store.GetLod(entities[4])->level);
+}
+
+TEST(CullingListsTheRowsTheViewsSee) {
+  ComponentStore store;
+  glm::mat4 viewProjection =
+      glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f) *
+      glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+                  glm::vec3(0.0f, 1.0f, 0.0f));
+  MultiViewFrustum frustum(&viewProjection, 1);
+  auto place = [&](ComponentMask mask, const glm::vec3 &at, float radius) {
+    Entity entity = store.Create(mask);
+    *store.GetBounds(entity) = glm::vec4(0.0f, 0.0f, 0.0f, radius);
+    *store.GetTransform(entity) = glm::translate(glm::mat4(1.0f), at);
+    return entity;
+  };
+  place(kDrawable, glm::vec3(0.0f, 0.0f, -10.0f), 1.0f);
+  place(kDrawable, glm::vec3(0.0f, 0.0f, 10.0f), 1.0f);
+  place(kDrawable, glm::vec3(0.0f, 0.0f, 10.0f), -1.0f);
+  place(kDrawable | kStaticTag, glm::vec3(0.0f, 0.0f, -20.0f), 1.0f);
+  // Not drawable: no material
+  place(kTransformComponent | kMeshComponent | kBoundsComponent,
+        glm::vec3(0.0f, 0.0f, -10.0f), 1.0f);
+  UpdateWorldBounds(store);
+
+  std::vector<DrawRef> visible;
+  CullRenderables(store, frustum, 0, visible);
+  REQUIRE(visible.size() == 3u);
+  CHECK(visible[0].archetype == 0 && visible[0].row == 0);
+  CHECK(visible[1].archetype == 0 && visible[1].row == 2);
+  CHECK(visible[2].archetype == 1 && visible[2].row == 0);
+
+  visible.clear();
+  CullRenderables(store, frustum, kStaticTag, visible);
+  REQUIRE(visible.size() == 1u);
+  CHECK_EQ(1u, visible[0].archetype);
+}
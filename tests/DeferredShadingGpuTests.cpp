@@ -0,0 +1,74 @@
+#include "DeferredShading.hpp"
+#include "GLState.hpp"
+#include "GpuTestSupport.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+// A triangle over the whole viewport that only keeps the left 8 columns
+static const char *kVertexSource = R"(#version 330 core
+void main() {
+  vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+static const char *kFragmentSource = R"(#version 330 core
+out vec4 color;
+void main() {
+  if (gl_FragCoord.x >= 8.0) discard;
+  color = vec4(1.0);
+}
+)";
+
+TEST(SampleCounterCountsTheSamplesWritten) {
+  const int size = 32;
+  GLState &state = GLState::Instance();
+  GLuint fbo = 0, color = 0, vao = 0;
+  glGenFramebuffers(1, &fbo);
+  glGenRenderbuffers(1, &color);
+  glBindRenderbuffer(GL_RENDERBUFFER, color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size, size);
+  state.BindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, color);
+  REQUIRE(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+  state.Viewport(0, 0, size, size);
+
+  GLuint program = CompileTestProgram({kVertexSource, kFragmentSource},
+                                      {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER});
+  REQUIRE(program != 0);
+  glGenVertexArrays(1, &vao);
+  state.UseProgram(program);
+  state.BindVertexArray(vao);
+
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  size_t queries = tracker.GetGpuCount(GpuResourceKind::Query);
+  {
+    GpuSampleCounter counter;
+    counter.Create();
+    CHECK_EQ(queries + 4, tracker.GetGpuCount(GpuResourceKind::Query));
+    uint64_t samples = 0;
+    CHECK(!counter.Poll(samples));
+
+    counter.Begin();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    counter.End();
+    // The newest finished count is returned
+    counter.Begin();
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    counter.End();
+    glFinish();
+    CHECK(counter.Poll(samples));
+    CHECK_EQ(uint64_t(2 * 8 * size), samples);
+    CHECK(!counter.Poll(samples));
+    CHECK_EQ(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+  }
+  CHECK_EQ(queries, tracker.GetGpuCount(GpuResourceKind::Query));
+
+  glDeleteProgram(program);
+  glDeleteVertexArrays(1, &vao);
+  state.BindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(1, &color);
+  state.Invalidate();
+}
@@ -0,0 +1,110 @@
+#include "DeferredShading.hpp"
+#include "Impostor.hpp"
+#include "TestHarness.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+static float Attenuated(const PointLight &light, float distance) {
+  return light.color.r / (light.constant + light.linear * distance +
+                          light.quadratic * distance * distance);
+}
+
+TEST(LightRangeEndsWhereTheLightFadesToTheCutoff) {
+  PointLight lamp;
+  lamp.color = glm::vec3(3.0f, 1.0f, 1.0f);
+  lamp.linear = 0.3f;
+  lamp.quadratic = 0.08f;
+  const float cutoff = 1.0f / 128.0f;
+  float range = LightRange(lamp, cutoff, 1000.0f);
+  CHECK(range > 0.0f && range < 1000.0f);
+  CHECK(std::fabs(Attenuated(lamp, range) - cutoff) < 1e-4f);
+
+  // Linear falloff only
+  lamp.quadratic = 0.0f;
+  range = LightRange(lamp, cutoff, 10000.0f);
+  CHECK(range > 1000.0f);
+  CHECK(std::fabs(Attenuated(lamp, range) - cutoff) < 1e-4f);
+
+  // Lights that never fade out, or too slowly, stop at the maximum
+  lamp.linear = 0.0f;
+  CHECK_EQ(1000.0f, LightRange(lamp, cutoff, 1000.0f));
+  lamp.linear = 0.003f;
+  CHECK_EQ(1000.0f, LightRange(lamp, cutoff, 1000.0f));
+  // Too dim to ever reach the cutoff
+  lamp.color = glm::vec3(0.001f);
+  lamp.linear = 1.0f;
+  CHECK_EQ(0.0f, LightRange(lamp, cutoff, 1000.0f));
+}
+
+TEST(LightsBlockHoldsTheLightsAndTheCamera) {
+  PointLight lights[kMaxLights + 1];
+  for (unsigned i = 0; i <= kMaxLights; i++) {
+    lights[i].position = glm::vec3(float(i), 2.0f, 3.0f);
+    lights[i].ambientIntensity = 0.25f;
+    lights[i].quadratic = 1.0f;
+  }
+  glm::mat4 viewProjection(2.0f);
+  viewProjection[3][3] = 1.0f;
+  LightsBlock block = MakeLightsBlock(lights, 3, viewProjection,
+                                      glm::vec3(1.0f, 2.0f, 3.0f),
+                                      1.0f / 128.0f, 500.0f);
+  CHECK_EQ(3, block.count.x);
+  CHECK(glm::vec3(block.lights[2].positionRange) == lights[2].position);
+  CHECK(block.lights[2].positionRange.w > 0.0f);
+  CHECK_EQ(0.25f, block.lights[1].colorAmbient.a);
+  CHECK_EQ(1.0f, block.lights[0].attenuationSpecular.z);
+  CHECK(block.lights[3].positionRange == glm::vec4(0.0f));
+  CHECK(block.viewProjection * block.inverseViewProjection == glm::mat4(1.0f));
+  CHECK(block.eyePosition == glm::vec4(1.0f, 2.0f, 3.0f, 1.0f));
+  // Extra lights are dropped
+  CHECK_EQ(static_cast<int>(kMaxLights),
+           MakeLightsBlock(lights, kMaxLights + 1, viewProjection,
+                           glm::vec3(0.0f), 1.0f / 128.0f, 500.0f)
+               .count.x);
+}
+
+TEST(GBufferNormalsSurviveSixteenBits) {
+  // RG16 keeps 65535 steps per axis of the octahedral map
+  float worst = 1.0f;
+  for (int i = 0; i < 200; i++) {
+    float a = 0.1f * i, b = 0.37f * i;
+    glm::vec3 normal = glm::normalize(glm::vec3(
+        std::sin(a) * std::cos(b), std::cos(a), std::sin(a) * std::sin(b)));
+    glm::vec2 stored =
+        glm::round(OctahedralEncode(normal) * 65535.0f) / 65535.0f;
+    worst = std::min(worst, glm::dot(normal, OctahedralDecode(stored)));
+  }
+  CHECK(worst > 0.99999f);
+}
+
+TEST(DeferredLightingScalesWithLitSamples) {
+  ShadingSamples samples;
+  samples.geometry = 1000;
+  samples.lightVolumes = 300;
+  samples.screen = 800;
+  samples.lights = 26;
+  ShadingBandwidth bandwidth = EstimateShadingBandwidth(samples);
+  CHECK_EQ(uint64_t(12000), bandwidth.forward);
+  CHECK_EQ(uint64_t(16000), bandwidth.geometryPass);
+  CHECK_EQ(uint64_t(7200), bandwidth.lightPass);
+  CHECK_EQ(uint64_t(19200), bandwidth.resolvePass);
+  CHECK_EQ(bandwidth.geometryPass + bandwidth.lightPass +
+               bandwidth.resolvePass,
+           bandwidth.deferred);
+  CHECK_EQ(uint64_t(26000), bandwidth.forwardLighting);
+  CHECK_EQ(uint64_t(300), bandwidth.deferredLighting);
+
+  // Overdraw costs forward shading every light again, deferred only
+  // G-buffer writes
+  samples.geometry *= 2;
+  ShadingBandwidth overdrawn = EstimateShadingBandwidth(samples);
+  CHECK_EQ(2 * bandwidth.forwardLighting, overdrawn.forwardLighting);
+  CHECK_EQ(bandwidth.deferredLighting, overdrawn.deferredLighting);
+
+  std::ostringstream out;
+  PrintShadingReport(out, samples);
+  CHECK(out.str().find("forward:") != std::string::npos);
+  CHECK(out.str().find("deferred:") != std::string::npos);
+}
@@ -0,0 +1,165 @@
+#include "ForsythTuner.hpp"
+#include "Parallel.hpp"
+#include "TestHarness.hpp"
+#include "VertexCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+// A w x h quad grid, two triangles per quad, in row order
+static TuneMesh GridMesh(int w, int h, uint32_t firstVertex = 0) {
+  TuneMesh mesh;
+  mesh.name = "grid";
+  mesh.vertexCount = firstVertex + static_cast<size_t>(w + 1) * (h + 1);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint32_t v = firstVertex + y * (w + 1) + x;
+      uint32_t quad[6] = {v, v + 1, v + w + 1, v + 1, v + w + 2, v + w + 1};
+      mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+    }
+  }
+  return mesh;
+}
+
+// Sorted triangles, to compare two orders of the same mesh
+static std::vector<std::vector<uint32_t>>
+Triangles(const std::vector<uint32_t> &indices) {
+  std::vector<std::vector<uint32_t>> triangles;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    std::vector<uint32_t> t(indices.begin() + i, indices.begin() + i + 3);
+    std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+    triangles.push_back(t);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+TEST(VertexCacheFifoAndLru) {
+  // a b c, then a again after d: an LRU of 3 keeps a (it was used last
+  // but one), a FIFO of 3 has pushed it out
+  uint32_t indices[] = {0, 1, 2, 0, 3, 4, 0, 4, 3};
+  VertexCacheModel fifo{VertexCacheKind::Fifo, 3};
+  VertexCacheModel lru{VertexCacheKind::Lru, 3};
+  VertexCacheStats f = SimulateVertexCache(indices, 9, 5, fifo);
+  VertexCacheStats l = SimulateVertexCache(indices, 9, 5, lru);
+  CHECK_EQ(3u, f.triangles);
+  CHECK_EQ(5u, f.uniqueVertices);
+  CHECK_EQ(6u, f.misses); // 0 1 2 3 4, then 0 again
+  CHECK_EQ(5u, l.misses);
+  CHECK_EQ(2.0, f.GetAcmr());
+  CHECK_EQ(1.0, l.GetAtvr());
+
+  // A big enough cache only misses each vertex once
+  VertexCacheModel big{VertexCacheKind::Fifo, 16};
+  CHECK_EQ(5u, SimulateVertexCache(indices, 9, 5, big).misses);
+}
+
+TEST(VertexCacheModelNames) {
+  VertexCacheModel model;
+  REQUIRE(ParseVertexCacheModel("fifo16", model));
+  CHECK(model.kind == VertexCacheKind::Fifo);
+  CHECK_EQ(16, model.size);
+  REQUIRE(ParseVertexCacheModel("lru32", model));
+  CHECK_EQ(std::string("lru32"), VertexCacheModelName(model));
+  CHECK(!ParseVertexCacheModel("lru", model));
+  CHECK(!ParseVertexCacheModel("fifo0", model));
+  CHECK(!ParseVertexCacheModel("fifo65", model));
+  CHECK(!ParseVertexCacheModel("mru8", model));
+}
+
+TEST(ForsythParamsKeepTheTriangles) {
+  TuneMesh mesh = GridMesh(20, 20);
+  std::vector<uint32_t> byDefault(mesh.indices.size());
+  std::vector<uint32_t> withParams(mesh.indices.size());
+  int triangles = static_cast<int>(mesh.indices.size() / 3);
+  int vertices = static_cast<int>(mesh.vertexCount);
+  REQUIRE(forsythReorderIndices(byDefault.data(), mesh.indices.data(),
+                                triangles, vertices) != nullptr);
+  // The defaults are what forsythReorderIndices() uses
+  ForsythParams defaults = forsythDefaultParams();
+  REQUIRE(forsythReorderIndicesWithParams(withParams.data(),
+                                          mesh.indices.data(), triangles,
+                                          vertices, &defaults) != nullptr);
+  CHECK(byDefault == withParams);
+  CHECK(Triangles(byDefault) == Triangles(mesh.indices));
+
+  ForsythParams small = {8, 0.0f, 0.25f, 6.0f, 0.25f};
+  REQUIRE(forsythReorderIndicesWithParams(withParams.data(),
+                                          mesh.indices.data(), triangles,
+                                          vertices, &small) != nullptr);
+  CHECK(Triangles(withParams) == Triangles(mesh.indices));
+}
+
+// 16 bit indices used to wrap around here
+TEST(ForsythHandlesMoreThan65536Vertices) {
+  TuneMesh mesh = GridMesh(8, 8, 70000);
+  std::vector<uint32_t> reordered(mesh.indices.size());
+  REQUIRE(forsythReorderIndices(reordered.data(), mesh.indices.data(),
+                                static_cast<int>(mesh.indices.size() / 3),
+                                static_cast<int>(mesh.vertexCount)) !=
+          nullptr);
+  CHECK(Triangles(reordered) == Triangles(mesh.indices));
+}
+
+TEST(ParallelForCoversEveryIndexOnce) {
+  std::vector<std::atomic<int>> hits(1001);
+  for (std::atomic<int> &hit : hits) {
+    hit = 0;
+  }
+  ParallelFor(
+      hits.size(), 7,
+      [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          hits[i]++;
+        }
+      },
+      4);
+  bool once = true;
+  for (std::atomic<int> &hit : hits) {
+    once = once && hit == 1;
+  }
+  CHECK(once);
+  ParallelFor(0, 1, [](size_t, size_t) { CHECK(false); });
+}
+
+TEST(TuneForsythNeverLosesToTheDefaults) {
+  std::vector<TuneMesh> corpus = {GridMesh(24, 24), GridMesh(7, 31)};
+  VertexCacheModel target{VertexCacheKind::Fifo, 12};
+  ForsythTuneOptions options;
+  options.gridSteps = 2;
+  options.starts = 1;
+  options.refineRounds = 1;
+  options.threads = 1;
+  ForsythTuneResult result = TuneForsyth(corpus, target, options);
+  CHECK(result.evaluations > 32);
+  CHECK(result.acmr <= result.defaultAcmr);
+  CHECK(result.defaultAcmr < EvaluateUnoptimized(corpus, target));
+  CHECK_EQ(result.acmr, EvaluateForsyth(corpus, result.params, target));
+
+  // The same answer on more threads
+  options.threads = 3;
+  ForsythTuneResult parallel = TuneForsyth(corpus, target, options);
+  CHECK_EQ(result.acmr, parallel.acmr);
+  CHECK_EQ(result.params.cacheSize, parallel.params.cacheSize);
+}
+
+TEST(ForsythPresets) {
+  ForsythParams params;
+  REQUIRE(FindForsythPreset("default", params));
+  ForsythParams defaults = forsythDefaultParams();
+  CHECK_EQ(defaults.cacheSize, params.cacheSize);
+  CHECK_EQ(defaults.cacheDecayPower, params.cacheDecayPower);
+  CHECK(!FindForsythPreset("fifo7", params));
+
+  size_t count = 0;
+  const ForsythPreset *presets = GetForsythPresets(count);
+  CHECK(count > 1);
+  for (size_t i = 0; i < count; i++) {
+    VertexCacheModel model;
+    CHECK(std::string(presets[i].name) == "default" ||
+          ParseVertexCacheModel(presets[i].name, model));
+    CHECK(presets[i].params.cacheSize >= 4 &&
+          presets[i].params.cacheSize <= FORSYTH_MAX_VERTEX_CACHE_SIZE);
+  }
+}
@@ -0,0 +1,87 @@
+#include "FrameStats.hpp"
+#include "PerfHud.hpp"
+#include "TestHarness.hpp"
+
+#include <cmath>
+
+TEST(FrameHistoryKeepsNewestSamples) {
+  FrameHistory history;
+  CHECK_EQ(0u, history.GetCount());
+  CHECK_EQ(0.0f, history.GetLatest());
+  for (size_t i = 0; i < FrameHistory::kSize + 10; i++) {
+    history.Push(static_cast<float>(i));
+  }
+  CHECK_EQ(FrameHistory::kSize, history.GetCount());
+  // The first ten samples were pushed out, the rest is oldest first
+  CHECK_EQ(10.0f, history.Get(0));
+  CHECK_EQ(static_cast<float>(FrameHistory::kSize + 9), history.GetLatest());
+  CHECK_EQ(static_cast<float>(FrameHistory::kSize + 9), history.GetMax());
+  float average = 10.0f + (FrameHistory::kSize - 1) * 0.5f;
+  CHECK(std::fabs(average - history.GetAverage()) < 1e-3f);
+}
+
+TEST(FrameHistoryPercentiles) {
+  FrameHistory history;
+  CHECK_EQ(0.0f, history.GetPercentile(0.5f));
+  // 1..100 in a scrambled order
+  for (int i = 0; i < 100; i++) {
+    history.Push(static_cast<float>((i * 37) % 100 + 1));
+  }
+  CHECK_EQ(50.0f, history.GetPercentile(0.50f));
+  CHECK_EQ(95.0f, history.GetPercentile(0.95f));
+  CHECK_EQ(99.0f, history.GetPercentile(0.99f));
+  CHECK_EQ(100.0f, history.GetPercentile(1.0f));
+  CHECK_EQ(1.0f, history.GetPercentile(0.0f));
+}
+
+TEST(FrameStatsClosesFrames) {
+  FrameStats &stats = FrameStats::Instance();
+  stats.Reset();
+  stats.CountDraw(100);
+  stats.CountDraw(20);
+  stats.CountStateChange(3);
+  CHECK_EQ(2u, stats.GetCurrentFrame().drawCalls);
+  stats.EndFrame(16.0f);
+  CHECK_EQ(2u, stats.GetLastFrame().drawCalls);
+  CHECK_EQ(120u, stats.GetLastFrame().triangles);
+  CHECK_EQ(3u, stats.GetLastFrame().stateChanges);
+  CHECK_EQ(0u, stats.GetCurrentFrame().drawCalls);
+  CHECK_EQ(16.0f, stats.GetFrameTimes().GetLatest());
+  CHECK_EQ(1ul, stats.GetFrameNumber());
+  stats.Reset();
+}
+
+TEST(HudBatchText) {
+  HudBatch batch;
+  float end = batch.AddText(10.0f, 20.0f, "Ab 1", 2.0f, HudColor(255, 0, 0));
+  // One quad per character, none for the space
+  CHECK_EQ(3u, batch.GetQuadCount());
+  CHECK_EQ(10.0f + 4 * HudBatch::kCharWidth * 2.0f, end);
+  const HudVertex &first = batch.GetVertices()[0];
+  CHECK_EQ(10.0f, first.x);
+  CHECK_EQ(20.0f, first.y);
+  CHECK_EQ(0xFF0000FFu, first.color);
+  // Lower case uses the upper case glyph
+  HudBatch upper;
+  upper.AddText(10.0f, 20.0f, "AB 1", 2.0f, HudColor(255, 0, 0));
+  for (size_t i = 0; i < batch.GetVertices().size(); i++) {
+    CHECK_EQ(upper.GetVertices()[i].u, batch.GetVertices()[i].u);
+    CHECK_EQ(upper.GetVertices()[i].v, batch.GetVertices()[i].v);
+  }
+}
+
+TEST(PerfHudLayoutFitsOneDraw) {
+  FrameStats &stats = FrameStats::Instance();
+  stats.Reset();
+  for (size_t i = 0; i < FrameHistory::kSize; i++) {
+    stats.CountDraw(1000);
+    stats.AddGpuTime(4.0f);
+    stats.EndFrame(i % 10 == 0 ? 40.0f : 16.0f);
+  }
+  HudBatch batch;
+  BuildPerfHud(batch, stats, 64u << 20, 8u << 20, 0.05f);
+  // Panel, two full graphs (background, bars, budget line) and the text
+  CHECK(batch.GetQuadCount() > 2 * (FrameHistory::kSize + 2));
+  CHECK(batch.GetQuadCount() < 1024u);
+  stats.Reset();
+}
@@ -0,0 +1,52 @@
+#include "Frustum.hpp"
+#include "TestHarness.hpp"
+
+#include <cmath>
+
+#include <glm/geometric.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// Camera at the origin looking down -z, sees z in [-100, -1]
+static Frustum MakeFrustum() {
+  glm::mat4 projection =
+      glm::perspective(glm::radians(90.0f), 1.0f, 1.0f, 100.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+                               glm::vec3(0.0f, 1.0f, 0.0f));
+  return Frustum(projection * view);
+}
+
+TEST(PlanesAreNormalized) {
+  Frustum frustum = MakeFrustum();
+  for (int i = 0; i < Frustum::PlaneCount; i++) {
+    glm::vec3 normal(frustum.GetPlane(static_cast<Frustum::Plane>(i)));
+    CHECK(std::abs(glm::length(normal) - 1.0f) < 1e-5f);
+  }
+}
+
+TEST(SphereVisibility) {
+  Frustum frustum = MakeFrustum();
+  CHECK(frustum.IntersectsSphere(glm::vec3(0, 0, -10), 1.0f));
+  CHECK(!frustum.IntersectsSphere(glm::vec3(0, 0, 10), 1.0f));
+  CHECK(!frustum.IntersectsSphere(glm::vec3(0, 0, -110), 1.0f));
+  // Center behind the camera, but overlapping the near plane
+  CHECK(frustum.IntersectsSphere(glm::vec3(0, 0, 0.5f), 2.0f));
+  // 90 degree field of view: x = -z is the edge
+  CHECK(!frustum.IntersectsSphere(glm::vec3(20, 0, -10), 1.0f));
+}
+
+TEST(AabbVisibility) {
+  Frustum frustum = MakeFrustum();
+  Aabb inside{glm::vec3(-1, -1, -11), glm::vec3(1, 1, -9)};
+  Aabb behind{glm::vec3(-1, -1, 1), glm::vec3(1, 1, 3)};
+  Aabb straddling{glm::vec3(-50, -1, -11), glm::vec3(0, 1, -9)};
+  CHECK(frustum.IntersectsAabb(inside));
+  CHECK(!frustum.IntersectsAabb(behind));
+  CHECK(frustum.IntersectsAabb(straddling));
+
+  Aabb boxes[] = {inside, behind, straddling};
+  uint8_t visible[3];
+  CHECK_EQ(2u, CullAabbs(frustum, boxes, 3, visible));
+  CHECK_EQ(1, visible[0]);
+  CHECK_EQ(0, visible[1]);
+  CHECK_EQ(1, visible[2]);
+}
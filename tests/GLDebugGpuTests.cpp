@@ -0,0 +1,29 @@
+#include "GLDebug.hpp"
+#include "HeadlessContext.hpp"
+#include "TestHarness.hpp"
+
+#include <sstream>
+
+TEST(GLDebugReportsCallSite) {
+  GLDebug &debug = GLDebug::Instance();
+  std::ostringstream out;
+  debug.SetOutput(&out);
+  // Without KHR_debug GL_CHECK falls back to glGetError, which still
+  // counts the error (just without a message from the driver)
+  bool installed = debug.Install(HeadlessContext::GetProcAddress, true);
+  debug.EndFrame();
+  debug.BeginCall("glEnable(0xFFFF)", "GLDebugGpuTests.cpp", 42);
+  glEnable(0xFFFF);
+  debug.EndCall();
+  debug.EndFrame();
+  CHECK(debug.GetLastFrame().errors >= 1u);
+  if (installed) {
+    CHECK(out.str().find("in glEnable(0xFFFF) (GLDebugGpuTests.cpp:42)") !=
+          std::string::npos);
+  }
+  debug.Uninstall();
+  debug.SetOutput(&std::cerr);
+  // The error flag is set either way; leave a clean context behind
+  while (glGetError() != GL_NO_ERROR) {
+  }
+}
@@ -0,0 +1,89 @@
+#include "GLDebug.hpp"
+#include "TestHarness.hpp"
+
+#include <sstream>
+
+// The tests share the one GLDebug, so each one uses its own message ids
+// and closes the frame before it starts.
+
+TEST(GLDebugCountsPerFrame) {
+  GLDebug &debug = GLDebug::Instance();
+  std::ostringstream out;
+  debug.SetOutput(&out);
+  debug.EndFrame();
+  debug.OnMessage(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_ERROR, 100,
+                  GL_DEBUG_SEVERITY_HIGH, "invalid enum");
+  debug.OnMessage(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_PERFORMANCE, 101,
+                  GL_DEBUG_SEVERITY_MEDIUM, "buffer moved to system memory");
+  debug.OnMessage(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_PERFORMANCE, 101,
+                  GL_DEBUG_SEVERITY_MEDIUM, "buffer moved to system memory");
+  debug.OnMessage(GL_DEBUG_SOURCE_SHADER_COMPILER, GL_DEBUG_TYPE_PORTABILITY,
+                  102, GL_DEBUG_SEVERITY_LOW, "non-portable shader");
+  // Annotations are never counted
+  debug.OnMessage(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP, 103,
+                  GL_DEBUG_SEVERITY_NOTIFICATION, "shadow pass");
+  debug.EndFrame();
+  const GLDebugCounts &frame = debug.GetLastFrame();
+  CHECK_EQ(1u, frame.errors);
+  CHECK_EQ(2u, frame.performance);
+  CHECK_EQ(1u, frame.warnings);
+  CHECK_EQ(0u, frame.other);
+  CHECK_EQ(4u, frame.Total());
+  CHECK(out.str().find("[GL error, api #100] invalid enum") !=
+        std::string::npos);
+  CHECK(out.str().find("2 performance warning(s)") != std::string::npos);
+
+  // The next frame starts from zero
+  debug.EndFrame();
+  CHECK_EQ(0u, debug.GetLastFrame().Total());
+  debug.SetOutput(&std::cerr);
+}
+
+TEST(GLDebugFiltersBySeverityAndId) {
+  GLDebug &debug = GLDebug::Instance();
+  std::ostringstream out;
+  debug.SetOutput(&out);
+  debug.EndFrame();
+  debug.SetMinimumSeverity(GL_DEBUG_SEVERITY_MEDIUM);
+  debug.OnMessage(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_OTHER, 200,
+                  GL_DEBUG_SEVERITY_LOW, "dropped: too low");
+  debug.OnMessage(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_OTHER, 201,
+                  GL_DEBUG_SEVERITY_MEDIUM, "kept");
+  debug.Ignore(GL_DEBUG_SOURCE_API, 202);
+  debug.OnMessage(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_ERROR, 202,
+                  GL_DEBUG_SEVERITY_HIGH, "dropped: ignored id");
+  // Same id from another source is a different message
+  debug.OnMessage(GL_DEBUG_SOURCE_THIRD_PARTY, GL_DEBUG_TYPE_ERROR, 202,
+                  GL_DEBUG_SEVERITY_HIGH, "kept");
+  debug.EndFrame();
+  CHECK_EQ(1u, debug.GetLastFrame().other);
+  CHECK_EQ(1u, debug.GetLastFrame().errors);
+  CHECK(out.str().find("dropped") == std::string::npos);
+  debug.SetMinimumSeverity(GL_DEBUG_SEVERITY_LOW);
+  debug.SetOutput(&std::cerr);
+}
+
+TEST(GLDebugPrintLimit) {
+  GLDebug &debug = GLDebug::Instance();
+  std::ostringstream out;
+  debug.SetOutput(&out);
+  debug.SetPrintLimit(2);
+  debug.EndFrame();
+  for (int i = 0; i < 10; i++) {
+    debug.OnMessage(GL_DEBUG_SOURCE_API, GL_DEBUG_TYPE_PERFORMANCE, 300,
+                    GL_DEBUG_SEVERITY_MEDIUM, "repeated");
+  }
+  debug.EndFrame();
+  // Counted every time, printed twice
+  CHECK_EQ(10u, debug.GetLastFrame().performance);
+  std::string text = out.str();
+  size_t printed = 0;
+  for (size_t at = text.find("repeated"); at != std::string::npos;
+       at = text.find("repeated", at + 1)) {
+    printed++;
+  }
+  CHECK_EQ(2u, printed);
+  CHECK(text.find("not printing this message again") != std::string::npos);
+  debug.SetPrintLimit(5);
+  debug.SetOutput(&std::cerr);
+}
@@ -0,0 +1,136 @@
+#include "FrameStats.hpp"
+#include "GLState.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+#include <sstream>
+
+static GLint GetInteger(GLenum query) {
+  GLint value = -1;
+  glGetIntegerv(query, &value);
+  return value;
+}
+
+TEST(GLStateFiltersRedundantCalls) {
+  GLState &state = GLState::Instance();
+  state.Invalidate();
+  state.ResetCounters();
+  FrameStats &stats = FrameStats::Instance();
+  stats.Reset();
+
+  GLuint vao = 0;
+  glGenVertexArrays(1, &vao);
+  GLuint textures[2] = {0, 0};
+  glGenTextures(2, textures);
+  // A frame's worth of state, set twice
+  for (int frame = 0; frame < 2; frame++) {
+    state.Viewport(0, 0, 64, 32);
+    state.ClearColor(0.1f, 0.2f, 0.3f, 1.0f);
+    state.Enable(GL_DEPTH_TEST);
+    state.Disable(GL_CULL_FACE);
+    state.PolygonMode(GL_FILL);
+    state.BindVertexArray(vao);
+    state.BindTexture(0, GL_TEXTURE_2D, textures[0]);
+    state.BindTexture(1, GL_TEXTURE_2D, textures[1]);
+  }
+  const GLStateCounters &counters = state.GetCounters();
+  // Switching the active unit back to 0 is a real change every frame
+  CHECK_EQ(12u, counters.GetIssued());
+  CHECK_EQ(8u, counters.GetFiltered());
+  CHECK_EQ(1u, counters.issued[static_cast<int>(GLStateKind::Viewport)]);
+  CHECK_EQ(1u, counters.filtered[static_cast<int>(GLStateKind::Viewport)]);
+  CHECK_EQ(0u, counters.mismatches);
+  stats.EndFrame(1.0f);
+  CHECK_EQ(12u, stats.GetLastFrame().stateChanges);
+  CHECK_EQ(8u, stats.GetLastFrame().filteredStateChanges);
+
+  // OpenGL agrees with the shadow
+  CHECK_EQ(0u, state.Validate(nullptr));
+  CHECK_EQ(static_cast<GLint>(vao), GetInteger(GL_VERTEX_ARRAY_BINDING));
+  CHECK_EQ(static_cast<GLint>(GL_TEXTURE1), GetInteger(GL_ACTIVE_TEXTURE));
+  CHECK(glIsEnabled(GL_DEPTH_TEST) == GL_TRUE);
+  CHECK(state.IsEnabled(GL_DEPTH_TEST));
+  CHECK(!state.IsEnabled(GL_CULL_FACE));
+
+  std::ostringstream report;
+  state.PrintReport(report);
+  CHECK(report.str().find("viewport") != std::string::npos);
+
+  state.BindVertexArray(0);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteTextures(2, textures);
+  state.Invalidate();
+  stats.Reset();
+  CHECK(glGetError() == GL_NO_ERROR);
+}
+
+TEST(GLStateValidationCatchesRawCalls) {
+  GLState &state = GLState::Instance();
+  state.Invalidate();
+  state.ResetCounters();
+  bool validating = state.IsValidating();
+
+  state.Viewport(0, 0, 16, 16);
+  state.Enable(GL_BLEND);
+  // Behind GLState's back
+  glViewport(0, 0, 8, 8);
+  glDisable(GL_BLEND);
+
+  // Without validation the stale shadow skips the call...
+  state.SetValidation(false);
+  state.Viewport(0, 0, 16, 16);
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  CHECK_EQ(8, viewport[2]);
+
+  // ...with it the mismatch is found and the call goes through
+  state.SetValidation(true);
+  state.Viewport(0, 0, 16, 16);
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  CHECK_EQ(16, viewport[2]);
+  state.Enable(GL_BLEND);
+  CHECK(glIsEnabled(GL_BLEND) == GL_TRUE);
+  CHECK_EQ(2u, state.GetCounters().mismatches);
+
+  // Validate() finds and adopts every difference at once
+  glViewport(0, 0, 4, 4);
+  glDisable(GL_BLEND);
+  std::ostringstream out;
+  CHECK_EQ(2u, state.Validate(&out));
+  CHECK(out.str().find("viewport") != std::string::npos);
+  CHECK_EQ(0u, state.Validate(nullptr));
+  CHECK(!state.IsEnabled(GL_BLEND));
+
+  state.SetValidation(validating);
+  state.Invalidate();
+}
+
+TEST(GLStateForgetsDeletedObjects) {
+  GLState &state = GLState::Instance();
+  state.Invalidate();
+  ResourceTracker &tracker = ResourceTracker::Instance();
+
+  GLuint buffer = 0;
+  glGenBuffers(1, &buffer);
+  state.BindBuffer(GL_ARRAY_BUFFER, buffer);
+  tracker.TrackGpu(GpuResourceKind::Buffer, buffer, 16, GL_ARRAY_BUFFER,
+                   "GLStateTest");
+  // Deleting it unbinds it; the tracker tells GLState
+  tracker.UntrackGpu(GpuResourceKind::Buffer, buffer);
+  glDeleteBuffers(1, &buffer);
+  CHECK_EQ(0, GetInteger(GL_ARRAY_BUFFER_BINDING));
+  CHECK_EQ(0u, state.Validate(nullptr));
+
+  // A new buffer may get the same name, and binding it is not skipped
+  GLuint again = 0;
+  glGenBuffers(1, &again);
+  state.ResetCounters();
+  state.BindBuffer(GL_ARRAY_BUFFER, again);
+  CHECK_EQ(1u, state.GetCounters().issued[static_cast<int>(
+                   GLStateKind::Buffer)]);
+  CHECK_EQ(static_cast<GLint>(again), GetInteger(GL_ARRAY_BUFFER_BINDING));
+
+  state.BindBuffer(GL_ARRAY_BUFFER, 0);
+  glDeleteBuffers(1, &again);
+  state.Invalidate();
+}
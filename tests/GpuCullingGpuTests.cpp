@@ -0,0 +1,180 @@
+#include "Frustum.hpp"
+#include "GLState.hpp"
+#include "GpuCulling.hpp"
+#include "GpuTestSupport.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <iostream>
+#include <vector>
+
+// Reads its transform through the object index, like part1's vert_gpu.glsl
+static const char *kVertexShader = R"(#version 430 core
+struct Object {
+  mat4 model;
+  vec4 sphere;
+  uvec4 mesh;
+};
+layout(std430, binding = 0) readonly buffer Objects { Object u_Objects[]; };
+layout(location = 0) in vec3 a_position;
+layout(location = 3) in uint a_ObjectIndex;
+uniform mat4 u_ViewProjection;
+void main() {
+  gl_Position =
+      u_ViewProjection * u_Objects[a_ObjectIndex].model * vec4(a_position, 1.0);
+}
+)";
+
+static const char *kFragmentShader = R"(#version 430 core
+out vec4 color;
+void main() { color = vec4(1.0, 0.0, 0.0, 1.0); }
+)";
+
+// What the CPU frustum keeps of the culler's objects
+static uint32_t CountVisible(const GpuCuller &culler,
+                             const glm::mat4 &viewProjection) {
+  Frustum frustum(viewProjection);
+  uint32_t visible = 0;
+  for (uint32_t i = 0; i < culler.GetObjectCount(); i++) {
+    const glm::vec4 &sphere = culler.GetObject(i).sphere;
+    visible += frustum.IntersectsSphere(glm::vec3(sphere), sphere.w) ? 1 : 0;
+  }
+  return visible;
+}
+
+static void CullsAndDraws(bool useDrawCount) {
+  GpuCuller culler;
+  if (!culler.Create(HeadlessContext::GetProcAddress, useDrawCount)) {
+    std::cout << "  skipped: " << culler.GetError() << std::endl;
+    return;
+  }
+  GLuint program = CompileTestProgram({kVertexShader, kFragmentShader},
+                                      {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER});
+  REQUIRE(program != 0);
+
+  const int width = 64, height = 64;
+  GLuint fbo = 0, color = 0;
+  glGenFramebuffers(1, &fbo);
+  glGenRenderbuffers(1, &color);
+  glBindRenderbuffer(GL_RENDERBUFFER, color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  GLState &state = GLState::Instance();
+  state.BindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, color);
+  REQUIRE(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+  state.Viewport(0, 0, width, height);
+
+  // A unit quad, then a triangle behind it in the same buffers
+  const float positions[] = {-0.5f, -0.5f, 0.0f, 0.5f, -0.5f, 0.0f,
+                             0.5f,  0.5f,  0.0f, -0.5f, 0.5f, 0.0f,
+                             0.0f,  0.0f,  0.0f, 0.4f, 0.0f, 0.0f,
+                             0.0f,  0.4f,  0.0f};
+  const GLuint indices[] = {0, 1, 2, 0, 2, 3, 0, 1, 2};
+  GLuint vao = 0, buffers[2] = {0, 0};
+  glGenVertexArrays(1, &vao);
+  glGenBuffers(2, buffers);
+  state.BindVertexArray(vao);
+  state.BindBuffer(GL_ARRAY_BUFFER, buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(positions), positions, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers[1]);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices,
+               GL_STATIC_DRAW);
+
+  uint32_t quad = culler.AddMesh({6, 0, 0, glm::vec3(0.0f), 0.71f});
+  uint32_t triangle =
+      culler.AddMesh({3, 6, 4, glm::vec3(0.13f, 0.13f, 0.0f), 0.3f});
+  // A row of quads along x, most of them outside the view
+  for (int x = -20; x <= 20; x += 2) {
+    culler.AddObject(quad, glm::translate(glm::mat4(1.0f),
+                                          glm::vec3(float(x), 0.0f, 0.0f)));
+  }
+  uint32_t center = 10; // At x = 0
+  culler.AddObject(triangle, glm::translate(glm::mat4(1.0f),
+                                            glm::vec3(0.0f, 0.0f, -500.0f)));
+  glm::mat4 viewProjection =
+      glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f) *
+      glm::lookAt(glm::vec3(0.0f, 0.0f, 10.0f), glm::vec3(0.0f),
+                  glm::vec3(0.0f, 1.0f, 0.0f));
+
+  auto drawAndRead = [&](uint32_t &drawn) {
+    state.ClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    culler.Cull(viewProjection);
+    state.UseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "u_ViewProjection"), 1,
+                       GL_FALSE, &viewProjection[0][0]);
+    culler.Draw(vao, 3);
+    drawn = culler.ReadDrawnCount();
+    unsigned char pixel[4];
+    glReadPixels(width / 2, height / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                 pixel);
+    return pixel[0] == 255 && pixel[2] == 0;
+  };
+
+  uint32_t drawn = 0;
+  CHECK(drawAndRead(drawn));
+  CHECK_EQ(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+  uint32_t expected = CountVisible(culler, viewProjection);
+  CHECK_EQ(expected, drawn);
+  CHECK(drawn > 1 && drawn < culler.GetObjectCount() - 1);
+  // Everything went up with the first Cull()
+  CHECK(culler.GetStats().uploadedBytes >=
+        culler.GetObjectCount() * sizeof(GpuObject));
+
+  // Nothing changed: nothing is uploaded
+  CHECK(drawAndRead(drawn));
+  CHECK_EQ(size_t(0), culler.GetStats().uploadedBytes);
+
+  // Moving one object sends only that object
+  culler.SetTransform(center, glm::translate(glm::mat4(1.0f),
+                                             glm::vec3(0.0f, 50.0f, 0.0f)));
+  CHECK(!drawAndRead(drawn));
+  CHECK_EQ(sizeof(GpuObject), culler.GetStats().uploadedBytes);
+  CHECK_EQ(expected - 1, drawn);
+  CHECK_EQ(CountVisible(culler, viewProjection), drawn);
+
+  // The triangle mesh, drawn with its own first index and base vertex
+  culler.SetTransform(culler.GetObjectCount() - 1, glm::mat4(1.0f));
+  CHECK(drawAndRead(drawn));
+  CHECK_EQ(expected, drawn);
+  CHECK_EQ(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+  // The statistics catch up without waiting
+  glFinish();
+  culler.Cull(viewProjection);
+  glFinish();
+  culler.Cull(viewProjection);
+  CHECK_EQ(expected, culler.GetStats().drawn);
+
+  glDeleteProgram(program);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(2, buffers);
+  state.BindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(1, &color);
+  state.Invalidate();
+}
+
+TEST(GpuCullerMatchesTheCpuFrustum) { CullsAndDraws(true); }
+
+TEST(GpuCullerWorksWithoutTheDrawCount) { CullsAndDraws(false); }
+
+TEST(GpuCullerReleasesItsBuffers) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  GpuCuller culler;
+  if (!culler.Create(HeadlessContext::GetProcAddress)) {
+    std::cout << "  skipped: " << culler.GetError() << std::endl;
+    return;
+  }
+  CHECK_EQ(1u, tracker.GetGpuCount(GpuResourceKind::Program));
+  CHECK(tracker.GetGpuCount(GpuResourceKind::Buffer) > 0);
+  culler.Release();
+  CHECK(!culler.IsCreated());
+  CHECK_EQ(0u, tracker.GetGpuCount(GpuResourceKind::Program));
+  CHECK_EQ(0u, tracker.GetGpuCount(GpuResourceKind::Buffer));
+}
@@ -0,0 +1,64 @@
+// Entry point for the tests that need an OpenGL context. They are skipped
+// (exit code 77, see tests/CMakeLists.txt) on machines without one.
+#include "GLState.hpp"
+#include "GpuTestSupport.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+#include <string>
+
+static HeadlessContext gContext;
+
+HeadlessContext &GetTestContext() { return gContext; }
+
+GLuint CompileTestProgram(std::initializer_list<const char *> sources,
+                          std::initializer_list<GLenum> stages) {
+  if (sources.size() != stages.size()) {
+    return 0;
+  }
+  GLuint program = glCreateProgram();
+  const GLenum *stage = stages.begin();
+  for (const char *source : sources) {
+    GLuint shader = glCreateShader(*stage++);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+    glAttachShader(program, shader);
+    glDeleteShader(shader);
+  }
+  glLinkProgram(program);
+  GLint linked = GL_FALSE;
+  glGetProgramiv(program, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    // The link log repeats the compile errors
+    GLint length = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    std::string log(static_cast<size_t>(length > 0 ? length : 1), '\0');
+    glGetProgramInfoLog(program, static_cast<GLsizei>(log.size()), nullptr,
+                        &log[0]);
+    std::cout << "  could not link a test program: " << log.c_str()
+              << std::endl;
+    glDeleteProgram(program);
+    return 0;
+  }
+  return program;
+}
+
+int main(int argc, char **argv) {
+  HeadlessContext &context = gContext;
+  if (!context.Create(3, 3)) {
+    std::cout << "Skipping GPU tests: " << context.GetError() << std::endl;
+    return 77;
+  }
+  std::cout << "Renderer: " << context.GetRenderer() << std::endl;
+  // The tests mix raw OpenGL calls with code that goes through GLState;
+  // validation keeps a stale shadow from skipping a call the test needs
+  GLState::Instance().SetValidation(true);
+  int failed = RunAllTests(argc, argv);
+  // Whatever a test left in the tracker leaked, even if the test passed
+  size_t leaks = ResourceTracker::Instance().CheckForLeaks(std::cout);
+  if (leaks > 0) {
+    std::cout << leaks << " resource(s) leaked by the tests" << std::endl;
+  }
+  context.Destroy();
+  return failed == 0 && leaks == 0 ? 0 : 1;
+}
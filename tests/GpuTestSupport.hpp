@@ -0,0 +1,24 @@
+/** @file GpuTestSupport.hpp
+ *  @brief What the GPU tests share, defined in GpuTestMain.cpp.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef GPU_TEST_SUPPORT_HPP
+#define GPU_TEST_SUPPORT_HPP
+
+#include "HeadlessContext.hpp"
+
+#include <glad/glad.h>
+
+#include <initializer_list>
+
+// The context of the test executable
+HeadlessContext &GetTestContext();
+
+// Compiles one shader per stage ('sources' and 'stages' in the same order)
+// and links them. Returns 0, after printing the log, if that fails. The
+// caller binds its own uniform blocks.
+GLuint CompileTestProgram(std::initializer_list<const char *> sources,
+                          std::initializer_list<GLenum> stages);
+
+#endif
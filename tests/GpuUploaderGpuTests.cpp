@@ -0,0 +1,202 @@
+#include "GLState.hpp"
+#include "GpuTestSupport.hpp"
+#include "GpuUploader.hpp"
+#include "OBJModel.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+static std::vector<uint8_t> ReadBuffer(GLuint buffer, size_t bytes) {
+  std::vector<uint8_t> data(bytes);
+  GLState::Instance().BindBuffer(GL_COPY_READ_BUFFER, buffer);
+  glGetBufferSubData(GL_COPY_READ_BUFFER, 0, bytes, data.data());
+  GLState::Instance().BindBuffer(GL_COPY_READ_BUFFER, 0);
+  return data;
+}
+
+TEST(GpuUploaderUploadsOnItsThread) {
+  SharedContext shared;
+  REQUIRE(GetTestContext().CreateSharedContext(shared));
+  GpuUploader uploader;
+  REQUIRE(uploader.Start(shared));
+  CHECK(uploader.IsThreaded());
+
+  std::vector<float> vertices(3000);
+  for (size_t i = 0; i < vertices.size(); i++) {
+    vertices[i] = static_cast<float>(i) * 0.5f;
+  }
+  std::vector<unsigned int> indices = {0, 1, 2, 2, 1, 3};
+  std::vector<BufferUpload> buffers;
+  buffers.push_back(MakeBufferUpload(vertices));
+  buffers.push_back(MakeBufferUpload(indices));
+
+  const std::thread::id renderThread = std::this_thread::get_id();
+  bool onRenderThread = true;
+  UploadResult meshResult, textureResult;
+  int ready = 0;
+  UploadTicket mesh =
+      uploader.UploadBuffers(buffers, [&](const UploadResult &result) {
+        onRenderThread = onRenderThread &&
+                         std::this_thread::get_id() == renderThread;
+        meshResult = result;
+        ready++;
+      });
+  TextureUpload texture;
+  texture.width = 64;
+  texture.height = 32;
+  texture.pixels.resize(64 * 32 * 3);
+  for (size_t i = 0; i < texture.pixels.size(); i++) {
+    texture.pixels[i] = static_cast<uint8_t>(i * 7);
+  }
+  const std::vector<uint8_t> pixels = texture.pixels;
+  UploadTicket image =
+      uploader.UploadTexture(texture, [&](const UploadResult &result) {
+        onRenderThread = onRenderThread &&
+                         std::this_thread::get_id() == renderThread;
+        textureResult = result;
+        ready++;
+      });
+  CHECK(mesh != 0);
+  CHECK(image != mesh);
+  // Nothing is handed over outside of Poll() and Finish()
+  CHECK_EQ(0, ready);
+  uploader.Finish();
+  CHECK_EQ(2, ready);
+  CHECK(onRenderThread);
+  CHECK_EQ(0u, uploader.GetPending());
+
+  REQUIRE(meshResult.buffers.size() == 2);
+  CHECK_EQ(vertices.size() * sizeof(float), meshResult.bufferBytes[0]);
+  std::vector<uint8_t> data =
+      ReadBuffer(meshResult.buffers[0], meshResult.bufferBytes[0]);
+  CHECK(std::memcmp(data.data(), vertices.data(), data.size()) == 0);
+  data = ReadBuffer(meshResult.buffers[1], meshResult.bufferBytes[1]);
+  CHECK(std::memcmp(data.data(), indices.data(), data.size()) == 0);
+
+  REQUIRE(textureResult.texture != 0);
+  GLState::Instance().BindTexture(0, GL_TEXTURE_2D, textureResult.texture);
+  std::vector<uint8_t> read(pixels.size());
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glGetTexImage(GL_TEXTURE_2D, 0, GL_RGB, GL_UNSIGNED_BYTE, read.data());
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  CHECK(read == pixels);
+  // The whole mip chain is there, down to 1x1
+  GLint width = 0;
+  glGetTexLevelParameteriv(GL_TEXTURE_2D, 6, GL_TEXTURE_WIDTH, &width);
+  CHECK_EQ(1, width);
+  GLState::Instance().BindTexture(0, GL_TEXTURE_2D, 0);
+
+  UploaderStats stats = uploader.GetStats();
+  CHECK_EQ(2u, stats.jobs);
+  CHECK_EQ(vertices.size() * sizeof(float) +
+               indices.size() * sizeof(unsigned int) + pixels.size(),
+           static_cast<size_t>(stats.bytes));
+  uploader.Stop();
+  CHECK(!uploader.IsThreaded());
+
+  glDeleteBuffers(2, meshResult.buffers.data());
+  glDeleteTextures(1, &textureResult.texture);
+  CHECK_EQ(0u, GLState::Instance().Validate(nullptr));
+  CHECK(glGetError() == GL_NO_ERROR);
+}
+
+TEST(GpuUploaderSkipsCanceledJobs) {
+  SharedContext shared;
+  REQUIRE(GetTestContext().CreateSharedContext(shared));
+  GpuUploader uploader;
+  REQUIRE(uploader.Start(shared));
+
+  std::vector<BufferUpload> buffers(1);
+  buffers[0].data.resize(1 << 20);
+  int ready = 0;
+  UploadTicket first = uploader.UploadBuffers(
+      buffers, [&](const UploadResult &) { ready++; });
+  UploadTicket second = uploader.UploadBuffers(
+      buffers, [&](const UploadResult &) { ready++; });
+  // Whether or not it was uploaded yet, the second one is never handed over
+  uploader.Cancel(second);
+  uploader.Finish();
+  CHECK_EQ(1, ready);
+  CHECK_EQ(2u, uploader.GetStats().jobs);
+  CHECK_EQ(0u, uploader.GetPending());
+  // Finished jobs cannot be canceled any more
+  uploader.Cancel(first);
+  uploader.Cancel(0);
+  uploader.Stop();
+  CHECK(glGetError() == GL_NO_ERROR);
+}
+
+TEST(GpuUploaderFallsBackToTheRenderThread) {
+  SharedContext broken;
+  broken.makeCurrent = []() { return false; };
+  GpuUploader uploader;
+  CHECK(!uploader.Start(broken));
+  CHECK(!uploader.IsThreaded());
+
+  std::vector<unsigned short> values = {1, 2, 3, 4, 5};
+  std::vector<BufferUpload> buffers;
+  buffers.push_back(MakeBufferUpload(values));
+  GLuint buffer = 0;
+  uploader.UploadBuffers(buffers, [&](const UploadResult &result) {
+    buffer = result.buffers[0];
+  });
+  // Uploaded already, but the callback still waits for Poll()
+  CHECK_EQ(0u, buffer);
+  CHECK_EQ(1u, uploader.GetPending());
+  CHECK_EQ(1u, uploader.Poll());
+  REQUIRE(buffer != 0);
+  std::vector<uint8_t> data = ReadBuffer(buffer, values.size() * 2);
+  CHECK(std::memcmp(data.data(), values.data(), data.size()) == 0);
+
+  // A canceled job's objects are deleted instead
+  GLuint canceled = 0;
+  UploadTicket ticket = uploader.UploadBuffers(
+      buffers, [&](const UploadResult &result) { canceled = result.buffers[0]; });
+  uploader.Cancel(ticket);
+  CHECK_EQ(1u, uploader.Poll());
+  CHECK_EQ(0u, canceled);
+
+  glDeleteBuffers(1, &buffer);
+  CHECK_EQ(0u, GLState::Instance().Validate(nullptr));
+  CHECK(glGetError() == GL_NO_ERROR);
+}
+
+TEST(OBJModelArrivesThroughTheUploader) {
+  SharedContext shared;
+  REQUIRE(GetTestContext().CreateSharedContext(shared));
+  GpuUploader uploader;
+  REQUIRE(uploader.Start(shared));
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  {
+    OBJModel model;
+    model.setUploader(&uploader);
+    model.loadModelFromFile(std::string(ENGINE_SOURCE_DIR) +
+                            "/common/objects/textured_cube/cube.obj");
+    // The host copies are gone already, the buffers are not there yet
+    CHECK(!model.isReady());
+    CHECK_EQ(0u, tracker.GetCpuBytes("OBJModel"));
+    model.render();
+    uploader.Finish();
+    CHECK(model.isReady());
+    CHECK_EQ(2u + OBJModel::kCacheModes,
+             tracker.GetGpuCount(GpuResourceKind::Buffer));
+    CHECK_EQ(2u, tracker.GetGpuCount(GpuResourceKind::VertexArray));
+    CHECK_EQ(1u, tracker.GetGpuCount(GpuResourceKind::Texture));
+
+    // Unloaded before its second upload arrives: nothing leaks
+    model.loadModelFromFile(std::string(ENGINE_SOURCE_DIR) +
+                            "/common/objects/textured_cube/cube.obj");
+    model.unload();
+    uploader.Finish();
+    CHECK(!model.isReady());
+  }
+  uploader.Stop();
+  std::ostringstream out;
+  CHECK_EQ(0u, tracker.CheckForLeaks(out));
+  CHECK_EQ(0u, GLState::Instance().Validate(nullptr));
+  CHECK(glGetError() == GL_NO_ERROR);
+}
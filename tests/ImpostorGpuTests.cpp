@@ -0,0 +1,99 @@
+#include "Impostor.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <sstream>
+#include <vector>
+
+TEST(ImpostorBakesAndDraws) {
+  const int width = 64, height = 64;
+  GLuint fbo = 0, renderbuffers[2] = {0, 0};
+  glGenFramebuffers(1, &fbo);
+  glGenRenderbuffers(2, renderbuffers);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[0]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, renderbuffers[1]);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, renderbuffers[0]);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, renderbuffers[1]);
+  REQUIRE(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+  glViewport(0, 0, width, height);
+
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  {
+    // The "mesh" is an opaque red square in the middle of every tile
+    ImpostorAtlas atlas;
+    int tiles = 0;
+    bool centered = true;
+    glm::vec3 center(1.0f, 2.0f, 3.0f);
+    REQUIRE(atlas.Bake(center, 0.5f, 4, 32,
+                       [&](const glm::mat4 &view, const glm::mat4 &projection) {
+                         glm::vec4 clip =
+                             projection * view * glm::vec4(center, 1.0f);
+                         centered = centered && std::fabs(clip.x) < 1e-4f &&
+                                    std::fabs(clip.y) < 1e-4f;
+                         GLint viewport[4];
+                         glGetIntegerv(GL_VIEWPORT, viewport);
+                         glEnable(GL_SCISSOR_TEST);
+                         glScissor(viewport[0] + viewport[2] / 4,
+                                   viewport[1] + viewport[3] / 4,
+                                   viewport[2] / 2, viewport[3] / 2);
+                         glClearColor(1.0f, 0.0f, 0.0f, 1.0f);
+                         glClear(GL_COLOR_BUFFER_BIT);
+                         glDisable(GL_SCISSOR_TEST);
+                         tiles++;
+                       }));
+    CHECK_EQ(16, tiles);
+    CHECK(centered);
+    // The caller's framebuffer and viewport are back
+    GLint bound = 0, viewport[4];
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &bound);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    CHECK_EQ(static_cast<GLint>(fbo), bound);
+    CHECK_EQ(width, viewport[2]);
+    CHECK_EQ(1u, tracker.GetGpuCount(GpuResourceKind::Texture));
+    CHECK_EQ(0u, tracker.GetGpuCount(GpuResourceKind::Framebuffer));
+
+    ImpostorRenderer renderer;
+    REQUIRE(renderer.Create());
+    glm::vec3 eye(1.0f, 2.0f, 8.0f);
+    glm::mat4 view = glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection =
+        glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f);
+    std::vector<ImpostorInstance> instances = {
+        {glm::vec3(0.0f), 1.0f, 1.0f}};
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    renderer.Draw(atlas, instances, view, projection, eye);
+    CHECK_EQ(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+    // Red in the middle of the screen, the clear color in the corner
+    std::vector<unsigned char> pixels(width * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                 pixels.data());
+    const unsigned char *middle = &pixels[((height / 2) * width + width / 2) * 4];
+    CHECK(middle[0] > 200 && middle[2] < 50);
+    CHECK_EQ(255, static_cast<int>(pixels[2]));
+
+    // Fade 0: nothing is left for the impostor
+    instances[0].fade = 0.0f;
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    renderer.Draw(atlas, instances, view, projection, eye);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                 pixels.data());
+    CHECK_EQ(0, static_cast<int>(middle[0]));
+    glDisable(GL_DEPTH_TEST);
+  }
+  std::ostringstream out;
+  CHECK_EQ(0u, tracker.CheckForLeaks(out));
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(2, renderbuffers);
+}
@@ -0,0 +1,93 @@
+#include "Impostor.hpp"
+#include "TestHarness.hpp"
+
+#include <cmath>
+
+static bool Near(const glm::vec3 &a, const glm::vec3 &b, float epsilon) {
+  return glm::length(a - b) <= epsilon;
+}
+
+TEST(OctahedralMappingRoundTrips) {
+  const glm::vec3 directions[] = {
+      {0.0f, 1.0f, 0.0f},  {0.0f, -1.0f, 0.0f}, {1.0f, 0.0f, 0.0f},
+      {0.0f, 0.0f, -1.0f}, {0.3f, -0.8f, 0.5f}, {-0.6f, 0.2f, -0.7f}};
+  for (glm::vec3 direction : directions) {
+    direction = glm::normalize(direction);
+    glm::vec2 uv = OctahedralEncode(direction);
+    CHECK(uv.x >= 0.0f && uv.x <= 1.0f && uv.y >= 0.0f && uv.y <= 1.0f);
+    CHECK(Near(direction, OctahedralDecode(uv), 1e-5f));
+  }
+  // Up is the middle of the map
+  CHECK(Near(glm::vec3(0.5f, 0.5f, 0.0f),
+             glm::vec3(OctahedralEncode(glm::vec3(0.0f, 1.0f, 0.0f)), 0.0f),
+             1e-6f));
+}
+
+TEST(ImpostorFramesCoverTheSphere) {
+  const int n = 8;
+  for (int y = 0; y < n; y++) {
+    for (int x = 0; x < n; x++) {
+      glm::vec3 direction = ImpostorFrameDirection(x, y, n);
+      CHECK(std::fabs(glm::length(direction) - 1.0f) < 1e-5f);
+      // A tile's own direction finds that tile
+      glm::ivec2 frame = ImpostorNearestFrame(direction, n);
+      CHECK_EQ(x, frame.x);
+      CHECK_EQ(y, frame.y);
+
+      glm::vec3 right, up;
+      ImpostorFrameBasis(direction, right, up);
+      CHECK(std::fabs(glm::dot(right, direction)) < 1e-5f);
+      CHECK(std::fabs(glm::dot(up, direction)) < 1e-5f);
+      CHECK(std::fabs(glm::length(up) - 1.0f) < 1e-5f);
+    }
+  }
+}
+
+TEST(ImpostorFadeByScreenSize) {
+  ImpostorLodSettings settings;
+  settings.thresholdPixels = 100.0f;
+  settings.fadePixels = 20.0f;
+  CHECK_EQ(0.0f, ImpostorFade(150.0f, settings));
+  CHECK_EQ(0.0f, ImpostorFade(100.0f, settings));
+  CHECK_EQ(0.5f, ImpostorFade(90.0f, settings));
+  CHECK_EQ(1.0f, ImpostorFade(80.0f, settings));
+  CHECK_EQ(1.0f, ImpostorFade(1.0f, settings));
+
+  // A sphere filling the view from top to bottom
+  float fovY = glm::radians(90.0f);
+  CHECK(std::fabs(ProjectedDiameter(1.0f, 1.0f / std::tan(fovY * 0.5f), fovY,
+                                    600.0f) -
+                  600.0f) < 1e-3f);
+  CHECK(ProjectedDiameter(1.0f, 20.0f, fovY, 600.0f) <
+        ProjectedDiameter(1.0f, 10.0f, fovY, 600.0f));
+}
+
+TEST(SelectImpostorsSplitsByDistance) {
+  ImpostorInstance instances[] = {{glm::vec3(0.0f, 0.0f, -2.0f), 1.0f, 0.0f},
+                                  {glm::vec3(0.0f, 0.0f, -500.0f), 1.0f, 0.0f},
+                                  {glm::vec3(0.0f, 0.0f, -30.0f), 1.0f, 0.0f}};
+  ImpostorLodSettings settings;
+  settings.thresholdPixels = 100.0f;
+  settings.fadePixels = 80.0f;
+  // 150, 0.6 and 10 pixels tall
+  float fovY = glm::radians(90.0f);
+  ImpostorSelection selection;
+  SelectImpostors(instances, 3, glm::vec3(0.0f), 1.0f, glm::vec3(0.0f), fovY,
+                  300.0f, settings, selection);
+  REQUIRE(selection.meshes.size() == 1u);
+  CHECK_EQ(0u, selection.meshes[0]);
+  CHECK_EQ(0.0f, selection.meshFades[0]);
+  REQUIRE(selection.impostors.size() == 2u);
+  CHECK_EQ(1.0f, selection.impostors[0].fade);
+  CHECK_EQ(-500.0f, selection.impostors[0].position.z);
+
+  // A lower threshold: the third one cross-fades and is drawn both ways
+  settings.thresholdPixels = 14.0f;
+  settings.fadePixels = 8.0f;
+  SelectImpostors(instances, 3, glm::vec3(0.0f), 1.0f, glm::vec3(0.0f), fovY,
+                  300.0f, settings, selection);
+  CHECK_EQ(2u, selection.meshes.size());
+  CHECK_EQ(2u, selection.impostors.size());
+  CHECK(std::fabs(selection.meshFades[1] - 0.5f) < 1e-4f);
+  CHECK_EQ(selection.meshFades[1], selection.impostors[1].fade);
+}
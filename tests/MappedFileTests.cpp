@@ -0,0 +1,47 @@
+#include "MappedFile.hpp"
+#include "TestHarness.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+TEST(MappedFilesHoldTheWholeFile) {
+  fs::path path =
+      fs::temp_directory_path() /
+      ("cs5310_mapped_" +
+       std::to_string(
+           std::chrono::steady_clock::now().time_since_epoch().count()));
+  std::string text(10000, '\0');
+  for (size_t i = 0; i < text.size(); i++) {
+    text[i] = static_cast<char>(i * 13 % 251);
+  }
+  std::ofstream(path, std::ios::binary) << text;
+
+  MappedFile file;
+  std::string error;
+  REQUIRE(file.Open(path.string(), &error));
+  CHECK(file.IsOpen());
+  REQUIRE(file.GetSize() == text.size());
+  CHECK(std::memcmp(file.GetData(), text.data(), text.size()) == 0);
+  // Hints only; they change nothing that can be read
+  file.AdviseRandom();
+  file.Prefetch(file.GetData() + 5000, 100);
+  CHECK(file.GetData()[5000] == static_cast<uint8_t>(text[5000]));
+  file.Close();
+  CHECK(!file.IsOpen());
+  CHECK_EQ(size_t(0), file.GetSize());
+
+  // Missing and empty files are refused, and say so
+  CHECK(!file.Open((path.string() + ".missing"), &error));
+  CHECK(error.find("could not open") != std::string::npos);
+  std::ofstream(path, std::ios::binary | std::ios::trunc);
+  CHECK(!file.Open(path.string(), &error));
+  CHECK(error.find("is empty") != std::string::npos);
+  CHECK(!file.IsOpen());
+  std::error_code code;
+  fs::remove(path, code);
+}
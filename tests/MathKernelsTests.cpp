@@ -0,0 +1,132 @@
+#include "MathKernels.hpp"
+#include "TestHarness.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// Bitwise equality (also tells -0.0f from 0.0f)
+static bool SameBits(float a, float b) {
+  return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+static bool SameBits(const glm::mat4 &a, const glm::mat4 &b) {
+  return std::memcmp(&a, &b, sizeof(glm::mat4)) == 0;
+}
+
+static bool SameBits(const std::vector<float> &a, const std::vector<float> &b) {
+  return a.size() == b.size() &&
+         std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+static glm::mat4 RandomAffine(std::mt19937 &random) {
+  std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+  glm::mat4 m = glm::translate(glm::mat4(1.0f), glm::vec3(value(random),
+                                                          value(random),
+                                                          value(random)));
+  m = glm::rotate(m, value(random),
+                  glm::normalize(glm::vec3(value(random), value(random),
+                                           value(random)) +
+                                 glm::vec3(0.0f, 0.0f, 20.0f)));
+  return glm::scale(m, glm::vec3(value(random), 1.0f, -0.5f));
+}
+
+TEST(AlignedMat4MatchesGlm) {
+  std::mt19937 random(1);
+  for (int i = 0; i < 100; i++) {
+    glm::mat4 a = RandomAffine(random), b = RandomAffine(random);
+    SimdMat4 product = SimdMat4(a) * SimdMat4(b);
+    CHECK(SameBits(a * b, glm::mat4(product)));
+  }
+}
+
+TEST(MultiplyMat4BatchMatchesGlm) {
+  std::mt19937 random(2);
+  std::vector<glm::mat4> lhs, rhs, expected;
+  for (int i = 0; i < 37; i++) {
+    lhs.push_back(RandomAffine(random));
+    rhs.push_back(RandomAffine(random));
+    expected.push_back(lhs.back() * rhs.back());
+  }
+  std::vector<glm::mat4> simd(lhs.size()), scalar(lhs.size());
+  MultiplyMat4Batch(lhs.data(), rhs.data(), simd.data(), lhs.size());
+  MultiplyMat4BatchScalar(lhs.data(), rhs.data(), scalar.data(), lhs.size());
+  for (size_t i = 0; i < lhs.size(); i++) {
+    CHECK(SameBits(expected[i], simd[i]));
+    CHECK(SameBits(expected[i], scalar[i]));
+  }
+  // In place
+  MultiplyMat4Batch(lhs.data(), rhs.data(), lhs.data(), lhs.size());
+  CHECK(SameBits(expected[5], lhs[5]));
+}
+
+TEST(TransformPointsMatchesGlm) {
+  std::mt19937 random(3);
+  std::uniform_real_distribution<float> value(-100.0f, 100.0f);
+  glm::mat4 m = RandomAffine(random);
+  PointsSoA points;
+  points.Resize(103); // Not a multiple of four
+  for (size_t i = 0; i < points.Size(); i++) {
+    points.x[i] = value(random);
+    points.y[i] = value(random);
+    points.z[i] = i == 0 ? -0.0f : value(random);
+  }
+  PointsSoA simd, scalar;
+  TransformPoints(m, points, simd);
+  TransformPointsScalar(m, points, scalar);
+  CHECK(SameBits(scalar.x, simd.x));
+  CHECK(SameBits(scalar.y, simd.y));
+  CHECK(SameBits(scalar.z, simd.z));
+  for (size_t i = 0; i < points.Size(); i++) {
+    glm::vec4 p = m * glm::vec4(points.x[i], points.y[i], points.z[i], 1.0f);
+    CHECK(SameBits(p.x, simd.x[i]) && SameBits(p.y, simd.y[i]) &&
+          SameBits(p.z, simd.z[i]));
+  }
+}
+
+TEST(TransformAabbsMatchesScalarAndCorners) {
+  std::mt19937 random(4);
+  std::uniform_real_distribution<float> value(-50.0f, 50.0f);
+  glm::mat4 m = RandomAffine(random);
+  AabbSoA boxes;
+  boxes.Resize(42);
+  for (size_t i = 0; i < boxes.Size(); i++) {
+    float x = value(random), y = value(random), z = value(random);
+    boxes.minX[i] = x;
+    boxes.minY[i] = y;
+    boxes.minZ[i] = z;
+    boxes.maxX[i] = x + std::abs(value(random));
+    boxes.maxY[i] = y + std::abs(value(random));
+    boxes.maxZ[i] = z;
+  }
+  AabbSoA simd, scalar;
+  TransformAabbs(m, boxes, simd);
+  TransformAabbsScalar(m, boxes, scalar);
+  CHECK(SameBits(scalar.minX, simd.minX));
+  CHECK(SameBits(scalar.maxX, simd.maxX));
+  CHECK(SameBits(scalar.minY, simd.minY));
+  CHECK(SameBits(scalar.maxY, simd.maxY));
+  CHECK(SameBits(scalar.minZ, simd.minZ));
+  CHECK(SameBits(scalar.maxZ, simd.maxZ));
+
+  // The result is the bounding box of the eight transformed corners
+  for (size_t i = 0; i < boxes.Size(); i++) {
+    glm::vec3 lo(1e30f), hi(-1e30f);
+    for (int c = 0; c < 8; c++) {
+      glm::vec4 corner((c & 1) ? boxes.maxX[i] : boxes.minX[i],
+                       (c & 2) ? boxes.maxY[i] : boxes.minY[i],
+                       (c & 4) ? boxes.maxZ[i] : boxes.minZ[i], 1.0f);
+      glm::vec3 p(m * corner);
+      lo = glm::min(lo, p);
+      hi = glm::max(hi, p);
+    }
+    const float tolerance = 1e-3f;
+    CHECK(std::abs(lo.x - simd.minX[i]) < tolerance);
+    CHECK(std::abs(hi.y - simd.maxY[i]) < tolerance);
+    CHECK(std::abs(lo.z - simd.minZ[i]) < tolerance);
+    CHECK(std::abs(hi.z - simd.maxZ[i]) < tolerance);
+  }
+}
@@ -0,0 +1,106 @@
+#include "CommandBuffer.hpp"
+#include "GLState.hpp"
+#include "GpuTestSupport.hpp"
+#include "MultiView.hpp"
+#include "TestHarness.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// A small quad around the origin, moved by the view of its instance and
+// sent to that layer, like Assignment10_fbo's vert.glsl with MULTIVIEW and
+// shaders/geom_multiview.glsl
+static const char *kVertexSource = R"(#version 330 core
+layout(std140) uniform Views {
+  mat4 viewProjections[4];
+  ivec4 viewCount;
+};
+out VertexData { flat int layer; };
+void main() {
+  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1) * 0.5 - 0.25;
+  gl_Position = viewProjections[gl_InstanceID] * vec4(corner, 0.0, 1.0);
+  layer = gl_InstanceID;
+}
+)";
+static const char *kGeometrySource = R"(#version 330 core
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+in VertexData { flat int layer; } vertices[];
+void main() {
+  for (int i = 0; i < 3; ++i) {
+    gl_Position = gl_in[i].gl_Position;
+    gl_Layer = vertices[i].layer;
+    EmitVertex();
+  }
+  EndPrimitive();
+}
+)";
+static const char *kFragmentSource = R"(#version 330 core
+out vec4 color;
+void main() { color = vec4(1.0, 0.0, 0.0, 1.0); }
+)";
+
+TEST(OneInstancedDrawFillsEveryLayer) {
+  const int size = 32, layers = 2;
+  GLuint program = CompileTestProgram(
+      {kVertexSource, kGeometrySource, kFragmentSource},
+      {GL_VERTEX_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER});
+  REQUIRE(program != 0);
+  glUniformBlockBinding(program, glGetUniformBlockIndex(program, "Views"), 2);
+  GLState &state = GLState::Instance();
+  GLuint color = 0, fbo = 0, readFbo = 0, vao = 0;
+  glGenTextures(1, &color);
+  state.BindTexture(0, GL_TEXTURE_2D_ARRAY, color);
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, size, size, layers, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  glGenFramebuffers(1, &fbo);
+  state.BindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferTexture(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, color, 0);
+  REQUIRE(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+  state.Viewport(0, 0, size, size);
+  state.ClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+  // Clears every layer
+  glClear(GL_COLOR_BUFFER_BIT);
+  glGenVertexArrays(1, &vao);
+
+  // View 0 moves the quad to the left, view 1 to the right
+  const glm::mat4 views[] = {
+      glm::translate(glm::mat4(1.0f), glm::vec3(-0.5f, 0.0f, 0.0f)),
+      glm::translate(glm::mat4(1.0f), glm::vec3(0.5f, 0.0f, 0.0f))};
+  ViewsBlock block = MakeViewsBlock(views, layers);
+  CommandBuffer commands;
+  commands.BindProgram(program);
+  commands.BindVertexArray(vao);
+  commands.SetUniformBlock(2, &block, sizeof(block));
+  commands.SetInstances(layers);
+  commands.DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  CommandReplayer replayer;
+  REQUIRE(replayer.Create());
+  replayer.Replay(&commands, 1);
+  CHECK_EQ(size_t(1), replayer.GetLastStats().draws);
+  CHECK_EQ(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+  // Each layer has the quad only where its view put it
+  glGenFramebuffers(1, &readFbo);
+  state.BindFramebuffer(GL_FRAMEBUFFER, readFbo);
+  for (int layer = 0; layer < layers; layer++) {
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, color, 0,
+                              layer);
+    unsigned char left[4], right[4];
+    glReadPixels(size / 4, size / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, left);
+    glReadPixels(3 * size / 4, size / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                 right);
+    const unsigned char *quad = layer == 0 ? left : right;
+    const unsigned char *empty = layer == 0 ? right : left;
+    CHECK(quad[0] == 255 && quad[2] == 0);
+    CHECK(empty[0] == 0 && empty[2] == 255);
+  }
+
+  replayer.Release();
+  glDeleteProgram(program);
+  glDeleteVertexArrays(1, &vao);
+  state.BindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteFramebuffers(1, &readFbo);
+  glDeleteTextures(1, &color);
+  state.Invalidate();
+}
@@ -0,0 +1,65 @@
+#include "MultiView.hpp"
+#include "TestHarness.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+static glm::mat4 LookAlong(const glm::vec3 &direction) {
+  return glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 100.0f) *
+         glm::lookAt(glm::vec3(0.0f), direction, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+TEST(MultiViewFrustumKeepsWhatAnyViewSees) {
+  const glm::mat4 views[] = {LookAlong(glm::vec3(0.0f, 0.0f, -1.0f)),
+                             LookAlong(glm::vec3(1.0f, 0.0f, 0.0f))};
+  const glm::vec3 ahead(0.0f, 0.0f, -10.0f), right(10.0f, 0.0f, 0.0f),
+      behind(0.0f, 0.0f, 10.0f);
+
+  MultiViewFrustum one(views, 1);
+  CHECK_EQ(size_t(1), one.GetViewCount());
+  CHECK(one.IntersectsSphere(ahead, 1.0f));
+  CHECK(!one.IntersectsSphere(right, 1.0f));
+
+  MultiViewFrustum both(views, 2);
+  CHECK(both.IntersectsSphere(ahead, 1.0f));
+  CHECK(both.IntersectsSphere(right, 1.0f));
+  CHECK(!both.IntersectsSphere(behind, 1.0f));
+
+  // No views: nothing is visible
+  MultiViewFrustum none;
+  CHECK(!none.IntersectsSphere(ahead, 1.0f));
+}
+
+TEST(ViewsBlockHoldsTheViews) {
+  glm::mat4 views[kMaxViews + 1];
+  for (unsigned i = 0; i <= kMaxViews; i++) {
+    views[i] = glm::translate(glm::mat4(1.0f), glm::vec3(float(i), 0.0f, 0.0f));
+  }
+  ViewsBlock block = MakeViewsBlock(views, 2);
+  CHECK_EQ(2, block.count.x);
+  CHECK(block.viewProjection[1] == views[1]);
+  CHECK(block.viewProjection[2] == glm::mat4(1.0f));
+  // Extra views are dropped
+  CHECK_EQ(static_cast<int>(kMaxViews),
+           MakeViewsBlock(views, kMaxViews + 1).count.x);
+}
+
+TEST(SplitScreenViewportsTileTheScreen) {
+  const int width = 801, height = 601;
+  for (unsigned count = 1; count <= kMaxViews; count++) {
+    long long area = 0;
+    for (unsigned i = 0; i < count; i++) {
+      glm::ivec4 part = SplitScreenViewport(i, count, width, height);
+      CHECK(part.x >= 0 && part.y >= 0);
+      CHECK(part.x + part.z <= width && part.y + part.w <= height);
+      area += static_cast<long long>(part.z) * part.w;
+    }
+    // Three views leave the bottom right quarter empty
+    if (count != 3) {
+      CHECK_EQ(static_cast<long long>(width) * height, area);
+    }
+  }
+  // Side by side, then top left first
+  CHECK(SplitScreenViewport(1, 2, 800, 600) == glm::ivec4(400, 0, 400, 600));
+  CHECK(SplitScreenViewport(0, 4, 800, 600) == glm::ivec4(0, 300, 400, 300));
+  CHECK(SplitScreenViewport(3, 4, 800, 600) == glm::ivec4(400, 0, 400, 300));
+}
@@ -0,0 +1,80 @@
+#include "OBJModel.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+#include <sstream>
+
+static const std::string kCube =
+    std::string(ENGINE_SOURCE_DIR) + "/common/objects/textured_cube/cube.obj";
+
+TEST(GpuOnlyFreesHostCopies) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  {
+    OBJModel model;
+    model.loadModelFromFile(kCube);
+    // Vertex buffer, one element buffer per cache mode and one for a single
+    // copy, and a vertex array for all copies and one for a single copy
+    CHECK_EQ(2u + OBJModel::kCacheModes,
+             tracker.GetGpuCount(GpuResourceKind::Buffer));
+    CHECK_EQ(2u, tracker.GetGpuCount(GpuResourceKind::VertexArray));
+    CHECK_EQ(0u, tracker.GetCpuBytes("OBJModel"));
+    CHECK_EQ(0u, tracker.GetCpuBytes("Image"));
+    CHECK(model.getCollisionMesh().IsEmpty());
+  }
+  std::ostringstream out;
+  CHECK_EQ(0u, tracker.CheckForLeaks(out));
+}
+
+TEST(CpuCollisionKeepsCompactMesh) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  {
+    OBJModel model;
+    model.setResidency(Residency::CpuCollision);
+    model.loadModelFromFile(kCube);
+    const CollisionMesh &mesh = model.getCollisionMesh();
+    REQUIRE(!mesh.IsEmpty());
+    CHECK_EQ(0u, mesh.indices.size() % 3);
+    // Corners shared by several faces are merged
+    CHECK(mesh.positions.size() / 3 < mesh.indices.size());
+    CHECK_EQ(mesh.GetSizeInBytes(), tracker.GetCpuBytes("OBJModel"));
+    model.unload();
+    CHECK(model.getCollisionMesh().IsEmpty());
+  }
+  std::ostringstream out;
+  CHECK_EQ(0u, tracker.CheckForLeaks(out));
+}
+
+TEST(CpuAndGpuKeepsEverything) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  {
+    OBJModel model;
+    model.setResidency(Residency::CpuAndGpu);
+    model.loadModelFromFile(kCube);
+    CHECK(tracker.GetCpuBytes("OBJModel") > 0);
+    // Switching modes only rebinds a buffer
+    size_t buffers = tracker.GetGpuCount(GpuResourceKind::Buffer);
+    model.setCacheMode(3);
+    model.setCacheMode(1);
+    CHECK_EQ(buffers, tracker.GetGpuCount(GpuResourceKind::Buffer));
+  }
+  std::ostringstream out;
+  CHECK_EQ(0u, tracker.CheckForLeaks(out));
+}
+
+TEST(EveryCacheModeDrawsTheSameTriangles) {
+  OBJModel model;
+  model.loadModelFromFile(kCube);
+  const VertexCacheStats &original = model.getCacheStats(1);
+  REQUIRE(original.triangles > 0);
+  for (int mode = 2; mode <= OBJModel::kCacheModes; mode++) {
+    const VertexCacheStats &stats = model.getCacheStats(mode);
+    CHECK_EQ(original.triangles, stats.triangles);
+    CHECK_EQ(original.uniqueVertices, stats.uniqueVertices);
+  }
+  // Welded corners are shared, so Forsyth beats three misses per triangle
+  CHECK(model.getCacheStats(2).GetAcmr() < 3.0f);
+  CHECK(model.getCacheStats(2).GetAcmr() <= model.getCacheStats(3).GetAcmr());
+}
@@ -0,0 +1,65 @@
+#include "ObjParser.hpp"
+#include "TestHarness.hpp"
+
+#include <string>
+
+static bool Parse(const std::string &text, ObjData &data,
+                  std::string *error = nullptr) {
+  return ParseObj(text.data(), text.size(), data, error);
+}
+
+TEST(ParsesAttributesAndFaces) {
+  ObjData data;
+  REQUIRE(Parse("mtllib cube.mtl\r\n"
+                "v 0 0 0\nv 1 0 0\nv 0 1.5 -2e-1\n"
+                "vt 0.5 1\nvn 0 0 1\n"
+                "# comment\ng group\nusemtl material\n"
+                "f 1/1/1 2/1/1 3/1/1\n",
+                data));
+  CHECK_EQ(std::string("cube.mtl"), data.materialLibrary);
+  CHECK_EQ(3u, data.positions.size());
+  CHECK_EQ(1.5f, data.positions[2].y);
+  CHECK_EQ(-0.2f, data.positions[2].z);
+  CHECK_EQ(1u, data.texCoords.size());
+  CHECK_EQ(1u, data.normals.size());
+  REQUIRE(data.GetTriangleCount() == 1);
+  CHECK_EQ(2, data.corners[2].position);
+  CHECK_EQ(0, data.corners[2].texCoord);
+  CHECK_EQ(0, data.corners[2].normal);
+}
+
+TEST(MissingAttributesAreMinusOne) {
+  ObjData data;
+  REQUIRE(Parse("v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//1\n"
+                "f 1 2 3\n",
+                data));
+  REQUIRE(data.GetTriangleCount() == 2);
+  CHECK_EQ(-1, data.corners[0].texCoord);
+  CHECK_EQ(0, data.corners[0].normal);
+  CHECK_EQ(-1, data.corners[3].texCoord);
+  CHECK_EQ(-1, data.corners[3].normal);
+}
+
+TEST(QuadsBecomeTriangleFans) {
+  ObjData data;
+  REQUIRE(Parse("v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nf 1 2 3 4\n", data));
+  REQUIRE(data.GetTriangleCount() == 2);
+  CHECK_EQ(0, data.corners[3].position);
+  CHECK_EQ(2, data.corners[4].position);
+  CHECK_EQ(3, data.corners[5].position);
+}
+
+TEST(NegativeIndicesAreRelative) {
+  ObjData data;
+  REQUIRE(Parse("v 0 0 0\nv 1 0 0\nv 0 1 0\nf -3 -2 -1\n", data));
+  REQUIRE(data.GetTriangleCount() == 1);
+  CHECK_EQ(0, data.corners[0].position);
+  CHECK_EQ(2, data.corners[2].position);
+}
+
+TEST(OutOfRangeIndexFails) {
+  ObjData data;
+  std::string error;
+  CHECK(!Parse("v 0 0 0\nv 1 0 0\n\nf 1 2 3\n", data, &error));
+  CHECK_EQ(std::string("invalid face on line 4"), error);
+}
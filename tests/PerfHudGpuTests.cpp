@@ -0,0 +1,65 @@
+#include "FrameStats.hpp"
+#include "GpuTimer.hpp"
+#include "PerfHud.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+#include <sstream>
+#include <vector>
+
+TEST(PerfHudDrawsOverlay) {
+  const int width = 400, height = 300;
+  GLuint fbo = 0, color = 0;
+  glGenFramebuffers(1, &fbo);
+  glGenRenderbuffers(1, &color);
+  glBindRenderbuffer(GL_RENDERBUFFER, color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, color);
+  REQUIRE(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  FrameStats::Instance().Reset();
+  {
+    PerfHud hud;
+    REQUIRE(hud.Create());
+    GpuTimer timer;
+    timer.Create();
+    CHECK_EQ(4u, tracker.GetGpuCount(GpuResourceKind::Query));
+
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    // Hidden by default
+    hud.Draw(width, height);
+    CHECK_EQ(0u, hud.GetQuadCount());
+
+    hud.SetVisible(true);
+    timer.Begin();
+    hud.Draw(width, height);
+    timer.End();
+    CHECK(hud.GetQuadCount() > 0u);
+    CHECK(hud.GetLastCost() > 0.0f);
+    CHECK_EQ(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+    // The panel's top left corner is dark, a pixel outside of it is not.
+    // glReadPixels counts rows from the bottom.
+    std::vector<unsigned char> pixels(width * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                 pixels.data());
+    const unsigned char *panel = &pixels[((height - 12) * width + 12) * 4];
+    const unsigned char *outside = &pixels[((height - 2) * width + 2) * 4];
+    CHECK(panel[0] < 128);
+    CHECK_EQ(255, static_cast<int>(outside[0]));
+
+    glFinish();
+    float milliseconds = -1.0f;
+    CHECK(timer.Poll(milliseconds));
+    CHECK(milliseconds >= 0.0f);
+  }
+  std::ostringstream out;
+  CHECK_EQ(0u, tracker.CheckForLeaks(out));
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(1, &color);
+}
@@ -0,0 +1,130 @@
+#include "FrameStats.hpp"
+#include "RedrawScheduler.hpp"
+#include "TestHarness.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+// Runs iterations until the scheduler goes idle; returns how many drew
+static int DrawUntilIdle(RedrawScheduler &redraw) {
+  int drawn = 0;
+  while (redraw.BeginFrame()) {
+    drawn++;
+    REQUIRE(drawn < 1000);
+  }
+  return drawn;
+}
+
+TEST(RedrawSchedulerGoesIdle) {
+  RedrawScheduler redraw(RedrawMode::OnDemand);
+  // The first frame plus the settle frames, then nothing
+  CHECK_EQ(1 + RedrawScheduler::kSettleFrames, DrawUntilIdle(redraw));
+  CHECK(!redraw.IsFrameDue());
+  CHECK_EQ(RedrawScheduler::kIdleTimeoutMs, redraw.GetWaitTimeout());
+  CHECK(!redraw.BeginFrame());
+  CHECK_EQ(2u, redraw.GetIdleWakeups());
+
+  redraw.MarkDirty();
+  CHECK_EQ(0, redraw.GetWaitTimeout());
+  CHECK_EQ(1 + RedrawScheduler::kSettleFrames, DrawUntilIdle(redraw));
+}
+
+TEST(RedrawSchedulerWatchesState) {
+  RedrawScheduler redraw(RedrawMode::OnDemand);
+  float offset = -2.0f;
+  redraw.Watch(HashValue(offset));
+  DrawUntilIdle(redraw);
+  // The same state does not draw again
+  redraw.Watch(HashValue(offset));
+  CHECK(!redraw.IsFrameDue());
+  offset += 0.01f;
+  redraw.Watch(HashValue(offset));
+  CHECK(redraw.IsFrameDue());
+  DrawUntilIdle(redraw);
+
+  // Chained hashes notice a change in any part
+  std::string model = "cube.obj";
+  redraw.Watch(HashState(model.data(), model.size(), HashValue(offset)));
+  DrawUntilIdle(redraw);
+  model = "tree.obj";
+  redraw.Watch(HashState(model.data(), model.size(), HashValue(offset)));
+  CHECK(redraw.IsFrameDue());
+}
+
+TEST(RedrawSchedulerWatchesPolygonMode) {
+  // A10 chains the held 'w' key (wireframe) into its camera state
+  RedrawScheduler redraw(RedrawMode::OnDemand);
+  float offset = -2.0f;
+  bool wireframe = false;
+  redraw.Watch(HashValue(wireframe, HashValue(offset)));
+  DrawUntilIdle(redraw);
+  CHECK(!redraw.IsFrameDue());
+
+  wireframe = true;
+  redraw.Watch(HashValue(wireframe, HashValue(offset)));
+  CHECK(redraw.IsFrameDue());
+  CHECK_EQ(1 + RedrawScheduler::kSettleFrames, DrawUntilIdle(redraw));
+
+  // Releasing the key draws the filled scene again
+  wireframe = false;
+  redraw.Watch(HashValue(wireframe, HashValue(offset)));
+  CHECK(redraw.IsFrameDue());
+}
+
+TEST(RedrawSchedulerRequestedFramesAreBounded) {
+  RedrawScheduler redraw(RedrawMode::OnDemand);
+  DrawUntilIdle(redraw);
+  redraw.RequestFrames(10);
+  CHECK_EQ(10, DrawUntilIdle(redraw));
+  redraw.RequestFrames(1000000);
+  CHECK_EQ(RedrawScheduler::kMaxRequestedFrames, DrawUntilIdle(redraw));
+}
+
+TEST(RedrawSchedulerContinuousAlwaysDraws) {
+  RedrawScheduler redraw(RedrawMode::Continuous);
+  for (int i = 0; i < 100; i++) {
+    CHECK(redraw.BeginFrame());
+  }
+  CHECK_EQ(0, redraw.GetWaitTimeout());
+  CHECK_EQ(100u, redraw.GetDrawnFrames());
+  redraw.ToggleMode();
+  CHECK(redraw.GetMode() == RedrawMode::OnDemand);
+  CHECK_EQ(1 + RedrawScheduler::kSettleFrames, DrawUntilIdle(redraw));
+}
+
+TEST(RedrawSchedulerDiscardsIdleTime) {
+  FrameStats &stats = FrameStats::Instance();
+  stats.Reset();
+  RedrawScheduler redraw(RedrawMode::OnDemand);
+  while (redraw.BeginFrame()) {
+    stats.EndFrame();
+  }
+  // Asleep for a while, then a change
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  CHECK(!redraw.BeginFrame());
+  redraw.MarkDirty();
+  REQUIRE(redraw.BeginFrame());
+  stats.EndFrame();
+  CHECK(stats.GetFrameTimes().GetLatest() < 40.0f);
+  stats.Reset();
+}
+
+TEST(RedrawModeFromArgs) {
+  char program[] = "prog";
+  char continuous[] = "--continuous";
+  char onDemand[] = "--on-demand";
+  char *args[] = {program, continuous, onDemand};
+  CHECK(RedrawModeFromArgs(2, args) == RedrawMode::Continuous);
+#ifndef _WIN32
+  unsetenv("ENGINE_REDRAW");
+  CHECK(RedrawModeFromArgs(1, args) == RedrawMode::OnDemand);
+  setenv("ENGINE_REDRAW", "continuous", 1);
+  CHECK(RedrawModeFromArgs(1, args) == RedrawMode::Continuous);
+  // The command line wins
+  char *onDemandArgs[] = {program, onDemand};
+  CHECK(RedrawModeFromArgs(2, onDemandArgs) == RedrawMode::OnDemand);
+  unsetenv("ENGINE_REDRAW");
+#endif
+}
@@ -0,0 +1,28 @@
+#include "Residency.hpp"
+#include "TestHarness.hpp"
+
+#include <string>
+
+TEST(FreeVectorReleasesCapacity) {
+  std::vector<float> values(1000, 1.0f);
+  FreeVector(values);
+  CHECK(values.empty());
+  CHECK_EQ(0u, values.capacity());
+}
+
+TEST(CollisionMeshSize) {
+  CollisionMesh mesh;
+  CHECK(mesh.IsEmpty());
+  mesh.positions = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+  mesh.indices = {0, 1, 2};
+  CHECK(!mesh.IsEmpty());
+  CHECK_EQ(1u, mesh.GetTriangleCount());
+  CHECK(mesh.GetSizeInBytes() >= 9 * sizeof(float) + 3 * sizeof(uint32_t));
+}
+
+TEST(ResidencyNames) {
+  CHECK_EQ(std::string("GpuOnly"),
+           std::string(ResidencyName(Residency::GpuOnly)));
+  CHECK_EQ(std::string("CpuCollision"),
+           std::string(ResidencyName(Residency::CpuCollision)));
+}
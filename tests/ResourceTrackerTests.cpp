@@ -0,0 +1,73 @@
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+#include <sstream>
+
+TEST(TrackAndUntrackGpuObjects) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  tracker.TrackGpu(GpuResourceKind::Buffer, 1, 1024, 0, "test");
+  tracker.TrackGpu(GpuResourceKind::Buffer, 2, 512, 0, "test");
+  tracker.TrackGpu(GpuResourceKind::Texture, 1, 4096, 0, "test");
+  CHECK_EQ(2u, tracker.GetGpuCount(GpuResourceKind::Buffer));
+  CHECK_EQ(1536u, tracker.GetGpuBytes(GpuResourceKind::Buffer));
+  CHECK_EQ(5632u, tracker.GetGpuBytes());
+
+  tracker.UntrackGpu(GpuResourceKind::Buffer, 1);
+  CHECK_EQ(1u, tracker.GetGpuCount(GpuResourceKind::Buffer));
+  CHECK_EQ(4608u, tracker.GetGpuBytes());
+  tracker.Reset();
+}
+
+TEST(NameZeroIsIgnored) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  tracker.TrackGpu(GpuResourceKind::Buffer, 0, 1024, 0, "test");
+  tracker.UntrackGpu(GpuResourceKind::Buffer, 0);
+  CHECK_EQ(0u, tracker.GetGpuCount(GpuResourceKind::Buffer));
+}
+
+TEST(RespecifyKeepsOwner) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  tracker.TrackGpu(GpuResourceKind::Buffer, 7, 16, 0, "first");
+  tracker.TrackGpu(GpuResourceKind::Buffer, 7, 32, 0, "second");
+  GpuResourceInfo info;
+  REQUIRE(tracker.FindGpu(GpuResourceKind::Buffer, 7, info));
+  CHECK_EQ(32u, info.bytes);
+  CHECK_EQ(std::string("first"), info.owner);
+  tracker.Reset();
+}
+
+TEST(TrackedAllocationFollowsOwner) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  {
+    TrackedAllocation a("TestCategory");
+    a.Set(100);
+    CHECK_EQ(100u, tracker.GetCpuBytes("TestCategory"));
+    TrackedAllocation b(a);
+    CHECK_EQ(200u, tracker.GetCpuBytes("TestCategory"));
+    a.Set(10);
+    CHECK_EQ(110u, tracker.GetCpuBytes("TestCategory"));
+  }
+  CHECK_EQ(0u, tracker.GetCpuBytes("TestCategory"));
+  std::ostringstream out;
+  CHECK_EQ(0u, tracker.CheckForLeaks(out));
+}
+
+TEST(LeaksAreReported) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  tracker.TrackGpu(GpuResourceKind::Framebuffer, 3, 0, 0, "leaky");
+  std::ostringstream out;
+  CHECK_EQ(1u, tracker.CheckForLeaks(out));
+  CHECK(out.str().find("leaky") != std::string::npos);
+  tracker.Reset();
+}
+
+TEST(TextureBytesIncludesMipChain) {
+  CHECK_EQ(12u, ResourceTracker::TextureBytes(2, 2, 3, false));
+  CHECK_EQ(16u, ResourceTracker::TextureBytes(2, 2, 3, true));
+  CHECK_EQ(0u, ResourceTracker::TextureBytes(0, 2, 3, true));
+}
@@ -0,0 +1,315 @@
+#include "SceneFile.hpp"
+#include "TestHarness.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// A scene file removed again when the test ends
+struct TestSceneFile {
+  std::string path;
+
+  TestSceneFile() {
+    path = (fs::temp_directory_path() /
+            ("cs5310_scene_" +
+             std::to_string(std::chrono::steady_clock::now()
+                                .time_since_epoch()
+                                .count()) +
+             ".bscene"))
+               .string();
+  }
+  ~TestSceneFile() {
+    std::error_code code;
+    fs::remove(path, code);
+  }
+  void Write(const std::vector<uint8_t> &bytes) const {
+    std::ofstream(path, std::ios::binary)
+        .write(reinterpret_cast<const char *>(bytes.data()),
+               static_cast<std::streamsize>(bytes.size()));
+  }
+};
+
+static const char kSceneText[] = R"(# A terrain under a group, lit twice
+node world
+    translate 10 0 -5.5
+    rotate 0 90 0
+node ground
+    kind terrain
+    parent world
+    static
+    mesh ./assets/textures/terrain2.ppm
+    segments 512 256
+    diffuse ./assets/textures/colormap.ppm
+    detail ./assets/textures/detailmap.ppm
+    shaders ./shaders/vert.glsl ./shaders/frag.glsl
+    scale 1 0.2 1
+node lamp   # Shares the ground's shaders
+    parent world
+    shaders ./shaders/vert.glsl ./shaders/frag.glsl
+light
+    position 51 30.25 51
+    color 3 1.8 0.9
+    attenuation 1 0.3 0.08
+light
+camera
+    eye 125 50 500
+camera
+    eye 0 400 0
+    direction 0 -1 -0.5
+)";
+
+static SceneDescription ParseTestScene() {
+  SceneDescription scene;
+  std::string error;
+  ParseSceneText(kSceneText, sizeof(kSceneText) - 1, scene, &error);
+  return scene;
+}
+
+static bool SameLight(const PointLight &a, const PointLight &b) {
+  return a.position == b.position && a.color == b.color &&
+         a.ambientIntensity == b.ambientIntensity &&
+         a.specularStrength == b.specularStrength &&
+         a.constant == b.constant && a.linear == b.linear &&
+         a.quadratic == b.quadratic;
+}
+
+static bool SameScene(const SceneDescription &a, const SceneDescription &b) {
+  if (a.nodes.size() != b.nodes.size() ||
+      a.lights.size() != b.lights.size() ||
+      a.cameras.size() != b.cameras.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.nodes.size(); i++) {
+    const SceneNodeDesc &x = a.nodes[i];
+    const SceneNodeDesc &y = b.nodes[i];
+    if (x.name != y.name || x.parent != y.parent || x.kind != y.kind ||
+        x.isStatic != y.isStatic || x.mesh != y.mesh ||
+        x.diffuse != y.diffuse || x.detail != y.detail ||
+        x.vertexShader != y.vertexShader ||
+        x.fragmentShader != y.fragmentShader ||
+        x.segments[0] != y.segments[0] || x.segments[1] != y.segments[1] ||
+        x.translation != y.translation || x.rotation != y.rotation ||
+        x.scale != y.scale) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < a.lights.size(); i++) {
+    if (!SameLight(a.lights[i], b.lights[i])) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < a.cameras.size(); i++) {
+    if (a.cameras[i].eye != b.cameras[i].eye ||
+        a.cameras[i].direction != b.cameras[i].direction) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(SceneTextReadsEveryProperty) {
+  SceneDescription scene;
+  std::string error;
+  REQUIRE(ParseSceneText(kSceneText, sizeof(kSceneText) - 1, scene, &error));
+  REQUIRE(scene.nodes.size() == 3u);
+  const SceneNodeDesc &ground = scene.nodes[1];
+  CHECK(ground.kind == SceneNodeKind::Terrain);
+  CHECK_EQ(0, ground.parent);
+  CHECK(ground.isStatic);
+  CHECK_EQ(512u, ground.segments[0]);
+  CHECK_EQ(256u, ground.segments[1]);
+  CHECK(ground.detail == "./assets/textures/detailmap.ppm");
+  CHECK(ground.fragmentShader == "./shaders/frag.glsl");
+  CHECK(ground.scale == glm::vec3(1.0f, 0.2f, 1.0f));
+  CHECK(scene.nodes[0].translation == glm::vec3(10.0f, 0.0f, -5.5f));
+  CHECK(scene.nodes[2].kind == SceneNodeKind::Group);
+  CHECK(!scene.nodes[2].isStatic);
+
+  REQUIRE(scene.lights.size() == 2u);
+  CHECK(scene.lights[0].position == glm::vec3(51.0f, 30.25f, 51.0f));
+  CHECK(scene.lights[0].quadratic == 0.08f);
+  CHECK(SameLight(PointLight(), scene.lights[1]));
+  REQUIRE(scene.cameras.size() == 2u);
+  CHECK(scene.cameras[0].direction == glm::vec3(0.0f, 0.0f, -1.0f));
+  CHECK(scene.cameras[1].direction == glm::vec3(0.0f, -1.0f, -0.5f));
+
+  // Scaled, rotated a quarter turn about y, then translated
+  glm::vec4 corner = SceneNodeMatrix(scene.nodes[0]) *
+                     SceneNodeMatrix(ground) * glm::vec4(1, 1, 0, 1);
+  CHECK(glm::length(glm::vec3(corner) - glm::vec3(10.0f, 0.2f, -6.5f)) <
+        1e-5f);
+}
+
+TEST(SceneTextRoundTrips) {
+  SceneDescription scene = ParseTestScene();
+  REQUIRE(scene.nodes.size() == 3u);
+  // Numbers that need every digit read back the same
+  scene.nodes[2].translation = glm::vec3(0.1f, 1.0f / 3.0f, -1e-7f);
+  scene.lights[1].ambientIntensity = 0.9f;
+  std::string text = WriteSceneText(scene);
+  SceneDescription again;
+  std::string error;
+  REQUIRE(ParseSceneText(text.data(), text.size(), again, &error));
+  CHECK(SameScene(scene, again));
+  CHECK(WriteSceneText(again) == text);
+  // Defaults are left out
+  CHECK(text.find("scale 1 1 1") == std::string::npos);
+  CHECK(text.find("kind group") == std::string::npos);
+}
+
+TEST(SceneTextErrorsNameTheLine) {
+  const char *broken[] = {
+      "node a\nnode a\n",                // Twice
+      "node a\n  parent b\n",             // No such node
+      "node a\n  kind mesh\n",            // No such kind
+      "node a\n  translate 1 2\n",        // Too few
+      "node a\n  segments 4 -2\n",        // Negative
+      "node a\n  scale 1 x 1\n",          // Not a number
+      "mesh ./a.ppm\n",                   // Before any node
+      "node a\nlight\n  eye 0 0 0\n",     // A camera property
+      "node a\n  kind terrain\n",         // No heightmap
+      "node a\n  shaders ./v.glsl\n",     // One shader
+      "node a\n  frobnicate\n",           // Unknown
+  };
+  for (const char *text : broken) {
+    SceneDescription scene;
+    std::string error;
+    CHECK(!ParseSceneText(text, std::strlen(text), scene, &error));
+    CHECK(!error.empty());
+    CHECK(scene.nodes.empty());
+  }
+  SceneDescription scene;
+  std::string error;
+  const char text[] = "# fine\n\nnode a\n  parent a\n";
+  CHECK(!ParseSceneText(text, sizeof(text) - 1, scene, &error));
+  CHECK(error.compare(0, 7, "line 4:") == 0);
+}
+
+TEST(BinaryScenesRoundTrip) {
+  SceneDescription scene = ParseTestScene();
+  TestSceneFile file;
+  std::string error;
+  REQUIRE(WriteSceneFile(file.path, scene, &error));
+  SceneFile binary;
+  REQUIRE(binary.Open(file.path, &error));
+  CHECK_EQ(3u, binary.GetNodeCount());
+  CHECK_EQ(2u, binary.GetLightCount());
+  CHECK_EQ(2u, binary.GetCameraCount());
+  const SceneNodeRecord &ground = binary.GetNode(1);
+  CHECK(std::strcmp(binary.GetString(ground.mesh),
+                    "./assets/textures/terrain2.ppm") == 0);
+  // Each string is stored once
+  CHECK_EQ(ground.vertexShader, binary.GetNode(2).vertexShader);
+  CHECK(std::strcmp(binary.GetString(binary.GetNode(0).mesh), "") == 0);
+  CHECK_EQ(0u, binary.GetNode(1).flags & ~kSceneNodeStatic);
+
+  SceneDescription again;
+  binary.ToDescription(again);
+  CHECK(SameScene(scene, again));
+  binary.Close();
+  CHECK(!binary.IsOpen());
+
+  // LoadScene() takes both forms
+  REQUIRE(LoadScene(file.path, again, &error));
+  CHECK(SameScene(scene, again));
+  std::ofstream(file.path, std::ios::binary) << kSceneText;
+  REQUIRE(LoadScene(file.path, again, &error));
+  CHECK(SameScene(scene, again));
+  CHECK(!LoadScene(file.path + ".missing", again, &error));
+}
+
+TEST(BrokenSceneFilesAreRefused) {
+  SceneDescription scene = ParseTestScene();
+  std::vector<uint8_t> good;
+  REQUIRE(CookScene(scene, good));
+  SceneFileHeader header;
+  std::memcpy(&header, good.data(), sizeof(header));
+  TestSceneFile file;
+  SceneFile binary;
+  std::string error;
+
+  std::vector<uint8_t> bytes(good.begin(), good.end() - 1);
+  file.Write(bytes);
+  CHECK(!binary.Open(file.path, &error));
+  CHECK(!binary.IsOpen());
+
+  bytes = good;
+  bytes[7] = 'X';
+  file.Write(bytes);
+  CHECK(!binary.Open(file.path));
+
+  bytes = good;
+  bytes[8] = 2; // Version
+  file.Write(bytes);
+  CHECK(!binary.Open(file.path));
+
+  // A child before its parent
+  bytes = good;
+  SceneNodeRecord node;
+  size_t nodeOffset = static_cast<size_t>(header.nodesOffset);
+  std::memcpy(&node, bytes.data() + nodeOffset, sizeof(node));
+  node.parent = 1;
+  std::memcpy(bytes.data() + nodeOffset, &node, sizeof(node));
+  file.Write(bytes);
+  CHECK(!binary.Open(file.path, &error));
+  CHECK(error.find("node 0") != std::string::npos);
+
+  // A string past the block
+  bytes = good;
+  std::memcpy(&node, bytes.data() + nodeOffset, sizeof(node));
+  node.name = static_cast<uint32_t>(header.stringsSize);
+  std::memcpy(bytes.data() + nodeOffset, &node, sizeof(node));
+  file.Write(bytes);
+  CHECK(!binary.Open(file.path));
+
+  // Strings that run off the end
+  bytes = good;
+  bytes.back() = 'x';
+  file.Write(bytes);
+  CHECK(!binary.Open(file.path));
+
+  // The light count reaching past the file
+  bytes = good;
+  header.lightCount = 1000000;
+  std::memcpy(bytes.data(), &header, sizeof(header));
+  file.Write(bytes);
+  CHECK(!binary.Open(file.path));
+
+  file.Write(good);
+  CHECK(binary.Open(file.path));
+
+  // Nothing is cooked that the binary form could not load
+  scene.nodes[2].parent = 2;
+  CHECK(!CookScene(scene, bytes, &error));
+  CHECK(bytes.empty());
+}
+
+TEST(LargeScenesOpenInOnePass) {
+  // 100000 nodes in chains of 100, all sharing a few strings
+  SceneDescription scene;
+  scene.nodes.resize(100000);
+  for (size_t i = 0; i < scene.nodes.size(); i++) {
+    SceneNodeDesc &node = scene.nodes[i];
+    node.name = "n" + std::to_string(i);
+    node.parent = i % 100 == 0 ? -1 : static_cast<int>(i) - 1;
+    node.vertexShader = "./shaders/vert.glsl";
+    node.fragmentShader = "./shaders/frag.glsl";
+    node.translation = glm::vec3(static_cast<float>(i), 0.0f, 1.0f);
+  }
+  TestSceneFile file;
+  REQUIRE(WriteSceneFile(file.path, scene));
+  SceneFile binary;
+  REQUIRE(binary.Open(file.path));
+  CHECK_EQ(100000u, binary.GetNodeCount());
+  CHECK_EQ(99998, binary.GetNode(99999).parent);
+  CHECK(std::strcmp(binary.GetString(binary.GetNode(99999).name),
+                    "n99999") == 0);
+  CHECK(binary.GetNode(70000).translation[0] == 70000.0f);
+  // Records, and the names plus two shared paths
+  CHECK(binary.GetSize() < 100000 * (sizeof(SceneNodeRecord) + 8) + 1024);
+}
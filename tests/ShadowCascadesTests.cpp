@@ -0,0 +1,133 @@
+#include "ShadowCascades.hpp"
+#include "TestHarness.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+
+static const float kFovY = glm::radians(45.0f);
+static const float kAspect = 4.0f / 3.0f;
+static const glm::vec3 kSun(-0.5f, -1.0f, -0.3f);
+
+static glm::mat4 CameraAt(const glm::vec3 &eye, const glm::vec3 &direction) {
+  return glm::lookAt(eye, eye + direction, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+TEST(CascadeSplitsGrowTowardsTheFarPlane) {
+  float ends[kMaxCascades];
+  ComputeCascadeSplits(0.1f, 512.0f, 4, 0.75f, ends);
+  float previous = 0.1f;
+  for (unsigned i = 0; i < 4; i++) {
+    CHECK(ends[i] > previous);
+    previous = ends[i];
+  }
+  CHECK_EQ(512.0f, ends[3]);
+  // Logarithmic splits give the near cascades a lot less than uniform ones
+  float uniform[kMaxCascades];
+  ComputeCascadeSplits(0.1f, 512.0f, 4, 0.0f, uniform);
+  CHECK(std::fabs(uniform[0] - (0.1f + 511.9f / 4.0f)) < 1e-3f);
+  CHECK(ends[0] < uniform[0]);
+}
+
+TEST(SliceSphereHoldsTheSliceWhicheverWayTheCameraLooks) {
+  const float sliceNear = 10.0f, sliceFar = 80.0f;
+  glm::mat4 view = CameraAt(glm::vec3(5.0f, 20.0f, 30.0f),
+                            glm::vec3(1.0f, -0.2f, -1.0f));
+  glm::vec3 center;
+  float radius;
+  FrustumSliceSphere(view, kFovY, kAspect, sliceNear, sliceFar, center,
+                     radius);
+  glm::mat4 toWorld = glm::inverse(view);
+  float tangent = std::tan(kFovY * 0.5f);
+  for (float distance : {sliceNear, sliceFar}) {
+    for (float x : {-1.0f, 1.0f}) {
+      for (float y : {-1.0f, 1.0f}) {
+        glm::vec4 corner(x * distance * tangent * kAspect,
+                         y * distance * tangent, -distance, 1.0f);
+        glm::vec3 world = glm::vec3(toWorld * corner);
+        CHECK(glm::length(world - center) <= radius * 1.0001f);
+      }
+    }
+  }
+  // Turning the camera moves the sphere but does not resize it
+  glm::vec3 turnedCenter;
+  float turnedRadius;
+  FrustumSliceSphere(CameraAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+                     kFovY, kAspect, sliceNear, sliceFar, turnedCenter,
+                     turnedRadius);
+  CHECK(std::fabs(turnedRadius - radius) < 1e-4f * radius);
+}
+
+TEST(CascadesMoveInWholeTexels) {
+  const int resolution = 1024;
+  const float half = 0.5f * resolution;
+  ShadowCascade a = FitShadowCascade(glm::vec3(10.0f, 0.0f, -20.0f), 50.0f,
+                                     kSun, resolution, 100.0f);
+  ShadowCascade b = FitShadowCascade(glm::vec3(10.37f, 0.0f, -20.11f), 50.0f,
+                                     kSun, resolution, 100.0f);
+  // The world origin is on a texel corner...
+  glm::vec2 origin = glm::vec2(a.viewProjection * glm::vec4(0, 0, 0, 1)) * half;
+  CHECK(std::fabs(origin.x - std::round(origin.x)) < 1e-2f);
+  CHECK(std::fabs(origin.y - std::round(origin.y)) < 1e-2f);
+  // ...so any world point is at the same place within its texel after the
+  // cascade moved
+  glm::vec4 point(3.3f, 1.7f, -12.9f, 1.0f);
+  glm::vec2 inA = glm::vec2(a.viewProjection * point) * half;
+  glm::vec2 inB = glm::vec2(b.viewProjection * point) * half;
+  glm::vec2 moved = inB - inA;
+  CHECK(std::fabs(moved.x - std::round(moved.x)) < 1e-2f);
+  CHECK(std::fabs(moved.y - std::round(moved.y)) < 1e-2f);
+  // The center is in the map, in front of the light
+  glm::vec4 center = a.viewProjection * glm::vec4(a.center, 1.0f);
+  CHECK(std::fabs(center.x) < 0.01f && std::fabs(center.y) < 0.01f);
+  CHECK(center.z > -1.0f && center.z < 1.0f);
+}
+
+TEST(CachedCascadesAreOnlyRedrawnWhenTheyMustBe) {
+  ShadowCascadeCache cache;
+  CHECK_EQ(3u, cache.GetCount());
+  CHECK(!cache.IsCached(0) && cache.IsCached(1) && cache.IsCached(2));
+  const glm::vec3 forward(0.0f, 0.0f, -1.0f);
+  glm::vec3 eye(100.0f, 50.0f, 400.0f);
+  auto update = [&](const glm::vec3 &light) {
+    return cache.Update(CameraAt(eye, forward), kFovY, kAspect, 0.1f, 512.0f,
+                        light);
+  };
+
+  CHECK_EQ(7u, update(kSun));
+  // The near cascade follows the camera every frame
+  CHECK_EQ(1u, update(kSun));
+  eye.x += 2.0f;
+  CHECK_EQ(1u, update(kSun));
+  // Far enough that the slices leave what the far cascades cover
+  eye.x += 300.0f;
+  CHECK_EQ(7u, update(kSun));
+  // A new light direction or static geometry redraws everything
+  CHECK_EQ(7u, update(glm::vec3(0.0f, -1.0f, 0.0f)));
+  CHECK_EQ(1u, update(glm::vec3(0.0f, -1.0f, 0.0f)));
+  cache.Invalidate();
+  CHECK_EQ(7u, update(glm::vec3(0.0f, -1.0f, 0.0f)));
+
+  const ShadowCascadeStats &stats = cache.GetStats();
+  CHECK_EQ(uint64_t(7), stats.frames);
+  CHECK_EQ(uint64_t(7), stats.drawn[0]);
+  CHECK_EQ(uint64_t(4), stats.drawn[2]);
+
+  // The cascades cover their part of the view range, in order
+  ShadowBlock block = cache.GetBlock(CameraAt(eye, forward));
+  CHECK_EQ(3, block.count.x);
+  CHECK(block.cascadeEnds[0] < block.cascadeEnds[1]);
+  CHECK_EQ(512.0f, block.cascadeEnds[2]);
+  CHECK(block.lightViewProjection[1] == cache.GetCascade(1).viewProjection);
+}
+
+TEST(ShadowSettingsAreClamped) {
+  ShadowCascadeCache cache;
+  ShadowSettings settings;
+  settings.cascades = 9;
+  cache.SetSettings(settings);
+  CHECK_EQ(kMaxCascades, cache.GetCount());
+  settings.cascades = 0;
+  cache.SetSettings(settings);
+  CHECK_EQ(1u, cache.GetCount());
+}
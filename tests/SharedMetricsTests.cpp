@@ -0,0 +1,123 @@
+#include "SharedMetrics.hpp"
+#include "TestHarness.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+// Unique per test run, so parallel runs do not share a block
+static std::string TestName(const char *suffix) {
+  return "/cs5310_test_" + std::to_string(getpid()) + "_" + suffix;
+}
+
+TEST(SharedMetricsRoundTrip) {
+  std::string name = TestName("roundtrip");
+  MetricsReader reader;
+  CHECK(!reader.Open(name)); // Nobody publishes yet
+
+  MetricsPublisher publisher;
+  REQUIRE(publisher.Open(name));
+  REQUIRE(reader.Open(name));
+  MetricsSnapshot snapshot{};
+  CHECK(!reader.Read(snapshot)); // Nothing published yet
+
+  MetricsSnapshot published{};
+  published.frameNumber = 42;
+  published.cacheMode = 2;
+  published.frameP99Ms = 33.5f;
+  published.triangles = 1234567;
+  SetMetricsText(published.program, "part1");
+  SetMetricsText(published.model, std::string(500, 'x')); // Truncated
+  publisher.Publish(published);
+  REQUIRE(reader.Read(snapshot));
+  CHECK_EQ(42u, snapshot.frameNumber);
+  CHECK_EQ(2, snapshot.cacheMode);
+  CHECK_EQ(33.5f, snapshot.frameP99Ms);
+  CHECK_EQ(1234567u, snapshot.triangles);
+  CHECK_EQ(std::string("part1"), std::string(snapshot.program));
+  CHECK_EQ(sizeof(snapshot.model) - 1, std::string(snapshot.model).size());
+  CHECK_EQ(2u, reader.GetSequence());
+
+  // Closing the publisher removes the object
+  reader.Close();
+  publisher.Close();
+  CHECK(!reader.Open(name));
+}
+
+// Every field the writer publishes holds the same counter, so a torn read
+// would show up as two different values in one snapshot.
+TEST(SharedMetricsReadsAreConsistent) {
+  std::string name = TestName("seqlock");
+  MetricsPublisher publisher;
+  REQUIRE(publisher.Open(name));
+  MetricsReader reader;
+  REQUIRE(reader.Open(name));
+
+  std::atomic<bool> done{false};
+  std::thread writer([&]() {
+    MetricsSnapshot snapshot{};
+    for (uint64_t i = 1; !done; i++) {
+      snapshot.frameNumber = i;
+      snapshot.triangles = i;
+      snapshot.gpuBytes = i;
+      snapshot.cpuBytes = i;
+      std::fill(snapshot.gpuObjects, snapshot.gpuObjects + 8,
+                static_cast<uint32_t>(i));
+      publisher.Publish(snapshot);
+    }
+  });
+  int reads = 0, torn = 0;
+  uint64_t last = 0;
+  bool monotonic = true;
+  // Time bound rather than a count: on one core the writer may not run
+  // for a while
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (reads < 5000 && std::chrono::steady_clock::now() < deadline) {
+    MetricsSnapshot snapshot;
+    if (!reader.Read(snapshot)) {
+      std::this_thread::yield();
+      continue;
+    }
+    reads++;
+    uint64_t v = snapshot.frameNumber;
+    if (snapshot.triangles != v || snapshot.gpuBytes != v ||
+        snapshot.cpuBytes != v || snapshot.gpuObjects[7] != (uint32_t)v) {
+      torn++;
+    }
+    monotonic = monotonic && v >= last;
+    last = v;
+  }
+  done = true;
+  writer.join();
+  CHECK(reads > 0);
+  CHECK_EQ(0, torn);
+  CHECK(monotonic);
+}
+
+TEST(SharedMetricsCsvColumns) {
+  MetricsSnapshot snapshot{};
+  SetMetricsText(snapshot.program, "a10_fbo");
+  SetMetricsText(snapshot.model, "say \"hi\", terrain");
+  std::ostringstream header, row;
+  WriteMetricsCsvHeader(header);
+  WriteMetricsCsvRow(row, snapshot);
+  // The quoted model contains a comma, so count outside of quotes
+  auto columns = [](const std::string &line) {
+    int count = 1;
+    bool quoted = false;
+    for (char c : line) {
+      if (c == '"') {
+        quoted = !quoted;
+      } else if (c == ',' && !quoted) {
+        count++;
+      }
+    }
+    return count;
+  };
+  CHECK_EQ(columns(header.str()), columns(row.str()));
+  CHECK(row.str().find("\"say \"\"hi\"\", terrain\"") != std::string::npos);
+}
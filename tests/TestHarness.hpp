@@ -0,0 +1,110 @@
+/** @file TestHarness.hpp
+ *  @brief A very small unit test framework (no dependencies).
+ *
+ *  TEST(Name) { ... } registers a test. CHECK(condition) and
+ *  CHECK_EQ(expected, actual) record a failure and keep going; REQUIRE
+ *  stops the current test. RunAllTests() runs everything (or only the tests
+ *  whose name contains argv[1]) and returns the number of failed tests.
+ *
+ *  @bug No known bugs.
+ */
+#ifndef TEST_HARNESS_HPP
+#define TEST_HARNESS_HPP
+
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct TestCase {
+  const char *name;
+  void (*function)();
+};
+
+// Every TEST() in the executable
+inline std::vector<TestCase> &GetTests() {
+  static std::vector<TestCase> tests;
+  return tests;
+}
+
+// Number of failed checks in the test that is running
+inline int &CurrentTestFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+struct TestRegistrar {
+  TestRegistrar(const char *name, void (*function)()) {
+    GetTests().push_back({name, function});
+  }
+};
+
+// Thrown by REQUIRE to leave the current test
+struct TestAbort {};
+
+inline void ReportFailure(const char *file, int line, const std::string &what) {
+  std::cout << "  " << file << ":" << line << ": FAILED " << what << std::endl;
+  CurrentTestFailures()++;
+}
+
+inline int RunAllTests(int argc = 0, char **argv = nullptr) {
+  std::string filter = argc > 1 ? argv[1] : "";
+  int failedTests = 0;
+  int ran = 0;
+  for (const TestCase &test : GetTests()) {
+    if (!filter.empty() &&
+        std::string(test.name).find(filter) == std::string::npos) {
+      continue;
+    }
+    std::cout << "[ RUN  ] " << test.name << std::endl;
+    CurrentTestFailures() = 0;
+    try {
+      test.function();
+    } catch (const TestAbort &) {
+    } catch (const std::exception &e) {
+      ReportFailure(test.name, 0, std::string("exception: ") + e.what());
+    }
+    ran++;
+    if (CurrentTestFailures() > 0) {
+      failedTests++;
+      std::cout << "[ FAIL ] " << test.name << std::endl;
+    } else {
+      std::cout << "[  OK  ] " << test.name << std::endl;
+    }
+  }
+  std::cout << ran - failedTests << "/" << ran << " tests passed" << std::endl;
+  return failedTests;
+}
+
+#define TEST(name)                                                             \
+  static void name();                                                          \
+  static TestRegistrar name##_registrar(#name, name);                          \
+  static void name()
+
+#define CHECK(condition)                                                       \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      ReportFailure(__FILE__, __LINE__, #condition);                           \
+    }                                                                          \
+  } while (0)
+
+#define CHECK_EQ(expected, actual)                                             \
+  do {                                                                         \
+    const auto &expectedValue = (expected);                                    \
+    const auto &actualValue = (actual);                                        \
+    if (!(expectedValue == actualValue)) {                                     \
+      std::cout << "  expected " << expectedValue << ", got " << actualValue   \
+                << std::endl;                                                  \
+      ReportFailure(__FILE__, __LINE__, #expected " == " #actual);             \
+    }                                                                          \
+  } while (0)
+
+#define REQUIRE(condition)                                                     \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      ReportFailure(__FILE__, __LINE__, #condition);                           \
+      throw TestAbort();                                                       \
+    }                                                                          \
+  } while (0)
+
+#endif
@@ -0,0 +1,12 @@
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+
+int main(int argc, char **argv) {
+  int failed = RunAllTests(argc, argv);
+  // Whatever a test left in the tracker leaked, even if the test passed
+  size_t leaks = ResourceTracker::Instance().CheckForLeaks(std::cout);
+  if (leaks > 0) {
+    std::cout << leaks << " resource(s) leaked by the tests" << std::endl;
+  }
+  return failed == 0 && leaks == 0 ? 0 : 1;
+}
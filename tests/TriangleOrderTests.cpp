@@ -0,0 +1,144 @@
+#include "TestHarness.hpp"
+#include "TriangleOrder.hpp"
+#include "VertexCache.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// A w x h quad grid in the xy plane, two triangles per quad, in row order
+struct GridMesh {
+  std::vector<float> positions; // x y z per vertex
+  std::vector<uint32_t> indices;
+  size_t vertexCount;
+
+  GridMesh(int w, int h) : vertexCount(static_cast<size_t>(w + 1) * (h + 1)) {
+    for (int y = 0; y <= h; y++) {
+      for (int x = 0; x <= w; x++) {
+        positions.insert(positions.end(), {float(x), float(y), 0.0f});
+      }
+    }
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        uint32_t v = y * (w + 1) + x;
+        uint32_t quad[6] = {v, v + 1, v + w + 1, v + 1, v + w + 2, v + w + 1};
+        indices.insert(indices.end(), quad, quad + 6);
+      }
+    }
+  }
+
+  PositionView GetPositions() const {
+    return PositionView{positions.data(), 3 * sizeof(float)};
+  }
+  std::vector<uint32_t> Order(TriangleOrder order, uint64_t seed = 1) const {
+    std::vector<uint32_t> out(indices.size());
+    OrderTriangles(order, indices.data(), indices.size(), GetPositions(),
+                   out.data(), seed);
+    return out;
+  }
+  double Acmr(const std::vector<uint32_t> &order) const {
+    VertexCacheModel model{VertexCacheKind::Fifo, 16};
+    return SimulateVertexCache(order.data(), order.size(), vertexCount, model)
+        .GetAcmr();
+  }
+};
+
+// Triangles as written (corners in their order), sorted
+static std::vector<std::vector<uint32_t>>
+Triangles(const std::vector<uint32_t> &indices) {
+  std::vector<std::vector<uint32_t>> triangles;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    triangles.push_back({indices[i], indices[i + 1], indices[i + 2]});
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+
+TEST(EveryOrderKeepsTheTriangles) {
+  GridMesh grid(13, 7);
+  const TriangleOrder orders[] = {TriangleOrder::Random, TriangleOrder::Morton,
+                                  TriangleOrder::Hilbert,
+                                  TriangleOrder::Adversarial};
+  for (TriangleOrder order : orders) {
+    // Same triangles, same winding
+    CHECK(Triangles(grid.indices) == Triangles(grid.Order(order)));
+  }
+}
+
+TEST(RandomOrderDependsOnlyOnTheSeed) {
+  GridMesh grid(16, 16);
+  CHECK(grid.Order(TriangleOrder::Random, 7) ==
+        grid.Order(TriangleOrder::Random, 7));
+  CHECK(grid.Order(TriangleOrder::Random, 7) !=
+        grid.Order(TriangleOrder::Random, 8));
+}
+
+TEST(CurveKeysCoverTheCube) {
+  // An 8 x 8 x 8 corner of the curve: both visit each cell once, and
+  // Hilbert only ever steps to a neighbouring cell
+  std::vector<int> hilbertCell(512, -1);
+  std::vector<bool> mortonSeen(512, false);
+  for (uint32_t x = 0; x < 8; x++) {
+    for (uint32_t y = 0; y < 8; y++) {
+      for (uint32_t z = 0; z < 8; z++) {
+        uint32_t h = HilbertKey(x, y, z);
+        uint32_t m = MortonKey(x, y, z);
+        REQUIRE(h < 512);
+        REQUIRE(m < 512);
+        CHECK_EQ(-1, hilbertCell[h]);
+        CHECK(!mortonSeen[m]);
+        hilbertCell[h] = static_cast<int>(x * 64 + y * 8 + z);
+        mortonSeen[m] = true;
+      }
+    }
+  }
+  for (int key = 1; key < 512; key++) {
+    int a = hilbertCell[key - 1], b = hilbertCell[key];
+    int distance = std::abs(a / 64 - b / 64) + std::abs(a / 8 % 8 - b / 8 % 8) +
+                   std::abs(a % 8 - b % 8);
+    CHECK_EQ(1, distance);
+  }
+  CHECK_EQ(7u, MortonKey(1, 1, 1));
+  CHECK_EQ(0x3fffffffu, MortonKey(1023, 1023, 1023));
+}
+
+TEST(RadixSortIsStable) {
+  std::mt19937 rng(3);
+  for (size_t count : {size_t(0), size_t(1), size_t(1000), size_t(300000)}) {
+    std::vector<uint32_t> keys(count), values(count);
+    for (size_t i = 0; i < count; i++) {
+      // Few distinct keys, so stability matters; some passes are skipped
+      keys[i] = (rng() % 97) << 8;
+      values[i] = static_cast<uint32_t>(i);
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> expected(count);
+    for (size_t i = 0; i < count; i++) {
+      expected[i] = {keys[i], values[i]};
+    }
+    std::stable_sort(
+        expected.begin(), expected.end(),
+        [](const std::pair<uint32_t, uint32_t> &a,
+           const std::pair<uint32_t, uint32_t> &b) { return a.first < b.first; });
+    for (unsigned threads : {1u, 4u}) {
+      std::vector<uint32_t> k = keys, v = values;
+      RadixSortPairs(k, v, threads);
+      bool same = true;
+      for (size_t i = 0; i < count; i++) {
+        same = same && k[i] == expected[i].first && v[i] == expected[i].second;
+      }
+      CHECK(same);
+    }
+  }
+}
+
+TEST(CurveOrdersBeatRandomAndAdversarialDoesNot) {
+  GridMesh grid(64, 64);
+  double random = grid.Acmr(grid.Order(TriangleOrder::Random));
+  double morton = grid.Acmr(grid.Order(TriangleOrder::Morton));
+  double hilbert = grid.Acmr(grid.Order(TriangleOrder::Hilbert));
+  double adversarial = grid.Acmr(grid.Order(TriangleOrder::Adversarial));
+  CHECK(hilbert < 0.5 * random);
+  CHECK(morton < 0.5 * random);
+  CHECK(adversarial >= 0.95 * random);
+}
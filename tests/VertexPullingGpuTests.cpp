@@ -0,0 +1,160 @@
+#include "GLState.hpp"
+#include "GpuTestSupport.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+#include "VertexPulling.hpp"
+
+#include <vector>
+
+// Fetches and decodes like Assignment10_fbo's shaders/vert_pull.glsl; the
+// color is the texture coordinates
+static const char *kVertexShader = R"(#version 330 core
+uniform usamplerBuffer u_PulledVertices;
+uniform usamplerBuffer u_PulledIndices;
+layout(std140) uniform PulledMesh {
+  vec4 positionMin;
+  vec4 positionScale;
+  vec4 texCoordRange;
+  ivec4 offsets;
+};
+out vec2 v_texCoord;
+vec2 Unpack16(uint value) {
+  return vec2(value & 0xFFFFu, value >> 16) / 65535.0;
+}
+void main() {
+  int index = int(texelFetch(u_PulledIndices, gl_VertexID).r) + offsets.x;
+  uvec4 vertex = texelFetch(u_PulledVertices, index);
+  vec3 position = positionMin.xyz + positionScale.xyz *
+                  vec3(Unpack16(vertex.x), Unpack16(vertex.y).x);
+  v_texCoord = texCoordRange.xy + texCoordRange.zw * Unpack16(vertex.w);
+  gl_Position = vec4(position, 1.0);
+}
+)";
+
+static const char *kFragmentShader = R"(#version 330 core
+in vec2 v_texCoord;
+out vec4 color;
+void main() { color = vec4(v_texCoord, 0.0, 1.0); }
+)";
+
+// A rectangle in clip space from x0 to x1 (full height), with the same
+// texture coordinates at every corner
+static PulledMesh AddRectangle(VertexPool &pool, float x0, float x1,
+                               glm::vec2 texCoord) {
+  const float vertices[] = {
+      x0, -1.0f, 0.0f, texCoord.x, texCoord.y,
+      x1, -1.0f, 0.0f, texCoord.x, texCoord.y,
+      x1, 1.0f,  0.0f, texCoord.x, texCoord.y,
+      x0, 1.0f,  0.0f, texCoord.x, texCoord.y};
+  const uint32_t indices[] = {0, 1, 2, 0, 2, 3};
+  VertexStreams streams;
+  streams.data = vertices;
+  streams.vertexCount = 4;
+  streams.stride = 5;
+  streams.texCoord = 3;
+  std::vector<PackedVertex> packed;
+  VertexQuantization quantization = PackVertices(streams, packed);
+  return pool.Add(packed, indices, 6, quantization);
+}
+
+TEST(VertexPoolDrawsMeshesWithOneVertexArray) {
+  GLuint program = CompileTestProgram({kVertexShader, kFragmentShader},
+                                      {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER});
+  REQUIRE(program != 0);
+  VertexPool pool;
+  REQUIRE(pool.Create());
+
+  const int width = 64, height = 64;
+  GLuint fbo = 0, color = 0;
+  glGenFramebuffers(1, &fbo);
+  glGenRenderbuffers(1, &color);
+  glBindRenderbuffer(GL_RENDERBUFFER, color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  GLState &state = GLState::Instance();
+  state.BindFramebuffer(GL_FRAMEBUFFER, fbo);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+                            GL_RENDERBUFFER, color);
+  REQUIRE(glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+  state.Viewport(0, 0, width, height);
+
+  // Red on the left, then enough vertices to make the pool grow (and copy
+  // the left half along), then green on the right
+  PulledMesh left = AddRectangle(pool, -1.0f, 0.0f, glm::vec2(1.0f, 0.0f));
+  REQUIRE(left.IsValid());
+  std::vector<PackedVertex> filler(5000);
+  std::vector<uint32_t> fillerIndices(3, 0);
+  PulledMesh unused = pool.Add(filler, fillerIndices.data(),
+                               fillerIndices.size(), VertexQuantization());
+  CHECK(unused.IsValid());
+  PulledMesh right = AddRectangle(pool, 0.0f, 1.0f, glm::vec2(0.0f, 1.0f));
+  REQUIRE(right.IsValid());
+  CHECK_EQ(int32_t(5004), right.baseVertex);
+  CHECK_EQ(uint32_t(9), right.firstIndex);
+  CHECK_EQ(size_t(5008), pool.GetVertexCount());
+  CHECK_EQ(size_t(15), pool.GetIndexCount());
+
+  state.UseProgram(program);
+  glUniform1i(glGetUniformLocation(program, "u_PulledVertices"),
+              VertexPool::kVertexUnit);
+  glUniform1i(glGetUniformLocation(program, "u_PulledIndices"),
+              VertexPool::kIndexUnit);
+  glUniformBlockBinding(program, glGetUniformBlockIndex(program, "PulledMesh"),
+                        1);
+  GLuint block = 0;
+  glGenBuffers(1, &block);
+  state.ClearColor(0.0f, 0.0f, 1.0f, 1.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  pool.Bind();
+  for (const PulledMesh &mesh : {left, right}) {
+    PulledMeshBlock data = mesh.GetBlock();
+    state.BindBuffer(GL_UNIFORM_BUFFER, block);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(data), &data, GL_STREAM_DRAW);
+    state.BindBufferBase(GL_UNIFORM_BUFFER, 1, block);
+    glDrawArrays(GL_TRIANGLES, mesh.firstIndex, mesh.indexCount);
+  }
+  CHECK_EQ(static_cast<GLenum>(GL_NO_ERROR), glGetError());
+
+  unsigned char pixel[4];
+  glReadPixels(width / 4, height / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+  CHECK(pixel[0] == 255 && pixel[1] == 0 && pixel[2] == 0);
+  glReadPixels(3 * width / 4, height / 2, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+               pixel);
+  CHECK(pixel[0] == 0 && pixel[1] == 255 && pixel[2] == 0);
+
+  glDeleteBuffers(1, &block);
+  glDeleteProgram(program);
+  state.BindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &fbo);
+  glDeleteRenderbuffers(1, &color);
+  state.Invalidate();
+}
+
+TEST(VertexPoolRejectsWhatItCannotHold) {
+  VertexPool pool;
+  std::vector<PackedVertex> vertices(3);
+  const uint32_t indices[] = {0, 1, 2};
+  // Not created yet
+  CHECK(!pool.Add(vertices, indices, 3, VertexQuantization()).IsValid());
+  CHECK(!pool.GetError().empty());
+  REQUIRE(pool.Create());
+  CHECK(!pool.Add(vertices, indices, 0, VertexQuantization()).IsValid());
+  CHECK(pool.Add(vertices, indices, 3, VertexQuantization()).IsValid());
+}
+
+TEST(VertexPoolReleasesItsBuffers) {
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  tracker.Reset();
+  VertexPool pool;
+  REQUIRE(pool.Create());
+  std::vector<PackedVertex> vertices(3);
+  const uint32_t indices[] = {0, 1, 2};
+  REQUIRE(pool.Add(vertices, indices, 3, VertexQuantization()).IsValid());
+  CHECK_EQ(1u, tracker.GetGpuCount(GpuResourceKind::VertexArray));
+  CHECK_EQ(2u, tracker.GetGpuCount(GpuResourceKind::Buffer));
+  CHECK_EQ(2u, tracker.GetGpuCount(GpuResourceKind::Texture));
+  pool.Release();
+  CHECK(!pool.IsCreated());
+  CHECK_EQ(0u, tracker.GetGpuCount(GpuResourceKind::VertexArray));
+  CHECK_EQ(0u, tracker.GetGpuCount(GpuResourceKind::Buffer));
+  CHECK_EQ(0u, tracker.GetGpuCount(GpuResourceKind::Texture));
+}
@@ -0,0 +1,94 @@
+#include "TestHarness.hpp"
+#include "VertexPulling.hpp"
+
+#include <vector>
+
+static bool Near(const glm::vec3 &a, const glm::vec3 &b, float epsilon) {
+  return glm::length(a - b) <= epsilon;
+}
+
+// x, y, z, normal, s, t like Assignment10_fbo's Geometry (without tangents)
+static const float kVertices[] = {
+    -4.0f, 0.0f, 2.0f,  0.0f,  1.0f, 0.0f, 0.0f,  0.0f,
+    12.0f, 3.0f, -6.0f, 0.6f,  0.8f, 0.0f, 1.0f,  0.25f,
+    1.5f,  7.5f, 0.5f,  -0.3f, 0.1f, 0.9f, 0.75f, 1.0f};
+
+static VertexStreams Streams() {
+  VertexStreams streams;
+  streams.data = kVertices;
+  streams.vertexCount = 3;
+  streams.stride = 8;
+  streams.position = 0;
+  streams.normal = 3;
+  streams.texCoord = 6;
+  return streams;
+}
+
+TEST(PackedVerticesRoundTrip) {
+  std::vector<PackedVertex> packed;
+  VertexQuantization quantization = PackVertices(Streams(), packed);
+  REQUIRE(packed.size() == 3);
+  CHECK(Near(glm::vec3(-4.0f, 0.0f, -6.0f), quantization.positionMin, 0.0f));
+  CHECK(Near(glm::vec3(16.0f, 7.5f, 8.0f), quantization.positionScale, 0.0f));
+  for (size_t i = 0; i < packed.size(); i++) {
+    const float *vertex = kVertices + i * 8;
+    // Half a step of 16 bits over the bounds
+    glm::vec3 position(vertex[0], vertex[1], vertex[2]);
+    CHECK(Near(position, UnpackPosition(packed[i], quantization),
+               16.0f / 65535.0f));
+    glm::vec3 normal =
+        glm::normalize(glm::vec3(vertex[3], vertex[4], vertex[5]));
+    CHECK(Near(normal, UnpackNormal(packed[i]), 1e-3f));
+    glm::vec2 texCoord(vertex[6], vertex[7]);
+    glm::vec2 unpacked = UnpackTexCoord(packed[i], quantization);
+    CHECK(glm::length(texCoord - unpacked) <= 1.0f / 65535.0f);
+  }
+  // The corners of the bounds are exact
+  CHECK_EQ(0u, packed[0].positionXY & 0xFFFFu);
+  CHECK_EQ(0xFFFFu, packed[1].positionXY & 0xFFFFu);
+}
+
+TEST(PackedVerticesHandleMissingAttributes) {
+  VertexStreams streams = Streams();
+  streams.normal = -1;
+  streams.texCoord = -1;
+  std::vector<PackedVertex> packed;
+  VertexQuantization quantization = PackVertices(streams, packed);
+  REQUIRE(packed.size() == 3);
+  for (const PackedVertex &vertex : packed) {
+    CHECK(Near(glm::vec3(0.0f, 1.0f, 0.0f), UnpackNormal(vertex), 1e-4f));
+    CHECK_EQ(0u, vertex.texCoord);
+  }
+  CHECK(glm::length(quantization.texCoordScale) == 0.0f);
+
+  // Nothing to pack
+  streams.vertexCount = 0;
+  PackVertices(streams, packed);
+  CHECK(packed.empty());
+}
+
+TEST(PackedVerticesKeepFlatAxes) {
+  // A flat quad: y has no extent, and a zero normal becomes up
+  const float flat[] = {0.0f, 2.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+                        1.0f, 2.0f, 1.0f, 0.0f, 0.0f, 0.0f};
+  VertexStreams streams;
+  streams.data = flat;
+  streams.vertexCount = 2;
+  streams.stride = 6;
+  streams.normal = 3;
+  std::vector<PackedVertex> packed;
+  VertexQuantization quantization = PackVertices(streams, packed);
+  CHECK(quantization.positionScale.y == 0.0f);
+  CHECK(Near(glm::vec3(1.0f, 2.0f, 1.0f),
+             UnpackPosition(packed[1], quantization), 1e-6f));
+  CHECK(Near(glm::vec3(0.0f, 1.0f, 0.0f), UnpackNormal(packed[0]), 1e-4f));
+
+  PulledMesh mesh;
+  CHECK(!mesh.IsValid());
+  mesh.indexCount = 6;
+  mesh.baseVertex = 40;
+  mesh.quantization = quantization;
+  PulledMeshBlock block = mesh.GetBlock();
+  CHECK_EQ(40, block.offsets.x);
+  CHECK(block.positionMin.y == 2.0f);
+}
@@ -0,0 +1,137 @@
+#include "GLState.hpp"
+#include "GpuTestSupport.hpp"
+#include "ResourceTracker.hpp"
+#include "TestHarness.hpp"
+#include "VirtualTexture.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// A triangle over the whole viewport that sees page (1, 0) of level 1
+static const char *kVertexSource = R"(#version 330 core
+void main() {
+  vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+static const char *kFragmentSource = R"(#version 330 core
+out vec4 color;
+void main() {
+  color = vec4(1.0, 0.0, 1.0, 255.0) / 255.0;
+}
+)";
+
+// 32 x 32 texels in pages of 8 with a border of 2: levels of 4, 2 and 1
+// pages along each side
+static std::string WritePageFile() {
+  std::string path =
+      (fs::temp_directory_path() /
+       ("cs5310_vt_gpu_" +
+        std::to_string(
+            std::chrono::steady_clock::now().time_since_epoch().count()) +
+        ".vtex"))
+          .string();
+  std::vector<uint8_t> pixels(32 * 32 * 3);
+  for (size_t i = 0; i < pixels.size(); i++) {
+    pixels[i] = static_cast<uint8_t>(i * 7);
+  }
+  return WriteVirtualTexture(path, pixels.data(), 32, 8, 2) ? path : "";
+}
+
+static PageId Page(uint32_t x, uint32_t y, uint32_t level) {
+  PageId page;
+  page.x = x;
+  page.y = y;
+  page.level = level;
+  return page;
+}
+
+TEST(VirtualTextureUploadsThePagesAskedFor) {
+  std::string path = WritePageFile();
+  REQUIRE(!path.empty());
+  ResourceTracker &tracker = ResourceTracker::Instance();
+  size_t textures = tracker.GetGpuCount(GpuResourceKind::Texture);
+  {
+    VirtualTexture texture;
+    std::string error;
+    CHECK(!texture.Create(path + ".missing", 2, &error));
+    CHECK(!error.empty());
+    // 4 slots, the top page in the first one
+    REQUIRE(texture.Create(path, 2));
+    CHECK_EQ(textures + 2, tracker.GetGpuCount(GpuResourceKind::Texture));
+    VirtualTextureStats stats = texture.GetStats();
+    CHECK_EQ(size_t(1), stats.resident);
+    CHECK_EQ(size_t(4), stats.slots);
+
+    texture.Request({Page(0, 0, 2), Page(1, 0, 1), Page(3, 2, 0)});
+    CHECK_EQ(size_t(2), texture.GetStats().missing);
+    bool changed = false;
+    for (int wait = 0; wait < 2000 && texture.IsStreaming(); wait++) {
+      changed = texture.Update() || changed;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    changed = texture.Update() || changed;
+    CHECK(changed);
+    stats = texture.GetStats();
+    CHECK_EQ(size_t(3), stats.resident);
+    CHECK_EQ(uint64_t(2), stats.uploaded);
+
+    // (3, 2, 0) points at the slot it got, (0, 0, 0) at the top page
+    std::vector<uint8_t> table(4 * 4 * 4);
+    GLState::Instance().BindTexture(0, GL_TEXTURE_2D, texture.GetPageTable());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, table.data());
+    const uint8_t *entry = table.data() + (2 * 4 + 3) * 4;
+    CHECK_EQ(0, int(entry[2]));
+    CHECK(entry[0] != 0 || entry[1] != 0);
+    entry = table.data();
+    CHECK(entry[0] == 0 && entry[1] == 0 && entry[2] == 2);
+    CHECK(!texture.Update());
+  }
+  CHECK_EQ(textures, tracker.GetGpuCount(GpuResourceKind::Texture));
+  std::error_code code;
+  fs::remove(path, code);
+}
+
+TEST(FeedbackReadsBackThePagesDrawn) {
+  GLState &state = GLState::Instance();
+  GLuint program = CompileTestProgram({kVertexSource, kFragmentSource},
+                                      {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER});
+  REQUIRE(program != 0);
+  GLuint vao = 0;
+  glGenVertexArrays(1, &vao);
+
+  VirtualTextureHeader header{};
+  header.size = 32;
+  header.pageSize = 8;
+  header.levels = 3;
+  VirtualTextureFeedback feedback;
+  REQUIRE(feedback.Create(64, 64, 4));
+  CHECK_EQ(4, feedback.GetScale());
+  std::vector<PageId> pages;
+  CHECK(!feedback.Poll(header, pages));
+
+  feedback.Begin();
+  state.Disable(GL_DEPTH_TEST);
+  state.UseProgram(program);
+  state.BindVertexArray(vao);
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  feedback.End();
+  CHECK(feedback.IsPending());
+  glFinish();
+  REQUIRE(feedback.Poll(header, pages));
+  CHECK(!feedback.IsPending());
+  REQUIRE(pages.size() == 2u);
+  CHECK(pages[0] == Page(0, 0, 2));
+  CHECK(pages[1] == Page(1, 0, 1));
+
+  state.BindFramebuffer(GL_FRAMEBUFFER, 0);
+  state.BindVertexArray(0);
+  state.UseProgram(0);
+  glDeleteVertexArrays(1, &vao);
+  glDeleteProgram(program);
+}
@@ -0,0 +1,243 @@
+#include "TestHarness.hpp"
+#include "VirtualTexture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// A page file removed again when the test ends: 32 x 32 texels in pages
+// of 8 with a border of 2, so levels of 4, 2 and 1 pages along each side
+struct TestPageFile {
+  std::string path;
+  std::vector<uint8_t> pixels;
+
+  TestPageFile() {
+    path = (fs::temp_directory_path() /
+            ("cs5310_vt_" +
+             std::to_string(std::chrono::steady_clock::now()
+                                .time_since_epoch()
+                                .count()) +
+             ".vtex"))
+               .string();
+    pixels.resize(32 * 32 * 3);
+    for (uint32_t y = 0; y < 32; y++) {
+      for (uint32_t x = 0; x < 32; x++) {
+        uint8_t *texel = pixels.data() + (y * 32 + x) * 3;
+        texel[0] = static_cast<uint8_t>(x * 8);
+        texel[1] = static_cast<uint8_t>(y * 8);
+        texel[2] = static_cast<uint8_t>((x + y) % 2 ? 200 : 100);
+      }
+    }
+  }
+  ~TestPageFile() {
+    std::error_code code;
+    fs::remove(path, code);
+  }
+  bool Write() const {
+    return WriteVirtualTexture(path, pixels.data(), 32, 8, 2);
+  }
+};
+
+static PageId Page(uint32_t x, uint32_t y, uint32_t level) {
+  PageId page;
+  page.x = x;
+  page.y = y;
+  page.level = level;
+  return page;
+}
+
+// Texel (i, j) of a page with a 12 texel side
+static const uint8_t *PageTexel(const std::vector<uint8_t> &page, int i,
+                                int j) {
+  return page.data() + (j * 12 + i) * 3;
+}
+
+TEST(PageFilesHoldEveryLevelWithBorders) {
+  TestPageFile file;
+  REQUIRE(file.Write());
+  VirtualTextureFile reader;
+  REQUIRE(reader.Open(file.path));
+  const VirtualTextureHeader &header = reader.GetHeader();
+  CHECK_EQ(3u, header.levels);
+  CHECK_EQ(16u + 4u + 1u, header.pageCount);
+  CHECK_EQ(size_t(12 * 12 * 3), PageBytes(header));
+  CHECK_EQ(0u, PageIndex(header, Page(0, 0, 0)));
+  CHECK_EQ(16u + 3u, PageIndex(header, Page(1, 1, 1)));
+  CHECK_EQ(20u, PageIndex(header, Page(0, 0, 2)));
+
+  // Page (1, 2) starts at texel (8, 16); the border reaches 2 texels
+  // into its neighbours
+  std::vector<uint8_t> page(PageBytes(header));
+  REQUIRE(reader.ReadPage(Page(1, 2, 0), page.data()));
+  CHECK_EQ(8 * 8, int(PageTexel(page, 2, 2)[0]));
+  CHECK_EQ(16 * 8, int(PageTexel(page, 2, 2)[1]));
+  CHECK_EQ(6 * 8, int(PageTexel(page, 0, 0)[0]));
+  CHECK_EQ(14 * 8, int(PageTexel(page, 0, 0)[1]));
+  CHECK_EQ(17 * 8, int(PageTexel(page, 11, 11)[0]));
+  // Clamped at the edges of the texture
+  REQUIRE(reader.ReadPage(Page(0, 0, 0), page.data()));
+  CHECK_EQ(0, int(PageTexel(page, 0, 0)[0]));
+  CHECK_EQ(0, int(PageTexel(page, 1, 1)[1]));
+
+  // Level 1 texels are the means of 2 x 2 texels of level 0
+  REQUIRE(reader.ReadPage(Page(0, 0, 1), page.data()));
+  CHECK_EQ(4, int(PageTexel(page, 2, 2)[0]));
+  CHECK_EQ(150, int(PageTexel(page, 2, 2)[2]));
+  CHECK(!reader.ReadPage(Page(2, 0, 1), page.data()));
+}
+
+TEST(BrokenPageFilesAreRefused) {
+  TestPageFile file;
+  std::string error;
+  CHECK(
+      !WriteVirtualTexture(file.path, file.pixels.data(), 24, 8, 2, &error));
+  CHECK(!error.empty());
+  CHECK(!WriteVirtualTexture(file.path, file.pixels.data(), 32, 8, 9));
+
+  REQUIRE(file.Write());
+  fs::resize_file(file.path, fs::file_size(file.path) - 1);
+  VirtualTextureFile reader;
+  CHECK(!reader.Open(file.path, &error));
+  CHECK(!reader.IsOpen());
+  std::ofstream(file.path, std::ios::binary) << "CS5310AR and more bytes";
+  CHECK(!reader.Open(file.path));
+}
+
+TEST(FeedbackAsksForEachPageOnceWithItsAncestors) {
+  VirtualTextureHeader header{};
+  header.size = 32;
+  header.pageSize = 8;
+  header.levels = 3;
+  const uint8_t pixels[][4] = {
+      {3, 1, 0, 255}, {3, 1, 0, 255}, {0, 0, 0, 0},   // Nothing seen
+      {0, 0, 1, 255}, {3, 1, 0, 255}, {4, 0, 0, 255}, // Outside level 0
+      {0, 0, 3, 255},                                 // No such level
+  };
+  std::vector<PageId> pages;
+  CollectFeedbackPages(&pixels[0][0], 7, header, pages);
+  REQUIRE(pages.size() == 4u);
+  CHECK(pages[0] == Page(0, 0, 2));
+  CHECK(pages[1] == Page(1, 0, 1));
+  CHECK(pages[2] == Page(0, 0, 1));
+  CHECK(pages[3] == Page(3, 1, 0));
+}
+
+TEST(PageCacheEvictsThePageSeenLongestAgo) {
+  // 4 slots for levels of 4, 2 and 1 pages
+  VirtualPageCache cache;
+  cache.Reset(4, 3, 2);
+  uint32_t slot = 0;
+  REQUIRE(cache.Insert(Page(0, 0, 2), slot));
+  CHECK_EQ(0u, slot);
+
+  std::vector<PageId> missing;
+  cache.Touch({Page(0, 0, 2), Page(1, 0, 1), Page(0, 0, 1)}, missing);
+  REQUIRE(missing.size() == 2u);
+  CHECK(cache.Insert(Page(1, 0, 1), slot));
+  CHECK(cache.Insert(Page(0, 0, 1), slot));
+  CHECK(cache.Insert(Page(3, 1, 0), slot));
+  CHECK_EQ(3u, slot);
+  // Every slot was seen this frame
+  CHECK(!cache.Insert(Page(2, 1, 0), slot));
+
+  // Next frame only (0, 0, 1) is seen again, so (1, 0, 1) and (3, 1, 0)
+  // can go. The top page never goes.
+  missing.clear();
+  cache.Touch({Page(0, 0, 1)}, missing);
+  CHECK(missing.empty());
+  PageId evicted;
+  CHECK(cache.Insert(Page(2, 1, 0), slot, &evicted));
+  CHECK(evicted == Page(1, 0, 1));
+  CHECK_EQ(1u, slot);
+  CHECK(cache.Insert(Page(0, 1, 0), slot, &evicted));
+  CHECK(evicted == Page(3, 1, 0));
+  CHECK(!cache.Insert(Page(1, 1, 0), slot));
+  CHECK_EQ(0, cache.FindSlot(Page(0, 0, 2)));
+  CHECK_EQ(-1, cache.FindSlot(Page(1, 0, 1)));
+  CHECK_EQ(size_t(4), cache.GetResidentCount());
+  CHECK(cache.TakeChanged());
+  CHECK(!cache.TakeChanged());
+}
+
+TEST(PageTablePointsAtTheNearestResidentPage) {
+  VirtualPageCache cache;
+  cache.Reset(4, 3, 2);
+  uint32_t slot = 0;
+  REQUIRE(cache.Insert(Page(0, 0, 2), slot)); // Slot 0
+  REQUIRE(cache.Insert(Page(1, 1, 1), slot)); // Slot 1
+  REQUIRE(cache.Insert(Page(2, 3, 0), slot)); // Slot 2: (0, 1)
+
+  const std::vector<uint8_t> &top = cache.GetTable(2);
+  CHECK(top.size() == 4u && top[0] == 0 && top[1] == 0 && top[2] == 2 &&
+        top[3] == 255);
+  const std::vector<uint8_t> &level1 = cache.GetTable(1);
+  const uint8_t *entry = level1.data() + (1 * 2 + 1) * 4;
+  CHECK(entry[0] == 1 && entry[1] == 0 && entry[2] == 1);
+  entry = level1.data() + 0;
+  CHECK(entry[0] == 0 && entry[1] == 0 && entry[2] == 2);
+  const std::vector<uint8_t> &level0 = cache.GetTable(0);
+  // Resident itself
+  entry = level0.data() + (3 * 4 + 2) * 4;
+  CHECK(entry[0] == 0 && entry[1] == 1 && entry[2] == 0);
+  // Its neighbour falls back to their parent (1, 1, 1)
+  entry = level0.data() + (3 * 4 + 3) * 4;
+  CHECK(entry[0] == 1 && entry[1] == 0 && entry[2] == 1);
+  // And the other quarters to the top page
+  entry = level0.data() + (0 * 4 + 3) * 4;
+  CHECK(entry[0] == 0 && entry[1] == 0 && entry[2] == 2);
+}
+
+TEST(StreamerReadsThePagesAskedFor) {
+  TestPageFile file;
+  REQUIRE(file.Write());
+  PageStreamer streamer;
+  REQUIRE(streamer.Start(file.path));
+  streamer.SetRequests({Page(0, 0, 2), Page(1, 0, 1), Page(3, 3, 0)});
+  std::vector<LoadedPage> loaded;
+  for (int wait = 0; wait < 2000 && loaded.size() < 3; wait++) {
+    streamer.TakeLoaded(loaded);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  REQUIRE(loaded.size() == 3u);
+  // Most wanted first
+  CHECK(loaded[0].page == Page(0, 0, 2));
+  CHECK(loaded[2].page == Page(3, 3, 0));
+  CHECK_EQ(size_t(0), streamer.GetPending());
+  CHECK_EQ(uint64_t(3 * 12 * 12 * 3), streamer.GetBytesRead());
+
+  VirtualTextureFile reader;
+  REQUIRE(reader.Open(file.path));
+  std::vector<uint8_t> page(PageBytes(reader.GetHeader()));
+  REQUIRE(reader.ReadPage(Page(3, 3, 0), page.data()));
+  CHECK(loaded[2].pixels == page);
+
+  streamer.Stop();
+  CHECK(!streamer.Start(file.path + ".missing"));
+}
+
+TEST(DetailKeepsTheColorsBrightness) {
+  // A flat color and a detail map of 40 and 120: the detail averages to 1
+  const uint8_t color[] = {100, 50, 200, 100, 50, 200};
+  const uint8_t detail[] = {40, 40, 40, 120, 120, 120};
+  std::vector<uint8_t> out;
+  ComposeDetailTexture(color, 2, 1, detail, 2, 1, 2, 8, out);
+  REQUIRE(out.size() == 8u * 8u * 3u);
+  double sum = 0.0;
+  int lowest = 255, highest = 0;
+  for (size_t i = 0; i < out.size(); i += 3) {
+    sum += out[i];
+    lowest = std::min(lowest, int(out[i]));
+    highest = std::max(highest, int(out[i]));
+  }
+  CHECK(std::abs(sum / 64.0 - 100.0) < 2.0);
+  // Blended in by half: 0.5 + 0.5 * 40 / 80 and 0.5 + 0.5 * 120 / 80
+  CHECK(lowest >= 75 && highest <= 125);
+  CHECK(highest - lowest > 20);
+}
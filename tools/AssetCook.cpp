@@ -0,0 +1,100 @@
+// Cooks the models and textures into one archive the programs map instead
+// of reading the loose files (see common/engine/include/AssetArchive.hpp).
+//
+//   asset_cook                         cook the defaults into
+//                                      common/assets.pak
+//   asset_cook -o out.pak common/objects
+//   asset_cook --list common/assets.pak
+//
+// Options:
+//   -o PATH        archive to write (default: common/assets.pak)
+//   --root DIR     directory the keys are relative to (default: the
+//                  repository); the directories given are relative to it
+//   --list PATH    print an archive's table of contents and exit
+#include "AssetArchive.hpp"
+#include "AssetCooker.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Everything the two programs load
+static const char *kDefaultDirectories[] = {
+    "common/objects", "common/textures", "Assignment10_fbo/part1/assets"};
+
+static void Usage() {
+  std::cerr << "usage: asset_cook [-o PATH] [--root DIR] [directory ...]\n"
+               "       asset_cook --list PATH\n";
+}
+
+static int List(const std::string &path) {
+  AssetArchive archive;
+  if (!archive.Mount(path, "")) {
+    std::cerr << "asset_cook: " << archive.GetError() << "\n";
+    return 1;
+  }
+  std::cout << path << ": " << archive.GetEntryCount() << " entries in "
+            << archive.GetSlotCount() << " slots, " << archive.GetSize()
+            << " bytes\n";
+  std::string key;
+  AssetView view;
+  for (uint32_t slot = 0; slot < archive.GetSlotCount(); slot++) {
+    if (!archive.GetEntry(slot, key, view)) {
+      continue;
+    }
+    std::cout << std::setw(8) << AssetKindName(view.kind) << std::setw(12)
+              << view.size << "  " << key;
+    if (view.kind == AssetKind::Texture) {
+      std::cout << " (" << view.width << "x" << view.height << ")";
+    }
+    std::cout << "\n";
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  std::string root = ENGINE_SOURCE_DIR;
+  std::string output;
+  std::vector<std::string> directories;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+      output = argv[++i];
+    } else if (std::strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+      root = argv[++i];
+    } else if (std::strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+      return List(argv[i + 1]);
+    } else if (argv[i][0] != '-') {
+      directories.push_back(argv[i]);
+    } else {
+      Usage();
+      return 2;
+    }
+  }
+  if (output.empty()) {
+    output = root + "/common/assets.pak";
+  }
+  if (directories.empty()) {
+    directories.assign(std::begin(kDefaultDirectories),
+                       std::end(kDefaultDirectories));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  CookStats stats;
+  std::string error;
+  if (!CookAssets(root, directories, output, stats, &std::cerr, &error)) {
+    std::cerr << "asset_cook: " << error << "\n";
+    return 1;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << std::fixed << std::setprecision(1) << output << ": "
+            << stats.meshes << " meshes, " << stats.textures << " textures, "
+            << stats.raw << " material files (" << stats.skipped
+            << " skipped); " << stats.inputBytes / 1048576.0 << " MiB in, "
+            << stats.outputBytes / 1048576.0 << " MiB out, "
+            << elapsed.count() << " s\n";
+  return 0;
+}
@@ -0,0 +1,142 @@
+// Tunes Forsyth's score function for vertex caches (see
+// common/engine/include/ForsythTuner.hpp) and prints the presets as the
+// table in common/engine/src/ForsythTuner.cpp.
+//
+//   forsyth_tune                          every default target, default corpus
+//   forsyth_tune --target fifo16 a.obj b.obj
+//
+// Options:
+//   --target NAME    cache to tune for (fifo16, lru32, ...); repeatable
+//   --grid N         values per parameter in the coarse grid (default 3)
+//   --starts N       grid points the local search starts from (default 3)
+//   --rounds N       refinement rounds (default 6)
+//   --threads N      worker threads (default: all cores)
+#include "ForsythTuner.hpp"
+#include "Parallel.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// The welded meshes in common/objects (duplicates and tiny ones left out)
+static const char *kDefaultCorpus[] = {
+    "common/objects/bunny_centered.obj",
+    "common/objects/monkey_centered.obj",
+    "common/objects/capsule/capsule.obj",
+    "common/objects/chapel/chapel_obj.obj",
+    "common/objects/Chalice/Stone_Chalic_OBJ.obj",
+    "common/objects/house/house_obj.obj",
+    "common/objects/lion/lion_centered_triangulated.obj",
+    "common/objects/tree/HandpaintedTree.obj",
+    "common/objects/windmill/windmill.obj"};
+
+// Common post-transform cache sizes
+static const char *kDefaultTargets[] = {"fifo16", "fifo32", "lru16", "lru32"};
+
+// A float as C++ source: 4 -> "4.0f", 0.125 -> "0.125f"
+static std::string FloatLiteral(float value) {
+  std::ostringstream text;
+  text << std::setprecision(3) << value;
+  std::string literal = text.str();
+  if (literal.find_first_of(".e") == std::string::npos) {
+    literal += ".0";
+  }
+  return literal + "f";
+}
+
+static void Usage() {
+  std::cerr << "usage: forsyth_tune [--target NAME]... [--grid N] "
+               "[--starts N] [--rounds N] [--threads N] [model.obj ...]\n";
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::string> targets;
+  std::vector<std::string> paths;
+  ForsythTuneOptions options;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--target") == 0 && i + 1 < argc) {
+      targets.push_back(argv[++i]);
+    } else if (std::strcmp(argv[i], "--grid") == 0 && i + 1 < argc) {
+      options.gridSteps = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--starts") == 0 && i + 1 < argc) {
+      options.starts = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+      options.refineRounds = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+      options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+    } else if (argv[i][0] != '-') {
+      paths.push_back(argv[i]);
+    } else {
+      Usage();
+      return 2;
+    }
+  }
+  if (targets.empty()) {
+    targets.assign(std::begin(kDefaultTargets), std::end(kDefaultTargets));
+  }
+  if (paths.empty()) {
+    for (const char *path : kDefaultCorpus) {
+      paths.push_back(std::string(ENGINE_SOURCE_DIR) + "/" + path);
+    }
+  }
+
+  std::vector<TuneMesh> corpus;
+  size_t triangles = 0;
+  for (const std::string &path : paths) {
+    TuneMesh mesh;
+    std::string error;
+    if (!LoadTuneMesh(path, mesh, &error)) {
+      std::cerr << "forsyth_tune: " << path << ": " << error << "\n";
+      return 1;
+    }
+    triangles += mesh.indices.size() / 3;
+    corpus.push_back(std::move(mesh));
+  }
+  std::cout << "Corpus: " << corpus.size() << " meshes, " << triangles
+            << " triangles; "
+            << (options.threads != 0 ? options.threads : GetWorkerCount())
+            << " threads\n\n";
+
+  std::vector<std::string> presets;
+  std::cout << std::fixed << std::setprecision(4);
+  for (const std::string &name : targets) {
+    VertexCacheModel target;
+    if (!ParseVertexCacheModel(name, target)) {
+      std::cerr << "forsyth_tune: unknown target " << name << "\n";
+      return 2;
+    }
+    auto start = std::chrono::steady_clock::now();
+    ForsythTuneResult result = TuneForsyth(corpus, target, options);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    const ForsythParams &p = result.params;
+    std::cout << name << ": ACMR " << result.acmr << " (defaults "
+              << result.defaultAcmr << ", file order "
+              << EvaluateUnoptimized(corpus, target) << "), "
+              << 100.0 * (result.defaultAcmr - result.acmr) /
+                     result.defaultAcmr
+              << "% better, " << result.evaluations << " evaluations in "
+              << std::setprecision(1) << elapsed.count() << " s\n"
+              << std::setprecision(4);
+
+    std::ostringstream line;
+    line << "    {\"" << name << "\", {" << p.cacheSize << ", "
+         << FloatLiteral(p.cacheDecayPower) << ", "
+         << FloatLiteral(p.lastTriScore) << ", "
+         << FloatLiteral(p.valenceBoostScale) << ", "
+         << FloatLiteral(p.valenceBoostPower) << "}},";
+    presets.push_back(line.str());
+  }
+
+  std::cout << "\nPresets (common/engine/src/ForsythTuner.cpp):\n"
+            << "    {\"default\", {24, 1.5f, 0.75f, 2.0f, 0.5f}},\n";
+  for (const std::string &line : presets) {
+    std::cout << line << "\n";
+  }
+  return 0;
+}
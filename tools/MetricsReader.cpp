@@ -0,0 +1,109 @@
+// Prints (or logs to CSV) the metrics a running program publishes in shared
+// memory (see common/engine/include/SharedMetrics.hpp). The block is only
+// mapped read only and never locked, so reading does not slow the program
+// down.
+//
+//   metrics_reader                      print /cs5310_part1 once a second
+//   metrics_reader /cs5310_a10 --once   print one snapshot and exit
+//   metrics_reader --csv log.csv --interval 100 --count 600
+//
+// Options:
+//   --once           print one snapshot and exit
+//   --csv FILE       append CSV rows to FILE ("-" for stdout) instead of
+//                    printing
+//   --interval MS    time between reads (default 1000)
+//   --count N        stop after N reads (default: until the program exits)
+#include "SharedMetrics.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+static void Usage() {
+  std::cerr << "usage: metrics_reader [name] [--once] [--csv FILE] "
+               "[--interval MS] [--count N]\n";
+}
+
+int main(int argc, char **argv) {
+  std::string name = MetricsName("part1");
+  std::string csvPath;
+  long intervalMs = 1000;
+  long count = -1;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--once") == 0) {
+      count = 1;
+    } else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+      csvPath = argv[++i];
+    } else if (std::strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+      intervalMs = std::atol(argv[++i]);
+    } else if (std::strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+      count = std::atol(argv[++i]);
+    } else if (argv[i][0] == '/') {
+      name = argv[i];
+    } else {
+      Usage();
+      return 2;
+    }
+  }
+
+  MetricsReader reader;
+  if (!reader.Open(name)) {
+    std::cerr << "metrics_reader: " << reader.GetError()
+              << " (is the program running?)\n";
+    return 1;
+  }
+
+  std::ofstream csvFile;
+  std::ostream *csv = nullptr;
+  if (csvPath == "-") {
+    csv = &std::cout;
+  } else if (!csvPath.empty()) {
+    csvFile.open(csvPath, std::ios::app);
+    if (!csvFile.is_open()) {
+      std::cerr << "metrics_reader: cannot write " << csvPath << "\n";
+      return 1;
+    }
+    csv = &csvFile;
+  }
+  // Appending to an existing log: it already has a header
+  if (csv != nullptr && (csv == &std::cout || csvFile.tellp() == 0)) {
+    WriteMetricsCsvHeader(*csv);
+  }
+
+  uint64_t lastSequence = 0;
+  int idleReads = 0;
+  long reads = 0;
+  for (bool first = true; count < 0 || reads < count; first = false) {
+    if (!first) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+    // A program that stopped publishing (exited or hangs) ends the log
+    uint64_t sequence = reader.GetSequence();
+    if (sequence == lastSequence) {
+      if (++idleReads >= 5) {
+        std::cerr << "metrics_reader: nothing new published, stopping\n";
+        return reads > 0 ? 0 : 1;
+      }
+    } else {
+      idleReads = 0;
+    }
+    lastSequence = sequence;
+
+    MetricsSnapshot snapshot;
+    if (!reader.Read(snapshot)) {
+      continue;
+    }
+    reads++;
+    if (csv != nullptr) {
+      WriteMetricsCsvRow(*csv, snapshot);
+      csv->flush();
+    } else {
+      PrintMetrics(std::cout, snapshot);
+      std::cout << std::endl;
+    }
+  }
+  return 0;
+}
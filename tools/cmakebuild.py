@@ -0,0 +1,44 @@
+# Helper used by the build.py scripts: builds one program with the top level
+# CMakeLists.txt and copies the executable next to build.py, so it can be
+# started the same way as before (./project or ./prog).
+#
+# Arguments understood (in any order):
+#   debug | release | relwithdebinfo   build type (default: release)
+#   native                             -march=native
+#   lto                                link time optimization
+#   direct                             skip CMake, use the plain g++ command
+import os
+import shutil
+import subprocess
+import sys
+
+BUILD_TYPES={"debug":"Debug","release":"Release","relwithdebinfo":"RelWithDebInfo"}
+ROOT=os.path.abspath(os.path.join(os.path.dirname(__file__),".."))
+
+def WantsCMake(args):
+    return "direct" not in args and shutil.which("cmake") is not None
+
+def Build(target,outputDir,executable,args):
+    buildType="Release"
+    for arg in args:
+        if arg.lower() in BUILD_TYPES:
+            buildType=BUILD_TYPES[arg.lower()]
+    # One build directory per configuration, so switching is cheap
+    buildDir=os.path.join(ROOT,"build",buildType.lower()+("-native" if "native" in args else "")+("-lto" if "lto" in args else ""))
+    configure=["cmake","-S",ROOT,"-B",buildDir,
+               "-DCMAKE_BUILD_TYPE="+buildType,
+               "-DENGINE_NATIVE_ARCH="+("ON" if "native" in args else "OFF"),
+               "-DENGINE_LTO="+("ON" if "lto" in args else "OFF")]
+    build=["cmake","--build",buildDir,"--target",target,"-j",str(os.cpu_count() or 1)]
+    for command in (configure,build):
+        print(" ".join(command))
+        if subprocess.call(command)!=0:
+            return False
+    # Copy the program next to build.py (shaders etc. are loaded from there)
+    built=os.path.join(buildDir,outputDir,executable)
+    if not os.path.exists(built):
+        print("CMake did not produce "+built+" (is SDL2 installed?)")
+        return False
+    shutil.copy2(built,executable)
+    print("Built "+buildType+" version of ./"+executable)
+    return True
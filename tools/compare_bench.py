@@ -0,0 +1,82 @@
+# Compares two microbench results and flags regressions.
+#
+#   build/release/bench/microbench --benchmark_out=base.json
+#   ... change something, rebuild ...
+#   build/release/bench/microbench --benchmark_out=new.json
+#   python3 tools/compare_bench.py base.json new.json [--threshold 5] [--cpu]
+#
+# A benchmark regressed if its time grew by more than --threshold percent
+# (real time by default, CPU time with --cpu). Exits with 1 if any did, so
+# it can be used in scripts. Works with Google Benchmark output too.
+import argparse
+import json
+import sys
+
+def Load(path):
+    with open(path) as f:
+        data=json.load(f)
+    results={}
+    for run in data.get("benchmarks",[]):
+        # Skip aggregates (mean, median, ...) of repeated runs
+        if run.get("run_type","iteration")!="iteration":
+            continue
+        results[run["name"]]=run
+    return results
+
+# Converts a time to nanoseconds so runs with different units compare
+def Nanoseconds(run,key):
+    scale={"ns":1.0,"us":1e3,"ms":1e6,"s":1e9}[run.get("time_unit","ns")]
+    return run[key]*scale
+
+def FormatTime(ns):
+    for unit,scale in (("s",1e9),("ms",1e6),("us",1e3)):
+        if ns>=scale:
+            return "%.3f %s"%(ns/scale,unit)
+    return "%.1f ns"%ns
+
+parser=argparse.ArgumentParser(description="Compare two benchmark runs")
+parser.add_argument("baseline")
+parser.add_argument("contender")
+parser.add_argument("--threshold",type=float,default=5.0,
+                    help="allowed slowdown in percent (default 5)")
+parser.add_argument("--cpu",action="store_true",
+                    help="compare CPU time instead of real time")
+args=parser.parse_args()
+
+key="cpu_time" if args.cpu else "real_time"
+baseline=Load(args.baseline)
+contender=Load(args.contender)
+
+width=max([len(name) for name in contender]+[9])
+print("%-*s %14s %14s %9s"%(width,"Benchmark","Baseline","Contender","Change"))
+print("-"*(width+40))
+regressions=[]
+for name,run in contender.items():
+    base=baseline.get(name)
+    if base is None:
+        print("%-*s %14s %14s %9s"%(width,name,"-",
+              "error" if run.get("error_occurred") else
+              FormatTime(Nanoseconds(run,key)),"new"))
+        continue
+    if run.get("error_occurred") or base.get("error_occurred"):
+        print("%-*s %14s %14s %9s"%(width,name,"","","skipped"))
+        continue
+    old=Nanoseconds(base,key)
+    new=Nanoseconds(run,key)
+    change=(new-old)/old*100.0 if old>0 else 0.0
+    flag=""
+    if change>args.threshold:
+        flag="  REGRESSION"
+        regressions.append(name)
+    print("%-*s %14s %14s %+8.1f%%%s"%(width,name,FormatTime(old),
+          FormatTime(new),change,flag))
+# e.g. the contender was run with --benchmark_filter
+missing=[name for name in baseline if name not in contender]
+if missing:
+    print("(%d benchmark(s) of the baseline were not run)"%len(missing))
+
+if regressions:
+    print("\n%d benchmark(s) slower by more than %.1f%%: %s"%(
+          len(regressions),args.threshold,", ".join(regressions)))
+    sys.exit(1)
+print("\nNo regressions above %.1f%%"%args.threshold)
@@ -0,0 +1,54 @@
+# Profile guided optimization in three steps:
+#   1. build everything instrumented (ENGINE_PGO=GENERATE)
+#   2. run the headless benchmark and the microbenchmarks to record profiles
+#   3. rebuild the same directory using the profiles (ENGINE_PGO=USE)
+#
+# Run with: python3 tools/pgo.py [native] [lto]
+# The optimized programs end up in build/pgo (e.g. build/pgo/part1/project).
+import glob
+import os
+import shutil
+import subprocess
+import sys
+
+ROOT=os.path.abspath(os.path.join(os.path.dirname(__file__),".."))
+BUILD_DIR=os.path.join(ROOT,"build","pgo")
+PROFILE_DIR=os.path.join(BUILD_DIR,"profiles")
+args=sys.argv[1:]
+
+def Run(command):
+    print(" ".join(command))
+    if subprocess.call(command)!=0:
+        print("pgo.py: command failed")
+        sys.exit(1)
+
+def ConfigureAndBuild(mode):
+    Run(["cmake","-S",ROOT,"-B",BUILD_DIR,
+         "-DCMAKE_BUILD_TYPE=Release",
+         "-DENGINE_PGO="+mode,
+         "-DENGINE_PGO_DIR="+PROFILE_DIR,
+         "-DENGINE_NATIVE_ARCH="+("ON" if "native" in args else "OFF"),
+         "-DENGINE_LTO="+("ON" if "lto" in args else "OFF")])
+    Run(["cmake","--build",BUILD_DIR,"-j",str(os.cpu_count() or 1)])
+
+# (1) Instrumented build, starting from empty profiles
+shutil.rmtree(PROFILE_DIR,ignore_errors=True)
+ConfigureAndBuild("GENERATE")
+
+# (2) Training run. Small frames keep it short; the work per vertex and per
+#     draw call is the same as in the real programs.
+headless=os.path.join(BUILD_DIR,"bench","headless_bench")
+if os.path.exists(headless):
+    Run([headless,"--frames","3","--size","64x64"])
+else:
+    print("pgo.py: no headless_bench (EGL missing), training with the microbenchmarks only")
+Run([os.path.join(BUILD_DIR,"bench","microbench"),"--benchmark_min_time=0.05"])
+
+# Clang writes raw profiles that have to be merged first
+raw=glob.glob(os.path.join(PROFILE_DIR,"*.profraw"))
+if raw:
+    Run(["llvm-profdata","merge","-o",os.path.join(PROFILE_DIR,"default.profdata")]+raw)
+
+# (3) Optimized build using the profiles
+ConfigureAndBuild("USE")
+print("Profile guided build is in "+BUILD_DIR)